@@ -0,0 +1,167 @@
+--
+-- Licensed under the Apache License v2.0 with LLVM Exceptions.
+-- See https://llvm.org/LICENSE.txt for license information.
+-- SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+--
+-- Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+--
+-- Official repository: https://github.com/cppalliance/mrdox
+--
+
+-- Renders the pages of the html generator.
+--
+-- The script is run once in each thread, and
+-- defines the functions called by the generator:
+--
+--   page(symbol)   the text of the page of a symbol
+--   header()       the text before a single page
+--   footer()       the text after a single page
+--
+-- Symbols are Dom objects. Arrays are indexed
+-- from zero, and `#` returns their size. The
+-- strings of the javadoc are already HTML.
+--
+-- The globals `multiPage` and `shardDepth` are
+-- set from the configuration before the script
+-- runs.
+
+local concat = table.concat
+
+local entities = {
+    ["&"] = "&amp;", ["<"] = "&lt;", [">"] = "&gt;", ['"'] = "&quot;"
+}
+
+local function escape(s)
+    return (tostring(s):gsub('[&<>"]', entities))
+end
+
+local function items(arr)
+    local i = -1
+    local n = arr and #arr or 0
+    return function()
+        i = i + 1
+        if i < n then
+            return arr[i]
+        end
+    end
+end
+
+local function qualifiedName(symbol)
+    local parts = {}
+    for parent in items(symbol.namespace) do
+        if parent.name and parent.name ~= "" then
+            table.insert(parts, 1, parent.name)
+        end
+    end
+    parts[#parts + 1] = symbol.name or ""
+    return concat(parts, "::")
+end
+
+-- the url of a symbol is the same from every
+-- page, and only the symbols with a page have one
+local function link(symbol)
+    if not symbol.url then
+        return escape(symbol.name or "")
+    end
+    return '<a href="' .. symbol.url .. '">' ..
+        escape(symbol.name or "") .. '</a>'
+end
+
+local suffixes = {
+    ["lvalue-reference"] = "&",
+    ["rvalue-reference"] = "&&",
+    ["pointer"] = "*"
+}
+
+local function typeName(t)
+    if not t then
+        return ""
+    end
+    local s
+    local suffix = suffixes[t.kind]
+    if suffix then
+        s = typeName(t["pointee-type"]) .. suffix
+    elseif t.kind == "array" then
+        s = typeName(t["element-type"]) .. "[" ..
+            (t["bounds-expr"] or "") .. "]"
+    elseif t.kind == "pack" then
+        s = typeName(t["pattern-type"]) .. "..."
+    else
+        s = t.name or t.kind
+        if t["parent-type"] then
+            s = typeName(t["parent-type"]) .. "::" .. s
+        end
+    end
+    local cv = t["cv-qualifiers"]
+    if cv and cv ~= "" then
+        s = s .. " " .. cv
+    end
+    return s
+end
+
+local function signature(symbol)
+    local params = {}
+    for param in items(symbol.params) do
+        local p = typeName(param.type)
+        if param.name then
+            p = p .. " " .. param.name
+        end
+        params[#params + 1] = p
+    end
+    return typeName(symbol["return"]) .. " " ..
+        (symbol.name or "") .. "(" .. concat(params, ", ") .. ")"
+end
+
+function header()
+    return "<!DOCTYPE html>\n<html>\n<head>\n" ..
+        "<meta charset=\"utf-8\">\n" ..
+        "<title>Reference</title>\n</head>\n<body>\n"
+end
+
+function footer()
+    return "</body>\n</html>\n"
+end
+
+function page(symbol)
+    local out = {}
+    local function put(s)
+        out[#out + 1] = s
+    end
+
+    put('<div class="symbol" id="' .. symbol.id .. '">\n')
+    put("<h2>" .. escape(qualifiedName(symbol)) .. "</h2>\n")
+    put('<p class="kind">' .. escape(symbol.kind) .. "</p>\n")
+
+    local doc = symbol.doc
+    if doc and doc.brief then
+        put('<p class="brief">' .. doc.brief .. "</p>\n")
+    end
+
+    if symbol.kind == "function" then
+        put("<pre><code>" .. escape(signature(symbol)) ..
+            "</code></pre>\n")
+    elseif symbol.type then
+        put("<pre><code>" .. escape(typeName(symbol.type)) ..
+            "</code></pre>\n")
+    end
+
+    if doc and doc.description then
+        put(doc.description)
+    end
+
+    if symbol.kind ~= "enum" and symbol.members and #symbol.members > 0 then
+        put("<h3>Members</h3>\n<ul>\n")
+        for member in items(symbol.members) do
+            put("<li>" .. link(member))
+            local brief = member.doc and member.doc.brief
+            if brief then
+                put(" &mdash; " .. brief)
+            end
+            put("</li>\n")
+        end
+        put("</ul>\n")
+    end
+
+    put("</div>\n")
+    return concat(out)
+end
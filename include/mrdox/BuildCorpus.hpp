@@ -0,0 +1,117 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_API_BUILDCORPUS_HPP
+#define MRDOX_API_BUILDCORPUS_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Config.hpp>
+#include <mrdox/Corpus.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A command which compiles one translation unit.
+
+    Relative paths are resolved against the
+    directory of the command, and a relative
+    directory against the working directory
+    of the configuration.
+*/
+struct CompileCommand
+{
+    /** The directory the command runs in.
+    */
+    std::string directory;
+
+    /** The source file of the translation unit.
+    */
+    std::string file;
+
+    /** The command line, starting with the compiler.
+    */
+    std::vector<std::string> arguments;
+};
+
+/** A function which is told of the progress of a build.
+
+    The phase is "parse" while the translation
+    units are parsed, then "reduce" while the
+    symbols are merged. The total is the number
+    of items of work in the phase.
+*/
+using BuildProgress = std::function<void(
+    std::string_view phase,
+    std::size_t done,
+    std::size_t total)>;
+
+/** The options of a build.
+*/
+struct BuildOptions
+{
+    /** A function which is told of the progress, or empty.
+
+        It is called from one thread at a time,
+        a few times a second and when a phase
+        ends, so it may do a little work.
+    */
+    BuildProgress progress;
+
+    /** A token which requests that the build stops.
+
+        Translation units and symbols which were
+        not started when the stop is requested
+        are skipped, and the build returns an
+        error.
+    */
+    std::stop_token stop;
+};
+
+/** Build a corpus from compile commands.
+
+    This runs the same extraction and reduction
+    as the tool, in the calling process, so the
+    corpus can be kept in memory and generated
+    from as often as needed. The corpus refers
+    to the configuration, which it keeps alive.
+
+    @par Thread Safety
+    Builds with distinct configurations may run
+    concurrently.
+
+    @return The corpus, or an error.
+
+    @param config The configuration, from
+    @ref createConfig.
+
+    @param commands The translation units to
+    extract symbols from.
+
+    @param options The options of the build.
+*/
+MRDOX_DECL
+Expected<std::unique_ptr<Corpus>>
+buildCorpus(
+    std::shared_ptr<Config const> config,
+    std::vector<CompileCommand> commands,
+    BuildOptions const& options = {});
+
+} // mrdox
+} // clang
+
+#endif
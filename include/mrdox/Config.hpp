@@ -81,6 +81,18 @@ public:
     */
     bool verboseOutput = false;
 
+    /** `true` if a progress line is shown for each phase.
+
+        The line shows the rate of work and the
+        time remaining. This is always `true` when
+        output is verbose.
+
+        @code
+        progress: true
+        @endcode
+    */
+    bool progress = false;
+
     /** `true` if private members should be extracted and displayed.
 
         In some cases private members will be listed
@@ -105,6 +117,97 @@ public:
     */
     unsigned int concurrency = 0;
 
+    /** The number of symbol objects kept alive for reuse.
+
+        Dom objects for symbols are cached while they
+        are referenced. When this is not zero, up to
+        this many of the most recently used objects
+        are also kept after their last reference is
+        dropped, instead of being built again.
+
+        @code
+        dom-cache-size: 4096
+        @endcode
+    */
+    std::size_t domCacheSize = 0;
+
+    /** `true` if the symbol objects are built before generation.
+
+        Every symbol object is built once, in
+        parallel, and then read by all threads
+        without locking. This suits output which
+        renders every symbol anyway.
+
+        @code
+        dom-prebuild: true
+        @endcode
+    */
+    bool domPrebuild = false;
+
+    /** `true` if unchanged output files are not written again.
+
+        A manifest of the hash of each file is
+        kept in the output directory. Pages whose
+        hash is the same as in the last run are
+        skipped, and the files of symbols which
+        no longer exist are removed, so tools
+        which watch the output only see the
+        pages which changed. The multi-page
+        Asciidoc generator also keeps the symbols
+        each page showed, and only renders again
+        the pages whose symbols changed.
+
+        @code
+        incremental-output: true
+        @endcode
+    */
+    bool incrementalOutput = false;
+
+    /** The levels of subdirectories of multi-page output.
+
+        When this is not zero, each page is put in
+        nested subdirectories named by the leading
+        pairs of digits of its symbol id, so that no
+        directory holds more than 256 of them. With
+        500,000 pages, one level leaves about 2,000
+        files in each directory.
+
+        @code
+        shard-depth: 1
+        @endcode
+    */
+    unsigned shardDepth = 0;
+
+    /** The compression of the output files.
+
+        This is "none", "gzip" or "zstd". Each
+        file is compressed as it is written, and
+        its name is given the extension of the
+        compression. Single-page output is
+        compressed in blocks, so it is never
+        held in memory as a whole.
+
+        @code
+        output-compression: zstd
+        @endcode
+    */
+    std::string outputCompression;
+
+    /** The archive holding the files of multi-page output.
+
+        When this is "tar", every page is streamed
+        into one file, `reference.tar` in the output
+        directory, instead of a file for each page.
+        With a compression, the archive is
+        compressed as a whole. This cannot be used
+        with incremental output.
+
+        @code
+        output-archive: tar
+        @endcode
+    */
+    std::string outputArchive;
+
     //--------------------------------------------
 
     /** Full path to the working directory
@@ -142,6 +245,32 @@ public:
     std::string extraYaml;
 };
 
+/** Return a configuration from YAML strings.
+
+    The settings of the extra YAML replace
+    those of the configuration YAML with the
+    same keys.
+
+    @return The configuration, or an error.
+
+    @param workingDir The absolute path from
+    which relative paths are resolved.
+
+    @param addonsDir The absolute path to the
+    addons directory.
+
+    @param configYaml The configuration.
+
+    @param extraYaml More settings, or empty.
+*/
+MRDOX_DECL
+Expected<std::shared_ptr<Config const>>
+createConfig(
+    std::string_view workingDir,
+    std::string_view addonsDir,
+    std::string_view configYaml,
+    std::string_view extraYaml = "");
+
 } // mrdox
 } // clang
 
@@ -15,8 +15,14 @@
 #include <mrdox/Platform.hpp>
 #include <mrdox/Config.hpp>
 #include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -24,6 +30,122 @@
 namespace clang {
 namespace mrdox {
 
+/** The symbols which refer to a symbol.
+
+    These are the reverse edges of the metadata,
+    computed once when the corpus is built. Each
+    list is sorted by symbol ID.
+*/
+struct References
+{
+    /** Records which have the symbol as a direct base.
+    */
+    std::vector<SymbolID> Derived;
+
+    /** Functions which name the symbol in their signature.
+    */
+    std::vector<SymbolID> Functions;
+
+    /** Specializations whose primary template is the symbol.
+    */
+    std::vector<SymbolID> Specializations;
+};
+
+/** An estimate of the memory held by a corpus.
+
+    The sizes include the heap storage of strings
+    and vectors, but not the overhead of the
+    allocator. Shared nodes are counted once.
+*/
+struct MemoryStats
+{
+    struct Usage
+    {
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+    };
+
+    /** The symbols of each kind.
+    */
+    std::vector<std::pair<InfoKind, Usage>> kinds;
+
+    /** The nodes of every type.
+    */
+    Usage types;
+
+    /** The nodes of every javadoc, and their pools.
+    */
+    Usage javadoc;
+
+    /** The locations of every symbol.
+    */
+    Usage locations;
+
+    /** The names and qualified names of every symbol.
+    */
+    Usage strings;
+};
+
+/** The fields of every symbol which whole-corpus passes read.
+
+    Each field is stored in its own array, in
+    index order, apart from the rest of the Info,
+    so that a pass over one field of every symbol
+    reads contiguous memory. The position of a
+    symbol in these arrays is its position in
+    the index.
+*/
+struct SymbolHeaders
+{
+    /** The parent of a symbol which has none.
+    */
+    static constexpr std::uint32_t npos = std::uint32_t(-1);
+
+    std::vector<SymbolID> id;
+    std::vector<InfoKind> kind;
+    std::vector<AccessKind> access;
+
+    /** The position of the innermost enclosing scope.
+
+        Scopes which are not in the corpus are
+        skipped. This is `npos` for the global
+        namespace.
+    */
+    std::vector<std::uint32_t> parent;
+
+    /** The unqualified name, which refers to the Info.
+    */
+    std::vector<std::string_view> name;
+
+    /** The positions of the children of every symbol.
+
+        The children of the symbol at position `i`
+        are `children[childOffsets[i]]` up to
+        `children[childOffsets[i + 1]]`, in the
+        order in which @ref Corpus::traverse visits
+        them. Members which are not in the corpus
+        are left out.
+    */
+    std::vector<std::uint32_t> childOffsets;
+    std::vector<std::uint32_t> children;
+
+    std::size_t
+    size() const noexcept
+    {
+        return id.size();
+    }
+
+    /** Return the positions of the children of a symbol.
+    */
+    std::span<std::uint32_t const>
+    childrenOf(
+        std::uint32_t i) const noexcept
+    {
+        return { children.data() + childOffsets[i],
+            children.data() + childOffsets[i + 1] };
+    }
+};
+
 /** The collection of declarations in extracted form.
 */
 class MRDOX_VISIBLE
@@ -57,6 +179,26 @@ public:
     std::vector<Info const*> const&
     index() const noexcept = 0;
 
+    /** Return the hot fields of every symbol, in index order.
+    */
+    MRDOX_DECL
+    virtual
+    SymbolHeaders const&
+    headers() const noexcept = 0;
+
+    /** Return the position of a symbol in the index, or `SymbolHeaders::npos`.
+
+        The position is a dense index which is
+        assigned when the corpus is built. It is
+        only meaningful for this corpus, while the
+        symbol ID is the stable identity.
+    */
+    MRDOX_DECL
+    virtual
+    std::uint32_t
+    indexOf(
+        SymbolID const& id) const noexcept = 0;
+
     /** Return the metadata for the global namespace.
     */
     MRDOX_DECL
@@ -70,6 +212,103 @@ public:
     Info const*
     find(SymbolID const& id) const noexcept = 0;
 
+    /** Return the symbols with a fully qualified name.
+
+        More than one symbol can have the same
+        name, for example overloaded functions.
+        The symbols are in index order.
+    */
+    MRDOX_DECL
+    virtual
+    std::span<Info const* const>
+    findByName(
+        std::string_view name) const noexcept = 0;
+
+    /** Return the symbols whose fully qualified name starts with a prefix.
+
+        The symbols are in index order, which is
+        sorted by name.
+    */
+    MRDOX_DECL
+    virtual
+    std::span<Info const* const>
+    findByPrefix(
+        std::string_view prefix) const noexcept = 0;
+
+    /** Return the interface of a record.
+
+        The interface is built the first time it
+        is requested, and the same object is then
+        returned to every caller.
+
+        @par Thread Safety
+        May be called concurrently.
+    */
+    MRDOX_DECL
+    virtual
+    std::shared_ptr<Interface const>
+    getInterface(
+        RecordInfo const& I) const = 0;
+
+    /** Return the overload sets of a namespace or record.
+
+        The sets are computed once when the corpus
+        is built, and are sorted by name. For any
+        other kind of symbol the list is empty.
+    */
+    MRDOX_DECL
+    virtual
+    std::span<OverloadInfo const>
+    overloads(
+        Info const& scope) const noexcept = 0;
+
+    /** Return an estimate of the memory held by the corpus.
+
+        This walks every symbol, so it should
+        not be called on a hot path.
+    */
+    MRDOX_DECL
+    virtual
+    MemoryStats
+    memoryStats() const = 0;
+
+    /** Return the symbols which refer to a symbol.
+
+        If nothing refers to the symbol, the
+        returned lists are empty.
+    */
+    MRDOX_DECL
+    virtual
+    References const&
+    references(
+        SymbolID const& id) const noexcept = 0;
+
+    /** Return true if a symbol is rendered.
+
+        When the configuration selects a subset
+        of the symbols, only those in the subset
+        are rendered. Otherwise every symbol is.
+        The names and the references of the
+        corpus are always those of every symbol.
+    */
+    MRDOX_DECL
+    virtual
+    bool
+    isSelected(
+        Info const& I) const noexcept = 0;
+
+    /** Return true if a symbol or one of its members is rendered.
+
+        A traversal which only renders the
+        selected symbols can skip the members
+        of the scopes for which this is false.
+    */
+    MRDOX_DECL
+    virtual
+    bool
+    hasSelected(
+        Info const& I) const noexcept = 0;
+
     /** Return true if an Info with the specified symbol ID exists.
     */
     bool
@@ -105,14 +344,93 @@ public:
         SpecializationInfo const& I,
         F&& f, Args&&... args) const;
 
+    /** Visit every symbol below a symbol concurrently.
+
+        The function is invoked with each member and
+        specialization reachable from `I`, but not
+        with `I` itself. A symbol with at least
+        `grain` children has its subtree visited by
+        a separate task on the thread pool of the
+        configuration. The order of the calls is
+        unspecified, and the function must be safe
+        to call concurrently.
+
+        @return Zero or more errors which were
+        thrown from the function.
+    */
+    template<class F>
+    [[nodiscard]]
+    std::vector<Error>
+    traverseParallel(
+        Info const& I,
+        F const& f,
+        std::size_t grain = 32) const;
+
+    /** Compute a value for every symbol below a symbol concurrently.
+
+        The values are returned in the order in
+        which @ref traverse would visit the symbols,
+        depth first, so that output built from them
+        is deterministic.
+
+        @return The values, or the errors which
+        were thrown from the function.
+    */
+    template<class F>
+    [[nodiscard]]
+    auto
+    mapOrdered(
+        Info const& I,
+        F const& f,
+        std::size_t grain = 256) const ->
+            Expected<std::vector<
+                std::invoke_result_t<F const&, Info const&>>>;
+
     //--------------------------------------------
 
+    /** Return the fully qualified name of a symbol.
+
+        The names are computed once, when the
+        corpus is built, so this does not allocate.
+    */
+    MRDOX_DECL
+    virtual
+    std::string_view
+    qualifiedName(
+        Info const& I) const noexcept = 0;
+
     // KRYSTIAN NOTE: temporary
     MRDOX_DECL
     std::string&
     getFullyQualifiedName(
         const Info& I,
         std::string& temp) const;
+
+private:
+    template<class F, class... Args>
+    bool
+    traverseIndexed(
+        Info const& I,
+        F&& f, Args&&... args) const;
+
+    static
+    std::size_t
+    countChildren(
+        Info const& I) noexcept;
+
+    template<class F>
+    void
+    traverseParallelImpl(
+        TaskGroup& taskGroup,
+        Info const& I,
+        F const& f,
+        std::size_t grain) const;
+
+    template<class F>
+    void
+    traverseAll(
+        Info const& I,
+        F const& f) const;
 };
 
 //------------------------------------------------
@@ -137,6 +455,28 @@ get(
     }
 }
 
+/** Visit the children of a symbol through the dense indexes.
+
+    @return false if the symbol has no
+    position, as before the corpus is built.
+*/
+template<class F, class... Args>
+bool
+Corpus::
+traverseIndexed(
+    Info const& I,
+    F&& f, Args&&... args) const
+{
+    std::uint32_t const i = indexOf(I.id);
+    if(i == SymbolHeaders::npos)
+        return false;
+    auto const& infos = index();
+    for(std::uint32_t j : headers().childrenOf(i))
+        visit(*infos[j], std::forward<F>(f),
+            std::forward<Args>(args)...);
+    return true;
+}
+
 template<class F, class... Args>
 void
 Corpus::
@@ -144,6 +484,9 @@ traverse(
     NamespaceInfo const& I,
     F&& f, Args&&... args) const
 {
+    if(traverseIndexed(I, std::forward<F>(f),
+            std::forward<Args>(args)...))
+        return;
     for(auto const& id : I.Members)
         visit(get(id), std::forward<F>(f),
             std::forward<Args>(args)...);
@@ -159,6 +502,9 @@ traverse(
     RecordInfo const& I,
     F&& f, Args&&... args) const
 {
+    if(traverseIndexed(I, std::forward<F>(f),
+            std::forward<Args>(args)...))
+        return;
     for(auto const& id : I.Members)
         visit(get(id), std::forward<F>(f),
             std::forward<Args>(args)...);
@@ -174,12 +520,142 @@ traverse(
     SpecializationInfo const& I,
     F&& f, Args&&... args) const
 {
+    if(traverseIndexed(I, std::forward<F>(f),
+            std::forward<Args>(args)...))
+        return;
     for(auto const& J : I.Members)
         visit(get(J.Specialized),
             std::forward<F>(f),
                 std::forward<Args>(args)...);
 }
 
+inline
+std::size_t
+Corpus::
+countChildren(
+    Info const& I) noexcept
+{
+    return visit(I,
+        []<class T>(T const& J) -> std::size_t
+        {
+            if constexpr(
+                T::isNamespace() ||
+                T::isRecord())
+                return J.Members.size() + J.Specializations.size();
+            else if constexpr(T::isSpecialization())
+                return J.Members.size();
+            else
+                return 0;
+        });
+}
+
+template<class F>
+void
+Corpus::
+traverseAll(
+    Info const& I,
+    F const& f) const
+{
+    visit(I,
+        [&]<class T>(T const& J)
+        {
+            if constexpr(
+                T::isNamespace() ||
+                T::isRecord() ||
+                T::isSpecialization())
+                traverse(J, f);
+        });
+}
+
+template<class F>
+void
+Corpus::
+traverseParallelImpl(
+    TaskGroup& taskGroup,
+    Info const& I,
+    F const& f,
+    std::size_t grain) const
+{
+    traverseAll(I,
+        [&](Info const& J)
+        {
+            f(J);
+            std::size_t const n = countChildren(J);
+            if(n == 0)
+                return;
+            if(n < grain)
+            {
+                traverseParallelImpl(taskGroup, J, f, grain);
+                return;
+            }
+            taskGroup.async(
+                [this, &taskGroup, &J, &f, grain]
+                {
+                    traverseParallelImpl(taskGroup, J, f, grain);
+                });
+        });
+}
+
+template<class F>
+std::vector<Error>
+Corpus::
+traverseParallel(
+    Info const& I,
+    F const& f,
+    std::size_t grain) const
+{
+    TaskGroup taskGroup(config.threadPool());
+    traverseParallelImpl(taskGroup, I, f, grain);
+    return taskGroup.wait();
+}
+
+template<class F>
+auto
+Corpus::
+mapOrdered(
+    Info const& I,
+    F const& f,
+    std::size_t grain) const ->
+        Expected<std::vector<
+            std::invoke_result_t<F const&, Info const&>>>
+{
+    using R = std::invoke_result_t<F const&, Info const&>;
+
+    // Listing the symbols is cheap compared to
+    // the work, so it is done on this thread.
+    std::vector<Info const*> infos;
+    auto const list = [&](auto const& self, Info const& J) -> void
+    {
+        traverseAll(J,
+            [&](Info const& K)
+            {
+                infos.push_back(&K);
+                self(self, K);
+            });
+    };
+    list(list, I);
+
+    std::vector<R> results(infos.size());
+    if(grain == 0)
+        grain = 1;
+    TaskGroup taskGroup(config.threadPool());
+    for(std::size_t i = 0; i < infos.size(); i += grain)
+    {
+        taskGroup.async(
+            [&, i]
+            {
+                std::size_t const end =
+                    std::min(i + grain, infos.size());
+                for(std::size_t j = i; j < end; ++j)
+                    results[j] = f(*infos[j]);
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Error(errors);
+    return results;
+}
+
 } // mrdox
 } // clang
 
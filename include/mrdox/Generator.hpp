@@ -23,9 +23,32 @@
 #include <string>
 #include <string_view>
 
+namespace llvm {
+class raw_ostream;
+} // llvm
+
 namespace clang {
 namespace mrdox {
 
+/** The parts of the metadata which a generator reads.
+
+    Extraction skips the parts which are not read.
+*/
+struct MetadataFacets
+{
+    /** Parsed documentation comments.
+    */
+    bool javadoc = true;
+
+    /** The arguments of template specializations.
+    */
+    bool templateArgs = true;
+
+    /** The source text of default arguments and initializers.
+    */
+    bool sourceText = true;
+};
+
 /** Base class for documentation generators.
 */
 class MRDOX_VISIBLE
@@ -72,6 +95,17 @@ public:
     std::string_view
     fileExtension() const noexcept = 0;
 
+    /** Return the parts of the metadata which the generator reads.
+
+        The default reads every part. A generator
+        which reads less can be run on a corpus
+        which is extracted faster.
+    */
+    MRDOX_DECL
+    virtual
+    MetadataFacets
+    facets() const noexcept;
+
     /** Build reference documentation for the corpus.
 
         This function invokes the generator to emit
@@ -122,6 +156,29 @@ public:
         std::ostream& os,
         Corpus const& corpus) const = 0;
 
+    /** Build reference documentation for the corpus.
+
+        This is the same as the overload which
+        takes a `std::ostream`, which the default
+        implementation calls. Generators which
+        write to an `llvm::raw_ostream` override
+        this, so that files are written to a
+        large buffer without going through
+        iostreams.
+
+        @return The error, if any occurred.
+
+        @param os The stream to write to.
+
+        @param corpus The metadata to emit.
+    */
+    MRDOX_DECL
+    virtual
+    Error
+    buildOne(
+        llvm::raw_ostream& os,
+        Corpus const& corpus) const;
+
     /** Build the reference as a single page to a file.
 
         @par Thread Safety
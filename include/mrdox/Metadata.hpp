@@ -29,6 +29,7 @@
 #include <mrdox/Metadata/Record.hpp>
 #include <mrdox/Metadata/Specialization.hpp>
 #include <mrdox/Metadata/Source.hpp>
+#include <mrdox/Metadata/SourceText.hpp>
 #include <mrdox/Metadata/Symbols.hpp>
 #include <mrdox/Metadata/Template.hpp>
 #include <mrdox/Metadata/Type.hpp>
@@ -16,11 +16,63 @@
 #include <mrdox/Support/Dom.hpp>
 #include <mrdox/Metadata.hpp>
 #include <type_traits>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
 
+/** The symbols looked up by a thread.
+
+    While a recorder exists, the symbols which
+    the thread that made it looks up through a
+    @ref DomCorpus are added to it, including
+    those whose objects are part of a value
+    which was built earlier. Recorders nest,
+    and an inner one adds its symbols to the
+    outer one when it is destroyed.
+*/
+class MRDOX_DECL
+    SymbolRecorder
+{
+    SymbolRecorder* outer_;
+    std::vector<SymbolID> ids_;
+
+public:
+    SymbolRecorder() noexcept;
+    ~SymbolRecorder();
+
+    SymbolRecorder(SymbolRecorder const&) = delete;
+    SymbolRecorder& operator=(SymbolRecorder const&) = delete;
+
+    /** Return true if the thread has a recorder.
+    */
+    static
+    bool
+    active() noexcept;
+
+    /** Add symbols to the recorder of the thread, if any.
+    */
+    static
+    void
+    add(std::span<SymbolID const> ids);
+
+    static
+    void
+    add(SymbolID const& id)
+    {
+        add(std::span<SymbolID const>(&id, 1));
+    }
+
+    /** Return the symbols recorded so far, sorted and without repeats.
+    */
+    std::vector<SymbolID> const&
+    ids();
+};
+
 /** Front-end factory for producing Dom nodes.
 
     A @ref Generator subclasses this object and
@@ -72,6 +124,60 @@ public:
     dom::Object
     get(Info const& I) const;
 
+    /** Build the objects for every symbol ahead of time.
+
+        The objects are built in parallel on the
+        thread pool of the configuration. After this
+        returns, looking up a symbol only reads the
+        prebuilt table, without taking a lock.
+
+        This must be called once, after the most
+        derived object is constructed, and before
+        any symbol is looked up.
+    */
+    Error
+    prebuild() const;
+
+    /** Assign its page to each symbol which has one.
+
+        A table holding the file and the link of
+        the page of each symbol is built once. The
+        link is the same from every page, and it
+        is the "url" property of the objects of
+        the symbols. A symbol without a page has
+        no link.
+
+        This must be called before any symbol
+        is looked up.
+
+        @param pages The symbols which have a page.
+
+        @param extension The extension of the files
+        of the pages, without the period. When this
+        is empty the output is a single page, and
+        the links are anchors in it.
+    */
+    void
+    assignPages(
+        std::span<Info const* const> pages,
+        std::string_view extension);
+
+    /** Return the file of the page of a symbol.
+
+        The file is relative to the output
+        directory. An empty string is returned
+        when the symbol has no page.
+    */
+    std::string_view
+    getPageFile(
+        SymbolID const& id) const noexcept;
+
+    /** Return the link to the page of a symbol, or null.
+    */
+    dom::Value
+    getPageLink(
+        SymbolID const& id) const;
+
     /** Return a Dom object representing the given symbol.
 
         When `id` is zero, this function returns null.
@@ -85,6 +191,19 @@ public:
     getOptional(
         SymbolID const& id) const;
 
+    /** Return a hash of the values of the object of a symbol.
+
+        Every value is built. The objects of the
+        other symbols in them contribute only their
+        ids, so the hash changes when the symbol or
+        what is derived from it changes, such as its
+        links, references and overloads. Zero is
+        returned when the symbol does not exist.
+    */
+    std::uint64_t
+    hash(
+        SymbolID const& id) const;
+
     /** Return a Dom value representing the Javadoc.
 
         The default implementation returns null. A
@@ -61,7 +61,7 @@ struct EnumInfo
     // Set to nonempty to the type when this is an explicitly typed enum. For
     //   enum Foo : short { ... };
     // this will be "short".
-    std::unique_ptr<TypeInfo> UnderlyingType;
+    std::shared_ptr<TypeInfo> UnderlyingType;
 
     // Enumeration members.
     std::vector<EnumValueInfo> Members;
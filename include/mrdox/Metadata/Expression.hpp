@@ -12,6 +12,7 @@
 #define MRDOX_API_METADATA_EXPRESSION_HPP
 
 #include <mrdox/Platform.hpp>
+#include <mrdox/Metadata/SourceText.hpp>
 #include <concepts>
 #include <optional>
 #include <string>
@@ -23,7 +24,7 @@ namespace mrdox {
 struct ExprInfo
 {
     /** The expression, as written */
-    std::string Written;
+    SourceText Written;
 };
 
 /** Represents an expression with a (possibly known) value */
@@ -44,7 +44,7 @@ struct FieldInfo
     , SourceInfo
 {
     /** Type of the field */
-    std::unique_ptr<TypeInfo> Type;
+    std::shared_ptr<TypeInfo> Type;
 
     /** The default member initializer, if any.
     */
@@ -17,6 +17,7 @@
 #include <mrdox/ADT/BitField.hpp>
 #include <mrdox/Metadata/Field.hpp>
 #include <mrdox/Metadata/Source.hpp>
+#include <mrdox/Metadata/SourceText.hpp>
 #include <mrdox/Metadata/Symbols.hpp>
 #include <mrdox/Metadata/Template.hpp>
 #include <mrdox/Support/Dom.hpp>
@@ -107,7 +108,7 @@ union FnFlags1
 struct Param
 {
     /** The type of this parameter */
-    std::unique_ptr<TypeInfo> Type;
+    std::shared_ptr<TypeInfo> Type;
 
     /** The parameter name.
 
@@ -116,14 +117,14 @@ struct Param
     std::string Name;
 
     /** The default argument for this parameter, if any */
-    std::string Default;
+    SourceText Default;
 
     Param() = default;
 
     Param(
-        std::unique_ptr<TypeInfo>&& type,
+        std::shared_ptr<TypeInfo>&& type,
         std::string&& name,
-        std::string&& def_arg)
+        SourceText&& def_arg)
         : Type(std::move(type))
         , Name(std::move(name))
         , Default(std::move(def_arg))
@@ -139,7 +140,7 @@ struct FunctionInfo
 {
     friend class ASTVisitor;
 
-    std::unique_ptr<TypeInfo> ReturnType; // Info about the return type of this function.
+    std::shared_ptr<TypeInfo> ReturnType; // Info about the return type of this function.
     std::vector<Param> Params; // List of parameters.
 
     // When present, this function is a template or specialization.
@@ -16,8 +16,11 @@
 #include <mrdox/Platform.hpp>
 #include <mrdox/Support/Dom.hpp>
 #include <mrdox/Support/Error.hpp>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -589,6 +592,179 @@ struct Overview
 
 MRDOX_DECL dom::String toString(Style style) noexcept;
 
+/** A compact, read-only copy of a list of blocks.
+
+    The nodes are stored in one array, where the
+    children of each node occupy a contiguous range
+    of indexes, and every distinct string is stored
+    once in a shared text buffer. Walking the pool
+    touches a few contiguous allocations instead of
+    one allocation per node.
+*/
+class MRDOX_DECL
+    NodePool
+{
+public:
+    /** A range of the text buffer.
+    */
+    struct Str
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+    };
+
+    /** A node in the pool.
+    */
+    struct Node
+    {
+        Kind kind = Kind::text;
+
+        /** The Style, Admonish, or ParamDirection.
+        */
+        std::uint8_t flag = 0;
+
+        /** The index and number of the children.
+        */
+        std::uint32_t first = 0;
+        std::uint32_t count = 0;
+
+        /** The text of a Text or Heading.
+        */
+        Str string;
+
+        /** The href of a Link, or the name of a Param or TParam.
+        */
+        Str extra;
+    };
+
+    /** The blocks of a pool, collated by kind.
+
+        @see Javadoc::makeOverview, overview
+    */
+    struct Overview
+    {
+        Node const* brief = nullptr;
+        std::vector<Node const*> blocks;
+        Node const* returns = nullptr;
+        std::vector<Node const*> params;
+        std::vector<Node const*> tparams;
+    };
+
+    NodePool() noexcept = default;
+
+    /** Constructor.
+    */
+    explicit
+    NodePool(
+        List<Block> const& blocks);
+
+    // the overview points into the nodes
+    NodePool(NodePool&&) noexcept = default;
+    NodePool& operator=(NodePool&&) noexcept = default;
+    NodePool(NodePool const&) = delete;
+    NodePool& operator=(NodePool const&) = delete;
+
+    /** Return true if the pool has no blocks.
+    */
+    bool
+    empty() const noexcept
+    {
+        return numBlocks_ == 0;
+    }
+
+    /** Return the top level blocks.
+    */
+    std::span<Node const>
+    blocks() const noexcept
+    {
+        return { nodes_.data(), numBlocks_ };
+    }
+
+    /** Return the children of a node.
+    */
+    std::span<Node const>
+    children(Node const& node) const noexcept
+    {
+        return { nodes_.data() + node.first, node.count };
+    }
+
+    std::string_view
+    string(Node const& node) const noexcept
+    {
+        return get(node.string);
+    }
+
+    /** Return the href of a Link.
+    */
+    std::string_view
+    href(Node const& node) const noexcept
+    {
+        return get(node.extra);
+    }
+
+    /** Return the name of a Param or TParam.
+    */
+    std::string_view
+    name(Node const& node) const noexcept
+    {
+        return get(node.extra);
+    }
+
+    Style
+    style(Node const& node) const noexcept
+    {
+        return static_cast<Style>(node.flag);
+    }
+
+    Admonish
+    admonish(Node const& node) const noexcept
+    {
+        return static_cast<Admonish>(node.flag);
+    }
+
+    ParamDirection
+    direction(Node const& node) const noexcept
+    {
+        return static_cast<ParamDirection>(node.flag);
+    }
+
+    /** Return the overview of the blocks.
+
+        The blocks are collated once, when the
+        pool is built, which is as the corpus is
+        finalized.
+    */
+    Overview const&
+    overview() const noexcept
+    {
+        return overview_;
+    }
+
+    /** Return the number of bytes held by the pool.
+    */
+    std::size_t
+    bytes() const noexcept
+    {
+        return nodes_.capacity() * sizeof(Node) + text_.capacity() +
+            (overview_.blocks.capacity() + overview_.params.capacity() +
+                overview_.tparams.capacity()) * sizeof(Node const*);
+    }
+
+private:
+    std::string_view
+    get(Str s) const noexcept
+    {
+        return { text_.data() + s.offset, s.size };
+    }
+
+    Overview makeOverview() const;
+
+    std::vector<Node> nodes_;
+    std::size_t numBlocks_ = 0;
+    std::string text_;
+    Overview overview_;
+};
+
 } // doc
 
 //------------------------------------------------
@@ -664,6 +840,49 @@ public:
     */
     doc::Overview makeOverview() const;
 
+    /** Return the hashes of the comments in this javadoc.
+
+        A parsed comment has the structural hash
+        of its blocks. When javadocs are merged,
+        the hashes of the distinct comments are
+        kept, so a comment that was already merged
+        can be recognized without comparing nodes.
+        The list is empty when this is not known.
+    */
+    std::vector<std::uint64_t> const&
+    hashes() const noexcept
+    {
+        return hashes_;
+    }
+
+    /** Set the hash to the structural hash of the blocks.
+    */
+    void computeHash();
+
+    /** Add a hash, as read from bitcode.
+    */
+    void
+    addHash(std::uint64_t hash)
+    {
+        hashes_.push_back(hash);
+    }
+
+    /** Return the compact copy of the blocks.
+
+        The pool is empty until @ref buildPool is
+        called, and is discarded when blocks are
+        appended.
+    */
+    doc::NodePool const&
+    pool() const noexcept
+    {
+        return pool_;
+    }
+
+    /** Build the compact copy of the blocks.
+    */
+    void buildPool();
+
     //--------------------------------------------
 
     /** Attempt to append a block.
@@ -691,6 +910,8 @@ private:
 
     doc::Paragraph const* brief_ = nullptr;
     doc::List<doc::Block> blocks_;
+    std::vector<std::uint64_t> hashes_;
+    doc::NodePool pool_;
 };
 
 } // mrdox
@@ -38,6 +38,8 @@ struct OverloadInfo
     std::span<FunctionInfo const*> Functions;
 };
 
+/** The overload sets of a namespace or record.
+*/
 class MRDOX_VISIBLE
     NamespaceOverloads
 {
@@ -48,10 +50,12 @@ public:
 
         @par Complexity
         `O(N * log(N))` in `data.size()`.
+
+        @param I The parent namespace or record.
     */
     MRDOX_DECL
     NamespaceOverloads(
-        NamespaceInfo const& I,
+        Info const& I,
         std::vector<FunctionInfo const*> data);
 
 private:
@@ -75,6 +79,19 @@ makeNamespaceOverloads(
     NamespaceInfo const& I,
     Corpus const& corpus);
 
+/** Create an overload set for all member functions of a record.
+
+    The sets are sorted the same way as
+    for a namespace.
+
+    @return The overload set.
+*/
+MRDOX_DECL
+NamespaceOverloads
+makeRecordOverloads(
+    RecordInfo const& I,
+    Corpus const& corpus);
+
 } // mrdox
 } // clang
 
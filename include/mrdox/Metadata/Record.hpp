@@ -45,14 +45,14 @@ union RecFlags0
 */
 struct BaseInfo
 {
-    std::unique_ptr<TypeInfo> Type;
+    std::shared_ptr<TypeInfo> Type;
     AccessKind Access = AccessKind::Public;
     bool IsVirtual = false;
 
     BaseInfo() = default;
 
     BaseInfo(
-        std::unique_ptr<TypeInfo>&& type,
+        std::shared_ptr<TypeInfo>&& type,
         AccessKind access,
         bool is_virtual)
         : Type(std::move(type))
@@ -16,38 +16,81 @@
 #include <mrdox/Platform.hpp>
 #include <mrdox/ADT/Optional.hpp>
 #include <mrdox/Metadata/Info.hpp>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
 namespace clang {
 namespace mrdox {
 
+/** Return the index of a file in the file table.
+
+    Every distinct file name is given an index
+    the first time it is seen, which remains
+    valid until the program exits. The empty
+    name has the index zero.
+
+    @par Thread Safety
+    May be called concurrently.
+
+    @param filename The name of the file.
+
+    @param in_root_dir Whether the file is inside
+    the source root directory. This is recorded
+    when the file is first seen.
+*/
+MRDOX_DECL
+std::uint32_t
+getFileIndex(
+    std::string_view filename,
+    bool in_root_dir = false);
+
+/** Return the name of a file in the file table.
+
+    @see getFileIndex
+*/
+MRDOX_DECL
+std::string_view
+getFileName(
+    std::uint32_t index) noexcept;
+
 struct MRDOX_DECL
     Location
 {
-    /** Name of the file
+    /** Index of the file in the file table
+
+        @see getFileIndex
     */
-    std::string Filename;
+    std::uint32_t FileIndex;
 
     /** Line number within the file
     */
     int LineNumber;
 
-    /** Whether the file is inside the source root directory
-    */
-    bool IsFileInRootDir;
-
     //--------------------------------------------
 
     Location(
         int line = 0,
         std::string_view filename = "",
-        bool in_root_dir = false)
-        : Filename(filename)
+        bool in_root_dir = false);
+
+    Location(
+        int line,
+        std::uint32_t file_index) noexcept
+        : FileIndex(file_index)
         , LineNumber(line)
-        , IsFileInRootDir(in_root_dir)
     {
     }
+
+    /** Return the name of the file
+    */
+    std::string_view
+    filename() const noexcept;
+
+    /** Return whether the file is inside the source root directory
+    */
+    bool
+    isFileInRootDir() const noexcept;
 };
 
 struct LocationEmptyPredicate
@@ -55,7 +98,7 @@ struct LocationEmptyPredicate
     constexpr bool operator()(
         Location const& loc) const noexcept
     {
-        return loc.Filename.empty();
+        return loc.FileIndex == 0;
     }
 };
 
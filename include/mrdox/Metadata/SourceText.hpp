@@ -0,0 +1,108 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_API_METADATA_SOURCETEXT_HPP
+#define MRDOX_API_METADATA_SOURCETEXT_HPP
+
+#include <mrdox/Platform.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** Text as written in a source file.
+
+    Short text is stored inline. Longer text is
+    stored as a range of characters in a file,
+    and read only when it is requested, from a
+    memory-mapped copy of the file which is
+    shared by every range in it. The file must
+    not change while the text is in use.
+*/
+class MRDOX_DECL
+    SourceText
+{
+    std::string text_;
+    std::uint32_t file_ = 0;
+    std::uint32_t offset_ = 0;
+    std::uint32_t size_ = 0;
+
+public:
+    /** The longest text which is stored inline.
+    */
+    static constexpr std::size_t InlineSize = 15;
+
+    SourceText() = default;
+
+    /** Constructor.
+
+        The text is stored inline.
+    */
+    explicit
+    SourceText(
+        std::string text) noexcept
+        : text_(std::move(text))
+    {
+    }
+
+    /** Constructor.
+
+        @param file_index The index of the full
+        path of the file in the file table.
+
+        @see getFileIndex
+    */
+    SourceText(
+        std::uint32_t file_index,
+        std::uint32_t offset,
+        std::uint32_t size) noexcept
+        : file_(file_index)
+        , offset_(offset)
+        , size_(size)
+    {
+    }
+
+    /** Return true if there is no text.
+    */
+    bool
+    empty() const noexcept
+    {
+        return file_ == 0 && text_.empty();
+    }
+
+    /** Return true if the text is a range of a file.
+    */
+    bool
+    isReference() const noexcept
+    {
+        return file_ != 0;
+    }
+
+    std::uint32_t fileIndex() const noexcept { return file_; }
+    std::uint32_t offset() const noexcept { return offset_; }
+    std::uint32_t size() const noexcept { return size_; }
+
+    /** Return the text.
+
+        The view remains valid until the program
+        exits, or for as long as this object when
+        the text is inline. An empty string is
+        returned when the file cannot be read.
+    */
+    std::string_view
+    str() const;
+};
+
+} // mrdox
+} // clang
+
+#endif
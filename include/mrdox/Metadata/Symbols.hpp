@@ -15,10 +15,14 @@
 
 #include <mrdox/Platform.hpp>
 #include <mrdox/ADT/Optional.hpp>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <compare>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
@@ -39,7 +43,7 @@ public:
     constexpr SymbolID() = default;
 
     template<typename Elem>
-    SymbolID(const Elem* src)
+    constexpr SymbolID(const Elem* src)
     {
         for(auto& c : data_)
             c = *src++;
@@ -120,6 +124,59 @@ compareSymbolNames(
     std::string_view symbolName0,
     std::string_view symbolName1) noexcept;
 
+/** Return the sort key of a symbol name.
+
+    The key is the case-folded name followed
+    by the tiebreak, so that keys compared
+    with @ref compareSymbolNameKeys are
+    ordered as the names are ordered by
+    @ref compareSymbolNames, using only
+    `memcmp`.
+*/
+MRDOX_DECL
+std::string
+makeSymbolNameKey(
+    std::string_view symbolName);
+
+/** Return the result of comparing two keys from @ref makeSymbolNameKey.
+*/
+MRDOX_DECL
+std::strong_ordering
+compareSymbolNameKeys(
+    std::string_view key0,
+    std::string_view key1) noexcept;
+
+/** Sort elements stably by symbol name.
+
+    The key of each name is computed once,
+    so a comparison does not fold case.
+
+    @param v The elements to sort.
+
+    @param name A function which returns
+    the name of an element.
+*/
+template<class T, class Name>
+void
+sortBySymbolName(
+    std::vector<T>& v,
+    Name const& name)
+{
+    if(v.size() < 2)
+        return;
+    std::vector<std::pair<std::string, T>> keyed;
+    keyed.reserve(v.size());
+    for(auto& t : v)
+        keyed.emplace_back(makeSymbolNameKey(name(t)), std::move(t));
+    std::stable_sort(keyed.begin(), keyed.end(),
+        [](auto const& p0, auto const& p1) noexcept
+        {
+            return compareSymbolNameKeys(p0.first, p1.first) < 0;
+        });
+    for(std::size_t i = 0; i < v.size(); ++i)
+        v[i] = std::move(keyed[i].second);
+}
+
 } // mrdox
 } // clang
 
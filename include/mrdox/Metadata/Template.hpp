@@ -15,6 +15,7 @@
 
 #include <mrdox/Platform.hpp>
 #include <mrdox/ADT/Optional.hpp>
+#include <mrdox/Metadata/SourceText.hpp>
 #include <mrdox/Metadata/Type.hpp>
 #include <optional>
 #include <string>
@@ -42,15 +43,15 @@ struct TParam;
 struct TypeTParam
 {
     /** Default type for the type template parameter */
-    std::unique_ptr<TypeInfo> Default;
+    std::shared_ptr<TypeInfo> Default;
 };
 
 struct NonTypeTParam
 {
     /** Type of the non-type template parameter */
-    std::unique_ptr<TypeInfo> Type;
+    std::shared_ptr<TypeInfo> Type;
     // Non-type template parameter default value (if any)
-    Optional<std::string> Default;
+    Optional<SourceText> Default;
 };
 
 struct TemplateTParam
@@ -58,7 +59,7 @@ struct TemplateTParam
     /** Template parameters for the template template parameter */
     std::vector<TParam> Params;
     /** Non-type template parameter default value (if any) */
-    Optional<std::string> Default;
+    Optional<SourceText> Default;
 };
 
 // ----------------------------------------------------------------
@@ -111,7 +111,7 @@ struct TagTypeInfo
     : IsType<TypeKind::Tag>
 {
     QualifierKind CVQualifiers = QualifierKind::None;
-    std::unique_ptr<TypeInfo> ParentType;
+    std::shared_ptr<TypeInfo> ParentType;
     std::string Name;
     SymbolID id = SymbolID::zero;
 };
@@ -120,7 +120,7 @@ struct SpecializationTypeInfo
     : IsType<TypeKind::Specialization>
 {
     QualifierKind CVQualifiers = QualifierKind::None;
-    std::unique_ptr<TypeInfo> ParentType;
+    std::shared_ptr<TypeInfo> ParentType;
     std::string Name;
     SymbolID id = SymbolID::zero;
     std::vector<TArg> TemplateArgs;
@@ -129,42 +129,42 @@ struct SpecializationTypeInfo
 struct LValueReferenceTypeInfo
     : IsType<TypeKind::LValueReference>
 {
-    std::unique_ptr<TypeInfo> PointeeType;
+    std::shared_ptr<TypeInfo> PointeeType;
 };
 
 struct RValueReferenceTypeInfo
     : IsType<TypeKind::RValueReference>
 {
-    std::unique_ptr<TypeInfo> PointeeType;
+    std::shared_ptr<TypeInfo> PointeeType;
 };
 
 struct PointerTypeInfo
     : IsType<TypeKind::Pointer>
 {
     QualifierKind CVQualifiers = QualifierKind::None;
-    std::unique_ptr<TypeInfo> PointeeType;
+    std::shared_ptr<TypeInfo> PointeeType;
 };
 
 struct MemberPointerTypeInfo
     : IsType<TypeKind::MemberPointer>
 {
     QualifierKind CVQualifiers = QualifierKind::None;
-    std::unique_ptr<TypeInfo> ParentType;
-    std::unique_ptr<TypeInfo> PointeeType;
+    std::shared_ptr<TypeInfo> ParentType;
+    std::shared_ptr<TypeInfo> PointeeType;
 };
 
 struct ArrayTypeInfo
     : IsType<TypeKind::Array>
 {
-    std::unique_ptr<TypeInfo> ElementType;
+    std::shared_ptr<TypeInfo> ElementType;
     ConstantExprInfo<std::uint64_t> Bounds;
 };
 
 struct FunctionTypeInfo
     : IsType<TypeKind::Function>
 {
-    std::unique_ptr<TypeInfo> ReturnType;
-    std::vector<std::unique_ptr<TypeInfo>> ParamTypes;
+    std::shared_ptr<TypeInfo> ReturnType;
+    std::vector<std::shared_ptr<TypeInfo>> ParamTypes;
     QualifierKind CVQualifiers = QualifierKind::None;
     ReferenceKind RefQualifier = ReferenceKind::None;
     NoexceptKind ExceptionSpec = NoexceptKind::None;
@@ -173,7 +173,7 @@ struct FunctionTypeInfo
 struct PackTypeInfo
     : IsType<TypeKind::Pack>
 {
-    std::unique_ptr<TypeInfo> PatternType;
+    std::shared_ptr<TypeInfo> PatternType;
 };
 
 template<typename F, typename... Args>
@@ -44,7 +44,7 @@ struct VariableInfo
     friend class ASTVisitor;
 
     /** The type of the variable */
-    std::unique_ptr<TypeInfo> Type;
+    std::shared_ptr<TypeInfo> Type;
 
     std::unique_ptr<TemplateInfo> Template;
 
@@ -49,6 +49,7 @@ struct Param;
 struct SpecializationInfo;
 struct SpecializedMember;
 struct SourceInfo;
+class SourceText;
 struct TypeInfo;
 struct TypedefInfo;
 struct VariableInfo;
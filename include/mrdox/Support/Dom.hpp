@@ -19,10 +19,15 @@
 #include <atomic>
 #include <cstdint>
 #include <initializer_list>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <string>
 #include <string_view>
 #include <type_traits>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 
@@ -46,6 +51,87 @@ enum class Kind
     Object
 };
 
+//------------------------------------------------
+//
+// Stats
+//
+//------------------------------------------------
+
+/** Counters for the work done by the Dom.
+
+    Counting is off until @ref enableStats is
+    called, and costs one relaxed load when off.
+*/
+struct Stats
+{
+    /** A count for one name.
+    */
+    struct Count
+    {
+        std::string name;
+        std::size_t count = 0;
+    };
+
+    /** Objects constructed, by implementation type.
+    */
+    std::vector<Count> objects;
+
+    /** Arrays constructed, by implementation type.
+    */
+    std::vector<Count> arrays;
+
+    /** Calls to Object::find, by key.
+    */
+    std::vector<Count> lookups;
+
+    /** Lazy objects which were constructed.
+    */
+    std::size_t materializations = 0;
+
+    /** Bytes allocated for implementations and strings.
+    */
+    std::size_t bytes = 0;
+};
+
+/** Turn the Dom counters on or off.
+*/
+MRDOX_DECL
+void
+enableStats(bool enable) noexcept;
+
+/** Return the Dom counters, most frequent first.
+*/
+MRDOX_DECL
+Stats
+getStats();
+
+namespace detail {
+
+MRDOX_DECL extern std::atomic<bool> statsEnabled;
+
+MRDOX_DECL
+void
+countNew(
+    char const* type,
+    bool isArray,
+    std::size_t bytes);
+
+MRDOX_DECL
+void
+countLookup(
+    std::string_view key);
+
+MRDOX_DECL
+void
+countBytes(
+    std::size_t bytes) noexcept;
+
+MRDOX_DECL
+void
+countMaterialization() noexcept;
+
+} // detail
+
 //------------------------------------------------
 //
 // String
@@ -62,18 +148,49 @@ concept StringLikeTy =
     std::convertible_to<StringTy, std::string_view>;
 
 /** An immutable string with shared ownership.
+
+    Short strings are stored inline, and longer
+    ones in a reference counted buffer. A string
+    may also refer to a literal, or to a buffer
+    owned by something else, without a copy.
 */
 class MRDOX_DECL
     String final
 {
     struct Impl;
 
-    Impl* impl_ = nullptr;
-    char const* psz_ = nullptr;
+    enum class Kind : unsigned char
+    {
+        Literal,    // psz_, not owned
+        Small,      // buf_
+        Shared      // impl_
+    };
+
+    static constexpr std::size_t SmallSize = 15;
+
+    union Rep
+    {
+        Impl* impl_;
+        char const* psz_;
+        char buf_[SmallSize + 1];
+    };
+
+    Rep rep_;
+    std::uint32_t size_ = 0;
+    Kind kind_ = Kind::Literal;
 
     static Impl* allocate(std::string_view s);
     static void deallocate(Impl*) noexcept;
 
+    constexpr
+    String(
+        char const* psz,
+        std::size_t size) noexcept
+        : rep_{ .psz_ = psz }
+        , size_(static_cast<std::uint32_t>(size))
+    {
+    }
+
 public:
     /** Destructor.
     */
@@ -139,11 +256,30 @@ public:
     */
     template<std::size_t N>
     constexpr String(char const(&psz)[N]) noexcept
-        : psz_(psz)
+        : String(psz, std::char_traits<char>::length(psz))
     {
         static_assert(N > 0);
     }
 
+    /** Return a string which refers to a buffer without copying it.
+
+        Ownership is not transferred. The buffer must
+        not change until the string and all of its
+        copies are destroyed, and the character after
+        the last one must be a null, as it is for
+        `std::string` or a string pool which stores
+        the terminator.
+
+        @param s The characters to refer to.
+    */
+    static
+    String
+    reference(
+        std::string_view s) noexcept
+    {
+        return String(s.data(), s.size());
+    }
+
     /** Assignment.
 
         This transfers ownership of the string
@@ -210,8 +346,9 @@ public:
     */
     void swap(String& other) noexcept
     {
-        std::swap(impl_, other.impl_);
-        std::swap(psz_, other.psz_);
+        std::swap(rep_, other.rep_);
+        std::swap(size_, other.size_);
+        std::swap(kind_, other.kind_);
     }
 
     /** Swap two strings.
@@ -378,6 +515,15 @@ public:
     */
     void emplace_back(value_type value);
 
+    /** Invoke a function with each element, in order.
+
+        The elements are fetched from the
+        implementation in batches, rather than
+        with one call for each element.
+    */
+    template<class F>
+    void forEach(F&& f) const;
+
     /** Swap two arrays.
     */
     void swap(Array& other) noexcept
@@ -431,6 +577,18 @@ public:
     */
     virtual value_type get(size_type i) const = 0;
 
+    /** Copy consecutive elements, without bounds checking.
+
+        This assigns the elements starting at
+        `first` to `dest`. The default calls
+        @ref get for each element.
+    */
+    virtual
+    void
+    getRange(
+        size_type first,
+        std::span<value_type> dest) const;
+
     /** Append an element to the end of the array.
 
         The default implementation throws an exception,
@@ -466,12 +624,49 @@ public:
 
     size_type size() const override;
     value_type get(size_type i) const override;
+    void getRange(size_type, std::span<value_type>) const override;
     void emplace_back(value_type value) override;
 
 private:
     std::vector<value_type> elements_;
 };
 
+//------------------------------------------------
+//
+// CachedArrayImpl
+//
+//------------------------------------------------
+
+/** An array which keeps the elements of another.
+
+    Some arrays build a new value each time an
+    element is read. When such an array is read
+    more than once, wrapping it in this reads
+    every element of the wrapped array in one
+    batch the first time, and keeps them.
+*/
+class MRDOX_DECL
+    CachedArrayImpl : public ArrayImpl
+{
+    Array arr_;
+    mutable std::once_flag once_;
+    mutable std::vector<value_type> elements_;
+
+    std::vector<value_type> const& elements() const;
+
+public:
+    explicit
+    CachedArrayImpl(
+        Array arr) noexcept
+        : arr_(std::move(arr))
+    {
+    }
+
+    size_type size() const override;
+    value_type get(size_type i) const override;
+    void getRange(size_type, std::span<value_type>) const override;
+};
+
 /** Return a new array using a custom implementation.
 */
 template<class T, class... Args>
@@ -479,6 +674,8 @@ requires std::derived_from<T, ArrayImpl>
 Array
 newArray(Args&&... args)
 {
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countNew(typeid(T).name(), true, sizeof(T));
     return Array(std::make_shared<T>(
         std::forward<Args>(args)...));
 }
@@ -723,6 +920,13 @@ public:
     */
     virtual Value find(std::string_view key) const = 0;
 
+    /** Return true if the specified key exists.
+
+        The default implementation compares
+        each key in turn.
+    */
+    virtual bool exists(std::string_view key) const;
+
     /** Insert or set the given key/value pair.
     */
     virtual void set(String key, Value value) = 0;
@@ -735,6 +939,8 @@ requires std::derived_from<T, ObjectImpl>
 Object
 newObject(Args&&... args)
 {
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countNew(typeid(T).name(), false, sizeof(T));
     return Object(std::make_shared<T>(
         std::forward<Args>(args)...));
 }
@@ -746,23 +952,101 @@ newObject(Args&&... args)
 //------------------------------------------------
 
 /** The default Object implementation.
+
+    Small objects are searched linearly. Once an
+    object has more than @ref indexThreshold keys,
+    a hash index from key to position is used.
+
+    Objects which always have the same keys in the
+    same order, such as the ones built for each
+    kind of symbol, can share one index built in
+    advance by @ref makeIndex.
 */
 class MRDOX_DECL
     DefaultObjectImpl : public ObjectImpl
 {
 public:
+    /** A map from keys to entry positions.
+    */
+    struct Index;
+
+    /** A shared index.
+    */
+    using index_type = std::shared_ptr<Index>;
+
+    /** The smallest size which uses an index.
+    */
+    static constexpr std::size_t indexThreshold = 8;
+
+    /** Return an index for the keys of the entries.
+
+        The index may be passed to the constructor
+        of every object with the same keys, in the
+        same order. It is never modified.
+    */
+    static index_type makeIndex(storage_type const& entries);
+
     DefaultObjectImpl() noexcept;
 
     explicit DefaultObjectImpl(
-        storage_type entries) noexcept;
+        storage_type entries);
+
+    DefaultObjectImpl(
+        storage_type entries,
+        index_type index) noexcept;
 
     std::size_t size() const override;
     reference get(std::size_t) const override;
     Value find(std::string_view) const override;
+    bool exists(std::string_view) const override;
     void set(String, Value) override;
 
 private:
+    std::size_t position(std::string_view key) const noexcept;
+
     storage_type entries_;
+    index_type index_;
+};
+
+//------------------------------------------------
+//
+// ObjectPool
+//
+//------------------------------------------------
+
+/** A pool of storage for short-lived objects.
+
+    Objects made by the pool are ordinary objects,
+    but the storage for each one, including its
+    reference count, comes from a free list owned
+    by the pool. When the last reference to an
+    object is released the storage goes back on
+    the list, so an object built for every page
+    rendered reuses the same few blocks instead
+    of allocating.
+
+    The storage is kept alive by the objects
+    themselves, so they may outlive the pool.
+*/
+class MRDOX_DECL
+    ObjectPool
+{
+public:
+    struct Impl;
+
+private:
+    std::shared_ptr<Impl> impl_;
+
+public:
+    /** Constructor.
+    */
+    ObjectPool();
+
+    /** Return a new object using storage from the pool.
+    */
+    Object
+    newObject(
+        Object::storage_type entries = {}) const;
 };
 
 //------------------------------------------------
@@ -794,6 +1078,71 @@ public:
     std::size_t size() const override;
     reference get(std::size_t i) const override;
     Value find(std::string_view key) const override;
+    bool exists(std::string_view key) const override;
+    void set(String key, Value value) override;
+};
+
+//------------------------------------------------
+//
+// LazyFieldsObjectImpl
+//
+//------------------------------------------------
+
+/** An Object whose values are computed one key at a time.
+
+    The keys are those of a schema, which is
+    shared by every object of the same kind.
+    The value of a key is computed the first
+    time it is read and then kept, so that an
+    object read for a few of its keys does not
+    pay for the others.
+*/
+class MRDOX_DECL
+    LazyFieldsObjectImpl : public ObjectImpl
+{
+public:
+    /** The keys of the objects of one kind.
+    */
+    struct Schema
+    {
+        storage_type keys;
+        DefaultObjectImpl::index_type index;
+
+        explicit
+        Schema(
+            storage_type keys);
+    };
+
+    using schema_type = std::shared_ptr<Schema const>;
+
+private:
+    schema_type schema_;
+    std::mutex mutable mutex_;
+    storage_type mutable entries_;
+    std::vector<bool> mutable done_;
+
+    std::size_t position(std::string_view key) const noexcept;
+    Object::value_type const& entry(std::size_t i) const;
+
+protected:
+    /** Return the value of the i-th key of the schema.
+
+        Keys may be read concurrently. When two
+        threads read a key which is not computed
+        yet, both compute it and the first value
+        is kept.
+    */
+    virtual Value compute(std::size_t i) const = 0;
+
+public:
+    explicit
+    LazyFieldsObjectImpl(
+        schema_type schema);
+
+    std::size_t size() const override;
+    reference get(std::size_t i) const override;
+    Value find(std::string_view key) const override;
+    bool exists(std::string_view key) const override;
     void set(String key, Value value) override;
 };
 
@@ -1279,6 +1628,21 @@ inline void Array::emplace_back(value_type value)
     impl_->emplace_back(std::move(value));
 }
 
+template<class F>
+void Array::forEach(F&& f) const
+{
+    constexpr size_type batch = 32;
+    value_type buf[batch];
+    size_type const n = size();
+    for(size_type i = 0; i < n; i += batch)
+    {
+        size_type const k = std::min(batch, n - i);
+        impl_->getRange(i, std::span<value_type>(buf, k));
+        for(size_type j = 0; j < k; ++j)
+            f(buf[j]);
+    }
+}
+
 //------------------------------------------------
 
 inline bool Object::empty() const
@@ -1310,6 +1674,8 @@ inline auto Object::at(size_type i) const -> reference
 
 inline Value Object::find(std::string_view key) const
 {
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countLookup(key);
     return impl_->find(key);
 }
 
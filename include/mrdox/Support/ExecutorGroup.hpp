@@ -16,8 +16,11 @@
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/ThreadPool.hpp>
 #include <deque>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <ranges>
+#include <type_traits>
 #include <vector>
 
 namespace clang {
@@ -30,6 +33,7 @@ class MRDOX_DECL
 
 protected:
     struct Impl;
+    struct Batch;
 
     struct MRDOX_DECL
         AnyAgent
@@ -41,10 +45,31 @@ protected:
     std::unique_ptr<Impl> impl_;
     std::vector<std::unique_ptr<AnyAgent>> agents_;
     std::deque<any_callable<void(void*)>> work_;
+    std::deque<std::shared_ptr<Batch>> batches_;
 
     explicit ExecutorGroupBase(ThreadPool&);
     void post(any_callable<void(void*)>);
-    void run(std::unique_lock<std::mutex>);
+    void postRange(std::size_t, any_callable<void(void*, std::size_t)>);
+    void run();
+    void addError(Error err);
+
+    // work which returns an Error reports it
+    // through wait, without throwing it
+    template<class F, class... Args>
+    void
+    invoke(F& f, Args&&... args)
+    {
+        if constexpr(std::is_same_v<
+                std::invoke_result_t<F&, Args...>, Error>)
+        {
+            if(Error err = f(std::forward<Args>(args)...))
+                addError(std::move(err));
+        }
+        else
+        {
+            f(std::forward<Args>(args)...);
+        }
+    }
 
 public:
     template<class T>
@@ -115,6 +140,9 @@ public:
         @code
         void( Agent&, Args... );
         @endcode
+        It may return an @ref Error instead,
+        which is returned by @ref wait like an
+        exception thrown from the work.
     */
     template<class F, class... Args>
     void
@@ -123,16 +151,55 @@ public:
         static_assert(std::is_invocable_v<F, Agent&, arg_t<Args>...>);
         post(
             [
+                this,
                 f = std::forward<F>(f),
                 args = std::tuple<arg_t<Args>...>(args...)
-            ](void* agent)
+            ](void* agent) mutable
             {
-                std::apply(f,
+                std::apply(
+                    [&](auto&&... a)
+                    {
+                        invoke(f, std::forward<decltype(a)>(a)...);
+                    },
                     std::tuple_cat(std::tuple<Agent&>(
                         *reinterpret_cast<Agent*>(agent)),
                     std::move(args)));
             });
     }
+
+    /** Submit work for each element of a range.
+
+        The elements are claimed by the agents
+        a few at a time, so no allocation or
+        lock is needed for each element. The
+        range is not copied, and must remain
+        valid until the work has completed.
+        The function object must have this
+        equivalent signature:
+        @code
+        void( Agent&, std::ranges::range_reference_t<Range> );
+        @endcode
+        As with @ref async, it may return an
+        @ref Error instead.
+    */
+    template<class Range, class F>
+    void
+    asyncRange(Range&& range, F&& f)
+    {
+        static_assert(std::ranges::random_access_range<Range>);
+        static_assert(std::is_invocable_v<F, Agent&,
+            std::ranges::range_reference_t<Range>>);
+        auto first = std::ranges::begin(range);
+        postRange(std::ranges::size(range),
+            [
+                this,
+                f = std::forward<F>(f),
+                first
+            ](void* agent, std::size_t i) mutable
+            {
+                invoke(f, *reinterpret_cast<Agent*>(agent), first[i]);
+            });
+    }
 };
 
 } // mrdox
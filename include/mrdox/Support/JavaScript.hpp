@@ -15,6 +15,9 @@
 #include <mrdox/Support/Dom.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <cstdlib>
+#include <functional>
+#include <optional>
+#include <span>
 #include <string_view>
 
 namespace clang {
@@ -33,6 +36,13 @@ class Value;
 
 //------------------------------------------------
 
+/** A native function which can be called from JavaScript.
+*/
+using NativeFunction = std::function<
+    dom::Value(std::span<dom::Value const> args)>;
+
+//------------------------------------------------
+
 /** Types of values.
 */
 enum class Type
@@ -98,6 +108,24 @@ public:
     /** Constructor.
     */
     MRDOX_DECL Context(Context const&) noexcept;
+
+    /** Record the state which @ref reset returns to.
+
+        This is called once the scripts which are
+        shared by every use of the context are
+        loaded. The names of the global properties
+        are recorded.
+    */
+    MRDOX_DECL void snapshot();
+
+    /** Drop the garbage accumulated since the snapshot.
+
+        The global properties defined after the
+        snapshot are deleted, and a full garbage
+        collection is run, which also reclaims
+        cycles.
+    */
+    MRDOX_DECL void reset();
 };
 
 //------------------------------------------------
@@ -125,6 +153,24 @@ public:
     Error
     script(std::string_view jsCode);
 
+    /** Compile a script to bytecode without running it.
+
+        The bytecode may be run with @ref scriptBytecode
+        in any context of the same interpreter build.
+    */
+    MRDOX_DECL
+    Expected<std::string>
+    compile(std::string_view jsCode);
+
+    /** Run a script compiled with @ref compile.
+
+        The bytecode is trusted, and invalid
+        bytecode results in undefined behavior.
+    */
+    MRDOX_DECL
+    Error
+    scriptBytecode(std::string_view bytecode);
+
     /** Return the global object.
     */
     MRDOX_DECL
@@ -136,6 +182,28 @@ public:
     MRDOX_DECL
     Expected<Value>
     getGlobal(std::string_view name);
+
+    /** Return a function which calls a native function.
+
+        Arguments are converted to Dom values.
+        Objects and arrays which came from Dom
+        values are passed as the original values.
+        Other objects are copied, numbers are
+        truncated to integers, and functions
+        become null. An Exception thrown by the
+        function becomes a JavaScript error.
+
+        @param fn The function to call.
+
+        @param dropLast If true, the last argument
+        is neither converted nor passed. Handlebars
+        passes its options object last to helpers.
+    */
+    MRDOX_DECL
+    Value
+    makeFunction(
+        NativeFunction fn,
+        bool dropLast = false);
 };
 
 //------------------------------------------------
@@ -261,6 +329,13 @@ public:
 
     std::string getString() const;
 
+    /** Return the string without copying it.
+
+        The view remains valid for as long
+        as this value exists.
+    */
+    std::string_view getStringView() const;
+
 void setlog();
     /** Call a function.
     */
@@ -308,6 +383,67 @@ private:
         std::size_t size) const;
 };
 
+//------------------------------------------------
+
+/** A reference to a value which outlives its scope.
+
+    The value is kept in the global stash of the
+    context until the handle is destroyed. It is
+    not collected, and @ref Context::reset does
+    not drop it, so long-lived values such as
+    compiled templates are not fetched again for
+    each use.
+*/
+class Handle
+{
+    std::optional<Context> ctx_;
+    unsigned id_ = 0;
+
+    void release() noexcept;
+
+public:
+    /** Destructor.
+    */
+    MRDOX_DECL ~Handle();
+
+    /** Constructor.
+
+        Default constructed handles refer to no value.
+    */
+    MRDOX_DECL Handle() noexcept;
+
+    /** Constructor.
+    */
+    MRDOX_DECL Handle(Handle&&) noexcept;
+
+    /** Constructor.
+
+        The value is added to the stash.
+    */
+    MRDOX_DECL explicit Handle(Value const& value);
+
+    /** Assignment.
+    */
+    MRDOX_DECL Handle& operator=(Handle&&) noexcept;
+
+    Handle(Handle const&) = delete;
+    Handle& operator=(Handle const&) = delete;
+
+    /** Return true if the handle refers to a value.
+    */
+    explicit operator bool() const noexcept
+    {
+        return ctx_.has_value();
+    }
+
+    /** Return the value in a scope.
+
+        The scope must belong to the
+        context of the value.
+    */
+    MRDOX_DECL Value get(Scope& scope) const;
+};
+
 inline bool Value::isUndefined() const noexcept
 {
     return type() == Type::undefined;
@@ -16,8 +16,12 @@
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/source_location.hpp>
 #include <fmt/format.h>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 
@@ -36,6 +40,11 @@ class Function;
 
 using FunctionPtr = Value (*)(std::vector<Value>);
 
+/** A native function which can be called from Lua.
+*/
+using NativeFunction = std::function<
+    dom::Value(std::span<dom::Value const> args)>;
+
 //------------------------------------------------
 
 /** A null-terminated string.
@@ -70,7 +79,34 @@ public:
 
 //------------------------------------------------
 
+/** The memory used by an instance of a Lua interpreter.
+*/
+struct MemoryStats
+{
+    /** The number of bytes in use.
+    */
+    std::size_t bytes = 0;
+
+    /** The most bytes in use at once.
+    */
+    std::size_t peak = 0;
+
+    /** The number of blocks allocated.
+    */
+    std::size_t allocations = 0;
+
+    /** The number of allocations refused because of the limit.
+    */
+    std::size_t refused = 0;
+};
+
 /** A reference to an instance of a Lua interpreter.
+
+    Each interpreter has its own allocator, which
+    keeps a free list for each size class of small
+    blocks and hands them out from large chunks,
+    so it is not contended by the other threads.
+    The chunks are freed with the interpreter.
 */
 class MRDOX_DECL
     Context
@@ -95,9 +131,55 @@ public:
     */
     Context();
 
+    /** Constructor.
+
+        @param memoryLimit The most bytes which the
+        interpreter may use, or zero for no limit.
+        An allocation past the limit raises a Lua
+        error, so a runaway script fails instead
+        of exhausting the memory of the process.
+    */
+    explicit Context(std::size_t memoryLimit);
+
     /** Constructor.
     */
     Context(Context const&) noexcept;
+
+    /** Return the memory used by the interpreter.
+    */
+    MemoryStats memoryStats() const noexcept;
+
+    /** Record the globals which @ref reset returns to.
+
+        This is called once the scripts which are
+        shared by every use of the context are
+        loaded.
+    */
+    void snapshot();
+
+    /** Return the globals to the snapshot.
+
+        Globals defined after the snapshot are
+        removed, and those which were assigned
+        are restored, so a context may be reused
+        for unrelated work without reloading the
+        standard libraries or shared scripts.
+        Modules loaded with `require` are kept.
+        The collector is stepped, so garbage of
+        earlier work is reclaimed gradually.
+    */
+    void reset();
+
+    /** Set the time after which a running script fails.
+
+        Past the deadline, the script raises a
+        Lua error, so a runaway script ends
+        instead of running forever. The maximum
+        time point removes the deadline.
+    */
+    void
+    setDeadline(
+        std::chrono::steady_clock::time_point t);
 };
 
 //------------------------------------------------
@@ -138,6 +220,20 @@ public:
         source_location loc =
             source_location::current());
 
+    /** Compile a Lua chunk to bytecode.
+
+        The bytecode may be passed to @ref loadChunk
+        in any context of the same build, which skips
+        the parser. It is not portable between builds.
+    */
+    MRDOX_DECL
+    Expected<std::string>
+    compile(
+        std::string_view luaChunk,
+        zstring chunkName,
+        source_location loc =
+            source_location::current());
+
     /** Run a Lua chunk.
     */
     MRDOX_DECL
@@ -161,6 +257,21 @@ public:
         std::string_view key,
         source_location loc =
             source_location::current());
+
+    /** Return a function which calls a native function.
+
+        Arguments are converted to Dom values.
+        Userdata which came from Dom values are
+        passed as the original values, and tables
+        are copied. A table whose keys are 1 to n
+        becomes an array. Numbers are truncated to
+        integers, and functions become null. An
+        Exception thrown by the function becomes
+        a Lua error.
+    */
+    MRDOX_DECL
+    Value
+    makeFunction(NativeFunction fn);
 };
 
 //------------------------------------------------
@@ -186,7 +297,7 @@ class MRDOX_DECL
     union
     {
         bool b_;
-        int i_;
+        std::int64_t i_;
         int index_; // for Value
         std::string_view s_;
         dom::Array arr_;
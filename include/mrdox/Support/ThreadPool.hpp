@@ -15,16 +15,13 @@
 #include <mrdox/Platform.hpp>
 #include <mrdox/Support/any_callable.hpp>
 #include <mrdox/Support/Error.hpp>
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
-namespace llvm {
-class ThreadPool;
-class ThreadPoolTaskGroup;
-} // llvm
-
 namespace clang {
 namespace mrdox {
 
@@ -33,15 +30,47 @@ class TaskGroup;
 //------------------------------------------------
 
 /** A pool of threads for executing work concurrently.
+
+    Each thread has its own queue of work. Work
+    submitted from a thread of the pool goes to
+    the queue of that thread, which runs the most
+    recent work first, while idle threads take the
+    oldest work from the queues of other threads.
+
+    The threads may be placed on the NUMA nodes
+    of the machine. Each thread then runs only on
+    the processors of its node, and steals from
+    threads of the same node first. Work which is
+    submitted to a node runs there, so memory it
+    allocates is local to the node.
+
+    Work has a @ref Priority. Queued work of a
+    higher priority always runs first, so later
+    stages of a pipeline, which release memory,
+    are not held up behind earlier ones.
 */
 class MRDOX_VISIBLE
     ThreadPool
 {
-    std::unique_ptr<llvm::ThreadPool> impl_;
+    struct Impl;
+
+    std::unique_ptr<Impl> impl_;
 
     friend class TaskGroup;
 
 public:
+    /** The priority of submitted work.
+    */
+    enum class Priority
+    {
+        /// Work which may wait, such as parsing
+        Low,
+        /// The default
+        Normal,
+        /// Work which others wait on
+        High
+    };
+
     template<class T> struct arg_ty { using type = T; };
     template<class T> struct arg_ty<T&> { using type =
         std::conditional_t< std::is_const_v<T>, T, T&>; };
@@ -62,18 +91,32 @@ public:
     ThreadPool();
 
     /** Constructor.
+
+        @param concurrency The number of threads,
+        or zero for one per hardware thread.
+
+        @param numa Whether the threads are
+        placed on the NUMA nodes of the machine.
     */
     MRDOX_DECL
     explicit
     ThreadPool(
-        unsigned concurrency);
+        unsigned concurrency,
+        bool numa = false);
 
     /** Reset the pool to the specified concurrency.
+
+        @param concurrency The number of threads,
+        or zero for one per hardware thread.
+
+        @param numa Whether the threads are
+        placed on the NUMA nodes of the machine.
     */
     MRDOX_DECL
     void
     reset(
-        unsigned concurrency);
+        unsigned concurrency,
+        bool numa = false);
 
     /** Return the number of threads in the pool.
     */
@@ -81,6 +124,15 @@ public:
     unsigned
     getThreadCount() const noexcept;
 
+    /** Return the number of NUMA nodes the threads are placed on.
+
+        This is one unless placement was requested
+        and the machine has more than one node.
+    */
+    MRDOX_DECL
+    unsigned
+    getNodeCount() const noexcept;
+
     /** Submit work to be executed.
 
         The signature of the submitted function
@@ -93,15 +145,56 @@ public:
         post(std::forward<F>(f));
     }
 
+    /** Submit work to be executed on a NUMA node.
+
+        The node is taken modulo the number of
+        nodes, so any value may be used.
+    */
+    template<class F>
+    void
+    async(unsigned node, F&& f)
+    {
+        post(node, std::forward<F>(f));
+    }
+
+    /** Submit work to be executed with a priority.
+    */
+    template<class F>
+    void
+    async(Priority priority, F&& f)
+    {
+        post(priority, std::forward<F>(f));
+    }
+
     /** Invoke a function object for each element of a range.
 
+        The elements are submitted in contiguous
+        blocks of `grain` elements, each of which is
+        one piece of work. When `grain` is zero and
+        the size of the range is known, it is chosen
+        to make a few blocks for each thread. Ranges
+        without random access, such as a `StringMap`,
+        are split into blocks in one pass over
+        their iterators.
+
         @return Zero or more errors which were
         thrown from submitted work.
+
+        @param range The range of elements.
+
+        @param f The function object, invoked
+        with each element.
+
+        @param grain The number of elements in
+        each block, or zero to choose it.
     */
     template<class Range, class F>
     [[nodiscard]]
     std::vector<Error>
-    forEach(Range&& range, F const& f);
+    forEach(
+        Range&& range,
+        F const& f,
+        std::size_t grain = 0);
 
     /** Block until all work has completed.
     */
@@ -111,6 +204,8 @@ public:
 
 private:
     MRDOX_DECL void post(any_callable<void(void)>);
+    MRDOX_DECL void post(unsigned, any_callable<void(void)>);
+    MRDOX_DECL void post(Priority, any_callable<void(void)>);
 };
 
 //------------------------------------------------
@@ -131,11 +226,18 @@ public:
     ~TaskGroup();
 
     /** Constructor.
+
+        @param threadPool The pool which runs the work.
+
+        @param priority The priority of all the
+        work submitted to the group.
     */
     MRDOX_DECL
     explicit
     TaskGroup(
-        ThreadPool& threadPool);
+        ThreadPool& threadPool,
+        ThreadPool::Priority priority =
+            ThreadPool::Priority::Normal);
 
     /** Submit work to be executed.
 
@@ -149,8 +251,23 @@ public:
         post(std::forward<F>(f));
     }
 
+    /** Submit work to be executed on a NUMA node.
+
+        The node is taken modulo the number of
+        nodes, so any value may be used.
+    */
+    template<class F>
+    void
+    async(unsigned node, F&& f)
+    {
+        post(node, std::forward<F>(f));
+    }
+
     /** Block until all work has completed.
 
+        When called from a thread of the pool,
+        the thread runs queued work while waiting.
+
         @return Zero or more errors which were
         thrown from submitted work.
     */
@@ -161,6 +278,7 @@ public:
 
 private:
     MRDOX_DECL void post(any_callable<void(void)>);
+    MRDOX_DECL void post(unsigned, any_callable<void(void)>);
 };
 
 //------------------------------------------------
@@ -170,15 +288,71 @@ std::vector<Error>
 ThreadPool::
 forEach(
     Range&& range,
-    F const& f)
+    F const& f,
+    std::size_t grain)
 {
+    using std::begin;
+    using std::end;
+    auto it = begin(range);
+    auto const last = end(range);
+    using iterator = decltype(it);
+    constexpr bool isRandomAccess = std::is_base_of_v<
+        std::random_access_iterator_tag,
+        typename std::iterator_traits<iterator>::iterator_category>;
+
+    if(grain == 0)
+    {
+        grain = 1;
+        std::size_t size = 0;
+        if constexpr(isRandomAccess)
+            size = static_cast<std::size_t>(last - it);
+        else if constexpr(requires { range.size(); })
+            size = range.size();
+        // a few blocks for each thread,
+        // to balance uneven elements
+        std::size_t const blocks = 4 * std::max(getThreadCount(), 1u);
+        if(size > blocks)
+            grain = (size + blocks - 1) / blocks;
+    }
+
     TaskGroup taskGroup(*this);
-    for(auto&& value : range)
+    while(it != last)
+    {
+        iterator first = it;
+        std::size_t n = 0;
+        if constexpr(isRandomAccess)
+        {
+            n = std::min<std::size_t>(grain, last - it);
+            it += n;
+        }
+        else
+        {
+            for(; n < grain && it != last; ++n)
+                ++it;
+        }
         taskGroup.async(
-            [&f, &value]
+            [&f, first, n]() mutable
             {
-                f(value);
+                // the other elements of the block are
+                // still visited when one of them throws
+                std::vector<Error> errors;
+                for(std::size_t i = 0; i < n; ++i, ++first)
+                {
+                    try
+                    {
+                        f(*first);
+                    }
+                    catch(Exception const& ex)
+                    {
+                        errors.emplace_back(ex.error());
+                    }
+                }
+                if(errors.size() == 1)
+                    std::move(errors.front()).Throw();
+                if(! errors.empty())
+                    Error(errors).Throw();
             });
+    }
     return taskGroup.wait();
 }
 
@@ -12,7 +12,9 @@
 #define MRDOX_API_SUPPORT_ANY_CALLABLE_HPP
 
 #include <mrdox/Platform.hpp>
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -21,6 +23,10 @@ namespace mrdox {
 
 /** A movable, type-erased function object.
 
+    Function objects which are small enough and
+    nothrow move constructible are stored inside
+    the object, so that no allocation is needed.
+
     Usage:
     @code
     any_callable<void(void)> f;
@@ -36,15 +42,81 @@ class any_callable<R(Args...)>
     {
         virtual ~base() = default;
         virtual R invoke(Args&&...args) = 0;
+        virtual base* move(void* dest) noexcept = 0;
     };
 
-    std::unique_ptr<base> p_;
+    // the object is one cache line in total
+    static constexpr std::size_t bufferSize =
+        64 - sizeof(base*);
+
+    alignas(std::max_align_t)
+        unsigned char buf_[bufferSize];
+    base* p_;
+
+    bool
+    isInline() const noexcept
+    {
+        return static_cast<void const*>(p_) == buf_;
+    }
+
+    void
+    destroy() noexcept
+    {
+        if(! p_)
+            return;
+        if(isInline())
+            p_->~base();
+        else
+            delete p_;
+        p_ = nullptr;
+    }
+
+    void
+    take(any_callable& other) noexcept
+    {
+        if(! other.p_)
+        {
+            p_ = nullptr;
+        }
+        else if(other.isInline())
+        {
+            p_ = other.p_->move(buf_);
+            other.destroy();
+        }
+        else
+        {
+            p_ = std::exchange(other.p_, nullptr);
+        }
+    }
 
 public:
     any_callable() = delete;
 
+    ~any_callable()
+    {
+        destroy();
+    }
+
+    any_callable(any_callable&& other) noexcept
+    {
+        take(other);
+    }
+
+    any_callable&
+    operator=(any_callable&& other) noexcept
+    {
+        if(this != &other)
+        {
+            destroy();
+            take(other);
+        }
+        return *this;
+    }
+
     template<class Callable>
-    requires std::is_invocable_r_v<R, Callable, Args...>
+    requires
+        (! std::is_same_v<std::remove_cvref_t<Callable>, any_callable>) &&
+        std::is_invocable_r_v<R, Callable, Args...>
     any_callable(Callable&& f)
     {
         class impl : public base
@@ -61,9 +133,26 @@ public:
             {
                 return f_(std::forward<Args>(args)...);
             }
+
+            base* move(void* dest) noexcept override
+            {
+                if constexpr(std::is_nothrow_move_constructible_v<impl>)
+                    return ::new(dest) impl(std::move(*this));
+                else
+                    return nullptr; // never stored inline
+            }
+
+            impl(impl&&) = default;
         };
 
-        p_ = std::make_unique<impl>(std::forward<Callable>(f));
+        if constexpr(
+            sizeof(impl) <= bufferSize &&
+            alignof(impl) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible_v<impl>)
+            p_ = ::new(static_cast<void*>(buf_))
+                impl(std::forward<Callable>(f));
+        else
+            p_ = new impl(std::forward<Callable>(f));
     }
 
     R operator()(Args&&...args) const
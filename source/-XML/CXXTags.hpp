@@ -234,7 +234,7 @@ writeType(
             {
                 std::string bounds = t.Bounds.Value ?
                     std::to_string(*t.Bounds.Value) :
-                    t.Bounds.Written;
+                    std::string(t.Bounds.Written.str());
                 if(! bounds.empty())
                     attrs.push({"bounds", bounds});
             }
@@ -294,7 +294,7 @@ writeType(
 inline
 void
 writeType(
-    const std::unique_ptr<TypeInfo>& type,
+    const std::shared_ptr<TypeInfo>& type,
     XMLTags& tags)
 {
     if(! type)
@@ -316,7 +316,7 @@ inline void writeParam(Param const& P, XMLTags& tags)
 {
     tags.open(paramTagName, {
         { "name", P.Name, ! P.Name.empty() },
-        { "default", P.Default, ! P.Default.empty() },
+        { "default", P.Default.str(), ! P.Default.empty() },
         });
     writeType(*P.Type, tags);
     tags.close(paramTagName);
@@ -346,7 +346,7 @@ inline void writeTemplateParam(const TParam& I, XMLTags& tags)
         const auto& t = I.get<NonTypeTParam>();
         std::string_view default_val;
         if(t.Default)
-            default_val = t.Default.value();
+            default_val = t.Default->str();
 
         tags.write(tparamTagName, {}, {
             { "name", I.Name, ! I.Name.empty() },
@@ -362,7 +362,7 @@ inline void writeTemplateParam(const TParam& I, XMLTags& tags)
         const auto& t = I.get<TemplateTParam>();
         std::string_view default_val;
         if(t.Default)
-            default_val = t.Default.value();
+            default_val = t.Default->str();
         tags.open(tparamTagName, {
             { "name", I.Name, ! I.Name.empty() },
             { "class", "template" },
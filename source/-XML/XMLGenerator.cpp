@@ -20,15 +20,34 @@ namespace clang {
 namespace mrdox {
 namespace xml {
 
+Error
+XMLGenerator::
+build(
+    std::string_view outputPath,
+    Corpus const& corpus) const
+{
+    if(! corpus.config.multiPage)
+        return Generator::build(outputPath, corpus);
+    return XMLWriter::buildPages(outputPath, corpus);
+}
+
 Error
 XMLGenerator::
 buildOne(
     std::ostream& os,
     Corpus const& corpus) const
 {
-    namespace fs = llvm::sys::fs;
     RawOstream raw_os(os);
-    return XMLWriter(raw_os, corpus).build();
+    return buildOne(raw_os, corpus);
+}
+
+Error
+XMLGenerator::
+buildOne(
+    llvm::raw_ostream& os,
+    Corpus const& corpus) const
+{
+    return XMLWriter(os, corpus).build();
 }
 
 } // xml
@@ -44,10 +44,20 @@ struct XMLGenerator : Generator
         return "xml";
     }
 
+    Error
+    build(
+        std::string_view outputPath,
+        Corpus const& corpus) const override;
+
     Error
     buildOne(
         std::ostream& os,
         Corpus const& corpus) const override;
+
+    Error
+    buildOne(
+        llvm::raw_ostream& os,
+        Corpus const& corpus) const override;
 };
 
 } // xml
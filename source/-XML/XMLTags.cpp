@@ -12,6 +12,14 @@
 #include "XMLTags.hpp"
 #include "Support/Radix.hpp"
 #include <mrdox/Platform.hpp>
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 namespace clang {
 namespace mrdox {
@@ -23,49 +31,137 @@ namespace xml {
 //
 //------------------------------------------------
 
+namespace {
+
+constexpr
+bool
+needsEscape(char c) noexcept
+{
+    return
+        c == '<' || c == '>' || c == '&' ||
+        c == '\'' || c == '"';
+}
+
+// '<' and '>' differ only in bit 1, and '&'
+// and '\'' only in bit 0, so three compares
+// find all five characters.
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+std::size_t
+findEscape(
+    char const* p,
+    std::size_t n) noexcept
+{
+    __m128i const gt = _mm_set1_epi8('>');
+    __m128i const apos = _mm_set1_epi8('\'');
+    __m128i const quot = _mm_set1_epi8('"');
+    __m128i const bit0 = _mm_set1_epi8(1);
+    __m128i const bit1 = _mm_set1_epi8(2);
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i const v = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p + i));
+        __m128i const m = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_or_si128(v, bit1), gt),
+                _mm_cmpeq_epi8(_mm_or_si128(v, bit0), apos)),
+            _mm_cmpeq_epi8(v, quot));
+        if(unsigned const bits = _mm_movemask_epi8(m))
+            return i + std::countr_zero(bits);
+    }
+    for(; i < n; ++i)
+        if(needsEscape(p[i]))
+            return i;
+    return n;
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+std::size_t
+findEscape(
+    char const* p,
+    std::size_t n) noexcept
+{
+    uint8x16_t const gt = vdupq_n_u8('>');
+    uint8x16_t const apos = vdupq_n_u8('\'');
+    uint8x16_t const quot = vdupq_n_u8('"');
+    uint8x16_t const bit0 = vdupq_n_u8(1);
+    uint8x16_t const bit1 = vdupq_n_u8(2);
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        uint8x16_t const v = vld1q_u8(
+            reinterpret_cast<std::uint8_t const*>(p + i));
+        uint8x16_t const m = vorrq_u8(
+            vorrq_u8(
+                vceqq_u8(vorrq_u8(v, bit1), gt),
+                vceqq_u8(vorrq_u8(v, bit0), apos)),
+            vceqq_u8(v, quot));
+        // four bits for each byte of the mask
+        std::uint64_t const bits = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(
+                vreinterpretq_u16_u8(m), 4)), 0);
+        if(bits)
+            return i + std::countr_zero(bits) / 4;
+    }
+    for(; i < n; ++i)
+        if(needsEscape(p[i]))
+            return i;
+    return n;
+}
+
+#else
+
+std::size_t
+findEscape(
+    char const* p,
+    std::size_t n) noexcept
+{
+    for(std::size_t i = 0; i < n; ++i)
+        if(needsEscape(p[i]))
+            return i;
+    return n;
+}
+
+#endif
+
+} // (anon)
+
 void
 xmlEscape::
 write(
     llvm::raw_ostream& os) const
 {
-    std::size_t pos = 0;
-    auto const size = s_.size();
-    while(pos < size)
+    char const* p = s_.data();
+    std::size_t n = s_.size();
+    for(;;)
     {
-    unescaped:
-        auto const found = s_.find_first_of("<>&'\"", pos);
-        if(found == llvm::StringRef::npos)
-        {
-            os.write(s_.data() + pos, s_.size() - pos);
+        std::size_t const i = findEscape(p, n);
+        os.write(p, i);
+        if(i == n)
             break;
-        }
-        os.write(s_.data() + pos, found - pos);
-        pos = found;
-        while(pos < size)
+        switch(p[i])
         {
-            auto const c = s_[pos];
-            switch(c)
-            {
-            case '<':
-                os.write("&lt;", 4);
-                break;
-            case '>':
-                os.write("&gt;", 4);
-                break;
-            case '&':
-                os.write("&amp;", 5);
-                break;
-            case '\'':
-                os.write("&apos;", 6);
-                break;
-            case '\"':
-                os.write("&quot;", 6);
-                break;
-            default:
-                goto unescaped;
-            }
-            ++pos;
+        case '<':
+            os.write("&lt;", 4);
+            break;
+        case '>':
+            os.write("&gt;", 4);
+            break;
+        case '&':
+            os.write("&amp;", 5);
+            break;
+        case '\'':
+            os.write("&apos;", 6);
+            break;
+        case '\"':
+            os.write("&quot;", 6);
+            break;
         }
+        p += i + 1;
+        n -= i + 1;
     }
 }
 
@@ -121,10 +217,22 @@ operator<<(
     Attributes const& attrs)
 {
     for(auto const& attr : attrs.attrs_)
-        if(attr.pred)
-            os <<
-                ' ' << attr.name << '=' <<
-                "\"" << xmlEscape(attr.value) << "\"";
+    {
+        if(! attr.pred)
+            continue;
+        os << ' ' << attr.name << "=\"";
+        if(attr.id != SymbolID::zero)
+        {
+            // base64 needs no escaping
+            char buf[toBase64Size(SymbolID::zero.size())];
+            os << toBase64(buf, attr.id);
+        }
+        else
+        {
+            os << xmlEscape(attr.value);
+        }
+        os << '"';
+    }
     return os;
 }
 
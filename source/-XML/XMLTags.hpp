@@ -77,6 +77,10 @@ struct Attribute
     dom::String value;
     bool pred;
 
+    // written in place of the value, so
+    // that the encoding is not allocated
+    SymbolID id = SymbolID::zero;
+
     Attribute(
         dom::String name_,
         dom::String value_,
@@ -88,10 +92,10 @@ struct Attribute
     }
 
     Attribute(
-        SymbolID id)
+        SymbolID id_)
         : name("id")
-        , value(toString(id))
-        , pred(id != SymbolID::zero)
+        , pred(id_ != SymbolID::zero)
+        , id(id_)
     {
     }
 
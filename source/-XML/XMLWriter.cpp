@@ -13,6 +13,8 @@
 #include "XMLWriter.hpp"
 #include "Tool/ConfigImpl.hpp"
 #include "CXXTags.hpp"
+#include "Support/PageWriter.hpp"
+#include "Support/PhaseReport.hpp"
 #include "Support/Radix.hpp"
 #include "Support/SafeNames.hpp"
 #include <mrdox/Platform.hpp>
@@ -106,6 +108,31 @@ namespace xml {
 //
 //------------------------------------------------
 
+/** Output in which the output of other tasks is spliced.
+*/
+struct XMLWriter::Part
+{
+    std::string text;
+
+    // the offsets in text at which each
+    // part is written, in ascending order
+    std::vector<std::pair<
+        std::size_t, std::unique_ptr<Part>>> parts;
+
+    void
+    write(llvm::raw_ostream& os) const
+    {
+        std::size_t pos = 0;
+        for(auto const& [offset, part] : parts)
+        {
+            os << llvm::StringRef(text).slice(pos, offset);
+            part->write(os);
+            pos = offset;
+        }
+        os << llvm::StringRef(text).substr(pos);
+    }
+};
+
 XMLWriter::
 XMLWriter(
     llvm::raw_ostream& os,
@@ -116,9 +143,27 @@ XMLWriter(
 {
 }
 
+XMLWriter::
+XMLWriter(
+    llvm::raw_ostream& os,
+    Corpus const& corpus,
+    Options const& options,
+    std::string const& indent,
+    TaskGroup& taskGroup,
+    Part& part)
+    : tags_(os)
+    , os_(os)
+    , corpus_(corpus)
+    , options_(options)
+    , taskGroup_(&taskGroup)
+    , part_(&part)
+{
+    tags_.indent_ = indent;
+}
+
 Error
 XMLWriter::
-build()
+loadOptions()
 {
     {
         llvm::yaml::Input yin(
@@ -138,6 +183,15 @@ build()
         if(auto ec = yin.error())
             return Error(ec);
     }
+    return Error::success();
+}
+
+Error
+XMLWriter::
+build()
+{
+    if(auto err = loadOptions())
+        return err;
 
     if(options_.prolog)
         os_ <<
@@ -148,7 +202,15 @@ build()
     if(options_.index || options_.safe_names)
         writeIndex();
 
-    visit(corpus_.globalNamespace(), *this);
+    if(corpus_.config.threadPool().getThreadCount() > 1)
+    {
+        if(auto err = buildConcurrently())
+            return err;
+    }
+    else
+    {
+        visit(corpus_.globalNamespace(), *this);
+    }
 
     if(options_.prolog)
         os_ << "</mrdox>\n";
@@ -156,14 +218,201 @@ build()
     return {};
 }
 
+Error
+XMLWriter::
+buildPages(
+    std::string_view outputPath,
+    Corpus const& corpus)
+{
+    // namespaces and records, in document order
+    std::vector<Info const*> pages;
+    auto const list = [&](auto const& self, Info const& I) -> void
+    {
+        if(! corpus.hasSelected(I))
+            return;
+        if(corpus.isSelected(I))
+            pages.push_back(&I);
+        visit(I, [&]<class T>(T const& J)
+        {
+            if constexpr(
+                T::isNamespace() ||
+                T::isRecord())
+                corpus.traverse(J,
+                    [&]<class U>(U const& K)
+                    {
+                        if constexpr(
+                            U::isNamespace() ||
+                            U::isRecord())
+                            self(self, K);
+                    });
+        });
+    };
+    list(list, corpus.globalNamespace());
+
+    std::string indexText;
+    llvm::raw_string_ostream os(indexText);
+    XMLWriter index(os, corpus);
+    if(auto err = index.loadOptions())
+        return err;
+    auto const& options = index.options_;
+
+    ScopedPhase phase("render");
+    PageWriter writer(outputPath, corpus.config);
+    if(corpus.config.progress)
+        writer.showProgress(pages.size());
+    auto errors = corpus.config.threadPool().forEach(pages,
+        [&](Info const* I)
+        {
+            std::string pageText;
+            llvm::raw_string_ostream os(pageText);
+            XMLWriter page(os, corpus);
+            page.options_ = options;
+            page.pages_ = true;
+            if(options.prolog)
+                os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+            visit(*I, page);
+            char hex[40];
+            writer.write(pageFileName(toBase16(hex, I->id), "xml",
+                corpus.config.shardDepth), std::move(pageText));
+        });
+
+    if(options.prolog)
+        os <<
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" <<
+            "<mrdox>\n";
+    index.tags_.open("pages");
+    for(Info const* I : pages)
+        index.writePageRef(*I);
+    index.tags_.close("pages");
+    if(options.index || options.safe_names)
+        index.writeIndex();
+    if(options.prolog)
+        os << "</mrdox>\n";
+    writer.write("index.xml", std::move(indexText));
+
+    setPhaseUnits("render", writer.filesQueued(), "page");
+    for(auto& err : writer.finish())
+        errors.push_back(std::move(err));
+    if(! errors.empty())
+        return Error(errors);
+    return Error::success();
+}
+
+void
+XMLWriter::
+writePageRef(
+    Info const& I)
+{
+    char hex[40];
+    tags_.write("page", {}, {
+        { "name", corpus_.qualifiedName(I), ! I.Name.empty() },
+        { I.id },
+        { "href", pageFileName(toBase16(hex, I.id), "xml",
+            corpus_.config.shardDepth) } });
+}
+
+Error
+XMLWriter::
+buildConcurrently()
+{
+    TaskGroup taskGroup(corpus_.config.threadPool());
+    Part root;
+    {
+        llvm::raw_string_ostream os(root.text);
+        XMLWriter writer(os, corpus_,
+            options_, tags_.indent_, taskGroup, root);
+        visit(corpus_.globalNamespace(), writer);
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Error(errors);
+    root.write(os_);
+    return {};
+}
+
+// Write the members of a namespace or record,
+// giving each large subtree to its own task.
+template<class T>
+void
+XMLWriter::
+writeMembers(
+    T const& I)
+{
+    // the least number of children of
+    // a subtree written by its own task
+    constexpr std::size_t grain = 32;
+
+    // the scopes which only contain selected
+    // symbols are written, so the tree is whole
+    if(pages_)
+    {
+        corpus_.traverse(I,
+            [&]<class U>(U const& J)
+            {
+                if(! corpus_.isSelected(J))
+                    return;
+                if constexpr(
+                    U::isNamespace() ||
+                    U::isRecord())
+                    writePageRef(J);
+                else
+                    (*this)(J);
+            });
+        return;
+    }
+    if(! taskGroup_)
+    {
+        corpus_.traverse(I,
+            [&]<class U>(U const& J)
+            {
+                if(corpus_.hasSelected(J))
+                    (*this)(J);
+            });
+        return;
+    }
+    corpus_.traverse(I,
+        [&]<class U>(U const& J)
+        {
+            if(! corpus_.hasSelected(J))
+                return;
+            if constexpr(
+                U::isNamespace() ||
+                U::isRecord())
+            {
+                if(J.Members.size() + J.Specializations.size() >= grain)
+                {
+                    os_.flush();
+                    auto& part = *part_->parts.emplace_back(
+                        part_->text.size(),
+                        std::make_unique<Part>()).second;
+                    // this writer can be gone when the task runs
+                    taskGroup_->async(
+                        [
+                            &corpus = corpus_,
+                            &taskGroup = *taskGroup_,
+                            options = options_,
+                            indent = tags_.indent_,
+                            &J, &part
+                        ]
+                        {
+                            llvm::raw_string_ostream os(part.text);
+                            XMLWriter writer(os, corpus,
+                                options, indent, taskGroup, part);
+                            writer(J);
+                        });
+                    return;
+                }
+            }
+            (*this)(J);
+        });
+}
+
 //------------------------------------------------
 
 void
 XMLWriter::
 writeIndex()
 {
-    std::string temp;
-    temp.reserve(256);
     tags_.open("symbols");
     if(options_.safe_names)
     {
@@ -173,7 +422,7 @@ writeIndex()
             auto safe_name = names.get(I->id);
             tags_.write("symbol", {}, {
                 { "safe", safe_name },
-                { "name", corpus_.getFullyQualifiedName(*I, temp) },
+                { "name", corpus_.qualifiedName(*I) },
                 { "tag", getTagName(*I) },
                 { I->id } });
         }
@@ -182,7 +431,7 @@ writeIndex()
     {
         for(auto I : corpus_.index())
             tags_.write("symbol", {}, {
-                { "name", corpus_.getFullyQualifiedName(*I, temp) },
+                { "name", corpus_.qualifiedName(*I) },
                 { "tag", getTagName(*I) },
                 { I->id } });
     }
@@ -206,7 +455,7 @@ operator()(
             { "is-inline", "1", I.specs.isInline}
             });
         writeJavadoc(I.javadoc);
-        corpus_.traverse(I, *this);
+        writeMembers(I);
         tags_.close(namespaceTagName);
     }
     if constexpr(T::isRecord())
@@ -251,7 +500,7 @@ writeEnum(
     {
         std::string val = V.Initializer.Value ?
             std::to_string(*V.Initializer.Value) :
-            V.Initializer.Written;
+            std::string(V.Initializer.Written.str());
         if(! V.javadoc)
         {
             tags_.write("value", {}, {
@@ -342,7 +591,7 @@ writeRecord(
 
     writeJavadoc(I.javadoc);
 
-    corpus_.traverse(I, *this);
+    writeMembers(I);
 
     tags_.close(tagName);
 
@@ -390,7 +639,7 @@ writeField(
         tag_name = bitfieldTagName;
         bit_width = I.BitfieldWidth.Value ?
             std::to_string(*I.BitfieldWidth.Value) :
-            I.BitfieldWidth.Written;
+            std::string(I.BitfieldWidth.Written.str());
     }
 
     tags_.open(tag_name, {
@@ -463,7 +712,7 @@ writeLocation(
     bool def)
 {
     tags_.write("file", {}, {
-        { "path", loc.Filename },
+        { "path", loc.filename() },
         { "line", std::to_string(loc.LineNumber) },
         { "class", "def", def } });
 }
@@ -530,65 +779,66 @@ writeJavadoc(
 {
     if(! javadoc)
         return;
+    // the corpus builds the pools when it is finalized
+    MRDOX_ASSERT(javadoc->empty() || ! javadoc->pool().empty());
+    pool_ = &javadoc->pool();
     tags_.open(javadocTagName);
-    writeNodes(javadoc->getBlocks());
+    writeNodes(pool_->blocks());
     tags_.close(javadocTagName);
+    pool_ = nullptr;
 }
 
-template<class T>
 void
 XMLWriter::
 writeNodes(
-    doc::List<T> const& list)
+    std::span<doc::NodePool::Node const> list)
 {
-    if(list.empty())
-        return;
     for(auto const& node : list)
-        writeNode(*node);
+        writeNode(node);
 }
 
 void
 XMLWriter::
 writeNode(
-    doc::Node const& node)
+    doc::NodePool::Node const& node)
 {
     switch(node.kind)
     {
     case doc::Kind::text:
-        writeText(static_cast<doc::Text const&>(node));
+        writeText(node);
         break;
     case doc::Kind::styled:
-        writeStyledText(static_cast<doc::Styled const&>(node));
+        writeStyledText(node);
         break;
     case doc::Kind::heading:
-        writeHeading(static_cast<doc::Heading const&>(node));
+        writeHeading(node);
         break;
     case doc::Kind::paragraph:
-        writeParagraph(static_cast<doc::Paragraph const&>(node));
+        writeParagraph(node);
         break;
     case doc::Kind::link:
-        writeLink(static_cast<doc::Link const&>(node));
+        writeLink(node);
         break;
     case doc::Kind::list_item:
-        writeListItem(static_cast<doc::ListItem const&>(node));
+        writeListItem(node);
         break;
     case doc::Kind::brief:
-        writeBrief(static_cast<doc::Brief const&>(node));
+        writeBrief(node);
         break;
     case doc::Kind::admonition:
-        writeAdmonition(static_cast<doc::Admonition const&>(node));
+        writeAdmonition(node);
         break;
     case doc::Kind::code:
-        writeCode(static_cast<doc::Code const&>(node));
+        writeCode(node);
         break;
     case doc::Kind::param:
-        writeJParam(static_cast<doc::Param const&>(node));
+        writeJParam(node);
         break;
     case doc::Kind::tparam:
-        writeTParam(static_cast<doc::TParam const&>(node));
+        writeTParam(node);
         break;
     case doc::Kind::returns:
-        writeReturns(static_cast<doc::Returns const&>(node));
+        writeReturns(node);
         break;
     default:
         // unknown kind
@@ -599,79 +849,79 @@ writeNode(
 void
 XMLWriter::
 writeLink(
-    doc::Link const& node)
+    doc::NodePool::Node const& node)
 {
-    tags_.write("link", node.string, {
-        { "href", node.href }
+    tags_.write("link", pool_->string(node), {
+        { "href", pool_->href(node) }
         });
 }
 
 void
 XMLWriter::
 writeListItem(
-    doc::ListItem const& node)
+    doc::NodePool::Node const& node)
 {
     tags_.open("item");
-    writeNodes(node.children);
+    writeNodes(pool_->children(node));
     tags_.close("item");
 }
 
 void
 XMLWriter::
 writeBrief(
-    doc::Paragraph const& node)
+    doc::NodePool::Node const& node)
 {
     tags_.open("brief");
-    writeNodes(node.children);
+    writeNodes(pool_->children(node));
     tags_.close("brief");
 }
 
 void
 XMLWriter::
 writeText(
-    doc::Text const& node)
+    doc::NodePool::Node const& node)
 {
     tags_.indent() <<
         "<text>" <<
-        xmlEscape(node.string) <<
+        xmlEscape(pool_->string(node)) <<
         "</text>\n";
 }
 
 void
 XMLWriter::
 writeStyledText(
-    doc::Styled const& node)
+    doc::NodePool::Node const& node)
 {
-    tags_.write(toString(node.style), node.string);
+    tags_.write(toString(pool_->style(node)), pool_->string(node));
 }
 
 void
 XMLWriter::
 writeHeading(
-    doc::Heading const& heading)
+    doc::NodePool::Node const& heading)
 {
-    tags_.write("head", heading.string);
+    tags_.write("head", pool_->string(heading));
 }
 
 void
 XMLWriter::
 writeParagraph(
-    doc::Paragraph const& para,
+    doc::NodePool::Node const& para,
     llvm::StringRef tag)
 {
     tags_.open("para", {
         { "class", tag, ! tag.empty() }});
-    writeNodes(para.children);
+    writeNodes(pool_->children(para));
     tags_.close("para");
 }
 
 void
 XMLWriter::
 writeAdmonition(
-    doc::Admonition const& admonition)
+    doc::NodePool::Node const& admonition)
 {
     llvm::StringRef tag;
-    switch(admonition.admonish)
+    switch(pool_->admonish(admonition))
     {
     case doc::Admonish::note:
         tag = "note";
@@ -697,38 +947,39 @@ writeAdmonition(
 
 void
 XMLWriter::
-writeCode(doc::Code const& code)
+writeCode(
+    doc::NodePool::Node const& code)
 {
-    if(code.children.empty())
+    if(code.count == 0)
     {
         tags_.indent() << "<code/>\n";
         return;
     }
 
     tags_.open("code");
-    writeNodes(code.children);
+    writeNodes(pool_->children(code));
     tags_.close("code");
 }
 
 void
 XMLWriter::
 writeReturns(
-    doc::Returns const& returns)
+    doc::NodePool::Node const& returns)
 {
-    if(returns.empty())
+    if(returns.count == 0)
         return;
     tags_.open("returns");
-    writeNodes(returns.children);
+    writeNodes(pool_->children(returns));
     tags_.close("returns");
 }
 
 void
 XMLWriter::
 writeJParam(
-    doc::Param const& param)
+    doc::NodePool::Node const& param)
 {
     dom::String direction;
-    switch(param.direction)
+    switch(pool_->direction(param))
     {
     case doc::ParamDirection::none:
         direction = "";
@@ -745,22 +996,24 @@ writeJParam(
     default:
         MRDOX_UNREACHABLE();
     }
+    auto const name = pool_->name(param);
     tags_.open("param", {
-        { "name", param.name, ! param.name.empty() },
+        { "name", name, ! name.empty() },
         { "class", direction, ! direction.empty() }
     });
-    writeNodes(param.children);
+    writeNodes(pool_->children(param));
     tags_.close("param");
 }
 
 void
 XMLWriter::
 writeTParam(
-    doc::TParam const& tparam)
+    doc::NodePool::Node const& tparam)
 {
+    auto const name = pool_->name(tparam);
     tags_.open("tparam", {
-        { "name", tparam.name, ! tparam.name.empty() }});
-    writeNodes(tparam.children);
+        { "name", name, ! name.empty() }});
+    writeNodes(pool_->children(tparam));
     tags_.close("tparam");
 }
 
@@ -17,6 +17,7 @@
 #include <mrdox/Corpus.hpp>
 #include <mrdox/Metadata.hpp>
 #include <mrdox/Support/Error.hpp>
+#include <span>
 #include <string>
 
 namespace clang {
@@ -26,6 +27,19 @@ namespace xml {
 class jit_indenter;
 
 /** A writer which outputs XML.
+
+    When the thread pool has more than one
+    thread, large namespace and record subtrees
+    are written into separate buffers by tasks
+    on the pool, and the buffers are spliced
+    together in document order. The output is
+    the same as that of the serial writer.
+
+    For multi-page output, each namespace and
+    record is written to its own file, where
+    its namespace and record members are
+    replaced by `page` elements naming their
+    files.
 */
 class XMLWriter
 {
@@ -47,6 +61,26 @@ protected:
     };
     Options options_;
 
+    struct Part;
+    TaskGroup* taskGroup_ = nullptr;
+    Part* part_ = nullptr;
+    bool pages_ = false;
+
+    XMLWriter(
+        llvm::raw_ostream& os,
+        Corpus const& corpus,
+        Options const& options,
+        std::string const& indent,
+        TaskGroup& taskGroup,
+        Part& part);
+
+    Error loadOptions();
+    Error buildConcurrently();
+    void writePageRef(Info const& I);
+
+    template<class T>
+    void writeMembers(T const& I);
+
 public:
     XMLWriter(
         llvm::raw_ostream& os,
@@ -54,6 +88,18 @@ public:
 
     Error build();
 
+    /** Write one file for each namespace and record, and an index.
+
+        The index, `index.xml`, lists the files
+        with their symbols. The paths of files
+        are relative to the output directory.
+    */
+    static
+    Error
+    buildPages(
+        std::string_view outputPath,
+        Corpus const& corpus);
+
     void writeIndex();
 
     template<class T>
@@ -73,24 +119,27 @@ public:
     void openTemplate(const std::unique_ptr<TemplateInfo>& I);
     void closeTemplate(const std::unique_ptr<TemplateInfo>& I);
 
-    // void writeType(std::unique_ptr<TypeInfo> const& type);
-
-    template<class T>
-    void writeNodes(doc::List<T> const& list);
-    void writeNode(doc::Node const& node);
-
-    void writeAdmonition(doc::Admonition const& node);
-    void writeBrief(doc::Paragraph const& node);
-    void writeCode(doc::Code const& node);
-    void writeHeading(doc::Heading const& node);
-    void writeLink(doc::Link const& node);
-    void writeListItem(doc::ListItem const& node);
-    void writeParagraph(doc::Paragraph const& node, llvm::StringRef tag = "");
-    void writeJParam(doc::Param const& node);
-    void writeReturns(doc::Returns const& node);
-    void writeStyledText(doc::Styled const& node);
-    void writeText(doc::Text const& node);
-    void writeTParam(doc::TParam const& node);
+    // void writeType(std::shared_ptr<TypeInfo> const& type);
+
+    void writeNodes(std::span<doc::NodePool::Node const> list);
+    void writeNode(doc::NodePool::Node const& node);
+
+    void writeAdmonition(doc::NodePool::Node const& node);
+    void writeBrief(doc::NodePool::Node const& node);
+    void writeCode(doc::NodePool::Node const& node);
+    void writeHeading(doc::NodePool::Node const& node);
+    void writeLink(doc::NodePool::Node const& node);
+    void writeListItem(doc::NodePool::Node const& node);
+    void writeParagraph(doc::NodePool::Node const& node, llvm::StringRef tag = "");
+    void writeJParam(doc::NodePool::Node const& node);
+    void writeReturns(doc::NodePool::Node const& node);
+    void writeStyledText(doc::NodePool::Node const& node);
+    void writeText(doc::NodePool::Node const& node);
+    void writeTParam(doc::NodePool::Node const& node);
+
+private:
+    // the pool of the javadoc being written
+    doc::NodePool const* pool_ = nullptr;
 };
 
 } // xml
@@ -10,10 +10,14 @@
 //
 
 #include "AdocCorpus.hpp"
-#include <mrdox/Support/RangeFor.hpp>
 #include <mrdox/Support/String.hpp>
 #include <fmt/format.h>
+#include <llvm/ADT/DenseMap.h>
+#include <array>
+#include <cstdint>
 #include <iterator>
+#include <mutex>
+#include <span>
 
 namespace clang {
 namespace mrdox {
@@ -23,32 +27,37 @@ namespace {
 
 class DocVisitor
 {
+    using Node = doc::NodePool::Node;
+
+    doc::NodePool const& pool_;
     std::string& dest_;
     std::back_insert_iterator<std::string> ins_;
 
 public:
-    explicit DocVisitor(std::string& dest) noexcept;
-
-    void operator()(doc::Admonition const& I);
-    void operator()(doc::Code const& I);
-    void operator()(doc::Heading const& I);
-    void operator()(doc::Paragraph const& I);
-    void operator()(doc::Link const& I);
-    void operator()(doc::ListItem const& I);
-    void operator()(doc::Param const& I);
-    void operator()(doc::Returns const& I);
-    void operator()(doc::Text const& I);
-    void operator()(doc::Styled const& I);
-    void operator()(doc::TParam const& I);
+    DocVisitor(
+        doc::NodePool const& pool,
+        std::string& dest) noexcept;
+
+    void operator()(Node const& I);
+
+    void visitCode(Node const& I);
+    void visitHeading(Node const& I);
+    void visitParagraph(Node const& I);
+    void visitLink(Node const& I);
+    void visitListItem(Node const& I);
+    void visitText(Node const& I);
+    void visitStyled(Node const& I);
 
     std::size_t measureLeftMargin(
-        doc::List<doc::Text> const& list);
+        std::span<Node const> list);
 };
 
 DocVisitor::
 DocVisitor(
+    doc::NodePool const& pool,
     std::string& dest) noexcept
-    : dest_(dest)
+    : pool_(pool)
+    , dest_(dest)
     , ins_(std::back_inserter(dest_))
 {
 }
@@ -56,64 +65,82 @@ DocVisitor(
 void
 DocVisitor::
 operator()(
-    doc::Admonition const& I)
+    Node const& I)
 {
-    //dest_ += I.string;
+    switch(I.kind)
+    {
+    case doc::Kind::code:
+        return visitCode(I);
+    case doc::Kind::heading:
+        return visitHeading(I);
+    case doc::Kind::brief:
+    case doc::Kind::paragraph:
+        return visitParagraph(I);
+    case doc::Kind::link:
+        return visitLink(I);
+    case doc::Kind::list_item:
+        return visitListItem(I);
+    case doc::Kind::text:
+        return visitText(I);
+    case doc::Kind::styled:
+        return visitStyled(I);
+    case doc::Kind::admonition:
+    case doc::Kind::param:
+    case doc::Kind::returns:
+    case doc::Kind::tparam:
+        //dest_ += I.string;
+        return;
+    default:
+        MRDOX_UNREACHABLE();
+    }
 }
 
 void
 DocVisitor::
-operator()(
-    doc::Code const& I)
+visitCode(
+    Node const& I)
 {
-    auto const leftMargin = measureLeftMargin(I.children);
+    auto const children = pool_.children(I);
+    auto const leftMargin = measureLeftMargin(children);
     dest_ +=
         "[,cpp]\n"
         "----\n";
-    for(auto const& it : RangeFor(I.children))
+    for(auto const& text : children)
     {
-        doc::visit(*it.value,
-            [&]<class T>(T const& text)
-            {
-                if constexpr(std::is_same_v<T, doc::Text>)
-                {
-                    if(! text.string.empty())
-                    {
-                        std::string_view s = text.string;
-                        s.remove_prefix(leftMargin);
-                        dest_.append(s);
-                    }
-                    dest_.push_back('\n');
-                }
-                else
-                {
-                    MRDOX_UNREACHABLE();
-                }
-            });
+        if(text.kind != doc::Kind::text)
+            MRDOX_UNREACHABLE();
+        std::string_view s = pool_.string(text);
+        if(! s.empty())
+        {
+            s.remove_prefix(leftMargin);
+            dest_.append(s);
+        }
+        dest_.push_back('\n');
     }
     dest_ += "----\n";
 }
 
 void
 DocVisitor::
-operator()(
-    doc::Heading const& I)
+visitHeading(
+    Node const& I)
 {
-    fmt::format_to(ins_, "=== {}\n", I.string);
+    fmt::format_to(ins_, "=== {}\n", pool_.string(I));
 }
 
 // Also handles doc::Brief
 void
 DocVisitor::
-operator()(
-    doc::Paragraph const& I)
+visitParagraph(
+    Node const& I)
 {
-    for(auto const& it : RangeFor(I.children))
+    auto const children = pool_.children(I);
+    for(std::size_t i = 0; i < children.size(); ++i)
     {
         auto const n = dest_.size();
-        doc::visit(*it.value, *this);
+        (*this)(children[i]);
         // detect empty text blocks
-        if(! it.last && dest_.size() > n)
+        if(i + 1 < children.size() && dest_.size() > n)
         {
             // wrap past 80 cols
             if(dest_.size() < 80)
@@ -127,28 +154,29 @@ operator()(
 
 void
 DocVisitor::
-operator()(
-    doc::Link const& I)
+visitLink(
+    Node const& I)
 {
     dest_.append("link:");
-    dest_.append(I.href);
+    dest_.append(pool_.href(I));
     dest_.push_back('[');
-    dest_.append(I.string);
+    dest_.append(pool_.string(I));
     dest_.push_back(']');
 }
 
 void
 DocVisitor::
-operator()(
-    doc::ListItem const& I)
+visitListItem(
+    Node const& I)
 {
     dest_.append("* ");
-    for(auto const& it : RangeFor(I.children))
+    auto const children = pool_.children(I);
+    for(std::size_t i = 0; i < children.size(); ++i)
     {
         auto const n = dest_.size();
-        doc::visit(*it.value, *this);
+        (*this)(children[i]);
         // detect empty text blocks
-        if(! it.last && dest_.size() > n)
+        if(i + 1 < children.size() && dest_.size() > n)
         {
             // wrap past 80 cols
             if(dest_.size() < 80)
@@ -162,36 +190,24 @@ operator()(
 
 void
 DocVisitor::
-operator()(doc::Param const& I)
-{
-    //dest_ += I.string;
-}
-
-void
-DocVisitor::
-operator()(doc::Returns const& I)
-{
-    //dest_ += I.string;
-}
-
-void
-DocVisitor::
-operator()(doc::Text const& I)
+visitText(
+    Node const& I)
 {
     // Asciidoc text must not have leading 
     // else they can be rendered up as code.
-    std::string_view s = trim(I.string);
+    std::string_view s = trim(pool_.string(I));
     dest_.append(s);
 }
 
 void
 DocVisitor::
-operator()(doc::Styled const& I)
+visitStyled(
+    Node const& I)
 {
     // VFALCO We need to apply Asciidoc escaping
     // depending on the contents of the string.
-    std::string_view s = trim(I.string);
-    switch(I.style)
+    std::string_view s = trim(pool_.string(I));
+    switch(pool_.style(I))
     {
     case doc::Style::none:
         dest_.append(s);
@@ -210,27 +226,20 @@ operator()(doc::Styled const& I)
     }
 }
 
-void
-DocVisitor::
-operator()(doc::TParam const& I)
-{
-    //dest_ += I.string;
-}
-
 std::size_t
 DocVisitor::
 measureLeftMargin(
-    doc::List<doc::Text> const& list)
+    std::span<Node const> list)
 {
     if(list.empty())
         return 0;
     std::size_t n = std::size_t(-1);
-    for(auto& text : list)
+    for(auto const& text : list)
     {
-        if(trim(text->string).empty())
+        std::string_view const s = pool_.string(text);
+        if(trim(s).empty())
             continue;
-        auto const space =
-            text->string.size() - ltrim(text->string).size();
+        auto const space = s.size() - ltrim(s).size();
         if( n > space)
             n = space;
     }
@@ -239,75 +248,131 @@ measureLeftMargin(
 
 //------------------------------------------------
 
+dom::String
+renderNodes(
+    doc::NodePool const& pool,
+    std::span<doc::NodePool::Node const* const> nodes)
+{
+    std::string s;
+    DocVisitor visitor(pool, s);
+    for(auto const& t : nodes)
+        visitor(*t);
+    return dom::String(s);
+}
+
 class DomJavadoc : public dom::LazyObjectImpl
 {
-    Javadoc const& jd_;
+    AdocJavadoc const& jd_;
 
 public:
     DomJavadoc(
-        Javadoc const& jd) noexcept
+        AdocJavadoc const& jd) noexcept
         : jd_(jd)
     {
     }
 
-    template<std::derived_from<doc::Node> T>
-    void
-    maybeEmplace(
-        storage_type& list,
-        std::string_view key,
-        T const& I) const
-    {
-        std::string s;
-        DocVisitor visitor(s);
-        doc::visit(I, visitor);
-        if(! s.empty())
-            list.emplace_back(key, std::move(s));
-    };
-
-    template<class T>
+    static
     void
     maybeEmplace(
         storage_type& list,
         std::string_view key,
-        std::vector<T const*> const& nodes) const
+        dom::String const& s)
     {
-        std::string s;
-        DocVisitor visitor(s);
-        for(auto const& t : nodes)
-            doc::visit(*t, visitor);
         if(! s.empty())
-            list.emplace_back(key, std::move(s));
-    };
+            list.emplace_back(key, s);
+    }
 
     dom::Object
     construct() const override
     {
         storage_type list;
         list.reserve(2);
+        maybeEmplace(list, "brief", jd_.brief);
+        maybeEmplace(list, "description", jd_.description);
+        maybeEmplace(list, "returns", jd_.returns);
+        maybeEmplace(list, "params", jd_.params);
+        maybeEmplace(list, "tparams", jd_.tparams);
+        return dom::Object(std::move(list));
+    }
+};
+
+} // (anon)
+
+//------------------------------------------------
+
+// The cache is split by the address of the
+// javadoc so that builder threads rarely
+// wait on the same lock.
+class AdocCorpus::Cache
+{
+    static constexpr std::size_t NumShards = 64;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::DenseMap<Javadoc const*,
+            std::unique_ptr<AdocJavadoc>> map;
+    };
 
-        auto ov = jd_.makeOverview();
+    std::array<Shard, NumShards> shards_;
 
-        // brief
+public:
+    AdocJavadoc const&
+    get(Javadoc const& jd)
+    {
+        Shard& shard = shards_[
+            (reinterpret_cast<std::uintptr_t>(&jd) >> 4) % NumShards];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(&jd);
+            if(it != shard.map.end())
+                return *it->second;
+        }
+
+        // render without the lock, a racing
+        // thread may render the same javadoc
+        auto r = std::make_unique<AdocJavadoc>();
+        auto const& pool = jd.pool();
+        auto const& ov = pool.overview();
         if(ov.brief)
-            maybeEmplace(list, "brief", *ov.brief);
-        maybeEmplace(list, "description", ov.blocks);
+            r->brief = renderNodes(pool, { &ov.brief, 1 });
+        r->description = renderNodes(pool, ov.blocks);
         if(ov.returns)
-            maybeEmplace(list, "returns", *ov.returns);
-        maybeEmplace(list, "params", ov.params);
-        maybeEmplace(list, "tparams", ov.tparams);
+            r->returns = renderNodes(pool, { &ov.returns, 1 });
+        r->params = renderNodes(pool, ov.params);
+        r->tparams = renderNodes(pool, ov.tparams);
 
-        return dom::Object(std::move(list));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.map.try_emplace(&jd, std::move(r));
+        return *it->second;
     }
 };
 
-} // (anon)
+AdocCorpus::
+AdocCorpus(
+    Corpus const& corpus)
+    : DomCorpus(corpus)
+    , cache_(std::make_unique<Cache>())
+{
+}
+
+AdocCorpus::
+~AdocCorpus() = default;
+
+AdocJavadoc const&
+AdocCorpus::
+render(
+    Javadoc const& jd) const
+{
+    return cache_->get(jd);
+}
 
 dom::Value
 AdocCorpus::
 getJavadoc(
     Javadoc const& jd) const
 {
-    return dom::newObject<DomJavadoc>(jd);
+    return dom::newObject<DomJavadoc>(render(jd));
 }
 
 } // adoc
@@ -13,20 +13,47 @@
 
 #include <mrdox/Platform.hpp>
 #include <mrdox/Metadata/DomMetadata.hpp>
+#include <memory>
 
 namespace clang {
 namespace mrdox {
 namespace adoc {
 
+/** The documentation of a symbol, rendered to Asciidoc.
+
+    Each part is empty when the symbol has none.
+*/
+struct AdocJavadoc
+{
+    dom::String brief;
+    dom::String description;
+    dom::String returns;
+    dom::String params;
+    dom::String tparams;
+};
+
 class AdocCorpus : public DomCorpus
 {
+    class Cache;
+
+    std::unique_ptr<Cache> cache_;
+
 public:
     explicit
     AdocCorpus(
-        Corpus const& corpus)
-        : DomCorpus(corpus)
-    {
-    }
+        Corpus const& corpus);
+
+    ~AdocCorpus();
+
+    /** Return the documentation rendered to Asciidoc.
+
+        The documentation is rendered the first
+        time it is requested, and the strings are
+        shared by every object built from it.
+    */
+    AdocJavadoc const&
+    render(
+        Javadoc const& jd) const;
 
     dom::Value
     getJavadoc(
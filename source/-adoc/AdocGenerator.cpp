@@ -14,10 +14,15 @@
 #include "Builder.hpp"
 #include "MultiPageVisitor.hpp"
 #include "SinglePageVisitor.hpp"
+#include "Support/PhaseReport.hpp"
 #include "Support/SafeNames.hpp"
 #include <mrdox/Metadata/DomMetadata.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/Path.hpp>
+#include <mrdox/Version.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/raw_os_ostream.h>
+#include <llvm/Support/xxhash.h>
 #include <optional>
 #include <vector>
 
@@ -27,20 +32,18 @@ namespace adoc {
 
 Expected<ExecutorGroup<Builder>>
 createExecutors(
-    DomCorpus const& domCorpus)
+    DomCorpus const& domCorpus,
+    Options const& options)
 {
-    auto options = loadOptions(domCorpus.corpus);
-    if(! options)
-        return options.error();
-
     auto const& config = domCorpus.corpus.config;
     auto& threadPool = config.threadPool();
+    auto addons = std::make_shared<AddonCache>(config, options);
     ExecutorGroup<Builder> group(threadPool);
     for(auto i = threadPool.getThreadCount(); i--;)
     {
         try
         {
-           group.emplace(domCorpus, *options);
+           group.emplace(domCorpus, options, addons);
         }
         catch(Exception const& ex)
         {
@@ -50,6 +53,27 @@ createExecutors(
     return group;
 }
 
+/** Return a hash of what every page depends on, besides its symbols.
+
+    This is the version of the tool, the
+    configuration, the addons and the set of
+    symbols, which decides the links.
+*/
+static
+std::uint64_t
+hashPageInputs(
+    Corpus const& corpus)
+{
+    auto const& config = corpus.config;
+    std::string text(project_version);
+    text.append(config.configYaml);
+    text.append(config.extraYaml);
+    text.append(llvm::utohexstr(AddonCache::hashFiles(config)));
+    for(Info const* I : corpus.index())
+        text.append(llvm::StringRef(I->id));
+    return llvm::xxHash64(text);
+}
+
 //------------------------------------------------
 //
 // AdocGenerator
@@ -65,14 +89,38 @@ build(
     if(! corpus.config.multiPage)
         return Generator::build(outputPath, corpus);
 
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
     AdocCorpus domCorpus(corpus);
-    auto ex = createExecutors(domCorpus);
+    if(corpus.config.domPrebuild)
+        if(auto err = domCorpus.prebuild())
+            return err;
+    auto ex = createExecutors(domCorpus, *options);
     if(! ex)
         return ex.error();
 
-    MultiPageVisitor visitor(*ex, outputPath, corpus);
+    // incremental output only renders the
+    // pages whose symbols changed
+    std::optional<PageDependencies> deps;
+    if(corpus.config.incrementalOutput)
+        deps.emplace(outputPath, hashPageInputs(corpus));
+
+    ScopedPhase phase("render");
+    PageWriter writer(outputPath, corpus.config);
+    if(corpus.config.progress)
+        writer.showProgress(0);
+    MultiPageVisitor visitor(*ex, writer, domCorpus,
+        options->chunk_cost, deps ? &*deps : nullptr);
     visitor(corpus.globalNamespace());
+    visitor.renderPages();
     auto errors = ex->wait();
+    setPhaseUnits("render", writer.filesQueued(), "page");
+    for(auto& err : writer.finish())
+        errors.push_back(std::move(err));
+    if(deps)
+        if(auto err = deps->save())
+            errors.push_back(std::move(err));
     if(! errors.empty())
         return Error(errors);
     return Error::success();
@@ -84,39 +132,39 @@ buildOne(
     std::ostream& os,
     Corpus const& corpus) const
 {
+    // every page is written through this
+    // buffer, in the order of the pages
+    llvm::raw_os_ostream out(os);
+    return buildOne(out, corpus);
+}
+
+Error
+AdocGenerator::
+buildOne(
+    llvm::raw_ostream& out,
+    Corpus const& corpus) const
+{
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
     AdocCorpus domCorpus(corpus);
-    auto ex = createExecutors(domCorpus);
+    if(corpus.config.domPrebuild)
+        if(auto err = domCorpus.prebuild())
+            return err;
+    auto ex = createExecutors(domCorpus, *options);
     if(! ex)
         return ex.error();
 
-    std::vector<Error> errors;
-
-    ex->async(
-        [&os](Builder& builder)
-        {
-            auto pageText = builder.renderSinglePageHeader().value();
-            os.write(pageText.data(), pageText.size());
-        });
-    errors = ex->wait();
-    if(! errors.empty())
-        return Error(errors);
-
-    SinglePageVisitor visitor(*ex, corpus, os);
+    // the header and footer are pages of the
+    // visitor, so the only wait is at the end
+    SinglePageVisitor visitor(*ex, corpus, out,
+        options->page_window, options->chunk_cost);
+    visitor.header();
     visitor(corpus.globalNamespace());
-    errors = ex->wait();
-    if(! errors.empty())
-        return Error(errors);
-
-    ex->async(
-        [ &os](Builder& builder)
-        {
-            auto pageText = builder.renderSinglePageFooter().value();
-            os.write(pageText.data(), pageText.size());
-        });
-    errors = ex->wait();
+    visitor.footer();
+    auto errors = ex->wait();
     if(! errors.empty())
         return Error(errors);
-
     return Error::success();
 }
 
@@ -50,6 +50,11 @@ public:
     buildOne(
         std::ostream& os,
         Corpus const& corpus) const override;
+
+    Error
+    buildOne(
+        llvm::raw_ostream& os,
+        Corpus const& corpus) const override;
 };
 
 } // adoc
@@ -9,11 +9,18 @@
 //
 
 #include "Builder.hpp"
+#include "Support/HandlebarsHelpers.hpp"
 #include "Support/Radix.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Metadata/DomMetadata.hpp>
 #include <mrdox/Support/Path.hpp>
+#include <mrdox/Version.hpp>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
 #include <fmt/format.h>
 
 namespace clang {
@@ -25,25 +32,299 @@ extern void lua_dump(dom::Object const& obj);
 
 namespace adoc {
 
+AddonCache::
+AddonCache(
+    Config const& config,
+    Options const& options)
+    : layoutDir_(files::appendPath(config.addonsDir,
+        "generator", "asciidoc", "layouts"))
+    , partialsDir_(files::appendPath(config.addonsDir,
+        "generator", "asciidoc", "partials"))
+    , fragments_(options.engine == "native" ?
+        options.cached_partials : std::vector<std::string>())
+    , profiling_(options.profile)
+    , verbose_(config.verboseOutput)
+{
+    if(! options.cache_dir.empty())
+        cacheDir_ = files::appendPath(options.cache_dir, "js");
+}
+
+AddonCache::
+~AddonCache()
+{
+    if(profiling_)
+        profile_.report();
+    if(verbose_ && fragments_.hits() + fragments_.misses() != 0)
+        reportInfo("Fragment cache: {} hits, {} misses",
+            fragments_.hits(), fragments_.misses());
+}
+
+std::uint64_t
+AddonCache::
+hashFiles(
+    Config const& config)
+{
+    namespace fs = llvm::sys::fs;
+
+    std::string const dir = files::appendPath(
+        config.addonsDir, "generator", "asciidoc");
+    std::string text;
+    std::error_code ec;
+    for(fs::recursive_directory_iterator it(dir, ec), end;
+        it != end && ! ec; it.increment(ec))
+    {
+        fs::file_status status;
+        if(fs::status(it->path(), status) ||
+            status.type() != fs::file_type::regular_file)
+            continue;
+        text += it->path();
+        text += fmt::format(" {} {}\n", status.getSize(),
+            status.getLastModificationTime().time_since_epoch().count());
+    }
+    return llvm::xxHash64(text);
+}
+
+void
+AddonCache::
+mergeProfile(RenderProfile const& profile)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    profile_.merge(profile);
+}
+
+Expected<std::span<AddonCache::Partial const>>
+AddonCache::
+partials()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(partials_)
+        return *partials_;
+    std::vector<Partial> partials;
+    auto err = forEachFile(partialsDir_,
+        [&](std::string_view pathName)
+        {
+            constexpr std::string_view ext = ".adoc.hbs";
+            if(! pathName.ends_with(ext))
+                return Error::success();
+            auto name = files::getFileName(pathName);
+            name.remove_suffix(ext.size());
+            auto text = files::getFileText(pathName);
+            if(! text)
+                return text.error();
+            partials.push_back({ std::string(name), std::move(*text) });
+            return Error::success();
+        });
+    if(err)
+        return err;
+    partials_ = std::move(partials);
+    return *partials_;
+}
+
+Expected<std::string_view>
+AddonCache::
+layout(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = layouts_.find(name);
+    if(it != layouts_.end())
+        return it->getValue();
+    auto text = files::getFileText(
+        files::appendPath(layoutDir_, name));
+    if(! text)
+        return text.error();
+    // StringMap values do not move
+    return layouts_.try_emplace(
+        name, std::move(*text)).first->getValue();
+}
+
+Expected<std::string_view>
+AddonCache::
+bytecode(
+    std::string_view pathName,
+    js::Scope& scope)
+{
+    namespace fs = llvm::sys::fs;
+
+    // Every builder waits for the first one to
+    // compile, which is still faster than each
+    // of them parsing the script.
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = bytecode_.find(pathName);
+    if(it != bytecode_.end())
+        return it->getValue();
+    auto text = files::getFileText(pathName);
+    if(! text)
+        return text.error();
+
+    // bytecode depends on the interpreter, which
+    // is part of this build, so hash the version too
+    std::string cachePath;
+    if(! cacheDir_.empty())
+    {
+        llvm::SHA1 H;
+        H.update(project_version);
+        H.update(*text);
+        cachePath = files::appendPath(cacheDir_,
+            llvm::toHex(H.final(), true) + ".jsbc");
+        if(auto bc = files::getFileText(cachePath))
+            return bytecode_.try_emplace(
+                pathName, std::move(*bc)).first->getValue();
+    }
+
+    auto bc = scope.compile(*text);
+    if(! bc)
+        return bc.error();
+    if(! cachePath.empty())
+    {
+        // write to a temporary and rename, so a
+        // partly written file is never loaded
+        std::string tempPath = cachePath + ".tmp";
+        std::error_code ec = fs::create_directories(cacheDir_);
+        if(! ec)
+        {
+            llvm::raw_fd_ostream os(tempPath, ec);
+            if(! ec)
+            {
+                os << *bc;
+                os.close();
+                if(! os.has_error())
+                    ec = fs::rename(tempPath, cachePath);
+            }
+        }
+        if(ec)
+            reportWarning("could not cache \"{}\": {}",
+                cachePath, ec.message());
+    }
+    return bytecode_.try_emplace(
+        pathName, std::move(*bc)).first->getValue();
+}
+
+//------------------------------------------------
+
+void
+Builder::
+initNative()
+{
+    for(auto const& partial : addons_->partials().value())
+        hbs_.registerPartial(partial.name, partial.text);
+
+    builtinHelpers().forEach(
+        [&](std::string_view name, Handlebars::Helper const& fn)
+        {
+            hbs_.registerHelper(name, fn);
+        });
+}
+
+void
+Builder::
+initLua()
+{
+    lua_ = std::make_unique<LuaHandlebars>();
+    for(auto const& partial : addons_->partials().value())
+        lua_->registerPartial(partial.name, partial.text);
+
+    builtinHelpers().forEach(
+        [&](std::string_view name, Handlebars::Helper const& fn)
+        {
+            lua_->registerHelper(name, fn);
+        });
+}
+
+Error
+Builder::
+callLua(
+    llvm::raw_ostream& os,
+    std::string_view name,
+    dom::Value const& context)
+{
+    if(! lua_->hasTemplate(name))
+    {
+        auto text = addons_->layout(name);
+        if(! text)
+            return text.error();
+        if(auto err = lua_->compile(name, *text))
+            return formatError("{}: {}",
+                name, err.message());
+    }
+    Handlebars::Options options;
+    options.noEscape = true;
+    options.profile = profile();
+    options.deadline = deadline_;
+    return lua_->render(os, name, context, options);
+}
+
+Error
+Builder::
+callNative(
+    llvm::raw_ostream& os,
+    std::string_view name,
+    dom::Value const& context)
+{
+    auto it = templates_.find(name);
+    if(it == templates_.end())
+    {
+        auto text = addons_->layout(name);
+        if(! text)
+            return text.error();
+        auto tmpl = Handlebars::compile(*text);
+        if(! tmpl)
+            return formatError("{}: {}",
+                name, tmpl.error().message());
+        it = templates_.try_emplace(
+            name, std::move(*tmpl)).first;
+    }
+    Handlebars::Options options;
+    options.noEscape = true;
+    options.profile = profile();
+    options.deadline = deadline_;
+    options.fragments = &addons_->fragments();
+    return hbs_.render(os, it->getValue(), context, options);
+}
+
+void
+Builder::
+checkDeadline() const
+{
+    if(std::chrono::steady_clock::now() >= deadline_)
+        formatError("the render took more than {} seconds",
+            options_.page_timeout).Throw();
+}
+
+//------------------------------------------------
+
 Builder::
 Builder(
     DomCorpus const& domCorpus,
-    Options const& options)
+    Options const& options,
+    std::shared_ptr<AddonCache> addons)
     : domCorpus_(domCorpus)
     , corpus_(domCorpus_.corpus)
     , options_(options)
+    , addons_(std::move(addons))
 {
     namespace fs = llvm::sys::fs;
     namespace path = llvm::sys::path;
 
     Config const& config = corpus_.config;
 
+    if(options_.engine == "native")
+    {
+        initNative();
+        return;
+    }
+    if(options_.engine == "lua")
+    {
+        initLua();
+        return;
+    }
+
     js::Scope scope(ctx_);
 
-    scope.script(files::getFileText(
+    auto bytecode = addons_->bytecode(
         files::appendPath(
-            config.addonsDir, "js", "handlebars.js")
-        ).value()).maybeThrow();
+            config.addonsDir, "js", "handlebars.js"),
+        scope).value();
+    scope.scriptBytecode(bytecode).maybeThrow();
     auto Handlebars = scope.getGlobal("Handlebars").value();
 
 // VFALCO refactor this
@@ -63,22 +344,9 @@ Handlebars.setlog();
     Error err;
 
     // load partials
-    forEachFile(
-        files::appendPath(config.addonsDir,
-            "generator", "asciidoc", "partials"),
-        [&](std::string_view pathName)
-        {
-            constexpr std::string_view ext = ".adoc.hbs";
-            if(! pathName.ends_with(ext))
-                return Error::success();
-            auto name = files::getFileName(pathName);
-            name.remove_suffix(ext.size());
-            auto text = files::getFileText(pathName);
-            if(! text)
-                return text.error();
-            return Handlebars.callProp(
-                "registerPartial", name, *text).error();
-        }).maybeThrow();
+    for(auto const& partial : addons_->partials().value())
+        Handlebars.callProp("registerPartial",
+            partial.name, partial.text).value();
 
     // load helpers
 #if 0
@@ -98,89 +366,178 @@ Handlebars.setlog();
         }).maybeThrow();
 #endif
 
-    scope.script(R"(
-        Handlebars.registerHelper(
-            'to_string', function(context, depth)
+    // native helpers, which are given the
+    // options object of Handlebars.js last
+    builtinHelpers().forEach(
+        [&](std::string_view name, Handlebars::Helper const& fn)
         {
-            return JSON.stringify(context, null, 2);
+            Handlebars.callProp("registerHelper",
+                name, scope.makeFunction(
+                [this, fn](std::span<dom::Value const> args)
+                {
+                    checkDeadline();
+                    return fn(args);
+                }, true)).value();
         });
 
-        Handlebars.registerHelper(
-            'eq', function(a, b)
-        {
-            return a === b;
-        });
+    scope.script(R"(
+        // the options used to compile and render layouts
+        var mrdoxOptions = {
+            noEscape: true,
+            allowProtoPropertiesByDefault: true
+            // VFALCO This makes Proxy objects stop working
+            //allowProtoMethodsByDefault: true
+        };
 
-        Handlebars.registerHelper(
-            'neq', function(a, b)
+        // call the given function before each partial
+        function mrdoxDeadline(check)
         {
-            return a !== b;
-        });
+            var invokePartial = Handlebars.VM.invokePartial;
+            Handlebars.VM.invokePartial = function(partial, context, options)
+            {
+                check();
+                return invokePartial.call(this, partial, context, options);
+            };
+        }
 
-        Handlebars.registerHelper(
-            'not', function(a)
+        // time each partial with the given functions
+        function mrdoxProfile(enter, leave)
         {
-            return ! a;
-        });
+            var invokePartial = Handlebars.VM.invokePartial;
+            Handlebars.VM.invokePartial = function(partial, context, options)
+            {
+                // compile the partial here, so
+                // its first call is timed too
+                if(typeof partial === 'string')
+                {
+                    partial = Handlebars.compile(partial, mrdoxOptions);
+                    options.partials[options.name] = partial;
+                }
+                enter(options.name);
+                try
+                {
+                    return invokePartial.call(this, partial, context, options);
+                }
+                finally
+                {
+                    leave();
+                }
+            };
+        }
+    )").maybeThrow();
 
-        Handlebars.registerHelper(
-            'or', function(a, b)
-        {
-            return a || b;
-        });
+    if(options_.profile)
+    {
+        auto enter = scope.makeFunction(
+            [this](std::span<dom::Value const> args) -> dom::Value
+            {
+                profile_.enter(args.empty() || ! args[0].isString() ?
+                    std::string_view("undefined") :
+                    std::string_view(args[0].getString().get()));
+                return nullptr;
+            });
+        auto leave = scope.makeFunction(
+            [this](std::span<dom::Value const>) -> dom::Value
+            {
+                profile_.leave();
+                return nullptr;
+            });
+        scope.getGlobal("mrdoxProfile").value()(enter, leave);
+    }
 
-        Handlebars.registerHelper(
-            'and', function(a, b)
-        {
-            return a && b;
-        });
-    )").maybeThrow();
+    // the partials and native helpers are where
+    // a runaway layout is stopped
+    if(options_.page_timeout != 0)
+    {
+        auto check = scope.makeFunction(
+            [this](std::span<dom::Value const>) -> dom::Value
+            {
+                checkDeadline();
+                return nullptr;
+            });
+        scope.getGlobal("mrdoxDeadline").value()(check);
+    }
+
+    // these are fetched once, and kept
+    // in the stash for every render
+    handlebars_ = js::Handle(Handlebars);
+    jsOptions_ = js::Handle(scope.getGlobal("mrdoxOptions").value());
+
+    ctx_.snapshot();
+}
+
+Builder::
+~Builder()
+{
+    if(options_.profile)
+        addons_->mergeProfile(profile_);
 }
 
 //------------------------------------------------
 
-Expected<std::string>
+Error
 Builder::
 callTemplate(
+    llvm::raw_ostream& os,
     std::string_view name,
     dom::Value const& context)
 {
-    Config const& config = corpus_.config;
+    MRDOX_PROFILE_ZONE_TEXT("callTemplate", name);
+    RenderProfile::Scope timing(profile(), name);
+    deadline_ = options_.page_timeout == 0
+        ? std::chrono::steady_clock::time_point::max()
+        : std::chrono::steady_clock::now() +
+            std::chrono::seconds(options_.page_timeout);
+    if(options_.engine == "native")
+        return callNative(os, name, context);
+    if(options_.engine == "lua")
+        return callLua(os, name, context);
+
+    // drop what earlier pages left behind,
+    // including cycles, every so often
+    constexpr std::size_t resetInterval = 256;
+    if(++renders_ % resetInterval == 0)
+        ctx_.reset();
 
     js::Scope scope(ctx_);
-    auto Handlebars = scope.getGlobal("Handlebars");
-    auto layoutDir = files::appendPath(config.addonsDir,
-            "generator", "asciidoc", "layouts");
-    auto pathName = files::appendPath(layoutDir, name);
-    auto fileText = files::getFileText(pathName);
-    if(! fileText)
-        return fileText.error();
-    dom::Object options;
-    options.set("noEscape", true);
-    options.set("allowProtoPropertiesByDefault", true);
-    // VFALCO This makes Proxy objects stop working
-    //options.set("allowProtoMethodsByDefault", true);
-    auto templateFn = Handlebars->callProp("compile", *fileText, options);
-    if(! templateFn)
-        return templateFn.error();
-    auto result = templateFn->call(context, options);
+    auto options = jsOptions_.get(scope);
+
+    // Each layout is compiled once per context,
+    // the first time it is rendered.
+    auto it = jsTemplates_.find(name);
+    if(it == jsTemplates_.end())
+    {
+        auto text = addons_->layout(name);
+        if(! text)
+            return text.error();
+        auto fn = handlebars_.get(scope).callProp(
+            "compile", *text, options);
+        if(! fn)
+            return fn.error();
+        it = jsTemplates_.try_emplace(
+            name, js::Handle(*fn)).first;
+    }
+    auto result = it->getValue().get(scope).call(context, options);
     if(! result)
         return result.error();
-    return result->getString();
+    // the text is written from the
+    // interpreter's string, without a copy
+    os << result->getStringView();
+    return Error::success();
 }
 
-Expected<std::string>
+Error
 Builder::
-renderSinglePageHeader()
+renderSinglePageHeader(llvm::raw_ostream& os)
 {
-    return callTemplate("single-header.adoc.hbs", {});
+    return callTemplate(os, "single-header.adoc.hbs", {});
 }
 
-Expected<std::string>
+Error
 Builder::
-renderSinglePageFooter()
+renderSinglePageFooter(llvm::raw_ostream& os)
 {
-    return callTemplate("single-footer.adoc.hbs", {});
+    return callTemplate(os, "single-footer.adoc.hbs", {});
 }
 
 //------------------------------------------------
@@ -190,23 +547,23 @@ Builder::
 createContext(
     SymbolID const& id)
 {
-    return dom::Object({
+    return pool_.newObject({
         { "symbol", domCorpus_.get(id) }
         });
 }
 
 template<class T>
-Expected<std::string>
+Error
 Builder::
-operator()(T const& I)
+operator()(llvm::raw_ostream& os, T const& I)
 {
-    return callTemplate(
+    return callTemplate(os,
         "single-symbol.adoc.hbs",
         createContext(I.id));
 }
 
-#define DEFINE(T) template Expected<std::string> \
-    Builder::operator()<T>(T const&)
+#define DEFINE(T) template Error \
+    Builder::operator()<T>(llvm::raw_ostream&, T const&)
 
 DEFINE(NamespaceInfo);
 DEFINE(RecordInfo);
@@ -12,11 +12,23 @@
 #define MRDOX_LIB_ADOC_BUILDER_HPP
 
 #include "Options.hpp"
+#include "Support/Handlebars.hpp"
+#include "Support/LuaHandlebars.hpp"
 #include "Support/Radix.hpp"
+#include "Support/RenderProfile.hpp"
 #include <mrdox/Metadata/DomMetadata.hpp>
 #include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/ExecutorGroup.hpp>
 #include <mrdox/Support/JavaScript.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
+#include <span>
+#include <vector>
 
 #include <mrdox/Support/Dom.hpp>
 
@@ -24,6 +36,101 @@ namespace clang {
 namespace mrdox {
 namespace adoc {
 
+/** The addon files used by the builders.
+
+    Each file is read once per generator run,
+    and shared by the builders of every thread.
+    Scripts are compiled to bytecode once, and
+    the bytecode is kept in the cache directory
+    when one is configured, keyed on a hash of
+    the script text.
+*/
+class AddonCache
+{
+public:
+    struct Partial
+    {
+        std::string name;
+        std::string text;
+    };
+
+private:
+    std::string layoutDir_;
+    std::string partialsDir_;
+    std::string cacheDir_;
+    std::mutex mutex_;
+    std::optional<std::vector<Partial>> partials_;
+    llvm::StringMap<std::string> layouts_;
+    llvm::StringMap<std::string> bytecode_;
+    RenderProfile profile_;
+    FragmentCache fragments_;
+    bool profiling_;
+    bool verbose_;
+
+public:
+    AddonCache(
+        Config const& config,
+        Options const& options);
+
+    /** Destructor.
+
+        The merged profile of the builders
+        is reported, if profiling is on.
+        The use of the shared renders is
+        reported in verbose mode.
+    */
+    ~AddonCache();
+
+    /** Return a hash of the addon files of the generator.
+
+        The names, sizes and times of the files
+        are enough to see an edit, without
+        reading every file each time.
+    */
+    static
+    std::uint64_t
+    hashFiles(
+        Config const& config);
+
+    /** Add the profile of a builder.
+    */
+    void
+    mergeProfile(RenderProfile const& profile);
+
+    /** Return the renders of partials shared by the builders.
+    */
+    FragmentCache&
+    fragments() noexcept
+    {
+        return fragments_;
+    }
+
+    /** Return the partials, reading them if needed.
+
+        The directory is walked by the first
+        builder, and the others share the text.
+    */
+    Expected<std::span<Partial const>>
+    partials();
+
+    /** Return the text of a layout, reading it if needed.
+    */
+    Expected<std::string_view>
+    layout(std::string_view name);
+
+    /** Return the bytecode of a script, compiling it if needed.
+
+        @param pathName The script file.
+
+        @param scope The scope used to compile
+        the script when it is not cached.
+    */
+    Expected<std::string_view>
+    bytecode(
+        std::string_view pathName,
+        js::Scope& scope);
+};
+
 /** Builds reference output.
 
     This contains all the state information
@@ -34,28 +141,83 @@ class Builder
     DomCorpus const& domCorpus_;
     Corpus const& corpus_;
     Options options_;
+    std::shared_ptr<AddonCache> addons_;
     js::Context ctx_;
+    js::Handle handlebars_;
+    js::Handle jsOptions_;
+    llvm::StringMap<js::Handle> jsTemplates_;
+    std::size_t renders_ = 0;
+    RenderProfile profile_;
+    dom::ObjectPool pool_;
+    Handlebars hbs_;
+    llvm::StringMap<Handlebars::Template> templates_;
+    std::unique_ptr<LuaHandlebars> lua_;
+    std::chrono::steady_clock::time_point deadline_ =
+        std::chrono::steady_clock::time_point::max();
+
+    void initNative();
+    void initLua();
+    void checkDeadline() const;
+
+    RenderProfile*
+    profile() noexcept
+    {
+        return options_.profile ? &profile_ : nullptr;
+    }
+
+    Error
+    callNative(
+        llvm::raw_ostream& os,
+        std::string_view name,
+        dom::Value const& context);
+
+    Error
+    callLua(
+        llvm::raw_ostream& os,
+        std::string_view name,
+        dom::Value const& context);
 
 public:
     Builder(
         DomCorpus const& domCorpus,
-        Options const& options);
+        Options const& options,
+        std::shared_ptr<AddonCache> addons);
+
+    ~Builder();
 
     dom::Value createContext(SymbolID const& id);
 
-    Expected<std::string>
+    /** Render a layout to a stream.
+
+        The output is written to the stream as
+        it is produced, and is not otherwise
+        held in memory.
+    */
+    Error
     callTemplate(
+        llvm::raw_ostream& os,
         std::string_view name,
         dom::Value const& context);
 
-    Expected<std::string> renderSinglePageHeader();
-    Expected<std::string> renderSinglePageFooter();
+    Error renderSinglePageHeader(llvm::raw_ostream& os);
+    Error renderSinglePageFooter(llvm::raw_ostream& os);
 
+    /** Render the page of a symbol to a stream.
+    */
     template<class T>
-    Expected<std::string>
-    operator()(T const&);
+    Error
+    operator()(llvm::raw_ostream& os, T const&);
 };
 
+/** Return a builder for each thread of the pool.
+
+    The builders share one cache of addons.
+*/
+Expected<ExecutorGroup<Builder>>
+createExecutors(
+    DomCorpus const& domCorpus,
+    Options const& options);
+
 } // adoc
 } // mrdox
 } // clang
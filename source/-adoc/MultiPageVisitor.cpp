@@ -9,19 +9,81 @@
 //
 
 #include "MultiPageVisitor.hpp"
+#include "RenderCost.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Support/Path.hpp>
-#include <fstream>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <numeric>
+#include <optional>
 
 namespace clang {
 namespace mrdox {
 namespace adoc {
 
+MultiPageVisitor::
+MultiPageVisitor(
+    ExecutorGroup<Builder>& ex,
+    PageWriter& writer,
+    DomCorpus const& domCorpus,
+    std::size_t chunkCost,
+    PageDependencies* deps)
+    : ex_(ex)
+    , writer_(writer)
+    , domCorpus_(domCorpus)
+    , corpus_(domCorpus.corpus)
+    , chunkCost_(chunkCost)
+    , deps_(deps)
+{
+    if(deps_)
+        hashes_ = std::make_unique<std::atomic<std::uint64_t>[]>(
+            corpus_.index().size());
+}
+
+std::uint64_t
+MultiPageVisitor::
+symbolHash(
+    SymbolID const& id) const
+{
+    auto const i = corpus_.indexOf(id);
+    if(i == SymbolHeaders::npos)
+        return 0;
+    auto& slot = hashes_[i];
+    std::uint64_t hash = slot.load(std::memory_order_relaxed);
+    if(hash != 0)
+        return hash;
+    // a racing thread computes the same hash
+    hash = std::max<std::uint64_t>(domCorpus_.hash(id), 1);
+    slot.store(hash, std::memory_order_relaxed);
+    return hash;
+}
+
+bool
+MultiPageVisitor::
+keepPage(
+    std::string const& name) const
+{
+    auto const old = deps_->find(name);
+    if(old.empty())
+        return false;
+    for(auto const& dep : old)
+        if(symbolHash(dep.id) != dep.hash)
+            return false;
+    if(! writer_.keep(name))
+        return false;
+    deps_->insert(name, { old.begin(), old.end() });
+    return true;
+}
+
 template<class T>
 void
 MultiPageVisitor::
 operator()(T const& I)
 {
-    renderPage(I);
+    if(! corpus_.hasSelected(I))
+        return;
+    if(corpus_.isSelected(I))
+        pages_.push_back(&I);
     if constexpr(
             T::isNamespace() ||
             T::isRecord())
@@ -30,30 +92,87 @@ operator()(T const& I)
 
 void
 MultiPageVisitor::
-renderPage(
-    auto const& I)
+renderPages()
 {
-    ex_.async(
-        [this, &I](Builder& builder)
+    std::vector<std::size_t> costs;
+    std::size_t first = 0;
+    std::size_t cost = 0;
+    for(std::size_t i = 0; i < pages_.size(); ++i)
+    {
+        cost += renderCost(*pages_[i]);
+        if(cost < chunkCost_ && i + 1 < pages_.size())
+            continue;
+        chunks_.emplace_back(&pages_[first], i + 1 - first);
+        costs.push_back(cost);
+        first = i + 1;
+        cost = 0;
+    }
+
+    // the agents take the chunks in order, so the
+    // most costly are started first and the cheap
+    // ones fill in the tail
+    std::vector<std::size_t> order(chunks_.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+        [&costs](std::size_t a, std::size_t b)
         {
-            auto pageText = builder(I).value();
+            return costs[a] > costs[b];
+        });
+    std::vector<std::span<Info const* const>> chunks;
+    chunks.reserve(order.size());
+    for(std::size_t i : order)
+        chunks.push_back(chunks_[i]);
+    chunks_ = std::move(chunks);
 
-            std::string fileName = files::appendPath(
-                outputPath_, toBase16(I.id) + ".adoc");
-            std::ofstream os;
-            try
-            {
-                os.open(fileName,
-                    std::ios_base::binary |
-                        std::ios_base::out |
-                        std::ios_base::trunc // | std::ios_base::noreplace
-                    );
-                os.write(pageText.data(), pageText.size());
-            }
-            catch(std::exception const& ex)
+    ex_.asyncRange(chunks_,
+        [this](Builder& builder, std::span<Info const* const> chunk)
+        {
+            // a failed page is not written, and
+            // the rest of the chunk is rendered
+            std::vector<Error> errors;
+            for(Info const* I : chunk)
             {
-                formatError("std::ofstream(\"{}\") threw \"{}\"", fileName, ex.what()).Throw();
+                char hex[40];
+                std::string name = pageFileName(toBase16(hex, I->id),
+                    "adoc", corpus_.config.shardDepth);
+                if(deps_ && keepPage(name))
+                    continue;
+
+                TraceScope trace("render", I->Name);
+                MRDOX_PROFILE_ZONE_TEXT("render", I->Name);
+                std::optional<SymbolRecorder> recorder;
+                if(deps_)
+                    recorder.emplace();
+                std::string pageText;
+                llvm::raw_string_ostream os(pageText);
+                Error err = visit(*I, [&](auto const& J)
+                    {
+                        return builder(os, J);
+                    });
+                if(err)
+                {
+                    errors.emplace_back(std::move(err));
+                    continue;
+                }
+                if(deps_)
+                {
+                    // hashing builds objects, which
+                    // are not looked up by the page
+                    std::vector<SymbolID> const ids = recorder->ids();
+                    recorder.reset();
+                    std::vector<PageDependencies::Dependency> deps;
+                    deps.reserve(ids.size());
+                    for(SymbolID const& id : ids)
+                        deps.push_back({ id, symbolHash(id) });
+                    deps_->insert(name, std::move(deps));
+                }
+                // the file is written on the writer's
+                // thread, so this one renders the next page
+                writer_.write(std::move(name), std::move(pageText));
             }
+            if(errors.empty())
+                return Error::success();
+            return Error(errors);
         });
 }
 
@@ -12,9 +12,15 @@
 #define MRDOX_LIB_ADOC_MULTIPAGEVISITOR_HPP
 
 #include "Builder.hpp"
+#include "Support/PageDependencies.hpp"
+#include "Support/PageWriter.hpp"
 #include <mrdox/Support/ExecutorGroup.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <ostream>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -23,27 +29,53 @@ namespace mrdox {
 namespace adoc {
 
 /** Visitor which emites a multi-page reference.
+
+    The traversal lists the pages, which
+    are then rendered to memory as a single
+    range of work, and the files are written
+    by the page writer. Consecutive pages are
+    grouped into chunks of about the chunk
+    cost, each of which is rendered by one
+    agent, the most costly first.
+
+    With the dependencies of the pages of the
+    last run, a page whose symbols did not
+    change is kept instead of rendered.
 */
 class MultiPageVisitor
 {
     ExecutorGroup<Builder>& ex_;
-    std::string_view outputPath_;
+    PageWriter& writer_;
+    DomCorpus const& domCorpus_;
     Corpus const& corpus_;
+    std::size_t chunkCost_;
+    PageDependencies* deps_;
+    std::vector<Info const*> pages_;
+    std::vector<std::span<Info const* const>> chunks_;
+
+    // the hash of each symbol, or zero
+    // when it is not computed yet
+    std::unique_ptr<std::atomic<std::uint64_t>[]> hashes_;
+
+    std::uint64_t symbolHash(SymbolID const& id) const;
+    bool keepPage(std::string const& name) const;
 
 public:
     MultiPageVisitor(
         ExecutorGroup<Builder>& ex,
-        std::string_view outputPath,
-        Corpus const& corpus) noexcept
-        : ex_(ex)
-        , outputPath_(outputPath)
-        , corpus_(corpus)
-    {
-    }
+        PageWriter& writer,
+        DomCorpus const& domCorpus,
+        std::size_t chunkCost,
+        PageDependencies* deps = nullptr);
 
     template<class T>
     void operator()(T const& I);
-    void renderPage(auto const& I);
+
+    /** Submit the work to render the listed pages.
+
+        The visitor must outlive the work.
+    */
+    void renderPages();
 };
 
 } // adoc
@@ -58,6 +58,12 @@ struct llvm::yaml::MappingTraits<
         auto& opt= yk.opt;
         io.mapOptional("safe-names",  opt.safe_names);
         io.mapOptional("template-dir",  opt.template_dir);
+        io.mapOptional("engine",  opt.engine);
+        io.mapOptional("profile",  opt.profile);
+        io.mapOptional("page-window",  opt.page_window);
+        io.mapOptional("chunk-cost",  opt.chunk_cost);
+        io.mapOptional("page-timeout",  opt.page_timeout);
+        io.mapOptional("cached-partials",  opt.cached_partials);
     }
 };
 
@@ -82,6 +88,7 @@ struct llvm::yaml::MappingTraits<
     {
         clang::mrdox::adoc::YamlGenKey ygk(opt);
         io.mapOptional("generator", ygk);
+        io.mapOptional("cache-dir", opt.cache_dir);
     }
 };
 
@@ -119,8 +126,21 @@ loadOptions(
             return Error(ec);
     }
 
+    if( opt.engine != "js" &&
+        opt.engine != "lua" &&
+        opt.engine != "native")
+        return formatError(
+            "unknown template engine \"{}\"", opt.engine);
+
     // adjust relative paths
 
+    if(! opt.cache_dir.empty())
+    {
+        opt.cache_dir = files::makeAbsolute(
+            opt.cache_dir,
+            corpus.config.workingDir);
+    }
+
     if(! opt.template_dir.empty())
     {
         opt.template_dir = files::makeAbsolute(
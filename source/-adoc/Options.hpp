@@ -12,7 +12,9 @@
 #define MRDOX_TOOL_ADOC_OPTIONS_HPP
 
 #include <mrdox/Support/Error.hpp>
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
@@ -27,6 +29,50 @@ struct Options
 {
     bool safe_names = false;
     std::string template_dir;
+    std::string cache_dir;
+
+    /** The template engine, "js", "lua" or "native".
+    */
+    std::string engine = "js";
+
+    /** Report the calls and times of each template and partial.
+    */
+    bool profile = false;
+
+    /** The most pages of single-page output rendered ahead.
+
+        Pages which are done before the pages
+        ahead of them are kept in memory, so
+        this bounds that memory. Zero means
+        no limit.
+    */
+    std::size_t page_window = 1024;
+
+    /** The estimated cost of the pages rendered by one task.
+
+        Consecutive pages are grouped until
+        their cost, as given by renderCost,
+        reaches this value. Zero or one
+        renders each page in its own task.
+    */
+    std::size_t chunk_cost = 16;
+
+    /** The most seconds the render of one page may take.
+
+        A page which takes longer fails with an
+        error, instead of holding up the output.
+        Zero means no limit.
+    */
+    unsigned page_timeout = 0;
+
+    /** The partials whose renders are reused, with the native engine.
+
+        A listed partial which is called with a
+        symbol is rendered once for each symbol,
+        and its output must depend only on the
+        symbol.
+    */
+    std::vector<std::string> cached_partials = { "function-sig" };
 };
 
 /** Return loaded Options from a configuration.
@@ -0,0 +1,111 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "PageRenderer.hpp"
+#include <llvm/Support/raw_ostream.h>
+
+namespace clang {
+namespace mrdox {
+namespace adoc {
+
+PageRenderer::
+PageRenderer(
+    Corpus const& corpus,
+    Options options,
+    std::size_t capacity)
+    : corpus_(corpus)
+    , options_(std::move(options))
+    , domCorpus_(corpus)
+    , capacity_(std::max<std::size_t>(capacity, 1))
+{
+}
+
+Expected<std::unique_ptr<PageRenderer>>
+PageRenderer::
+create(
+    Corpus const& corpus,
+    std::size_t capacity)
+{
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
+    std::unique_ptr<PageRenderer> renderer(
+        new PageRenderer(corpus, std::move(*options), capacity));
+    if(auto err = renderer->refresh())
+        return err;
+    return renderer;
+}
+
+Error
+PageRenderer::
+refresh()
+{
+    auto const hash = AddonCache::hashFiles(corpus_.config);
+    if(ex_ && hash == addonsHash_)
+        return Error::success();
+    // the builders of the old addons finish
+    // before the new ones are made
+    ex_.reset();
+    pages_.clear();
+    index_.clear();
+    auto ex = createExecutors(domCorpus_, options_);
+    if(! ex)
+        return ex.error();
+    ex_.emplace(std::move(*ex));
+    addonsHash_ = hash;
+    return Error::success();
+}
+
+Expected<std::string>
+PageRenderer::
+render(
+    SymbolID const& id)
+{
+    if(auto err = refresh())
+        return err;
+    if(auto it = index_.find(std::string_view(id));
+        it != index_.end())
+    {
+        ++hits_;
+        pages_.splice(pages_.begin(), pages_, it->second);
+        return std::string(it->second->text);
+    }
+    ++misses_;
+
+    Info const* I = corpus_.find(id);
+    if(! I)
+        return formatError("the symbol {} was not found", toBase16(id));
+    std::string text;
+    ex_->async(
+        [&](Builder& builder)
+        {
+            llvm::raw_string_ostream os(text);
+            return visit(*I, [&](auto const& J)
+                {
+                    return builder(os, J);
+                });
+        });
+    auto errors = ex_->wait();
+    if(! errors.empty())
+        return Error(errors);
+
+    pages_.push_front({ id, text });
+    index_[std::string_view(id)] = pages_.begin();
+    if(pages_.size() > capacity_)
+    {
+        index_.erase(std::string_view(pages_.back().id));
+        pages_.pop_back();
+    }
+    return text;
+}
+
+} // adoc
+} // mrdox
+} // clang
@@ -0,0 +1,95 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_ADOC_PAGERENDERER_HPP
+#define MRDOX_LIB_ADOC_PAGERENDERER_HPP
+
+#include "AdocCorpus.hpp"
+#include "Builder.hpp"
+#include <mrdox/Corpus.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace clang {
+namespace mrdox {
+namespace adoc {
+
+/** Render the pages of symbols when they are requested.
+
+    The builders of every thread are made once,
+    so their script contexts are reused for each
+    page. Rendered pages are kept in a cache of
+    the most recently used ones, keyed on the
+    symbol and a hash of the addon files. When
+    the addons change, the builders are made
+    again and the older pages are dropped.
+*/
+class PageRenderer
+{
+    struct Page
+    {
+        SymbolID id;
+        std::string text;
+    };
+
+    Corpus const& corpus_;
+    Options options_;
+    AdocCorpus domCorpus_;
+    std::optional<ExecutorGroup<Builder>> ex_;
+    std::uint64_t addonsHash_ = 0;
+    std::size_t capacity_;
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
+
+    // the most recently used page is first
+    std::list<Page> pages_;
+    llvm::StringMap<std::list<Page>::iterator> index_;
+
+    PageRenderer(
+        Corpus const& corpus,
+        Options options,
+        std::size_t capacity);
+
+    Error refresh();
+
+public:
+    /** Return a renderer for a corpus.
+
+        @param capacity The most pages
+        which are kept in the cache.
+    */
+    static
+    Expected<std::unique_ptr<PageRenderer>>
+    create(
+        Corpus const& corpus,
+        std::size_t capacity);
+
+    /** Return the page of a symbol.
+
+        Calls must not be concurrent.
+    */
+    Expected<std::string>
+    render(
+        SymbolID const& id);
+
+    std::size_t hits() const noexcept { return hits_; }
+    std::size_t misses() const noexcept { return misses_; }
+};
+
+} // adoc
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,37 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "RenderCost.hpp"
+#include <mrdox/Metadata.hpp>
+
+namespace clang {
+namespace mrdox {
+namespace adoc {
+
+std::size_t
+renderCost(
+    Info const& I)
+{
+    std::size_t cost = 1;
+    if(I.javadoc)
+        cost += I.javadoc->getBlocks().size();
+    visit(I, [&](auto const& J)
+    {
+        if constexpr(requires { J.Members; })
+            cost += J.Members.size();
+        if constexpr(requires { J.Params; })
+            cost += J.Params.size();
+    });
+    return cost;
+}
+
+} // adoc
+} // mrdox
+} // clang
@@ -0,0 +1,35 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_ADOC_RENDERCOST_HPP
+#define MRDOX_LIB_ADOC_RENDERCOST_HPP
+
+#include <mrdox/Metadata/Info.hpp>
+#include <cstddef>
+
+namespace clang {
+namespace mrdox {
+namespace adoc {
+
+/** Return the estimated cost of rendering the page of a symbol.
+
+    The unit is the cost of a page with no
+    members, parameters or documentation.
+    Each of those adds one to the estimate.
+*/
+std::size_t
+renderCost(
+    Info const& I);
+
+} // adoc
+} // mrdox
+} // clang
+
+#endif
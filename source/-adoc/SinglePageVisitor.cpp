@@ -9,7 +9,10 @@
 //
 
 #include "SinglePageVisitor.hpp"
+#include "RenderCost.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Support/unlock_guard.hpp>
+#include <fmt/format.h>
 
 namespace clang {
 namespace mrdox {
@@ -20,26 +23,136 @@ void
 SinglePageVisitor::
 operator()(T const& I)
 {
-    renderPage(I, numPages_++);
+    if(! corpus_.hasSelected(I))
+        return;
+    if(corpus_.isSelected(I))
+    {
+        // a costly symbol gets a page of its own,
+        // so the symbols before it are not held
+        // back until it is rendered
+        std::size_t const cost = renderCost(I);
+        if(cost >= chunkCost_)
+            flush();
+        chunk_.push_back(&I);
+        cost_ += cost;
+        if(cost_ >= chunkCost_)
+            flush();
+    }
     if constexpr(
             T::isNamespace() ||
             T::isRecord())
         corpus_.traverse(I, *this);
 }
 
+void
+SinglePageVisitor::
+header()
+{
+    renderPage({}, Part::header, numPages_++);
+}
+
+void
+SinglePageVisitor::
+footer()
+{
+    flush();
+    renderPage({}, Part::footer, numPages_++);
+}
+
+void
+SinglePageVisitor::
+flush()
+{
+    if(chunk_.empty())
+        return;
+    renderPage(std::move(chunk_), Part::symbols, numPages_++);
+    chunk_.clear();
+    cost_ = 0;
+}
+
 // Launch a task to render the page
 // pageNumber is zero-based
 //
 void
 SinglePageVisitor::
 renderPage(
-    auto const& I,
+    std::vector<Info const*> chunk,
+    Part part,
     std::size_t pageNumber)
 {
+    if(window_ != 0)
+    {
+        // throttle the traversal, which
+        // only waits on pages already queued
+        std::unique_lock<std::mutex> lock(mutex_);
+        advanced_.wait(lock, [&]
+            {
+                return pageNumber < topPage_ + window_;
+            });
+    }
+
     ex_.async(
-        [this, &I, pageNumber](Builder& builder)
+        [this, chunk = std::move(chunk), part, pageNumber](Builder& builder)
         {
-            endPage(builder(I).value(), pageNumber);
+            // the symbols after a failed one are
+            // still rendered, and every error of
+            // the page is returned
+            auto const render = [&](llvm::raw_ostream& os)
+            {
+                TraceScope trace("render");
+                if(trace)
+                    trace.setDetail(fmt::format("page {}", pageNumber));
+                std::vector<Error> errors;
+                auto const check = [&](Error err)
+                {
+                    if(err)
+                        errors.emplace_back(std::move(err));
+                };
+                if(part == Part::header)
+                    check(builder.renderSinglePageHeader(os));
+                for(Info const* I : chunk)
+                    visit(*I, [&](auto const& J)
+                        {
+                            check(builder(os, J));
+                        });
+                if(part == Part::footer)
+                    check(builder.renderSinglePageFooter(os));
+                if(errors.empty())
+                    return Error::success();
+                return Error(errors);
+            };
+
+            try
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if(pageNumber == topPage_)
+                {
+                    // no other page can be written until
+                    // this one is done, so write it directly
+                    Error err;
+                    {
+                        unlock_guard unlock(mutex_);
+                        err = render(os_);
+                    }
+                    writePages(lock, pageNumber + 1);
+                    return err;
+                }
+                lock.unlock();
+
+                // a failed page is kept too, so the
+                // pages after it do not wait forever
+                std::string pageText;
+                llvm::raw_string_ostream os(pageText);
+                Error err = render(os);
+                endPage(std::move(pageText), pageNumber);
+                return err;
+            }
+            catch(...)
+            {
+                // likewise for an exception
+                endPage({}, pageNumber);
+                throw;
+            }
         });
 }
 
@@ -52,33 +165,48 @@ endPage(
 {
     std::unique_lock<std::mutex> lock(mutex_);
 
+    // defer this page
+    auto const i = pageNumber - firstPage_;
+    if( pages_.size() <= i)
+        pages_.resize(i + 1);
+    pages_[i] = std::move(pageText);
     if(pageNumber > topPage_)
-    {
-        // defer this page
-        if( pages_.size() <= pageNumber)
-            pages_.resize(pageNumber + 1);
-        pages_[pageNumber] = std::move(pageText);
         return;
-    }
+    writePages(lock, pageNumber);
+}
 
-    // write contiguous pages
+// Write the deferred pages which are
+// contiguous, beginning with pageNumber
+void
+SinglePageVisitor::
+writePages(
+    std::unique_lock<std::mutex>& lock,
+    std::size_t pageNumber)
+{
     for(;;)
     {
+        topPage_ = pageNumber;
+        advanced_.notify_all();
+        // the pages before are written, so only
+        // the window is held in the queue
+        while(firstPage_ < pageNumber && ! pages_.empty())
         {
-            unlock_guard unlock(mutex_);
-            os_.write(pageText.data(), pageText.size());
-            ++pageNumber;
+            pages_.pop_front();
+            ++firstPage_;
         }
-        topPage_ = pageNumber;
-        if(pageNumber >= pages_.size())
+        firstPage_ = pageNumber;
+        if(pages_.empty() || ! pages_.front())
             return;
-        if(! pages_[pageNumber])
-            return;
-        pageText = std::move(*pages_[pageNumber]);
+        std::string pageText = std::move(*pages_.front());
         // VFALCO this is in theory not needed but
         // I am paranoid about the std::move of the
         // string not resulting in a deallocation.
-        pages_[pageNumber].reset();
+        pages_.front().reset();
+        {
+            unlock_guard unlock(mutex_);
+            os_ << pageText;
+            ++pageNumber;
+        }
     }
 }
 
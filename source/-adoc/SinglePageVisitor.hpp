@@ -13,8 +13,11 @@
 
 #include "Builder.hpp"
 #include <mrdox/Support/ExecutorGroup.hpp>
+#include <llvm/Support/raw_ostream.h>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
-#include <ostream>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -23,33 +26,94 @@ namespace mrdox {
 namespace adoc {
 
 /** Visitor which writes everything to a single page.
+
+    Pages are written in order. The page which
+    is next when its rendering starts is written
+    straight to the stream, and the others are
+    kept until the pages before them are written.
+    The header and the footer are the first and
+    the last pages, so nothing waits for all of
+    the pages before them to be done.
+
+    Consecutive symbols are grouped into one
+    page until their estimated cost reaches
+    the chunk cost, so that small symbols do
+    not each pay for a task. A page is not
+    submitted until it is within the window
+    of the next page to be written, so a slow
+    page holds back at most that many pages
+    in memory.
+
+    The last page and the footer are submitted
+    by @ref footer.
 */
 class SinglePageVisitor
 {
+    enum class Part
+    {
+        header,
+        symbols,
+        footer
+    };
+
     ExecutorGroup<Builder>& ex_;
     Corpus const& corpus_;
-    std::ostream& os_;
-    std::size_t numPages_ = 0; 
+    llvm::raw_ostream& os_;
+    std::size_t window_;
+    std::size_t chunkCost_;
+    std::size_t numPages_ = 0;
+    std::vector<Info const*> chunk_;
+    std::size_t cost_ = 0;
     std::mutex mutex_;
+    std::condition_variable advanced_;
     std::size_t topPage_ = 0;
-    std::vector<std::optional<
+
+    // the pages held back, from firstPage_ on
+    std::size_t firstPage_ = 0;
+    std::deque<std::optional<
         std::string>> pages_;
 
+    void flush();
+    void renderPage(std::vector<Info const*> chunk,
+        Part part, std::size_t pageNumber);
+    void endPage(std::string pageText, std::size_t pageNumber);
+    void writePages(std::unique_lock<std::mutex>& lock,
+        std::size_t pageNumber);
+
 public:
+    /** Constructor.
+
+        @param window The most pages which may
+        be rendered ahead of the next page to be
+        written, or zero for no limit.
+
+        @param chunkCost The estimated cost of
+        the symbols rendered as one page.
+    */
     SinglePageVisitor(
         ExecutorGroup<Builder>& ex,
         Corpus const& corpus,
-        std::ostream& os) noexcept
+        llvm::raw_ostream& os,
+        std::size_t window,
+        std::size_t chunkCost) noexcept
         : ex_(ex)
         , corpus_(corpus)
         , os_(os)
+        , window_(window)
+        , chunkCost_(chunkCost)
     {
     }
 
+    /** Submit the header, before any symbol.
+    */
+    void header();
+
     template<class T>
     void operator()(T const& I);
-    void renderPage(auto const& I, std::size_t pageNumber);
-    void endPage(std::string pageText, std::size_t pageNumber);
+
+    /** Submit the symbols not yet submitted, then the footer.
+    */
+    void footer();
 };
 
 } // adoc
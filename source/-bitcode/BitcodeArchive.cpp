@@ -0,0 +1,254 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "BitcodeArchive.hpp"
+#include "AST/Bitcode.hpp"
+#include "Support/Error.hpp"
+#include <mrdox/Corpus.hpp>
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Endian.h>
+#include <algorithm>
+#include <cstring>
+
+namespace clang {
+namespace mrdox {
+namespace bitcode {
+
+namespace {
+
+constexpr llvm::StringLiteral archiveMagic = "MRDOXBA1";
+
+// symbol ID, offset, compressed size, size
+constexpr std::size_t entrySize = 20 + 8 + 4 + 4;
+
+// magic, codec, count
+constexpr std::size_t headerSize = 8 + 4 + 4;
+
+enum class Codec : std::uint32_t
+{
+    None = 0,
+    Zlib = 1,
+    Zstd = 2
+};
+
+Codec
+chooseCodec() noexcept
+{
+    if(llvm::compression::zstd::isAvailable())
+        return Codec::Zstd;
+    if(llvm::compression::zlib::isAvailable())
+        return Codec::Zlib;
+    return Codec::None;
+}
+
+struct Frame
+{
+    SymbolID id;
+    std::uint32_t size = 0;
+    llvm::SmallVector<std::uint8_t, 0> data;
+
+    // the uncompressed bitcode, which is
+    // kept instead of copying into data
+    llvm::SmallString<0> bitcode;
+
+    llvm::StringRef
+    bytes() const noexcept
+    {
+        if(! data.empty())
+            return { reinterpret_cast<char const*>(
+                data.data()), data.size() };
+        return bitcode.str();
+    }
+};
+
+void
+compressFrame(
+    Codec codec,
+    Frame& frame,
+    llvm::SmallString<0>&& bitcode)
+{
+    llvm::ArrayRef<std::uint8_t> input(
+        reinterpret_cast<std::uint8_t const*>(bitcode.data()),
+        bitcode.size());
+    frame.size = static_cast<std::uint32_t>(bitcode.size());
+    switch(codec)
+    {
+    case Codec::Zstd:
+        llvm::compression::zstd::compress(input, frame.data);
+        break;
+    case Codec::Zlib:
+        llvm::compression::zlib::compress(input, frame.data);
+        break;
+    case Codec::None:
+        frame.bitcode = std::move(bitcode);
+        break;
+    }
+}
+
+void
+writeU32(
+    std::ostream& os,
+    std::uint32_t v)
+{
+    char buf[4];
+    llvm::support::endian::write32le(buf, v);
+    os.write(buf, sizeof(buf));
+}
+
+void
+writeU64(
+    std::ostream& os,
+    std::uint64_t v)
+{
+    char buf[8];
+    llvm::support::endian::write64le(buf, v);
+    os.write(buf, sizeof(buf));
+}
+
+} // (anon)
+
+Error
+writeBitcodeArchive(
+    std::ostream& os,
+    Corpus const& corpus,
+    bool compress)
+{
+    auto const& index = corpus.index();
+    Codec const codec = compress ? chooseCodec() : Codec::None;
+
+    // compress every symbol concurrently
+    std::vector<Frame> frames(index.size());
+    TaskGroup taskGroup(corpus.config.threadPool());
+    for(std::size_t i = 0; i < index.size(); ++i)
+    {
+        taskGroup.async(
+            [&, i]
+            {
+                Frame& frame = frames[i];
+                frame.id = index[i]->id;
+                auto bc = writeBitcode(*index[i]);
+                compressFrame(codec, frame, std::move(bc.data));
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Error(errors);
+
+    std::sort(frames.begin(), frames.end(),
+        [](Frame const& a, Frame const& b)
+        {
+            return a.id < b.id;
+        });
+
+    os.write(archiveMagic.data(), archiveMagic.size());
+    writeU32(os, static_cast<std::uint32_t>(codec));
+    writeU32(os, frames.size());
+    std::uint64_t offset = 0;
+    for(auto const& frame : frames)
+    {
+        auto const bytes = frame.bytes();
+        os.write(reinterpret_cast<char const*>(frame.id.data()), 20);
+        writeU64(os, offset);
+        writeU32(os, bytes.size());
+        writeU32(os, frame.size);
+        offset += bytes.size();
+    }
+    for(auto const& frame : frames)
+    {
+        auto const bytes = frame.bytes();
+        os.write(bytes.data(), bytes.size());
+    }
+    if(! os)
+        return formatError("write bitcode archive failed");
+    return Error::success();
+}
+
+Expected<std::string>
+readArchivedBitcode(
+    llvm::StringRef archive,
+    SymbolID const& id)
+{
+    namespace endian = llvm::support::endian;
+
+    if(archive.size() < headerSize ||
+        archive.take_front(archiveMagic.size()) != archiveMagic)
+        return formatError("not a bitcode archive");
+    auto const codec = static_cast<Codec>(
+        endian::read32le(archive.data() + 8));
+    std::size_t const count = endian::read32le(archive.data() + 12);
+    if((archive.size() - headerSize) / entrySize < count)
+        return formatError("bitcode archive is truncated");
+    char const* const table = archive.data() + headerSize;
+    llvm::StringRef const frames =
+        archive.drop_front(headerSize + count * entrySize);
+
+    // binary search the sorted table
+    llvm::StringRef const key(id);
+    std::size_t lo = 0;
+    std::size_t hi = count;
+    while(lo < hi)
+    {
+        std::size_t const mid = lo + (hi - lo) / 2;
+        char const* const p = table + mid * entrySize;
+        int const cmp = llvm::StringRef(p, 20).compare(key);
+        if(cmp < 0)
+        {
+            lo = mid + 1;
+            continue;
+        }
+        if(cmp > 0)
+        {
+            hi = mid;
+            continue;
+        }
+
+        std::uint64_t const offset = endian::read64le(p + 20);
+        std::size_t const csize = endian::read32le(p + 28);
+        std::size_t size = endian::read32le(p + 32);
+        if(offset > frames.size() ||
+            csize > frames.size() - offset)
+            return formatError("bitcode archive is truncated");
+        llvm::ArrayRef<std::uint8_t> input(
+            reinterpret_cast<std::uint8_t const*>(
+                frames.data() + offset), csize);
+
+        std::string result(size, '\0');
+        auto* out = reinterpret_cast<std::uint8_t*>(result.data());
+        switch(codec)
+        {
+        case Codec::Zstd:
+            if(auto err = llvm::compression::zstd::decompress(input, out, size))
+                return toError(std::move(err));
+            break;
+        case Codec::Zlib:
+            if(auto err = llvm::compression::zlib::decompress(input, out, size))
+                return toError(std::move(err));
+            break;
+        case Codec::None:
+            if(csize != size)
+                return formatError("bitcode archive is corrupt");
+            std::memcpy(out, input.data(), size);
+            break;
+        default:
+            return formatError("unknown bitcode archive codec");
+        }
+        result.resize(size);
+        return result;
+    }
+    return formatError("symbol not found in bitcode archive");
+}
+
+} // bitcode
+} // mrdox
+} // clang
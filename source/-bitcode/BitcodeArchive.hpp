@@ -0,0 +1,63 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_BITCODE_BITCODEARCHIVE_HPP
+#define MRDOX_TOOL_BITCODE_BITCODEARCHIVE_HPP
+
+#include <mrdox/MetadataFwd.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringRef.h>
+#include <ostream>
+#include <string>
+
+namespace clang {
+namespace mrdox {
+
+class Corpus;
+
+namespace bitcode {
+
+/** Write every symbol of a corpus to an indexed archive.
+
+    The archive starts with a header holding the
+    compression codec and a table of symbol ID,
+    offset, and sizes sorted by symbol ID. Each
+    symbol follows as its own compressed frame,
+    so one symbol can be loaded without reading
+    the others. zstd is used when LLVM was built
+    with it, otherwise zlib, otherwise nothing.
+
+    The symbols are serialized concurrently
+    on the thread pool of the configuration.
+
+    @param compress `false` to store every
+    frame uncompressed.
+*/
+Error
+writeBitcodeArchive(
+    std::ostream& os,
+    Corpus const& corpus,
+    bool compress = true);
+
+/** Return the bitcode for one symbol in an archive.
+
+    The table is binary searched, and only the
+    frame of the matching symbol is decompressed.
+*/
+Expected<std::string>
+readArchivedBitcode(
+    llvm::StringRef archive,
+    SymbolID const& id);
+
+} // bitcode
+} // mrdox
+} // clang
+
+#endif
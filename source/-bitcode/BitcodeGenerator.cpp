@@ -10,6 +10,8 @@
 //
 
 #include "BitcodeGenerator.hpp"
+#include "BitcodeArchive.hpp"
+#include "Options.hpp"
 #include "Support/Error.hpp"
 #include "Support/SafeNames.hpp"
 #include "AST/Bitcode.hpp"
@@ -90,6 +92,14 @@ class SingleFileBuilder
     Corpus const& corpus_;
     std::ostream& os_;
 
+    struct Entry
+    {
+        Info const* I;
+        Bitcode bc;
+    };
+
+    std::vector<Entry> entries_;
+
 public:
     SingleFileBuilder(
         std::ostream& os,
@@ -103,6 +113,20 @@ public:
     build()
     {
         corpus_.traverse(corpus_.globalNamespace(), *this);
+
+        // serialize concurrently, then
+        // write in the order of traversal
+        auto errors = corpus_.config.threadPool().forEach(entries_,
+            [](Entry& entry)
+            {
+                entry.bc = writeBitcode(*entry.I);
+            });
+        if(! errors.empty())
+            return Error(errors);
+        for(auto const& entry : entries_)
+            os_.write(entry.bc.data.data(), entry.bc.data.size());
+        if(! os_)
+            return formatError("write bitcode failed");
         return Error::success();
     }
 
@@ -110,8 +134,7 @@ public:
     void
     operator()(T const& I)
     {
-        auto bc = writeBitcode(I);
-        os_.write(bc.data.data(), bc.data.size());
+        entries_.push_back({ &I });
         if constexpr(T::isRecord())
             corpus_.traverse(I, *this);
     }
@@ -125,6 +148,12 @@ build(
     std::string_view outputPath,
     Corpus const& corpus) const
 {
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
+    // the archive is always a single file
+    if(options->archive)
+        return Generator::build(outputPath, corpus);
     return MultiFileBuilder(outputPath, corpus).build();
 }
 
@@ -134,6 +163,11 @@ buildOne(
     std::ostream& os,
     Corpus const& corpus) const
 {
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
+    if(options->archive)
+        return writeBitcodeArchive(os, corpus, options->compress);
     return SingleFileBuilder(os, corpus).build();
 }
 
@@ -0,0 +1,123 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Options.hpp"
+#include "Tool/ConfigImpl.hpp"
+#include <mrdox/Corpus.hpp>
+#include <llvm/Support/YAMLParser.h>
+#include <llvm/Support/YAMLTraits.h>
+
+namespace clang {
+namespace mrdox {
+namespace bitcode {
+
+struct YamlKey
+{
+    Options& opt;
+
+    explicit
+    YamlKey(
+        Options& opt_) noexcept
+        : opt(opt_)
+    {
+    }
+};
+
+struct YamlGenKey
+{
+    Options& opt;
+
+    explicit
+    YamlGenKey(
+        Options& opt_)
+        : opt(opt_)
+    {
+    }
+};
+
+} // bitcode
+} // mrdox
+} // clang
+
+template<>
+struct llvm::yaml::MappingTraits<
+    clang::mrdox::bitcode::YamlKey>
+{
+    static void mapping(IO& io,
+        clang::mrdox::bitcode::YamlKey& yk)
+    {
+        auto& opt= yk.opt;
+        io.mapOptional("archive",  opt.archive);
+        io.mapOptional("compress",  opt.compress);
+    }
+};
+
+template<>
+struct llvm::yaml::MappingTraits<
+    clang::mrdox::bitcode::YamlGenKey>
+{
+    static void mapping(IO& io,
+        clang::mrdox::bitcode::YamlGenKey& ygk)
+    {
+        clang::mrdox::bitcode::YamlKey yk(ygk.opt);
+        io.mapOptional("bitcode",  yk);
+    }
+};
+
+template<>
+struct llvm::yaml::MappingTraits<
+    clang::mrdox::bitcode::Options>
+{
+    static void mapping(IO& io,
+        clang::mrdox::bitcode::Options& opt)
+    {
+        clang::mrdox::bitcode::YamlGenKey ygk(opt);
+        io.mapOptional("generator", ygk);
+    }
+};
+
+namespace clang {
+namespace mrdox {
+namespace bitcode {
+
+Expected<Options>
+loadOptions(
+    Corpus const& corpus)
+{
+    Options opt;
+
+    // config
+    {
+        llvm::yaml::Input yin(
+            corpus.config.configYaml, nullptr,
+                ConfigImpl::yamlDiagnostic);
+        yin.setAllowUnknownKeys(true);
+        yin >> opt;
+        if(auto ec = yin.error())
+            return Error(ec);
+    }
+
+    // extra
+    {
+        llvm::yaml::Input yin(
+            corpus.config.extraYaml, nullptr,
+                ConfigImpl::yamlDiagnostic);
+        yin.setAllowUnknownKeys(true);
+        yin >> opt;
+        if(auto ec = yin.error())
+            return Error(ec);
+    }
+
+    return opt;
+}
+
+} // bitcode
+} // mrdox
+} // clang
@@ -0,0 +1,49 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_BITCODE_OPTIONS_HPP
+#define MRDOX_TOOL_BITCODE_OPTIONS_HPP
+
+#include <mrdox/Support/Error.hpp>
+
+namespace clang {
+namespace mrdox {
+
+class Corpus;
+
+namespace bitcode {
+
+/** Generator-specific options.
+*/
+struct Options
+{
+    /** `true` to write one compressed, indexed archive.
+    */
+    bool archive = false;
+
+    /** `false` to store the symbols of the archive uncompressed.
+
+        The archive is then a bundle which costs
+        no time to write or read beyond copying.
+    */
+    bool compress = true;
+};
+
+/** Return loaded Options from a configuration.
+*/
+Expected<Options>
+loadOptions(
+    Corpus const& corpus);
+
+} // bitcode
+} // mrdox
+} // clang
+
+#endif
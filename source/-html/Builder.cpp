@@ -0,0 +1,206 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Builder.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <mrdox/Version.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SHA1.h>
+#include <algorithm>
+#include <chrono>
+
+namespace clang {
+namespace mrdox {
+namespace html {
+
+ScriptCache::
+ScriptCache(
+    Config const& config,
+    Options const& options)
+    : verbose_(config.verboseOutput)
+{
+    if(! options.cache_dir.empty())
+        cacheDir_ = files::appendPath(options.cache_dir, "lua");
+}
+
+ScriptCache::
+~ScriptCache()
+{
+    if(! verbose_ || contexts_ == 0)
+        return;
+    reportInfo("Lua: {} interpreters, {} allocations, "
+        "{} KB at most in one, {} refused",
+        contexts_, memory_.allocations,
+        memory_.peak / 1024, memory_.refused);
+}
+
+void
+ScriptCache::
+mergeStats(lua::MemoryStats const& stats)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++contexts_;
+    memory_.bytes += stats.bytes;
+    memory_.peak = std::max(memory_.peak, stats.peak);
+    memory_.allocations += stats.allocations;
+    memory_.refused += stats.refused;
+}
+
+Expected<std::string_view>
+ScriptCache::
+bytecode(
+    std::string_view pathName,
+    lua::Scope& scope)
+{
+    namespace fs = llvm::sys::fs;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = bytecode_.find(pathName);
+    if(it != bytecode_.end())
+        return it->getValue();
+    auto text = files::getFileText(pathName);
+    if(! text)
+        return text.error();
+
+    // bytecode depends on the interpreter, which
+    // is part of this build, so hash the version too
+    std::string cachePath;
+    if(! cacheDir_.empty())
+    {
+        llvm::SHA1 H;
+        H.update(project_version);
+        H.update(*text);
+        cachePath = files::appendPath(cacheDir_,
+            llvm::toHex(H.final(), true) + ".luac");
+        if(auto bc = files::getFileText(cachePath))
+            return bytecode_.try_emplace(
+                pathName, std::move(*bc)).first->getValue();
+    }
+
+    auto bc = scope.compile(*text, pathName);
+    if(! bc)
+        return bc.error();
+    if(! cachePath.empty())
+    {
+        // write to a temporary and rename, so a
+        // partly written file is never loaded
+        std::string tempPath = cachePath + ".tmp";
+        std::error_code ec = fs::create_directories(cacheDir_);
+        if(! ec)
+        {
+            llvm::raw_fd_ostream os(tempPath, ec);
+            if(! ec)
+            {
+                os << *bc;
+                os.close();
+                if(! os.has_error())
+                    ec = fs::rename(tempPath, cachePath);
+            }
+        }
+        if(ec)
+            reportWarning("could not cache \"{}\": {}",
+                cachePath, ec.message());
+    }
+    return bytecode_.try_emplace(
+        pathName, std::move(*bc)).first->getValue();
+}
+
+//------------------------------------------------
+
+Builder::
+Builder(
+    DomCorpus const& domCorpus,
+    Options const& options,
+    std::shared_ptr<ScriptCache> scripts)
+    : domCorpus_(domCorpus)
+    , options_(options)
+    , scripts_(std::move(scripts))
+    , ctx_(std::size_t(options_.memory_limit) << 20)
+{
+    lua::Scope scope(ctx_);
+    Config const& config = domCorpus_.corpus.config;
+    auto globals = scope.getGlobalTable();
+    globals.set("multiPage", config.multiPage);
+    globals.set("shardDepth", std::int64_t(config.shardDepth));
+    auto bytecode = scripts_->bytecode(
+        options_.script, scope).value();
+    auto chunk = scope.loadChunk(
+        bytecode, options_.script).value();
+    chunk.call().value();
+    ctx_.snapshot();
+}
+
+Builder::
+~Builder()
+{
+    scripts_->mergeStats(ctx_.memoryStats());
+}
+
+Error
+Builder::
+callScript(
+    llvm::raw_ostream& os,
+    std::string_view name,
+    dom::Value const& arg,
+    bool optional)
+{
+    // each call starts from the globals
+    // the script defined when it was loaded
+    ctx_.reset();
+    ctx_.setDeadline(options_.page_timeout == 0
+        ? std::chrono::steady_clock::time_point::max()
+        : std::chrono::steady_clock::now() +
+            std::chrono::seconds(options_.page_timeout));
+    lua::Scope scope(ctx_);
+    auto fn = scope.getGlobal(name);
+    if(! fn)
+    {
+        if(optional)
+            return Error::success();
+        return formatError("{}: {}",
+            options_.script, fn.error().message());
+    }
+    auto result = fn->call(arg);
+    if(! result)
+        return result.error();
+    if(! result->isString())
+        return formatError("{}: {} returned {}, not a string",
+            options_.script, name, result->displayString());
+    // the text is written from the
+    // interpreter's string, without a copy
+    os << lua::String(std::move(*result)).get();
+    return Error::success();
+}
+
+Error
+Builder::
+renderSinglePageHeader(llvm::raw_ostream& os)
+{
+    return callScript(os, "header", nullptr, true);
+}
+
+Error
+Builder::
+renderSinglePageFooter(llvm::raw_ostream& os)
+{
+    return callScript(os, "footer", nullptr, true);
+}
+
+Error
+Builder::
+operator()(llvm::raw_ostream& os, Info const& I)
+{
+    return callScript(os, "page", domCorpus_.get(I.id), false);
+}
+
+} // html
+} // mrdox
+} // clang
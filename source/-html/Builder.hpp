@@ -0,0 +1,127 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_HTML_BUILDER_HPP
+#define MRDOX_LIB_HTML_BUILDER_HPP
+
+#include "Options.hpp"
+#include <mrdox/Metadata/DomMetadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Lua.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <memory>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+namespace html {
+
+/** The compiled scripts used by the builders.
+
+    Each script is compiled to bytecode once
+    per generator run, and shared by the
+    builders of every thread. The bytecode is
+    kept in the cache directory when one is
+    configured, keyed on a hash of the script
+    text, so later runs skip the parser.
+*/
+class ScriptCache
+{
+    std::string cacheDir_;
+    std::mutex mutex_;
+    llvm::StringMap<std::string> bytecode_;
+    lua::MemoryStats memory_;
+    std::size_t contexts_ = 0;
+    bool verbose_;
+
+public:
+    ScriptCache(
+        Config const& config,
+        Options const& options);
+
+    /** Destructor.
+
+        The memory used by the interpreters
+        is reported, if output is verbose.
+    */
+    ~ScriptCache();
+
+    /** Add the memory statistics of an interpreter.
+    */
+    void
+    mergeStats(lua::MemoryStats const& stats);
+
+    /** Return the bytecode of a script, compiling it if needed.
+
+        @param pathName The script file.
+
+        @param scope The scope used to compile
+        the script when it is not cached.
+    */
+    Expected<std::string_view>
+    bytecode(
+        std::string_view pathName,
+        lua::Scope& scope);
+};
+
+/** Builds reference output.
+
+    This contains all the state information
+    for a single thread to generate output.
+    The script is run once when the builder
+    is constructed, and defines the global
+    functions `page`, which returns the text
+    of the page of a symbol, and optionally
+    `header` and `footer`, which return the
+    text around a single page reference. The
+    globals `multiPage` and `shardDepth` hold
+    the settings of the same configuration
+    keys, so that links can be formed.
+    Globals assigned by one call are not seen
+    by the next, so pages do not depend on the
+    order in which the thread renders them.
+*/
+class Builder
+{
+    DomCorpus const& domCorpus_;
+    Options options_;
+    std::shared_ptr<ScriptCache> scripts_;
+    lua::Context ctx_;
+
+    Error
+    callScript(
+        llvm::raw_ostream& os,
+        std::string_view name,
+        dom::Value const& arg,
+        bool optional);
+
+public:
+    Builder(
+        DomCorpus const& domCorpus,
+        Options const& options,
+        std::shared_ptr<ScriptCache> scripts);
+
+    ~Builder();
+
+    Error renderSinglePageHeader(llvm::raw_ostream& os);
+    Error renderSinglePageFooter(llvm::raw_ostream& os);
+
+    /** Render the page of a symbol to a stream.
+    */
+    Error
+    operator()(llvm::raw_ostream& os, Info const& I);
+};
+
+} // html
+} // mrdox
+} // clang
+
+#endif
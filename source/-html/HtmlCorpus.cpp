@@ -0,0 +1,267 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "HtmlCorpus.hpp"
+#include <mrdox/Support/String.hpp>
+#include <algorithm>
+#include <span>
+
+namespace clang {
+namespace mrdox {
+namespace html {
+
+namespace {
+
+class DocVisitor
+{
+    using Node = doc::NodePool::Node;
+
+    doc::NodePool const& pool_;
+    std::string& dest_;
+
+    void escape(std::string_view s);
+    void children(Node const& I);
+
+public:
+    DocVisitor(
+        doc::NodePool const& pool,
+        std::string& dest) noexcept
+        : pool_(pool)
+        , dest_(dest)
+    {
+    }
+
+    void operator()(Node const& I);
+
+    void visitCode(Node const& I);
+    void visitLink(Node const& I);
+    void visitStyled(Node const& I);
+};
+
+void
+DocVisitor::
+escape(
+    std::string_view s)
+{
+    for(char c : s)
+    {
+        switch(c)
+        {
+        case '&': dest_.append("&amp;"); break;
+        case '<': dest_.append("&lt;"); break;
+        case '>': dest_.append("&gt;"); break;
+        case '"': dest_.append("&quot;"); break;
+        default: dest_.push_back(c); break;
+        }
+    }
+}
+
+void
+DocVisitor::
+children(
+    Node const& I)
+{
+    auto const children = pool_.children(I);
+    for(std::size_t i = 0; i < children.size(); ++i)
+    {
+        auto const n = dest_.size();
+        (*this)(children[i]);
+        // detect empty text blocks
+        if(i + 1 < children.size() && dest_.size() > n)
+            dest_.push_back(' ');
+    }
+}
+
+void
+DocVisitor::
+operator()(
+    Node const& I)
+{
+    switch(I.kind)
+    {
+    case doc::Kind::code:
+        return visitCode(I);
+    case doc::Kind::heading:
+        dest_.append("<h3>");
+        escape(pool_.string(I));
+        dest_.append("</h3>\n");
+        return;
+    case doc::Kind::brief:
+        // the brief is used inline
+        return children(I);
+    case doc::Kind::paragraph:
+        dest_.append("<p>");
+        children(I);
+        dest_.append("</p>\n");
+        return;
+    case doc::Kind::link:
+        return visitLink(I);
+    case doc::Kind::list_item:
+        dest_.append("<li>");
+        children(I);
+        dest_.append("</li>\n");
+        return;
+    case doc::Kind::text:
+        return escape(trim(pool_.string(I)));
+    case doc::Kind::styled:
+        return visitStyled(I);
+    case doc::Kind::admonition:
+    case doc::Kind::param:
+    case doc::Kind::returns:
+    case doc::Kind::tparam:
+        return;
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+void
+DocVisitor::
+visitCode(
+    Node const& I)
+{
+    auto const children = pool_.children(I);
+
+    // remove the common indentation
+    std::size_t margin = std::size_t(-1);
+    for(auto const& text : children)
+    {
+        std::string_view const s = pool_.string(text);
+        if(! trim(s).empty())
+            margin = std::min(margin, s.size() - ltrim(s).size());
+    }
+
+    dest_.append("<pre><code>");
+    for(auto const& text : children)
+    {
+        if(text.kind != doc::Kind::text)
+            MRDOX_UNREACHABLE();
+        std::string_view s = pool_.string(text);
+        if(! trim(s).empty())
+            escape(s.substr(margin));
+        dest_.push_back('\n');
+    }
+    dest_.append("</code></pre>\n");
+}
+
+void
+DocVisitor::
+visitLink(
+    Node const& I)
+{
+    dest_.append("<a href=\"");
+    escape(pool_.href(I));
+    dest_.append("\">");
+    escape(pool_.string(I));
+    dest_.append("</a>");
+}
+
+void
+DocVisitor::
+visitStyled(
+    Node const& I)
+{
+    std::string_view s = trim(pool_.string(I));
+    switch(pool_.style(I))
+    {
+    case doc::Style::none:
+        escape(s);
+        break;
+    case doc::Style::bold:
+        dest_.append("<b>");
+        escape(s);
+        dest_.append("</b>");
+        break;
+    case doc::Style::mono:
+        dest_.append("<code>");
+        escape(s);
+        dest_.append("</code>");
+        break;
+    case doc::Style::italic:
+        dest_.append("<em>");
+        escape(s);
+        dest_.append("</em>");
+        break;
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+class DomJavadoc : public dom::LazyObjectImpl
+{
+    Javadoc const& jd_;
+
+public:
+    DomJavadoc(
+        Javadoc const& jd) noexcept
+        : jd_(jd)
+    {
+    }
+
+    void
+    maybeEmplace(
+        storage_type& list,
+        std::string_view key,
+        doc::NodePool::Node const& I) const
+    {
+        std::string s;
+        DocVisitor visitor(jd_.pool(), s);
+        visitor(I);
+        if(! s.empty())
+            list.emplace_back(key, std::move(s));
+    };
+
+    void
+    maybeEmplace(
+        storage_type& list,
+        std::string_view key,
+        std::vector<doc::NodePool::Node const*> const& nodes) const
+    {
+        std::string s;
+        DocVisitor visitor(jd_.pool(), s);
+        for(auto const& t : nodes)
+            visitor(*t);
+        if(! s.empty())
+            list.emplace_back(key, std::move(s));
+    };
+
+    dom::Object
+    construct() const override
+    {
+        storage_type list;
+        list.reserve(2);
+
+        auto const& ov = jd_.pool().overview();
+
+        if(ov.brief)
+            maybeEmplace(list, "brief", *ov.brief);
+        maybeEmplace(list, "description", ov.blocks);
+        if(ov.returns)
+            maybeEmplace(list, "returns", *ov.returns);
+        maybeEmplace(list, "params", ov.params);
+        maybeEmplace(list, "tparams", ov.tparams);
+
+        return dom::Object(std::move(list));
+    }
+};
+
+} // (anon)
+
+dom::Value
+HtmlCorpus::
+getJavadoc(
+    Javadoc const& jd) const
+{
+    return dom::newObject<DomJavadoc>(jd);
+}
+
+} // html
+} // mrdox
+} // clang
@@ -0,0 +1,45 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_HTML_HTMLCORPUS_HPP
+#define MRDOX_TOOL_HTML_HTMLCORPUS_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Metadata/DomMetadata.hpp>
+
+namespace clang {
+namespace mrdox {
+namespace html {
+
+/** A Dom corpus whose javadoc is rendered as HTML.
+
+    Text is escaped, so the strings may be
+    written to a page as they are.
+*/
+class HtmlCorpus : public DomCorpus
+{
+public:
+    explicit
+    HtmlCorpus(
+        Corpus const& corpus)
+        : DomCorpus(corpus)
+    {
+    }
+
+    dom::Value
+    getJavadoc(
+        Javadoc const& jd) const override;
+};
+
+} // html
+} // mrdox
+} // clang
+
+#endif
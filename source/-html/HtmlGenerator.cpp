@@ -0,0 +1,297 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Builder.hpp"
+#include "HtmlCorpus.hpp"
+#include "HtmlGenerator.hpp"
+#include "Support/PageWriter.hpp"
+#include "Support/PhaseReport.hpp"
+#include "Support/Trace.hpp"
+#include <mrdox/Support/ExecutorGroup.hpp>
+#include <mrdox/Support/Path.hpp>
+#include <llvm/Support/raw_os_ostream.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+namespace html {
+
+namespace {
+
+Expected<ExecutorGroup<Builder>>
+createExecutors(
+    DomCorpus const& domCorpus,
+    Options const& options)
+{
+    auto const& config = domCorpus.corpus.config;
+    auto& threadPool = config.threadPool();
+    auto scripts = std::make_shared<ScriptCache>(config, options);
+    ExecutorGroup<Builder> group(threadPool);
+    for(auto i = threadPool.getThreadCount(); i--;)
+    {
+        try
+        {
+           group.emplace(domCorpus, options, scripts);
+        }
+        catch(Exception const& ex)
+        {
+            return ex.error();
+        }
+    }
+    return group;
+}
+
+/** Visitor which lists the pages, in order.
+*/
+class PageVisitor
+{
+    Corpus const& corpus_;
+    std::vector<Info const*>& pages_;
+
+public:
+    PageVisitor(
+        Corpus const& corpus,
+        std::vector<Info const*>& pages) noexcept
+        : corpus_(corpus)
+        , pages_(pages)
+    {
+    }
+
+    template<class T>
+    void operator()(T const& I)
+    {
+        if(! corpus_.hasSelected(I))
+            return;
+        if(corpus_.isSelected(I))
+            pages_.push_back(&I);
+        if constexpr(
+                T::isNamespace() ||
+                T::isRecord())
+            corpus_.traverse(I, *this);
+    }
+};
+
+std::vector<Info const*>
+listPages(
+    Corpus const& corpus)
+{
+    std::vector<Info const*> pages;
+    PageVisitor visitor(corpus, pages);
+    visitor(corpus.globalNamespace());
+    return pages;
+}
+
+/** Writes the parts of a single page in order.
+
+    A part is written as soon as the parts
+    before it are, so the output is streamed
+    while the rest is rendered. At most the
+    window of parts may be rendered ahead of
+    the output.
+*/
+class OrderedOutput
+{
+    llvm::raw_ostream& os_;
+    std::size_t window_;
+    std::mutex mutex_;
+    std::condition_variable advanced_;
+    std::size_t next_ = 0;
+
+    // the parts from next_ on
+    std::deque<std::optional<std::string>> parts_;
+
+public:
+    OrderedOutput(
+        llvm::raw_ostream& os,
+        std::size_t window) noexcept
+        : os_(os)
+        , window_(window)
+    {
+    }
+
+    /** Block until a part is in the window.
+    */
+    void
+    reserve(std::size_t n)
+    {
+        if(window_ == 0)
+            return;
+        std::unique_lock<std::mutex> lock(mutex_);
+        advanced_.wait(lock, [&]
+            {
+                return n < next_ + window_;
+            });
+    }
+
+    /** Add a part, writing it if the parts before it are written.
+    */
+    void
+    put(std::size_t n, std::string text)
+    {
+        // the parts are written under the lock,
+        // since the stream has only one writer
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto const i = n - next_;
+        if(parts_.size() <= i)
+            parts_.resize(i + 1);
+        parts_[i] = std::move(text);
+        if(i != 0)
+            return;
+        while(! parts_.empty() && parts_.front())
+        {
+            os_ << *parts_.front();
+            parts_.pop_front();
+            ++next_;
+        }
+        advanced_.notify_all();
+    }
+};
+
+} // (anon)
+
+//------------------------------------------------
+//
+// HtmlGenerator
+//
+//------------------------------------------------
+
+Error
+HtmlGenerator::
+build(
+    std::string_view outputPath,
+    Corpus const& corpus) const
+{
+    if(! corpus.config.multiPage)
+        return Generator::build(outputPath, corpus);
+
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
+    auto const pages = listPages(corpus);
+    HtmlCorpus domCorpus(corpus);
+    domCorpus.assignPages(pages, "html");
+    if(corpus.config.domPrebuild)
+        if(auto err = domCorpus.prebuild())
+            return err;
+    auto ex = createExecutors(domCorpus, *options);
+    if(! ex)
+        return ex.error();
+
+    ScopedPhase phase("render");
+    PageWriter writer(outputPath, corpus.config);
+    if(corpus.config.progress)
+        writer.showProgress(pages.size());
+    ex->asyncRange(pages,
+        [&writer, &domCorpus](Builder& builder, Info const* I)
+        {
+            TraceScope trace("render", I->Name);
+            MRDOX_PROFILE_ZONE_TEXT("render", I->Name);
+            std::string pageText;
+            llvm::raw_string_ostream os(pageText);
+            if(auto err = builder(os, *I))
+                return err;
+            writer.write(std::string(domCorpus.getPageFile(I->id)),
+                std::move(pageText));
+            return Error::success();
+        });
+    auto errors = ex->wait();
+    setPhaseUnits("render", writer.filesQueued(), "page");
+    for(auto& err : writer.finish())
+        errors.push_back(std::move(err));
+    if(! errors.empty())
+        return Error(errors);
+    return Error::success();
+}
+
+Error
+HtmlGenerator::
+buildOne(
+    std::ostream& os,
+    Corpus const& corpus) const
+{
+    llvm::raw_os_ostream out(os);
+    return buildOne(out, corpus);
+}
+
+Error
+HtmlGenerator::
+buildOne(
+    llvm::raw_ostream& out,
+    Corpus const& corpus) const
+{
+    auto options = loadOptions(corpus);
+    if(! options)
+        return options.error();
+    auto const pages = listPages(corpus);
+    HtmlCorpus domCorpus(corpus);
+    domCorpus.assignPages(pages, {});
+    if(corpus.config.domPrebuild)
+        if(auto err = domCorpus.prebuild())
+            return err;
+    auto ex = createExecutors(domCorpus, *options);
+    if(! ex)
+        return ex.error();
+
+    // the header and footer are the first and
+    // last parts, and each page is one part
+    OrderedOutput output(out, options->page_window);
+    auto const submit = [&](std::size_t n, auto render)
+    {
+        output.reserve(n);
+        ex->async(
+            [&output, n, render](Builder& builder)
+            {
+                std::string text;
+                llvm::raw_string_ostream os(text);
+                // a failed part is empty, so
+                // the parts after it are written
+                Error err = render(builder, os);
+                output.put(n, std::move(text));
+                return err;
+            });
+    };
+    submit(0,
+        [](Builder& builder, llvm::raw_ostream& os)
+        {
+            return builder.renderSinglePageHeader(os);
+        });
+    for(std::size_t i = 0; i < pages.size(); ++i)
+        submit(i + 1,
+            [I = pages[i]](Builder& builder, llvm::raw_ostream& os)
+            {
+                return builder(os, *I);
+            });
+    submit(pages.size() + 1,
+        [](Builder& builder, llvm::raw_ostream& os)
+        {
+            return builder.renderSinglePageFooter(os);
+        });
+    auto errors = ex->wait();
+    if(! errors.empty())
+        return Error(errors);
+    return Error::success();
+}
+
+} // html
+
+//------------------------------------------------
+
+std::unique_ptr<Generator>
+makeHtmlGenerator()
+{
+    return std::make_unique<html::HtmlGenerator>();
+}
+
+} // mrdox
+} // clang
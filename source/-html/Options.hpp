@@ -0,0 +1,69 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_HTML_OPTIONS_HPP
+#define MRDOX_TOOL_HTML_OPTIONS_HPP
+
+#include <mrdox/Support/Error.hpp>
+#include <string>
+
+namespace clang {
+namespace mrdox {
+
+class Corpus;
+
+namespace html {
+
+/** Generator-specific options.
+*/
+struct Options
+{
+    /** The Lua script which renders the pages.
+
+        When not set, the script in the
+        addons directory is used.
+    */
+    std::string script;
+
+    std::string cache_dir;
+
+    /** The most memory the script of a thread may use, in megabytes.
+
+        Zero means no limit.
+    */
+    unsigned memory_limit = 0;
+
+    /** The most seconds the script may take to render one page.
+
+        Zero means no limit.
+    */
+    unsigned page_timeout = 0;
+
+    /** The most pages of single-page output rendered ahead.
+
+        Pages which are done before the pages
+        ahead of them are kept in memory, so
+        this bounds that memory. Zero means
+        no limit.
+    */
+    std::size_t page_window = 1024;
+};
+
+/** Return loaded Options from a configuration.
+*/
+Expected<Options>
+loadOptions(
+    Corpus const& corpus);
+
+} // html
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,169 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "JsonGenerator.hpp"
+#include "Support/JsonWriter.hpp"
+#include "Support/RawOstream.hpp"
+#include "Support/SafeNames.hpp"
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Metadata/DomMetadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+namespace clang {
+namespace mrdox {
+namespace json {
+
+namespace {
+
+// Symbols refer to each other in both
+// directions, so a symbol nested inside
+// another is written as its ID.
+class SymbolWriter : public JsonWriter
+{
+    std::optional<dom::Value>
+    collapse(
+        dom::Object const& obj,
+        std::size_t) override
+    {
+        if(obj.exists("id") && obj.exists("kind"))
+            return obj.find("id");
+        return std::nullopt;
+    }
+
+public:
+    using JsonWriter::JsonWriter;
+};
+
+class MultiFileBuilder
+{
+    Corpus const& corpus_;
+    std::string_view outputPath_;
+    DomCorpus domCorpus_;
+    SafeNames names_;
+    TaskGroup taskGroup_;
+
+public:
+    MultiFileBuilder(
+        std::string_view outputPath,
+        Corpus const& corpus)
+        : corpus_(corpus)
+        , outputPath_(outputPath)
+        , domCorpus_(corpus)
+        , names_(corpus_)
+        , taskGroup_(corpus.config.threadPool())
+    {
+    }
+
+    Error
+    build()
+    {
+        corpus_.traverse(
+            corpus_.globalNamespace(), *this);
+        auto errors = taskGroup_.wait();
+        if(! errors.empty())
+            return Error(errors);
+        return Error::success();
+    }
+
+    template<class T>
+    void operator()(T const& I)
+    {
+        namespace fs = llvm::sys::fs;
+        namespace path = llvm::sys::path;
+
+        taskGroup_.async(
+            [&]
+            {
+                llvm::SmallString<512> filePath(outputPath_);
+                llvm::StringRef name = names_.get(I.id);
+                path::append(filePath, name);
+                filePath.append(".json");
+                std::error_code ec;
+                llvm::raw_fd_ostream os(filePath, ec, fs::CD_CreateAlways);
+                if(ec)
+                {
+                    reportError(Error(ec), "open \"{}\"", filePath);
+                    return;
+                }
+                SymbolWriter(os).write(domCorpus_.get(I));
+                os << '\n';
+                if(auto ec = os.error())
+                    reportError(Error(ec), "write \"{}\"", filePath);
+            });
+
+        if constexpr(
+                T::isNamespace() ||
+                T::isRecord())
+            corpus_.traverse(I, *this);
+    }
+};
+
+} // (anon)
+
+Error
+JsonGenerator::
+build(
+    std::string_view outputPath,
+    Corpus const& corpus) const
+{
+    if(! corpus.config.multiPage)
+        return Generator::build(outputPath, corpus);
+    return MultiFileBuilder(outputPath, corpus).build();
+}
+
+Error
+JsonGenerator::
+buildOne(
+    std::ostream& os,
+    Corpus const& corpus) const
+{
+    RawOstream raw_os(os);
+    return buildOne(raw_os, corpus);
+}
+
+Error
+JsonGenerator::
+buildOne(
+    llvm::raw_ostream& raw_os,
+    Corpus const& corpus) const
+{
+    // The symbols are written one at a time as
+    // elements of a single array, so the whole
+    // document is never held in memory.
+    DomCorpus domCorpus(corpus);
+    SymbolWriter writer(raw_os);
+    raw_os << "[";
+    bool first = true;
+    for(Info const* I : corpus.index())
+    {
+        raw_os << (first ? "\n" : ",\n");
+        first = false;
+        writer.write(domCorpus.get(*I));
+    }
+    raw_os << "\n]\n";
+    return Error::success();
+}
+
+} // json
+
+//------------------------------------------------
+
+std::unique_ptr<Generator>
+makeJsonGenerator()
+{
+    return std::make_unique<json::JsonGenerator>();
+}
+
+} // mrdox
+} // clang
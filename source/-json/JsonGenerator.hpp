@@ -0,0 +1,61 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_JSON_JSONGENERATOR_HPP
+#define MRDOX_LIB_JSON_JSONGENERATOR_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Generator.hpp>
+
+namespace clang {
+namespace mrdox {
+namespace json {
+
+struct JsonGenerator : Generator
+{
+    std::string_view
+    id() const noexcept override
+    {
+        return "json";
+    }
+
+    std::string_view
+    displayName() const noexcept override
+    {
+        return "JavaScript Object Notation (JSON)";
+    }
+
+    std::string_view
+    fileExtension() const noexcept override
+    {
+        return "json";
+    }
+
+    Error
+    build(
+        std::string_view outputPath,
+        Corpus const& corpus) const override;
+
+    Error
+    buildOne(
+        std::ostream& os,
+        Corpus const& corpus) const override;
+
+    Error
+    buildOne(
+        llvm::raw_ostream& os,
+        Corpus const& corpus) const override;
+};
+
+} // json
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,140 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "SearchGenerator.hpp"
+#include "Support/JsonWriter.hpp"
+#include "Support/PageWriter.hpp"
+#include "Support/Radix.hpp"
+#include "Support/RawOstream.hpp"
+#include <mrdox/Corpus.hpp>
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Path.h>
+
+namespace clang {
+namespace mrdox {
+namespace search {
+
+namespace {
+
+// Return the row of a symbol, or an
+// empty string if it is not rendered
+std::string
+makeRow(
+    Corpus const& corpus,
+    Info const& I)
+{
+    if(! corpus.isSelected(I))
+        return {};
+
+    // the brief without its markup
+    std::string brief;
+    if(I.javadoc)
+        if(doc::Paragraph const* p = I.javadoc->brief())
+            for(auto const& text : p->children)
+                brief += text->string;
+
+    char hex[40];
+    std::string_view const id = toBase16(hex, I.id);
+    std::string url;
+    if(corpus.config.multiPage)
+    {
+        url = pageFileName(id, "html", corpus.config.shardDepth);
+    }
+    else
+    {
+        url = "reference.html#";
+        url += id;
+    }
+
+    std::string row;
+    llvm::raw_string_ostream os(row);
+    os << '[';
+    writeJsonString(os, corpus.qualifiedName(I));
+    os << ',';
+    writeJsonString(os, toString(I.Kind));
+    os << ',';
+    writeJsonString(os, brief);
+    os << ',';
+    writeJsonString(os, url);
+    os << ']';
+    return row;
+}
+
+} // (anon)
+
+Error
+SearchGenerator::
+build(
+    std::string_view outputPath,
+    Corpus const& corpus) const
+{
+    namespace path = llvm::sys::path;
+
+    // the index is one file for either kind of output
+    llvm::SmallString<0> fileName(outputPath);
+    if(path::extension(outputPath).compare_insensitive(".json") != 0)
+        path::append(fileName, "search-index.json");
+    return Generator::buildOne(fileName.str(), corpus);
+}
+
+Error
+SearchGenerator::
+buildOne(
+    std::ostream& os,
+    Corpus const& corpus) const
+{
+    RawOstream raw_os(os);
+    return buildOne(raw_os, corpus);
+}
+
+Error
+SearchGenerator::
+buildOne(
+    llvm::raw_ostream& os,
+    Corpus const& corpus) const
+{
+    // The rows are formed concurrently, and
+    // come back in traversal order so that
+    // the index is deterministic.
+    auto rows = corpus.mapOrdered(corpus.globalNamespace(),
+        [&corpus](Info const& I)
+        {
+            return makeRow(corpus, I);
+        });
+    if(! rows)
+        return rows.error();
+
+    os << R"({"fields":["name","kind","brief","url"],"symbols":[)";
+    bool first = true;
+    for(auto const& row : *rows)
+    {
+        if(row.empty())
+            continue;
+        os << (first ? "\n" : ",\n") << row;
+        first = false;
+    }
+    os << "\n]}\n";
+    return Error::success();
+}
+
+} // search
+
+//------------------------------------------------
+
+std::unique_ptr<Generator>
+makeSearchGenerator()
+{
+    return std::make_unique<search::SearchGenerator>();
+}
+
+} // mrdox
+} // clang
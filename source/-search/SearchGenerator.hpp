@@ -0,0 +1,71 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SEARCH_SEARCHGENERATOR_HPP
+#define MRDOX_LIB_SEARCH_SEARCHGENERATOR_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Generator.hpp>
+
+namespace clang {
+namespace mrdox {
+namespace search {
+
+/** A generator which emits a search index of the symbols.
+
+    The index is one compact JSON document,
+    `search-index.json`, with a row for every
+    rendered symbol holding its qualified name,
+    its kind, the text of its brief, and the
+    URL of its page in the HTML output,
+    relative to the output directory. It is
+    compressed when output compression is set.
+*/
+struct SearchGenerator : Generator
+{
+    std::string_view
+    id() const noexcept override
+    {
+        return "search";
+    }
+
+    std::string_view
+    displayName() const noexcept override
+    {
+        return "Search Index";
+    }
+
+    std::string_view
+    fileExtension() const noexcept override
+    {
+        return "json";
+    }
+
+    Error
+    build(
+        std::string_view outputPath,
+        Corpus const& corpus) const override;
+
+    Error
+    buildOne(
+        std::ostream& os,
+        Corpus const& corpus) const override;
+
+    Error
+    buildOne(
+        llvm::raw_ostream& os,
+        Corpus const& corpus) const override;
+};
+
+} // search
+} // mrdox
+} // clang
+
+#endif
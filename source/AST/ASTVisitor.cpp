@@ -14,22 +14,30 @@
 #include "ASTVisitorHelpers.hpp"
 #include "Bitcode.hpp"
 #include "ParseJavadoc.hpp"
+#include "Metadata/Reduce.hpp"
 #include "Tool/ConfigImpl.hpp"
+#include "Tool/JumboDatabase.hpp"
 #include "Support/Path.hpp"
 #include "Support/Debug.hpp"
+#include "Support/Memory.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Metadata.hpp>
 #include <clang/AST/Attr.h>
 #include <clang/AST/Decl.h>
 #include <clang/AST/DeclCXX.h>
 #include <clang/AST/DeclFriend.h>
+#include <clang/Basic/Module.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Index/USRGeneration.h>
 #include <clang/Lex/Lexer.h>
+#include <clang/Sema/Sema.h>
 #include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/Error.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/SHA1.h>
+#include <fmt/format.h>
+#include <algorithm>
 #include <ranges>
 
 namespace clang {
@@ -49,8 +57,108 @@ ASTVisitor(
     : ex_(static_cast<ExecutionContext&>(ex))
     , config_(config)
     , compiler_(compiler)
-    , IsFileInRootDir_(true)
+    , start_(std::chrono::steady_clock::now())
+    , deadline_(ex_.deadline())
 {
+    if(config_.tuTimeout_ != 0)
+        deadline_ = std::min(deadline_,
+            start_ + std::chrono::seconds(config_.tuTimeout_));
+}
+
+void
+ASTVisitor::
+insertBitcode(
+    Bitcode&& bitcode)
+{
+    ++bitcodes_;
+    batch_.insert(bitcode);
+}
+
+bool
+ASTVisitor::
+isDuplicate(
+    SymbolID const& id,
+    const Decl* D)
+{
+    // the cached results of each translation
+    // unit must be complete on their own
+    if(ex_.cache())
+        return false;
+
+    // a template asks before its templated
+    // declaration is built, which asks again
+    auto [it, inserted] = duplicates_.try_emplace(D, false);
+    if(! inserted)
+        return it->second;
+
+    bool isDefinition = false;
+    if(auto const* TD = dyn_cast<TagDecl>(D))
+        isDefinition = TD->isThisDeclarationADefinition();
+    else if(auto const* FD = dyn_cast<FunctionDecl>(D))
+        isDefinition = FD->isThisDeclarationADefinition();
+    else if(auto const* VD = dyn_cast<VarDecl>(D))
+        isDefinition = VD->isThisDeclarationADefinition() !=
+            VarDecl::DeclarationOnly;
+
+    PresumedLoc const loc =
+        sourceManager_->getPresumedLoc(D->getBeginLoc());
+    llvm::SmallString<256> key(std::string_view(id));
+    key.append(File_);
+    key.push_back(':');
+    key.append(std::to_string(loc.getLine()));
+    key.push_back(':');
+    key.append(std::to_string(loc.getColumn()));
+    key.push_back(isDefinition ? 'D' : 'd');
+    // the javadoc is not parsed yet, so
+    // look for the comment it comes from
+    bool const hasComment = ! isa<NamespaceDecl>(D) &&
+        D->getASTContext().getRawCommentForDeclNoCache(D);
+    key.push_back(hasComment ? 'J' : 'j');
+    it->second = ex_.isEmitted(key) ||
+        ! emitted_.insert(key).second;
+    return it->second;
+}
+
+bool
+ASTVisitor::
+isDuplicateTemplated(
+    const NamedDecl* D)
+{
+    SymbolID id;
+    return ! ex_.cache() &&
+        shouldSerializeInfo(D) &&
+        extractSymbolID(D, id) &&
+        isDuplicate(id, D);
+}
+
+bool
+ASTVisitor::
+isExtractedElsewhere(
+    const Decl* D)
+{
+    Module const* M = D->getOwningModule();
+    if(! M)
+        return false;
+    auto [it, inserted] = moduleFilter_.try_emplace(M, false);
+    if(! inserted)
+        return it->second;
+    if(ex_.isModuleInterface(M->getTopLevelModuleName()))
+    {
+        it->second = true;
+    }
+    else if(! ex_.cache())
+    {
+        // the cached results of each translation
+        // unit must be complete on their own
+        std::string key = M->getFullModuleName();
+        if(auto F = M->getASTFile())
+        {
+            key.push_back('@');
+            key.append(F->getName());
+        }
+        it->second = ! ex_.claimModule(key);
+    }
+    return it->second;
 }
 
 //------------------------------------------------
@@ -69,11 +177,25 @@ extractSymbolID(
     const Decl* D,
     SymbolID& id)
 {
+    // redeclarations share a USR, so the
+    // canonical declaration is the key
+    auto [it, inserted] = symbolIDs_.try_emplace(
+        D->getCanonicalDecl(), SymbolID::zero);
+    if(! inserted)
+    {
+        ++symbolIDHits_;
+        if(it->second.empty())
+            return false;
+        id = it->second;
+        return true;
+    }
+    ++symbolIDMisses_;
     usr_.clear();
     if(index::generateUSRForDecl(D, usr_))
         return false;
     id = SymbolID(llvm::SHA1::hash(
         arrayRefFromStringRef(usr_)).data());
+    it->second = id;
     return true;
 }
 
@@ -126,15 +248,60 @@ getLine(
         D->getBeginLoc()).getLine();
 }
 
-std::string
+SourceText
 ASTVisitor::
 getSourceCode(
     SourceRange const& R)
 {
-    return Lexer::getSourceText(
+    if(! ex_.facets().sourceText)
+        return {};
+    // this is what Lexer::getSourceText does,
+    // without copying text which is kept as a range
+    CharSourceRange const range = Lexer::makeFileCharRange(
         CharSourceRange::getTokenRange(R),
         *sourceManager_,
-        astContext_->getLangOpts()).str();
+        astContext_->getLangOpts());
+    if(range.isInvalid())
+        return {};
+    auto const [id, begin] =
+        sourceManager_->getDecomposedLoc(range.getBegin());
+    auto const [endId, end] =
+        sourceManager_->getDecomposedLoc(range.getEnd());
+    if(id != endId || end < begin)
+        return {};
+    bool invalid = false;
+    llvm::StringRef const buffer =
+        sourceManager_->getBufferData(id, &invalid);
+    if(invalid || end > buffer.size())
+        return {};
+    llvm::StringRef const text = buffer.slice(begin, end);
+    if(text.size() <= SourceText::InlineSize)
+        return SourceText(text.str());
+    std::uint32_t const file = getSourceFileIndex(id);
+    if(file == 0)
+        return SourceText(text.str());
+    return SourceText(file, begin, text.size());
+}
+
+std::uint32_t
+ASTVisitor::
+getSourceFileIndex(
+    FileID id)
+{
+    auto [it, inserted] = sourceFiles_.try_emplace(id, 0);
+    if(! inserted)
+        return it->second;
+    // the text of a file which was replaced in
+    // memory cannot be read back from the disk
+    auto FE = sourceManager_->getFileEntryRefForID(id);
+    if(! FE || sourceManager_->isFileOverridden(*FE))
+        return 0;
+    llvm::StringRef const path =
+        FE->getFileEntry().tryGetRealPathName();
+    if(path.empty())
+        return 0;
+    it->second = getFileIndex(path);
+    return it->second;
 }
 
 //------------------------------------------------
@@ -179,6 +346,18 @@ makeTypeInfo(
     return I;
 }
 
+std::shared_ptr<TypeInfo>
+ASTVisitor::
+getTypeInfo(
+    QualType T)
+{
+    auto [it, inserted] = typeInfos_.try_emplace(
+        T.getAsOpaquePtr(), nullptr);
+    if(inserted)
+        it->second = buildTypeInfoForType(T);
+    return it->second;
+}
+
 std::unique_ptr<TypeInfo>
 ASTVisitor::
 buildTypeInfoForType(
@@ -535,7 +714,7 @@ parseParameters(
     for(const ParmVarDecl* P : D->parameters())
     {
         I.Params.emplace_back(
-            buildTypeInfoForType(P->getOriginalType()),
+            getTypeInfo(P->getOriginalType()),
             P->getNameAsString(),
             getSourceCode(P->getDefaultArgRange()));
     }
@@ -559,7 +738,7 @@ buildTemplateParam(
             TypeTParam>();
         if(TP->hasDefaultArgument())
         {
-            extinfo.Default = buildTypeInfoForType(
+            extinfo.Default = getTypeInfo(
                 TP->getDefaultArgument());
         }
     }
@@ -568,7 +747,7 @@ buildTemplateParam(
     {
         auto& extinfo = info.emplace<
             NonTypeTParam>();
-        extinfo.Type = buildTypeInfoForType(
+        extinfo.Type = getTypeInfo(
             TP->getType());
         if(TP->hasDefaultArgument())
         {
@@ -612,6 +791,8 @@ buildTemplateArgs(
     // the argument as written when it is not dependent and is a type.
     // FIXME: constant folding behavior should be consistent with that of other
     // constructs, e.g. noexcept specifiers & explicit specifiers
+    if(! ex_.facets().templateArgs)
+        return;
     const auto& policy = astContext_->getPrintingPolicy();
     for(const TemplateArgument& arg : range)
     {
@@ -774,37 +955,78 @@ parseRawComment(
     // ASTContext::getCommentForDecl instead
     RawComment* RC =
         D->getASTContext().getRawCommentForDeclNoCache(D);
-    parseJavadoc(javadoc, RC, D, config_);
+    parseJavadoc(javadoc, RC, D, config_, ex_.javadocs());
+}
+
+void
+ASTVisitor::
+parseJavadocs(
+    Info& I,
+    Decl const* D)
+{
+    // do not extract javadocs for namespaces
+    if(I.isNamespace() || ! ex_.facets().javadoc)
+        return;
+    parseRawComment(I.javadoc, D);
+    if(auto const* ED = dyn_cast<EnumDecl>(D))
+    {
+        auto& members = static_cast<EnumInfo&>(I).Members;
+        std::size_t i = 0;
+        for(const EnumConstantDecl* E : ED->enumerators())
+            parseRawComment(members[i++].javadoc, E);
+    }
 }
 
 //------------------------------------------------
 
 template<class Child>
 requires std::derived_from<Child, Info>
-static
-Bitcode
-writeParent(
+void
+ASTVisitor::
+insertParent(
     Child const& I,
     bool parent_is_record)
 {
     MRDOX_ASSERT(! I.Namespace.empty());
-    // Create an dummy parent and insert the child
-    // Then return the parent as a serialized bitcode.
+    // Insert the child into a dummy parent, which
+    // holds every child of the parent found in
+    // this translation unit.
+    SymbolID const& id = I.Namespace.front();
     if(parent_is_record)
     {
         MRDOX_ASSERT(Child::isSpecialization() ||
             I.Access != AccessKind::None);
-        RecordInfo P(I.Namespace.front());
-        insertChild<Child>(P, I.id);
-        return writeBitcode(P);
+        auto it = parentRecords_.try_emplace(
+            std::string_view(id), id).first;
+        insertChild<Child>(it->second, I.id);
     }
     else
     {
         MRDOX_ASSERT(I.Access == AccessKind::None);
-        NamespaceInfo P(I.Namespace.front());
-        insertChild<Child>(P, I.id);
-        return writeBitcode(P);
+        auto it = parentNamespaces_.try_emplace(
+            std::string_view(id), id).first;
+        insertChild<Child>(it->second, I.id);
+    }
+}
+
+void
+ASTVisitor::
+writeParents()
+{
+    // a child can be found more than once,
+    // for example when it is redeclared
+    for(auto& entry : parentNamespaces_)
+    {
+        canonicalize(entry.second);
+        insertBitcode(serializer_.write(entry.second));
     }
+    for(auto& entry : parentRecords_)
+    {
+        canonicalize(entry.second);
+        insertBitcode(serializer_.write(entry.second));
+    }
+    parentNamespaces_.clear();
+    parentRecords_.clear();
 }
 
 void
@@ -823,13 +1045,12 @@ parseEnumerators(
             E->getInitExpr(),
             E->getInitVal());
 
-        parseRawComment(I.Members.back().javadoc, E);
     }
 }
 
 //------------------------------------------------
 
-// This also sets IsFileInRootDir
+// This also sets File_ and FileIndex_
 bool
 ASTVisitor::
 shouldExtract(
@@ -844,30 +1065,40 @@ shouldExtract(
     // we should never visit block scope declarations
     MRDOX_ASSERT(! D->getParentFunctionOrMethod());
 
-    const PresumedLoc loc =
-        sourceManager_->getPresumedLoc(D->getBeginLoc());
-
-    auto [it, inserted] = fileFilter_.emplace(
-        loc.getIncludeLoc().getRawEncoding(),
-        FileFilter());
-
+    // the decision is made once per file, so
+    // the common case does no string work
+    FileID const id = sourceManager_->getFileID(
+        sourceManager_->getExpansionLoc(D->getBeginLoc()));
+    auto [it, inserted] = fileFilter_.try_emplace(id);
     FileFilter& ff = it->second;
-    File_ = files::makePosixStyle(loc.getFilename());
 
     // file has not been previously visited
     if(inserted)
-        ff.include = config_.shouldExtractFromFile(File_, ff.prefix);
+    {
+        const PresumedLoc loc =
+            sourceManager_->getPresumedLoc(D->getBeginLoc());
+        ff.file = files::makePosixStyle(loc.getFilename());
+        ff.include = config_.shouldExtractFromFile(ff.file, ff.prefix);
+        // VFALCO we could assert that the prefix
+        //        matches and just lop off the
+        //        first ff.prefix.size() characters.
+        if(ff.include)
+        {
+            llvm::SmallString<512> file(ff.file);
+            path::replace_path_prefix(file, ff.prefix, "");
+            ff.file = file.str();
+        }
+        ff.inRootDir = true;
+        ff.index = getFileIndex(ff.file, ff.inRootDir);
+    }
 
     // don't extract if the declaration is in a file
     // that should not be visited
     if(! ff.include)
         return false;
-    // VFALCO we could assert that the prefix
-    //        matches and just lop off the
-    //        first ff.prefix.size() characters.
-    path::replace_path_prefix(File_, ff.prefix, "");
 
-    IsFileInRootDir_ = true;
+    File_ = ff.file;
+    FileIndex_ = ff.index;
 
     return true;
 }
@@ -883,9 +1114,6 @@ extractInfo(
     if(! extractSymbolID(D, I.id))
         return false;
     I.Name = extractName(D);
-    // do not extract javadocs for namespaces
-    if(! I.isNamespace())
-        parseRawComment(I.javadoc, D);
     return true;
 }
 
@@ -953,9 +1181,20 @@ getParentNamespaces(
     std::vector<SymbolID>& Namespaces,
     const Decl* D)
 {
+    // siblings share the chain of their context
+    const DeclContext* const context = D->getDeclContext();
+    if(auto it = parentChains_.find(context);
+        it != parentChains_.end())
+    {
+        Namespaces.insert(Namespaces.end(),
+            it->second.begin(), it->second.end());
+        return false;
+    }
+    std::size_t const first = Namespaces.size();
+
     bool member_specialization = false;
     const Decl* child = D;
-    const DeclContext* parent_context = child->getDeclContext();
+    const DeclContext* parent_context = context;
     do
     {
         const Decl* parent = cast<Decl>(parent_context);
@@ -1015,6 +1254,13 @@ getParentNamespaces(
         child = parent;
     }
     while((parent_context = parent_context->getParent()));
+
+    // a member specialization builds the
+    // specialization of its own parent,
+    // so its chain is not reused
+    if(! member_specialization)
+        parentChains_.try_emplace(context,
+            Namespaces.begin() + first, Namespaces.end());
     return member_specialization;
 }
 
@@ -1044,10 +1290,9 @@ buildSpecialization(
 
     bool member_spec = getParentNamespaces(I.Namespace, P);
 
-    insertBitcode(ex_, writeBitcode(I));
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            P->getDeclContext()->isRecord()));
+        insertParent(I, P->getDeclContext()->isRecord());
             // ! P->getDeclContext()->isFileContext()));
 
 }
@@ -1068,7 +1313,7 @@ extractBases(
     for(CXXBaseSpecifier const& B : D->bases())
     {
         I.Bases.emplace_back(
-            buildTypeInfoForType(B.getType()),
+            getTypeInfo(B.getType()),
             convertToAccessKind(
                 B.getAccessSpecifier()),
             B.isVirtual());
@@ -1083,13 +1328,13 @@ buildRecord(
     RecordInfo& I,
     CXXRecordDecl* D)
 {
-    if(! extractInfo(I, D))
+    if(! extractInfo(I, D) || isDuplicate(I.id, D))
         return;
     int line = getLine(D);
     if(D->isThisDeclarationADefinition())
-        I.DefLoc.emplace(line, File_.str(), IsFileInRootDir_);
+        I.DefLoc.emplace(line, FileIndex_);
     else
-        I.Loc.emplace_back(line, File_.str(), IsFileInRootDir_);
+        I.Loc.emplace_back(line, FileIndex_);
 
     I.KeyKind = convertToRecordKeyKind(D->getTagKind());
 
@@ -1108,10 +1353,11 @@ buildRecord(
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            D->getDeclContext()->isRecord()));
+        insertParent(I, D->getDeclContext()->isRecord());
 }
 
 //------------------------------------------------
@@ -1121,21 +1367,24 @@ bool
 ASTVisitor::
 constructFunction(
     FunctionInfo& I,
-    DeclTy* D)
+    DeclTy* D,
+    bool checkDuplicate)
 {
     // adjust parameter types
     applyDecayToParameters(D);
     if(! extractInfo(I, D))
         return false;
+    if(checkDuplicate && isDuplicate(I.id, D))
+        return false;
     // if(name)
     //     I.Name = name;
     int line = getLine(D);
     if(D->isThisDeclarationADefinition())
-        I.DefLoc.emplace(line, File_.str(), IsFileInRootDir_);
+        I.DefLoc.emplace(line, FileIndex_);
     else
-        I.Loc.emplace_back(line, File_.str(), IsFileInRootDir_);
+        I.Loc.emplace_back(line, FileIndex_);
     parseParameters(I, D);
-    I.ReturnType = buildTypeInfoForType(
+    I.ReturnType = getTypeInfo(
         D->getReturnType());
 
     if(const auto* ftsi = D->getTemplateSpecializationInfo())
@@ -1253,7 +1502,7 @@ buildNamespace(
     NamespaceInfo& I,
     NamespaceDecl* D)
 {
-    if(! extractInfo(I, D))
+    if(! extractInfo(I, D) || isDuplicate(I.id, D))
         return;
 
     I.specs.isAnonymous = D->isAnonymousNamespace();
@@ -1261,9 +1510,11 @@ buildNamespace(
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I, false));
+        insertParent(I, false);
 }
 
 void
@@ -1279,7 +1530,7 @@ buildFriend(
             if(! shouldExtract(FD))
                 return;
             FunctionInfo I;
-            if(! constructFunction(I, FD))
+            if(! constructFunction(I, FD, false))
                 return;
 #if 0
             SymbolID id;
@@ -1307,10 +1558,11 @@ buildFriend(
             getParentNamespaces(I.Namespace, FD);
             getParentNamespaces(P.Namespace, ND);
 #endif
-            insertBitcode(ex_, writeBitcode(I));
-            insertBitcode(ex_, writeParent(I, false));
-            insertBitcode(ex_, writeBitcode(P));
-            insertBitcode(ex_, writeParent(P, false));
+            parseJavadocs(I, FD);
+            insertBitcode(writeBitcode(I));
+            insertParent(I, false);
+            insertBitcode(writeBitcode(P));
+            insertParent(P, false);
             return;
         }
         if(FunctionTemplateDecl* FT = dyn_cast<FunctionTemplateDecl>(ND))
@@ -1346,26 +1598,27 @@ buildEnum(
     EnumInfo& I,
     EnumDecl* D)
 {
-    if(! extractInfo(I, D))
+    if(! extractInfo(I, D) || isDuplicate(I.id, D))
         return;
     int line = getLine(D);
     if(D->isThisDeclarationADefinition())
-        I.DefLoc.emplace(line, File_.str(), IsFileInRootDir_);
+        I.DefLoc.emplace(line, FileIndex_);
     else
-        I.Loc.emplace_back(line, File_.str(), IsFileInRootDir_);
+        I.Loc.emplace_back(line, FileIndex_);
     I.Scoped = D->isScoped();
     if(D->isFixed())
-        I.UnderlyingType = buildTypeInfoForType(
+        I.UnderlyingType = getTypeInfo(
             D->getIntegerType());
 
     parseEnumerators(I, D);
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            D->getDeclContext()->isRecord()));
+        insertParent(I, D->getDeclContext()->isRecord());
 }
 
 void
@@ -1374,12 +1627,12 @@ buildField(
     FieldInfo& I,
     FieldDecl* D)
 {
-    if(! extractInfo(I, D))
+    if(! extractInfo(I, D) || isDuplicate(I.id, D))
         return;
     int line = getLine(D);
-    I.DefLoc.emplace(line, File_.str(), IsFileInRootDir_);
+    I.DefLoc.emplace(line, FileIndex_);
 
-    I.Type = buildTypeInfoForType(D->getType());
+    I.Type = getTypeInfo(D->getType());
 
     I.IsMutable = D->isMutable();
 
@@ -1397,10 +1650,11 @@ buildField(
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            D->getDeclContext()->isRecord()));
+        insertParent(I, D->getDeclContext()->isRecord());
 }
 
 void
@@ -1409,15 +1663,15 @@ buildVar(
     VariableInfo& I,
     VarDecl* D)
 {
-    if(! extractInfo(I, D))
+    if(! extractInfo(I, D) || isDuplicate(I.id, D))
         return;
     int line = getLine(D);
     if(D->isThisDeclarationADefinition())
-        I.DefLoc.emplace(line, File_.str(), IsFileInRootDir_);
+        I.DefLoc.emplace(line, FileIndex_);
     else
-        I.Loc.emplace_back(line, File_.str(), IsFileInRootDir_);
+        I.Loc.emplace_back(line, FileIndex_);
 
-    I.Type = buildTypeInfoForType(D->getType());
+    I.Type = getTypeInfo(D->getType());
 
     I.specs.storageClass =
         convertToStorageClassKind(
@@ -1440,10 +1694,11 @@ buildVar(
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            D->getDeclContext()->isRecord()));
+        insertParent(I, D->getDeclContext()->isRecord());
 }
 
 template<class DeclTy>
@@ -1453,15 +1708,16 @@ buildFunction(
     FunctionInfo& I,
     DeclTy* D)
 {
-    if(! constructFunction(I, D))
+    if(! constructFunction(I, D, true))
         return;
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            D->getDeclContext()->isRecord()));
+        insertParent(I, D->getDeclContext()->isRecord());
 }
 
 template<class DeclTy>
@@ -1471,9 +1727,9 @@ buildTypedef(
     TypedefInfo& I,
     DeclTy* D)
 {
-    if(! extractInfo(I, D))
+    if(! extractInfo(I, D) || isDuplicate(I.id, D))
         return;
-    I.Type = buildTypeInfoForType(
+    I.Type = getTypeInfo(
         D->getUnderlyingType());
 
 #if 0
@@ -1490,16 +1746,17 @@ buildTypedef(
 
     int line = getLine(D);
     // D->isThisDeclarationADefinition(); // not available
-    I.DefLoc.emplace(line, File_.str(), IsFileInRootDir_);
+    I.DefLoc.emplace(line, FileIndex_);
     // KRYSTIAN NOTE: IsUsing is set by TraverseTypeAlias
     // I.IsUsing = std::is_same_v<DeclTy, TypeAliasDecl>;
 
     bool member_spec = getParentNamespaces(I.Namespace, D);
 
-    insertBitcode(ex_, writeBitcode(I));
+    parseJavadocs(I, D);
+
+    insertBitcode(writeBitcode(I));
     if(! member_spec)
-        insertBitcode(ex_, writeParent(I,
-            D->getDeclContext()->isRecord()));
+        insertParent(I, D->getDeclContext()->isRecord());
 }
 
 //------------------------------------------------
@@ -1772,8 +2029,14 @@ traverse(ClassTemplateDecl* D,
     if(! shouldExtract(RD))
         return true;
 
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateParams(*Template, RD);
+    // the template is not needed when the
+    // record is dropped as a duplicate
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(RD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateParams(*Template, RD);
+    }
 
     return traverse(RD, A, std::move(Template));
 }
@@ -1786,9 +2049,13 @@ traverse(ClassTemplateSpecializationDecl* D)
     if(! shouldExtract(RD))
         return true;
 
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateParams(*Template, RD);
-    parseTemplateArgs(*Template, D);
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(RD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateParams(*Template, RD);
+        parseTemplateArgs(*Template, D);
+    }
 
     // determine the access from the primary template
     return traverse(RD,
@@ -1805,8 +2072,12 @@ traverse(VarTemplateDecl* D,
     if(! shouldExtract(VD))
         return true;
 
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateParams(*Template, VD);
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(VD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateParams(*Template, VD);
+    }
 
     return traverse(VD, A, std::move(Template));
 }
@@ -1819,9 +2090,13 @@ traverse(VarTemplateSpecializationDecl* D)
     if(! shouldExtract(VD))
         return true;
 
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateParams(*Template, VD);
-    parseTemplateArgs(*Template, D);
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(VD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateParams(*Template, VD);
+        parseTemplateArgs(*Template, D);
+    }
 
     return traverse(VD,
         D->getSpecializedTemplate()->getAccessUnsafe(),
@@ -1839,8 +2114,15 @@ traverse(FunctionTemplateDecl* D,
     // (e.g. for an abbreviated function template with no template-head)
     if(! shouldExtract(FD))
         return true;
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateParams(*Template, FD);
+    // the symbol ID of a function depends
+    // on the adjusted parameter types
+    applyDecayToParameters(FD);
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(FD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateParams(*Template, FD);
+    }
 
     // traverse the templated declaration according to its kind
     return traverseDecl(FD, std::move(Template));
@@ -1862,11 +2144,16 @@ traverse(ClassScopeFunctionSpecializationDecl* D)
        the primary template, but this is only possible when none of the candidates are dependent
        upon a template parameter of the enclosing class template.
     */
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateArgs(*Template, D);
-
     CXXMethodDecl* MD = D->getSpecialization();
 
+    applyDecayToParameters(MD);
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(MD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateArgs(*Template, D);
+    }
+
     // since the templated CXXMethodDecl may be a constructor
     // or conversion function, call TraverseDecl to ensure that
     // we call traverse for the dynamic type of the CXXMethodDecl
@@ -1882,8 +2169,12 @@ traverse(TypeAliasTemplateDecl* D,
     if(! shouldExtract(AD))
         return true;
 
-    auto Template = std::make_unique<TemplateInfo>();
-    parseTemplateParams(*Template, AD);
+    std::unique_ptr<TemplateInfo> Template;
+    if(! isDuplicateTemplated(AD))
+    {
+        Template = std::make_unique<TemplateInfo>();
+        parseTemplateParams(*Template, AD);
+    }
 
     return traverse(AD, A, std::move(Template));
 }
@@ -1907,8 +2198,13 @@ traverseDecl(
     Args&&... args)
 {
     MRDOX_ASSERT(D);
+    MRDOX_PROFILE_ZONE("traverseDecl");
+    ++declsVisited_;
     if(D->isInvalidDecl() || D->isImplicit())
         return true;
+    // an imported module is not visited by every importer
+    if(D->isFromASTFile() && isExtractedElsewhere(D))
+        return true;
 
     AccessSpecifier access =
         D->getAccessUnsafe();
@@ -2071,21 +2367,25 @@ HandleTranslationUnit(
     // as those set by Initialize and InitializeSema
     MRDOX_ASSERT(astContext_ == &Context);
     MRDOX_ASSERT(sema_);
+    auto const visitStart = std::chrono::steady_clock::now();
 
     // Install handlers for our custom commands
     initCustomCommentCommands(Context);
 
+    // TUs excluded by the configuration are
+    // filtered by the ToolExecutor before parsing.
     std::optional<llvm::StringRef> filePath =
         Context.getSourceManager().getNonBuiltinFilenameForID(
             Context.getSourceManager().getMainFileID());
     if(! filePath)
         return;
-
-    // Filter out TUs we don't care about
-    File_ = *filePath;
-    convert_to_slash(File_);
-    if(! config_.shouldVisitTU(File_))
+    // a jumbo unit with errors is parsed
+    // again one file at a time, so its
+    // partial results are not reported
+    if(JumboDatabase::isUnit(*filePath) &&
+        Context.getDiagnostics().hasErrorOccurred())
         return;
+    TraceScope trace("visit", *filePath);
 
     TranslationUnitDecl* TU =
         Context.getTranslationUnitDecl();
@@ -2097,13 +2397,87 @@ HandleTranslationUnit(
         std::vector<Decl*>{TU});
 
     for(auto* C : TU->decls())
+    {
+        if(isPastDeadline())
+            return;
         traverseDecl(C);
+    }
+    if(isPastDeadline())
+        return;
+    writeParents();
+
+    std::string batch;
+    if(! batch_.empty())
+        batch = batch_.finish();
+
+    // The memory of the parse, which is most
+    // of what a translation unit needs, is the
+    // estimate used by the memory budget.
+    {
+        SourceManager const& SM = Context.getSourceManager();
+        setTranslationUnitBytes(
+            Context.getASTAllocatedMemory() +
+            Context.getSideTableAllocatedMemory() +
+            SM.getContentCacheSize() +
+            SM.getDataStructureSizes() +
+            sema_->getPreprocessor().getTotalMemory());
+    }
+
+    // Record every file read by the translation
+    // unit so that the cached results can be
+    // invalidated when any of them change.
+    if(TUCache* cache = ex_.cache())
+    {
+        SourceManager& SM = Context.getSourceManager();
+        for(auto it = SM.fileinfo_begin();
+            it != SM.fileinfo_end(); ++it)
+        {
+            SrcMgr::ContentCache const* CC = it->second;
+            if(! CC->OrigEntry)
+                continue;
+            auto data = CC->getBufferDataIfLoaded();
+            if(! data)
+                continue;
+            llvm::SmallString<256> path(CC->OrigEntry->getName());
+            SM.getFileManager().makeAbsolutePath(path);
+            llvm::sys::path::remove_dots(path, true);
+            cacheEntry_.deps.push_back({
+                std::string(path.str()),
+                TUCache::hashContents(*data) });
+        }
+        cacheEntry_.bitcodes = batch;
+        cache->record(*filePath, std::move(cacheEntry_));
+    }
+    if(! config_.tuStats_.empty())
+    {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        ExecutionContext::TUStats stats;
+        stats.file = filePath->str();
+        stats.parseMs = milliseconds(visitStart - start_).count();
+        stats.visitMs = milliseconds(
+            std::chrono::steady_clock::now() - visitStart).count();
+        stats.declsVisited = declsVisited_;
+        stats.declsExtracted = declsExtracted_;
+        stats.bitcodes = bitcodes_;
+        stats.bitcodeBytes = batch.size();
+        ex_.reportTUStats(std::move(stats));
+    }
+    if(! batch.empty())
+    {
+        ex_.reportBitcodeBytes(batch.size());
+        insertBitcodes(ex_, *filePath, std::move(batch));
+    }
+    // the keys are published only with the results,
+    // so returning early above withholds neither
+    ex_.publishEmitted(emitted_);
 
     // VFALCO If we returned from the function early
     // then this line won't execute, which means we
     // will miss error and warnings emitted before
     // the return.
     ex_.report(std::move(diags_));
+    ex_.reportSymbolIDs(symbolIDHits_, symbolIDMisses_);
+    ex_.reportInstantiationsSkipped(instantiationsSkipped_);
 }
 
 void
@@ -2130,6 +2504,54 @@ ForgetSema()
     sema_ = nullptr;
 }
 
+bool
+ASTVisitor::
+HandleTopLevelDecl(DeclGroupRef D)
+{
+    // Sema queues the definitions used by each top
+    // level declaration and instantiates them at the
+    // end of the translation unit. They only add
+    // decls which are never extracted.
+    if(config_.skipInstantiations_ && sema_)
+    {
+        instantiationsSkipped_ +=
+            sema_->PendingInstantiations.size();
+        sema_->PendingInstantiations.clear();
+    }
+    // the parser stops when this returns false
+    return ! isPastDeadline();
+}
+
+bool
+ASTVisitor::
+isPastDeadline()
+{
+    if(timedOut_)
+        return true;
+    if(deadline_ == std::chrono::steady_clock::time_point::max() ||
+        std::chrono::steady_clock::now() < deadline_)
+        return false;
+    timedOut_ = true;
+
+    auto& DE = compiler_.getDiagnostics();
+    DE.Report(DE.getCustomDiagID(DiagnosticsEngine::Fatal,
+        "the translation unit ran out of time"));
+
+    SourceManager const& SM = compiler_.getSourceManager();
+    std::optional<llvm::StringRef> filePath =
+        SM.getNonBuiltinFilenameForID(SM.getMainFileID());
+    std::string file = filePath ? filePath->str() : std::string();
+    ex_.reportTimedOut(file);
+    // the results end here, so the
+    // diagnostics so far are reported now
+    diags_.reportWarning(fmt::format(
+        "{}: gave up after {:.1f} seconds", file,
+        std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_).count()));
+    ex_.report(std::move(diags_));
+    return true;
+}
+
 void
 ASTVisitor::
 HandleCXXStaticMemberVarInstantiation(VarDecl* D)
@@ -2146,6 +2568,8 @@ ASTVisitor::
 HandleCXXImplicitFunctionInstantiation(FunctionDecl* D)
 {
     D->setImplicit();
+    // a runaway instantiation is stopped here
+    isPastDeadline();
 }
 
 } // mrdox
@@ -13,12 +13,21 @@
 #ifndef MRDOX_TOOL_AST_ASTVISITOR_HPP
 #define MRDOX_TOOL_AST_ASTVISITOR_HPP
 
+#include "AST/Bitcode.hpp"
 #include "Tool/ConfigImpl.hpp"
 #include "Tool/Diagnostics.hpp"
 #include "Tool/ExecutionContext.hpp"
+#include "Tool/TUCache.hpp"
 #include <mrdox/MetadataFwd.hpp>
+#include <mrdox/Metadata/Namespace.hpp>
+#include <mrdox/Metadata/Record.hpp>
 #include <clang/Sema/SemaConsumer.h>
 #include <clang/Tooling/Execution.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <chrono>
+#include <concepts>
 #include <optional>
 #include <unordered_map>
 
@@ -41,10 +50,15 @@ class ASTVisitor
     : public SemaConsumer
 {
 public:
+    /** The extraction decision for one file.
+    */
     struct FileFilter
     {
         std::string prefix;
+        std::string file;
         bool include = true;
+        bool inRootDir = true;
+        std::uint32_t index = 0;
     };
 
     ExecutionContext& ex_;
@@ -57,20 +71,157 @@ public:
     Sema* sema_ = nullptr;
 
     llvm::SmallString<512> File_;
-    bool IsFileInRootDir_;
+    std::uint32_t FileIndex_ = 0;
 
     llvm::SmallString<128> usr_;
 
-    std::unordered_map<
-        clang::SourceLocation::UIntTy,
+    // SymbolIDs keyed on the canonical declaration,
+    // where a zero ID means no USR could be generated
+    llvm::DenseMap<const Decl*, SymbolID> symbolIDs_;
+
+    // the IDs of the enclosing scopes of each
+    // context, innermost first, when no member
+    // specialization is involved
+    llvm::DenseMap<const DeclContext*,
+        std::vector<SymbolID>> parentChains_;
+    std::size_t symbolIDHits_ = 0;
+    std::size_t symbolIDMisses_ = 0;
+    std::size_t instantiationsSkipped_ = 0;
+
+    // the consumer is made just before parsing
+    // starts, so this is the start of the parse
+    std::chrono::steady_clock::time_point start_;
+    // the earlier of the time limit of the
+    // translation unit and the global deadline
+    std::chrono::steady_clock::time_point deadline_;
+    bool timedOut_ = false;
+    std::size_t declsVisited_ = 0;
+    std::size_t declsExtracted_ = 0;
+    std::size_t bitcodes_ = 0;
+
+    // TypeInfo keyed on the QualType as written,
+    // including its fast qualifiers
+    llvm::DenseMap<void*, std::shared_ptr<TypeInfo>> typeInfos_;
+
+    llvm::DenseMap<
+        clang::FileID,
         FileFilter> fileFilter_;
 
+    // the file table index of the full path of
+    // each file, or zero if it cannot be reread
+    llvm::DenseMap<clang::FileID, std::uint32_t> sourceFiles_;
+
+    // whether the declarations of each
+    // imported module are skipped
+    llvm::DenseMap<Module const*, bool> moduleFilter_;
+
+    // whether each declaration asked about
+    // was already emitted by another TU
+    llvm::DenseMap<Decl const*, bool> duplicates_;
+
+    // the keys of the declarations emitted by
+    // this TU, published with its results
+    llvm::StringSet<> emitted_;
+
+    // bitcodes kept for the translation
+    // unit cache, when it is enabled
+    TUCache::Entry cacheEntry_;
+
+    // reused for every bitcode written by this visitor
+    BitcodeSerializer serializer_;
+
+    // every bitcode of the translation unit,
+    // reported as one result at the end
+    BitcodeBatch batch_;
+
+    // the children of each parent, keyed on the
+    // ID of the parent, which are written as one
+    // bitcode per parent at the end
+    llvm::StringMap<NamespaceInfo> parentNamespaces_;
+    llvm::StringMap<RecordInfo> parentRecords_;
+
 public:
     ASTVisitor(
         tooling::ExecutionContext& ex,
         ConfigImpl const& config,
         clang::CompilerInstance& compiler) noexcept;
 
+    /** Append bitcode to the batch of the translation unit.
+
+        The batch is inserted into the tool results
+        when the translation unit is finished.
+    */
+    void
+    insertBitcode(
+        Bitcode&& bitcode);
+
+    /** Add a symbol to the members of its parent.
+
+        The parent is written by @ref writeParents.
+    */
+    template<class Child>
+    requires std::derived_from<Child, Info>
+    void
+    insertParent(
+        Child const& I,
+        bool parent_is_record);
+
+    /** Append the bitcode of every parent to the batch.
+    */
+    void
+    writeParents();
+
+    /** Return the serialized bitcode for a metadata node.
+    */
+    Bitcode
+    writeBitcode(
+        Info const& I)
+    {
+        ++declsExtracted_;
+        return serializer_.write(I);
+    }
+
+    /** Return true if another TU already emitted this declaration.
+
+        Declarations are identified by their symbol
+        ID and location. Whether the declaration is
+        a definition or has documentation is part of
+        the key, so new information is never dropped.
+        Only the symbol ID is needed, so this is
+        checked before the types, parameters, and
+        javadoc are extracted, since most copies of
+        a header declaration are dropped.
+    */
+    bool
+    isDuplicate(
+        SymbolID const& id,
+        const Decl* D);
+
+    /** Return true if the templated declaration of a template is a duplicate.
+
+        This is asked before the template parameters
+        and arguments are extracted, which are
+        discarded with the declaration. The answer
+        is kept for when the declaration is built.
+    */
+    bool
+    isDuplicateTemplated(
+        const NamedDecl* D);
+
+    /** Return true if another TU extracts this imported declaration.
+
+        The declarations of a named module are
+        extracted from its interface, when it is
+        a translation unit of the run. Those of other
+        modules, such as header units, are extracted
+        by the first translation unit to import them.
+        Declarations from a precompiled header belong
+        to no module and are always extracted.
+    */
+    bool
+    isExtractedElsewhere(
+        const Decl* D);
+
     bool
     extractSymbolID(
         const Decl* D,
@@ -100,10 +251,14 @@ public:
     getLine(
         const NamedDecl* D) const;
 
-    std::string
+    SourceText
     getSourceCode(
         SourceRange const& R);
 
+    std::uint32_t
+    getSourceFileIndex(
+        FileID id);
+
     std::string
     getTypeAsString(
         QualType T);
@@ -129,6 +284,15 @@ public:
         QualType T,
         unsigned quals = 0);
 
+    /** Return the TypeInfo for a type, built once per translation unit.
+
+        Every use of the same type in the translation
+        unit shares the returned node, which must not
+        be modified.
+    */
+    std::shared_ptr<TypeInfo>
+    getTypeInfo(QualType T);
+
     template<typename Integer>
     Integer
     getValue(const llvm::APInt& V);
@@ -200,6 +364,16 @@ public:
         std::unique_ptr<Javadoc>& javadoc,
         Decl const* D);
 
+    /** Parse the javadocs of a declaration which is kept.
+
+        For an enum, the javadocs of the
+        enumerators are parsed as well.
+    */
+    void
+    parseJavadocs(
+        Info& I,
+        Decl const* D);
+
     void
     parseEnumerators(
         EnumInfo& I,
@@ -223,7 +397,8 @@ public:
     template<class DeclTy>
     bool constructFunction(
         FunctionInfo& I,
-        DeclTy* D);
+        DeclTy* D,
+        bool checkDuplicate);
 
     template<class DeclTy>
     void buildFunction(
@@ -323,6 +498,26 @@ public:
     void InitializeSema(Sema& S) override;
     void ForgetSema() override;
 
+    /** Discard the pending implicit instantiations.
+
+        Only declarations are extracted, so the
+        definitions Sema would instantiate at the
+        end of the translation unit are not needed.
+        This is done when the configuration enables
+        `skip-instantiations`.
+    */
+    bool HandleTopLevelDecl(DeclGroupRef D) override;
+
+    /** Return true if the translation unit ran out of time.
+
+        The first time, a fatal error is reported
+        to clang, which then stops instantiating
+        templates, and the translation unit is
+        recorded as given up on. Its results are
+        not kept.
+    */
+    bool isPastDeadline();
+
     void HandleCXXStaticMemberVarInstantiation(VarDecl* D) override;
     void HandleCXXImplicitFunctionInstantiation(FunctionDecl* D) override;
 };
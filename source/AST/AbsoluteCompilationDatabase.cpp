@@ -13,11 +13,13 @@
 #include "Support/Debug.hpp"
 #include "Support/Path.hpp"
 #include "AST/AbsoluteCompilationDatabase.hpp"
+#include <mrdox/Support/ThreadPool.hpp>
 #include <fmt/format.h>
 #include <clang/Basic/LangStandard.h>
 #include <clang/Driver/Driver.h>
 #include <clang/Driver/Options.h>
 #include <clang/Driver/Types.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/Option/ArgList.h>
 #include <llvm/Option/OptSpecifier.h>
 #include <llvm/Option/OptTable.h>
@@ -178,81 +180,240 @@ adjustCommandLine(
     return new_cmdline;
 }
 
+/** Make a path absolute by resolving against the working directory.
+*/
+static
+void
+makeAbsolutePath(
+    std::string& s,
+    llvm::StringRef workingDir,
+    SmallPathString& temp)
+{
+    namespace fs = llvm::sys::fs;
+    namespace path = llvm::sys::path;
+
+    if(path::is_absolute(s))
+    {
+        path::native(s, temp);
+    }
+    else
+    {
+        temp = s;
+        fs::make_absolute(workingDir, temp);
+        path::remove_dots(temp, true);
+    }
+    s.assign(temp.data(), temp.size());
+}
+
 AbsoluteCompilationDatabase::
 AbsoluteCompilationDatabase(
     llvm::StringRef workingDir,
     CompilationDatabase const& inner,
     std::shared_ptr<const Config> config)
+    : AbsoluteCompilationDatabase(
+        workingDir,
+        inner.getAllCompileCommands(),
+        std::move(config))
 {
-    namespace fs = llvm::sys::fs;
-    namespace path = llvm::sys::path;
-    auto config_impl = std::dynamic_pointer_cast<
-        const ConfigImpl>(config);
+}
+
+AbsoluteCompilationDatabase::
+AbsoluteCompilationDatabase(
+    llvm::StringRef workingDir,
+    std::vector<tooling::CompileCommand> commands,
+    std::shared_ptr<const Config> config)
+{
+    llvm::StringMap<std::uint32_t> flagSets;
+    append(workingDir, std::move(commands), *config, flagSets);
+}
+
+AbsoluteCompilationDatabase::
+AbsoluteCompilationDatabase(
+    std::vector<Source> sources,
+    std::shared_ptr<const Config> config)
+{
+    // the templates are shared by every database
+    llvm::StringMap<std::uint32_t> flagSets;
+    for(auto& source : sources)
+        append(source.workingDir,
+            std::move(source.commands), *config, flagSets);
+}
 
-    auto allCommands = inner.getAllCompileCommands();
-    AllCommands_.reserve(allCommands.size());
-    SmallPathString temp;
-    for(auto const& cmd0 : allCommands)
+void
+AbsoluteCompilationDatabase::
+append(
+    llvm::StringRef workingDir,
+    std::vector<tooling::CompileCommand> commands,
+    Config const& config,
+    llvm::StringMap<std::uint32_t>& flagSets)
+{
+    auto const& defines = static_cast<
+        ConfigImpl const&>(config).additionalDefines_;
+
+    // adjust in batches, keeping the order of the
+    // commands so the first one for a file is used
+    constexpr std::size_t grain = 64;
+    std::vector<char> isCXX(commands.size());
+    std::vector<std::string> fileArgs(commands.size());
+    TaskGroup taskGroup(config.threadPool());
+    for(std::size_t first = 0; first < commands.size(); first += grain)
     {
-        tooling::CompileCommand cmd;
+        taskGroup.async(
+            [&, first]
+            {
+                std::size_t const last =
+                    std::min(first + grain, commands.size());
+                SmallPathString temp;
+                for(std::size_t i = first; i < last; ++i)
+                {
+                    auto& cmd = commands[i];
+                    fileArgs[i] = cmd.Filename;
+                    makeAbsolutePath(cmd.Filename, workingDir, temp);
 
-        cmd.CommandLine = cmd0.CommandLine;
-        cmd.Heuristic = cmd0.Heuristic;
-        cmd.Output = cmd0.Output;
-        cmd.CommandLine = adjustCommandLine(
-            cmd0.CommandLine,
-            config_impl->additionalDefines_);
+                    // non-C++ input file; skip
+                    if(! isCXXSrcFile(cmd.Filename))
+                        continue;
+                    isCXX[i] = true;
+                    makeAbsolutePath(cmd.Directory, workingDir, temp);
+                    cmd.CommandLine = adjustCommandLine(
+                        cmd.CommandLine, defines);
+                }
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        Error(errors).Throw();
 
-        if(path::is_absolute(cmd0.Directory))
-        {
-            path::native(cmd0.Directory, temp);
-            cmd.Directory = static_cast<std::string>(temp);
-        }
-        else
-        {
-            temp = cmd0.Directory;
-            fs::make_absolute(workingDir, temp);
-            path::remove_dots(temp, true);
-            cmd.Directory = static_cast<std::string>(temp);
-        }
+    Entries_.reserve(Entries_.size() + commands.size());
+    for(std::size_t i = 0; i < commands.size(); ++i)
+    {
+        if(isCXX[i])
+            add(std::move(commands[i]),
+                std::move(fileArgs[i]), flagSets);
+    }
+}
 
-        if(path::is_absolute(cmd0.Filename))
-        {
-            path::native(cmd0.Filename, temp);
-            cmd.Filename = static_cast<std::string>(temp);
-        }
-        else
-        {
-            temp = cmd0.Filename;
-            fs::make_absolute(workingDir, temp);
-            path::remove_dots(temp, true);
-            cmd.Filename = static_cast<std::string>(temp);
-        }
+void
+AbsoluteCompilationDatabase::
+add(
+    tooling::CompileCommand&& cmd,
+    std::string&& fileArg,
+    llvm::StringMap<std::uint32_t>& flagSets)
+{
+    Entry e;
+    e.Directory = Strings_.save(cmd.Directory);
+    e.Heuristic = Strings_.save(cmd.Heuristic);
+    e.Output = std::move(cmd.Output);
+    e.FileArg = std::move(fileArg);
+    e.OutputArg = e.Output;
+    if(e.OutputArg.empty())
+    {
+        auto const it = std::find(
+            cmd.CommandLine.begin(), cmd.CommandLine.end(), "-o");
+        if(it != cmd.CommandLine.end() &&
+            it + 1 != cmd.CommandLine.end())
+            e.OutputArg = *(it + 1);
+    }
 
-        // non-C++ input file; skip
-        if(! isCXXSrcFile(cmd.Filename))
-            continue;
+    // Make the template. Any argument which ends
+    // with the value of a slot can be replaced, as
+    // the text is the rest of the argument.
+    auto const first = Args_.size();
+    std::string key;
+    for(std::string_view arg : cmd.CommandLine)
+    {
+        Arg a = { arg, Slot::None };
+        if(! e.FileArg.empty() && arg.ends_with(e.FileArg))
+            a = { arg.substr(0, arg.size() - e.FileArg.size()), Slot::File };
+        else if(! e.OutputArg.empty() && arg.ends_with(e.OutputArg))
+            a = { arg.substr(0, arg.size() - e.OutputArg.size()), Slot::Output };
+        a.text = Strings_.save(a.text);
+
+        // interned strings are equal when
+        // their addresses are equal
+        char const* const p = a.text.data();
+        key.append(reinterpret_cast<char const*>(&p), sizeof(p));
+        key.push_back(static_cast<char>(a.slot));
+        Args_.push_back(a);
+    }
+
+    auto const set = flagSets.try_emplace(key,
+        static_cast<std::uint32_t>(FlagSets_.size()));
+    if(set.second)
+    {
+        FlagSets_.push_back({
+            static_cast<std::uint32_t>(first),
+            static_cast<std::uint32_t>(Args_.size() - first) });
+    }
+    else
+    {
+        // the template is already stored
+        Args_.resize(first);
+    }
+    e.Flags = set.first->getValue();
 
-        std::size_t i = AllCommands_.size();
-        auto result = IndexByFile_.try_emplace(cmd.Filename, i);
-        if(result.second)
-            AllCommands_.emplace_back(std::move(cmd));
+    // The first command for a file is used. The
+    // same file compiled with other flags, as by
+    // another database, is counted as a conflict.
+    auto const result = IndexByFile_.try_emplace(
+        cmd.Filename, Entries_.size());
+    if(! result.second)
+    {
+        Entry const& prev = Entries_[result.first->getValue()];
+        if(prev.Flags != e.Flags || prev.Directory != e.Directory)
+            ++conflicts_;
+        return;
     }
+    e.Filename = result.first->getKey();
+    Entries_.emplace_back(std::move(e));
 }
 
-std::vector<tooling::CompileCommand>
+tooling::CompileCommand
 AbsoluteCompilationDatabase::
-getCompileCommands(
-    llvm::StringRef FilePath) const
+makeCommand(
+    Entry const& e) const
+{
+    tooling::CompileCommand cmd;
+    cmd.Directory = e.Directory.str();
+    cmd.Filename = e.Filename.str();
+    cmd.Output = e.Output;
+    cmd.Heuristic = e.Heuristic.str();
+    auto const& set = FlagSets_[e.Flags];
+    cmd.CommandLine.reserve(set.count);
+    for(auto const& a : llvm::ArrayRef<Arg>(Args_).slice(set.first, set.count))
+    {
+        std::string& arg = cmd.CommandLine.emplace_back(a.text.str());
+        if(a.slot == Slot::File)
+            arg += e.FileArg;
+        else if(a.slot == Slot::Output)
+            arg += e.OutputArg;
+    }
+    return cmd;
+}
+
+auto
+AbsoluteCompilationDatabase::
+find(
+    llvm::StringRef FilePath) const ->
+        std::optional<CommandView>
 {
     SmallPathString nativeFilePath;
     llvm::sys::path::native(FilePath, nativeFilePath);
 
     auto const it = IndexByFile_.find(nativeFilePath);
     if (it == IndexByFile_.end())
-        return {};
+        return std::nullopt;
+    return CommandView(*this, Entries_[it->getValue()]);
+}
+
+std::vector<tooling::CompileCommand>
+AbsoluteCompilationDatabase::
+getCompileCommands(
+    llvm::StringRef FilePath) const
+{
     std::vector<tooling::CompileCommand> Commands;
-    Commands.push_back(AllCommands_[it->getValue()]);
+    if(auto view = find(FilePath))
+        Commands.push_back(view->command());
     return Commands;
 }
 
@@ -261,9 +422,9 @@ AbsoluteCompilationDatabase::
 getAllFiles() const
 {
     std::vector<std::string> allFiles;
-    allFiles.reserve(AllCommands_.size());
-    for(auto const& cmd : AllCommands_)
-        allFiles.push_back(cmd.Filename);
+    allFiles.reserve(Entries_.size());
+    for(auto const& e : Entries_)
+        allFiles.push_back(e.Filename.str());
     return allFiles;
 }
 
@@ -271,7 +432,11 @@ std::vector<tooling::CompileCommand>
 AbsoluteCompilationDatabase::
 getAllCompileCommands() const
 {
-    return AllCommands_;
+    std::vector<tooling::CompileCommand> allCommands;
+    allCommands.reserve(Entries_.size());
+    for(auto const& e : Entries_)
+        allCommands.push_back(makeCommand(e));
+    return allCommands;
 }
 
 } // mrdox
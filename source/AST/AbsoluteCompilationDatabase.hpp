@@ -14,6 +14,10 @@
 #include <mrdox/Config.hpp>
 #include <clang/Tooling/JSONCompilationDatabase.h>
 #include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/StringSaver.h>
+#include <cstdint>
+#include <optional>
 #include <vector>
 
 namespace clang {
@@ -25,14 +29,133 @@ namespace mrdox {
     will be converted to absolute paths by resolving
     them according to the working directory specified
     at construction.
+
+    Most commands differ only in their input and
+    output files, so the command lines are kept as
+    templates where those arguments are replaced
+    by the values of each command. Every distinct
+    template and argument is stored once.
 */
 class AbsoluteCompilationDatabase
     : public tooling::CompilationDatabase
 {
-    std::vector<tooling::CompileCommand> AllCommands_;
+    enum class Slot : std::uint8_t
+    {
+        None,
+        File,
+        Output
+    };
+
+    // an argument of a template, which is the text
+    // followed by the value of the slot, if any
+    struct Arg
+    {
+        llvm::StringRef text;
+        Slot slot;
+    };
+
+    struct FlagSet
+    {
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    struct Entry
+    {
+        llvm::StringRef Filename;
+        llvm::StringRef Directory;
+        llvm::StringRef Heuristic;
+        std::string Output;
+        std::string FileArg;
+        std::string OutputArg;
+        std::uint32_t Flags;
+    };
+
+    llvm::BumpPtrAllocator Alloc_;
+    llvm::UniqueStringSaver Strings_{Alloc_};
+    std::vector<Arg> Args_;
+    std::vector<FlagSet> FlagSets_;
+    std::vector<Entry> Entries_;
     llvm::StringMap<std::size_t> IndexByFile_;
+    std::size_t conflicts_ = 0;
+
+    void append(llvm::StringRef workingDir,
+        std::vector<tooling::CompileCommand> commands,
+        Config const& config,
+        llvm::StringMap<std::uint32_t>& flagSets);
+
+    void add(tooling::CompileCommand&& cmd,
+        std::string&& fileArg,
+        llvm::StringMap<std::uint32_t>& flagSets);
+
+    tooling::CompileCommand
+    makeCommand(Entry const& e) const;
 
 public:
+    /** The commands of a database, and the directory they are relative to.
+    */
+    struct Source
+    {
+        std::string workingDir;
+        std::vector<tooling::CompileCommand> commands;
+    };
+
+    /** A compile command which refers to the database.
+    */
+    class CommandView
+    {
+        friend class AbsoluteCompilationDatabase;
+
+        AbsoluteCompilationDatabase const* db_;
+        Entry const* e_;
+
+        CommandView(
+            AbsoluteCompilationDatabase const& db,
+            Entry const& e) noexcept
+            : db_(&db)
+            , e_(&e)
+        {
+        }
+
+    public:
+        llvm::StringRef
+        directory() const noexcept
+        {
+            return e_->Directory;
+        }
+
+        llvm::StringRef
+        filename() const noexcept
+        {
+            return e_->Filename;
+        }
+
+        llvm::StringRef
+        output() const noexcept
+        {
+            return e_->Output;
+        }
+
+        /** Return the index of the flags without the input and output files.
+
+            Commands with equal indexes differ
+            only in their input and output files.
+        */
+        std::uint32_t
+        flags() const noexcept
+        {
+            return e_->Flags;
+        }
+
+        /** Return the command, with a copy of the command line.
+        */
+        tooling::CompileCommand
+        command() const
+        {
+            return db_->makeCommand(*e_);
+        }
+    };
+
     /** Constructor.
 
         This copies the contents of the source compilation
@@ -45,6 +168,60 @@ public:
         CompilationDatabase const& inner,
         std::shared_ptr<const Config> config);
 
+    /** Constructor.
+
+        The commands are taken from a loaded
+        database, and adjusted concurrently on
+        the thread pool of the configuration.
+    */
+    AbsoluteCompilationDatabase(
+        llvm::StringRef workingDir,
+        std::vector<tooling::CompileCommand> commands,
+        std::shared_ptr<const Config> config);
+
+    /** Constructor.
+
+        The commands of several databases are
+        merged, in order. A file which appears
+        more than once is compiled with its
+        first command.
+    */
+    AbsoluteCompilationDatabase(
+        std::vector<Source> sources,
+        std::shared_ptr<const Config> config);
+
+    /** Return the number of commands.
+    */
+    std::size_t
+    size() const noexcept
+    {
+        return Entries_.size();
+    }
+
+    /** Return the number of files whose commands were dropped.
+
+        These are files which appear again
+        with other flags or in another directory.
+    */
+    std::size_t
+    conflicts() const noexcept
+    {
+        return conflicts_;
+    }
+
+    /** Return the command at an index, in the order of the database.
+    */
+    CommandView
+    operator[](std::size_t i) const noexcept
+    {
+        return CommandView(*this, Entries_[i]);
+    }
+
+    /** Return the command for a file, if any.
+    */
+    std::optional<CommandView>
+    find(llvm::StringRef FilePath) const;
+
     std::vector<tooling::CompileCommand>
     getCompileCommands(
         llvm::StringRef FilePath) const override;
@@ -15,6 +15,7 @@
 
 #include "BitcodeReader.hpp"
 #include "DecodeRecord.hpp"
+#include "TypeTable.hpp"
 #include "Support/Debug.hpp"
 #include "Support/Error.hpp"
 
@@ -253,6 +254,25 @@ public:
         I_ = std::make_unique<Javadoc>();
     }
 
+    Error
+    parseRecord(Record const& R,
+        unsigned ID, llvm::StringRef Blob) override
+    {
+        switch(ID)
+        {
+        case JAVADOC_HASH:
+        {
+            std::uint64_t hash = 0;
+            if(auto err = decodeRecord(R, hash, Blob))
+                return err;
+            I_->addHash(hash);
+            return Error::success();
+        }
+        default:
+            return AnyBlock::parseRecord(R, ID, Blob);
+        }
+    }
+
     Error
     readSubBlock(
         unsigned ID) override
@@ -435,11 +455,11 @@ class TypeInfoBlock
 {
 protected:
     BitcodeReader& br_;
-    std::unique_ptr<TypeInfo>& I_;
+    std::shared_ptr<TypeInfo>& I_;
 
 public:
     TypeInfoBlock(
-        std::unique_ptr<TypeInfo>& I,
+        std::shared_ptr<TypeInfo>& I,
         BitcodeReader& br) noexcept
         : br_(br)
         , I_(I)
@@ -539,6 +559,22 @@ public:
     readSubBlock(unsigned ID) override;
 };
 
+/** Read a type and replace it with its shared instance.
+*/
+inline
+Error
+readTypeInfo(
+    std::shared_ptr<TypeInfo>& I,
+    BitcodeReader& br,
+    unsigned ID)
+{
+    TypeInfoBlock B(I, br);
+    if(auto err = br.readBlock(B, ID))
+        return err;
+    I = internType(std::move(I));
+    return Error::success();
+}
+
 //------------------------------------------------
 
 class BaseBlock
@@ -582,8 +618,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I_.Type, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I_.Type, br_, ID);
         }
         default:
             return AnyBlock::readSubBlock(ID);
@@ -709,7 +744,7 @@ public:
         }
         case BI_TYPEINFO_BLOCK_ID:
         {
-            std::unique_ptr<TypeInfo>* t = nullptr;
+            std::shared_ptr<TypeInfo>* t = nullptr;
             switch(I_.Kind)
             {
             case TParamKind::Type:
@@ -721,8 +756,7 @@ public:
             default:
                 return formatError("invalid TypeInfo block in TParam");
             }
-            TypeInfoBlock B(*t, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(*t, br_, ID);
         }
         default:
             return AnyBlock::readSubBlock(ID);
@@ -803,7 +837,7 @@ readSubBlock(unsigned ID)
     case BI_TYPEINFO_CHILD_BLOCK_ID:
         return visit(*I_, [&]<typename T>(T& t)
             {
-                std::unique_ptr<TypeInfo>* child = nullptr;
+                std::shared_ptr<TypeInfo>* child = nullptr;
                 if constexpr(requires { t.PointeeType; })
                     child = &t.PointeeType;
                 else if constexpr(T::isPack())
@@ -815,16 +849,14 @@ readSubBlock(unsigned ID)
 
                 if(! child)
                     return Error("wrong TypeInfo kind");
-                TypeInfoBlock B(*child, br_);
-                return br_.readBlock(B, ID);
+                return readTypeInfo(*child, br_, ID);
             });
     case BI_TYPEINFO_PARENT_BLOCK_ID:
         return visit(*I_, [&]<typename T>(T& t)
             {
                 if constexpr(requires { t.ParentType; })
                 {
-                    TypeInfoBlock B(t.ParentType, br_);
-                    return br_.readBlock(B, ID);
+                    return readTypeInfo(t.ParentType, br_, ID);
                 }
                 return Error("wrong TypeInfo kind");
             });
@@ -834,8 +866,7 @@ readSubBlock(unsigned ID)
         if(! I_->isFunction())
             return Error("wrong TypeInfo kind");
         auto& I = static_cast<FunctionTypeInfo&>(*I_);
-        TypeInfoBlock B(I.ParamTypes.emplace_back(), br_);
-        return br_.readBlock(B, ID);
+        return readTypeInfo(I.ParamTypes.emplace_back(), br_, ID);
     }
     case BI_TEMPLATE_ARG_BLOCK_ID:
     {
@@ -904,8 +935,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I_.Type, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I_.Type, br_, ID);
         }
         default:
             return AnyBlock::readSubBlock(ID);
@@ -1068,8 +1098,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I->ReturnType, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I->ReturnType, br_, ID);
         }
         case BI_FUNCTION_PARAM_BLOCK_ID:
         {
@@ -1123,8 +1152,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I->Type, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I->Type, br_, ID);
         }
         case BI_TEMPLATE_BLOCK_ID:
         {
@@ -1221,8 +1249,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I->UnderlyingType, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I->UnderlyingType, br_, ID);
         }
         case BI_ENUM_VALUE_BLOCK_ID:
         {
@@ -1271,8 +1298,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I->Type, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I->Type, br_, ID);
         }
         case BI_TEMPLATE_BLOCK_ID:
         {
@@ -1328,8 +1354,7 @@ public:
         {
         case BI_TYPEINFO_BLOCK_ID:
         {
-            TypeInfoBlock B(I->Type, br_);
-            return br_.readBlock(B, ID);
+            return readTypeInfo(I->Type, br_, ID);
         }
         case BI_EXPR_BLOCK_ID:
         {
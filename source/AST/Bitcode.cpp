@@ -10,18 +10,111 @@
 //
 
 #include "Bitcode.hpp"
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
+#include <cstring>
 
 namespace clang {
 namespace mrdox {
 
+namespace {
+
+// symbol ID, offset, and size
+constexpr std::size_t batchEntrySize = 20 + 4 + 4;
+
+} // (anon)
+
+void
+BitcodeBatch::
+insert(Bitcode const& bitcode)
+{
+    table_.push_back({
+        bitcode.id,
+        static_cast<std::uint32_t>(payload_.size()),
+        static_cast<std::uint32_t>(bitcode.data.size()) });
+    payload_.append(bitcode.data);
+}
+
+std::string
+BitcodeBatch::
+finish()
+{
+    namespace endian = llvm::support::endian;
+
+    std::string result;
+    result.resize(4 + table_.size() * batchEntrySize);
+    char* p = result.data();
+    endian::write32le(p, table_.size());
+    p += 4;
+    for(auto const& e : table_)
+    {
+        std::memcpy(p, e.id.data(), 20);
+        endian::write32le(p + 20, e.offset);
+        endian::write32le(p + 24, e.size);
+        p += batchEntrySize;
+    }
+    result.append(payload_.data(), payload_.size());
+    table_.clear();
+    payload_.clear();
+    return result;
+}
+
+bool
+forEachBitcode(
+    llvm::StringRef batch,
+    llvm::function_ref<void(
+        llvm::StringRef id,
+        llvm::StringRef bitcode)> f)
+{
+    namespace endian = llvm::support::endian;
+
+    if(batch.size() < 4)
+        return false;
+    std::size_t const n = endian::read32le(batch.data());
+    if((batch.size() - 4) / batchEntrySize < n)
+        return false;
+    llvm::StringRef table = batch.substr(4, n * batchEntrySize);
+    llvm::StringRef payload = batch.drop_front(4 + n * batchEntrySize);
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        char const* p = table.data() + i * batchEntrySize;
+        std::size_t const offset = endian::read32le(p + 20);
+        std::size_t const size = endian::read32le(p + 24);
+        if(offset > payload.size() ||
+            size > payload.size() - offset)
+            return false;
+        f(llvm::StringRef(p, 20), payload.substr(offset, size));
+    }
+    return true;
+}
+
 void
-insertBitcode(
+insertBitcodes(
     tooling::ExecutionContext& ex,
-    Bitcode&& bitcode)
+    llvm::StringRef key,
+    std::string batch)
 {
-    ex.reportResult(
-        StringRef(bitcode.id),
-        std::move(bitcode.data));
+    ex.reportResult(key, std::move(batch));
+}
+
+void
+sortBitcodes(
+    std::vector<StringRef>& bitcodes)
+{
+    if(bitcodes.size() < 2)
+        return;
+    // a hash is compared first, since
+    // bitcodes often share long prefixes
+    std::vector<std::pair<std::uint64_t, StringRef>> keyed;
+    keyed.reserve(bitcodes.size());
+    for(auto const& bitcode : bitcodes)
+        keyed.emplace_back(llvm::xxHash64(bitcode), bitcode);
+    std::sort(keyed.begin(), keyed.end());
+    for(std::size_t i = 0; i < keyed.size(); ++i)
+        bitcodes[i] = keyed[i].second;
 }
 
 Bitcodes
@@ -32,12 +125,132 @@ collectBitcodes(
     ex.getToolResults()->forEachResult(
         [&](StringRef Key, StringRef Value)
         {
-            auto result = results.try_emplace(
-                Key, std::vector<StringRef>());
-            result.first->second.emplace_back(Value);
+            bool ok = forEachBitcode(Value,
+                [&](StringRef id, StringRef bitcode)
+                {
+                    results[id].emplace_back(bitcode);
+                });
+            if(! ok)
+                reportError("invalid bitcode batch for \"{}\"",
+                    std::string_view(Key));
         });
     return results;
 }
 
+//------------------------------------------------
+
+namespace {
+
+constexpr llvm::StringLiteral shardMagic = "MRDOXSH1";
+
+void
+writeU32(
+    llvm::raw_ostream& os,
+    std::uint32_t v)
+{
+    char buf[4];
+    llvm::support::endian::write32le(buf, v);
+    os.write(buf, sizeof(buf));
+}
+
+} // (anon)
+
+Error
+writeBitcodeShard(
+    std::string_view path,
+    Bitcodes const& bitcodes)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    os << shardMagic;
+    writeU32(os, bitcodes.size());
+    // the same shard for any number of threads
+    std::vector<Bitcodes::value_type const*> groups;
+    groups.reserve(bitcodes.size());
+    for(auto const& group : bitcodes)
+        groups.push_back(&group);
+    std::sort(groups.begin(), groups.end(),
+        [](auto const* a, auto const* b)
+        {
+            return a->getKey() < b->getKey();
+        });
+    std::vector<StringRef> values;
+    for(auto const* group : groups)
+    {
+        os << group->getKey();
+        values = group->getValue();
+        sortBitcodes(values);
+        writeU32(os, values.size());
+        for(auto const& bitcode : values)
+        {
+            writeU32(os, bitcode.size());
+            os << bitcode;
+        }
+    }
+    os.close();
+    if(os.has_error())
+    {
+        ec = os.error();
+        os.clear_error();
+        return formatError("write(\"{}\") returned \"{}\"",
+            path, ec.message());
+    }
+    return Error::success();
+}
+
+mrdox::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+readBitcodeShard(
+    std::string_view path,
+    Bitcodes& bitcodes)
+{
+    auto buf = llvm::MemoryBuffer::getFile(path);
+    if(! buf)
+        return formatError("getFile(\"{}\") returned \"{}\"",
+            path, buf.getError().message());
+
+    llvm::StringRef s = (*buf)->getBuffer();
+    bool ok = true;
+    auto const take = [&](std::size_t n)
+    {
+        if(! ok || s.size() < n)
+        {
+            ok = false;
+            return llvm::StringRef();
+        }
+        auto result = s.take_front(n);
+        s = s.drop_front(n);
+        return result;
+    };
+    auto const takeU32 = [&]() -> std::uint32_t
+    {
+        auto v = take(4);
+        return ok ? llvm::support::endian::read32le(v.data()) : 0;
+    };
+
+    if(take(shardMagic.size()) != shardMagic)
+        return formatError("\"{}\" is not a bitcode shard", path);
+    auto const numGroups = takeU32();
+    for(std::uint32_t i = 0; ok && i < numGroups; ++i)
+    {
+        auto key = take(20);
+        auto const n = takeU32();
+        if(! ok)
+            break;
+        auto& group = bitcodes[key];
+        for(std::uint32_t j = 0; ok && j < n; ++j)
+        {
+            auto bitcode = take(takeU32());
+            if(ok)
+                group.emplace_back(bitcode);
+        }
+    }
+    if(! ok)
+        return formatError("bitcode shard \"{}\" is truncated", path);
+    return std::move(*buf);
+}
+
 } // mrdox
 } // clang
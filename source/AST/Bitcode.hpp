@@ -16,16 +16,20 @@
 #include <mrdox/MetadataFwd.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <clang/Tooling/Execution.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Support/Error.h>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace llvm {
 class BitstreamWriter;
 class BitstreamCursor;
+class MemoryBuffer;
 } // llvm
 
 namespace clang {
@@ -71,39 +75,175 @@ struct Bitcode
 */
 using Bitcodes = llvm::StringMap<std::vector<StringRef>>;
 
+/** Sort the bitcodes of one ID into a canonical order.
+
+    The order depends only on the bitcodes, so
+    it is the same however the translation units
+    were scheduled. Identical bitcodes are
+    adjacent afterwards.
+*/
+void
+sortBitcodes(
+    std::vector<StringRef>& bitcodes);
+
 /** Return the serialized bitcode for a metadata node.
 */
 Bitcode
 writeBitcode(
     Info const& I);
 
+/** A reusable serializer for metadata nodes.
+
+    Unlike @ref writeBitcode, the buffer and the
+    stream header with its abbreviations are set
+    up once and reused for every node written.
+    Each returned bitcode is still a complete
+    stream which can be read independently.
+*/
+class BitcodeSerializer
+{
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    BitcodeSerializer();
+    ~BitcodeSerializer();
+
+    /** Return the serialized bitcode for a metadata node.
+    */
+    Bitcode
+    write(Info const& I);
+};
+
 /** Return an array of Info read from a bitstream.
 */
 mrdox::Expected<std::vector<std::unique_ptr<Info>>>
 readBitcode(llvm::StringRef bitcode);
 
-/** Store a key/value pair in the tool results.
+/** A reusable decoder for serialized metadata.
+
+    Every bitcode starts with the same BLOCKINFO
+    block holding the abbreviations. The decoder
+    parses it once and reuses it for each later
+    bitcode which begins with identical bytes.
+*/
+class BitcodeDecoder
+{
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+
+public:
+    BitcodeDecoder();
+    ~BitcodeDecoder();
+
+    /** Return an array of Info read from a bitstream.
+
+        @param trusted Whether the bitcode was
+        written by this process. Checks which
+        only catch corrupt input are skipped,
+        so bitcode read from files is never
+        trusted.
+    */
+    mrdox::Expected<std::vector<std::unique_ptr<Info>>>
+    read(
+        llvm::StringRef bitcode,
+        bool trusted = false);
+};
+
+/** The bitcodes of one translation unit, stored contiguously.
 
-    This function inserts the bitcode for the
-    specified symbol ID into the tool results
-    of the execution context.
+    A serialized batch is a table of symbol ID,
+    offset, and length for each bitcode, followed
+    by one payload holding every bitcode. The
+    whole batch is reported as a single result,
+    and readers refer into it without copying.
+*/
+class BitcodeBatch
+{
+    struct Entry
+    {
+        SymbolID id;
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
 
-    Each symbol ID can have multiple bitcodes.
+    std::vector<Entry> table_;
+    llvm::SmallString<0> payload_;
+
+public:
+    /** Return true if the batch holds no bitcode.
+    */
+    bool
+    empty() const noexcept
+    {
+        return table_.empty();
+    }
+
+    /** Append a bitcode to the batch.
+    */
+    void
+    insert(Bitcode const& bitcode);
+
+    /** Return the serialized batch, leaving it empty.
+    */
+    std::string
+    finish();
+};
+
+/** Invoke a function with each bitcode in a serialized batch.
+
+    @return `false` if the batch is malformed.
+*/
+bool
+forEachBitcode(
+    llvm::StringRef batch,
+    llvm::function_ref<void(
+        llvm::StringRef id,
+        llvm::StringRef bitcode)> f);
+
+/** Store a serialized batch in the tool results.
+
+    The key is only used for diagnostics; every
+    symbol ID in the batch is found by reading
+    its table.
 */
 void
-insertBitcode(
+insertBitcodes(
     tooling::ExecutionContext& ex,
-    Bitcode&& bitcode);
+    llvm::StringRef key,
+    std::string batch);
 
 /** Return the bitcodes grouped by matching ID.
 
     Each ID may have one or more associated
     bitcodes, with duplicate bitcodes possible.
+    The bitcodes refer to the batches held by
+    the tool results.
 */
 Bitcodes
 collectBitcodes(
     tooling::ToolExecutor& ex);
 
+/** Write bitcodes grouped by ID to a shard file.
+
+    Shards are produced by distributed extraction
+    and combined later using @ref readBitcodeShard.
+*/
+Error
+writeBitcodeShard(
+    std::string_view path,
+    Bitcodes const& bitcodes);
+
+/** Append the bitcodes in a shard file.
+
+    The bitcodes refer to the memory in the
+    returned buffer, which must outlive them.
+*/
+mrdox::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+readBitcodeShard(
+    std::string_view path,
+    Bitcodes& bitcodes);
+
 } // mrdox
 } // clang
 
@@ -22,7 +22,7 @@ namespace mrdox {
 // Current version number of clang-doc bitcode.
 // Should be bumped when removing or changing BlockIds, RecordIDs, or
 // BitCodeConstants, though they can be added without breaking it.
-static const unsigned BitcodeVersion = 3;
+static const unsigned BitcodeVersion = 4;
 
 struct BitCodeConstants
 {
@@ -110,6 +110,7 @@ enum RecordID
     FUNCTION_CLASS,
     FUNCTION_PARAM_NAME,
     FUNCTION_PARAM_DEFAULT,
+    JAVADOC_HASH,
     JAVADOC_NODE_ADMONISH,
     JAVADOC_NODE_HREF,
     JAVADOC_NODE_KIND,
@@ -10,10 +10,12 @@
 //
 
 #include "BitcodeReader.hpp"
+#include "Bitcode.hpp"
 #include "AnyBlock.hpp"
 #include "DecodeRecord.hpp"
 #include "Support/Debug.hpp"
 #include "Support/Error.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Support/Error.hpp>
 
 namespace clang {
@@ -151,6 +153,13 @@ validateStream()
     if (Stream.AtEndOfStream())
         return formatError("premature end of stream");
 
+    if (trusted_)
+    {
+        if (auto err = Stream.JumpToBit(32))
+            return toError(std::move(err));
+        return Error::success();
+    }
+
     // Sniff for the signature.
     for (int i = 0; i != 4; ++i)
     {
@@ -167,13 +176,44 @@ Error
 BitcodeReader::
 readBlockInfoBlock()
 {
+    auto const bytes = Stream.getBitcodeBytes();
+    auto const prefixOf = [&](uint64_t bitNo)
+    {
+        return llvm::StringRef(
+            reinterpret_cast<char const*>(bytes.data()),
+            bitNo / 8);
+    };
+
+    // The block ends on a word boundary, so the bytes
+    // up to its end identify the abbreviations.
+    if(cache_ && cache_->info)
+    {
+        uint64_t const start = Stream.GetCurrentBitNo();
+        if(auto err = Stream.SkipBlock())
+            return toError(std::move(err));
+        if(prefixOf(Stream.GetCurrentBitNo()) == cache_->prefix)
+        {
+            Stream.setBlockInfo(&*cache_->info);
+            return Error::success();
+        }
+        if(auto err = Stream.JumpToBit(start))
+            return toError(std::move(err));
+    }
+
     llvm::Expected<std::optional<llvm::BitstreamBlockInfo>> MaybeBlockInfo =
         Stream.ReadBlockInfoBlock();
     if (!MaybeBlockInfo)
         return toError(MaybeBlockInfo.takeError());
-    BlockInfo = MaybeBlockInfo.get();
+    BlockInfo = std::move(MaybeBlockInfo.get());
     if (!BlockInfo)
         return formatError("unable to parse BlockInfoBlock");
+    if(cache_)
+    {
+        cache_->info = std::move(BlockInfo);
+        cache_->prefix = prefixOf(Stream.GetCurrentBitNo()).str();
+        Stream.setBlockInfo(&*cache_->info);
+        return Error::success();
+    }
     Stream.setBlockInfo(&*BlockInfo);
     return Error::success();
 }
@@ -238,7 +278,11 @@ Error
 BitcodeReader::
 readRecord(unsigned ID)
 {
-    Record R;
+    // Lists of symbol IDs hold twenty values per
+    // ID and outgrow the inline storage, so the
+    // buffer keeps its capacity between records.
+    thread_local Record R;
+    R.clear();
     llvm::StringRef Blob;
     llvm::Expected<unsigned> MaybeRecID =
         Stream.readRecord(ID, R, &Blob);
@@ -311,10 +355,39 @@ skipUntilRecordOrBlock(
 mrdox::Expected<std::vector<std::unique_ptr<Info>>>
 readBitcode(llvm::StringRef bitcode)
 {
+    MRDOX_PROFILE_ZONE("readBitcode");
     llvm::BitstreamCursor Stream(bitcode);
     BitcodeReader reader(Stream);
     return reader.getInfos();
 }
 
+//------------------------------------------------
+
+struct BitcodeDecoder::Impl
+    : BlockInfoCache
+{
+};
+
+BitcodeDecoder::
+BitcodeDecoder()
+    : impl_(std::make_unique<Impl>())
+{
+}
+
+BitcodeDecoder::
+~BitcodeDecoder() = default;
+
+mrdox::Expected<std::vector<std::unique_ptr<Info>>>
+BitcodeDecoder::
+read(
+    llvm::StringRef bitcode,
+    bool trusted)
+{
+    MRDOX_PROFILE_ZONE("readBitcode");
+    llvm::BitstreamCursor Stream(bitcode);
+    BitcodeReader reader(Stream, impl_.get(), trusted);
+    return reader.getInfos();
+}
+
 } // mrdox
 } // clang
@@ -26,19 +26,39 @@
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/Bitstream/BitstreamReader.h>
 #include <optional>
+#include <string>
 
 namespace clang {
 namespace mrdox {
 
 using Record = llvm::SmallVector<uint64_t, 1024>;
 
+/** A parsed BLOCKINFO block and the bytes it was read from.
+*/
+struct BlockInfoCache
+{
+    std::string prefix;
+    std::optional<llvm::BitstreamBlockInfo> info;
+};
+
 // Class to read bitstream into an InfoSet collection
 class BitcodeReader
 {
 public:
+    /** Constructor.
+
+        @param trusted Whether the bitcode was
+        written by this process, in which case
+        the checks which only catch corruption
+        are skipped.
+    */
     BitcodeReader(
-        llvm::BitstreamCursor& Stream)
+        llvm::BitstreamCursor& Stream,
+        BlockInfoCache* cache = nullptr,
+        bool trusted = false)
         : Stream(Stream)
+        , cache_(cache)
+        , trusted_(trusted)
     {
     }
 
@@ -85,6 +105,8 @@ public:
 public:
     llvm::BitstreamCursor& Stream;
     std::optional<llvm::BitstreamBlockInfo> BlockInfo;
+    BlockInfoCache* cache_;
+    bool trusted_;
     std::vector<AnyBlock*> blockStack_;
 };
 
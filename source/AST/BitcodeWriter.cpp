@@ -14,6 +14,7 @@
 #include "Bitcode.hpp"
 #include "ParseJavadoc.hpp"
 #include "Support/Debug.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Metadata.hpp>
 #include <llvm/ADT/IndexedMap.h>
 #include <initializer_list>
@@ -175,6 +176,24 @@ static void LocationAbbrev(
         llvm::BitCodeAbbrevOp(llvm::BitCodeAbbrevOp::Blob) });
 }
 
+static void SourceTextAbbrev(
+    std::shared_ptr<llvm::BitCodeAbbrev>& Abbrev)
+{
+    AbbrevGen(Abbrev, {
+        // 0. VBR integer (offset in the file)
+        llvm::BitCodeAbbrevOp(
+            llvm::BitCodeAbbrevOp::VBR, 8),
+        // 1. VBR integer (size, or zero if the blob is the text)
+        llvm::BitCodeAbbrevOp(
+            llvm::BitCodeAbbrevOp::VBR, 8),
+        // 2. Fixed-size integer (length of the following string)
+        llvm::BitCodeAbbrevOp(
+            llvm::BitCodeAbbrevOp::Fixed,
+            BitCodeConstants::StringLengthSize),
+        // 3. The text, or the full path of the file
+        llvm::BitCodeAbbrevOp(llvm::BitCodeAbbrevOp::Blob) });
+}
+
 //------------------------------------------------
 
 struct RecordIDDsc
@@ -255,7 +274,7 @@ RecordIDNameMap = []()
         {ENUM_VALUE_NAME, {"Name", &StringAbbrev}},
         {ENUM_VALUE_VALUE, {"Value", &StringAbbrev}},
         {ENUM_VALUE_EXPR, {"Expr", &StringAbbrev}},
-        {EXPR_WRITTEN, {"ExprWritten", &StringAbbrev}},
+        {EXPR_WRITTEN, {"ExprWritten", &SourceTextAbbrev}},
         {EXPR_VALUE, {"ExprValue", &Integer64Abbrev}},
         {FIELD_DEFAULT, {"DefaultValue", &StringAbbrev}},
         {FIELD_ATTRIBUTES, {"FieldAttributes", &Integer32ArrayAbbrev}},
@@ -264,11 +283,12 @@ RecordIDNameMap = []()
         {FUNCTION_BITS, {"Bits", &Integer32ArrayAbbrev}},
         {FUNCTION_CLASS, {"FunctionClass", &Integer32Abbrev}},
         {FUNCTION_PARAM_NAME, {"Name", &StringAbbrev}},
-        {FUNCTION_PARAM_DEFAULT, {"Default", &StringAbbrev}},
+        {FUNCTION_PARAM_DEFAULT, {"Default", &SourceTextAbbrev}},
         {INFO_PART_ACCESS, {"InfoAccess", &Integer32Abbrev}},
         {INFO_PART_ID, {"InfoID", &SymbolIDAbbrev}},
         {INFO_PART_NAME, {"InfoName", &StringAbbrev}},
         {INFO_PART_PARENTS, {"InfoParents", &SymbolIDsAbbrev}},
+        {JAVADOC_HASH, {"JavadocHash", &Integer64Abbrev}},
         {JAVADOC_NODE_ADMONISH, {"JavadocNodeAdmonish", &Integer32Abbrev}},
         {JAVADOC_NODE_HREF, {"JavadocNodeHref", &StringAbbrev}},
         {JAVADOC_NODE_KIND, {"JavadocNodeKind", &Integer32Abbrev}},
@@ -293,7 +313,7 @@ RecordIDNameMap = []()
         {TEMPLATE_PARAM_KIND,    {"Kind", &Integer32Abbrev}},
         {TEMPLATE_PARAM_NAME,    {"Name", &StringAbbrev}},
         {TEMPLATE_PARAM_IS_PACK, {"IsPack", &BoolAbbrev}},
-        {TEMPLATE_PARAM_DEFAULT, {"Default", &StringAbbrev}},
+        {TEMPLATE_PARAM_DEFAULT, {"Default", &SourceTextAbbrev}},
         {TYPEINFO_KIND, {"TypeinfoKind", &Integer32Abbrev}},
         {TYPEINFO_ID, {"TypeinfoID", &SymbolIDAbbrev}},
         {TYPEINFO_NAME, {"TypeinfoName", &StringAbbrev}},
@@ -351,7 +371,7 @@ RecordsByBlock{
         {FUNCTION_PARAM_NAME, FUNCTION_PARAM_DEFAULT}},
     // Javadoc
     {BI_JAVADOC_BLOCK_ID,
-        {}},
+        {JAVADOC_HASH}},
     // doc::List<doc::Node>
     {BI_JAVADOC_LIST_BLOCK_ID,
         {}},
@@ -676,11 +696,33 @@ emitRecord(
         return;
     // FIXME: Assert that the line number
     // is of the appropriate size.
+    std::string_view const filename = Loc.filename();
     Record.push_back(Loc.LineNumber);
-    MRDOX_ASSERT(Loc.Filename.size() < (1U << BitCodeConstants::StringLengthSize));
-    Record.push_back(Loc.IsFileInRootDir);
-    Record.push_back(Loc.Filename.size());
-    Stream.EmitRecordWithBlob(Abbrevs.get(ID), Record, Loc.Filename);
+    MRDOX_ASSERT(filename.size() < (1U << BitCodeConstants::StringLengthSize));
+    Record.push_back(Loc.isFileInRootDir());
+    Record.push_back(filename.size());
+    Stream.EmitRecordWithBlob(Abbrevs.get(ID), Record, filename);
+}
+
+void
+BitcodeWriter::
+emitRecord(
+    SourceText const& Text, RecordID ID)
+{
+    MRDOX_ASSERT(RecordIDNameMap[ID] && "Unknown RecordID.");
+    MRDOX_ASSERT(RecordIDNameMap[ID].Abbrev == &SourceTextAbbrev &&
+        "Abbrev type mismatch.");
+    if (!prepRecordData(ID, !Text.empty()))
+        return;
+    // a range is written with the path instead of
+    // the text, which is read again when needed
+    std::string_view const blob = Text.isReference() ?
+        getFileName(Text.fileIndex()) : Text.str();
+    MRDOX_ASSERT(blob.size() < (1U << BitCodeConstants::StringLengthSize));
+    Record.push_back(Text.offset());
+    Record.push_back(Text.size());
+    Record.push_back(blob.size());
+    Stream.EmitRecordWithBlob(Abbrevs.get(ID), Record, blob);
 }
 
 void
@@ -862,6 +904,8 @@ emitBlock(
     // If the unique_ptr<Javadoc> has a value then we
     // always want to emit it, even if it is empty.
     StreamSubBlockGuard Block(Stream, BI_JAVADOC_BLOCK_ID);
+    for(std::uint64_t hash : jd->hashes())
+        emitRecord(hash, JAVADOC_HASH);
     emitBlock(jd->getBlocks());
 }
 
@@ -920,7 +964,7 @@ emitBlock(
 void
 BitcodeWriter::
 emitBlock(
-    std::unique_ptr<TypeInfo> const& TI,
+    std::shared_ptr<TypeInfo> const& TI,
     BlockID ID)
 {
     if(! TI)
@@ -932,7 +976,7 @@ emitBlock(
 void
 BitcodeWriter::
 emitBlock(
-    std::unique_ptr<TypeInfo> const& TI)
+    std::shared_ptr<TypeInfo> const& TI)
 {
     if(! TI)
         return;
@@ -1133,6 +1177,7 @@ Bitcode
 writeBitcode(
     Info const& I)
 {
+    MRDOX_PROFILE_ZONE("writeBitcode");
     SmallString<0> Buffer;
     llvm::BitstreamWriter Stream(Buffer);
     BitcodeWriter writer(Stream);
@@ -1140,5 +1185,48 @@ writeBitcode(
     return Bitcode{ I.id, std::move(Buffer) };
 }
 
+//------------------------------------------------
+
+struct BitcodeSerializer::Impl
+{
+    SmallString<0> Buffer;
+    llvm::BitstreamWriter Stream;
+    BitcodeWriter Writer;
+
+    // size of the header, BLOCKINFO, and
+    // version block emitted by the writer
+    std::size_t PrefixSize;
+
+    Impl()
+        : Stream(Buffer)
+        , Writer(Stream)
+        , PrefixSize(Buffer.size())
+    {
+    }
+};
+
+BitcodeSerializer::
+BitcodeSerializer()
+    : impl_(std::make_unique<Impl>())
+{
+}
+
+BitcodeSerializer::
+~BitcodeSerializer() = default;
+
+Bitcode
+BitcodeSerializer::
+write(Info const& I)
+{
+    MRDOX_PROFILE_ZONE("writeBitcode");
+    // Every top-level block ends on a word
+    // boundary, so truncating the buffer to the
+    // prefix leaves the stream ready for the next.
+    impl_->Writer.dispatchInfoForWrite(&I);
+    SmallString<0> data(impl_->Buffer.str());
+    impl_->Buffer.resize(impl_->PrefixSize);
+    return Bitcode{ I.id, std::move(data) };
+}
+
 } // mrdox
 } // clang
@@ -83,6 +83,7 @@ public:
     void emitRecord(SymbolID const& Str, RecordID ID);
     void emitRecord(StringRef Str, RecordID ID);
     void emitRecord(Location const& Loc, RecordID ID);
+    void emitRecord(SourceText const& Text, RecordID ID);
     void emitRecord(bool Value, RecordID ID);
     void emitRecord(std::initializer_list<BitFieldFullValue> values, RecordID ID);
 
@@ -128,8 +129,8 @@ public:
     void emitBlock(VariableInfo const& I);
     void emitBlock(FieldInfo const& I);
 
-    void emitBlock(std::unique_ptr<TypeInfo> const& TI);
-    void emitBlock(std::unique_ptr<TypeInfo> const& TI, BlockID ID);
+    void emitBlock(std::shared_ptr<TypeInfo> const& TI);
+    void emitBlock(std::shared_ptr<TypeInfo> const& TI, BlockID ID);
 
     template<typename ExprInfoTy>
         requires std::derived_from<ExprInfoTy, ExprInfo>
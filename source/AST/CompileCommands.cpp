@@ -0,0 +1,455 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "AST/CompileCommands.hpp"
+#include <mrdox/Support/ThreadPool.hpp>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/ConvertUTF.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/StringSaver.h>
+#include <algorithm>
+#include <cstring>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+bool
+isSpace(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/** Return the end of a string, given the first character after the quote.
+
+    Only the closing quote is searched for,
+    so nothing is decoded.
+*/
+char const*
+skipString(
+    char const* p,
+    char const* end) noexcept
+{
+    for(;;)
+    {
+        p = static_cast<char const*>(
+            std::memchr(p, '"', end - p));
+        if(! p)
+            return nullptr;
+        // an odd number of backslashes escapes the
+        // quote, and the opening quote ends the run
+        char const* q = p;
+        while(q[-1] == '\\')
+            --q;
+        if(((p - q) & 1) == 0)
+            return p + 1;
+        ++p;
+    }
+}
+
+/** A parser for the entries of a compilation database.
+
+    The entries were already checked to have
+    balanced brackets and terminated strings.
+*/
+class Parser
+{
+    char const* const base_;
+    char const* p_;
+    char const* end_;
+    std::string temp_;
+
+public:
+    Parser(
+        llvm::StringRef json,
+        llvm::StringRef entry) noexcept
+        : base_(json.data())
+        , p_(entry.data())
+        , end_(entry.data() + entry.size())
+    {
+    }
+
+    Error
+    fail(std::string_view what) const
+    {
+        return formatError("{} at offset {} of the compilation database",
+            what, p_ - base_);
+    }
+
+    void
+    skipSpace() noexcept
+    {
+        while(p_ < end_ && isSpace(*p_))
+            ++p_;
+    }
+
+    bool
+    consume(char c) noexcept
+    {
+        skipSpace();
+        if(p_ == end_ || *p_ != c)
+            return false;
+        ++p_;
+        return true;
+    }
+
+    bool
+    parseHex4(unsigned& cp) noexcept
+    {
+        if(end_ - p_ < 4)
+            return false;
+        cp = 0;
+        for(int i = 0; i < 4; ++i)
+        {
+            char const c = *p_++;
+            cp <<= 4;
+            if(c >= '0' && c <= '9')
+                cp |= c - '0';
+            else if(c >= 'a' && c <= 'f')
+                cp |= c - 'a' + 10;
+            else if(c >= 'A' && c <= 'F')
+                cp |= c - 'A' + 10;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    Error
+    parseString(std::string& s)
+    {
+        if(! consume('"'))
+            return fail("expected a string");
+        s.clear();
+        for(;;)
+        {
+            // copy the run up to the next quote or escape
+            char const* q = p_;
+            while(q < end_ && *q != '"' && *q != '\\')
+                ++q;
+            s.append(p_, q);
+            p_ = q;
+            if(p_ == end_)
+                return fail("unterminated string");
+            if(*p_++ == '"')
+                return Error::success();
+            if(p_ == end_)
+                return fail("unterminated string");
+            switch(char const c = *p_++)
+            {
+            case '"': case '\\': case '/':
+                s.push_back(c);
+                break;
+            case 'b': s.push_back('\b'); break;
+            case 'f': s.push_back('\f'); break;
+            case 'n': s.push_back('\n'); break;
+            case 'r': s.push_back('\r'); break;
+            case 't': s.push_back('\t'); break;
+            case 'u':
+            {
+                unsigned cp;
+                if(! parseHex4(cp))
+                    return fail("invalid unicode escape");
+                if(cp >= 0xD800 && cp < 0xDC00)
+                {
+                    unsigned lo;
+                    if(end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u')
+                        return fail("invalid unicode escape");
+                    p_ += 2;
+                    if(! parseHex4(lo) || lo < 0xDC00 || lo >= 0xE000)
+                        return fail("invalid unicode escape");
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                char buf[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+                char* out = buf;
+                if(! llvm::ConvertCodePointToUTF8(cp, out))
+                    return fail("invalid unicode escape");
+                s.append(buf, out);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+    }
+
+    Error
+    skipValue()
+    {
+        skipSpace();
+        if(p_ == end_)
+            return fail("expected a value");
+        if(*p_ == '"')
+            return parseString(temp_);
+        if(*p_ == '{' || *p_ == '[')
+        {
+            std::size_t depth = 0;
+            for(; p_ < end_; ++p_)
+            {
+                char const c = *p_;
+                if(c == '"')
+                {
+                    p_ = skipString(p_ + 1, end_) - 1;
+                }
+                else if(c == '{' || c == '[')
+                {
+                    ++depth;
+                }
+                else if(c == '}' || c == ']')
+                {
+                    if(--depth == 0)
+                    {
+                        ++p_;
+                        return Error::success();
+                    }
+                }
+            }
+            return fail("unterminated value");
+        }
+        // numbers, booleans, and null
+        char const* const first = p_;
+        while(p_ < end_ && ! isSpace(*p_) &&
+            *p_ != ',' && *p_ != '}' && *p_ != ']')
+            ++p_;
+        if(p_ == first)
+            return fail("expected a value");
+        return Error::success();
+    }
+
+    Error
+    parseArguments(std::vector<std::string>& args)
+    {
+        if(! consume('['))
+            return fail("expected an array of strings");
+        if(consume(']'))
+            return Error::success();
+        for(;;)
+        {
+            if(auto err = parseString(args.emplace_back()))
+                return err;
+            if(consume(','))
+                continue;
+            if(consume(']'))
+                return Error::success();
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    Error
+    parseEntry(tooling::CompileCommand& cmd)
+    {
+        bool hasDirectory = false;
+        bool hasFile = false;
+        bool hasArguments = false;
+        bool hasCommand = false;
+        std::string command;
+
+        if(! consume('{'))
+            return fail("expected an object");
+        if(! consume('}'))
+        {
+            std::string key;
+            for(;;)
+            {
+                if(auto err = parseString(key))
+                    return err;
+                if(! consume(':'))
+                    return fail("expected ':'");
+                Error err;
+                if(key == "directory")
+                {
+                    err = parseString(cmd.Directory);
+                    hasDirectory = true;
+                }
+                else if(key == "file")
+                {
+                    err = parseString(cmd.Filename);
+                    hasFile = true;
+                }
+                else if(key == "output")
+                {
+                    err = parseString(cmd.Output);
+                }
+                else if(key == "arguments")
+                {
+                    cmd.CommandLine.clear();
+                    err = parseArguments(cmd.CommandLine);
+                    hasArguments = true;
+                }
+                else if(key == "command")
+                {
+                    err = parseString(command);
+                    hasCommand = true;
+                }
+                else
+                {
+                    err = skipValue();
+                }
+                if(err)
+                    return err;
+                if(consume(','))
+                    continue;
+                if(consume('}'))
+                    break;
+                return fail("expected ',' or '}'");
+            }
+        }
+
+        if(! hasDirectory)
+            return fail("missing key \"directory\"");
+        if(! hasFile)
+            return fail("missing key \"file\"");
+        if(! hasArguments && ! hasCommand)
+            return fail("missing key \"command\" or \"arguments\"");
+
+        // the arguments are used when both are present
+        if(! hasArguments)
+        {
+            llvm::BumpPtrAllocator alloc;
+            llvm::StringSaver saver(alloc);
+            llvm::SmallVector<char const*, 64> argv;
+#ifdef _WIN32
+            llvm::cl::TokenizeWindowsCommandLineFull(command, saver, argv);
+#else
+            llvm::cl::TokenizeGNUCommandLine(command, saver, argv);
+#endif
+            cmd.CommandLine.assign(argv.begin(), argv.end());
+        }
+        return Error::success();
+    }
+};
+
+/** Return the text of each entry of the top-level array.
+*/
+Expected<std::vector<llvm::StringRef>>
+splitEntries(
+    llvm::StringRef json)
+{
+    char const* p = json.data();
+    char const* const end = p + json.size();
+    auto const fail = [&](std::string_view what)
+    {
+        return formatError("{} at offset {} of the compilation database",
+            what, p - json.data());
+    };
+    auto const skipSpace = [&]
+    {
+        while(p < end && isSpace(*p))
+            ++p;
+    };
+
+    std::vector<llvm::StringRef> entries;
+    if(json.substr(0, 3) == "\xEF\xBB\xBF")
+        p += 3;
+    skipSpace();
+    if(p == end || *p != '[')
+        return fail("expected '['");
+    ++p;
+    skipSpace();
+    if(p < end && *p == ']')
+        return entries;
+    for(;;)
+    {
+        skipSpace();
+        if(p == end || *p != '{')
+            return fail("expected an object");
+        char const* const first = p;
+        std::size_t depth = 0;
+        for(; p < end; ++p)
+        {
+            char const c = *p;
+            if(c == '"')
+            {
+                char const* q = skipString(p + 1, end);
+                if(! q)
+                    return fail("unterminated string");
+                p = q - 1;
+            }
+            else if(c == '{' || c == '[')
+            {
+                ++depth;
+            }
+            else if(c == '}' || c == ']')
+            {
+                if(--depth == 0)
+                    break;
+            }
+        }
+        if(p == end)
+            return fail("unterminated object");
+        ++p;
+        entries.emplace_back(first, p - first);
+        skipSpace();
+        if(p < end && *p == ',')
+        {
+            ++p;
+            continue;
+        }
+        if(p < end && *p == ']')
+            return entries;
+        return fail("expected ',' or ']'");
+    }
+}
+
+} // (anon)
+
+Expected<std::vector<tooling::CompileCommand>>
+parseCompileCommands(
+    llvm::StringRef json,
+    ThreadPool& threadPool)
+{
+    auto entries = splitEntries(json);
+    if(! entries)
+        return entries.error();
+
+    // decode the entries in batches, as
+    // each one is only a few microseconds
+    constexpr std::size_t grain = 256;
+    std::vector<tooling::CompileCommand> commands(entries->size());
+    TaskGroup taskGroup(threadPool);
+    for(std::size_t first = 0; first < commands.size(); first += grain)
+    {
+        taskGroup.async(
+            [&, first]
+            {
+                std::size_t const last =
+                    std::min(first + grain, commands.size());
+                for(std::size_t i = first; i < last; ++i)
+                {
+                    Parser parser(json, (*entries)[i]);
+                    parser.parseEntry(commands[i]).maybeThrow();
+                }
+            });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Error(errors);
+    return commands;
+}
+
+Expected<std::vector<tooling::CompileCommand>>
+loadCompileCommands(
+    llvm::StringRef path,
+    ThreadPool& threadPool)
+{
+    // large files are mapped rather than read
+    auto buf = llvm::MemoryBuffer::getFile(path,
+        /*IsText=*/ false, /*RequiresNullTerminator=*/ false);
+    if(! buf)
+        return formatError("getFile(\"{}\") returned \"{}\"",
+            path, buf.getError().message());
+    return parseCompileCommands((*buf)->getBuffer(), threadPool);
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,54 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_AST_COMPILECOMMANDS_HPP
+#define MRDOX_TOOL_AST_COMPILECOMMANDS_HPP
+
+#include <mrdox/Support/Error.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringRef.h>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+class ThreadPool;
+
+/** Return the commands of a JSON compilation database.
+
+    This reads the format of `compile_commands.json`
+    without building a tree of JSON values. The
+    entries are found in one pass over the text,
+    then decoded concurrently. The command line of
+    an entry is its "arguments", or else its
+    "command" split with the rules of the host, as
+    `tooling::JSONCompilationDatabase` does. The
+    commands are returned in the order of the file,
+    with their paths unchanged.
+*/
+Expected<std::vector<tooling::CompileCommand>>
+parseCompileCommands(
+    llvm::StringRef json,
+    ThreadPool& threadPool);
+
+/** Return the commands of a JSON compilation database file.
+
+    The file is mapped into memory rather than
+    read, then parsed with @ref parseCompileCommands.
+*/
+Expected<std::vector<tooling::CompileCommand>>
+loadCompileCommands(
+    llvm::StringRef path,
+    ThreadPool& threadPool);
+
+} // mrdox
+} // clang
+
+#endif
@@ -103,15 +103,14 @@ decodeRecord(
     std::vector<SymbolID>& f,
     llvm::StringRef blob)
 {
-    auto src = R.begin();
-    auto n = *src++;
-    f.resize(n);
-    auto* dest = &f[0];
-    while(n--)
-    {
-        *dest++ = SymbolID(src);
-        src += BitCodeConstants::USRHashSize;
-    }
+    constexpr std::size_t N = BitCodeConstants::USRHashSize;
+    auto const n = R[0];
+    if(R.size() != 1 + n * N)
+        return formatError("symbol ID list size={}", R.size());
+    f.clear();
+    f.reserve(n);
+    for(auto src = R.begin() + 1; src != R.end(); src += N)
+        f.emplace_back(src);
     return Error::success();
 }
 
@@ -179,6 +178,24 @@ decodeRecord(
     return Error::success();
 }
 
+inline
+Error
+decodeRecord(
+    Record const& R,
+    SourceText& Field,
+    llvm::StringRef Blob)
+{
+    if(R[0] > UINT32_MAX || R[1] > UINT32_MAX)
+        return formatError("source range {}+{} too large", R[0], R[1]);
+    if(R[1] == 0)
+        Field = SourceText(Blob.str());
+    else
+        Field = SourceText(getFileIndex(Blob),
+            static_cast<std::uint32_t>(R[0]),
+            static_cast<std::uint32_t>(R[1]));
+    return Error::success();
+}
+
 inline
 Error
 decodeRecord(
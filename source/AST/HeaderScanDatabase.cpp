@@ -0,0 +1,166 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "AST/HeaderScanDatabase.hpp"
+#include "Support/Debug.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <clang/Driver/Types.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <algorithm>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+bool
+isHeaderFile(
+    llvm::StringRef filename)
+{
+    auto ext = llvm::sys::path::extension(filename);
+    if(ext.empty())
+        return false;
+    auto const type = driver::types::lookupTypeForExtension(
+        ext.drop_front());
+    return type != driver::types::TY_INVALID &&
+        driver::types::onlyPrecompileType(type);
+}
+
+/** Return a command for a generated file.
+*/
+tooling::CompileCommand
+makeCommand(
+    tooling::CompileCommand const& rep,
+    std::string const& filename)
+{
+    tooling::CompileCommand cmd = rep;
+    cmd.Filename = filename;
+    cmd.Output.clear();
+    cmd.Heuristic = "header scan";
+    bool found = false;
+    for(auto& arg : cmd.CommandLine)
+    {
+        if(arg == rep.Filename)
+        {
+            arg = filename;
+            found = true;
+        }
+    }
+    if(! found)
+        cmd.CommandLine.push_back(filename);
+    return cmd;
+}
+
+} // (anon)
+
+HeaderScanDatabase::
+HeaderScanDatabase(
+    llvm::StringRef workingDir,
+    CompilationDatabase const& inner,
+    std::vector<std::string> const& headers,
+    bool umbrella)
+{
+    auto const commands = inner.getAllCompileCommands();
+    MRDOX_ASSERT(! commands.empty());
+    auto const& rep = commands.front();
+
+    auto const add = [&](std::string filename, std::string text)
+    {
+        IndexByFile_.try_emplace(filename, AllCommands_.size());
+        AllCommands_.emplace_back(makeCommand(rep, filename));
+        Contents_.try_emplace(filename, std::move(text));
+    };
+
+    if(umbrella)
+    {
+        std::string text;
+        for(auto const& header : headers)
+            text += "#include \"" + header + "\"\n";
+        add(files::appendPath(workingDir, "mrdox-umbrella.cpp"),
+            std::move(text));
+        return;
+    }
+    // the generated file is next to the header,
+    // so that diagnostics are easy to locate
+    for(auto const& header : headers)
+        add(header + ".mrdox.cpp",
+            "#include \"" + header + "\"\n");
+}
+
+std::vector<tooling::CompileCommand>
+HeaderScanDatabase::
+getCompileCommands(
+    llvm::StringRef FilePath) const
+{
+    auto const it = IndexByFile_.find(FilePath);
+    if(it == IndexByFile_.end())
+        return {};
+    return { AllCommands_[it->getValue()] };
+}
+
+std::vector<std::string>
+HeaderScanDatabase::
+getAllFiles() const
+{
+    std::vector<std::string> allFiles;
+    allFiles.reserve(AllCommands_.size());
+    for(auto const& cmd : AllCommands_)
+        allFiles.push_back(cmd.Filename);
+    return allFiles;
+}
+
+std::vector<tooling::CompileCommand>
+HeaderScanDatabase::
+getAllCompileCommands() const
+{
+    return AllCommands_;
+}
+
+//------------------------------------------------
+
+Expected<std::vector<std::string>>
+findHeaderFiles(
+    std::vector<std::string> const& paths)
+{
+    namespace fs = llvm::sys::fs;
+
+    std::vector<std::string> result;
+    for(auto const& path : paths)
+    {
+        if(! fs::is_directory(path))
+        {
+            if(! fs::exists(path))
+                return formatError("header \"{}\" does not exist", path);
+            result.push_back(path);
+            continue;
+        }
+        std::error_code ec;
+        fs::recursive_directory_iterator it(path, ec);
+        fs::recursive_directory_iterator const end;
+        for(; ! ec && it != end; it.increment(ec))
+        {
+            if(it->type() == fs::file_type::regular_file &&
+                isHeaderFile(it->path()))
+                result.push_back(files::makePosixStyle(it->path()));
+        }
+        if(ec)
+            return formatError("recursive_directory_iterator(\"{}\") returned \"{}\"",
+                path, ec.message());
+    }
+    // deterministic order, so generated
+    // translation units are stable
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,89 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_AST_HEADERSCANDATABASE_HPP
+#define MRDOX_TOOL_AST_HEADERSCANDATABASE_HPP
+
+#include <mrdox/Support/Error.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringMap.h>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A compilation database of synthesized header translation units.
+
+    Instead of the source files of a project, the
+    translation units of this database are generated
+    files which only include the public headers.
+    The flags of a representative command from the
+    inner database are used for every generated
+    translation unit.
+*/
+class HeaderScanDatabase
+    : public tooling::CompilationDatabase
+{
+    std::vector<tooling::CompileCommand> AllCommands_;
+    llvm::StringMap<std::size_t> IndexByFile_;
+    llvm::StringMap<std::string> Contents_;
+
+public:
+    /** Constructor.
+
+        @param inner The database to take the
+        representative compile command from.
+
+        @param headers The absolute paths of the
+        public headers.
+
+        @param umbrella If `true`, one translation
+        unit includes every header. Otherwise, one
+        translation unit is made for each header.
+    */
+    HeaderScanDatabase(
+        llvm::StringRef workingDir,
+        CompilationDatabase const& inner,
+        std::vector<std::string> const& headers,
+        bool umbrella);
+
+    /** Return the contents of each generated file, keyed by path.
+    */
+    llvm::StringMap<std::string> const&
+    contents() const noexcept
+    {
+        return Contents_;
+    }
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override;
+
+    std::vector<std::string>
+    getAllFiles() const override;
+
+    std::vector<tooling::CompileCommand>
+    getAllCompileCommands() const override;
+};
+
+/** Return the header files named by a list of files and directories.
+
+    Directories are searched recursively for
+    files with a C or C++ header extension.
+*/
+Expected<std::vector<std::string>>
+findHeaderFiles(
+    std::vector<std::string> const& paths);
+
+} // mrdox
+} // clang
+
+#endif
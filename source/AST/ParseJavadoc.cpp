@@ -27,7 +27,18 @@
 #pragma warning(pop)
 #endif
 #include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/SmallString.h>
 #include <llvm/Support/JSON.h>
+#include <llvm/Support/xxhash.h>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 /*
     Comment Types
@@ -112,7 +123,7 @@ class JavadocVisitor
     Comment::child_iterator it_;
     Comment::child_iterator end_;
 
-    static std::string& ensureUTF8(std::string&&);
+    static std::string toUTF8(llvm::StringRef s);
     void visitChildren(Comment const* C);
 
 public:
@@ -167,14 +178,140 @@ Scope(U&, T*&) -> Scope<T, T>;
 
 //------------------------------------------------
 
-std::string&
+// Comment text is nearly always ASCII, which
+// is found sixteen bytes at a time. The few
+// multibyte sequences are checked one by one.
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+std::size_t
+findNonASCII(
+    char const* p,
+    std::size_t n) noexcept
+{
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i const v = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(p + i));
+        if(unsigned const bits = _mm_movemask_epi8(v))
+            return i + std::countr_zero(bits);
+    }
+    for(; i < n; ++i)
+        if(static_cast<unsigned char>(p[i]) >= 0x80)
+            return i;
+    return n;
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+std::size_t
+findNonASCII(
+    char const* p,
+    std::size_t n) noexcept
+{
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        uint8x16_t const v = vld1q_u8(
+            reinterpret_cast<std::uint8_t const*>(p + i));
+        if(vmaxvq_u8(v) >= 0x80)
+            break;
+    }
+    for(; i < n; ++i)
+        if(static_cast<unsigned char>(p[i]) >= 0x80)
+            return i;
+    return n;
+}
+
+#else
+
+std::size_t
+findNonASCII(
+    char const* p,
+    std::size_t n) noexcept
+{
+    // eight bytes at a time
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p + i, 8);
+        if(v & 0x8080808080808080ull)
+            break;
+    }
+    for(; i < n; ++i)
+        if(static_cast<unsigned char>(p[i]) >= 0x80)
+            return i;
+    return n;
+}
+
+#endif
+
+/** Return true if a string is well-formed UTF-8.
+
+    Overlong forms, surrogates, and code points
+    past U+10FFFF are rejected, as they are by
+    llvm::json::isUTF8.
+*/
+bool
+isUTF8(
+    llvm::StringRef s) noexcept
+{
+    auto const* p = reinterpret_cast<unsigned char const*>(s.data());
+    std::size_t const n = s.size();
+    std::size_t i = 0;
+    for(;;)
+    {
+        i += findNonASCII(s.data() + i, n - i);
+        if(i == n)
+            return true;
+        unsigned char const c = p[i];
+        std::size_t len;
+        unsigned char lo = 0x80;
+        unsigned char hi = 0xBF;
+        if(c >= 0xC2 && c <= 0xDF)
+            len = 2;
+        else if(c >= 0xE0 && c <= 0xEF)
+        {
+            len = 3;
+            if(c == 0xE0)
+                lo = 0xA0;
+            else if(c == 0xED)
+                hi = 0x9F;
+        }
+        else if(c >= 0xF0 && c <= 0xF4)
+        {
+            len = 4;
+            if(c == 0xF0)
+                lo = 0x90;
+            else if(c == 0xF4)
+                hi = 0x8F;
+        }
+        else
+            return false;
+        if(n - i < len)
+            return false;
+        // only the second byte has a narrower range
+        if(p[i + 1] < lo || p[i + 1] > hi)
+            return false;
+        for(std::size_t k = 2; k < len; ++k)
+            if((p[i + k] & 0xC0) != 0x80)
+                return false;
+        i += len;
+    }
+}
+
+std::string
 JavadocVisitor::
-ensureUTF8(
-    std::string&& s)
+toUTF8(
+    llvm::StringRef s)
 {
-    if (!llvm::json::isUTF8(s))
-        s = llvm::json::fixUTF8(s);
-    return s;
+    // the text is copied once, and
+    // only invalid text is repaired
+    if(isUTF8(s))
+        return s.str();
+    return llvm::json::fixUTF8(s);
 }
 
 void
@@ -254,7 +391,7 @@ visitTextComment(
 #if 0
     if(! s.empty())
 #endif
-        paragraph_->emplace_back(doc::Text(ensureUTF8(s.str())));
+        paragraph_->emplace_back(doc::Text(toUTF8(s)));
 }
 
 void
@@ -296,9 +433,7 @@ visitHTMLStartTagComment(
             // error
             return;
         }
-        std::string text;
-        std::string href;
-        text = cText.getText();
+        llvm::StringRef href;
         for(std::size_t i = 0; i < C->getNumAttrs(); ++i)
         {
             auto const& attr = C->getAttr(i);
@@ -309,8 +444,8 @@ visitHTMLStartTagComment(
             }
         }
         paragraph_->emplace_back(doc::Link(
-            ensureUTF8(std::move(text)),
-            ensureUTF8(std::move(href))));
+            toUTF8(cText.getText()),
+            toUTF8(href)));
 
         it_ += 2; // bit of a hack
     }
@@ -484,7 +619,7 @@ visitParamCommandComment(
 {
     doc::Param param;
     if(C->hasParamName())
-        param.name = ensureUTF8(C->getParamNameAsWritten().str());
+        param.name = toUTF8(C->getParamNameAsWritten());
     else
         param.name = "@anon";
     if(C->isDirectionExplicit())
@@ -515,7 +650,7 @@ visitTParamCommandComment(
 {
     doc::TParam tparam;
     if(C->hasParamName())
-        tparam.name = ensureUTF8(C->getParamNameAsWritten().str());
+        tparam.name = toUTF8(C->getParamNameAsWritten());
     else
         tparam.name = "@anon";
     Scope scope(tparam, paragraph_);
@@ -725,6 +860,7 @@ parseJavadoc(
         if(jd == nullptr)
         {
             jd = std::make_unique<Javadoc>(std::move(result));
+            jd->computeHash();
         }
         else
         {
@@ -738,5 +874,138 @@ parseJavadoc(
     }
 }
 
+//------------------------------------------------
+
+namespace {
+
+std::unique_ptr<doc::Text>
+cloneText(
+    doc::Text const& text)
+{
+    return doc::visit(text,
+        []<class T>(T const& t) -> std::unique_ptr<doc::Text>
+        {
+            if constexpr(std::derived_from<T, doc::Text>)
+                return std::make_unique<T>(t);
+            else
+                MRDOX_UNREACHABLE();
+        });
+}
+
+// The blocks own their children, so they are
+// rebuilt field by field instead of copied.
+std::unique_ptr<doc::Block>
+cloneBlock(
+    doc::Block const& block)
+{
+    return doc::visit(block,
+        []<class T>(T const& b) -> std::unique_ptr<doc::Block>
+        {
+            if constexpr(std::derived_from<T, doc::Block>)
+            {
+                auto p = std::make_unique<T>();
+                if constexpr(std::same_as<T, doc::Heading>)
+                {
+                    p->string = b.string;
+                }
+                else if constexpr(std::same_as<T, doc::Admonition>)
+                {
+                    p->admonish = b.admonish;
+                }
+                else if constexpr(std::same_as<T, doc::Param>)
+                {
+                    p->name = b.name;
+                    p->direction = b.direction;
+                }
+                else if constexpr(std::same_as<T, doc::TParam>)
+                {
+                    p->name = b.name;
+                }
+                p->children.reserve(b.children.size());
+                for(auto const& text : b.children)
+                    p->children.emplace_back(cloneText(*text));
+                return p;
+            }
+            else
+            {
+                MRDOX_UNREACHABLE();
+            }
+        });
+}
+
+std::unique_ptr<Javadoc>
+cloneJavadoc(
+    Javadoc const& jd)
+{
+    doc::List<doc::Block> blocks;
+    blocks.reserve(jd.getBlocks().size());
+    for(auto const& block : jd.getBlocks())
+        blocks.emplace_back(cloneBlock(*block));
+    auto result = std::make_unique<Javadoc>(std::move(blocks));
+    for(auto hash : jd.hashes())
+        result->addHash(hash);
+    return result;
+}
+
+} // (anon)
+
+std::unique_ptr<Javadoc>
+JavadocCache::
+get(
+    RawComment* RC,
+    Decl const* D,
+    Config const& config)
+{
+    SourceManager const& sm = D->getASTContext().getSourceManager();
+    SourceLocation const loc = RC->getBeginLoc();
+    std::uint64_t const offset = sm.getFileOffset(loc);
+    std::uint64_t const hash = llvm::xxHash64(RC->getRawText(sm));
+
+    llvm::SmallString<256> key(sm.getFilename(loc));
+    key.push_back('\0');
+    key.append(reinterpret_cast<char const*>(&offset), sizeof(offset));
+    key.append(reinterpret_cast<char const*>(&hash), sizeof(hash));
+
+    // entries are never replaced or erased, so
+    // they can be copied outside of the lock
+    Shard& shard = shards_[(hash ^ offset) % shardCount];
+    Javadoc const* cached = nullptr;
+    {
+        std::lock_guard<llvm::sys::Mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if(it != shard.map.end())
+            cached = it->second.get();
+    }
+    if(cached)
+    {
+        ++hits_;
+        RC->setAttached();
+        return cloneJavadoc(*cached);
+    }
+
+    ++misses_;
+    std::unique_ptr<Javadoc> jd;
+    parseJavadoc(jd, RC, D, config);
+    auto copy = cloneJavadoc(*jd);
+    {
+        std::lock_guard<llvm::sys::Mutex> lock(shard.mutex);
+        shard.map.try_emplace(key, std::move(copy));
+    }
+    return jd;
+}
+
+void
+parseJavadoc(
+    std::unique_ptr<Javadoc>& jd,
+    RawComment* RC,
+    Decl const* D,
+    Config const& config,
+    JavadocCache& cache)
+{
+    MRDOX_ASSERT(jd == nullptr);
+    if(RC)
+        jd = cache.get(RC, D, config);
+}
+
 } // mrdox
 } // clang
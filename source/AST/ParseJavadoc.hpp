@@ -15,6 +15,10 @@
 #include <mrdox/Platform.hpp>
 #include <mrdox/Config.hpp>
 #include <mrdox/Metadata/Javadoc.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Mutex.h>
+#include <atomic>
+#include <memory>
 
 namespace clang {
 
@@ -33,6 +37,56 @@ void
 initCustomCommentCommands(
     ASTContext& ctx);
 
+/** The parsed comments of a run.
+
+    A comment in a header is parsed again by
+    every translation unit which includes it.
+    The first parse of each comment is kept, keyed
+    on its file, offset, and the hash of its text,
+    and later translation units receive a copy.
+
+    The cache is safe for concurrent use.
+*/
+class JavadocCache
+{
+    struct Shard
+    {
+        llvm::sys::Mutex mutex;
+        llvm::StringMap<std::unique_ptr<Javadoc const>> map;
+    };
+
+    static constexpr std::size_t shardCount = 16;
+
+    Shard shards_[shardCount];
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+
+public:
+    /** Return a copy of the javadoc for a comment, parsing it if needed.
+    */
+    std::unique_ptr<Javadoc>
+    get(
+        RawComment* RC,
+        Decl const* D,
+        Config const& config);
+
+    /** Return the number of comments which were found in the cache.
+    */
+    std::size_t
+    hits() const noexcept
+    {
+        return hits_.load();
+    }
+
+    /** Return the number of comments which were parsed.
+    */
+    std::size_t
+    misses() const noexcept
+    {
+        return misses_.load();
+    }
+};
+
 /** Parse a javadoc.
 */
 void
@@ -42,6 +96,16 @@ parseJavadoc(
     Decl const* D,
     Config const& config);
 
+/** Parse a javadoc, reusing the result of an earlier parse.
+*/
+void
+parseJavadoc(
+    std::unique_ptr<Javadoc>& jd,
+    RawComment* RC,
+    Decl const* D,
+    Config const& config,
+    JavadocCache& cache);
+
 } // mrdox
 } // clang
 
@@ -0,0 +1,112 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "TypeTable.hpp"
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/xxhash.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+struct Shard
+{
+    std::mutex mutex;
+    llvm::StringMap<std::shared_ptr<TypeInfo>> types;
+};
+
+constexpr std::size_t NumShards = 16;
+
+/** Return the key of a type.
+
+    The children are identified by address,
+    so the key only covers the top node.
+*/
+std::string
+makeKey(TypeInfo const& I)
+{
+    std::string key;
+    auto const putInt = [&](std::uint64_t v)
+    {
+        key.append(reinterpret_cast<char const*>(&v), sizeof(v));
+    };
+    auto const putString = [&](std::string_view s)
+    {
+        putInt(s.size());
+        key.append(s);
+    };
+    auto const putType = [&](std::shared_ptr<TypeInfo> const& t)
+    {
+        putInt(reinterpret_cast<std::uintptr_t>(t.get()));
+    };
+    putInt(static_cast<std::uint64_t>(I.Kind));
+    visit(I, [&]<class T>(T const& t)
+    {
+        if constexpr(requires { t.CVQualifiers; })
+            putInt(static_cast<std::uint64_t>(t.CVQualifiers));
+        if constexpr(requires { t.Name; })
+            putString(t.Name);
+        if constexpr(requires { t.id; })
+            putString(std::string_view(t.id));
+        if constexpr(requires { t.ParentType; })
+            putType(t.ParentType);
+        if constexpr(requires { t.PointeeType; })
+            putType(t.PointeeType);
+        if constexpr(requires { t.ElementType; })
+            putType(t.ElementType);
+        if constexpr(requires { t.PatternType; })
+            putType(t.PatternType);
+        if constexpr(requires { t.ReturnType; })
+        {
+            putType(t.ReturnType);
+            putInt(t.ParamTypes.size());
+            for(auto const& p : t.ParamTypes)
+                putType(p);
+            putInt(static_cast<std::uint64_t>(t.RefQualifier));
+            putInt(static_cast<std::uint64_t>(t.ExceptionSpec));
+        }
+        if constexpr(requires { t.TemplateArgs; })
+        {
+            putInt(t.TemplateArgs.size());
+            for(auto const& arg : t.TemplateArgs)
+                putString(arg.Value);
+        }
+        if constexpr(requires { t.Bounds; })
+        {
+            putString(t.Bounds.Written.str());
+            putInt(t.Bounds.Value.has_value());
+            putInt(t.Bounds.Value.value_or(0));
+        }
+    });
+    return key;
+}
+
+} // (anon)
+
+std::shared_ptr<TypeInfo>
+internType(std::shared_ptr<TypeInfo> I)
+{
+    if(! I)
+        return I;
+    static std::array<Shard, NumShards> shards;
+    auto const key = makeKey(*I);
+    auto& shard = shards[llvm::xxHash64(key) % NumShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.types.try_emplace(key, std::move(I)).first->second;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,40 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_AST_TYPETABLE_HPP
+#define MRDOX_TOOL_AST_TYPETABLE_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Metadata/Type.hpp>
+#include <memory>
+
+namespace clang {
+namespace mrdox {
+
+/** Return the shared instance of a decoded type.
+
+    Structurally identical types are stored once,
+    and every Info which uses the type holds the
+    same node. The children of the type must
+    already be shared instances, so that they can
+    be compared by address. Types returned from
+    this function must not be modified, and live
+    until the program exits.
+
+    @par Thread Safety
+    May be called concurrently.
+*/
+std::shared_ptr<TypeInfo>
+internType(std::shared_ptr<TypeInfo> I);
+
+} // mrdox
+} // clang
+
+#endif
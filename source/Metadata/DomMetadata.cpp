@@ -9,10 +9,20 @@
 // Official repository: https://github.com/cppalliance/mrdox
 //
 
+#include "Support/PageWriter.hpp"
+#include "Support/PhaseReport.hpp"
 #include "Support/Radix.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Metadata.hpp>
 #include <mrdox/Metadata/DomMetadata.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
 #include <llvm/ADT/StringMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <list>
 #include <memory>
 #include <mutex>
 
@@ -77,7 +87,7 @@ dom::Object
 domCreate(Location const& loc)
 {
     return dom::Object({
-        { "file", loc.Filename },
+        { "file", loc.filename() },
         { "line", loc.LineNumber}
         });
 }
@@ -125,16 +135,16 @@ domCreate(SourceInfo const& I)
 //------------------------------------------------
 
 static dom::Value domCreate(
-    std::unique_ptr<TypeInfo> const&, DomCorpus const&);
+    std::shared_ptr<TypeInfo> const&, DomCorpus const&);
 
 class DomTypeInfoArray : public dom::ArrayImpl
 {
-    std::vector<std::unique_ptr<TypeInfo>> const& list_;
+    std::vector<std::shared_ptr<TypeInfo>> const& list_;
     DomCorpus const& domCorpus_;
 
 public:
     DomTypeInfoArray(
-        std::vector<std::unique_ptr<TypeInfo>> const& list,
+        std::vector<std::shared_ptr<TypeInfo>> const& list,
         DomCorpus const& domCorpus) noexcept
         : list_(list)
         , domCorpus_(domCorpus)
@@ -187,7 +197,7 @@ public:
         return dom::Object({
             { "name", dom::stringOrNull(I.Name) },
             { "type", domCreate(I.Type, domCorpus_) },
-            { "default", dom::stringOrNull(I.Default) }
+            { "default", dom::stringOrNull(I.Default.str()) }
             });
     }
 };
@@ -310,6 +320,16 @@ domCreate(
     return nullptr;
 }
 
+static
+dom::Value
+sourceTextOrNull(
+    Optional<SourceText> const& text)
+{
+    if(! text)
+        return nullptr;
+    return dom::Value(text->str());
+}
+
 static
 dom::Value
 getTParamDefault(
@@ -321,9 +341,9 @@ getTParamDefault(
     case TParamKind::Type:
         return domCreate(I.get<TypeTParam>().Default, domCorpus);
     case TParamKind::NonType:
-        return dom::Value(I.get<NonTypeTParam>().Default);
+        return sourceTextOrNull(I.get<NonTypeTParam>().Default);
     case TParamKind::Template:
-        return dom::Value(I.get<TemplateTParam>().Default);
+        return sourceTextOrNull(I.get<TemplateTParam>().Default);
     default:
         MRDOX_UNREACHABLE();
     }
@@ -334,7 +354,7 @@ getTParamDefault(
 static
 dom::Value
 domCreate(
-    std::unique_ptr<TypeInfo> const& I,
+    std::shared_ptr<TypeInfo> const& I,
     DomCorpus const& domCorpus)
 {
     if(! I)
@@ -382,7 +402,7 @@ domCreate(
                 entries.emplace_back("bounds-value",
                     *t.Bounds.Value);
             entries.emplace_back("bounds-expr",
-                t.Bounds.Written);
+                t.Bounds.Written.str());
         }
 
         if constexpr(T::isFunction())
@@ -465,10 +485,10 @@ public:
     {
         auto const& I = list_.at(i);
         return dom::Object({
-            { "name", I.Name },
+            { "name", dom::String::reference(I.Name) },
             { "value", I.Initializer.Value ?
                 *I.Initializer.Value : dom::Value() },
-            { "expr", I.Initializer.Written },
+            { "expr", I.Initializer.Written.str() },
             { "doc", domCreate(I.javadoc, domCorpus_) }
             });
     }
@@ -484,13 +504,13 @@ template<class T>
 class DomTrancheArray : public dom::ArrayImpl
 {
     std::span<T const*> list_;
-    std::shared_ptr<Interface> sp_;
+    std::shared_ptr<Interface const> sp_;
     DomCorpus const& domCorpus_;
 
 public:
     DomTrancheArray(
         std::span<T const*> list,
-        std::shared_ptr<Interface> const& sp,
+        std::shared_ptr<Interface const> const& sp,
         DomCorpus const& domCorpus)
         : list_(list)
         , sp_(sp)
@@ -512,7 +532,7 @@ public:
 
 class DomTranche : public dom::DefaultObjectImpl
 {
-    std::shared_ptr<Interface> sp_;
+    std::shared_ptr<Interface const> sp_;
     Interface::Tranche const& tranche_;
     DomCorpus const& domCorpus_;
 
@@ -521,7 +541,7 @@ class DomTranche : public dom::DefaultObjectImpl
     dom::Value
     init(
         std::span<T const*> list,
-        std::shared_ptr<Interface> const& sp,
+        std::shared_ptr<Interface const> const& sp,
         DomCorpus const& domCorpus)
     {
         return dom::newArray<DomTrancheArray<T>>(list, sp, domCorpus);
@@ -530,7 +550,7 @@ class DomTranche : public dom::DefaultObjectImpl
 public:
     DomTranche(
         Interface::Tranche const& tranche,
-        std::shared_ptr<Interface> const& sp,
+        std::shared_ptr<Interface const> const& sp,
         DomCorpus const& domCorpus) noexcept
         : dom::DefaultObjectImpl({
             { "records",    init(tranche.Records, sp, domCorpus) },
@@ -552,7 +572,7 @@ class DomInterface : public dom::LazyObjectImpl
 {
     RecordInfo const& I_;
     DomCorpus const& domCorpus_;
-    std::shared_ptr<Interface> mutable sp_;
+    std::shared_ptr<Interface const> mutable sp_;
 
 public:
     DomInterface(
@@ -566,7 +586,7 @@ public:
     dom::Object
     construct() const override
     {
-        sp_ = std::make_shared<Interface>(makeInterface(I_, domCorpus_.corpus));
+        sp_ = domCorpus_.corpus.getInterface(I_);
         return dom::Object({
             { "public", dom::newObject<DomTranche>(sp_->Public, sp_, domCorpus_) },
             { "protected", dom::newObject<DomTranche>(sp_->Protected, sp_, domCorpus_) },
@@ -575,6 +595,69 @@ public:
     }
 };
 
+//------------------------------------------------
+//
+// OverloadInfo
+//
+//------------------------------------------------
+
+class DomFunctionArray : public dom::ArrayImpl
+{
+    std::span<FunctionInfo const*> list_;
+    DomCorpus const& domCorpus_;
+
+public:
+    DomFunctionArray(
+        std::span<FunctionInfo const*> list,
+        DomCorpus const& domCorpus) noexcept
+        : list_(list)
+        , domCorpus_(domCorpus)
+    {
+    }
+
+    std::size_t size() const noexcept override
+    {
+        return list_.size();
+    }
+
+    dom::Value get(std::size_t i) const override
+    {
+        MRDOX_ASSERT(i < list_.size());
+        return domCorpus_.get(*list_[i]);
+    }
+};
+
+class DomOverloadsArray : public dom::ArrayImpl
+{
+    std::span<OverloadInfo const> list_;
+    DomCorpus const& domCorpus_;
+
+public:
+    DomOverloadsArray(
+        std::span<OverloadInfo const> list,
+        DomCorpus const& domCorpus) noexcept
+        : list_(list)
+        , domCorpus_(domCorpus)
+    {
+    }
+
+    std::size_t size() const noexcept override
+    {
+        return list_.size();
+    }
+
+    dom::Value get(std::size_t i) const override
+    {
+        MRDOX_ASSERT(i < list_.size());
+        auto const& O = list_[i];
+        return dom::Object({
+            { "name", O.Name },
+            { "functions", dom::newArray<DomFunctionArray>(
+                O.Functions, domCorpus_) }
+            });
+    }
+};
+
 //------------------------------------------------
 //
 // Info
@@ -598,142 +681,353 @@ getDefaultAccess(
     }
 }
 
+// The object of a symbol. The symbols looked up
+// while one of its values is built are kept, and
+// given to the recorder of each later read, as
+// the value holds their objects.
+class DomSymbol : public dom::LazyFieldsObjectImpl
+{
+    std::mutex mutable mutex_;
+    std::vector<SymbolID> mutable embedded_;
+
+protected:
+    virtual dom::Value build(std::size_t i) const = 0;
+
+    dom::Value
+    compute(std::size_t i) const override
+    {
+        SymbolRecorder recorder;
+        dom::Value value = build(i);
+        auto const& ids = recorder.ids();
+        if(! ids.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            embedded_.insert(embedded_.end(), ids.begin(), ids.end());
+        }
+        return value;
+    }
+
+    void
+    replay() const
+    {
+        if(! SymbolRecorder::active())
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        SymbolRecorder::add(embedded_);
+    }
+
+public:
+    Info const& info;
+
+    DomSymbol(
+        Info const& I,
+        schema_type schema)
+        : LazyFieldsObjectImpl(std::move(schema))
+        , info(I)
+    {
+    }
+
+    reference
+    get(std::size_t i) const override
+    {
+        reference result = LazyFieldsObjectImpl::get(i);
+        replay();
+        return result;
+    }
+
+    dom::Value
+    find(std::string_view key) const override
+    {
+        dom::Value result = LazyFieldsObjectImpl::find(key);
+        replay();
+        return result;
+    }
+};
+
 template<class T>
 requires std::derived_from<T, Info>
-class DomInfo : public dom::LazyObjectImpl
+class DomInfo : public DomSymbol
 {
+    using getter = dom::Value(*)(T const&, DomCorpus const&);
+
+    struct Fields
+    {
+        std::vector<getter> getters;
+        schema_type schema;
+    };
+
+    static Fields const& fields();
+
     T const& I_;
     DomCorpus const& domCorpus_;
 
+    dom::Value
+    build(std::size_t i) const override
+    {
+        return fields().getters[i](I_, domCorpus_);
+    }
+
 public:
     DomInfo(
         T const& I,
-        DomCorpus const& domCorpus) noexcept
-        : I_(I)
+        DomCorpus const& domCorpus)
+        : DomSymbol(I, fields().schema)
+        , I_(I)
         , domCorpus_(domCorpus)
     {
     }
-
-    dom::Object construct() const override;
 };
 
+// Every object of one kind has the same keys,
+// and each value is built when it is read, so
+// a link to a symbol only builds its name.
 template<class T>
 requires std::derived_from<T, Info>
-dom::Object
-DomInfo<T>::construct() const
-{
-    storage_type entries;
-    entries.insert(entries.end(), {
-        { "id",         toBase16(I_.id) },
-        { "kind",       toString(I_.Kind) },
-        { "access",     toString(I_.Access) },
-        { "name",       I_.Name },
-        { "namespace",  dom::newArray<DomSymbolArray>(
-                            I_.Namespace, domCorpus_) },
-        { "doc",        domCreate(I_.javadoc, domCorpus_) }
-        });
-    if constexpr(std::derived_from<T, SourceInfo>)
-    {
-        entries.emplace_back("loc", domCreate(I_));
-    }
-    if constexpr(T::isNamespace())
+auto
+DomInfo<T>::
+fields() -> Fields const&
+{
+    static Fields const result = []
     {
-        entries.insert(entries.end(), {
-            { "members", dom::newArray<DomSymbolArray>(
-                I_.Members, domCorpus_) },
-            { "specializations", nullptr }
-            });
-    }
-    if constexpr(T::isRecord())
-    {
-        entries.insert(entries.end(), {
-            { "tag",            toString(I_.KeyKind) },
-            { "defaultAccess",  getDefaultAccess(I_) },
-            { "isTypedef",      I_.IsTypeDef },
-            { "bases",          dom::newArray<DomBaseArray>(I_.Bases, domCorpus_) },
-            { "friends",        dom::newArray<DomSymbolArray>(I_.Friends, domCorpus_) },
-            { "members",        dom::newArray<DomSymbolArray>(I_.Members, domCorpus_) },
-            { "specializations",dom::newArray<DomSymbolArray>(I_.Specializations, domCorpus_) },
-            { "interface",      dom::newObject<DomInterface>(I_, domCorpus_) },
-            { "template",       domCreate(I_.Template, domCorpus_) }
-            });
-    }
-    if constexpr(T::isFunction())
-    {
-        entries.insert(entries.end(), {
-            { "class",      toString(I_.Class) },
-            { "params",     dom::newArray<DomParamArray>(I_.Params, domCorpus_) },
-            { "return",     domCreate(I_.ReturnType, domCorpus_) },
-            { "template",   domCreate(I_.Template, domCorpus_) },
-
-            { "isVariadic",         I_.specs0.isVariadic.get() },
-            { "isVirtual",          I_.specs0.isVirtual.get() },
-            { "isVirtualAsWritten", I_.specs0.isVirtualAsWritten.get() },
-            { "isPure",             I_.specs0.isPure.get() },
-            { "isDefaulted",        I_.specs0.isDefaulted.get() },
-          { "isExplicitlyDefaulted",I_.specs0.isExplicitlyDefaulted.get() },
-            { "isDeleted",          I_.specs0.isDeleted.get() },
-            { "isDeletedAsWritten", I_.specs0.isDeletedAsWritten.get() },
-            { "isNoReturn",         I_.specs0.isNoReturn.get() },
-            { "hasOverrideAttr",    I_.specs0.hasOverrideAttr.get() },
-            { "hasTrailingReturn",  I_.specs0.hasTrailingReturn.get() },
-            { "isConst",            I_.specs0.isConst.get() },
-            { "isVolatile",         I_.specs0.isVolatile.get() },
-            { "isFinal",            I_.specs0.isFinal.get() },
-            { "isNodiscard",        I_.specs1.isNodiscard.get() },
-
-            { "constexprKind",      toString(I_.specs0.constexprKind.get()) },
-            { "exceptionSpec",      toString(I_.specs0.exceptionSpec.get()) },
-            { "overloadedOperator", I_.specs0.overloadedOperator.get() },
-            { "storageClass",       toString(I_.specs0.storageClass.get()) },
-            { "refQualifier",       toString(I_.specs0.refQualifier.get()) },
-            { "explicitSpec",       toString(I_.specs1.explicitSpec.get()) }
-            });
-    }
-    if constexpr(T::isEnum())
+        std::vector<std::pair<std::string_view, getter>> list;
+
+// the value of a key, from the symbol I and the corpus dc
+#define FIELD(key, ...) list.emplace_back(key, \
+    []([[maybe_unused]] T const& I, \
+        [[maybe_unused]] DomCorpus const& dc) -> dom::Value \
+    { \
+        return __VA_ARGS__; \
+    })
+
+        FIELD("id",         toBase16(I.id));
+        FIELD("kind",       toString(I.Kind));
+        FIELD("access",     toString(I.Access));
+        // the corpus outlives the dom
+        FIELD("name",       dom::String::reference(I.Name));
+        FIELD("namespace",  dom::newArray<DomSymbolArray>(I.Namespace, dc));
+        FIELD("doc",        domCreate(I.javadoc, dc));
+        // null when the symbol has no page
+        FIELD("url",        dc.getPageLink(I.id));
+        if constexpr(std::derived_from<T, SourceInfo>)
+        {
+            FIELD("loc",    domCreate(I));
+        }
+        if constexpr(T::isNamespace())
+        {
+            FIELD("members",    dom::newArray<DomSymbolArray>(I.Members, dc));
+            FIELD("overloads",  dom::newArray<DomOverloadsArray>(
+                                    dc.corpus.overloads(I), dc));
+            FIELD("specializations", nullptr);
+        }
+        if constexpr(T::isRecord())
+        {
+            FIELD("tag",            toString(I.KeyKind));
+            FIELD("defaultAccess",  getDefaultAccess(I));
+            FIELD("isTypedef",      I.IsTypeDef);
+            FIELD("bases",          dom::newArray<DomBaseArray>(I.Bases, dc));
+            FIELD("friends",        dom::newArray<DomSymbolArray>(I.Friends, dc));
+            FIELD("members",        dom::newArray<DomSymbolArray>(I.Members, dc));
+            FIELD("overloads",      dom::newArray<DomOverloadsArray>(
+                                        dc.corpus.overloads(I), dc));
+            FIELD("specializations",dom::newArray<DomSymbolArray>(I.Specializations, dc));
+            FIELD("interface",      dom::newObject<DomInterface>(I, dc));
+            FIELD("template",       domCreate(I.Template, dc));
+            FIELD("derived",        dom::newArray<DomSymbolArray>(
+                                        dc.corpus.references(I.id).Derived, dc));
+            FIELD("usedBy",         dom::newArray<DomSymbolArray>(
+                                        dc.corpus.references(I.id).Functions, dc));
+            FIELD("specializedBy",  dom::newArray<DomSymbolArray>(
+                                        dc.corpus.references(I.id).Specializations, dc));
+        }
+        if constexpr(T::isFunction())
+        {
+            FIELD("class",      toString(I.Class));
+            // templates read the parameters more than once
+            FIELD("params",     dom::newArray<dom::CachedArrayImpl>(
+                                    dom::newArray<DomParamArray>(I.Params, dc)));
+            FIELD("return",     domCreate(I.ReturnType, dc));
+            FIELD("template",   domCreate(I.Template, dc));
+
+            FIELD("isVariadic",         I.specs0.isVariadic.get());
+            FIELD("isVirtual",          I.specs0.isVirtual.get());
+            FIELD("isVirtualAsWritten", I.specs0.isVirtualAsWritten.get());
+            FIELD("isPure",             I.specs0.isPure.get());
+            FIELD("isDefaulted",        I.specs0.isDefaulted.get());
+            FIELD("isExplicitlyDefaulted", I.specs0.isExplicitlyDefaulted.get());
+            FIELD("isDeleted",          I.specs0.isDeleted.get());
+            FIELD("isDeletedAsWritten", I.specs0.isDeletedAsWritten.get());
+            FIELD("isNoReturn",         I.specs0.isNoReturn.get());
+            FIELD("hasOverrideAttr",    I.specs0.hasOverrideAttr.get());
+            FIELD("hasTrailingReturn",  I.specs0.hasTrailingReturn.get());
+            FIELD("isConst",            I.specs0.isConst.get());
+            FIELD("isVolatile",         I.specs0.isVolatile.get());
+            FIELD("isFinal",            I.specs0.isFinal.get());
+            FIELD("isNodiscard",        I.specs1.isNodiscard.get());
+
+            FIELD("constexprKind",      toString(I.specs0.constexprKind.get()));
+            FIELD("exceptionSpec",      toString(I.specs0.exceptionSpec.get()));
+            FIELD("overloadedOperator", I.specs0.overloadedOperator.get());
+            FIELD("storageClass",       toString(I.specs0.storageClass.get()));
+            FIELD("refQualifier",       toString(I.specs0.refQualifier.get()));
+            FIELD("explicitSpec",       toString(I.specs1.explicitSpec.get()));
+        }
+        if constexpr(T::isEnum())
+        {
+            FIELD("type",       domCreate(I.UnderlyingType, dc));
+            FIELD("members",    dom::newArray<DomEnumValueArray>(I.Members, dc));
+            FIELD("isScoped",   I.Scoped);
+            FIELD("usedBy",     dom::newArray<DomSymbolArray>(
+                                    dc.corpus.references(I.id).Functions, dc));
+        }
+        if constexpr(T::isTypedef())
+        {
+            FIELD("type",       domCreate(I.Type, dc));
+            FIELD("template",   domCreate(I.Template, dc));
+            FIELD("isUsing",    I.IsUsing);
+            FIELD("usedBy",     dom::newArray<DomSymbolArray>(
+                                    dc.corpus.references(I.id).Functions, dc));
+        }
+        if constexpr(T::isVariable())
+        {
+            FIELD("type",           domCreate(I.Type, dc));
+            FIELD("template",       domCreate(I.Template, dc));
+            FIELD("storageClass",   toString(I.specs.storageClass));
+        }
+        if constexpr(T::isField())
+        {
+            FIELD("type",           domCreate(I.Type, dc));
+            FIELD("default",        dom::stringOrNull(I.Default));
+            FIELD("isMaybeUnused",  I.specs.isMaybeUnused.get());
+            FIELD("isDeprecated",   I.specs.isDeprecated.get());
+            FIELD("hasNoUniqueAddress", I.specs.hasNoUniqueAddress.get());
+        }
+
+#undef FIELD
+
+        Fields fields;
+        storage_type keys;
+        for(auto const& [key, get] : list)
+        {
+            keys.emplace_back(dom::String(key), nullptr);
+            fields.getters.push_back(get);
+        }
+        fields.schema = std::make_shared<Schema const>(std::move(keys));
+        return fields;
+    }();
+    return result;
+}
+
+//------------------------------------------------
+
+} // (anon)
+
+//------------------------------------------------
+
+namespace {
+
+thread_local SymbolRecorder* currentRecorder = nullptr;
+
+void
+hashValue(
+    llvm::raw_ostream& os,
+    dom::Value const& value)
+{
+    // the kind is written first, so that
+    // different values make different text
+    switch(value.kind())
     {
-        entries.insert(entries.end(), {
-            { "type",       domCreate(I_.UnderlyingType, domCorpus_) },
-            { "members",    dom::newArray<DomEnumValueArray>(I_.Members, domCorpus_) },
-            { "isScoped",   I_.Scoped }
-            });
-    }
-    if constexpr(T::isTypedef())
+    case dom::Kind::Null:
+        os << 'n';
+        break;
+    case dom::Kind::Boolean:
+        os << (value.getBool() ? 't' : 'f');
+        break;
+    case dom::Kind::Integer:
+        os << 'i' << value.getInteger() << ';';
+        break;
+    case dom::Kind::String:
     {
-        entries.insert(entries.end(), {
-            { "type",       domCreate(I_.Type, domCorpus_) },
-            { "template",   domCreate(I_.Template, domCorpus_) },
-            { "isUsing",    I_.IsUsing }
-            });
+        std::string_view const str = value.getString().get();
+        os << 's' << str.size() << ':' << str;
+        break;
     }
-    if constexpr(T::isVariable())
+    case dom::Kind::Array:
     {
-        entries.insert(entries.end(), {
-            { "type",           domCreate(I_.Type, domCorpus_) },
-            { "template",       domCreate(I_.Template, domCorpus_) },
-            { "storageClass",   toString(I_.specs.storageClass) }
-            });
+        dom::Array const& arr = value.getArray();
+        os << 'a' << arr.size() << ':';
+        for(std::size_t i = 0; i < arr.size(); ++i)
+            hashValue(os, arr.at(i));
+        break;
     }
-    if constexpr(T::isField())
+    case dom::Kind::Object:
     {
-        entries.insert(entries.end(), {
-            { "type",           domCreate(I_.Type, domCorpus_) },
-            { "default",        dom::stringOrNull(I_.Default) },
-            { "isMaybeUnused",  I_.specs.isMaybeUnused.get() },
-            { "isDeprecated",   I_.specs.isDeprecated.get() },
-            { "hasNoUniqueAddress", I_.specs.hasNoUniqueAddress.get() }
-            });
+        dom::Object const& obj = value.getObject();
+        if(auto sym = dynamic_cast<DomSymbol const*>(obj.impl().get()))
+        {
+            os << 'y' << llvm::StringRef(sym->info.id);
+            break;
+        }
+        os << 'o' << obj.size() << ':';
+        for(auto const& kv : obj)
+        {
+            os << kv.key.size() << ':' << kv.key.get();
+            hashValue(os, kv.value);
+        }
+        break;
     }
-    if constexpr(T::isSpecialization())
-    {
+    default:
+        MRDOX_UNREACHABLE();
     }
-    return dom::Object(std::move(entries));
 }
 
-//------------------------------------------------
-
 } // (anon)
 
+SymbolRecorder::
+SymbolRecorder() noexcept
+    : outer_(currentRecorder)
+{
+    currentRecorder = this;
+}
+
+SymbolRecorder::
+~SymbolRecorder()
+{
+    currentRecorder = outer_;
+    if(outer_)
+        outer_->ids_.insert(outer_->ids_.end(),
+            ids_.begin(), ids_.end());
+}
+
+bool
+SymbolRecorder::
+active() noexcept
+{
+    return currentRecorder != nullptr;
+}
+
+void
+SymbolRecorder::
+add(std::span<SymbolID const> ids)
+{
+    if(! currentRecorder)
+        return;
+    auto& list = currentRecorder->ids_;
+    list.insert(list.end(), ids.begin(), ids.end());
+    // a page looks up the same few symbols
+    // many times, so the list is kept short
+    if(list.size() >= 4096)
+        (void)currentRecorder->ids();
+}
+
+std::vector<SymbolID> const&
+SymbolRecorder::
+ids()
+{
+    llvm::sort(ids_);
+    ids_.erase(std::unique(ids_.begin(), ids_.end()), ids_.end());
+    return ids_;
+}
+
 //------------------------------------------------
 
 class DomCorpus::Impl
@@ -741,21 +1035,85 @@ class DomCorpus::Impl
     struct value_type
     {
         std::weak_ptr<dom::ObjectImpl> weak;
+
+        // set while the object is retained
+        // by the recently used list
         std::shared_ptr<dom::ObjectImpl> strong;
+        std::list<value_type*>::iterator pos;
     };
 
+    // The cache is split by the first byte of the
+    // symbol ID, which is uniform, so that builder
+    // threads rarely wait on the same lock.
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::StringMap<value_type> infoCache;
+
+        // most recently used first
+        std::list<value_type*> recent;
+    };
+
+    static constexpr std::size_t NumShards = 64;
+
     DomCorpus const& domCorpus_;
     Corpus const& corpus_;
-    llvm::StringMap<value_type> infoCache_;
-    std::mutex mutex_;
+    std::size_t retain_;
+    std::array<Shard, NumShards> shards_;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+    std::atomic<std::size_t> rebuilds_ = 0;
+
+    // once set, the cache is no longer modified
+    bool prebuilt_ = false;
+
+    // Keep the object alive until it falls
+    // off the end of the recently used list.
+    void
+    retain(
+        Shard& shard,
+        value_type& v,
+        std::shared_ptr<dom::ObjectImpl> sp)
+    {
+        if(retain_ == 0)
+            return;
+        if(v.strong)
+        {
+            shard.recent.splice(
+                shard.recent.begin(), shard.recent, v.pos);
+            return;
+        }
+        v.strong = std::move(sp);
+        v.pos = shard.recent.insert(shard.recent.begin(), &v);
+        if(shard.recent.size() > retain_)
+        {
+            shard.recent.back()->strong.reset();
+            shard.recent.pop_back();
+        }
+    }
 
 public:
+    // the pages, by the position of
+    // the symbol in the corpus
+    std::vector<std::string> pageFiles;
+    std::vector<dom::Value> pageLinks;
+
     Impl(
         DomCorpus const& domCorpus,
         Corpus const& corpus) noexcept
         : domCorpus_(domCorpus)
         , corpus_(corpus)
+        , retain_(corpus.config.domCacheSize == 0 ? 0 :
+            (corpus.config.domCacheSize + NumShards - 1) / NumShards)
+    {
+    }
+
+    ~Impl()
     {
+        if(corpus_.config.verboseOutput)
+            reportInfo(
+                "DomCorpus cache: {} hits, {} misses, {} rebuilds",
+                hits_.load(), misses_.load(), rebuilds_.load());
     }
 
     dom::Object
@@ -785,26 +1143,82 @@ public:
             });
     }
 
+    Error
+    prebuild()
+    {
+        MRDOX_ASSERT(! prebuilt_);
+        auto const& index = corpus_.index();
+        std::vector<std::shared_ptr<dom::ObjectImpl>> objects(index.size());
+        constexpr std::size_t grain = 256;
+        TaskGroup taskGroup(corpus_.config.threadPool());
+        for(std::size_t i = 0; i < index.size(); i += grain)
+        {
+            taskGroup.async(
+                [&, i]
+                {
+                    std::size_t const end =
+                        std::min(i + grain, index.size());
+                    for(std::size_t j = i; j < end; ++j)
+                    {
+                        dom::Object obj = get(*index[j]);
+                        // build every value now
+                        for(auto const& kv : obj)
+                            (void)kv;
+                        objects[j] = obj.impl();
+                    }
+                });
+        }
+        auto errors = taskGroup.wait();
+        if(! errors.empty())
+            return Error(errors);
+
+        for(std::size_t i = 0; i < index.size(); ++i)
+        {
+            SymbolID const& id = index[i]->id;
+            Shard& shard = shards_[id.data()[0] % NumShards];
+            auto& v = shard.infoCache[llvm::StringRef(id)];
+            v.weak = objects[i];
+            v.strong = std::move(objects[i]);
+        }
+        prebuilt_ = true;
+        return Error::success();
+    }
+
     dom::Object
     get(SymbolID const& id)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = infoCache_.find(llvm::StringRef(id));
-        if(it == infoCache_.end())
+        Shard& shard = shards_[id.data()[0] % NumShards];
+        if(prebuilt_)
+        {
+            // the table is immutable now
+            auto it = shard.infoCache.find(llvm::StringRef(id));
+            // and shared counters would contend
+            if(it != shard.infoCache.end())
+                return dom::Object(it->second.strong);
+            return create(id);
+        }
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.infoCache.try_emplace(
+            llvm::StringRef(id));
+        value_type& v = it->second;
+        if(! inserted)
         {
-            auto obj = create(id);
-            auto impl = obj.impl();
-            infoCache_.insert(
-                { llvm::StringRef(id), { impl, nullptr } });
-            return obj;
+            auto sp = v.strong ? v.strong : v.weak.lock();
+            if(sp)
+            {
+                ++hits_;
+                retain(shard, v, sp);
+                return dom::Object(std::move(sp));
+            }
+            ++rebuilds_;
+        }
+        else
+        {
+            ++misses_;
         }
-        if(it->second.strong)
-            return dom::Object(it->second.strong);
-        auto sp = it->second.weak.lock();
-        if(sp)
-            return dom::Object(sp);
         auto obj = create(id);
-        it->second.weak = obj.impl();
+        v.weak = obj.impl();
+        retain(shard, v, obj.impl());
         return obj;
     }
 };
@@ -820,10 +1234,20 @@ DomCorpus(
 {
 }
 
+Error
+DomCorpus::
+prebuild() const
+{
+    ScopedPhase phase("dom");
+    return impl_->prebuild();
+}
+
 dom::Object
 DomCorpus::
 get(SymbolID const& id) const
 {
+    MRDOX_PROFILE_ZONE("DomCorpus::get");
+    SymbolRecorder::add(id);
     return impl_->get(id);
 }
 
@@ -831,18 +1255,96 @@ dom::Object
 DomCorpus::
 get(Info const& I) const
 {
+    MRDOX_PROFILE_ZONE("DomCorpus::get");
+    SymbolRecorder::add(I.id);
     return impl_->get(I);
 }
 
+void
+DomCorpus::
+assignPages(
+    std::span<Info const* const> pages,
+    std::string_view extension)
+{
+    auto& files = impl_->pageFiles;
+    auto& links = impl_->pageLinks;
+    files.assign(corpus.headers().size(), {});
+    links.assign(corpus.headers().size(), nullptr);
+
+    // pages in subdirectories link through the
+    // output directory, as pages move between runs
+    std::string up;
+    for(unsigned i = 0; i < corpus.config.shardDepth; ++i)
+        up.append("../");
+
+    char hex[40];
+    for(Info const* I : pages)
+    {
+        auto const i = corpus.indexOf(I->id);
+        if(i == SymbolHeaders::npos)
+            continue;
+        std::string_view const id = toBase16(hex, I->id);
+        if(extension.empty())
+        {
+            links[i] = dom::String("#" + std::string(id));
+            continue;
+        }
+        files[i] = pageFileName(id, extension,
+            corpus.config.shardDepth);
+        links[i] = dom::String(up + files[i]);
+    }
+}
+
+std::string_view
+DomCorpus::
+getPageFile(
+    SymbolID const& id) const noexcept
+{
+    auto const i = corpus.indexOf(id);
+    if(i >= impl_->pageFiles.size())
+        return {};
+    return impl_->pageFiles[i];
+}
+
+dom::Value
+DomCorpus::
+getPageLink(
+    SymbolID const& id) const
+{
+    auto const i = corpus.indexOf(id);
+    if(i >= impl_->pageLinks.size())
+        return nullptr;
+    return impl_->pageLinks[i];
+}
+
 dom::Value
 DomCorpus::
 getOptional(SymbolID const& id) const
 {
     if(id == SymbolID::zero)
         return nullptr;
+    SymbolRecorder::add(id);
     return impl_->get(id);
 }
 
+std::uint64_t
+DomCorpus::
+hash(
+    SymbolID const& id) const
+{
+    if(! corpus.find(id))
+        return 0;
+    dom::Object obj = impl_->get(id);
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    for(auto const& kv : obj)
+    {
+        os << kv.key.size() << ':' << kv.key.get();
+        hashValue(os, kv.value);
+    }
+    return llvm::xxHash64(text);
+}
+
 dom::Value
 DomCorpus::
 getJavadoc(
@@ -19,7 +19,11 @@
 #include <mrdox/Metadata/Record.hpp>
 #include <mrdox/Metadata/Typedef.hpp>
 #include <mrdox/Metadata/Variable.hpp>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/ADT/StringSet.h>
 #include <algorithm>
+#include <type_traits>
 
 namespace clang {
 namespace mrdox {
@@ -44,11 +48,16 @@ class Interface::Build
     Table<FunctionInfo>     staticfuncs_;
     Table<VariableInfo>     staticdata_;
 
+    // the names declared by the record hide
+    // the members of its bases with that name
+    llvm::DenseSet<Info const*> seen_;
+    llvm::StringSet<> hidden_;
+
 public:
     Build(
         Interface& I,
         RecordInfo const& Derived,
-        Corpus const& corpus) noexcept
+        Corpus const& corpus)
         : I_(I)
         , corpus_(corpus)
         , includePrivate_(corpus_.config.includePrivate)
@@ -56,6 +65,8 @@ public:
         // treat `Derived` as a public base,
         append(AccessKind::Public, Derived);
 
+        inherit(Derived);
+
         finish();
     }
 
@@ -77,51 +88,154 @@ private:
         return AccessKind::Public;
     }
 
-    void
-    append(
+    /** Return true if a member is listed with an access.
+    */
+    bool
+    keep(
         AccessKind access,
-        RecordInfo const& From)
+        Info const& I,
+        RecordInfo const& From) const noexcept
+    {
+        if(includePrivate_ || access != AccessKind::Private)
+            return true;
+        // private virtual functions can be overridden
+        if(I.Kind != InfoKind::Function)
+            return false;
+        return ! From.specs.isFinal.get() &&
+            static_cast<FunctionInfo const&>(I).specs0.isVirtual;
+    }
+
+    /** Return the record named by a base, if it was extracted.
+    */
+    RecordInfo const*
+    findBase(
+        BaseInfo const& B) const noexcept
+    {
+        if(! B.Type)
+            return nullptr;
+        SymbolID id = SymbolID::zero;
+        visit(*B.Type, [&]<class Ty>(Ty const& t)
+        {
+            if constexpr(requires { t.id; })
+                id = t.id;
+        });
+        if(id == SymbolID::zero)
+            return nullptr;
+        Info const* I = corpus_.find(id);
+        if(! I || ! I->isRecord())
+            return nullptr;
+        return static_cast<RecordInfo const*>(I);
+    }
+
+    /** Append the members of the bases of a record.
+
+        The interface of each base is that of the
+        corpus, which is built once and includes
+        the members of its own bases, so a hierarchy
+        is walked once however many records derive
+        from it. The access of a member is the most
+        restrictive of its access in the base and
+        the access of the base.
+    */
+    void
+    inherit(
+        RecordInfo const& Derived)
     {
-        for(auto const& B : From.Bases)
+        // a record which derives from itself,
+        // as in a corrupt corpus, is not expanded
+        static thread_local std::vector<RecordInfo const*> building;
+        if(std::ranges::find(building, &Derived) != building.end())
+            return;
+        building.push_back(&Derived);
+        auto const done = llvm::make_scope_exit(
+            [&]
+            {
+                building.pop_back();
+            });
+
+        for(auto const& B : Derived.Bases)
         {
-            auto actualAccess = effectiveAccess(access, B.Access);
             if( ! includePrivate_ &&
-                actualAccess == AccessKind::Private)
+                B.Access == AccessKind::Private)
                 continue;
-            // VFALCO temporary hack to avoid looking up IDs
-            //        which for metadata that is not emitted
-            continue;
-#if 0
-            if(B.Type.id == SymbolID::zero ||
-                ! corpus_.find(B.Type.id))
+            RecordInfo const* Base = findBase(B);
+            if(! Base || Base == &Derived)
                 continue;
-            append(actualAccess,
-                corpus_.get<RecordInfo>(B.Type.id));
-#endif
+            auto const sp = corpus_.getInterface(*Base);
+            inherit(B.Access, *sp, *Base, Derived);
         }
+    }
 
+    void
+    inherit(
+        AccessKind access,
+        Interface const& base,
+        RecordInfo const& Base,
+        RecordInfo const& Derived)
+    {
+        auto const add =
+        [&]<class T>(
+            std::span<T const*> Interface::Tranche::* member,
+            Table<T>& dest)
+        {
+            auto const tranche =
+            [&](AccessKind baseAccess, std::span<T const*> list)
+            {
+                auto const actualAccess = effectiveAccess(access, baseAccess);
+                for(T const* I : list)
+                {
+                    if(hidden_.contains(I->Name) ||
+                        ! keep(actualAccess, *I, Derived))
+                        continue;
+                    if constexpr(std::is_same_v<T, FunctionInfo>)
+                    {
+                        // special members are not inherited
+                        if( I->Class == FunctionClass::Constructor ||
+                            I->Class == FunctionClass::Destructor ||
+                            I->Class == FunctionClass::Deduction)
+                            continue;
+                    }
+                    // a base reached along several paths
+                    // contributes its members once
+                    if(! seen_.insert(I).second)
+                        continue;
+                    dest.push_back({ actualAccess, I });
+                }
+            };
+            tranche(AccessKind::Public, base.Public.*member);
+            tranche(AccessKind::Protected, base.Protected.*member);
+            tranche(AccessKind::Private, base.Private.*member);
+        };
+        add(&Interface::Tranche::Records,          records_);
+        add(&Interface::Tranche::Functions,        functions_);
+        add(&Interface::Tranche::Enums,            enums_);
+        add(&Interface::Tranche::Types,            types_);
+        add(&Interface::Tranche::Data,             data_);
+        add(&Interface::Tranche::StaticFunctions,  staticfuncs_);
+        add(&Interface::Tranche::StaticData,       staticdata_);
+    }
+
+    void
+    append(
+        AccessKind access,
+        RecordInfo const& From)
+    {
         for(auto const& id : From.Members)
         {
             const auto& I = corpus_.get<Info>(id);
+            seen_.insert(&I);
+            if(! I.Name.empty())
+                hidden_.insert(I.Name);
             auto actualAccess = effectiveAccess(access, I.Access);
+            if(! keep(actualAccess, I, From))
+                continue;
             if(I.Kind == InfoKind::Function)
             {
                 const auto& F = static_cast<FunctionInfo const&>(I);
-                auto const isRecFinal = From.specs.isFinal.get();
-                if( includePrivate_ ||
-                    actualAccess != AccessKind::Private || (
-                        ! isRecFinal && F.specs0.isVirtual))
-                {
-                    if(F.specs0.storageClass == StorageClassKind::Static)
-                        staticfuncs_.push_back({ actualAccess, &F });
-                    else
-                        functions_.push_back({ actualAccess, &F });
-                }
-                continue;
-            }
-            else if(! includePrivate_ &&
-                actualAccess == AccessKind::Private)
-            {
+                if(F.specs0.storageClass == StorageClassKind::Static)
+                    staticfuncs_.push_back({ actualAccess, &F });
+                else
+                    functions_.push_back({ actualAccess, &F });
                 continue;
             }
             switch(I.Kind)
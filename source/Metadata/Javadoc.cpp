@@ -12,9 +12,12 @@
 
 #include "Support/Debug.hpp"
 #include <mrdox/Metadata/Javadoc.hpp>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/Support/Error.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/xxhash.h>
 #include <fmt/format.h>
+#include <algorithm>
 
 namespace clang {
 namespace mrdox {
@@ -161,6 +164,103 @@ toString(
     }
 }
 
+//------------------------------------------------
+
+NodePool::
+NodePool(
+    List<Block> const& blocks)
+    : numBlocks_(blocks.size())
+{
+    llvm::StringMap<Str> strings;
+    auto const intern = [&](std::string_view s) -> Str
+    {
+        if(s.empty())
+            return {};
+        auto [it, inserted] = strings.try_emplace(
+            llvm::StringRef(s.data(), s.size()));
+        if(inserted)
+        {
+            it->second = {
+                static_cast<std::uint32_t>(text_.size()),
+                static_cast<std::uint32_t>(s.size()) };
+            text_.append(s);
+        }
+        return it->second;
+    };
+
+    // Breadth-first, so that the children
+    // of each node are laid out together
+    std::vector<std::pair<doc::Node const*, std::size_t>> queue;
+    queue.reserve(blocks.size());
+    nodes_.resize(blocks.size());
+    for(std::size_t i = 0; i < blocks.size(); ++i)
+        queue.emplace_back(blocks[i].get(), i);
+    for(std::size_t q = 0; q < queue.size(); ++q)
+    {
+        doc::Node const* const src = queue[q].first;
+        std::size_t const at = queue[q].second;
+        Node n;
+        n.kind = src->kind;
+        visit(*src, [&](auto const& J)
+        {
+            if constexpr(requires { J.string; })
+                n.string = intern(J.string);
+            if constexpr(requires { J.href; })
+                n.extra = intern(J.href);
+            if constexpr(requires { J.name; })
+                n.extra = intern(J.name);
+            if constexpr(requires { J.style; })
+                n.flag = static_cast<std::uint8_t>(J.style);
+            if constexpr(requires { J.admonish; })
+                n.flag = static_cast<std::uint8_t>(J.admonish);
+            if constexpr(requires { J.direction; })
+                n.flag = static_cast<std::uint8_t>(J.direction);
+            if constexpr(requires { J.children; })
+            {
+                n.first = static_cast<std::uint32_t>(nodes_.size());
+                n.count = static_cast<std::uint32_t>(J.children.size());
+                nodes_.resize(nodes_.size() + J.children.size());
+                for(std::size_t i = 0; i < J.children.size(); ++i)
+                    queue.emplace_back(J.children[i].get(), n.first + i);
+            }
+        });
+        nodes_[at] = n;
+    }
+    text_.shrink_to_fit();
+    overview_ = makeOverview();
+}
+
+NodePool::Overview
+NodePool::
+makeOverview() const
+{
+    // same collation as doc::makeOverview
+    Overview ov;
+    for(auto const& node : blocks())
+    {
+        switch(node.kind)
+        {
+        case Kind::brief:
+        case Kind::paragraph:
+            ov.brief = &node;
+            break;
+        case Kind::returns:
+            ov.returns = &node;
+            break;
+        case Kind::param:
+            ov.params.push_back(&node);
+            break;
+        case Kind::tparam:
+            ov.tparams.push_back(&node);
+            break;
+        default:
+            ov.blocks.push_back(&node);
+            break;
+        }
+    }
+    return ov;
+}
+
 } // doc
 
 //------------------------------------------------
@@ -180,6 +280,59 @@ move_to(
     return it;
 }
 
+/** Append a stable serialization of a node.
+
+    The fields are the ones written to bitcode, so
+    nodes which round-trip equal serialize equal.
+*/
+static
+void
+hashNode(
+    std::string& out,
+    doc::Node const& I)
+{
+    auto const putInt = [&](std::uint32_t v)
+    {
+        out.append(reinterpret_cast<char const*>(&v), sizeof(v));
+    };
+    auto const putString = [&](std::string_view s)
+    {
+        putInt(static_cast<std::uint32_t>(s.size()));
+        out.append(s);
+    };
+    putInt(static_cast<std::uint32_t>(I.kind));
+    doc::visit(I.kind,
+    [&]<class T>()
+    {
+        if constexpr(! std::is_void_v<T>)
+        {
+            auto const& J = static_cast<T const&>(I);
+            if constexpr(requires { J.href; })
+                putString(J.href);
+            if constexpr(requires { J.string; })
+                putString(J.string);
+            if constexpr(requires { J.style; })
+                putInt(static_cast<std::uint32_t>(J.style));
+            if constexpr(requires { J.admonish; })
+                putInt(static_cast<std::uint32_t>(J.admonish));
+            if constexpr(requires { J.direction; })
+                putInt(static_cast<std::uint32_t>(J.direction));
+            if constexpr(requires { J.name; })
+                putString(J.name);
+            if constexpr(requires { J.children; })
+            {
+                putInt(static_cast<std::uint32_t>(J.children.size()));
+                for(auto const& child : J.children)
+                    hashNode(out, *child);
+            }
+        }
+        else
+        {
+            MRDOX_UNREACHABLE();
+        }
+    });
+}
+
 //------------------------------------------------
 
 Javadoc::
@@ -242,6 +395,23 @@ makeOverview() const
     return doc::makeOverview(blocks_);
 }
 
+void
+Javadoc::
+computeHash()
+{
+    std::string out;
+    for(auto const& block : blocks_)
+        hashNode(out, *block);
+    hashes_.assign(1, llvm::xxHash64(out));
+}
+
+void
+Javadoc::
+buildPool()
+{
+    pool_ = doc::NodePool(blocks_);
+}
+
 std::string
 Javadoc::
 emplace_back(
@@ -305,6 +475,7 @@ emplace_back(
     }
 
     blocks_.emplace_back(std::move(block));
+    pool_ = {};
     return result;
 }
 
@@ -313,6 +484,21 @@ Javadoc::
 append(
     Javadoc&& other)
 {
+    // The hashes only describe the result when
+    // both sides know the hashes of their comments.
+    if((hashes_.empty() && ! blocks_.empty()) ||
+        (other.hashes_.empty() && ! other.blocks_.empty()))
+    {
+        hashes_.clear();
+    }
+    else
+    {
+        for(auto hash : other.hashes_)
+            if(std::find(hashes_.begin(), hashes_.end(),
+                    hash) == hashes_.end())
+                hashes_.push_back(hash);
+    }
+
     // VFALCO What about the returned strings,
     // for warnings and errors?
     for(auto&& block : other.blocks_)
@@ -330,6 +516,7 @@ append(doc::List<doc::Node>&& blocks)
         blocks_.emplace_back(
             static_cast<doc::Block*>(block.release()));
     }
+    pool_ = {};
 }
 
 } // mrdox
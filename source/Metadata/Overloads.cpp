@@ -12,6 +12,7 @@
 #include <mrdox/Metadata/Function.hpp>
 #include <mrdox/Metadata/Namespace.hpp>
 #include <mrdox/Metadata/Overloads.hpp>
+#include <mrdox/Metadata/Record.hpp>
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/StringRef.h>
 
@@ -20,16 +21,15 @@ namespace mrdox {
 
 NamespaceOverloads::
 NamespaceOverloads(
-    NamespaceInfo const& I,
+    Info const& I,
     std::vector<FunctionInfo const*> data)
     : data_(std::move(data))
 {
     // Sort to group the overloads, preserving order
-    llvm::stable_sort(data_,
-        []( FunctionInfo const* f0,
-            FunctionInfo const* f1)
+    sortBySymbolName(data_,
+        [](FunctionInfo const* f)
         {
-            return compareSymbolNames(f0->Name, f1->Name) < 0;
+            return std::string_view(f->Name);
         });
 
     // Find the end of the range of each overload set
@@ -51,13 +51,14 @@ NamespaceOverloads(
     }
 }
 
-NamespaceOverloads
-makeNamespaceOverloads(
-    NamespaceInfo const& I,
+static
+std::vector<FunctionInfo const*>
+findFunctions(
+    std::vector<SymbolID> const& members,
     Corpus const& corpus)
 {
     std::vector<FunctionInfo const*> data;
-    for(auto const& id : I.Members)
+    for(auto const& id : members)
     {
         if(const Info* info = corpus.find(id);
             info && info->isFunction())
@@ -66,8 +67,25 @@ makeNamespaceOverloads(
                 const FunctionInfo*>(info));
         }
     }
+    return data;
+}
 
-    return NamespaceOverloads(I, std::move(data));
+NamespaceOverloads
+makeNamespaceOverloads(
+    NamespaceInfo const& I,
+    Corpus const& corpus)
+{
+    return NamespaceOverloads(I,
+        findFunctions(I.Members, corpus));
+}
+
+NamespaceOverloads
+makeRecordOverloads(
+    RecordInfo const& I,
+    Corpus const& corpus)
+{
+    return NamespaceOverloads(I,
+        findFunctions(I.Members, corpus));
 }
 
 } // mrdox
@@ -10,8 +10,10 @@
 //
 
 #include "Reduce.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Metadata.hpp>
 #include <mrdox/Platform.hpp>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/STLExtras.h>
 
 namespace clang {
@@ -27,8 +29,8 @@ struct LocationEqual
         Location const& L1) const noexcept
     {
         return
-            std::tie(L0.LineNumber, L0.Filename) ==
-            std::tie(L1.LineNumber, L1.Filename);
+            std::tie(L0.LineNumber, L0.FileIndex) ==
+            std::tie(L1.LineNumber, L1.FileIndex);
     }
 };
 
@@ -37,14 +39,17 @@ struct LocationLess
     // This operator is used to sort a vector of Locations.
     // No specific order (attributes more important than others) is required. Any
     // sort is enough, the order is only needed to call std::unique after sorting
-    // the vector.
+    // the vector. The file indexes depend on the order in which the
+    // files were seen, so the names are compared to keep the output stable.
     bool operator()(
         Location const& L0,
         Location const& L1) const noexcept
     {
-        return
-            std::tie(L0.LineNumber, L0.Filename) <
-            std::tie(L1.LineNumber, L1.Filename);
+        if(L0.LineNumber != L1.LineNumber)
+            return L0.LineNumber < L1.LineNumber;
+        if(L0.FileIndex == L1.FileIndex)
+            return false;
+        return L0.filename() < L1.filename();
     }
 };
 
@@ -64,6 +69,19 @@ static void merge(Javadoc& I, Javadoc&& other)
     // FIXME: this doesn't merge parameter information;
     // parameters with the same name but different direction
     // or descriptions end up being duplicated
+    if(! other.hashes().empty() && ! I.hashes().empty())
+    {
+        // A comment already merged into I needs no
+        // node comparison; the same header comment
+        // arrives once from every including TU.
+        if(llvm::all_of(other.hashes(), [&](std::uint64_t hash)
+            {
+                return llvm::is_contained(I.hashes(), hash);
+            }))
+            return;
+        I.append(std::move(other));
+        return;
+    }
     if(other != I)
     {
         // Unconditionally extend the blocks
@@ -97,11 +115,8 @@ static void mergeSourceInfo(
     if (! I.DefLoc)
         I.DefLoc = std::move(Other.DefLoc);
     // Unconditionally extend the list of locations, since we want all of them.
+    // Duplicates are removed once, by canonicalize.
     std::move(Other.Loc.begin(), Other.Loc.end(), std::back_inserter(I.Loc));
-    // VFALCO This has the fortuituous effect of also canonicalizing
-    llvm::sort(I.Loc, LocationLess{});
-    auto Last = std::unique(I.Loc.begin(), I.Loc.end(), LocationEqual{});
-    I.Loc.erase(Last, I.Loc.end());
 }
 
 static void mergeExprInfo(
@@ -124,19 +139,15 @@ static void mergeExprInfo(
         I.Value = std::move(Other.Value);
 }
 
+// Lists of children are appended by merge, and
+// duplicates are removed once by canonicalize.
 static
 void
 reduceSymbolIDs(
     std::vector<SymbolID>& list,
     std::vector<SymbolID>&& otherList)
 {
-    for(auto const& id : otherList)
-    {
-        auto it = llvm::find(list, id);
-        if(it != list.end())
-            continue;
-        list.push_back(id);
-    }
+    list.insert(list.end(), otherList.begin(), otherList.end());
 }
 
 static
@@ -145,18 +156,58 @@ reduceSpecializedMembers(
     std::vector<SpecializedMember>& list,
     std::vector<SpecializedMember>&& otherList)
 {
-    for(auto const& ref : otherList)
+    list.insert(list.end(), otherList.begin(), otherList.end());
+}
+
+// Remove duplicates, keeping the first occurrence
+template<class T, class GetID>
+static
+void
+uniqueByID(
+    std::vector<T>& list,
+    GetID const& getID)
+{
+    if(list.size() < 2)
+        return;
+    // the kept elements are compacted in place, and
+    // the set refers to those before the output
+    // position, which are not moved again
+    llvm::DenseSet<llvm::StringRef> seen;
+    seen.reserve(list.size());
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < list.size(); ++i)
     {
-        auto it = llvm::find_if(
-            list,
-            [ref](SpecializedMember const& other) noexcept
-            {
-                return other.Specialized == ref.Specialized;
-            });
-        if(it != list.end())
+        if(seen.contains(llvm::StringRef(getID(list[i]))))
             continue;
-        list.push_back(ref);
+        if(n != i)
+            list[n] = std::move(list[i]);
+        seen.insert(llvm::StringRef(getID(list[n])));
+        ++n;
     }
+    list.erase(list.begin() + n, list.end());
+}
+
+static
+void
+canonicalizeSymbolIDs(
+    std::vector<SymbolID>& list)
+{
+    uniqueByID(list,
+        [](SymbolID const& id) -> SymbolID const&
+        {
+            return id;
+        });
+}
+
+static
+void
+canonicalizeSourceInfo(
+    SourceInfo& I)
+{
+    // VFALCO This has the fortuituous effect of also canonicalizing
+    llvm::sort(I.Loc, LocationLess{});
+    auto Last = std::unique(I.Loc.begin(), I.Loc.end(), LocationEqual{});
+    I.Loc.erase(Last, I.Loc.end());
 }
 
 void merge(NamespaceInfo& I, NamespaceInfo&& Other)
@@ -275,6 +326,97 @@ void merge(SpecializationInfo& I, SpecializationInfo&& Other)
 
 }
 
+void
+canonicalize(Info& I)
+{
+    switch(I.Kind)
+    {
+    case InfoKind::Namespace:
+    {
+        auto& J = static_cast<NamespaceInfo&>(I);
+        canonicalizeSymbolIDs(J.Members);
+        canonicalizeSymbolIDs(J.Specializations);
+        break;
+    }
+    case InfoKind::Record:
+    {
+        auto& J = static_cast<RecordInfo&>(I);
+        canonicalizeSymbolIDs(J.Friends);
+        canonicalizeSymbolIDs(J.Members);
+        canonicalizeSymbolIDs(J.Specializations);
+        canonicalizeSourceInfo(J);
+        break;
+    }
+    case InfoKind::Specialization:
+    {
+        auto& J = static_cast<SpecializationInfo&>(I);
+        uniqueByID(J.Members,
+            [](SpecializedMember const& m) -> SymbolID const&
+            {
+                return m.Specialized;
+            });
+        break;
+    }
+    case InfoKind::Function:
+        canonicalizeSourceInfo(static_cast<FunctionInfo&>(I));
+        break;
+    case InfoKind::Enum:
+        canonicalizeSourceInfo(static_cast<EnumInfo&>(I));
+        break;
+    case InfoKind::Field:
+        canonicalizeSourceInfo(static_cast<FieldInfo&>(I));
+        break;
+    case InfoKind::Typedef:
+        canonicalizeSourceInfo(static_cast<TypedefInfo&>(I));
+        break;
+    case InfoKind::Variable:
+        canonicalizeSourceInfo(static_cast<VariableInfo&>(I));
+        break;
+    default:
+        break;
+    }
+}
+
+//------------------------------------------------
+
+namespace {
+
+template<class T>
+void
+reduceInto(
+    std::unique_ptr<Info>& slot,
+    Info& I)
+{
+    if(! slot)
+        slot = std::make_unique<T>(I.id);
+    merge(static_cast<T&>(*slot), std::move(static_cast<T&>(I)));
+}
+
+} // (anon)
+
+bool
+reduceInto(
+    std::unique_ptr<Info>& slot,
+    Info& I)
+{
+    MRDOX_PROFILE_ZONE("reduceInto");
+    if(slot && slot->Kind != I.Kind)
+        return false;
+    switch(I.Kind)
+    {
+    case InfoKind::Namespace:      reduceInto<NamespaceInfo>(slot, I); break;
+    case InfoKind::Record:         reduceInto<RecordInfo>(slot, I); break;
+    case InfoKind::Enum:           reduceInto<EnumInfo>(slot, I); break;
+    case InfoKind::Function:       reduceInto<FunctionInfo>(slot, I); break;
+    case InfoKind::Typedef:        reduceInto<TypedefInfo>(slot, I); break;
+    case InfoKind::Variable:       reduceInto<VariableInfo>(slot, I); break;
+    case InfoKind::Field:          reduceInto<FieldInfo>(slot, I); break;
+    case InfoKind::Specialization: reduceInto<SpecializationInfo>(slot, I); break;
+    default:
+        return false;
+    }
+    return true;
+}
 
 } // mrdox
 } // clang
@@ -30,6 +30,17 @@ void merge(FieldInfo& I, FieldInfo&& Other);
 void merge(VariableInfo& I, VariableInfo&& Other);
 void merge(SpecializationInfo& I, SpecializationInfo&& Other);
 
+/** Remove the duplicates which merge leaves behind.
+
+    To keep reduction linear in the number of
+    inputs, merging only appends locations and
+    lists of children. This sorts and uniques the
+    locations and removes repeated children,
+    keeping the first occurrence, once all the
+    inputs for a symbol have been merged.
+*/
+void canonicalize(Info& I);
+
 //
 // This file defines the merging of different types of infos. The data in the
 // calling Info is preserved during a merge unless that field is empty or
@@ -56,9 +67,26 @@ reduce(
     T* Tmp = static_cast<T*>(Merged.get());
     for (auto& I : Values)
         merge(*Tmp, std::move(*static_cast<T*>(I.get())));
+    canonicalize(*Merged);
     return std::move(Merged);
 }
 
+/** Merge an Info into the running result for its symbol.
+
+    When the slot is empty, it receives a new Info
+    of the same kind first. Once every Info for the
+    symbol is merged, @ref canonicalize makes the
+    result the same as from @ref reduce. Each
+    decoded Info can be released as soon as it is
+    merged.
+
+    @return `false` if the kinds do not match.
+*/
+bool
+reduceInto(
+    std::unique_ptr<Info>& slot,
+    Info& I);
+
 // Return the index of the matching child in the list,
 // or -1 if merge is not necessary.
 template <typename T>
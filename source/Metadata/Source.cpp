@@ -10,9 +10,147 @@
 //
 
 #include <mrdox/Metadata/Source.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/xxhash.h>
+#include <array>
+#include <atomic>
+#include <mutex>
 
 namespace clang {
 namespace mrdox {
 
+namespace {
+
+struct FileEntry
+{
+    std::string_view name;
+    bool inRootDir = false;
+};
+
+/*  The entries are stored in chunks which are
+    never moved or freed, so an index can be
+    resolved without a lock by any thread which
+    obtained it.
+*/
+class FileTable
+{
+    static constexpr std::uint32_t ChunkBits = 12;
+    static constexpr std::uint32_t ChunkSize = 1U << ChunkBits;
+    static constexpr std::uint32_t MaxChunks = 1U << 12;
+    static constexpr std::size_t NumShards = 16;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::StringMap<std::uint32_t> indexes;
+    };
+
+    std::array<Shard, NumShards> shards_;
+    std::mutex growMutex_;
+    std::uint32_t size_ = 1;
+    std::array<std::atomic<FileEntry*>, MaxChunks> chunks_{};
+
+public:
+    FileTable()
+    {
+        // index zero is the empty name
+        chunks_[0].store(new FileEntry[ChunkSize]());
+    }
+
+    std::uint32_t
+    insert(
+        std::string_view name,
+        bool inRootDir)
+    {
+        if(name.empty())
+            return 0;
+        llvm::StringRef key(name.data(), name.size());
+        Shard& shard = shards_[llvm::xxHash64(key) % NumShards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.indexes.try_emplace(key, 0);
+        if(! inserted)
+            return it->second;
+
+        std::uint32_t index;
+        FileEntry* chunk;
+        {
+            std::lock_guard<std::mutex> growLock(growMutex_);
+            index = size_++;
+            MRDOX_ASSERT((index >> ChunkBits) < MaxChunks);
+            chunk = chunks_[index >> ChunkBits].load(
+                std::memory_order_relaxed);
+            if(! chunk)
+            {
+                chunk = new FileEntry[ChunkSize]();
+                chunks_[index >> ChunkBits].store(
+                    chunk, std::memory_order_release);
+            }
+        }
+        // the key of a StringMap entry does not move
+        FileEntry& entry = chunk[index & (ChunkSize - 1)];
+        entry.name = std::string_view(
+            it->getKey().data(), it->getKey().size());
+        entry.inRootDir = inRootDir;
+        it->second = index;
+        return index;
+    }
+
+    FileEntry const&
+    operator[](
+        std::uint32_t index) const noexcept
+    {
+        return chunks_[index >> ChunkBits].load(
+            std::memory_order_acquire)[index & (ChunkSize - 1)];
+    }
+};
+
+FileTable&
+fileTable()
+{
+    static FileTable table;
+    return table;
+}
+
+} // (anon)
+
+std::uint32_t
+getFileIndex(
+    std::string_view filename,
+    bool in_root_dir)
+{
+    return fileTable().insert(filename, in_root_dir);
+}
+
+std::string_view
+getFileName(
+    std::uint32_t index) noexcept
+{
+    return fileTable()[index].name;
+}
+
+Location::
+Location(
+    int line,
+    std::string_view filename,
+    bool in_root_dir)
+    : FileIndex(getFileIndex(filename, in_root_dir))
+    , LineNumber(line)
+{
+}
+
+std::string_view
+Location::
+filename() const noexcept
+{
+    return getFileName(FileIndex);
+}
+
+bool
+Location::
+isFileInRootDir() const noexcept
+{
+    return fileTable()[FileIndex].inRootDir;
+}
+
 } // mrdox
 } // clang
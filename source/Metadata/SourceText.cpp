@@ -0,0 +1,85 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include <mrdox/Metadata/Source.hpp>
+#include <mrdox/Metadata/SourceText.hpp>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <array>
+#include <memory>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+// The files are mapped the first time one of
+// their ranges is read, and stay mapped until
+// the program exits. A file which could not be
+// read is remembered as an empty buffer.
+class MappedFiles
+{
+    static constexpr std::size_t NumShards = 16;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::DenseMap<std::uint32_t,
+            std::unique_ptr<llvm::MemoryBuffer>> files;
+    };
+
+    std::array<Shard, NumShards> shards_;
+
+public:
+    std::string_view
+    get(
+        std::uint32_t index)
+    {
+        Shard& shard = shards_[index % NumShards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.files.try_emplace(index);
+        if(inserted)
+        {
+            auto buf = llvm::MemoryBuffer::getFile(
+                getFileName(index), false, false);
+            if(buf)
+                it->second = std::move(*buf);
+        }
+        if(! it->second)
+            return {};
+        llvm::StringRef const data = it->second->getBuffer();
+        return std::string_view(data.data(), data.size());
+    }
+};
+
+MappedFiles&
+mappedFiles()
+{
+    static MappedFiles files;
+    return files;
+}
+
+} // (anon)
+
+std::string_view
+SourceText::
+str() const
+{
+    if(file_ == 0)
+        return text_;
+    std::string_view const data = mappedFiles().get(file_);
+    if(offset_ > data.size() || size_ > data.size() - offset_)
+        return {};
+    return data.substr(offset_, size_);
+}
+
+} // mrdox
+} // clang
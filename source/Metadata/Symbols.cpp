@@ -86,5 +86,40 @@ do_tiebreak:
     return std::strong_ordering::equivalent;
 }
 
+std::string
+makeSymbolNameKey(
+    std::string_view symbolName)
+{
+    std::string key;
+    key.resize(2 * symbolName.size());
+    auto out = key.begin();
+    for(char c : symbolName)
+        *out++ = static_cast<char>(tolower(c));
+    // the first different character breaks the
+    // tie, with the greater char coming first
+    for(char c : symbolName)
+        *out++ = static_cast<char>(CHAR_MAX - c);
+    return key;
+}
+
+std::strong_ordering
+compareSymbolNameKeys(
+    std::string_view key0,
+    std::string_view key1) noexcept
+{
+    auto const n0 = key0.size() / 2;
+    auto const n1 = key1.size() / 2;
+    // string_view compares as unsigned char
+    if(int c = key0.substr(0, n0).compare(key1.substr(0, n1)))
+        return c < 0 ?
+            std::strong_ordering::less :
+            std::strong_ordering::greater;
+    if(int c = key0.substr(n0).compare(key1.substr(n1)))
+        return c < 0 ?
+            std::strong_ordering::less :
+            std::strong_ordering::greater;
+    return std::strong_ordering::equivalent;
+}
+
 } // mrdox
 } // clang
@@ -225,7 +225,7 @@ operator()(
     if constexpr(T::isArray())
         write('[', t.Bounds.Value ?
             std::to_string(*t.Bounds.Value) :
-            t.Bounds.Written, ']');
+            std::string(t.Bounds.Written.str()), ']');
 
     if constexpr(T::isFunction())
     {
@@ -0,0 +1,267 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/Allocations.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace clang {
+namespace mrdox {
+
+#ifdef MRDOX_TRACK_ALLOCATIONS
+
+namespace {
+
+// The counters of a thread are only written by
+// the thread, and are never freed, so that the
+// allocations of a thread which exited are kept.
+struct ThreadCounts
+{
+    std::atomic<std::uint64_t> count = 0;
+    std::atomic<std::uint64_t> bytes = 0;
+    ThreadCounts* next = nullptr;
+};
+
+std::atomic<ThreadCounts*> threadList = nullptr;
+thread_local ThreadCounts* threadCounts = nullptr;
+
+void
+countAllocation(
+    std::size_t size) noexcept
+{
+    ThreadCounts* c = threadCounts;
+    if(! c)
+    {
+        // the counters cannot come from
+        // the allocator which they count
+        void* p = std::malloc(sizeof(ThreadCounts));
+        if(! p)
+            return;
+        c = ::new(p) ThreadCounts;
+        c->next = threadList.load(std::memory_order_relaxed);
+        while(! threadList.compare_exchange_weak(
+            c->next, c, std::memory_order_release,
+                std::memory_order_relaxed))
+        {
+        }
+        threadCounts = c;
+    }
+    // a load and a store are cheaper than an
+    // atomic increment, and there is one writer
+    c->count.store(c->count.load(
+        std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    c->bytes.store(c->bytes.load(
+        std::memory_order_relaxed) + size,
+            std::memory_order_relaxed);
+}
+
+} // (anon)
+
+bool
+isTrackingAllocations() noexcept
+{
+    return true;
+}
+
+AllocationCounts
+getAllocationCounts() noexcept
+{
+    AllocationCounts result;
+    for(ThreadCounts const* c = threadList.load(
+        std::memory_order_acquire); c; c = c->next)
+    {
+        result.count += c->count.load(std::memory_order_relaxed);
+        result.bytes += c->bytes.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+std::vector<AllocationCounts>
+getThreadAllocationCounts()
+{
+    std::vector<AllocationCounts> result;
+    for(ThreadCounts const* c = threadList.load(
+        std::memory_order_acquire); c; c = c->next)
+    {
+        result.push_back({
+            c->count.load(std::memory_order_relaxed),
+            c->bytes.load(std::memory_order_relaxed) });
+    }
+    // new threads are at the front of the list
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+#else
+
+bool
+isTrackingAllocations() noexcept
+{
+    return false;
+}
+
+AllocationCounts
+getAllocationCounts() noexcept
+{
+    return {};
+}
+
+std::vector<AllocationCounts>
+getThreadAllocationCounts()
+{
+    return {};
+}
+
+#endif
+
+} // mrdox
+} // clang
+
+//------------------------------------------------
+//
+// Global allocator
+//
+//------------------------------------------------
+
+#ifdef MRDOX_TRACK_ALLOCATIONS
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace {
+
+void*
+allocate(
+    std::size_t size,
+    std::nothrow_t const&) noexcept
+{
+    clang::mrdox::countAllocation(size);
+    if(size == 0)
+        size = 1;
+    for(;;)
+    {
+        if(void* p = std::malloc(size))
+            return p;
+        std::new_handler handler = std::get_new_handler();
+        if(! handler)
+            return nullptr;
+        try
+        {
+            handler();
+        }
+        catch(std::bad_alloc const&)
+        {
+            return nullptr;
+        }
+    }
+}
+
+void*
+allocate(
+    std::size_t size,
+    std::align_val_t align,
+    std::nothrow_t const&) noexcept
+{
+    clang::mrdox::countAllocation(size);
+    if(size == 0)
+        size = 1;
+    auto const alignment = std::max(
+        static_cast<std::size_t>(align), sizeof(void*));
+    for(;;)
+    {
+#if defined(_WIN32)
+        if(void* p = _aligned_malloc(size, alignment))
+            return p;
+#else
+        void* p;
+        if(posix_memalign(&p, alignment, size) == 0)
+            return p;
+#endif
+        std::new_handler handler = std::get_new_handler();
+        if(! handler)
+            return nullptr;
+        try
+        {
+            handler();
+        }
+        catch(std::bad_alloc const&)
+        {
+            return nullptr;
+        }
+    }
+}
+
+void*
+allocate(
+    std::size_t size)
+{
+    if(void* p = allocate(size, std::nothrow))
+        return p;
+    throw std::bad_alloc();
+}
+
+void*
+allocate(
+    std::size_t size,
+    std::align_val_t align)
+{
+    if(void* p = allocate(size, align, std::nothrow))
+        return p;
+    throw std::bad_alloc();
+}
+
+void
+deallocate(
+    void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+deallocate(
+    void* p,
+    std::align_val_t) noexcept
+{
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+} // (anon)
+
+void* operator new(std::size_t n) { return allocate(n); }
+void* operator new[](std::size_t n) { return allocate(n); }
+void* operator new(std::size_t n, std::nothrow_t const& t) noexcept { return allocate(n, t); }
+void* operator new[](std::size_t n, std::nothrow_t const& t) noexcept { return allocate(n, t); }
+void* operator new(std::size_t n, std::align_val_t a) { return allocate(n, a); }
+void* operator new[](std::size_t n, std::align_val_t a) { return allocate(n, a); }
+void* operator new(std::size_t n, std::align_val_t a, std::nothrow_t const& t) noexcept { return allocate(n, a, t); }
+void* operator new[](std::size_t n, std::align_val_t a, std::nothrow_t const& t) noexcept { return allocate(n, a, t); }
+
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { deallocate(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { deallocate(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t a) noexcept { deallocate(p, a); }
+void operator delete[](void* p, std::align_val_t a) noexcept { deallocate(p, a); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept { deallocate(p, a); }
+void operator delete[](void* p, std::size_t, std::align_val_t a) noexcept { deallocate(p, a); }
+void operator delete(void* p, std::align_val_t a, std::nothrow_t const&) noexcept { deallocate(p, a); }
+void operator delete[](void* p, std::align_val_t a, std::nothrow_t const&) noexcept { deallocate(p, a); }
+
+#endif
@@ -0,0 +1,63 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_ALLOCATIONS_HPP
+#define MRDOX_TOOL_SUPPORT_ALLOCATIONS_HPP
+
+#include <mrdox/Platform.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** The allocations made through the global allocator.
+*/
+struct AllocationCounts
+{
+    /** The number of allocations.
+    */
+    std::uint64_t count = 0;
+
+    /** The number of bytes requested.
+    */
+    std::uint64_t bytes = 0;
+};
+
+/** Return true if allocations are counted.
+
+    Allocations are only counted when the
+    program is built with the CMake option
+    MRDOX_TRACK_ALLOCATIONS, which replaces
+    the global `operator new`. Otherwise the
+    counts are always zero.
+*/
+bool
+isTrackingAllocations() noexcept;
+
+/** Return the allocations of all threads so far.
+*/
+AllocationCounts
+getAllocationCounts() noexcept;
+
+/** Return the allocations of each thread so far.
+
+    The threads are in the order in which they
+    first allocated, so that the element for a
+    thread has the same index in every result.
+    Threads which have exited are included.
+*/
+std::vector<AllocationCounts>
+getThreadAllocationCounts();
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,184 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/Compression.hpp"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/CRC.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Endian.h>
+#include <algorithm>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+// The header of a gzip member: the magic, the
+// deflate method, no flags, no time, no extra
+// flags, and an unknown operating system.
+constexpr char gzipHeader[] = {
+    '\x1f', '\x8b', '\x08', '\x00',
+    '\x00', '\x00', '\x00', '\x00',
+    '\x00', '\xff' };
+
+// A zlib stream is a deflate stream with a
+// two byte header and an Adler-32 trailer,
+// so it is rewrapped as a gzip member.
+void
+appendGzip(
+    llvm::ArrayRef<std::uint8_t> input,
+    std::string& dest)
+{
+    llvm::SmallVector<std::uint8_t, 0> z;
+    llvm::compression::zlib::compress(input, z);
+    MRDOX_ASSERT(z.size() >= 6);
+    dest.append(gzipHeader, sizeof(gzipHeader));
+    dest.append(reinterpret_cast<char const*>(
+        z.data() + 2), z.size() - 6);
+    char trailer[8];
+    llvm::support::endian::write32le(trailer, llvm::crc32(input));
+    llvm::support::endian::write32le(trailer + 4,
+        static_cast<std::uint32_t>(input.size()));
+    dest.append(trailer, sizeof(trailer));
+}
+
+} // (anon)
+
+Expected<OutputCompression>
+parseOutputCompression(
+    std::string_view name)
+{
+    if(name.empty() || name == "none")
+        return OutputCompression::none;
+    if(name == "gzip")
+    {
+        if(! llvm::compression::zlib::isAvailable())
+            return formatError("output-compression \"gzip\" needs zlib, which is not in this build");
+        return OutputCompression::gzip;
+    }
+    if(name == "zstd")
+    {
+        if(! llvm::compression::zstd::isAvailable())
+            return formatError("output-compression \"zstd\" needs zstd, which is not in this build");
+        return OutputCompression::zstd;
+    }
+    return formatError("output-compression \"{}\" is not \"none\", \"gzip\" or \"zstd\"", name);
+}
+
+std::string_view
+compressedExtension(
+    OutputCompression compression) noexcept
+{
+    switch(compression)
+    {
+    case OutputCompression::gzip:
+        return ".gz";
+    case OutputCompression::zstd:
+        return ".zst";
+    default:
+        return {};
+    }
+}
+
+void
+compressAppend(
+    OutputCompression compression,
+    std::string_view text,
+    std::string& dest)
+{
+    llvm::ArrayRef<std::uint8_t> input(
+        reinterpret_cast<std::uint8_t const*>(text.data()),
+        text.size());
+    switch(compression)
+    {
+    case OutputCompression::gzip:
+        appendGzip(input, dest);
+        break;
+    case OutputCompression::zstd:
+    {
+        llvm::SmallVector<std::uint8_t, 0> frame;
+        llvm::compression::zstd::compress(input, frame);
+        dest.append(reinterpret_cast<char const*>(
+            frame.data()), frame.size());
+        break;
+    }
+    default:
+        dest.append(text);
+        break;
+    }
+}
+
+//------------------------------------------------
+
+CompressedOstream::
+CompressedOstream(
+    llvm::raw_ostream& os,
+    OutputCompression compression)
+    : os_(os)
+    , compression_(compression)
+{
+    // the block is the buffer
+    SetUnbuffered();
+}
+
+CompressedOstream::
+~CompressedOstream()
+{
+    close();
+}
+
+void
+CompressedOstream::
+close()
+{
+    flush();
+    if(! block_.empty())
+        writeBlock();
+}
+
+void
+CompressedOstream::
+write_impl(
+    char const* ptr,
+    std::size_t size)
+{
+    pos_ += size;
+    while(size > 0)
+    {
+        std::size_t const n = std::min(
+            size, BlockSize - block_.size());
+        block_.append(ptr, n);
+        ptr += n;
+        size -= n;
+        if(block_.size() == BlockSize)
+            writeBlock();
+    }
+}
+
+std::uint64_t
+CompressedOstream::
+current_pos() const
+{
+    return pos_;
+}
+
+void
+CompressedOstream::
+writeBlock()
+{
+    out_.clear();
+    compressAppend(compression_, block_, out_);
+    os_ << out_;
+    block_.clear();
+}
+
+} // mrdox
+} // clang
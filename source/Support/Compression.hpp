@@ -0,0 +1,107 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_COMPRESSION_HPP
+#define MRDOX_TOOL_SUPPORT_COMPRESSION_HPP
+
+#include <mrdox/Support/Error.hpp>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** The compression of output files.
+*/
+enum class OutputCompression
+{
+    none,
+    gzip,
+    zstd
+};
+
+/** Return the compression with the given name.
+
+    The names are "none", "gzip" and "zstd". An
+    empty name is none. A compression which is
+    not available in this build is an error.
+*/
+Expected<OutputCompression>
+parseOutputCompression(
+    std::string_view name);
+
+/** Return the extension of compressed files.
+
+    The extension includes the leading
+    period, and is empty for none.
+*/
+std::string_view
+compressedExtension(
+    OutputCompression compression) noexcept;
+
+/** Append the compressed text to a string.
+
+    The text is written as one gzip member or
+    zstd frame. Members and frames may be
+    concatenated, and the tools decompress
+    them as if they were one stream.
+*/
+void
+compressAppend(
+    OutputCompression compression,
+    std::string_view text,
+    std::string& dest);
+
+/** A stream which compresses the text written to another stream.
+
+    The text is compressed in blocks, each
+    written as a member or frame of its own,
+    so the whole output is never held in
+    memory.
+*/
+class CompressedOstream : public llvm::raw_ostream
+{
+    llvm::raw_ostream& os_;
+    OutputCompression compression_;
+    std::string block_;
+    std::string out_;
+    std::uint64_t pos_ = 0;
+
+    void write_impl(char const* ptr, std::size_t size) override;
+    std::uint64_t current_pos() const override;
+    void writeBlock();
+
+public:
+    /** The size of the text in each block.
+    */
+    static constexpr std::size_t BlockSize = 4 * 1024 * 1024;
+
+    CompressedOstream(
+        llvm::raw_ostream& os,
+        OutputCompression compression);
+
+    /** Destructor.
+
+        The last block is written.
+    */
+    ~CompressedOstream();
+
+    /** Write the last block.
+    */
+    void
+    close();
+};
+
+} // mrdox
+} // clang
+
+#endif
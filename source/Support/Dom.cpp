@@ -11,9 +11,13 @@
 #include <mrdox/Support/Dom.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/RangeFor.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Demangle/Demangle.h>
 #include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <ranges>
 
@@ -24,6 +28,121 @@ namespace dom {
 static_assert(std::random_access_iterator<Object::iterator>);
 static_assert(std::ranges::random_access_range<Object>);
 
+//------------------------------------------------
+//
+// Stats
+//
+//------------------------------------------------
+
+namespace detail {
+
+std::atomic<bool> statsEnabled = false;
+
+} // detail
+
+namespace {
+
+struct Counters
+{
+    std::mutex mutex;
+    llvm::StringMap<std::size_t> objects;
+    llvm::StringMap<std::size_t> arrays;
+    llvm::StringMap<std::size_t> lookups;
+    std::atomic<std::size_t> materializations = 0;
+    std::atomic<std::size_t> bytes = 0;
+};
+
+Counters&
+counters() noexcept
+{
+    static Counters c;
+    return c;
+}
+
+std::vector<Stats::Count>
+sortedCounts(
+    llvm::StringMap<std::size_t> const& m,
+    bool demangle)
+{
+    // the same type can have a different
+    // name pointer in each library
+    llvm::StringMap<std::size_t> merged;
+    for(auto const& kv : m)
+        merged[demangle ?
+            llvm::demangle(kv.getKey().str()) :
+            kv.getKey().str()] += kv.getValue();
+    std::vector<Stats::Count> v;
+    v.reserve(merged.size());
+    for(auto const& kv : merged)
+        v.push_back({ kv.getKey().str(), kv.getValue() });
+    std::sort(v.begin(), v.end(),
+        [](auto const& a, auto const& b)
+        {
+            return a.count > b.count;
+        });
+    return v;
+}
+
+} // (anon)
+
+void
+enableStats(bool enable) noexcept
+{
+    detail::statsEnabled.store(enable);
+}
+
+Stats
+getStats()
+{
+    auto& c = counters();
+    Stats stats;
+    std::lock_guard<std::mutex> lock(c.mutex);
+    stats.objects = sortedCounts(c.objects, true);
+    stats.arrays = sortedCounts(c.arrays, true);
+    stats.lookups = sortedCounts(c.lookups, false);
+    stats.materializations = c.materializations.load();
+    stats.bytes = c.bytes.load();
+    return stats;
+}
+
+void
+detail::
+countNew(
+    char const* type,
+    bool isArray,
+    std::size_t bytes)
+{
+    auto& c = counters();
+    c.bytes += bytes;
+    std::lock_guard<std::mutex> lock(c.mutex);
+    ++(isArray ? c.arrays : c.objects)[type];
+}
+
+void
+detail::
+countLookup(
+    std::string_view key)
+{
+    auto& c = counters();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    ++c.lookups[key];
+}
+
+void
+detail::
+countBytes(
+    std::size_t bytes) noexcept
+{
+    counters().bytes += bytes;
+}
+
+void
+detail::
+countMaterialization() noexcept
+{
+    ++counters().materializations;
+}
+
 //------------------------------------------------
 //
 // String
@@ -144,6 +263,8 @@ allocate(
         s.size() +          // string data
         1 +                 // null term '\0'
         (sizeof(Impl) - 1); // round up to nearest sizeof(Impl)
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countBytes(n);
     return new(alloc.allocate(n / sizeof(Impl))) Impl(s, uv);
 }
 
@@ -170,16 +291,16 @@ deallocate(
 String::
 ~String()
 {
-    if(! impl_)
+    if(kind_ != Kind::Shared)
         return;
-    if(--impl_->refs > 0)
+    if(--rep_.impl_->refs > 0)
         return;
-    deallocate(impl_);
+    deallocate(rep_.impl_);
 }
 
 String::
 String() noexcept
-    : psz_(&sz_empty[0])
+    : String(&sz_empty[0], 0)
 {
 }
 
@@ -194,18 +315,28 @@ String(
 String::
 String(
     String const& other) noexcept
-    : impl_(other.impl_)
-    , psz_(other.psz_)
+    : rep_(other.rep_)
+    , size_(other.size_)
+    , kind_(other.kind_)
 {
-    if(impl_)
-        ++impl_->refs;
+    if(kind_ == Kind::Shared)
+        ++rep_.impl_->refs;
 }
 
 String::
 String(
     std::string_view s)
-    : impl_(allocate(s))
 {
+    if(s.size() <= SmallSize)
+    {
+        std::memcpy(rep_.buf_, s.data(), s.size());
+        rep_.buf_[s.size()] = '\0';
+        size_ = static_cast<std::uint32_t>(s.size());
+        kind_ = Kind::Small;
+        return;
+    }
+    rep_.impl_ = allocate(s);
+    kind_ = Kind::Shared;
 }
 
 String&
@@ -232,18 +363,32 @@ bool
 String::
 empty() const noexcept
 {
-    if(impl_)
-        return impl_->get().size() == 0;
-    return psz_[0] == '\0';
+    return get().empty();
 }
 
 std::string_view
 String::
 get() const noexcept
 {
-    if(psz_)
-        return std::string_view(psz_);
-    return impl_->get();
+    switch(kind_)
+    {
+    case Kind::Literal:
+        return { rep_.psz_, size_ };
+    case Kind::Small:
+        return { rep_.buf_, size_ };
+    case Kind::Shared:
+        return rep_.impl_->get();
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+char const*
+String::
+c_str() const noexcept
+{
+    // every representation stores the terminator
+    return get().data();
 }
 
 //------------------------------------------------
@@ -259,6 +404,9 @@ Array::
 Array()
     : impl_(std::make_shared<DefaultArrayImpl>())
 {
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countNew(typeid(DefaultArrayImpl).name(),
+            true, sizeof(DefaultArrayImpl));
 }
 
 Array::
@@ -322,6 +470,16 @@ toString(
 ArrayImpl::
 ~ArrayImpl() = default;
 
+void
+ArrayImpl::
+getRange(
+    size_type first,
+    std::span<value_type> dest) const
+{
+    for(std::size_t i = 0; i < dest.size(); ++i)
+        dest[i] = get(first + i);
+}
+
 void
 ArrayImpl::
 emplace_back(
@@ -354,6 +512,17 @@ get(
     return elements_[i];
 }
 
+void
+DefaultArrayImpl::
+getRange(
+    size_type first,
+    std::span<value_type> dest) const
+{
+    MRDOX_ASSERT(first + dest.size() <= elements_.size());
+    std::copy_n(elements_.begin() + first,
+        dest.size(), dest.begin());
+}
+
 void
 DefaultArrayImpl::
 emplace_back(
@@ -362,6 +531,57 @@ emplace_back(
     elements_.emplace_back(std::move(value));
 }
 
+//------------------------------------------------
+//
+// CachedArrayImpl
+//
+//------------------------------------------------
+
+auto
+CachedArrayImpl::
+elements() const ->
+    std::vector<value_type> const&
+{
+    std::call_once(once_,
+        [this]
+        {
+            elements_.resize(arr_.size());
+            arr_.impl()->getRange(0, elements_);
+        });
+    return elements_;
+}
+
+auto
+CachedArrayImpl::
+size() const ->
+    size_type
+{
+    return arr_.size();
+}
+
+auto
+CachedArrayImpl::
+get(
+    size_type i) const ->
+        value_type
+{
+    auto const& v = elements();
+    MRDOX_ASSERT(i < v.size());
+    return v[i];
+}
+
+void
+CachedArrayImpl::
+getRange(
+    size_type first,
+    std::span<value_type> dest) const
+{
+    auto const& v = elements();
+    MRDOX_ASSERT(first + dest.size() <= v.size());
+    std::copy_n(v.begin() + first,
+        dest.size(), dest.begin());
+}
+
 //------------------------------------------------
 //
 // Object
@@ -375,6 +595,9 @@ Object::
 Object()
     : impl_(std::make_shared<DefaultObjectImpl>())
 {
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countNew(typeid(DefaultObjectImpl).name(),
+            false, sizeof(DefaultObjectImpl));
 }
 
 Object::
@@ -398,6 +621,9 @@ Object(
     : impl_(std::make_shared<
         DefaultObjectImpl>(std::move(list)))
 {
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countNew(typeid(DefaultObjectImpl).name(),
+            false, sizeof(DefaultObjectImpl));
 }
 
 Object&
@@ -414,11 +640,7 @@ bool
 Object::
 exists(std::string_view key) const
 {
-    for(auto const& kv : *this)
-        if(kv.key == key)
-            return true;
-
-    return false;
+    return impl_->exists(key);
 }
 
 std::string
@@ -453,20 +675,84 @@ toString(
 ObjectImpl::
 ~ObjectImpl() = default;
 
+bool
+ObjectImpl::
+exists(std::string_view key) const
+{
+    std::size_t const n = size();
+    for(std::size_t i = 0; i < n; ++i)
+        if(get(i).key == key)
+            return true;
+    return false;
+}
+
 //------------------------------------------------
 //
 // DefaultObjectImpl
 //
 //------------------------------------------------
 
+struct DefaultObjectImpl::Index
+{
+    // the position of the first entry with each key
+    llvm::StringMap<std::size_t> positions;
+};
+
+auto
+DefaultObjectImpl::
+makeIndex(
+    storage_type const& entries) ->
+        index_type
+{
+    auto index = std::make_shared<Index>();
+    for(std::size_t i = 0; i < entries.size(); ++i)
+        index->positions.try_emplace(
+            entries[i].key.get(), i);
+    return index;
+}
+
 DefaultObjectImpl::
 DefaultObjectImpl() noexcept = default;
 
 DefaultObjectImpl::
 DefaultObjectImpl(
-    storage_type entries) noexcept
+    storage_type entries)
+    : entries_(std::move(entries))
+{
+    if(entries_.size() >= indexThreshold)
+        index_ = makeIndex(entries_);
+}
+
+DefaultObjectImpl::
+DefaultObjectImpl(
+    storage_type entries,
+    index_type index) noexcept
     : entries_(std::move(entries))
+    , index_(std::move(index))
 {
+    MRDOX_ASSERT(! index_ ||
+        index_->positions.size() <= entries_.size());
+}
+
+std::size_t
+DefaultObjectImpl::
+position(
+    std::string_view key) const noexcept
+{
+    if(index_)
+    {
+        auto it = index_->positions.find(key);
+        if(it == index_->positions.end())
+            return entries_.size();
+        return it->second;
+    }
+    auto it = std::find_if(
+        entries_.begin(), entries_.end(),
+        [key](auto const& kv)
+        {
+            return kv.key == key;
+        });
+    return it - entries_.begin();
 }
 
 std::size_t
@@ -489,32 +775,157 @@ Value
 DefaultObjectImpl::
 find(std::string_view key) const
 {
-    auto it = std::find_if(
-        entries_.begin(), entries_.end(),
-        [key](auto const& kv)
-        {
-            return kv.key == key;
-        });
-    if(it == entries_.end())
+    std::size_t const i = position(key);
+    if(i == entries_.size())
         return nullptr;
-    return it->value;
+    return entries_[i].value;
+}
+
+bool
+DefaultObjectImpl::
+exists(std::string_view key) const
+{
+    return position(key) != entries_.size();
 }
 
 void
 DefaultObjectImpl::
 set(String key, Value value)
 {
-    auto it = std::find_if(
-        entries_.begin(), entries_.end(),
-        [key](auto const& kv)
+    std::size_t const i = position(key);
+    if(i != entries_.size())
+    {
+        entries_[i].value = std::move(value);
+        return;
+    }
+    entries_.emplace_back(key, std::move(value));
+    if(index_)
+    {
+        // the index may be shared, so copy it
+        // before adding a key which is ours alone
+        if(index_.use_count() > 1)
+            index_ = std::make_shared<Index>(*index_);
+        index_->positions.try_emplace(key.get(), i);
+    }
+    else if(entries_.size() >= indexThreshold)
+    {
+        index_ = makeIndex(entries_);
+    }
+}
+
+//------------------------------------------------
+//
+// ObjectPool
+//
+//------------------------------------------------
+
+struct ObjectPool::Impl
+{
+    // Every block holds the same rebound
+    // control block of a DefaultObjectImpl,
+    // so the first request fixes the size.
+    std::mutex mutex;
+    std::size_t size = 0;
+    std::vector<void*> free;
+
+    ~Impl()
+    {
+        for(void* p : free)
+            ::operator delete(p);
+    }
+
+    void*
+    allocate(std::size_t n)
+    {
         {
-            return kv.key == key;
-        });
-    if(it == entries_.end())
-        entries_.emplace_back(
-            key, std::move(value));
-    else
-        it->value = std::move(value);
+            std::lock_guard<std::mutex> lock(mutex);
+            if(size == 0)
+                size = n;
+            if(n == size && ! free.empty())
+            {
+                void* p = free.back();
+                free.pop_back();
+                return p;
+            }
+        }
+        return ::operator new(n);
+    }
+
+    void
+    deallocate(void* p, std::size_t n) noexcept
+    {
+        if(n == size)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free.push_back(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+};
+
+namespace {
+
+template<class T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    std::shared_ptr<ObjectPool::Impl> impl;
+
+    explicit
+    PoolAllocator(
+        std::shared_ptr<ObjectPool::Impl> impl_) noexcept
+        : impl(std::move(impl_))
+    {
+    }
+
+    template<class U>
+    PoolAllocator(
+        PoolAllocator<U> const& other) noexcept
+        : impl(other.impl)
+    {
+    }
+
+    T*
+    allocate(std::size_t n)
+    {
+        return static_cast<T*>(
+            impl->allocate(n * sizeof(T)));
+    }
+
+    void
+    deallocate(T* p, std::size_t n) noexcept
+    {
+        impl->deallocate(p, n * sizeof(T));
+    }
+
+    template<class U>
+    bool
+    operator==(PoolAllocator<U> const& other) const noexcept
+    {
+        return impl == other.impl;
+    }
+};
+
+} // (anon)
+
+ObjectPool::
+ObjectPool()
+    : impl_(std::make_shared<Impl>())
+{
+}
+
+Object
+ObjectPool::
+newObject(
+    Object::storage_type entries) const
+{
+    // the rebound allocator in the control
+    // block keeps the pool alive
+    return Object(std::allocate_shared<DefaultObjectImpl>(
+        PoolAllocator<DefaultObjectImpl>(impl_),
+        std::move(entries)));
 }
 
 //------------------------------------------------
@@ -531,6 +942,8 @@ obj() const
     if(impl)
         return *impl;
     impl_type expected = nullptr;
+    if(detail::statsEnabled.load(std::memory_order_relaxed))
+        detail::countMaterialization();
     if(sp_.compare_exchange_strong(
             expected, construct().impl()))
         return *sp_.load();
@@ -559,6 +972,13 @@ find(std::string_view key) const
     return obj().find(key);
 }
 
+bool
+LazyObjectImpl::
+exists(std::string_view key) const
+{
+    return obj().exists(key);
+}
+
 void
 LazyObjectImpl::
 set(String key, Value value)
@@ -566,6 +986,123 @@ set(String key, Value value)
     obj().set(std::move(key), value);
 }
 
+//------------------------------------------------
+//
+// LazyFieldsObjectImpl
+//
+//------------------------------------------------
+
+LazyFieldsObjectImpl::
+Schema::
+Schema(
+    storage_type keys_)
+    : keys(std::move(keys_))
+    , index(DefaultObjectImpl::makeIndex(keys))
+{
+}
+
+LazyFieldsObjectImpl::
+LazyFieldsObjectImpl(
+    schema_type schema)
+    : schema_(std::move(schema))
+    , entries_(schema_->keys)
+    , done_(schema_->keys.size(), false)
+{
+}
+
+// Called with the mutex held
+std::size_t
+LazyFieldsObjectImpl::
+position(
+    std::string_view key) const noexcept
+{
+    auto it = schema_->index->positions.find(key);
+    if(it != schema_->index->positions.end())
+        return it->second;
+    // keys which were set are after the schema
+    for(std::size_t i = done_.size(); i < entries_.size(); ++i)
+        if(entries_[i].key == key)
+            return i;
+    return entries_.size();
+}
+
+auto
+LazyFieldsObjectImpl::
+entry(std::size_t i) const ->
+    Object::value_type const&
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(i >= done_.size() || done_[i])
+            return entries_[i];
+    }
+    // computed without the lock, since
+    // the value may read other objects
+    Value value = compute(i);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(! done_[i])
+    {
+        entries_[i].value = std::move(value);
+        done_[i] = true;
+    }
+    return entries_[i];
+}
+
+std::size_t
+LazyFieldsObjectImpl::
+size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+auto
+LazyFieldsObjectImpl::
+get(std::size_t i) const ->
+    reference
+{
+    MRDOX_ASSERT(i < size());
+    return entry(i);
+}
+
+Value
+LazyFieldsObjectImpl::
+find(std::string_view key) const
+{
+    std::size_t i;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        i = position(key);
+        if(i == entries_.size())
+            return nullptr;
+    }
+    return entry(i).value;
+}
+
+bool
+LazyFieldsObjectImpl::
+exists(std::string_view key) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return position(key) != entries_.size();
+}
+
+void
+LazyFieldsObjectImpl::
+set(String key, Value value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t const i = position(key);
+    if(i == entries_.size())
+    {
+        entries_.emplace_back(std::move(key), std::move(value));
+        return;
+    }
+    entries_[i].value = std::move(value);
+    if(i < done_.size())
+        done_[i] = true;
+}
+
 //------------------------------------------------
 //
 // Value
@@ -11,6 +11,8 @@
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/ExecutorGroup.hpp>
 #include <mrdox/Support/unlock_guard.hpp>
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <unordered_set>
 
@@ -33,6 +35,31 @@ struct ExecutorGroupBase::
     }
 };
 
+/** Work submitted for each element of a range.
+
+    Agents claim elements by advancing the
+    shared index, so the batch stays at the
+    front of the queue until it is exhausted.
+*/
+struct ExecutorGroupBase::
+    Batch
+{
+    any_callable<void(void*, std::size_t)> work;
+    std::size_t size;
+    std::size_t grain;
+    std::atomic<std::size_t> next = 0;
+
+    Batch(
+        any_callable<void(void*, std::size_t)> work_,
+        std::size_t size_,
+        std::size_t grain_)
+        : work(std::move(work_))
+        , size(size_)
+        , grain(grain_)
+    {
+    }
+};
+
 class ExecutorGroupBase::
     scoped_agent
 {
@@ -83,16 +110,47 @@ void
 ExecutorGroupBase::
 post(any_callable<void(void*)> work)
 {
-    std::unique_lock<std::mutex> lock(impl_->mutex);
+    std::lock_guard<std::mutex> lock(impl_->mutex);
     work_.emplace_back(std::move(work));
     if(agents_.empty())
         return;
-    run(std::move(lock));
+    run();
+}
+
+void
+ExecutorGroupBase::
+postRange(
+    std::size_t size,
+    any_callable<void(void*, std::size_t)> work)
+{
+    if(size == 0)
+        return;
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    // several claims for each agent, so
+    // that uneven elements are balanced
+    std::size_t const agents = std::max<std::size_t>(
+        agents_.size() + impl_->busy, 1);
+    std::size_t const grain = std::clamp<std::size_t>(
+        size / (8 * agents), 1, 64);
+    batches_.emplace_back(std::make_shared<Batch>(
+        std::move(work), size, grain));
+    for(auto n = std::min(size, agents_.size()); n--;)
+        run();
+}
+
+void
+ExecutorGroupBase::
+addError(Error err)
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->errors.emplace(std::move(err));
 }
 
+// Called with the mutex held, when
+// at least one agent is available.
 void
 ExecutorGroupBase::
-run(std::unique_lock<std::mutex> lock)
+run()
 {
     std::unique_ptr<AnyAgent> agent(std::move(agents_.back()));
     agents_.pop_back();
@@ -101,36 +159,68 @@ run(std::unique_lock<std::mutex> lock)
     impl_->threadPool.async(
         [this, agent = std::move(agent)]() mutable
         {
+            auto const invoke = [&](auto const& f)
+            {
+                try
+                {
+                    f();
+                }
+                catch(Exception const& ex)
+                {
+                    std::lock_guard<std::mutex> lock(impl_->mutex);
+                    impl_->errors.emplace(ex.error());
+                }
+                catch(std::exception const& ex)
+                {
+                    // Any exception which is not
+                    // derived from Exception should
+                    // be reported and terminate
+                    // the process immediately.
+                    reportUnhandledException(ex);
+                }
+            };
+
             std::unique_lock<std::mutex> lock(impl_->mutex);
             scoped_agent scope(*this, std::move(agent));
             for(;;)
             {
+                if(! batches_.empty())
+                {
+                    std::shared_ptr<Batch> batch = batches_.front();
+                    lock.unlock();
+                    for(;;)
+                    {
+                        std::size_t i = batch->next.fetch_add(
+                            batch->grain, std::memory_order_relaxed);
+                        if(i >= batch->size)
+                            break;
+                        auto const last = std::min(
+                            i + batch->grain, batch->size);
+                        for(; i < last; ++i)
+                            invoke([&]
+                                {
+                                    batch->work(scope.get(), std::size_t(i));
+                                });
+                    }
+                    lock.lock();
+                    // the first agent to run out
+                    // of elements removes the batch
+                    if( ! batches_.empty() &&
+                        batches_.front() == batch)
+                        batches_.pop_front();
+                    continue;
+                }
                 if(work_.empty())
                     break;
                 any_callable<void(void*)> work(
                     std::move(work_.front()));
                 work_.pop_front();
-                {
-                    lock.unlock();
-                    try
+                lock.unlock();
+                invoke([&]
                     {
                         work(scope.get());
-                        lock.lock();
-                    }
-                    catch(Exception const& ex)
-                    {
-                        lock.lock();
-                        impl_->errors.emplace(ex.error());
-                    }
-                    catch(std::exception const& ex)
-                    {
-                        // Any exception which is not
-                        // derived from Exception should
-                        // be reported and terminate
-                        // the process immediately.
-                        reportUnhandledException(ex);
-                    }
-                }
+                    });
+                lock.lock();
             }
         });
 }
@@ -143,7 +233,10 @@ wait() noexcept
     impl_->cv.wait(lock,
         [&]
         {
-            return work_.empty() && impl_->busy == 0;
+            return
+                work_.empty() &&
+                batches_.empty() &&
+                impl_->busy == 0;
         });
     std::vector<Error> errors;
     errors.reserve(impl_->errors.size());
@@ -0,0 +1,339 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/FileWatcher.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/FileSystem.h>
+#include <algorithm>
+#include <optional>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+#include <unordered_map>
+#endif
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+/** Return true if a path is in a directory tree.
+*/
+bool
+isInDirectory(
+    std::string_view path,
+    std::string_view dir)
+{
+    return path.size() > dir.size() &&
+        path.substr(0, dir.size()) == dir &&
+        (path[dir.size()] == '/' || dir.back() == '/');
+}
+
+} // (anon)
+
+#if defined(__linux__)
+
+struct FileWatcher::Impl
+{
+    int fd = -1;
+    llvm::StringSet<> files;
+    std::vector<std::string> trees;
+    std::unordered_map<int, std::string> dirs;
+    llvm::StringSet<> watchedDirs;
+
+    Impl()
+        : fd(inotify_init1(IN_CLOEXEC))
+    {
+    }
+
+    ~Impl()
+    {
+        if(fd != -1)
+            ::close(fd);
+    }
+
+    void
+    watchDir(
+        std::string const& dir)
+    {
+        if(fd == -1 || ! watchedDirs.insert(dir).second)
+            return;
+        int const wd = inotify_add_watch(fd, dir.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+        if(wd != -1)
+            dirs[wd] = dir;
+    }
+
+    bool
+    isWatched(
+        std::string_view path) const
+    {
+        if(files.contains(path))
+            return true;
+        return std::any_of(trees.begin(), trees.end(),
+            [&](std::string const& dir)
+            {
+                return isInDirectory(path, dir);
+            });
+    }
+
+    /** Read the pending events, waiting at most a timeout.
+
+        @return false if no event arrived in time.
+    */
+    Expected<bool>
+    read(
+        std::vector<std::string>& changed,
+        int timeoutMs)
+    {
+        pollfd pfd{ fd, POLLIN, 0 };
+        int const n = ::poll(&pfd, 1, timeoutMs);
+        if(n < 0 && errno == EINTR)
+            return true;
+        if(n < 0)
+            return formatError("poll returned \"{}\"",
+                std::error_code(errno, std::system_category()).message());
+        if(n == 0)
+            return false;
+
+        alignas(inotify_event) char buf[16384];
+        auto const len = ::read(fd, buf, sizeof(buf));
+        if(len <= 0)
+            return true;
+        for(char const* p = buf; p < buf + len;)
+        {
+            auto const* e = reinterpret_cast<inotify_event const*>(p);
+            p += sizeof(inotify_event) + e->len;
+            auto it = dirs.find(e->wd);
+            if(it == dirs.end() || e->len == 0)
+                continue;
+            auto path = files::appendPath(it->second, e->name);
+            // a directory made in a watched tree is
+            // watched too, and its files reported later
+            if(e->mask & IN_ISDIR)
+            {
+                if((e->mask & IN_CREATE) && isWatched(path))
+                    watchDir(path);
+                continue;
+            }
+            if(isWatched(path))
+                changed.emplace_back(std::move(path));
+        }
+        return true;
+    }
+
+    Expected<std::vector<std::string>>
+    wait(
+        std::chrono::milliseconds debounce)
+    {
+        if(fd == -1)
+            return formatError("inotify_init1 failed");
+        std::vector<std::string> changed;
+        while(changed.empty())
+        {
+            auto got = read(changed, -1);
+            if(! got)
+                return got.error();
+        }
+        for(;;)
+        {
+            auto got = read(changed,
+                static_cast<int>(debounce.count()));
+            if(! got)
+                return got.error();
+            if(! *got)
+                break;
+        }
+        return changed;
+    }
+};
+
+void
+FileWatcher::
+watchFile(
+    std::string_view path)
+{
+    impl_->files.insert(path);
+    impl_->watchDir(files::getParentDir(path));
+}
+
+void
+FileWatcher::
+watchDirectory(
+    std::string_view path)
+{
+    namespace fs = llvm::sys::fs;
+
+    std::string dir = files::normalizePath(path);
+    impl_->trees.push_back(dir);
+    impl_->watchDir(dir);
+    std::error_code ec;
+    for(fs::recursive_directory_iterator it(dir, ec), end;
+        it != end && ! ec; it.increment(ec))
+    {
+        if(it->type() == fs::file_type::directory_file)
+            impl_->watchDir(it->path());
+    }
+}
+
+#else
+
+struct FileWatcher::Impl
+{
+    llvm::StringMap<llvm::sys::TimePoint<>> times;
+    std::vector<std::string> trees;
+
+    static
+    std::optional<llvm::sys::TimePoint<>>
+    getTime(
+        llvm::StringRef path)
+    {
+        llvm::sys::fs::file_status status;
+        if(llvm::sys::fs::status(path, status))
+            return std::nullopt;
+        return status.getLastModificationTime();
+    }
+
+    /** Return the files of the trees and their times.
+    */
+    void
+    scan(
+        llvm::StringMap<llvm::sys::TimePoint<>>& result) const
+    {
+        namespace fs = llvm::sys::fs;
+
+        for(auto const& dir : trees)
+        {
+            std::error_code ec;
+            for(fs::recursive_directory_iterator it(dir, ec), end;
+                it != end && ! ec; it.increment(ec))
+            {
+                if(it->type() != fs::file_type::regular_file)
+                    continue;
+                if(auto t = getTime(it->path()))
+                    result[it->path()] = *t;
+            }
+        }
+    }
+
+    /** Return the files which changed since the last check.
+    */
+    std::vector<std::string>
+    check()
+    {
+        std::vector<std::string> changed;
+        llvm::StringMap<llvm::sys::TimePoint<>> now;
+        for(auto const& e : times)
+        {
+            // a file of a tree is found by the scan
+            if(std::any_of(trees.begin(), trees.end(),
+                [&](std::string const& dir)
+                {
+                    return isInDirectory(e.getKey(), dir);
+                }))
+                continue;
+            auto t = getTime(e.getKey());
+            now[e.getKey()] = t.value_or(llvm::sys::TimePoint<>());
+        }
+        scan(now);
+        for(auto const& e : now)
+        {
+            auto it = times.find(e.getKey());
+            if(it == times.end() || it->getValue() != e.getValue())
+                changed.emplace_back(e.getKey());
+        }
+        for(auto const& e : times)
+            if(! now.count(e.getKey()))
+                changed.emplace_back(e.getKey());
+        times = std::move(now);
+        return changed;
+    }
+
+    Expected<std::vector<std::string>>
+    wait(
+        std::chrono::milliseconds debounce)
+    {
+        constexpr std::chrono::milliseconds interval(250);
+        std::vector<std::string> changed;
+        while(changed.empty())
+        {
+            std::this_thread::sleep_for(interval);
+            changed = check();
+        }
+        for(;;)
+        {
+            std::this_thread::sleep_for(std::max(debounce, interval));
+            auto more = check();
+            if(more.empty())
+                break;
+            changed.insert(changed.end(), more.begin(), more.end());
+        }
+        return changed;
+    }
+};
+
+void
+FileWatcher::
+watchFile(
+    std::string_view path)
+{
+    auto t = Impl::getTime(path);
+    impl_->times.try_emplace(path, t.value_or(llvm::sys::TimePoint<>()));
+}
+
+void
+FileWatcher::
+watchDirectory(
+    std::string_view path)
+{
+    impl_->trees.push_back(files::normalizePath(path));
+    llvm::StringMap<llvm::sys::TimePoint<>> found;
+    Impl tree;
+    tree.trees.push_back(impl_->trees.back());
+    tree.scan(found);
+    for(auto const& e : found)
+        impl_->times.try_emplace(e.getKey(), e.getValue());
+}
+
+#endif
+
+FileWatcher::
+FileWatcher()
+    : impl_(std::make_unique<Impl>())
+{
+}
+
+FileWatcher::
+~FileWatcher() = default;
+
+Expected<std::vector<std::string>>
+FileWatcher::
+wait(
+    std::chrono::milliseconds debounce)
+{
+    auto changed = impl_->wait(debounce);
+    if(! changed)
+        return changed.error();
+    // a file saved twice is reported once
+    std::sort(changed->begin(), changed->end());
+    changed->erase(std::unique(changed->begin(), changed->end()),
+        changed->end());
+    return changed;
+}
+
+} // mrdox
+} // clang
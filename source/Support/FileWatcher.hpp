@@ -0,0 +1,70 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_FILEWATCHER_HPP
+#define MRDOX_TOOL_SUPPORT_FILEWATCHER_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Wait for changes to a set of files.
+
+    On Linux the changes are reported by inotify.
+    The directories holding the files are watched
+    rather than the files, so that a file which an
+    editor replaces is still seen. Elsewhere the
+    times of the files are compared periodically.
+*/
+class FileWatcher
+{
+    struct Impl;
+
+    std::unique_ptr<Impl> impl_;
+
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    /** Watch a file, given by its absolute path.
+    */
+    void
+    watchFile(
+        std::string_view path);
+
+    /** Watch every file in a directory tree.
+    */
+    void
+    watchDirectory(
+        std::string_view path);
+
+    /** Wait for changes and return the changed files.
+
+        After the first change, further changes are
+        collected until none happens for the debounce
+        interval, so that saving several files at once
+        is reported once.
+    */
+    Expected<std::vector<std::string>>
+    wait(
+        std::chrono::milliseconds debounce);
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -10,13 +10,15 @@
 //
 
 #include "AST/ParseJavadoc.hpp"
+#include "Support/Compression.hpp"
+#include <mrdox/Corpus.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Generator.hpp>
 #include <llvm/ADT/SmallString.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
-#include <fstream>
-#include <sstream>
+#include <llvm/Support/raw_ostream.h>
+#include <streambuf>
 
 namespace clang {
 namespace mrdox {
@@ -24,6 +26,54 @@ namespace mrdox {
 Generator::
 ~Generator() noexcept = default;
 
+MetadataFacets
+Generator::
+facets() const noexcept
+{
+    return {};
+}
+
+namespace {
+
+/** A stream buffer which writes to a raw_ostream.
+
+    The raw_ostream does the buffering, so
+    this one has no buffer of its own.
+*/
+class RawStreambuf : public std::streambuf
+{
+    llvm::raw_ostream& os_;
+
+public:
+    explicit
+    RawStreambuf(
+        llvm::raw_ostream& os) noexcept
+        : os_(os)
+    {
+    }
+
+protected:
+    int_type
+    overflow(int_type c) override
+    {
+        if(! traits_type::eq_int_type(c, traits_type::eof()))
+            os_ << traits_type::to_char_type(c);
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize
+    xsputn(char const* s, std::streamsize n) override
+    {
+        os_.write(s, static_cast<std::size_t>(n));
+        return n;
+    }
+};
+
+// The size of the buffer of output files
+constexpr std::size_t fileBufferSize = 1024 * 1024;
+
+} // (anon)
+
 /*  default implementation of this function
     assumes the output is single page, and emits
     the file reference.ext using the extension
@@ -53,35 +103,66 @@ build(
     return buildOne(fileName.str(), corpus);
 }
 
+Error
+Generator::
+buildOne(
+    llvm::raw_ostream& os,
+    Corpus const& corpus) const
+{
+    RawStreambuf buf(os);
+    std::ostream out(&buf);
+    return buildOne(out, corpus);
+}
+
 Error
 Generator::
 buildOne(
     std::string_view fileName,
     Corpus const& corpus) const
 {
-    std::ofstream os;
+    auto compression = parseOutputCompression(
+        corpus.config.outputCompression);
+    if(! compression)
+        return compression.error();
+    std::string path(fileName);
+    path.append(compressedExtension(*compression));
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    os.SetBufferSize(fileBufferSize);
 
+    Error err;
     try
     {
-        os.open(std::string(fileName),
-            std::ios_base::binary |
-                std::ios_base::out |
-                std::ios_base::trunc // | std::ios_base::noreplace
-            );
+        if(*compression == OutputCompression::none)
+        {
+            err = buildOne(os, corpus);
+        }
+        else
+        {
+            CompressedOstream cos(os, *compression);
+            err = buildOne(cos, corpus);
+            cos.close();
+        }
     }
     catch(std::exception const& ex)
     {
-        return formatError("std::ofstream threw \"{}\"", ex.what());
-    }
-
-    try
-    {
-        return buildOne(os, corpus);
+        err = formatError("buildOne threw \"{}\"", ex.what());
     }
-    catch(std::exception const& ex)
+    os.close();
+    if(err)
+        return err;
+    if(os.has_error())
     {
-        return formatError("buildOne threw \"{}\"", ex.what());
+        ec = os.error();
+        os.clear_error();
+        return formatError("could not write \"{}\": {}",
+            path, ec.message());
     }
+    return Error::success();
 }
 
 Error
@@ -91,14 +172,13 @@ buildOneString(
     Corpus const& corpus) const
 {
     dest.clear();
-    std::stringstream ss;
+    llvm::raw_string_ostream os(dest);
     try
     {
-        auto err = buildOne(ss, corpus);
+        auto err = buildOne(os, corpus);
         if(err)
-            return err;
-        dest = ss.str();
-        return {};
+            dest.clear();
+        return err;
     }
     catch(Exception const& ex)
     {
@@ -22,6 +22,18 @@ extern
 std::unique_ptr<Generator>
 makeBitcodeGenerator();
 
+extern
+std::unique_ptr<Generator>
+makeHtmlGenerator();
+
+extern
+std::unique_ptr<Generator>
+makeJsonGenerator();
+
+extern
+std::unique_ptr<Generator>
+makeSearchGenerator();
+
 extern
 std::unique_ptr<Generator>
 makeXMLGenerator();
@@ -45,6 +57,9 @@ GeneratorsImpl()
     Error err;
     err = insert(makeAdocGenerator());
     err = insert(makeBitcodeGenerator());
+    err = insert(makeHtmlGenerator());
+    err = insert(makeJsonGenerator());
+    err = insert(makeSearchGenerator());
     err = insert(makeXMLGenerator());
 }
 
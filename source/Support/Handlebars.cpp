@@ -0,0 +1,2576 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Handlebars.hpp"
+#include <mrdox/Metadata/DomMetadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+//------------------------------------------------
+//
+// Syntax tree
+//
+//------------------------------------------------
+
+namespace {
+
+/** Whitespace control flags of a tag.
+
+    `open` is set by "{{~" and `close` by "~}}".
+*/
+struct Strip
+{
+    bool open = false;
+    bool close = false;
+};
+
+struct Call;
+
+struct Expr
+{
+    enum class Kind
+    {
+        Path,
+        Literal,
+        SubExpr
+    };
+
+    Kind kind = Kind::Path;
+
+    // Path
+    bool data = false;
+    bool scoped = false;
+    unsigned depth = 0;
+    std::vector<std::string> parts;
+
+    // Path and Literal
+    std::string original;
+
+    // Literal
+    dom::Value value;
+
+    // SubExpr
+    std::shared_ptr<Call const> call;
+
+    /** Return true if this names a helper or a property of `this`.
+    */
+    bool
+    isSimple() const noexcept
+    {
+        return
+            kind == Kind::Path &&
+            ! data &&
+            ! scoped &&
+            depth == 0 &&
+            parts.size() == 1;
+    }
+};
+
+struct HashArg
+{
+    std::string key;
+    Expr value;
+};
+
+struct Call
+{
+    Expr path;
+    std::vector<Expr> params;
+    std::vector<HashArg> hash;
+};
+
+enum class StmtKind
+{
+    Content,
+    Comment,
+    Mustache,
+    Block,
+    Partial
+};
+
+} // (anon)
+
+struct Handlebars::Program
+{
+    struct Stmt
+    {
+        StmtKind kind;
+        std::size_t line = 0;
+
+        // Content
+        std::string original;
+        std::string value;
+        bool leftStripped = false;
+        bool rightStripped = false;
+
+        // Mustache, Block, Partial
+        Call call;
+
+        // Mustache
+        bool escaped = true;
+
+        // Mustache, Comment, Partial
+        Strip strip;
+
+        // Block
+        std::unique_ptr<Program> program;
+        std::unique_ptr<Program> inverse;
+        Strip openStrip;
+        Strip inverseStrip;
+        Strip closeStrip;
+
+        // Partial
+        std::string indent;
+    };
+
+    std::vector<Stmt> body;
+    bool chained = false;
+};
+
+namespace {
+
+using Program = Handlebars::Program;
+using Stmt = Program::Stmt;
+
+constexpr std::size_t npos = std::string_view::npos;
+
+bool
+isSpace(char c) noexcept
+{
+    return
+        c == ' ' || c == '\t' || c == '\n' ||
+        c == '\r' || c == '\v' || c == '\f';
+}
+
+//------------------------------------------------
+//
+// Lexer
+//
+//------------------------------------------------
+
+enum class TokKind
+{
+    Content,
+    Comment,
+    Mustache,
+    Open,
+    OpenInverse,
+    Close,
+    Else,
+    ElseChain,
+    Partial
+};
+
+struct Token
+{
+    TokKind kind;
+    std::string_view text;
+    std::size_t line;
+    Strip strip;
+    bool escaped = true;
+};
+
+class Lexer
+{
+    std::string_view s_;
+    std::size_t line_ = 1;
+    std::size_t counted_ = 0;
+    std::vector<Token> toks_;
+
+    std::size_t
+    lineAt(std::size_t pos) noexcept
+    {
+        for(; counted_ < pos; ++counted_)
+            if(s_[counted_] == '\n')
+                ++line_;
+        return line_;
+    }
+
+    [[noreturn]]
+    void
+    fail(
+        std::size_t pos,
+        std::string_view what)
+    {
+        formatError("Parse error on line {}: {}",
+            lineAt(pos), what).Throw();
+    }
+
+    void
+    addContent(
+        std::size_t first,
+        std::size_t last)
+    {
+        if(first < last)
+            toks_.push_back({ TokKind::Content,
+                s_.substr(first, last - first), lineAt(first) });
+    }
+
+    /** Return the position of the "}}" closing a tag.
+
+        Quoted strings are skipped, so they may
+        contain braces.
+    */
+    std::size_t
+    findClose(
+        std::size_t pos,
+        std::string_view close)
+    {
+        while(pos < s_.size())
+        {
+            char c = s_[pos];
+            if(c == '"' || c == '\'')
+            {
+                auto q = pos + 1;
+                while(q < s_.size() && s_[q] != c)
+                    q += (s_[q] == '\\') ? 2 : 1;
+                pos = q + 1;
+                continue;
+            }
+            if(s_.substr(pos).starts_with(close))
+                return pos;
+            ++pos;
+        }
+        fail(pos, "unterminated mustache");
+    }
+
+    std::size_t lexTag(std::size_t pos);
+
+public:
+    explicit
+    Lexer(std::string_view s) noexcept
+        : s_(s)
+    {
+    }
+
+    std::vector<Token> lex();
+};
+
+std::vector<Token>
+Lexer::
+lex()
+{
+    std::size_t pos = 0;
+    std::size_t const n = s_.size();
+    while(pos < n)
+    {
+        auto p = s_.find("{{", pos);
+        if(p == npos)
+        {
+            addContent(pos, n);
+            break;
+        }
+        if(p > pos && s_[p - 1] == '\\')
+        {
+            if(p - pos >= 2 && s_[p - 2] == '\\')
+            {
+                // "\\{{" is a backslash followed by a tag
+                addContent(pos, p - 1);
+            }
+            else
+            {
+                // "\{{" is a literal "{{", which continues
+                // up to the next tag or escaped tag
+                addContent(pos, p - 1);
+                auto q = s_.find("{{", p + 2);
+                if(q == npos)
+                {
+                    q = n;
+                }
+                else if(s_[q - 1] == '\\')
+                {
+                    --q;
+                    if(q > p + 2 && s_[q - 1] == '\\')
+                        --q;
+                }
+                addContent(p, q);
+                pos = q;
+                continue;
+            }
+        }
+        else
+        {
+            addContent(pos, p);
+        }
+        pos = lexTag(p);
+    }
+    return std::move(toks_);
+}
+
+std::size_t
+Lexer::
+lexTag(std::size_t pos)
+{
+    std::size_t const start = pos;
+    std::size_t const line = lineAt(pos);
+    Token tok{ TokKind::Mustache, {}, line };
+    pos += 2;
+    if(pos < s_.size() && s_[pos] == '~')
+    {
+        tok.strip.open = true;
+        ++pos;
+    }
+    auto rest = s_.substr(pos);
+
+    // comments
+    if(rest.starts_with("!"))
+    {
+        auto const close = rest.starts_with("!--") ?
+            std::string_view("--") : std::string_view();
+        auto q = pos + 1 + close.size();
+        for(;;)
+        {
+            q = s_.find(close.empty() ? "}}" : "--", q);
+            if(q == npos)
+                fail(start, "unterminated comment");
+            auto r = q + close.size();
+            if(r < s_.size() && s_[r] == '~')
+                ++r;
+            if(s_.substr(r).starts_with("}}"))
+            {
+                tok.kind = TokKind::Comment;
+                tok.text = s_.substr(start, r + 2 - start);
+                tok.strip.close = s_[r - 1] == '~';
+                toks_.push_back(tok);
+                return r + 2;
+            }
+            ++q;
+        }
+    }
+
+    std::string_view close = "}}";
+    if(rest.starts_with("{{"))
+    {
+        fail(start, "raw blocks are not supported");
+    }
+    else if(rest.starts_with("{"))
+    {
+        tok.escaped = false;
+        close = "}}}";
+        ++pos;
+    }
+    else if(rest.starts_with("&"))
+    {
+        tok.escaped = false;
+        ++pos;
+    }
+    else if(rest.starts_with("#>"))
+    {
+        fail(start, "partial blocks are not supported");
+    }
+    else if(rest.starts_with("#*") || rest.starts_with("*"))
+    {
+        fail(start, "decorators are not supported");
+    }
+    else if(rest.starts_with("#"))
+    {
+        tok.kind = TokKind::Open;
+        ++pos;
+    }
+    else if(rest.starts_with("/"))
+    {
+        tok.kind = TokKind::Close;
+        ++pos;
+    }
+    else if(rest.starts_with("^"))
+    {
+        tok.kind = TokKind::OpenInverse;
+        ++pos;
+    }
+    else if(rest.starts_with(">"))
+    {
+        tok.kind = TokKind::Partial;
+        ++pos;
+    }
+    else
+    {
+        auto q = pos;
+        while(q < s_.size() && isSpace(s_[q]))
+            ++q;
+        auto word = s_.substr(q);
+        if(word.starts_with("else") && (
+            word.size() == 4 ||
+            isSpace(word[4]) ||
+            word[4] == '~' ||
+            word[4] == '}'))
+        {
+            tok.kind = TokKind::ElseChain;
+            pos = q + 4;
+        }
+    }
+
+    auto end = findClose(pos, close);
+    auto exprEnd = end;
+    if(exprEnd > pos && s_[exprEnd - 1] == '~')
+    {
+        tok.strip.close = true;
+        --exprEnd;
+    }
+    tok.text = s_.substr(pos, exprEnd - pos);
+
+    // "{{else}}" and "{{^}}" separate a block
+    // from its inverse
+    if(tok.kind == TokKind::ElseChain ||
+        tok.kind == TokKind::OpenInverse)
+    {
+        auto t = tok.text;
+        while(! t.empty() && isSpace(t.front()))
+            t.remove_prefix(1);
+        if(t.empty() || std::all_of(t.begin(), t.end(), isSpace))
+            tok.kind = TokKind::Else;
+    }
+    toks_.push_back(tok);
+    return end + close.size();
+}
+
+//------------------------------------------------
+//
+// Expression parser
+//
+//------------------------------------------------
+
+class ExprParser
+{
+    std::string_view s_;
+    std::size_t i_ = 0;
+    std::size_t line_;
+
+    [[noreturn]]
+    void
+    fail(std::string_view what)
+    {
+        formatError("Parse error on line {}: {} in \"{}\"",
+            line_, what, s_).Throw();
+    }
+
+    static
+    bool
+    isIdChar(char c) noexcept
+    {
+        if(isSpace(c))
+            return false;
+        switch(c)
+        {
+        case '!': case '"': case '#': case '%': case '&':
+        case '\'': case '(': case ')': case '*': case '+':
+        case ',': case '.': case '/': case ';': case '<':
+        case '=': case '>': case '@': case '[': case '\\':
+        case ']': case '^': case '`': case '{': case '|':
+        case '}': case '~':
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    /** Return true if a literal may end at position i.
+    */
+    bool
+    isLiteralEnd(std::size_t i) const noexcept
+    {
+        return
+            i >= s_.size() ||
+            isSpace(s_[i]) ||
+            s_[i] == ')' ||
+            s_[i] == '~' ||
+            s_[i] == '}';
+    }
+
+    void
+    skipSpace() noexcept
+    {
+        while(i_ < s_.size() && isSpace(s_[i_]))
+            ++i_;
+    }
+
+    bool
+    atEnd() noexcept
+    {
+        skipSpace();
+        return i_ >= s_.size();
+    }
+
+    bool
+    peek(char c) noexcept
+    {
+        skipSpace();
+        return i_ < s_.size() && s_[i_] == c;
+    }
+
+    bool
+    peekHashKey() noexcept
+    {
+        skipSpace();
+        auto j = i_;
+        while(j < s_.size() && isIdChar(s_[j]))
+            ++j;
+        if(j == i_)
+            return false;
+        while(j < s_.size() && isSpace(s_[j]))
+            ++j;
+        return j < s_.size() && s_[j] == '=';
+    }
+
+    std::string segment();
+    Expr path(bool data);
+    Expr helperName();
+    Expr param();
+
+public:
+    ExprParser(
+        std::string_view s,
+        std::size_t line) noexcept
+        : s_(s)
+        , line_(line)
+    {
+    }
+
+    Call call(
+        bool sub = false,
+        bool partial = false);
+
+    void
+    finish()
+    {
+        if(! atEnd())
+            fail(peek('|') || s_.substr(i_).starts_with("as ") ?
+                "block parameters are not supported" :
+                "unexpected characters");
+    }
+};
+
+std::string
+ExprParser::
+segment()
+{
+    if(i_ < s_.size() && s_[i_] == '[')
+    {
+        std::string seg;
+        ++i_;
+        while(i_ < s_.size() && s_[i_] != ']')
+        {
+            if(s_[i_] == '\\' && i_ + 1 < s_.size() &&
+                (s_[i_ + 1] == ']' || s_[i_ + 1] == '\\'))
+                ++i_;
+            seg.push_back(s_[i_++]);
+        }
+        if(i_ >= s_.size())
+            fail("unterminated segment");
+        ++i_;
+        return seg;
+    }
+    auto const start = i_;
+    if(s_.substr(i_).starts_with(".."))
+    {
+        i_ += 2;
+    }
+    else if(s_.substr(i_).starts_with(".") && (
+        i_ + 1 >= s_.size() ||
+        s_[i_ + 1] == '/' ||
+        s_[i_ + 1] == '.' ||
+        s_[i_ + 1] == '=' ||
+        isLiteralEnd(i_ + 1)))
+    {
+        i_ += 1;
+    }
+    else
+    {
+        while(i_ < s_.size() && isIdChar(s_[i_]))
+            ++i_;
+    }
+    if(i_ == start)
+        fail("expected a path");
+    return std::string(s_.substr(start, i_ - start));
+}
+
+Expr
+ExprParser::
+path(bool data)
+{
+    Expr e;
+    e.data = data;
+    auto const start = i_;
+    for(;;)
+    {
+        bool const literal = s_[i_] == '[';
+        auto seg = segment();
+        if(! literal && (
+            seg == ".." || seg == "." || seg == "this"))
+        {
+            if(! e.parts.empty())
+                fail("invalid path");
+            if(seg == "..")
+                ++e.depth;
+        }
+        else
+        {
+            e.parts.push_back(std::move(seg));
+        }
+        if(i_ + 1 < s_.size() &&
+            (s_[i_] == '.' || s_[i_] == '/') &&
+            ! isSpace(s_[i_ + 1]) &&
+            s_[i_ + 1] != ')' &&
+            s_[i_ + 1] != '=')
+        {
+            ++i_;
+            continue;
+        }
+        break;
+    }
+    e.original = std::string(s_.substr(start, i_ - start));
+    e.scoped =
+        e.original.starts_with(".") ||
+        e.original.starts_with("this");
+    if(data)
+        e.original.insert(e.original.begin(), '@');
+    return e;
+}
+
+Expr
+ExprParser::
+helperName()
+{
+    skipSpace();
+    if(i_ >= s_.size())
+        fail("expected an expression");
+    Expr e;
+    char const c = s_[i_];
+    if(c == '"' || c == '\'')
+    {
+        std::string str;
+        ++i_;
+        while(i_ < s_.size() && s_[i_] != c)
+        {
+            if(s_[i_] == '\\' && i_ + 1 < s_.size() && s_[i_ + 1] == c)
+                ++i_;
+            str.push_back(s_[i_++]);
+        }
+        if(i_ >= s_.size())
+            fail("unterminated string");
+        ++i_;
+        e.kind = Expr::Kind::Literal;
+        e.original = str;
+        e.value = dom::String(str);
+        return e;
+    }
+    if(c == '@')
+    {
+        ++i_;
+        return path(true);
+    }
+
+    // number, boolean, null and undefined literals
+    auto j = i_;
+    if(s_[j] == '-')
+        ++j;
+    auto const digits = j;
+    while(j < s_.size() && s_[j] >= '0' && s_[j] <= '9')
+        ++j;
+    bool number = j > digits;
+    bool integral = true;
+    if(number && j + 1 < s_.size() && s_[j] == '.' &&
+        s_[j + 1] >= '0' && s_[j + 1] <= '9')
+    {
+        integral = false;
+        for(++j; j < s_.size() && s_[j] >= '0' && s_[j] <= '9';)
+            ++j;
+    }
+    if(number && isLiteralEnd(j))
+    {
+        e.kind = Expr::Kind::Literal;
+        e.original = std::string(s_.substr(i_, j - i_));
+        std::int64_t v = 0;
+        if(integral)
+            std::from_chars(s_.data() + i_, s_.data() + j, v);
+        e.value = integral ? dom::Value(v) : dom::Value(e.original);
+        i_ = j;
+        return e;
+    }
+    for(std::string_view word : {
+        "true", "false", "null", "undefined" })
+    {
+        if(s_.substr(i_).starts_with(word) &&
+            isLiteralEnd(i_ + word.size()))
+        {
+            e.kind = Expr::Kind::Literal;
+            e.original = std::string(word);
+            if(word == "true")
+                e.value = true;
+            else if(word == "false")
+                e.value = false;
+            i_ += word.size();
+            return e;
+        }
+    }
+    return path(false);
+}
+
+Expr
+ExprParser::
+param()
+{
+    if(peek('('))
+    {
+        ++i_;
+        Expr e;
+        e.kind = Expr::Kind::SubExpr;
+        e.call = std::make_shared<Call>(call(true));
+        return e;
+    }
+    return helperName();
+}
+
+Call
+ExprParser::
+call(
+    bool sub,
+    bool partial)
+{
+    Call c;
+    if(peek('(') && ! partial)
+        fail("subexpressions cannot name a helper");
+    c.path = param();
+    for(;;)
+    {
+        if(sub && peek(')'))
+        {
+            ++i_;
+            return c;
+        }
+        if(atEnd() || peek('|'))
+            break;
+        if(peekHashKey())
+        {
+            auto const start = i_;
+            while(isIdChar(s_[i_]))
+                ++i_;
+            HashArg arg;
+            arg.key = std::string(s_.substr(start, i_ - start));
+            skipSpace();
+            ++i_; // '='
+            arg.value = param();
+            c.hash.push_back(std::move(arg));
+            continue;
+        }
+        if(! c.hash.empty())
+            fail("positional arguments must precede hash arguments");
+        c.params.push_back(param());
+    }
+    if(sub)
+        fail("expected ')'");
+    return c;
+}
+
+/** Make a literal in place of a helper name into a path.
+
+    Handlebars looks these up by their text.
+*/
+void
+literalToPath(Expr& e)
+{
+    if(e.kind != Expr::Kind::Literal)
+        return;
+    e.kind = Expr::Kind::Path;
+    e.parts = { e.original };
+    e.value = nullptr;
+}
+
+//------------------------------------------------
+//
+// Parser
+//
+//------------------------------------------------
+
+class Parser
+{
+    std::vector<Token> toks_;
+    std::size_t i_ = 0;
+
+    [[noreturn]]
+    void
+    fail(
+        std::size_t line,
+        std::string_view what)
+    {
+        formatError("Parse error on line {}: {}",
+            line, what).Throw();
+    }
+
+    Call
+    parseCall(Token const& tok)
+    {
+        ExprParser p(tok.text, tok.line);
+        auto c = p.call(false,
+            tok.kind == TokKind::Partial);
+        p.finish();
+        return c;
+    }
+
+    std::unique_ptr<Program> parseProgram();
+    void parseBlock(Token const& open, Stmt& block, bool chained);
+
+public:
+    explicit
+    Parser(std::string_view text)
+        : toks_(Lexer(text).lex())
+    {
+    }
+
+    std::unique_ptr<Program>
+    parse()
+    {
+        auto program = parseProgram();
+        if(i_ < toks_.size())
+        {
+            auto const& tok = toks_[i_];
+            fail(tok.line, tok.kind == TokKind::Close ?
+                "unexpected close tag" : "unexpected else");
+        }
+        return program;
+    }
+};
+
+std::unique_ptr<Program>
+Parser::
+parseProgram()
+{
+    auto program = std::make_unique<Program>();
+    while(i_ < toks_.size())
+    {
+        Token const& tok = toks_[i_];
+        Stmt stmt;
+        stmt.line = tok.line;
+        switch(tok.kind)
+        {
+        case TokKind::Close:
+        case TokKind::Else:
+        case TokKind::ElseChain:
+            return program;
+
+        case TokKind::Content:
+            stmt.kind = StmtKind::Content;
+            stmt.original = std::string(tok.text);
+            stmt.value = stmt.original;
+            ++i_;
+            break;
+
+        case TokKind::Comment:
+            stmt.kind = StmtKind::Comment;
+            stmt.strip = tok.strip;
+            ++i_;
+            break;
+
+        case TokKind::Mustache:
+            stmt.kind = StmtKind::Mustache;
+            stmt.call = parseCall(tok);
+            literalToPath(stmt.call.path);
+            stmt.escaped = tok.escaped;
+            stmt.strip = tok.strip;
+            ++i_;
+            break;
+
+        case TokKind::Partial:
+            stmt.kind = StmtKind::Partial;
+            stmt.call = parseCall(tok);
+            if(stmt.call.params.size() > 1)
+                fail(tok.line, fmt::format(
+                    "Unsupported number of partial arguments: {}",
+                    stmt.call.params.size()));
+            stmt.strip = tok.strip;
+            ++i_;
+            break;
+
+        case TokKind::Open:
+        case TokKind::OpenInverse:
+            ++i_;
+            parseBlock(tok, stmt, false);
+            break;
+        }
+        program->body.push_back(std::move(stmt));
+    }
+    return program;
+}
+
+void
+Parser::
+parseBlock(
+    Token const& open,
+    Stmt& block,
+    bool chained)
+{
+    block.kind = StmtKind::Block;
+    block.line = open.line;
+    block.call = parseCall(open);
+    literalToPath(block.call.path);
+    block.openStrip = open.strip;
+    block.program = parseProgram();
+    if(i_ >= toks_.size())
+        fail(open.line, fmt::format("unclosed block \"{}\"",
+            block.call.path.original));
+
+    Token const* tok = &toks_[i_];
+    if(tok->kind == TokKind::Else)
+    {
+        block.inverseStrip = tok->strip;
+        ++i_;
+        block.inverse = parseProgram();
+        if(i_ >= toks_.size() ||
+            toks_[i_].kind != TokKind::Close)
+            fail(tok->line, "expected a close tag");
+        // an inner chained block ends where the
+        // else of its parent begins
+        block.closeStrip = tok->strip;
+    }
+    else if(tok->kind == TokKind::ElseChain)
+    {
+        // "{{else if x}}" is an inverse holding
+        // a single block
+        block.inverseStrip = tok->strip;
+        ++i_;
+        Stmt inner;
+        parseBlock(*tok, inner, true);
+        // Handlebars gives each chained block the
+        // strip flags of its own opening tag as
+        // the flags of its close.
+        inner.closeStrip = tok->strip;
+        block.inverse = std::make_unique<Program>();
+        block.inverse->chained = true;
+        block.inverse->body.push_back(std::move(inner));
+        if(chained)
+        {
+            block.closeStrip = tok->strip;
+            return;
+        }
+    }
+    if(chained)
+        return;
+
+    tok = &toks_[i_];
+    if(tok->kind != TokKind::Close)
+        fail(tok->line, "expected a close tag");
+    auto name = tok->text;
+    while(! name.empty() && isSpace(name.front()))
+        name.remove_prefix(1);
+    while(! name.empty() && isSpace(name.back()))
+        name.remove_suffix(1);
+    if(name != block.call.path.original)
+        fail(tok->line, fmt::format("\"{}\" doesn't match \"{}\"",
+            block.call.path.original, name));
+    block.closeStrip = tok->strip;
+    if(block.inverse && block.inverse->chained)
+        block.inverse->body.front().closeStrip = tok->strip;
+    ++i_;
+
+    if(open.kind == TokKind::OpenInverse)
+        std::swap(block.program, block.inverse);
+}
+
+//------------------------------------------------
+//
+// Whitespace control
+//
+//------------------------------------------------
+
+// This follows WhitespaceControl in Handlebars.js
+// closely, as the output depends on its details.
+
+/** Return true if the trailing whitespace of s has a newline.
+*/
+bool
+endsWithNewline(
+    std::string_view s,
+    bool orBlank) noexcept
+{
+    for(auto i = s.size(); i-- > 0;)
+    {
+        if(s[i] == '\n')
+            return true;
+        if(! isSpace(s[i]))
+            return false;
+    }
+    return orBlank;
+}
+
+/** Return true if the leading whitespace of s has a newline.
+*/
+bool
+startsWithNewline(
+    std::string_view s,
+    bool orBlank) noexcept
+{
+    for(char c : s)
+    {
+        if(c == '\n')
+            return true;
+        if(! isSpace(c))
+            return false;
+    }
+    return orBlank;
+}
+
+bool
+isPrevWhitespace(
+    std::vector<Stmt> const& body,
+    std::size_t i = npos,
+    bool isRoot = false)
+{
+    if(i == npos)
+        i = body.size();
+    if(i < 1)
+        return isRoot;
+    auto const& prev = body[i - 1];
+    if(prev.kind != StmtKind::Content)
+        return false;
+    bool const sibling = i >= 2;
+    return endsWithNewline(prev.original,
+        ! sibling && isRoot);
+}
+
+bool
+isNextWhitespace(
+    std::vector<Stmt> const& body,
+    std::size_t i = npos,
+    bool isRoot = false)
+{
+    std::size_t const n = (i == npos) ? 0 : i + 1;
+    if(n >= body.size())
+        return isRoot;
+    auto const& next = body[n];
+    if(next.kind != StmtKind::Content)
+        return false;
+    bool const sibling = n + 1 < body.size();
+    return startsWithNewline(next.original,
+        ! sibling && isRoot);
+}
+
+void
+omitRight(
+    std::vector<Stmt>& body,
+    std::size_t i = npos,
+    bool multiple = false)
+{
+    std::size_t const n = (i == npos) ? 0 : i + 1;
+    if(n >= body.size())
+        return;
+    auto& cur = body[n];
+    if(cur.kind != StmtKind::Content ||
+        (! multiple && cur.rightStripped))
+        return;
+    auto& v = cur.value;
+    std::size_t k = 0;
+    if(multiple)
+    {
+        while(k < v.size() && isSpace(v[k]))
+            ++k;
+    }
+    else
+    {
+        while(k < v.size() && (v[k] == ' ' || v[k] == '\t'))
+            ++k;
+        if(k < v.size() && v[k] == '\r')
+            ++k;
+        if(k < v.size() && v[k] == '\n')
+            ++k;
+        else if(k > 0 && v[k - 1] == '\r')
+            --k;
+    }
+    v.erase(0, k);
+    cur.rightStripped = k > 0;
+}
+
+bool
+omitLeft(
+    std::vector<Stmt>& body,
+    std::size_t i = npos,
+    bool multiple = false)
+{
+    if(body.empty() || i == 0)
+        return false;
+    auto& cur = body[(i == npos) ? body.size() - 1 : i - 1];
+    if(cur.kind != StmtKind::Content ||
+        (! multiple && cur.leftStripped))
+        return false;
+    auto& v = cur.value;
+    auto k = v.size();
+    if(multiple)
+    {
+        while(k > 0 && isSpace(v[k - 1]))
+            --k;
+    }
+    else
+    {
+        while(k > 0 && (v[k - 1] == ' ' || v[k - 1] == '\t'))
+            --k;
+    }
+    cur.leftStripped = k < v.size();
+    v.erase(k);
+    return cur.leftStripped;
+}
+
+class WhitespaceControl
+{
+    struct Result
+    {
+        bool open = false;
+        bool close = false;
+        bool openStandalone = false;
+        bool closeStandalone = false;
+        bool inlineStandalone = false;
+    };
+
+    bool isRootSeen_ = false;
+
+    Result block(Stmt& block);
+
+public:
+    void program(Program& program);
+};
+
+void
+WhitespaceControl::
+program(Program& program)
+{
+    bool const isRoot = ! isRootSeen_;
+    isRootSeen_ = true;
+
+    auto& body = program.body;
+    for(std::size_t i = 0; i < body.size(); ++i)
+    {
+        auto& current = body[i];
+        Result strip;
+        switch(current.kind)
+        {
+        case StmtKind::Content:
+            continue;
+        case StmtKind::Mustache:
+            strip.open = current.strip.open;
+            strip.close = current.strip.close;
+            break;
+        case StmtKind::Comment:
+        case StmtKind::Partial:
+            strip.open = current.strip.open;
+            strip.close = current.strip.close;
+            strip.inlineStandalone = true;
+            break;
+        case StmtKind::Block:
+            strip = block(current);
+            break;
+        }
+
+        bool const prevWs = isPrevWhitespace(body, i, isRoot);
+        bool const nextWs = isNextWhitespace(body, i, isRoot);
+        bool const openStandalone = strip.openStandalone && prevWs;
+        bool const closeStandalone = strip.closeStandalone && nextWs;
+        bool const inlineStandalone =
+            strip.inlineStandalone && prevWs && nextWs;
+
+        if(strip.close)
+            omitRight(body, i, true);
+        if(strip.open)
+            omitLeft(body, i, true);
+
+        if(inlineStandalone)
+        {
+            omitRight(body, i);
+            if(omitLeft(body, i) &&
+                current.kind == StmtKind::Partial)
+            {
+                // keep the indent of a standalone partial
+                std::string_view prev = body[i - 1].original;
+                auto k = prev.size();
+                while(k > 0 && (prev[k - 1] == ' ' || prev[k - 1] == '\t'))
+                    --k;
+                current.indent = std::string(prev.substr(k));
+            }
+        }
+        if(openStandalone)
+        {
+            omitRight((current.program ?
+                current.program : current.inverse)->body);
+            omitLeft(body, i);
+        }
+        if(closeStandalone)
+        {
+            omitRight(body, i);
+            omitLeft((current.inverse ?
+                current.inverse : current.program)->body);
+        }
+    }
+}
+
+auto
+WhitespaceControl::
+block(Stmt& block) -> Result
+{
+    if(block.program)
+        this->program(*block.program);
+    if(block.inverse)
+        this->program(*block.inverse);
+
+    Program* program = block.program ?
+        block.program.get() : block.inverse.get();
+    Program* inverse = block.program ?
+        block.inverse.get() : nullptr;
+    Program* firstInverse = inverse;
+    Program* lastInverse = inverse;
+    if(inverse && inverse->chained)
+    {
+        firstInverse = inverse->body.front().program.get();
+        while(lastInverse->chained)
+            lastInverse = lastInverse->body.back().program.get();
+    }
+
+    Result strip;
+    strip.open = block.openStrip.open;
+    strip.close = block.closeStrip.close;
+    strip.openStandalone = isNextWhitespace(program->body);
+    strip.closeStandalone = isPrevWhitespace(
+        (firstInverse ? firstInverse : program)->body);
+
+    if(block.openStrip.close)
+        omitRight(program->body, npos, true);
+    if(inverse)
+    {
+        if(block.inverseStrip.open)
+            omitLeft(program->body, npos, true);
+        if(block.inverseStrip.close)
+            omitRight(firstInverse->body, npos, true);
+        if(block.closeStrip.open)
+            omitLeft(lastInverse->body, npos, true);
+
+        // standalone else
+        if(isPrevWhitespace(program->body) &&
+            isNextWhitespace(firstInverse->body))
+        {
+            omitLeft(program->body);
+            omitRight(firstInverse->body);
+        }
+    }
+    else if(block.closeStrip.open)
+    {
+        omitLeft(program->body, npos, true);
+    }
+    return strip;
+}
+
+//------------------------------------------------
+//
+// Values
+//
+//------------------------------------------------
+
+/** Return true if a value is falsy in JavaScript.
+*/
+bool
+isFalsy(dom::Value const& v) noexcept
+{
+    switch(v.kind())
+    {
+    case dom::Kind::Null:
+        return true;
+    case dom::Kind::Boolean:
+        return ! v.getBool();
+    case dom::Kind::Integer:
+        return v.getInteger() == 0;
+    case dom::Kind::String:
+        return v.getString().empty();
+    default:
+        return false;
+    }
+}
+
+/** Return true if a value is empty, as Handlebars defines it.
+*/
+bool
+isEmpty(dom::Value const& v)
+{
+    if(v.isArray())
+        return v.getArray().empty();
+    if(v.isInteger())
+        return false;
+    return isFalsy(v);
+}
+
+/** Return true if two values are loosely the same.
+*/
+bool
+isSame(
+    dom::Value const& a,
+    dom::Value const& b)
+{
+    if(a.kind() != b.kind())
+        return false;
+    switch(a.kind())
+    {
+    case dom::Kind::Null:
+        return true;
+    case dom::Kind::Boolean:
+        return a.getBool() == b.getBool();
+    case dom::Kind::Integer:
+        return a.getInteger() == b.getInteger();
+    case dom::Kind::String:
+        return a.getString() == b.getString();
+    case dom::Kind::Array:
+        return a.getArray().impl() == b.getArray().impl();
+    case dom::Kind::Object:
+        return a.getObject().impl() == b.getObject().impl();
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+/** Return the named property of a value, or null.
+*/
+dom::Value
+lookupProperty(
+    dom::Value const& v,
+    std::string_view key)
+{
+    switch(v.kind())
+    {
+    case dom::Kind::Object:
+        return v.getObject().find(key);
+    case dom::Kind::Array:
+    {
+        auto const& arr = v.getArray();
+        if(key == "length")
+            return static_cast<std::int64_t>(arr.size());
+        std::size_t i = 0;
+        auto [p, ec] = std::from_chars(
+            key.data(), key.data() + key.size(), i);
+        if(ec == std::errc() && p == key.data() + key.size() &&
+            i < arr.size())
+            return arr.get(i);
+        return nullptr;
+    }
+    case dom::Kind::String:
+        if(key == "length")
+            return static_cast<std::int64_t>(
+                v.getString().size());
+        return nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+/** Append a value converted as JavaScript does.
+*/
+void
+appendString(
+    llvm::raw_ostream& out,
+    dom::Value const& v)
+{
+    switch(v.kind())
+    {
+    case dom::Kind::Null:
+        return;
+    case dom::Kind::Boolean:
+        out << (v.getBool() ? "true" : "false");
+        return;
+    case dom::Kind::Integer:
+        out << v.getInteger();
+        return;
+    case dom::Kind::String:
+        out << v.getString().get();
+        return;
+    case dom::Kind::Array:
+    {
+        auto const& arr = v.getArray();
+        for(std::size_t i = 0; i < arr.size(); ++i)
+        {
+            if(i > 0)
+                out << ',';
+            appendString(out, arr.get(i));
+        }
+        return;
+    }
+    case dom::Kind::Object:
+        out << "[object Object]";
+        return;
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+/** Return a value converted as JavaScript does.
+*/
+std::string
+jsString(dom::Value const& v)
+{
+    if(v.isString())
+        return std::string(v.getString().get());
+    std::string s;
+    llvm::raw_string_ostream os(s);
+    appendString(os, v);
+    return s;
+}
+
+void
+appendEscaped(
+    llvm::raw_ostream& out,
+    std::string_view s)
+{
+    // runs of plain characters are written at once
+    std::size_t run = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        std::string_view rep;
+        switch(s[i])
+        {
+        case '&': rep = "&amp;"; break;
+        case '<': rep = "&lt;"; break;
+        case '>': rep = "&gt;"; break;
+        case '"': rep = "&quot;"; break;
+        case '\'': rep = "&#x27;"; break;
+        case '`': rep = "&#x60;"; break;
+        case '=': rep = "&#x3D;"; break;
+        default: continue;
+        }
+        out << s.substr(run, i - run) << rep;
+        run = i + 1;
+    }
+    out << s.substr(run);
+}
+
+/** The context of a partial called with hash arguments.
+
+    The hash arguments are looked up first, and
+    then the properties of the context. This has
+    the effect of `Utils.extend({}, context, hash)`
+    without copying the context.
+*/
+class PartialContextImpl : public dom::ObjectImpl
+{
+    dom::Value base_;
+    storage_type hash_;
+    mutable std::optional<storage_type> merged_;
+
+    storage_type const&
+    merged() const
+    {
+        if(merged_)
+            return *merged_;
+        storage_type v;
+        if(base_.isObject())
+        {
+            for(auto const& kv : base_.getObject())
+            {
+                auto it = std::find_if(hash_.begin(), hash_.end(),
+                    [&kv](auto const& h) { return h.key == kv.key; });
+                if(it == hash_.end())
+                    v.emplace_back(kv.key, kv.value);
+                else
+                    v.emplace_back(it->key, it->value);
+            }
+        }
+        for(auto const& h : hash_)
+            if(! base_.isObject() ||
+                ! base_.getObject().exists(h.key))
+                v.emplace_back(h.key, h.value);
+        return merged_.emplace(std::move(v));
+    }
+
+public:
+    PartialContextImpl(
+        dom::Value base,
+        storage_type hash) noexcept
+        : base_(std::move(base))
+        , hash_(std::move(hash))
+    {
+    }
+
+    std::size_t
+    size() const override
+    {
+        return merged().size();
+    }
+
+    reference
+    get(std::size_t i) const override
+    {
+        return merged()[i];
+    }
+
+    dom::Value
+    find(std::string_view key) const override
+    {
+        for(auto const& h : hash_)
+            if(h.key == key)
+                return h.value;
+        if(base_.isObject())
+            return base_.getObject().find(key);
+        return nullptr;
+    }
+
+    bool
+    exists(std::string_view key) const override
+    {
+        for(auto const& h : hash_)
+            if(h.key == key)
+                return true;
+        return base_.isObject() &&
+            base_.getObject().exists(key);
+    }
+
+    void
+    set(dom::String key, dom::Value value) override
+    {
+        merged_.reset();
+        for(auto& h : hash_)
+        {
+            if(h.key == key)
+            {
+                h.value = std::move(value);
+                return;
+            }
+        }
+        hash_.emplace_back(std::move(key), std::move(value));
+    }
+};
+
+} // (anon)
+
+//------------------------------------------------
+//
+// Renderer
+//
+//------------------------------------------------
+
+struct Handlebars::Renderer
+{
+    /** A context, and the contexts it is nested in.
+    */
+    struct Depth
+    {
+        dom::Value const& context;
+        Depth const* parent;
+    };
+
+    /** The data variables of an iteration.
+    */
+    struct Data
+    {
+        Data const* parent = nullptr;
+        dom::Value key;
+        std::int64_t index = 0;
+        bool first = false;
+        bool last = false;
+    };
+
+    Handlebars const& hbs;
+    Options const& opt;
+    dom::Value const& root;
+
+    void
+    program(
+        llvm::raw_ostream& out,
+        Program const* p,
+        dom::Value const& context,
+        Depth const* depths,
+        Data const* data)
+    {
+        if(! p)
+            return;
+        // every block and partial is a program,
+        // so a runaway render stops here
+        if(opt.deadline != std::chrono::steady_clock::time_point::max() &&
+            std::chrono::steady_clock::now() >= opt.deadline)
+            Error("the render ran out of time").Throw();
+        // a new depth begins when the context changes
+        Depth d{ context, depths };
+        Depth const* cur = (depths &&
+            isSame(depths->context, context)) ? depths : &d;
+        for(auto const& stmt : p->body)
+            statement(out, stmt, cur, data);
+    }
+
+    void
+    statement(
+        llvm::raw_ostream& out,
+        Stmt const& stmt,
+        Depth const* depths,
+        Data const* data)
+    {
+        switch(stmt.kind)
+        {
+        case StmtKind::Content:
+            out << stmt.value;
+            return;
+        case StmtKind::Comment:
+            return;
+        case StmtKind::Mustache:
+        {
+            auto v = mustache(stmt.call, depths, data);
+            if(v.isString() && (opt.noEscape || ! stmt.escaped))
+            {
+                out << v.getString().get();
+            }
+            else if(opt.noEscape || ! stmt.escaped)
+            {
+                appendString(out, v);
+            }
+            else
+            {
+                appendEscaped(out, jsString(v));
+            }
+            return;
+        }
+        case StmtKind::Block:
+            block(out, stmt, depths, data);
+            return;
+        case StmtKind::Partial:
+            partial(out, stmt, depths, data);
+            return;
+        default:
+            MRDOX_UNREACHABLE();
+        }
+    }
+
+    dom::Value
+    resolve(
+        Expr const& e,
+        Depth const* depths,
+        Data const* data)
+    {
+        dom::Value v;
+        auto part = e.parts.begin();
+        if(e.data)
+        {
+            for(auto n = e.depth; data && n > 0; --n)
+                data = data->parent;
+            if(part == e.parts.end())
+                return nullptr;
+            std::string_view const name = *part++;
+            if(name == "root")
+                v = root;
+            else if(! data)
+                return nullptr;
+            else if(name == "key")
+                v = data->key;
+            else if(name == "index")
+                v = data->index;
+            else if(name == "first")
+                v = data->first;
+            else if(name == "last")
+                v = data->last;
+            else
+                return nullptr;
+        }
+        else
+        {
+            for(auto n = e.depth; depths && n > 0; --n)
+                depths = depths->parent;
+            if(! depths)
+                return nullptr;
+            v = depths->context;
+        }
+        for(; part != e.parts.end(); ++part)
+        {
+            if(v.isNull())
+                return v;
+            v = lookupProperty(v, *part);
+        }
+        return v;
+    }
+
+    dom::Value
+    eval(
+        Expr const& e,
+        Depth const* depths,
+        Data const* data)
+    {
+        switch(e.kind)
+        {
+        case Expr::Kind::Literal:
+            return e.value;
+        case Expr::Kind::Path:
+            return resolve(e, depths, data);
+        case Expr::Kind::SubExpr:
+            return callHelper(*e.call, depths, data);
+        default:
+            MRDOX_UNREACHABLE();
+        }
+    }
+
+    Helper const*
+    findHelper(Expr const& path) const
+    {
+        if(! path.isSimple())
+            return nullptr;
+        auto it = hbs.helpers_.find(path.parts.front());
+        if(it == hbs.helpers_.end())
+            return nullptr;
+        return &it->getValue();
+    }
+
+    dom::Value
+    callHelper(
+        Call const& c,
+        Depth const* depths,
+        Data const* data)
+    {
+        auto helper = findHelper(c.path);
+        if(! helper)
+            formatError("Missing helper: \"{}\"",
+                c.path.original).Throw();
+        std::vector<dom::Value> args;
+        args.reserve(c.params.size());
+        for(auto const& param : c.params)
+            args.push_back(eval(param, depths, data));
+        return (*helper)(args);
+    }
+
+    dom::Value
+    mustache(
+        Call const& c,
+        Depth const* depths,
+        Data const* data)
+    {
+        if(! c.params.empty() || ! c.hash.empty())
+            return callHelper(c, depths, data);
+        if(findHelper(c.path))
+            return callHelper(c, depths, data);
+        return resolve(c.path, depths, data);
+    }
+
+    void
+    block(
+        llvm::raw_ostream& out,
+        Stmt const& stmt,
+        Depth const* depths,
+        Data const* data)
+    {
+        auto const& c = stmt.call;
+        auto const& context = depths->context;
+        std::string_view const name = c.path.isSimple() ?
+            std::string_view(c.path.parts.front()) :
+            std::string_view();
+
+        auto const oneArg = [&]() -> dom::Value
+        {
+            if(c.params.size() != 1)
+                formatError("#{} requires exactly one argument",
+                    name).Throw();
+            return eval(c.params.front(), depths, data);
+        };
+
+        if(name == "if" || name == "unless")
+        {
+            auto cond = oneArg();
+            bool includeZero = false;
+            for(auto const& h : c.hash)
+                if(h.key == "includeZero")
+                    includeZero = ! isFalsy(eval(h.value, depths, data));
+            bool falsy = isEmpty(cond) ||
+                (! includeZero && cond.isInteger() && cond.getInteger() == 0);
+            if(name == "unless")
+                falsy = ! falsy;
+            program(out, falsy ? stmt.inverse.get() :
+                stmt.program.get(), context, depths, data);
+            return;
+        }
+        if(name == "with")
+        {
+            auto v = oneArg();
+            if(isEmpty(v))
+                program(out, stmt.inverse.get(), context, depths, data);
+            else
+                program(out, stmt.program.get(), v, depths, data);
+            return;
+        }
+        if(name == "each")
+        {
+            if(c.params.empty())
+                formatError("Must pass iterator to #each").Throw();
+            each(out, stmt, eval(c.params.front(), depths, data),
+                depths, data);
+            return;
+        }
+        if(findHelper(c.path))
+        {
+            // simple helpers ignore their block
+            appendString(out, callHelper(c, depths, data));
+            return;
+        }
+        if(! c.params.empty() || ! c.hash.empty())
+            formatError("Missing helper: \"{}\"",
+                c.path.original).Throw();
+
+        // blockHelperMissing
+        auto v = resolve(c.path, depths, data);
+        if(v.isBoolean() && v.getBool())
+            program(out, stmt.program.get(), context, depths, data);
+        else if(v.isNull() || v.isBoolean())
+            program(out, stmt.inverse.get(), context, depths, data);
+        else if(v.isArray())
+            each(out, stmt, v, depths, data);
+        else
+            program(out, stmt.program.get(), v, depths, data);
+    }
+
+    void
+    each(
+        llvm::raw_ostream& out,
+        Stmt const& stmt,
+        dom::Value const& v,
+        Depth const* depths,
+        Data const* data)
+    {
+        Data frame;
+        frame.parent = data;
+        std::size_t n = 0;
+        if(v.isArray())
+        {
+            auto const& arr = v.getArray();
+            n = arr.size();
+            std::int64_t i = 0;
+            arr.forEach([&](dom::Value const& elem)
+            {
+                frame.key = i;
+                frame.index = i;
+                frame.first = i == 0;
+                frame.last = static_cast<std::size_t>(i + 1) == n;
+                program(out, stmt.program.get(), elem, depths, &frame);
+                ++i;
+            });
+        }
+        else if(v.isObject())
+        {
+            auto const& obj = v.getObject();
+            n = obj.size();
+            std::int64_t i = 0;
+            for(auto const& kv : obj)
+            {
+                frame.key = kv.key;
+                frame.index = i;
+                frame.first = i == 0;
+                frame.last = static_cast<std::size_t>(i + 1) == n;
+                program(out, stmt.program.get(), kv.value, depths, &frame);
+                ++i;
+            }
+        }
+        if(n == 0)
+            program(out, stmt.inverse.get(),
+                depths->context, depths, data);
+    }
+
+    void
+    partial(
+        llvm::raw_ostream& out,
+        Stmt const& stmt,
+        Depth const* depths,
+        Data const* data)
+    {
+        auto const& c = stmt.call;
+        std::string name;
+        if(c.path.kind == Expr::Kind::SubExpr)
+        {
+            auto v = callHelper(*c.path.call, depths, data);
+            if(v.isNull())
+                name = "undefined";
+            else
+                name = jsString(v);
+        }
+        else
+        {
+            name = c.path.original;
+        }
+
+        auto it = hbs.partials_.find(name);
+        if(it == hbs.partials_.end())
+            formatError("The partial {} could not be found",
+                name).Throw();
+        auto& p = it->getValue();
+        if(! p.tmpl)
+        {
+            auto tmpl = compile(p.text);
+            if(! tmpl)
+                formatError("partial \"{}\": {}", name,
+                    tmpl.error().message()).Throw();
+            p.tmpl = std::move(*tmpl);
+        }
+        // hold the program, in case the
+        // partial is registered again
+        auto const prog = p.tmpl.program_;
+
+        dom::Value context = c.params.empty() ?
+            depths->context : eval(c.params.front(), depths, data);
+        if(! c.hash.empty())
+        {
+            dom::Object::storage_type hash;
+            hash.reserve(c.hash.size());
+            for(auto const& h : c.hash)
+                hash.emplace_back(h.key, eval(h.value, depths, data));
+            context = partialContext(
+                std::move(context), std::move(hash));
+        }
+
+        RenderProfile::Scope timing(opt.profile, name);
+        std::string key;
+        if( opt.fragments && c.hash.empty() &&
+            opt.fragments->caches(name))
+            key = FragmentCache::makeKey(name, context, p.hash);
+        if(! key.empty())
+        {
+            if(auto text = opt.fragments->find(key))
+            {
+                indented(out, stmt, *text);
+                return;
+            }
+            std::string s;
+            llvm::raw_string_ostream os(s);
+            SymbolRecorder recorder;
+            program(os, prog.get(), context, nullptr, data);
+            indented(out, stmt, s);
+            opt.fragments->insert(key, std::move(s), recorder.ids());
+            return;
+        }
+        if(stmt.indent.empty() || opt.preventIndent)
+        {
+            program(out, prog.get(), context, nullptr, data);
+            return;
+        }
+        std::string s;
+        llvm::raw_string_ostream os(s);
+        program(os, prog.get(), context, nullptr, data);
+        indented(out, stmt, s);
+    }
+
+    // Write the output of a partial, with the
+    // indentation of a standalone partial
+    void
+    indented(
+        llvm::raw_ostream& out,
+        Stmt const& stmt,
+        std::string_view text)
+    {
+        if(stmt.indent.empty() || opt.preventIndent)
+        {
+            out << text;
+            return;
+        }
+        while(! text.empty())
+        {
+            auto n = text.find('\n');
+            n = (n == npos) ? text.size() : n + 1;
+            out << stmt.indent << text.substr(0, n);
+            text.remove_prefix(n);
+        }
+    }
+};
+
+//------------------------------------------------
+//
+// Lua
+//
+//------------------------------------------------
+
+namespace {
+
+/** Writes a template as a Lua chunk.
+
+    Each program becomes a function of the context,
+    the depths, the data frame and the output table,
+    in the order the Renderer passes them. The names
+    used by the chunk are the runtime functions in
+    LuaHandlebars.cpp.
+*/
+class LuaWriter
+{
+    std::vector<std::string> funcs_;
+    llvm::DenseMap<Program const*, std::size_t> index_;
+    bool depths_ = false;
+
+    static
+    void
+    literal(std::string& out, std::string_view s)
+    {
+        out += '"';
+        for(unsigned char c : s)
+        {
+            switch(c)
+            {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if(c < 0x20 || c == 0x7f)
+                    out += fmt::format("\\{:03}", c);
+                else
+                    out += static_cast<char>(c);
+                break;
+            }
+        }
+        out += '"';
+    }
+
+    static
+    std::string
+    literal(std::string_view s)
+    {
+        std::string out;
+        literal(out, s);
+        return out;
+    }
+
+    static
+    std::string
+    literalValue(dom::Value const& v)
+    {
+        switch(v.kind())
+        {
+        case dom::Kind::Boolean:
+            return v.getBool() ? "true" : "false";
+        case dom::Kind::Integer:
+            if(v.getInteger() == std::numeric_limits<std::int64_t>::min())
+                return "math.mininteger";
+            return fmt::format("({})", v.getInteger());
+        case dom::Kind::String:
+            return literal(v.getString().get());
+        default:
+            return "nil";
+        }
+    }
+
+    // Return true if an expression refers to an outer context
+    static
+    bool
+    usesDepths(Expr const& e)
+    {
+        if(e.kind == Expr::Kind::SubExpr)
+            return usesDepths(*e.call);
+        return e.kind == Expr::Kind::Path &&
+            ! e.data && e.depth > 0;
+    }
+
+    static
+    bool
+    usesDepths(Call const& c)
+    {
+        return usesDepths(c.path) ||
+            std::ranges::any_of(c.params,
+                [](Expr const& e) { return usesDepths(e); }) ||
+            std::ranges::any_of(c.hash,
+                [](HashArg const& h) { return usesDepths(h.value); });
+    }
+
+    static
+    bool
+    usesDepths(Program const* p)
+    {
+        if(! p)
+            return false;
+        for(auto const& stmt : p->body)
+        {
+            switch(stmt.kind)
+            {
+            case StmtKind::Mustache:
+            case StmtKind::Partial:
+                if(usesDepths(stmt.call))
+                    return true;
+                break;
+            case StmtKind::Block:
+                if( usesDepths(stmt.call) ||
+                    usesDepths(stmt.program.get()) ||
+                    usesDepths(stmt.inverse.get()))
+                    return true;
+                break;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+    std::string
+    resolve(Expr const& e)
+    {
+        std::string v;
+        auto part = e.parts.begin();
+        if(e.data)
+        {
+            if(part == e.parts.end())
+                return "nil";
+            std::string_view const name = *part++;
+            if(name == "root")
+                v = "R.root";
+            else if(
+                name == "key" || name == "index" ||
+                name == "first" || name == "last")
+                v = fmt::format("Dt(a, {}, \"{}\")", e.depth, name);
+            else
+                return "nil";
+        }
+        else if(e.depth > 0)
+        {
+            v = fmt::format("U(d, {})", e.depth);
+        }
+        else
+        {
+            v = "c";
+        }
+        for(; part != e.parts.end(); ++part)
+            v = fmt::format("L({}, {})", v, literal(*part));
+        return v;
+    }
+
+    std::string
+    eval(Expr const& e)
+    {
+        switch(e.kind)
+        {
+        case Expr::Kind::Literal:
+            return literalValue(e.value);
+        case Expr::Kind::Path:
+            return resolve(e);
+        case Expr::Kind::SubExpr:
+            return callHelper(*e.call);
+        default:
+            MRDOX_UNREACHABLE();
+        }
+    }
+
+    std::string
+    args(Call const& c)
+    {
+        std::string s;
+        for(auto const& param : c.params)
+        {
+            if(! s.empty())
+                s += ", ";
+            s += eval(param);
+        }
+        return s;
+    }
+
+    std::string
+    callHelper(Call const& c)
+    {
+        if(! c.path.isSimple())
+            return fmt::format("M({})()",
+                literal(c.path.original));
+        return fmt::format("(H[{}] or M({}))({})",
+            literal(c.path.parts.front()),
+            literal(c.path.original), args(c));
+    }
+
+    // Return a call to a program, or nothing
+    std::string
+    call(
+        Program const* p,
+        std::string_view context)
+    {
+        if(! p)
+            return {};
+        return fmt::format("B[{}]({}, d, a, o) ",
+            program(p), context);
+    }
+
+    void
+    statement(std::string& out, Stmt const& stmt)
+    {
+        auto const& c = stmt.call;
+        switch(stmt.kind)
+        {
+        case StmtKind::Content:
+            if(stmt.value.empty())
+                return;
+            out += "o[#o+1] = ";
+            literal(out, stmt.value);
+            out += '\n';
+            return;
+        case StmtKind::Comment:
+            return;
+        case StmtKind::Mustache:
+        {
+            std::string_view const write =
+                stmt.escaped ? "R.e" : "S";
+            if(! c.params.empty() || ! c.hash.empty())
+            {
+                out += fmt::format("o[#o+1] = {}({})\n",
+                    write, callHelper(c));
+            }
+            else if(c.path.isSimple())
+            {
+                out += fmt::format(
+                    "do local h, v = H[{}] "
+                    "if h then v = h() else v = {} end "
+                    "o[#o+1] = {}(v) end\n",
+                    literal(c.path.parts.front()),
+                    resolve(c.path), write);
+            }
+            else
+            {
+                out += fmt::format("o[#o+1] = {}({})\n",
+                    write, resolve(c.path));
+            }
+            return;
+        }
+        case StmtKind::Block:
+            block(out, stmt);
+            return;
+        case StmtKind::Partial:
+            partial(out, stmt);
+            return;
+        default:
+            MRDOX_UNREACHABLE();
+        }
+    }
+
+    void
+    block(std::string& out, Stmt const& stmt)
+    {
+        auto const& c = stmt.call;
+        std::string_view const name = c.path.isSimple() ?
+            std::string_view(c.path.parts.front()) :
+            std::string_view();
+        auto const prog = stmt.program.get();
+        auto const inv = stmt.inverse.get();
+
+        if(name == "if" || name == "unless" || name == "with")
+        {
+            if(c.params.size() != 1)
+            {
+                out += fmt::format("error({}, 0)\n", literal(fmt::format(
+                    "#{} requires exactly one argument", name)));
+                return;
+            }
+            out += fmt::format("do local v = {}\n", eval(c.params.front()));
+            if(name == "with")
+            {
+                out += fmt::format("if Em(v) then {}else {}end end\n",
+                    call(inv, "c"), call(prog, "v"));
+                return;
+            }
+            out += "local z = false\n";
+            for(auto const& h : c.hash)
+                if(h.key == "includeZero")
+                    out += fmt::format("z = not F({})\n", eval(h.value));
+            out += fmt::format(
+                "if {}(Em(v) or (not z and v == 0)) then {}else {}end end\n",
+                name == "unless" ? "not " : "",
+                call(inv, "c"), call(prog, "c"));
+            return;
+        }
+        if(name == "each")
+        {
+            if(c.params.empty())
+            {
+                out += "error(\"Must pass iterator to #each\", 0)\n";
+                return;
+            }
+            out += fmt::format("EA({}, {}, {}, c, d, a, o)\n",
+                eval(c.params.front()),
+                prog ? fmt::format("B[{}]", program(prog)) : "nil",
+                inv ? fmt::format("B[{}]", program(inv)) : "nil");
+            return;
+        }
+
+        std::string missing;
+        if(! c.params.empty() || ! c.hash.empty())
+        {
+            missing = fmt::format("M({})()\n",
+                literal(c.path.original));
+        }
+        else
+        {
+            // blockHelperMissing
+            missing = fmt::format(
+                "local v = {}\n"
+                "if v == true then {}"
+                "elseif v == nil or v == false then {}"
+                "elseif K(v) == \"dom.Array\" then EA(v, {}, {}, c, d, a, o) "
+                "else {}end\n",
+                resolve(c.path),
+                call(prog, "c"), call(inv, "c"),
+                prog ? fmt::format("B[{}]", program(prog)) : "nil",
+                inv ? fmt::format("B[{}]", program(inv)) : "nil",
+                call(prog, "v"));
+        }
+        if(name.empty())
+        {
+            out += fmt::format("do {}end\n", missing);
+            return;
+        }
+        // simple helpers ignore their block
+        out += fmt::format(
+            "do local h = H[{}] if h then o[#o+1] = S(h({})) else\n"
+            "{}end end\n",
+            literal(name), args(c), missing);
+    }
+
+    void
+    partial(std::string& out, Stmt const& stmt)
+    {
+        auto const& c = stmt.call;
+        std::string name;
+        if(c.path.kind == Expr::Kind::SubExpr)
+            name = fmt::format("Pn({})", callHelper(*c.path.call));
+        else
+            name = literal(c.path.original);
+        std::string context = c.params.empty() ?
+            std::string("c") : eval(c.params.front());
+        if(! c.hash.empty())
+        {
+            std::string hash;
+            for(auto const& h : c.hash)
+                hash += fmt::format(", {}, {}",
+                    literal(h.key), eval(h.value));
+            context = fmt::format("CX({}{})", context, hash);
+        }
+        out += fmt::format("PA({}, {}, a, o, {})\n",
+            name, context, literal(stmt.indent));
+    }
+
+    // Write a program as a function, returning its index
+    std::size_t
+    program(Program const* p)
+    {
+        auto [it, inserted] = index_.try_emplace(p, funcs_.size());
+        if(! inserted)
+            return it->second;
+        auto const index = it->second;
+        funcs_.emplace_back();
+        std::string out = fmt::format(
+            "B[{}] = function(c, d, a, o)\n", index);
+        // a new depth begins when the context changes
+        if(depths_)
+            out += "if d == nil or d.c ~= c then d = { c = c, p = d } end\n";
+        for(auto const& stmt : p->body)
+            statement(out, stmt);
+        out += "end\n";
+        funcs_[index] = std::move(out);
+        return index;
+    }
+
+public:
+    std::string
+    operator()(Program const& p)
+    {
+        depths_ = usesDepths(&p);
+        program(&p);
+        std::string out =
+            "local R = ...\n"
+            "local H, K, L, S, F, Em, M = R.H, R.K, R.L, R.S, R.F, R.Em, R.M\n"
+            "local U, Dt, EA, PA, Pn, CX = R.U, R.Dt, R.each, R.partial, R.Pn, R.ctx\n"
+            "local B = {}\n";
+        for(auto const& f : funcs_)
+            out += f;
+        out += "return B[0]\n";
+        return out;
+    }
+};
+
+} // (anon)
+
+//------------------------------------------------
+//
+// FragmentCache
+//
+//------------------------------------------------
+
+FragmentCache::
+FragmentCache(
+    std::vector<std::string> const& names)
+{
+    for(auto const& name : names)
+        names_.insert(name);
+}
+
+std::string
+FragmentCache::
+makeKey(
+    std::string_view name,
+    dom::Value const& context,
+    std::uint64_t hash)
+{
+    if(! context.isObject())
+        return {};
+    // types and template parameters have an
+    // id too, but only symbols have a namespace
+    auto const& obj = context.getObject();
+    auto id = obj.find("id");
+    if(! id.isString() || ! obj.exists("namespace"))
+        return {};
+    return fmt::format("{}:{}:{:016x}",
+        name, id.getString().get(), hash);
+}
+
+std::optional<std::string_view>
+FragmentCache::
+find(
+    std::string_view key)
+{
+    Shard& shard = shards_[llvm::xxHash64(key) % NumShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.fragments.find(key);
+    if(it == shard.fragments.end())
+    {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    SymbolRecorder::add(it->getValue().symbols);
+    // StringMap values do not move
+    return std::string_view(it->getValue().text);
+}
+
+void
+FragmentCache::
+insert(
+    std::string_view key,
+    std::string text,
+    std::vector<SymbolID> symbols)
+{
+    Shard& shard = shards_[llvm::xxHash64(key) % NumShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // a racing render of the same call
+    // produced the same text
+    shard.fragments.try_emplace(key,
+        Fragment{ std::move(text), std::move(symbols) });
+}
+
+//------------------------------------------------
+//
+// Handlebars
+//
+//------------------------------------------------
+
+Handlebars::
+Handlebars()
+{
+    registerHelper("lookup",
+        [](std::span<dom::Value const> args) -> dom::Value
+        {
+            if(args.empty())
+                return nullptr;
+            if(isFalsy(args[0]) || args.size() < 2)
+                return args[0];
+            return lookupProperty(args[0], jsString(args[1]));
+        });
+    registerHelper("log",
+        [](std::span<dom::Value const>) -> dom::Value
+        {
+            return nullptr;
+        });
+}
+
+Handlebars::
+~Handlebars() = default;
+
+Expected<Handlebars::Template>
+Handlebars::
+compile(std::string_view text)
+{
+    try
+    {
+        auto program = Parser(text).parse();
+        WhitespaceControl().program(*program);
+        Template tmpl;
+        tmpl.program_ = std::move(program);
+        return tmpl;
+    }
+    catch(Exception const& ex)
+    {
+        return ex.error();
+    }
+}
+
+Expected<std::string>
+Handlebars::
+toLua(std::string_view text)
+{
+    auto tmpl = compile(text);
+    if(! tmpl)
+        return tmpl.error();
+    return LuaWriter()(*tmpl->program_);
+}
+
+dom::Value
+Handlebars::
+partialContext(
+    dom::Value context,
+    dom::Object::storage_type hash)
+{
+    return dom::newObject<PartialContextImpl>(
+        std::move(context), std::move(hash));
+}
+
+void
+Handlebars::
+registerPartial(
+    std::string_view name,
+    std::string_view text)
+{
+    partials_.insert_or_assign(name,
+        Partial{ std::string(text), {}, llvm::xxHash64(text) });
+}
+
+void
+Handlebars::
+registerHelper(
+    std::string_view name,
+    Helper helper)
+{
+    helpers_.insert_or_assign(name, std::move(helper));
+}
+
+Error
+Handlebars::
+render(
+    llvm::raw_ostream& os,
+    Template const& tmpl,
+    dom::Value const& context,
+    Options const& options) const
+{
+    if(! tmpl)
+        return Error("template is not compiled");
+    try
+    {
+        Renderer r{ *this, options, context };
+        r.program(os, tmpl.program_.get(), context, nullptr, nullptr);
+    }
+    catch(Exception const& ex)
+    {
+        return ex.error();
+    }
+    return Error::success();
+}
+
+Expected<std::string>
+Handlebars::
+render(
+    Template const& tmpl,
+    dom::Value const& context,
+    Options const& options) const
+{
+    std::string out;
+    llvm::raw_string_ostream os(out);
+    if(auto err = render(os, tmpl, context, options))
+        return err;
+    return out;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,317 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SUPPORT_HANDLEBARS_HPP
+#define MRDOX_LIB_SUPPORT_HANDLEBARS_HPP
+
+#include "Support/RenderProfile.hpp"
+#include <mrdox/Metadata/Symbols.hpp>
+#include <mrdox/Support/Dom.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A native Handlebars template engine.
+
+    Templates are parsed once into a tree of
+    statements, which is evaluated directly
+    against Dom values. The language is the
+    subset used by the generator addons:
+    expressions, comments, whitespace control,
+    standalone lines, subexpressions, hash
+    arguments, the built-in block helpers
+    `if`, `unless`, `each` and `with`, the
+    `lookup` helper, plus partials, including
+    dynamic partials and partial indentation.
+
+    Output is meant to be identical to that of
+    Handlebars.js for the templates it accepts.
+    Inline partials, partial blocks, decorators,
+    block parameters and raw blocks are not
+    supported, and are reported as errors.
+
+    @par Thread Safety
+    Distinct objects may be used concurrently.
+*/
+/** Rendered partials, shared by the renders of every thread.
+
+    A partial named in the cache, which is called
+    with a symbol as its only argument, is rendered
+    once for each symbol and text of the partial.
+    The output of such a partial must depend only
+    on the symbol.
+*/
+class FragmentCache
+{
+    static constexpr std::size_t NumShards = 16;
+
+    struct Fragment
+    {
+        std::string text;
+
+        // looked up by the render
+        std::vector<SymbolID> symbols;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::StringMap<Fragment> fragments;
+    };
+
+    llvm::StringSet<> names_;
+    std::array<Shard, NumShards> shards_;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+
+public:
+    /** Constructor.
+
+        @param names The names of the partials
+        whose renders are kept.
+    */
+    explicit
+    FragmentCache(
+        std::vector<std::string> const& names);
+
+    /** Return true if the renders of a partial are kept.
+    */
+    bool
+    caches(
+        std::string_view name) const noexcept
+    {
+        return names_.contains(name);
+    }
+
+    /** Return the key of a call, or an empty string.
+
+        Only a call whose context is a symbol
+        has a key.
+    */
+    static
+    std::string
+    makeKey(
+        std::string_view name,
+        dom::Value const& context,
+        std::uint64_t hash);
+
+    /** Return a kept render.
+
+        The view remains valid for the
+        lifetime of the cache. The symbols which
+        the render looked up are added to the
+        recorder of the thread.
+    */
+    std::optional<std::string_view>
+    find(
+        std::string_view key);
+
+    /** Keep a render.
+
+        @param symbols The symbols which
+        the render looked up.
+    */
+    void
+    insert(
+        std::string_view key,
+        std::string text,
+        std::vector<SymbolID> symbols);
+
+    std::size_t hits() const noexcept { return hits_; }
+    std::size_t misses() const noexcept { return misses_; }
+};
+
+class Handlebars
+{
+    struct Renderer;
+
+public:
+    /** The statements of a compiled template.
+    */
+    struct Program;
+
+    /** A simple helper.
+
+        The function receives the evaluated
+        positional arguments of the call.
+        Hash arguments are not passed.
+    */
+    using Helper = std::function<
+        dom::Value(std::span<dom::Value const> args)>;
+
+    /** Options for rendering.
+    */
+    struct Options
+    {
+        /** Do not escape the values of expressions.
+        */
+        bool noEscape = false;
+
+        /** Do not indent the lines of standalone partials.
+        */
+        bool preventIndent = false;
+
+        /** If not null, the profile which times each partial.
+        */
+        RenderProfile* profile = nullptr;
+
+        /** The time after which the render fails.
+        */
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::time_point::max();
+
+        /** If not null, the renders of partials which are reused.
+        */
+        FragmentCache* fragments = nullptr;
+    };
+
+    /** A compiled template.
+    */
+    class Template
+    {
+        friend class Handlebars;
+        friend struct Renderer;
+
+        std::shared_ptr<Program const> program_;
+
+    public:
+        Template() = default;
+
+        /** Return true if the template was compiled.
+        */
+        explicit operator bool() const noexcept
+        {
+            return program_ != nullptr;
+        }
+    };
+
+    /** Constructor.
+
+        The built-in helpers are registered.
+    */
+    Handlebars();
+
+    ~Handlebars();
+
+    /** Compile a template.
+    */
+    static
+    Expected<Template>
+    compile(std::string_view text);
+
+    /** Translate a template into a Lua chunk.
+
+        The chunk is called with the runtime
+        in LuaHandlebars.cpp, and returns the
+        function which renders the template.
+    */
+    static
+    Expected<std::string>
+    toLua(std::string_view text);
+
+    /** Return the context of a partial called with hash arguments.
+
+        The hash arguments are found first, and
+        then the properties of the context, which
+        is not copied.
+    */
+    static
+    dom::Value
+    partialContext(
+        dom::Value context,
+        dom::Object::storage_type hash);
+
+    /** Register a partial.
+
+        The text is compiled the first time
+        the partial is used.
+    */
+    void
+    registerPartial(
+        std::string_view name,
+        std::string_view text);
+
+    /** Register a helper, replacing any with the same name.
+    */
+    void
+    registerHelper(
+        std::string_view name,
+        Helper helper);
+
+    /** Render a template to a stream.
+
+        Output is written as it is produced,
+        so nothing is held for the whole page.
+        If an error occurs, the output written
+        so far is left in the stream.
+
+        @param os The stream to write to.
+
+        @param tmpl The compiled template.
+
+        @param context The value used as `this`
+        at the top level of the template.
+
+        @param options The rendering options.
+    */
+    Error
+    render(
+        llvm::raw_ostream& os,
+        Template const& tmpl,
+        dom::Value const& context,
+        Options const& options) const;
+
+    /** Render a template.
+
+        @param tmpl The compiled template.
+
+        @param context The value used as `this`
+        at the top level of the template.
+
+        @param options The rendering options.
+    */
+    Expected<std::string>
+    render(
+        Template const& tmpl,
+        dom::Value const& context,
+        Options const& options) const;
+
+private:
+    struct Partial
+    {
+        std::string text;
+        Template tmpl;
+        std::uint64_t hash = 0;
+    };
+
+    llvm::StringMap<Helper> helpers_;
+    mutable llvm::StringMap<Partial> partials_;
+};
+
+} // mrdox
+} // clang
+
+#endif
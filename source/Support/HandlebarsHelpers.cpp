@@ -0,0 +1,228 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/HandlebarsHelpers.hpp"
+#include "Support/JsonWriter.hpp"
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <string>
+
+namespace clang {
+namespace mrdox {
+
+void
+HelperRegistry::
+add(
+    std::string_view name,
+    Handlebars::Helper helper)
+{
+    helpers_.insert_or_assign(name, std::move(helper));
+}
+
+Handlebars::Helper const*
+HelperRegistry::
+find(std::string_view name) const noexcept
+{
+    auto it = helpers_.find(name);
+    if(it == helpers_.end())
+        return nullptr;
+    return &it->getValue();
+}
+
+//------------------------------------------------
+
+namespace {
+
+using Args = std::span<dom::Value const>;
+
+dom::Value
+arg(Args args, std::size_t i)
+{
+    if(i < args.size())
+        return args[i];
+    return nullptr;
+}
+
+/** Return true if a value is truthy in JavaScript.
+*/
+bool
+isTruthy(dom::Value const& v)
+{
+    // unlike dom::Value::isTruthy,
+    // empty arrays and objects are true
+    if(v.isArray() || v.isObject())
+        return true;
+    return v.isTruthy();
+}
+
+/** Return true if two values are equal, like "===".
+*/
+bool
+isStrictEqual(
+    dom::Value const& a,
+    dom::Value const& b)
+{
+    if(a.kind() != b.kind())
+        return false;
+    switch(a.kind())
+    {
+    case dom::Kind::Null:
+        return true;
+    case dom::Kind::Boolean:
+        return a.getBool() == b.getBool();
+    case dom::Kind::Integer:
+        return a.getInteger() == b.getInteger();
+    case dom::Kind::String:
+        return a.getString() == b.getString();
+    case dom::Kind::Array:
+        return a.getArray().impl() == b.getArray().impl();
+    case dom::Kind::Object:
+        return a.getObject().impl() == b.getObject().impl();
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+dom::Value
+eq(Args args)
+{
+    return isStrictEqual(arg(args, 0), arg(args, 1));
+}
+
+dom::Value
+ne(Args args)
+{
+    return ! isStrictEqual(arg(args, 0), arg(args, 1));
+}
+
+dom::Value
+not_(Args args)
+{
+    return ! isTruthy(arg(args, 0));
+}
+
+dom::Value
+or_(Args args)
+{
+    // two arguments yield one of them, like "||"
+    if(args.size() <= 2)
+    {
+        auto a = arg(args, 0);
+        return isTruthy(a) ? a : arg(args, 1);
+    }
+    for(auto const& v : args)
+        if(isTruthy(v))
+            return true;
+    return false;
+}
+
+dom::Value
+and_(Args args)
+{
+    // two arguments yield one of them, like "&&"
+    if(args.size() <= 2)
+    {
+        auto a = arg(args, 0);
+        return isTruthy(a) ? arg(args, 1) : a;
+    }
+    for(auto const& v : args)
+        if(! isTruthy(v))
+            return false;
+    return true;
+}
+
+dom::Value
+increment(Args args)
+{
+    auto v = arg(args, 0);
+    if(! isTruthy(v))
+        return 1;
+    if(v.isInteger())
+        return v.getInteger() + 1;
+    if(v.isBoolean())
+        return 2;
+    if(v.isString())
+        return std::string(v.getString()) + "1";
+    return v;
+}
+
+dom::Value
+detag(Args args)
+{
+    auto v = arg(args, 0);
+    if(! v.isString())
+        return v;
+    // removes each "<...>" which is not empty
+    std::string_view s = v.getString().get();
+    std::string result;
+    result.reserve(s.size());
+    while(! s.empty())
+    {
+        auto const i = s.find('<');
+        auto const j = i == s.npos ? s.npos : s.find('>', i + 1);
+        if(j == s.npos || j == i + 1)
+        {
+            auto const n = j == s.npos ? s.size() : j + 1;
+            result.append(s.substr(0, n));
+            s.remove_prefix(n);
+            continue;
+        }
+        result.append(s.substr(0, i));
+        s.remove_prefix(j + 1);
+    }
+    return result;
+}
+
+dom::Value
+year(Args)
+{
+    namespace chr = std::chrono;
+    chr::year_month_day const ymd(
+        chr::floor<chr::days>(chr::system_clock::now()));
+    return std::to_string(static_cast<int>(ymd.year()));
+}
+
+dom::Value
+to_string(Args args)
+{
+    std::string s;
+    llvm::raw_string_ostream os(s);
+    JsonWriter(os, 2).write(arg(args, 0));
+    return os.str();
+}
+
+HelperRegistry
+makeBuiltins()
+{
+    HelperRegistry r;
+    r.add("eq", eq);
+    r.add("ne", ne);
+    r.add("neq", ne);
+    r.add("not", not_);
+    r.add("or", or_);
+    r.add("and", and_);
+    r.add("increment", increment);
+    r.add("detag", detag);
+    r.add("year", year);
+    r.add("to_string", to_string);
+    return r;
+}
+
+} // (anon)
+
+HelperRegistry const&
+builtinHelpers()
+{
+    static HelperRegistry const r = makeBuiltins();
+    return r;
+}
+
+} // mrdox
+} // clang
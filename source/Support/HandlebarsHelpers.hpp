@@ -0,0 +1,69 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SUPPORT_HANDLEBARSHELPERS_HPP
+#define MRDOX_LIB_SUPPORT_HANDLEBARSHELPERS_HPP
+
+#include "Support/Handlebars.hpp"
+#include <llvm/ADT/StringMap.h>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** A set of native helpers, by name.
+
+    The same helpers are given to every template
+    engine, so that templates do not depend on
+    the engine which renders them. Values follow
+    the JavaScript rules: empty arrays and
+    objects are truthy, and equality is strict.
+*/
+class HelperRegistry
+{
+    llvm::StringMap<Handlebars::Helper> helpers_;
+
+public:
+    /** Add a helper, replacing any with the same name.
+    */
+    void
+    add(
+        std::string_view name,
+        Handlebars::Helper helper);
+
+    /** Return the helper with the given name, or nullptr.
+    */
+    Handlebars::Helper const*
+    find(std::string_view name) const noexcept;
+
+    /** Invoke a function with the name and helper of each element.
+    */
+    template<class F>
+    void
+    forEach(F&& f) const
+    {
+        for(auto const& e : helpers_)
+            f(std::string_view(e.getKey()), e.getValue());
+    }
+};
+
+/** Return the helpers built into the generators.
+
+    These are `eq`, `ne`, `neq`, `not`, `or`,
+    `and`, `increment`, `detag`, `year` and
+    `to_string`.
+*/
+HelperRegistry const&
+builtinHelpers();
+
+} // mrdox
+} // clang
+
+#endif
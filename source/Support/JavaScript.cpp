@@ -8,12 +8,19 @@
 // Official repository: https://github.com/cppalliance/mrdox
 //
 
+#include "Support/Trace.hpp"
 #include <mrdox/Platform.hpp>
 #include <mrdox/Support/Path.hpp>
 #include <mrdox/Support/JavaScript.hpp>
 #include <llvm/Support/MemoryBuffer.h>
 #include <duktape.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <llvm/Support/raw_ostream.h>
 
@@ -43,11 +50,160 @@ namespace js {
 
 //------------------------------------------------
 
+namespace {
+
+/** The memory of one heap.
+
+    Small blocks are carved from large chunks
+    and recycled through a free list for each
+    size, so the allocations of the interpreter
+    rarely reach the system allocator. Memory is
+    returned to the system when the pool is
+    destroyed. A heap is used by one thread at
+    a time, so there is no locking.
+*/
+class HeapPool
+{
+    // each block is preceded by its size,
+    // padded to keep the block aligned
+    static constexpr std::size_t headerSize = 16;
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t maxSmall = 512;
+    static constexpr std::size_t chunkSize = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::vector<void*> chunks_;
+    FreeBlock* free_[maxSmall / granularity] = {};
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+
+    static
+    std::size_t&
+    sizeOf(void* p) noexcept
+    {
+        return *reinterpret_cast<std::size_t*>(
+            static_cast<char*>(p) - headerSize);
+    }
+
+    void*
+    allocSmall(std::size_t size)
+    {
+        auto& head = free_[size / granularity - 1];
+        if(head)
+        {
+            void* p = head;
+            head = head->next;
+            return p;
+        }
+        if(static_cast<std::size_t>(end_ - cur_) <
+            headerSize + size)
+        {
+            cur_ = static_cast<char*>(std::malloc(chunkSize));
+            if(! cur_)
+                return nullptr;
+            end_ = cur_ + chunkSize;
+            chunks_.push_back(cur_);
+        }
+        void* p = cur_ + headerSize;
+        cur_ += headerSize + size;
+        sizeOf(p) = size;
+        return p;
+    }
+
+public:
+    HeapPool() = default;
+    HeapPool(HeapPool const&) = delete;
+    HeapPool& operator=(HeapPool const&) = delete;
+
+    ~HeapPool()
+    {
+        for(void* chunk : chunks_)
+            std::free(chunk);
+    }
+
+    void*
+    alloc(std::size_t n)
+    {
+        if(n == 0)
+            return nullptr;
+        if(n <= maxSmall)
+            return allocSmall(
+                (n + granularity - 1) & ~(granularity - 1));
+        auto p = static_cast<char*>(std::malloc(headerSize + n));
+        if(! p)
+            return nullptr;
+        p += headerSize;
+        sizeOf(p) = n;
+        return p;
+    }
+
+    void
+    free(void* p) noexcept
+    {
+        if(! p)
+            return;
+        auto const size = sizeOf(p);
+        if(size > maxSmall)
+        {
+            std::free(static_cast<char*>(p) - headerSize);
+            return;
+        }
+        auto& head = free_[size / granularity - 1];
+        head = ::new(p) FreeBlock{ head };
+    }
+
+    void*
+    realloc(void* p, std::size_t n)
+    {
+        if(! p)
+            return alloc(n);
+        if(n == 0)
+        {
+            free(p);
+            return nullptr;
+        }
+        auto const size = sizeOf(p);
+        if(size > maxSmall && n > maxSmall)
+        {
+            auto q = static_cast<char*>(std::realloc(
+                static_cast<char*>(p) - headerSize,
+                headerSize + n));
+            if(! q)
+                return nullptr;
+            q += headerSize;
+            sizeOf(q) = n;
+            return q;
+        }
+        if(n <= size && size <= maxSmall)
+            return p;
+        void* q = alloc(n);
+        if(! q)
+            return nullptr;
+        std::memcpy(q, p, std::min(size, n));
+        free(p);
+        return q;
+    }
+};
+
+} // (anon)
+
 struct Context::Impl
 {
     std::size_t refs;
+    HeapPool pool;
     duk_context* ctx;
 
+    // the key of the next handle in the stash
+    unsigned handles = 0;
+
+    // sorted names of the global
+    // properties kept by reset
+    std::vector<std::string> globals;
+
     ~Impl()
     {
         duk_destroy_heap(ctx);
@@ -55,7 +211,22 @@ struct Context::Impl
 
     Impl()
         : refs(1)
-        , ctx(duk_create_heap_default())
+        , ctx(duk_create_heap(
+            [](void* udata, duk_size_t size)
+            {
+                return static_cast<HeapPool*>(
+                    udata)->alloc(size);
+            },
+            [](void* udata, void* ptr, duk_size_t size)
+            {
+                return static_cast<HeapPool*>(
+                    udata)->realloc(ptr, size);
+            },
+            [](void* udata, void* ptr)
+            {
+                static_cast<HeapPool*>(udata)->free(ptr);
+            },
+            &pool, nullptr))
     {
     }
 };
@@ -81,6 +252,55 @@ Context(
     ++impl_->refs;
 }
 
+void
+Context::
+snapshot()
+{
+    duk_context* ctx = impl_->ctx;
+    auto& globals = impl_->globals;
+    globals.clear();
+    duk_push_global_object(ctx);
+    duk_enum(ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
+    while(duk_next(ctx, -1, 0))
+    {
+        duk_size_t size;
+        auto const data = duk_get_lstring(ctx, -1, &size);
+        globals.emplace_back(data, size);
+        duk_pop(ctx);
+    }
+    duk_pop_2(ctx);
+    std::sort(globals.begin(), globals.end());
+}
+
+void
+Context::
+reset()
+{
+    duk_context* ctx = impl_->ctx;
+    auto const& globals = impl_->globals;
+    std::vector<std::string> added;
+    duk_push_global_object(ctx);
+    duk_enum(ctx, -1, DUK_ENUM_OWN_PROPERTIES_ONLY);
+    while(duk_next(ctx, -1, 0))
+    {
+        duk_size_t size;
+        auto const data = duk_get_lstring(ctx, -1, &size);
+        std::string_view name(data, size);
+        if(! std::binary_search(
+                globals.begin(), globals.end(), name))
+            added.emplace_back(name);
+        duk_pop(ctx);
+    }
+    duk_pop(ctx); // enum
+    for(auto const& name : added)
+        duk_del_prop_lstring(ctx, -1, name.data(), name.size());
+    duk_pop(ctx); // global
+    // the second pass frees the
+    // objects which had finalizers
+    duk_gc(ctx, 0);
+    duk_gc(ctx, 0);
+}
+
 struct Access
 {
     duk_context* ctx_ = nullptr;
@@ -102,6 +322,18 @@ struct Access
     {
     }
 
+    Context::Impl*
+    operator->() const noexcept
+    {
+        return impl_;
+    }
+
+    static Context const& context(Value const& value) noexcept
+    {
+        MRDOX_ASSERT(value.scope_);
+        return value.scope_->ctx_;
+    }
+
     operator duk_context*() const noexcept
     {
         return ctx_;
@@ -240,6 +472,7 @@ Scope::
 script(
     std::string_view jsCode)
 {
+    MRDOX_PROFILE_ZONE("js::script");
     Access A(*this);
     auto failed = duk_peval_lstring(
         A, jsCode.data(), jsCode.size());
@@ -250,6 +483,40 @@ script(
     return Error::success();
 }
 
+Expected<std::string>
+Scope::
+compile(
+    std::string_view jsCode)
+{
+    Access A(*this);
+    auto failed = duk_pcompile_lstring(
+        A, 0, jsCode.data(), jsCode.size());
+    if(failed)
+        return dukM_popError(*this);
+    duk_dump_function(A);
+    duk_size_t size;
+    auto const data = static_cast<char const*>(
+        duk_get_buffer(A, -1, &size));
+    std::string bytecode(data, size);
+    duk_pop(A); // buffer
+    return bytecode;
+}
+
+Error
+Scope::
+scriptBytecode(
+    std::string_view bytecode)
+{
+    Access A(*this);
+    auto p = duk_push_fixed_buffer(A, bytecode.size());
+    std::memcpy(p, bytecode.data(), bytecode.size());
+    duk_load_function(A);
+    if(duk_pcall(A, 0) != DUK_EXEC_SUCCESS)
+        return dukM_popError(*this);
+    duk_pop(A); // result
+    return Error::success();
+}
+
 Value
 Scope::
 getGlobalObject()
@@ -298,6 +565,12 @@ struct ArrayProxy : ArrayBase
 
 };
 
+// Uses a plain array of the elements
+struct ArrayCached : ArrayBase
+{
+    static void push(Access& A, dom::Array const& arr);
+};
+
 struct ObjectBase
 {
     static dom::Object& get(Access& A, duk_idx_t idx);
@@ -315,7 +588,16 @@ struct ObjectProxy : ObjectBase
     static void push(Access& A, dom::Object const& obj);
 };
 
+// Uses getters which are replaced by their values
+struct ObjectCached : ObjectBase
+{
+    static void push(Access& A, dom::Object const& obj);
+};
+
 #if 1
+using ArrayRep  = ArrayCached;
+using ObjectRep = ObjectCached;
+#elif 0
 using ArrayRep  = ArrayProxy; //ArrayGetSet;
 using ObjectRep = ObjectGetSet;
 #else
@@ -324,6 +606,7 @@ using ObjectRep = ObjectProxy;
 #endif
 
 static void domValue_push(Access& A, dom::Value const& value);
+static dom::Value domValue_get(Access& A, duk_idx_t idx, int depth);
 
 //------------------------------------------------
 
@@ -336,7 +619,7 @@ get(Access& A, duk_idx_t idx)
     if(duk_get_type(A, -1) == DUK_TYPE_POINTER)
         data = duk_get_pointer(A, -1);
     else
-        data = duk_get_buffer_data(A, idx, nullptr);
+        data = duk_get_buffer_data(A, -1, nullptr);
     duk_pop(A);
     return *static_cast<dom::Array*>(data);
 }
@@ -487,6 +770,41 @@ push(
     duk_push_proxy(A, 0);
 }
 
+void
+ArrayCached::
+push(
+    Access& A, dom::Array const& arr)
+{
+    duk_push_array(A);
+    auto idx = duk_normalize_index(A, -1);
+    auto& arr_ = *static_cast<dom::Array*>(
+        duk_push_fixed_buffer(A, sizeof(dom::Array)));
+    dukM_put_prop_string(A, idx, DUK_HIDDEN_SYMBOL("dom"));
+
+    // Effects:     ~ArrayPtr
+    // Signature    ()
+    duk_push_c_function(A,
+    [](duk_context* ctx) -> duk_ret_t
+    {
+        Access A(ctx);
+        duk_push_this(ctx);
+        std::destroy_at(&get(A, -1));
+        return 0;
+    }, 0);
+    duk_set_finalizer(A, idx);
+    std::construct_at(&arr_, arr);
+
+    // The elements are pushed when the array
+    // is, which is when it is first used. Their
+    // own properties are still resolved lazily.
+    duk_uarridx_t i = 0;
+    arr.forEach([&](dom::Value const& v)
+    {
+        domValue_push(A, v);
+        duk_put_prop_index(A, idx, i++);
+    });
+}
+
 //------------------------------------------------
 
 dom::Object&
@@ -530,12 +848,92 @@ push(
     duk_set_finalizer(A, idx);
     std::construct_at(&obj_, obj);
 
-    for(auto const& kv : obj)
+    // Entries are only ever appended, so the
+    // position of each key is resolved here once
+    // and stored in the magic of its getter.
+    constexpr std::size_t maxMagic = 32767;
+    std::size_t const n = obj.size();
+    for(std::size_t i = 0; i < n; ++i)
     {
-        dukM_push_string(A, kv.key);
+        dukM_push_string(A, obj[i].key);
+        if(i <= maxMagic)
+        {
+            // Method:      Getter
+            // Effects:     return obj[i].value
+            // Signature:   ()
+            duk_push_c_function(A,
+            [](duk_context* ctx) -> duk_ret_t
+            {
+                Access A(ctx);
+                auto const i = static_cast<std::size_t>(
+                    duk_get_current_magic(A));
+                duk_push_this(A);
+                auto obj = get(A, -1);
+                duk_pop_n(A, duk_get_top(A));
+                domValue_push(A, obj.get(i).value);
+                return 1;
+            }, 0);
+            duk_set_magic(A, -1, static_cast<duk_int_t>(i));
+        }
+        else
+        {
+            // Method:      Getter
+            // Effects:     return obj[key]
+            // Signature:   (key)
+            duk_push_c_function(A,
+            [](duk_context* ctx) -> duk_ret_t
+            {
+                Access A(ctx);
+                auto key = dukM_get_string(A, 0);
+                duk_push_this(A);
+                auto obj = get(A, 1);
+                duk_pop_n(A, duk_get_top(A));
+                domValue_push(A, obj.find(key));
+                return 1;
+            }, 1);
+        }
+        duk_def_prop(A, idx,
+            DUK_DEFPROP_HAVE_GETTER |
+            DUK_DEFPROP_SET_ENUMERABLE);
+    }
+}
+
+void
+ObjectCached::
+push(
+    Access& A, dom::Object const& obj)
+{
+    duk_push_object(A);
+    auto idx = duk_normalize_index(A, -1);
+    auto& obj_ = *static_cast<dom::Object*>(
+        duk_push_fixed_buffer(A, sizeof(dom::Object)));
+    dukM_put_prop_string(A, idx, DUK_HIDDEN_SYMBOL("dom"));
+
+    // Effects:     ~ObjectPtr
+    // Signature    ()
+    duk_push_c_function(A,
+    [](duk_context* ctx) -> duk_ret_t
+    {
+        Access A(ctx);
+        duk_push_this(ctx);
+        std::destroy_at(&get(A, -1));
+        return 0;
+    }, 0);
+    duk_set_finalizer(A, idx);
+    std::construct_at(&obj_, obj);
+
+    // Each property starts as a getter which
+    // replaces itself with a data property on
+    // first use. Later reads do not call out of
+    // the interpreter, and an object or array
+    // value stays the same JavaScript object.
+    std::size_t const n = obj.size();
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        dukM_push_string(A, obj[i].key);
 
         // Method:      Getter
-        // Effects:     return obj[key]
+        // Effects:     this[key] = obj[key], return obj[key]
         // Signature:   (key)
         duk_push_c_function(A,
         [](duk_context* ctx) -> duk_ret_t
@@ -544,13 +942,23 @@ push(
             auto key = dukM_get_string(A, 0);
             duk_push_this(A);
             auto obj = get(A, 1);
-            duk_pop_n(A, duk_get_top(A));
+            duk_dup(A, 0);
             domValue_push(A, obj.find(key));
-            return 1;      
+            duk_dup_top(A);
+            duk_insert(A, 1);
+            // stack: key, value, this, key, value
+            duk_def_prop(A, 2,
+                DUK_DEFPROP_HAVE_VALUE |
+                DUK_DEFPROP_SET_WRITABLE |
+                DUK_DEFPROP_SET_ENUMERABLE |
+                DUK_DEFPROP_SET_CONFIGURABLE);
+            duk_pop(A); // this
+            return 1;
         }, 1);
         duk_def_prop(A, idx,
             DUK_DEFPROP_HAVE_GETTER |
-            DUK_DEFPROP_SET_ENUMERABLE);
+            DUK_DEFPROP_SET_ENUMERABLE |
+            DUK_DEFPROP_SET_CONFIGURABLE);
     }
 }
 
@@ -928,6 +1336,150 @@ domValue_push(
     }
 }
 
+/** Return a JavaScript value as a Dom value.
+*/
+static
+dom::Value
+domValue_get(
+    Access& A, duk_idx_t idx, int depth)
+{
+    // cycles in plain objects end here
+    constexpr int maxDepth = 32;
+
+    idx = duk_normalize_index(A, idx);
+    switch(duk_get_type(A, idx))
+    {
+    case DUK_TYPE_BOOLEAN:
+        return static_cast<bool>(duk_get_boolean(A, idx));
+    case DUK_TYPE_NUMBER:
+        return static_cast<std::int64_t>(duk_get_number(A, idx));
+    case DUK_TYPE_STRING:
+        return dom::String(dukM_get_string(A, idx));
+    case DUK_TYPE_OBJECT:
+        break;
+    default:
+        return nullptr;
+    }
+    if(duk_is_function(A, idx) || depth >= maxDepth)
+        return nullptr;
+
+    // an object or array which came from a Dom value
+    if(duk_get_prop_string(A, idx, DUK_HIDDEN_SYMBOL("dom")))
+    {
+        duk_pop(A);
+        if(duk_is_array(A, idx))
+            return ArrayBase::get(A, idx);
+        return ObjectBase::get(A, idx);
+    }
+    duk_pop(A);
+
+    if(duk_is_array(A, idx))
+    {
+        dom::Array arr;
+        auto const n = duk_get_length(A, idx);
+        for(duk_size_t i = 0; i < n; ++i)
+        {
+            duk_get_prop_index(A, idx, static_cast<duk_uarridx_t>(i));
+            arr.emplace_back(domValue_get(A, -1, depth + 1));
+            duk_pop(A);
+        }
+        return arr;
+    }
+
+    dom::Object::storage_type entries;
+    duk_enum(A, idx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+    while(duk_next(A, -1, 1))
+    {
+        entries.emplace_back(
+            dom::String(dukM_get_string(A, -2)),
+            domValue_get(A, -1, depth + 1));
+        duk_pop_2(A);
+    }
+    duk_pop(A); // enum
+    return dom::Object(std::move(entries));
+}
+
+/** Call the native function of the current function.
+
+    @return true on success, with the result
+    pushed, or false with an error pushed.
+*/
+static
+bool
+dukM_call_native(Access& A)
+{
+    duk_push_current_function(A);
+    duk_get_prop_string(A, -1, DUK_HIDDEN_SYMBOL("fn"));
+    auto const& fn = *static_cast<NativeFunction const*>(
+        duk_get_buffer_data(A, -1, nullptr));
+    duk_get_prop_string(A, -2, DUK_HIDDEN_SYMBOL("dropLast"));
+    bool const dropLast = duk_get_boolean(A, -1);
+    duk_pop_3(A);
+
+    try
+    {
+        auto n = duk_get_top(A);
+        if(dropLast && n > 0)
+            --n;
+        std::vector<dom::Value> args;
+        args.reserve(n);
+        for(duk_idx_t i = 0; i < n; ++i)
+            args.push_back(domValue_get(A, i, 0));
+        auto result = fn(args);
+        domValue_push(A, result);
+        return true;
+    }
+    catch(Exception const& ex)
+    {
+        duk_push_error_object(A, DUK_ERR_ERROR,
+            "%.*s",
+            static_cast<int>(ex.error().message().size()),
+            ex.error().message().data());
+        return false;
+    }
+}
+
+Value
+Scope::
+makeFunction(
+    NativeFunction fn,
+    bool dropLast)
+{
+    Access A(*this);
+    duk_push_c_function(A,
+    [](duk_context* ctx) -> duk_ret_t
+    {
+        // duk_throw does not unwind C++ frames,
+        // so nothing may be alive when it runs
+        Access A(ctx);
+        if(dukM_call_native(A))
+            return 1;
+        return duk_throw(ctx);
+    }, DUK_VARARGS);
+    auto idx = duk_normalize_index(A, -1);
+
+    auto& fn_ = *static_cast<NativeFunction*>(
+        duk_push_fixed_buffer(A, sizeof(NativeFunction)));
+    dukM_put_prop_string(A, idx, DUK_HIDDEN_SYMBOL("fn"));
+    std::construct_at(&fn_, std::move(fn));
+    duk_push_boolean(A, dropLast);
+    dukM_put_prop_string(A, idx, DUK_HIDDEN_SYMBOL("dropLast"));
+
+    // Effects:     ~NativeFunction
+    // Signature    ()
+    duk_push_c_function(A,
+    [](duk_context* ctx) -> duk_ret_t
+    {
+        Access A(ctx);
+        duk_get_prop_string(A, 0, DUK_HIDDEN_SYMBOL("fn"));
+        std::destroy_at(static_cast<NativeFunction*>(
+            duk_get_buffer_data(A, -1, nullptr)));
+        return 0;
+    }, 1);
+    duk_set_finalizer(A, idx);
+    return A.construct<Value>(-1, *this);
+}
+
 Value::
 Value(
     int idx,
@@ -1044,6 +1596,14 @@ getString() const
         dukM_get_string(A, idx_));
 }
 
+std::string_view
+Value::
+getStringView() const
+{
+    Access A(*scope_);
+    return dukM_get_string(A, idx_);
+}
+
 void
 Value::
 setlog()
@@ -1068,6 +1628,7 @@ callImpl(
     Param const* data,
     std::size_t size) const
 {
+    MRDOX_PROFILE_ZONE("js::call");
     Access A(*scope_);
     duk_dup(A, idx_);
     for(std::size_t i = 0; i < size; ++i)
@@ -1078,6 +1639,89 @@ callImpl(
     return A.construct<Value>(-1, *scope_);
 }
 
+//------------------------------------------------
+//
+// Handle
+//
+//------------------------------------------------
+
+void
+Handle::
+release() noexcept
+{
+    if(! ctx_)
+        return;
+    Access A(*ctx_);
+    duk_push_global_stash(A);
+    duk_del_prop_index(A, -1, id_);
+    duk_pop(A);
+    ctx_.reset();
+}
+
+Handle::
+~Handle()
+{
+    release();
+}
+
+Handle::
+Handle() noexcept = default;
+
+Handle::
+Handle(
+    Handle&& other) noexcept
+    : id_(other.id_)
+{
+    if(other.ctx_)
+        ctx_.emplace(*other.ctx_);
+    other.ctx_.reset();
+}
+
+Handle::
+Handle(
+    Value const& value)
+{
+    auto const& ctx = Access::context(value);
+    Access A(ctx);
+    id_ = A->handles++;
+    duk_push_global_stash(A);
+    duk_dup(A, Access::idx(value));
+    duk_put_prop_index(A, -2, id_);
+    duk_pop(A);
+    ctx_.emplace(ctx);
+}
+
+Handle&
+Handle::
+operator=(
+    Handle&& other) noexcept
+{
+    if(this == &other)
+        return *this;
+    release();
+    if(other.ctx_)
+        ctx_.emplace(*other.ctx_);
+    id_ = other.id_;
+    other.ctx_.reset();
+    return *this;
+}
+
+Value
+Handle::
+get(Scope& scope) const
+{
+    Access A(scope);
+    if(! ctx_)
+    {
+        duk_push_undefined(A);
+        return A.construct<Value>(-1, scope);
+    }
+    duk_push_global_stash(A);
+    duk_get_prop_index(A, -1, id_);
+    duk_remove(A, -2);
+    return A.construct<Value>(-1, scope);
+}
+
 Expected<Value>
 Value::
 callPropImpl(
@@ -1085,6 +1729,7 @@ callPropImpl(
     Param const* data,
     std::size_t size) const
 {
+    MRDOX_PROFILE_ZONE_TEXT("js::call", prop);
     Access A(*scope_);
     if(! duk_get_prop_lstring(A,
             idx_, prop.data(), prop.size()))
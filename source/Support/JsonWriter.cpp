@@ -0,0 +1,169 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "JsonWriter.hpp"
+#include <mrdox/Support/Error.hpp>
+
+namespace clang {
+namespace mrdox {
+
+void
+JsonWriter::
+newline()
+{
+    if(indent_ == 0)
+        return;
+    os_ << '\n';
+    os_.indent(static_cast<unsigned>(depth_ * indent_));
+}
+
+void
+writeJsonString(
+    llvm::raw_ostream& os,
+    std::string_view s)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+    os << '"';
+    // write runs of plain characters at once
+    std::size_t run = 0;
+    for(std::size_t i = 0; i < s.size(); ++i)
+    {
+        unsigned char const c = s[i];
+        if(c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        os.write(s.data() + run, i - run);
+        run = i + 1;
+        switch(c)
+        {
+        case '"':  os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\b': os << "\\b"; break;
+        case '\f': os << "\\f"; break;
+        case '\n': os << "\\n"; break;
+        case '\r': os << "\\r"; break;
+        case '\t': os << "\\t"; break;
+        default:
+            os << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+            break;
+        }
+    }
+    os.write(s.data() + run, s.size() - run);
+    os << '"';
+}
+
+void
+JsonWriter::
+writeString(std::string_view s)
+{
+    writeJsonString(os_, s);
+}
+
+void
+JsonWriter::
+writeArray(dom::Array const& arr)
+{
+    std::size_t const n = arr.size();
+    if(n == 0)
+    {
+        os_ << "[]";
+        return;
+    }
+    os_ << '[';
+    ++depth_;
+    bool first = true;
+    arr.forEach(
+        [&](dom::Value const& v)
+        {
+            if(! first)
+                os_ << ',';
+            first = false;
+            newline();
+            write(v);
+        });
+    --depth_;
+    newline();
+    os_ << ']';
+}
+
+void
+JsonWriter::
+writeObject(dom::Object const& obj)
+{
+    if(depth_ > 0)
+    {
+        if(auto v = collapse(obj, depth_))
+        {
+            write(*v);
+            return;
+        }
+    }
+    std::size_t const n = obj.size();
+    if(n == 0)
+    {
+        os_ << "{}";
+        return;
+    }
+    os_ << '{';
+    ++depth_;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        auto const& kv = obj.get(i);
+        if(i != 0)
+            os_ << ',';
+        newline();
+        writeString(kv.key);
+        os_ << (indent_ ? ": " : ":");
+        write(kv.value);
+    }
+    --depth_;
+    newline();
+    os_ << '}';
+}
+
+std::optional<dom::Value>
+JsonWriter::
+collapse(
+    dom::Object const&,
+    std::size_t)
+{
+    return std::nullopt;
+}
+
+void
+JsonWriter::
+write(dom::Value const& value)
+{
+    switch(value.kind())
+    {
+    case dom::Kind::Null:
+        os_ << "null";
+        break;
+    case dom::Kind::Boolean:
+        os_ << (value.getBool() ? "true" : "false");
+        break;
+    case dom::Kind::Integer:
+        os_ << value.getInteger();
+        break;
+    case dom::Kind::String:
+        writeString(value.getString());
+        break;
+    case dom::Kind::Array:
+        writeArray(value.getArray());
+        break;
+    case dom::Kind::Object:
+        writeObject(value.getObject());
+        break;
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,92 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SUPPORT_JSONWRITER_HPP
+#define MRDOX_LIB_SUPPORT_JSONWRITER_HPP
+
+#include <mrdox/Support/Dom.hpp>
+#include <llvm/Support/raw_ostream.h>
+#include <optional>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** Write a string as a quoted and escaped JSON string.
+*/
+void
+writeJsonString(
+    llvm::raw_ostream& os,
+    std::string_view s);
+
+/** Writes Dom values as JSON.
+
+    Output goes to the stream as the value is
+    visited, so memory use depends on the depth
+    of the value rather than on its size.
+*/
+class JsonWriter
+{
+    llvm::raw_ostream& os_;
+    unsigned indent_;
+    std::size_t depth_ = 0;
+
+    void newline();
+    void writeString(std::string_view s);
+    void writeArray(dom::Array const& arr);
+    void writeObject(dom::Object const& obj);
+
+protected:
+    /** Return a value to write in place of a nested object.
+
+        This is called for every object below the
+        top level. Returning a value writes it instead
+        of the object, which can be used to write
+        references and break cycles. The default
+        returns nothing, and the object is written.
+
+        @param obj The object about to be written.
+
+        @param depth The nesting level of the object.
+    */
+    virtual
+    std::optional<dom::Value>
+    collapse(
+        dom::Object const& obj,
+        std::size_t depth);
+
+public:
+    /** Constructor.
+
+        @param os The stream to write to.
+
+        @param indent The number of spaces for each
+        level of nesting, or zero for compact output.
+    */
+    explicit
+    JsonWriter(
+        llvm::raw_ostream& os,
+        unsigned indent = 2) noexcept
+        : os_(os)
+        , indent_(indent)
+    {
+    }
+
+    virtual ~JsonWriter() = default;
+
+    /** Write a value.
+    */
+    void write(dom::Value const& value);
+};
+
+} // mrdox
+} // clang
+
+#endif
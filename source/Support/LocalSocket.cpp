@@ -0,0 +1,367 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/LocalSocket.hpp"
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if ! defined(_WIN32)
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace clang {
+namespace mrdox {
+
+#if defined(_WIN32)
+
+LocalConnection::
+LocalConnection(
+    LocalConnection&& other) noexcept = default;
+
+LocalConnection::
+~LocalConnection() = default;
+
+Expected<LocalConnection>
+LocalConnection::
+connectTcp(
+    std::string_view,
+    std::uint16_t,
+    std::chrono::seconds)
+{
+    return formatError("local sockets are not supported on this platform");
+}
+
+std::optional<std::string>
+LocalConnection::
+readLine()
+{
+    return std::nullopt;
+}
+
+std::optional<std::string>
+LocalConnection::
+read(
+    std::size_t)
+{
+    return std::nullopt;
+}
+
+std::string
+LocalConnection::
+readAll()
+{
+    return {};
+}
+
+Error
+LocalConnection::
+writeLine(
+    std::string_view)
+{
+    return formatError("local sockets are not supported on this platform");
+}
+
+Error
+LocalConnection::
+write(
+    std::string_view)
+{
+    return formatError("local sockets are not supported on this platform");
+}
+
+LocalServer::
+LocalServer(
+    LocalServer&& other) noexcept = default;
+
+LocalServer::
+~LocalServer() = default;
+
+Expected<LocalServer>
+LocalServer::
+listen(
+    std::string_view)
+{
+    return formatError("local sockets are not supported on this platform");
+}
+
+Expected<LocalServer>
+LocalServer::
+listenTcp(
+    std::uint16_t)
+{
+    return formatError("local sockets are not supported on this platform");
+}
+
+Expected<LocalConnection>
+LocalServer::
+accept()
+{
+    return formatError("local sockets are not supported on this platform");
+}
+
+#else
+
+namespace {
+
+std::string
+lastError()
+{
+    return std::error_code(errno, std::system_category()).message();
+}
+
+} // (anon)
+
+LocalConnection::
+LocalConnection(
+    LocalConnection&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1))
+    , buffer_(std::move(other.buffer_))
+{
+}
+
+LocalConnection::
+~LocalConnection()
+{
+    if(fd_ != -1)
+        ::close(fd_);
+}
+
+Expected<LocalConnection>
+LocalConnection::
+connectTcp(
+    std::string_view host,
+    std::uint16_t port,
+    std::chrono::seconds timeout)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* list = nullptr;
+    auto const service = std::to_string(port);
+    if(int rc = ::getaddrinfo(std::string(host).c_str(),
+            service.c_str(), &hints, &list); rc != 0)
+        return formatError("getaddrinfo(\"{}\") returned \"{}\"",
+            host, ::gai_strerror(rc));
+
+    // each address is tried in turn
+    std::string error = "no address";
+    int fd = -1;
+    for(addrinfo* ai = list; ai; ai = ai->ai_next)
+    {
+        fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if(fd == -1)
+        {
+            error = lastError();
+            continue;
+        }
+        if(::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            break;
+        error = lastError();
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(list);
+    if(fd == -1)
+        return formatError("connect(\"{}:{}\") returned \"{}\"",
+            host, port, error);
+
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(timeout.count());
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return LocalConnection(fd);
+}
+
+std::optional<std::string>
+LocalConnection::
+readLine()
+{
+    for(;;)
+    {
+        if(auto pos = buffer_.find('\n');
+            pos != std::string::npos)
+        {
+            std::string line = buffer_.substr(0, pos);
+            buffer_.erase(0, pos + 1);
+            if(! line.empty() && line.back() == '\r')
+                line.pop_back();
+            return line;
+        }
+        char buf[4096];
+        auto const n = ::read(fd_, buf, sizeof(buf));
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+        {
+            // a last line without its end
+            if(buffer_.empty())
+                return std::nullopt;
+            return std::exchange(buffer_, {});
+        }
+        buffer_.append(buf, n);
+    }
+}
+
+std::optional<std::string>
+LocalConnection::
+read(
+    std::size_t n)
+{
+    while(buffer_.size() < n)
+    {
+        char buf[16384];
+        auto const got = ::read(fd_, buf, sizeof(buf));
+        if(got < 0 && errno == EINTR)
+            continue;
+        if(got <= 0)
+            return std::nullopt;
+        buffer_.append(buf, got);
+    }
+    std::string result = buffer_.substr(0, n);
+    buffer_.erase(0, n);
+    return result;
+}
+
+std::string
+LocalConnection::
+readAll()
+{
+    for(;;)
+    {
+        char buf[16384];
+        auto const got = ::read(fd_, buf, sizeof(buf));
+        if(got < 0 && errno == EINTR)
+            continue;
+        if(got <= 0)
+            return std::exchange(buffer_, {});
+        buffer_.append(buf, got);
+    }
+}
+
+Error
+LocalConnection::
+writeLine(
+    std::string_view line)
+{
+    std::string text(line);
+    text.push_back('\n');
+    return write(text);
+}
+
+Error
+LocalConnection::
+write(
+    std::string_view text)
+{
+    std::string_view rest = text;
+    while(! rest.empty())
+    {
+        auto const n = ::write(fd_, rest.data(), rest.size());
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n < 0)
+            return formatError("write returned \"{}\"", lastError());
+        rest.remove_prefix(n);
+    }
+    return Error::success();
+}
+
+LocalServer::
+LocalServer(
+    LocalServer&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1))
+    , path_(std::move(other.path_))
+{
+}
+
+LocalServer::
+~LocalServer()
+{
+    if(fd_ == -1)
+        return;
+    ::close(fd_);
+    if(! path_.empty())
+        ::unlink(path_.c_str());
+}
+
+Expected<LocalServer>
+LocalServer::
+listen(
+    std::string_view path)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path))
+        return formatError("the socket path \"{}\" is too long", path);
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd == -1)
+        return formatError("socket returned \"{}\"", lastError());
+    LocalServer server(fd, std::string(path));
+    ::unlink(server.path_.c_str());
+    if(::bind(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0)
+        return formatError("bind(\"{}\") returned \"{}\"", path, lastError());
+    if(::listen(fd, 8) != 0)
+        return formatError("listen(\"{}\") returned \"{}\"", path, lastError());
+    return server;
+}
+
+Expected<LocalServer>
+LocalServer::
+listenTcp(
+    std::uint16_t port)
+{
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(fd == -1)
+        return formatError("socket returned \"{}\"", lastError());
+    LocalServer server(fd, {});
+    // a restarted server can use the port at once
+    int const on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if(::bind(fd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0)
+        return formatError("bind(port {}) returned \"{}\"", port, lastError());
+    if(::listen(fd, 64) != 0)
+        return formatError("listen(port {}) returned \"{}\"", port, lastError());
+    return server;
+}
+
+Expected<LocalConnection>
+LocalServer::
+accept()
+{
+    for(;;)
+    {
+        int const fd = ::accept(fd_, nullptr, nullptr);
+        if(fd != -1)
+            return LocalConnection(fd);
+        if(errno != EINTR)
+            return formatError("accept returned \"{}\"", lastError());
+    }
+}
+
+#endif
+
+} // mrdox
+} // clang
@@ -0,0 +1,148 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_LOCALSOCKET_HPP
+#define MRDOX_TOOL_SUPPORT_LOCALSOCKET_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** A connection accepted by a local server, or made to a TCP peer.
+
+    The protocol is text, one request or
+    reply on each line, which may be
+    followed by a body of known size.
+*/
+class LocalConnection
+{
+    int fd_ = -1;
+    std::string buffer_;
+
+public:
+    explicit
+    LocalConnection(int fd) noexcept
+        : fd_(fd)
+    {
+    }
+
+    LocalConnection(LocalConnection&& other) noexcept;
+    LocalConnection& operator=(LocalConnection&&) = delete;
+    ~LocalConnection();
+
+    /** Return a connection to a port of a host.
+
+        Reads and writes which make no progress
+        for the timeout fail, so a peer which
+        stops responding is not waited on forever.
+    */
+    static
+    Expected<LocalConnection>
+    connectTcp(
+        std::string_view host,
+        std::uint16_t port,
+        std::chrono::seconds timeout);
+
+    /** Return the next line, without its end.
+
+        The result is empty when the
+        peer closed the connection.
+    */
+    std::optional<std::string>
+    readLine();
+
+    /** Return the next bytes.
+
+        The result is empty when the peer
+        closed the connection before all
+        of the bytes were read.
+    */
+    std::optional<std::string>
+    read(
+        std::size_t n);
+
+    /** Return the bytes until the peer closes the connection.
+    */
+    std::string
+    readAll();
+
+    /** Write a line, adding its end.
+    */
+    Error
+    writeLine(
+        std::string_view line);
+
+    /** Write text as it is.
+    */
+    Error
+    write(
+        std::string_view text);
+};
+
+/** A server which only accepts connections from this machine.
+
+    The server listens on a Unix domain socket,
+    which processes with access to its path can
+    connect to, or on a TCP port of the loopback
+    interface. The path of a Unix domain socket
+    is removed when the server is destroyed.
+*/
+class LocalServer
+{
+    int fd_ = -1;
+    std::string path_;
+
+    LocalServer(
+        int fd,
+        std::string path) noexcept
+        : fd_(fd)
+        , path_(std::move(path))
+    {
+    }
+
+public:
+    LocalServer(LocalServer&& other) noexcept;
+    LocalServer& operator=(LocalServer&&) = delete;
+    ~LocalServer();
+
+    /** Return a server listening on a path.
+
+        A socket left at the path by a server
+        which did not exit cleanly is replaced.
+    */
+    static
+    Expected<LocalServer>
+    listen(
+        std::string_view path);
+
+    /** Return a server listening on a port of the loopback interface.
+    */
+    static
+    Expected<LocalServer>
+    listenTcp(
+        std::uint16_t port);
+
+    /** Wait for the next connection.
+    */
+    Expected<LocalConnection>
+    accept();
+};
+
+} // mrdox
+} // clang
+
+#endif
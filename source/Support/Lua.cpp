@@ -13,9 +13,13 @@
 #include <mrdox/Support/Path.hpp>
 #include "../../lua/src/lua.hpp"
 #include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 #include <llvm/Support/raw_ostream.h>
 #include "Support/LuaHandlebars.hpp"
+#include "Support/Trace.hpp"
 
 namespace clang {
 namespace mrdox {
@@ -34,6 +38,7 @@ static char gImplKey{};
 
 static void domObject_push_metatable(Access& A);
 static void domValue_push(Access& A, dom::Value const&);
+static dom::Value domValue_get(Access& A, int index, int depth);
 
 //------------------------------------------------
 //
@@ -41,15 +46,204 @@ static void domValue_push(Access& A, dom::Value const&);
 //
 //------------------------------------------------
 
+namespace {
+
+// The allocator of one interpreter.
+//
+// Lua passes the size of every block it frees
+// or resizes, so blocks have no header. Small
+// blocks are kept on a free list for each size
+// class, and carved from chunks which are only
+// freed with the allocator. Large blocks use
+// the C heap.
+class Allocator
+{
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t maxSmall = 512;
+    static constexpr std::size_t chunkSize = 64 * 1024;
+
+    struct Block
+    {
+        Block* next;
+    };
+
+    Block* free_[maxSmall / granularity] = {};
+    Block* chunks_ = nullptr;
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t limit_;
+    MemoryStats stats_;
+
+    static
+    std::size_t
+    sizeClass(std::size_t n) noexcept
+    {
+        return (n - 1) / granularity;
+    }
+
+    void*
+    acquire(std::size_t n) noexcept
+    {
+        if(n > maxSmall)
+            return std::malloc(n);
+        auto const c = sizeClass(n);
+        if(Block* b = free_[c])
+        {
+            free_[c] = b->next;
+            return b;
+        }
+        n = (c + 1) * granularity;
+        if(static_cast<std::size_t>(end_ - pos_) < n)
+        {
+            auto chunk = static_cast<char*>(std::malloc(chunkSize));
+            if(! chunk)
+                return nullptr;
+            // the tail of the old chunk is not lost
+            if(auto rest = static_cast<std::size_t>(end_ - pos_);
+                rest >= granularity)
+            {
+                release(pos_, rest - rest % granularity);
+            }
+            auto head = reinterpret_cast<Block*>(chunk);
+            head->next = chunks_;
+            chunks_ = head;
+            pos_ = chunk + granularity;
+            end_ = chunk + chunkSize;
+        }
+        void* p = pos_;
+        pos_ += n;
+        return p;
+    }
+
+    void
+    release(void* p, std::size_t n) noexcept
+    {
+        if(n > maxSmall)
+            return std::free(p);
+        auto const c = sizeClass(n);
+        auto b = static_cast<Block*>(p);
+        b->next = free_[c];
+        free_[c] = b;
+    }
+
+    void*
+    resize(
+        void* p,
+        std::size_t osize,
+        std::size_t nsize) noexcept
+    {
+        if(nsize == 0)
+        {
+            if(p)
+            {
+                release(p, osize);
+                stats_.bytes -= osize;
+            }
+            return nullptr;
+        }
+        // Lua expects shrinking to succeed,
+        // so only growth is checked
+        if( limit_ != 0 && nsize > osize &&
+            stats_.bytes - osize + nsize > limit_)
+        {
+            ++stats_.refused;
+            return nullptr;
+        }
+        void* q;
+        if(! p)
+        {
+            q = acquire(nsize);
+            if(! q)
+                return nullptr;
+            ++stats_.allocations;
+        }
+        else if(osize > maxSmall && nsize > maxSmall)
+        {
+            q = std::realloc(p, nsize);
+            if(! q)
+                return nullptr;
+        }
+        else if(osize <= maxSmall && nsize <= maxSmall &&
+            sizeClass(osize) == sizeClass(nsize))
+        {
+            q = p;
+        }
+        else
+        {
+            q = acquire(nsize);
+            if(! q)
+                return nullptr;
+            std::memcpy(q, p, std::min(osize, nsize));
+            release(p, osize);
+        }
+        stats_.bytes = stats_.bytes - osize + nsize;
+        stats_.peak = std::max(stats_.peak, stats_.bytes);
+        return q;
+    }
+
+public:
+    explicit
+    Allocator(
+        std::size_t limit) noexcept
+        : limit_(limit)
+    {
+    }
+
+    ~Allocator()
+    {
+        while(chunks_)
+        {
+            auto next = chunks_->next;
+            std::free(chunks_);
+            chunks_ = next;
+        }
+    }
+
+    MemoryStats const&
+    stats() const noexcept
+    {
+        return stats_;
+    }
+
+    // The lua_Alloc, with the allocator as userdata
+    static
+    void*
+    alloc(
+        void* ud,
+        void* p,
+        std::size_t osize,
+        std::size_t nsize) noexcept
+    {
+        // osize is the kind of object when p is null
+        return static_cast<Allocator*>(ud)->resize(
+            p, p ? osize : 0, nsize);
+    }
+};
+
+} // (anon)
+
 struct Context::Impl
 {
+    // destroyed after the state is closed
+    Allocator alloc;
     lua_State* L = nullptr;
 
     int objMetaRef = LUA_NOREF;
     int arrMetaRef = LUA_NOREF;
 
+    // weak table of the userdata which hold
+    // Dom containers, keyed on the impl
+    int domCacheRef = LUA_NOREF;
+
+    // copy of the global table for Context::reset
+    int globalsRef = LUA_NOREF;
+
+    // checked by the hook set by Context::setDeadline
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();
+
     ~Impl();
-    Impl();
+    explicit Impl(std::size_t memoryLimit);
 };
 
 Context::
@@ -61,9 +255,22 @@ Impl::
 
 Context::
 Impl::
-Impl()
-    : L(luaL_newstate())
+Impl(
+    std::size_t memoryLimit)
+    : alloc(memoryLimit)
+    , L(lua_newstate(&Allocator::alloc, &alloc))
 {
+    if(! L)
+        formatError("could not create a Lua state").Throw();
+    lua_atpanic(L,
+    [](lua_State* L)
+    {
+        // Lua aborts the process when this returns
+        auto msg = lua_tostring(L, -1);
+        reportError("Lua panic: {}",
+            msg ? msg : "error object is not a string");
+        return 0;
+    });
     luaL_openlibs(L);
 
     // Store `this` at G[&gImplKey]
@@ -80,18 +287,125 @@ Context::~Context() = default;
 
 Context::
 Context()
-    : impl_(std::make_shared<Impl>())
+    : Context(0)
+{
+}
+
+Context::
+Context(
+    std::size_t memoryLimit)
+    : impl_(std::make_shared<Impl>(memoryLimit))
+{
+}
+
+MemoryStats
+Context::
+memoryStats() const noexcept
 {
+    return impl_->alloc.stats();
 }
 
 Context::
 Context(
     Context const& other) noexcept = default;
 
+void
+Context::
+snapshot()
+{
+    lua_State* L = impl_->L;
+    lua_createtable(L, 0, 64);
+    lua_pushglobaltable(L);
+    lua_pushnil(L);
+    while(lua_next(L, -2))
+    {
+        // copy[key] = value
+        lua_pushvalue(L, -2);
+        lua_insert(L, -2);
+        lua_rawset(L, -5);
+    }
+    lua_pop(L, 1);
+    luaL_unref(L, LUA_REGISTRYINDEX, impl_->globalsRef);
+    impl_->globalsRef = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+void
+Context::
+reset()
+{
+    lua_State* L = impl_->L;
+    if(impl_->globalsRef == LUA_NOREF)
+        return;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, impl_->globalsRef);
+    lua_pushglobaltable(L);
+
+    // remove the globals defined since,
+    // fields may be cleared during lua_next
+    lua_pushnil(L);
+    while(lua_next(L, -2))
+    {
+        lua_pop(L, 1);
+        lua_pushvalue(L, -1);
+        if(lua_rawget(L, -4) == LUA_TNIL)
+        {
+            lua_pop(L, 1);
+            lua_pushvalue(L, -1);
+            lua_pushnil(L);
+            lua_rawset(L, -4);
+        }
+        else
+        {
+            lua_pop(L, 1);
+        }
+    }
+
+    // restore the others
+    lua_pushnil(L);
+    while(lua_next(L, -3))
+    {
+        lua_pushvalue(L, -2);
+        lua_insert(L, -2);
+        lua_rawset(L, -4);
+    }
+    lua_pop(L, 2);
+    lua_gc(L, LUA_GCSTEP, 0);
+}
+
+void
+Context::
+setDeadline(
+    std::chrono::steady_clock::time_point t)
+{
+    lua_State* L = impl_->L;
+    impl_->deadline = t;
+    if(t == std::chrono::steady_clock::time_point::max())
+    {
+        lua_sethook(L, nullptr, 0, 0);
+        return;
+    }
+    // the clock is read every few
+    // thousand instructions
+    constexpr int interval = 4096;
+    lua_sethook(L,
+    [](lua_State* L, lua_Debug*)
+    {
+        lua_pushglobaltable(L);
+        lua_pushlightuserdata(L, &gImplKey);
+        lua_rawget(L, -2);
+        auto impl = static_cast<Context::Impl*>(
+            lua_touserdata(L, -1));
+        lua_pop(L, 2);
+        if(impl && std::chrono::steady_clock::now() >= impl->deadline)
+            luaL_error(L, "the script ran out of time");
+    }, LUA_MASKCOUNT, interval);
+}
+
 void
 Scope::
 reset()
 {
+    lua_State* L = ctx_.impl_->L;
+    lua_settop(L, top_);
 }
 
 Scope::
@@ -260,6 +574,74 @@ luaM_pushstring(
     lua_pushlstring(L, s.data(), s.size());
 }
 
+// Return true if the value at the index
+// has the metatable with the given reference
+static
+bool
+luaM_hasmetatable(
+    lua_State* L, int index, int ref)
+{
+    if( ref == LUA_NOREF ||
+        ! lua_getmetatable(L, index))
+        return false;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+    bool const result = lua_rawequal(L, -1, -2);
+    lua_pop(L, 2);
+    return result;
+}
+
+// Push the userdata of a Dom container if one
+// is alive, and return true. Otherwise push the
+// cache table and return false.
+//
+// An entry is cleared before its userdata is
+// finalized, and the userdata keeps the impl
+// alive, so the address is never reused while
+// it is a key.
+static
+bool
+luaM_pushcached(
+    Access& A,
+    void const* impl)
+{
+    if(A->domCacheRef != LUA_NOREF)
+    {
+        lua_rawgeti(A, LUA_REGISTRYINDEX, A->domCacheRef);
+    }
+    else
+    {
+        lua_createtable(A, 0, 0);
+        lua_createtable(A, 0, 1);
+        luaM_pushstring(A, "__mode");
+        luaM_pushstring(A, "v");
+        lua_settable(A, -3);
+        lua_setmetatable(A, -2);
+        lua_pushvalue(A, -1);
+        A->domCacheRef = luaL_ref(A, LUA_REGISTRYINDEX);
+    }
+    if(lua_rawgetp(A, -1, impl) != LUA_TNIL)
+    {
+        lua_remove(A, -2);
+        return true;
+    }
+    lua_pop(A, 1);
+    return false;
+}
+
+// Store the userdata on top of the stack in
+// the cache table just below it, and pop the
+// cache table.
+static
+void
+luaM_setcached(
+    Access& A,
+    void const* impl)
+{
+    lua_pushvalue(A, -1);
+    lua_rawsetp(A, -3, impl);
+    lua_remove(A, -2);
+}
+
 //------------------------------------------------
 //
 // dom::Array
@@ -290,7 +672,11 @@ domArray_push_metatable(
         return;
     }
 
-    lua_createtable(A, 0, 3);
+    lua_createtable(A, 0, 6);
+
+    luaM_pushstring(A, "__name");
+    luaM_pushstring(A, "dom.Array");
+    lua_settable(A, -3);
 
     // Effect:      return t[i]
     // Signature:   (t, i)
@@ -327,6 +713,34 @@ domArray_push_metatable(
     lua_settable(A, -3);
 #endif
 
+    // Effect:      return #t
+    // Signature:   (t)
+    luaM_pushstring(A, "__len");
+    lua_pushcfunction(A,
+    [](lua_State* L)
+    {
+        Access A(L);
+        auto const n = domArray_get(A, 1).size();
+        lua_pushinteger(A, static_cast<lua_Integer>(n));
+        return 1;
+    });
+    lua_settable(A, -3);
+
+    // Effect:      return a == b
+    // Signature:   (a, b)
+    luaM_pushstring(A, "__eq");
+    lua_pushcfunction(A,
+    [](lua_State* L)
+    {
+        Access A(L);
+        lua_pushboolean(A,
+            luaM_hasmetatable(A, 1, A->arrMetaRef) &&
+            luaM_hasmetatable(A, 2, A->arrMetaRef) &&
+            domArray_get(A, 1).impl() == domArray_get(A, 2).impl());
+        return 1;
+    });
+    lua_settable(A, -3);
+
     // Effect:      return next(t [, index])
     // Signature:   (t [, index])
     static constexpr auto const next =
@@ -390,6 +804,27 @@ domArray_push_metatable(
     A->arrMetaRef = luaL_ref(A, LUA_REGISTRYINDEX);
 }
 
+// Push a dom::Array onto the stack
+static
+void
+domArray_push(
+    Access& A,
+    dom::Array const& arr)
+{
+    // the same array is often pushed many
+    // times, so one userdata is shared
+    void const* key = arr.impl().get();
+    if(luaM_pushcached(A, key))
+        return;
+    auto& arr_ = *static_cast<
+        dom::Array*>(lua_newuserdatauv(
+            A, sizeof(dom::Array), 0));
+    domArray_push_metatable(A);
+    lua_setmetatable(A, -2);
+    std::construct_at(&arr_, arr);
+    luaM_setcached(A, key);
+}
+
 //------------------------------------------------
 //
 // dom::Object
@@ -420,7 +855,11 @@ domObject_push_metatable(
         return;
     }
 
-    lua_createtable(A, 0, 4);
+    lua_createtable(A, 0, 7);
+
+    luaM_pushstring(A, "__name");
+    luaM_pushstring(A, "dom.Object");
+    lua_settable(A, -3);
 
     // Effect:      return t[k]
     // Signature:   (t, k)
@@ -432,7 +871,6 @@ domObject_push_metatable(
         domValue_push(A,
             domObject_get(A, 1).find(
                 luaM_getstring(A, 2)));
-        lua_replace(A, 1);
         return 1;
     });
     lua_settable(A, -3);
@@ -528,6 +966,34 @@ domObject_push_metatable(
     });
     lua_settable(A, -3);
 
+    // Effect:      return a == b
+    // Signature:   (a, b)
+    luaM_pushstring(A, "__eq");
+    lua_pushcfunction(A,
+    [](lua_State* L)
+    {
+        Access A(L);
+        lua_pushboolean(A,
+            luaM_hasmetatable(A, 1, A->objMetaRef) &&
+            luaM_hasmetatable(A, 2, A->objMetaRef) &&
+            domObject_get(A, 1).impl() == domObject_get(A, 2).impl());
+        return 1;
+    });
+    lua_settable(A, -3);
+
+    // Effect:      return #t
+    // Signature:   (t)
+    luaM_pushstring(A, "__len");
+    lua_pushcfunction(A,
+    [](lua_State* L)
+    {
+        Access A(L);
+        auto const n = domObject_get(A, 1).size();
+        lua_pushinteger(A, static_cast<lua_Integer>(n));
+        return 1;
+    });
+    lua_settable(A, -3);
+
     // Effect:      ~SharedPtr<dom::Object>
     // Signature:   (table)
     luaM_pushstring(A, "__gc");
@@ -551,12 +1017,18 @@ domObject_push(
     Access& A,
     dom::Object const& obj)
 {
+    // a symbol is pushed many times while
+    // a page renders, so one userdata is shared
+    void const* key = obj.impl().get();
+    if(luaM_pushcached(A, key))
+        return;
     auto& obj_ = *static_cast<
         dom::Object*>(lua_newuserdatauv(
             A, sizeof(dom::Object), 0));
     domObject_push_metatable(A);
     lua_setmetatable(A, -2);
     std::construct_at(&obj_, obj);
+    luaM_setcached(A, key);
 }
 
 //------------------------------------------------
@@ -577,12 +1049,12 @@ domValue_push(
     case dom::Kind::Boolean:
         return lua_pushboolean(A, value.getBool());
     case dom::Kind::Integer:
-        return lua_pushnumber(A, value.getInteger());
+        return lua_pushinteger(A, static_cast<
+            lua_Integer>(value.getInteger()));
     case dom::Kind::String:
         return luaM_pushstring(A, value.getString());
     case dom::Kind::Array:
-        MRDOX_UNREACHABLE();
-        //return domArray_push(A, value.getArray());
+        return domArray_push(A, value.getArray());
     case dom::Kind::Object:
         return domObject_push(A, value.getObject());
     default:
@@ -590,6 +1062,69 @@ domValue_push(
     }
 }
 
+// Return the value at the index as a dom::Value
+static
+dom::Value
+domValue_get(
+    Access& A, int index, int depth)
+{
+    // cycles in tables end here
+    constexpr int maxDepth = 32;
+
+    index = lua_absindex(A, index);
+    switch(lua_type(A, index))
+    {
+    case LUA_TBOOLEAN:
+        return lua_toboolean(A, index) != 0;
+    case LUA_TNUMBER:
+        if(lua_isinteger(A, index))
+            return static_cast<std::int64_t>(
+                lua_tointeger(A, index));
+        return static_cast<std::int64_t>(
+            lua_tonumber(A, index));
+    case LUA_TSTRING:
+        return dom::String(luaM_getstring(A, index));
+    case LUA_TUSERDATA:
+        if(luaM_hasmetatable(A, index, A->objMetaRef))
+            return domObject_get(A, index);
+        if(luaM_hasmetatable(A, index, A->arrMetaRef))
+            return domArray_get(A, index);
+        return nullptr;
+    case LUA_TTABLE:
+        break;
+    default:
+        return nullptr;
+    }
+    if(depth >= maxDepth)
+        return nullptr;
+
+    // a table with the keys 1 to n is an array
+    auto const n = lua_rawlen(A, index);
+    if(n > 0)
+    {
+        dom::Array arr;
+        for(lua_Unsigned i = 1; i <= n; ++i)
+        {
+            lua_rawgeti(A, index, static_cast<lua_Integer>(i));
+            arr.emplace_back(domValue_get(A, -1, depth + 1));
+            lua_pop(A, 1);
+        }
+        return arr;
+    }
+
+    dom::Object::storage_type entries;
+    lua_pushnil(A);
+    while(lua_next(A, index))
+    {
+        if(lua_type(A, -2) == LUA_TSTRING)
+            entries.emplace_back(
+                dom::String(luaM_getstring(A, -2)),
+                domValue_get(A, -1, depth + 1));
+        lua_pop(A, 1);
+    }
+    return dom::Object(std::move(entries));
+}
+
 //------------------------------------------------
 
 static
@@ -642,6 +1177,35 @@ loadChunk(
         loc);
 }
 
+Expected<std::string>
+Scope::
+compile(
+    std::string_view luaChunk,
+    zstring chunkName,
+    source_location loc)
+{
+    Access A(*this);
+    auto rc = lua_load(A,
+        &Reader, &luaChunk, chunkName.c_str(), "t");
+    if(rc != LUA_OK)
+        return luaM_popError(A, loc);
+    std::string bytecode;
+    // debug information is kept, so that
+    // errors still show the line numbers
+    rc = ::lua_dump(A,
+        [](lua_State*, void const* p, std::size_t n, void* ud)
+        {
+            static_cast<std::string*>(ud)->append(
+                static_cast<char const*>(p), n);
+            return 0;
+        }, &bytecode, 0);
+    lua_pop(A, 1);
+    if(rc != 0)
+        return formatError("{}: could not dump the chunk",
+            chunkName.c_str());
+    return bytecode;
+}
+
 Expected<Function>
 Scope::
 loadChunkFromFile(
@@ -663,6 +1227,77 @@ getGlobalTable()
     return A.construct<Table>(-1, *this);
 }
 
+// Call the native function in the first upvalue.
+// Returns true on success with the result pushed,
+// or false with an error message pushed.
+static
+bool
+luaM_callNative(Access& A)
+{
+    auto const& fn = *static_cast<NativeFunction const*>(
+        lua_touserdata(A, lua_upvalueindex(1)));
+    try
+    {
+        auto const n = lua_gettop(A);
+        std::vector<dom::Value> args;
+        args.reserve(n);
+        for(int i = 1; i <= n; ++i)
+            args.push_back(domValue_get(A, i, 0));
+        auto result = fn(args);
+        lua_settop(A, 0);
+        domValue_push(A, result);
+        return true;
+    }
+    catch(Exception const& ex)
+    {
+        lua_settop(A, 0);
+        luaM_pushstring(A, ex.error().message());
+        return false;
+    }
+    catch(std::exception const& ex)
+    {
+        lua_settop(A, 0);
+        luaM_pushstring(A, ex.what());
+        return false;
+    }
+}
+
+Value
+Scope::
+makeFunction(NativeFunction fn)
+{
+    Access A(*this);
+    auto& fn_ = *static_cast<NativeFunction*>(
+        lua_newuserdatauv(A, sizeof(NativeFunction), 0));
+
+    // Effect:      ~NativeFunction
+    // Signature:   (userdata)
+    lua_createtable(A, 0, 1);
+    luaM_pushstring(A, "__gc");
+    lua_pushcfunction(A,
+    [](lua_State* L)
+    {
+        std::destroy_at(static_cast<NativeFunction*>(
+            lua_touserdata(L, 1)));
+        return 0;
+    });
+    lua_settable(A, -3);
+    lua_setmetatable(A, -2);
+    std::construct_at(&fn_, std::move(fn));
+
+    lua_pushcclosure(A,
+    [](lua_State* L)
+    {
+        // lua_error does not unwind C++ frames,
+        // so nothing may be alive when it runs
+        Access A(L);
+        if(luaM_callNative(A))
+            return 1;
+        return lua_error(L);
+    }, 1);
+    return A.construct<Value>(-1, *this);
+}
+
 Expected<Value>
 Scope::
 getGlobal(
@@ -707,7 +1342,8 @@ push(Scope& scope) const
     case Kind::value:
         return lua_pushvalue(A, index_);
     case Kind::domArray:
-        MRDOX_UNREACHABLE();
+        domArray_push(A, arr_);
+        return;
     case Kind::domObject:
         domObject_push(A, obj_);
         return;
@@ -870,7 +1506,7 @@ Value::
     if( ! scope_)
         return;
     Access A(*scope_);
-    if(index_ == lua_gettop(A) - 1)
+    if(index_ == lua_gettop(A))
         lua_pop(A, 1);
     Access::release(*scope_);
 }
@@ -975,7 +1611,9 @@ callImpl(
     Param const* args,
     std::size_t narg)
 {
+    MRDOX_PROFILE_ZONE("lua::call");
     Access A(*scope_);
+    luaL_checkstack(A, static_cast<int>(narg) + 2, nullptr);
     lua_pushvalue(A, index_);
     for(std::size_t i = 0; i < narg; ++i)
         Access::push(args[i], *scope_);
@@ -1137,6 +1775,7 @@ callImpl(
     Param const* data,
     std::size_t size) const
 {
+    MRDOX_PROFILE_ZONE_TEXT("lua::call", key);
     Access A(*scope_);
     luaM_pushstring(A, key);
     lua_gettable(A, index_);
@@ -14,58 +14,381 @@
 namespace clang {
 namespace mrdox {
 
-// VFALCO:
-// C Functions use "Error::Throw" for C++ errors
-// Or.. should we push an error object onto the stack?
+namespace {
+
+// The runtime of translated templates.
+//
+// Values follow the rules of Handlebars.js:
+// null is nil, and Dom arrays and objects are
+// userdata. The functions which a chunk uses
+// are documented in Handlebars::toLua.
+constexpr std::string_view runtime = R"(
+local makeContext = ...
+
+local H, P, T = {}, {}, {}
+local R = { H = H }
+
+-- the kind of a value, with Dom values by name
+local function K(v)
+    local t = type(v)
+    if t == "userdata" then
+        local m = getmetatable(v)
+        return m and m.__name or t
+    end
+    return t
+end
+
+-- return v[k] as Handlebars looks it up
+local function L(v, k)
+    local t = K(v)
+    if t == "dom.Object" then
+        return v[k]
+    elseif t == "dom.Array" then
+        if k == "length" then
+            return #v
+        end
+        local i = k:find("^%d+$") and math.tointeger(tonumber(k))
+        if i then
+            return v[i]
+        end
+    elseif t == "string" and k == "length" then
+        return #v
+    end
+    return nil
+end
+
+-- convert a value to a string as JavaScript does
+local function S(v)
+    local t = type(v)
+    if t == "string" then
+        return v
+    elseif t == "nil" then
+        return ""
+    elseif t == "boolean" or t == "number" then
+        return tostring(v)
+    elseif K(v) == "dom.Array" then
+        local r = {}
+        for i = 0, #v - 1 do
+            r[i + 1] = S(v[i])
+        end
+        return table.concat(r, ",")
+    end
+    return "[object Object]"
+end
+
+local escapes = {
+    ["&"] = "&amp;", ["<"] = "&lt;", [">"] = "&gt;",
+    ['"'] = "&quot;", ["'"] = "&#x27;", ["`"] = "&#x60;",
+    ["="] = "&#x3D;" }
+
+local function escape(v)
+    return (S(v):gsub("[&<>\"'`=]", escapes))
+end
+
+local function F(v)
+    return v == nil or v == false or v == 0 or v == ""
+end
+
+local function Em(v)
+    if K(v) == "dom.Array" then
+        return #v == 0
+    end
+    if math.type(v) == "integer" then
+        return false
+    end
+    return F(v)
+end
+
+local function M(name)
+    error('Missing helper: "' .. name .. '"', 0)
+end
+
+-- the context n depths up
+local function U(d, n)
+    for _ = 1, n do
+        if d == nil then
+            return nil
+        end
+        d = d.p
+    end
+    return d and d.c
+end
+
+-- a data variable of the frame n levels up
+local function Dt(a, n, name)
+    for _ = 1, n do
+        if a == nil then
+            return nil
+        end
+        a = a.p
+    end
+    return a and a[name]
+end
+
+local function each(v, fn, inv, c, d, a, o)
+    local t, n = K(v), 0
+    local frame = { p = a }
+    if t == "dom.Array" then
+        n = #v
+        for i = 0, n - 1 do
+            frame.key, frame.index = i, i
+            frame.first, frame.last = i == 0, i + 1 == n
+            if fn then
+                fn(v[i], d, frame, o)
+            end
+        end
+    elseif t == "dom.Object" then
+        n = #v
+        local i = 0
+        for k, e in pairs(v) do
+            frame.key, frame.index = k, i
+            frame.first, frame.last = i == 0, i + 1 == n
+            if fn then
+                fn(e, d, frame, o)
+            end
+            i = i + 1
+        end
+    end
+    if n == 0 and inv then
+        inv(c, d, a, o)
+    end
+end
+
+local function invoke(p, c, a, o, indent)
+    if indent == "" or R.preventIndent then
+        return p(c, nil, a, o)
+    end
+    local t = {}
+    p(c, nil, a, t)
+    local s = table.concat(t)
+    local i = 1
+    while i <= #s do
+        local j = s:find("\n", i, true) or #s
+        o[#o + 1] = indent
+        o[#o + 1] = s:sub(i, j)
+        i = j + 1
+    end
+end
+
+local function partial(name, c, a, o, indent)
+    local p = P[name]
+    if p == nil then
+        error("The partial " .. name .. " could not be found", 0)
+    end
+    if not R.profiling then
+        return invoke(p, c, a, o, indent)
+    end
+    R.enter(name)
+    local ok, err = pcall(invoke, p, c, a, o, indent)
+    R.leave()
+    if not ok then
+        error(err, 0)
+    end
+end
+
+R.K, R.L, R.S, R.F, R.Em, R.M = K, L, S, F, Em, M
+R.U, R.Dt, R.each, R.partial, R.ctx = U, Dt, each, partial, makeContext
+R.Pn = function(v)
+    if v == nil then
+        return "undefined"
+    end
+    return S(v)
+end
+
+H.lookup = function(...)
+    local n = select("#", ...)
+    if n == 0 then
+        return nil
+    end
+    local v, k = ...
+    if F(v) or n < 2 then
+        return v
+    end
+    return L(v, S(k))
+end
+
+H.log = function()
+    return nil
+end
+
+local function compile(name, code)
+    local chunk, err = load(code, "=" .. name, "t")
+    if chunk == nil then
+        error(err, 0)
+    end
+    return chunk(R)
+end
+
+Handlebars = {
+    Utils = {
+        escapeExpression = escape,
+        isEmpty = Em,
+        toString = S
+    },
+
+    registerHelper = function(name, fn)
+        H[name] = fn
+    end,
+
+    -- a partial which failed to compile
+    -- reports the error when it is used
+    registerPartial = function(name, code, err)
+        local ok, fn = false, err
+        if code ~= nil then
+            ok, fn = pcall(compile, name, code)
+        end
+        if not ok then
+            err = 'partial "' .. name .. '": ' .. fn
+            fn = function() error(err, 0) end
+        end
+        P[name] = fn
+    end,
+
+    compile = function(name, code)
+        T[name] = compile(name, code)
+    end,
+
+    profile = function(enter, leave)
+        R.enter, R.leave = enter, leave
+    end,
+
+    render = function(name, context, noEscape, preventIndent, profiling)
+        local fn = T[name]
+        if fn == nil then
+            error("template " .. name .. " is not compiled", 0)
+        end
+        R.root = context
+        R.e = noEscape and S or escape
+        R.preventIndent = preventIndent
+        R.profiling = profiling
+        local o = {}
+        fn(context, nil, nil, o)
+        return table.concat(o)
+    end
+}
+)";
 
-static
 lua::Value
-escapeExpression(
-    std::vector<lua::Value> args)
+getFunction(
+    lua::Scope& scope,
+    std::string_view name)
 {
-    if(args.empty())
-        return lua::Value(); // nil
-    // remove excess arguments
-#if 0
-    if(args.size() > 1)
-        args.erase(args.begin() + 1, args.end());
-#endif
-    if(! args.front().isString())
-        return std::move(args.front());
-    //
-    // TODO: escape the thing
-    //
-    return std::move(args.front());
+    return lua::Table(
+        scope.getGlobal("Handlebars").value()).get(name);
 }
 
+} // (anon)
+
 Error
 tryLoadHandlebars(
     lua::Context const& ctx)
 {
     lua::Scope scope(ctx);
-    auto G = scope.getGlobalTable();
-    lua::Table hbs(scope);
+    auto chunk = scope.loadChunk(runtime, "=handlebars");
+    if(! chunk)
+        return chunk.error();
 
-    lua::Table utils(scope);
-    //utils.set("escapeExpression", &escapeExpression);
-    utils.set("isEmpty", "2");
-    utils.set("extend", "3");
-    utils.set("toString", "4");
-    utils.set("isArray", "5");
-    utils.set("isFunction", "6");
-    utils.set("log", "7");
+    // the context of a partial with hash arguments,
+    // called with the context then each key and value
+    auto makeContext = scope.makeFunction(
+        [](std::span<dom::Value const> args) -> dom::Value
+        {
+            dom::Object::storage_type hash;
+            for(std::size_t i = 1; i + 1 < args.size(); i += 2)
+                hash.emplace_back(args[i].getString(), args[i + 1]);
+            return Handlebars::partialContext(
+                args.empty() ? dom::Value() : args[0],
+                std::move(hash));
+        });
+    return chunk->call(makeContext).error();
+}
 
-    hbs.set("Utils", utils);
+//------------------------------------------------
 
-    hbs.set("SafeString", "8");
-    hbs.set("createFrame", "9");
-    //hbs.set("escapeExpression", utils.get("escapeExpression"));
+LuaHandlebars::
+LuaHandlebars()
+{
+    tryLoadHandlebars(ctx_).maybeThrow();
 
-    G.set("Handlebars", hbs);
-    return Error::success();
+    lua::Scope scope(ctx_);
+    auto enter = scope.makeFunction(
+        [this](std::span<dom::Value const> args) -> dom::Value
+        {
+            profile_->enter(args.empty() || ! args[0].isString() ?
+                std::string_view("undefined") :
+                std::string_view(args[0].getString().get()));
+            return nullptr;
+        });
+    auto leave = scope.makeFunction(
+        [this](std::span<dom::Value const>) -> dom::Value
+        {
+            profile_->leave();
+            return nullptr;
+        });
+    getFunction(scope, "profile").call(enter, leave).value();
+}
+
+void
+LuaHandlebars::
+registerPartial(
+    std::string_view name,
+    std::string_view text)
+{
+    lua::Scope scope(ctx_);
+    auto fn = getFunction(scope, "registerPartial");
+    auto code = Handlebars::toLua(text);
+    if(code)
+        fn.call(name, *code, nullptr).value();
+    else
+        fn.call(name, nullptr, code.error().message()).value();
+}
 
+void
+LuaHandlebars::
+registerHelper(
+    std::string_view name,
+    Handlebars::Helper helper)
+{
+    lua::Scope scope(ctx_);
+    getFunction(scope, "registerHelper").call(
+        name, scope.makeFunction(std::move(helper))).value();
+}
 
+Error
+LuaHandlebars::
+compile(
+    std::string_view name,
+    std::string_view text)
+{
+    auto code = Handlebars::toLua(text);
+    if(! code)
+        return code.error();
+    lua::Scope scope(ctx_);
+    auto result = getFunction(scope, "compile").call(name, *code);
+    if(! result)
+        return result.error();
+    templates_.insert(name);
+    return Error::success();
+}
 
+Error
+LuaHandlebars::
+render(
+    llvm::raw_ostream& os,
+    std::string_view name,
+    dom::Value const& context,
+    Handlebars::Options const& options)
+{
+    lua::Scope scope(ctx_);
+    profile_ = options.profile;
+    ctx_.setDeadline(options.deadline);
+    auto result = getFunction(scope, "render").call(
+        name, context, options.noEscape,
+        options.preventIndent, options.profile != nullptr);
+    if(! result)
+        return result.error();
+    os << lua::String(std::move(*result)).get();
+    return Error::success();
 }
 
 } // mrdox
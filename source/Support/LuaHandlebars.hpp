@@ -11,8 +11,13 @@
 #ifndef MRDOX_API_SUPPORT_LUAHANDLEBARS_HPP
 #define MRDOX_API_SUPPORT_LUAHANDLEBARS_HPP
 
+#include "Support/Handlebars.hpp"
+#include "Support/RenderProfile.hpp"
 #include <mrdox/Platform.hpp>
 #include <mrdox/Support/Lua.hpp>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/raw_ostream.h>
+#include <string_view>
 
 namespace clang {
 namespace mrdox {
@@ -24,6 +29,84 @@ Error
 tryLoadHandlebars(
     lua::Context const& ctx);
 
+/** A Handlebars template engine which runs in Lua.
+
+    Templates are parsed by the native engine,
+    and each one is translated into a Lua chunk
+    which is loaded once. The output is meant to
+    be identical to that of the native engine.
+
+    @par Thread Safety
+    Distinct objects may be used concurrently.
+*/
+class LuaHandlebars
+{
+    lua::Context ctx_;
+    llvm::StringSet<> templates_;
+    RenderProfile* profile_ = nullptr;
+
+public:
+    /** Constructor.
+
+        The built-in helpers are registered.
+    */
+    LuaHandlebars();
+
+    LuaHandlebars(LuaHandlebars const&) = delete;
+    LuaHandlebars& operator=(LuaHandlebars const&) = delete;
+
+    /** Register a partial.
+
+        The text is translated now. If this
+        fails, the error is reported when the
+        partial is used.
+    */
+    void
+    registerPartial(
+        std::string_view name,
+        std::string_view text);
+
+    /** Register a helper, replacing any with the same name.
+    */
+    void
+    registerHelper(
+        std::string_view name,
+        Handlebars::Helper helper);
+
+    /** Return true if a template with the name was compiled.
+    */
+    bool
+    hasTemplate(std::string_view name) const
+    {
+        return templates_.contains(name);
+    }
+
+    /** Compile a template, giving it a name.
+    */
+    Error
+    compile(
+        std::string_view name,
+        std::string_view text);
+
+    /** Render a named template to a stream.
+
+        @param os The stream to write to.
+
+        @param name The name the template was compiled with.
+
+        @param context The value used as `this`
+        at the top level of the template.
+
+        @param options The rendering options.
+    */
+    Error
+    render(
+        llvm::raw_ostream& os,
+        std::string_view name,
+        dom::Value const& context,
+        Handlebars::Options const& options);
+};
+
 } // mrdox
 } // clang
 
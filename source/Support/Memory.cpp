@@ -0,0 +1,112 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/Memory.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+namespace clang {
+namespace mrdox {
+
+std::size_t
+getPeakResidentBytes() noexcept
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(! GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize;
+#else
+    struct rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+#if defined(__APPLE__)
+    // macOS reports bytes
+    return static_cast<std::size_t>(ru.ru_maxrss);
+#else
+    // Linux and the BSDs report kilobytes
+    return static_cast<std::size_t>(ru.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+std::size_t
+getResidentBytes() noexcept
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(! GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.WorkingSetSize;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+        reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#elif defined(__linux__)
+    // the second field is the resident pages
+    std::FILE* f = std::fopen("/proc/self/statm", "r");
+    if(! f)
+        return 0;
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int const n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    if(n != 2)
+        return 0;
+    return static_cast<std::size_t>(resident) *
+        static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+static thread_local std::size_t translationUnitBytes = 0;
+
+void
+setTranslationUnitBytes(
+    std::size_t bytes) noexcept
+{
+    translationUnitBytes = bytes;
+}
+
+std::size_t
+takeTranslationUnitBytes() noexcept
+{
+    return std::exchange(translationUnitBytes, 0);
+}
+
+void
+reportPeakMemory(
+    std::string_view phase)
+{
+    reportInfo("Peak memory after {}: {} MB", phase,
+        getPeakResidentBytes() / (1024 * 1024));
+}
+
+} // mrdox
+} // clang
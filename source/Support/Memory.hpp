@@ -0,0 +1,75 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_MEMORY_HPP
+#define MRDOX_TOOL_SUPPORT_MEMORY_HPP
+
+#include <mrdox/Platform.hpp>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** Return the peak resident set size of the process, in bytes.
+
+    Zero is returned if the platform does
+    not provide the value.
+*/
+std::size_t
+getPeakResidentBytes() noexcept;
+
+/** Return the current resident set size of the process, in bytes.
+
+    Zero is returned if the platform does
+    not provide the value.
+*/
+std::size_t
+getResidentBytes() noexcept;
+
+/** Record the memory held by the translation unit parsed on this thread.
+
+    The value is kept until it is taken with
+    @ref takeTranslationUnitBytes.
+*/
+void
+setTranslationUnitBytes(
+    std::size_t bytes) noexcept;
+
+/** Return and clear the memory recorded on this thread.
+*/
+std::size_t
+takeTranslationUnitBytes() noexcept;
+
+/** Report the peak resident set size after a phase.
+*/
+void
+reportPeakMemory(
+    std::string_view phase);
+
+/** Return the number of bytes a string holds on the heap.
+*/
+inline
+std::size_t
+heapBytes(
+    std::string const& s) noexcept
+{
+    // a short string is stored inside the object
+    auto const p = reinterpret_cast<char const*>(&s);
+    if(s.data() >= p && s.data() < p + sizeof(s))
+        return 0;
+    return s.capacity() + 1;
+}
+
+} // mrdox
+} // clang
+
+#endif
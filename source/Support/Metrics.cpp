@@ -0,0 +1,225 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/Metrics.hpp"
+#include "Support/Memory.hpp"
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+// The label name is the same for
+// every value of one metric.
+struct Family
+{
+    std::string labelName;
+    std::map<std::string, double> values;
+};
+
+std::atomic<bool> collecting = false;
+std::mutex metricsMutex;
+std::map<std::string, Family, std::less<>> metrics;
+
+template<class F>
+void
+updateMetric(
+    std::string_view name,
+    MetricLabel label,
+    F const& f)
+{
+    if(! isCollectingMetrics())
+        return;
+    std::lock_guard<std::mutex> lock(metricsMutex);
+    auto it = metrics.find(name);
+    if(it == metrics.end())
+        it = metrics.emplace(std::string(name), Family{
+            std::string(label.name), {} }).first;
+    f(it->second.values[std::string(label.value)]);
+}
+
+/** Write a label value, escaped as OpenMetrics requires.
+*/
+void
+writeLabelValue(
+    llvm::raw_ostream& os,
+    std::string_view value)
+{
+    for(char c : value)
+    {
+        if(c == '\\' || c == '"')
+            os << '\\' << c;
+        else if(c == '\n')
+            os << "\\n";
+        else
+            os << c;
+    }
+}
+
+void
+writeOpenMetrics(
+    llvm::raw_ostream& os)
+{
+    for(auto const& [name, family] : metrics)
+    {
+        os << "# TYPE " << name << " gauge\n";
+        for(auto const& [label, value] : family.values)
+        {
+            os << name;
+            if(! family.labelName.empty())
+            {
+                os << '{' << family.labelName << "=\"";
+                writeLabelValue(os, label);
+                os << "\"}";
+            }
+            os << ' ' << fmt::format("{}", value) << '\n';
+        }
+    }
+    os << "# EOF\n";
+}
+
+void
+writeJSON(
+    llvm::raw_ostream& os)
+{
+    llvm::json::OStream J(os, 2);
+    J.object([&]
+    {
+        for(auto const& [name, family] : metrics)
+        {
+            if(family.labelName.empty())
+            {
+                J.attribute(name, family.values.begin()->second);
+                continue;
+            }
+            J.attributeObject(name, [&]
+            {
+                for(auto const& [label, value] : family.values)
+                    J.attribute(label, value);
+            });
+        }
+    });
+    os << '\n';
+}
+
+} // (anon)
+
+void
+startMetrics()
+{
+    collecting.store(true, std::memory_order_release);
+}
+
+bool
+isCollectingMetrics() noexcept
+{
+    return collecting.load(std::memory_order_acquire);
+}
+
+void
+setMetric(
+    std::string_view name,
+    double value,
+    MetricLabel label)
+{
+    updateMetric(name, label,
+        [&](double& v)
+        {
+            v = value;
+        });
+}
+
+void
+addMetric(
+    std::string_view name,
+    double value,
+    MetricLabel label)
+{
+    updateMetric(name, label,
+        [&](double& v)
+        {
+            v += value;
+        });
+}
+
+void
+addPhaseMetrics(
+    std::vector<PhaseStats> const& phases)
+{
+    // a phase which runs more than once,
+    // such as for each page, is summed
+    for(auto const& s : phases)
+    {
+        addMetric("mrdox_phase_wall_seconds",
+            s.wallSeconds, { "phase", s.name });
+        addMetric("mrdox_phase_cpu_seconds",
+            s.cpuSeconds, { "phase", s.name });
+        if(! isTrackingAllocations())
+            continue;
+        addMetric("mrdox_phase_allocations",
+            static_cast<double>(s.allocations.count), { "phase", s.name });
+        addMetric("mrdox_phase_allocated_bytes",
+            static_cast<double>(s.allocations.bytes), { "phase", s.name });
+    }
+}
+
+Error
+writeMetrics(
+    std::string_view path)
+{
+    addPhaseMetrics(takePhaseStats());
+    setMetric("mrdox_peak_resident_bytes",
+        static_cast<double>(getPeakResidentBytes()));
+
+    llvm::SmallString<256> temp;
+    int fd;
+    if(auto ec = llvm::sys::fs::createUniqueFile(
+            std::string(path) + "-%%%%%%%%.tmp", fd, temp))
+        return formatError("createUniqueFile(\"{}\") returned \"{}\"",
+            path, ec.message());
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        {
+            std::lock_guard<std::mutex> lock(metricsMutex);
+            if(llvm::sys::path::extension(path).equals_insensitive(".json"))
+                writeJSON(os);
+            else
+                writeOpenMetrics(os);
+        }
+        os.close();
+        if(os.has_error())
+        {
+            auto ec = os.error();
+            os.clear_error();
+            llvm::sys::fs::remove(temp);
+            return formatError("write(\"{}\") returned \"{}\"",
+                std::string_view(temp.data(), temp.size()), ec.message());
+        }
+    }
+    if(auto ec = llvm::sys::fs::rename(temp, path))
+    {
+        llvm::sys::fs::remove(temp);
+        return formatError("rename(\"{}\") returned \"{}\"",
+            path, ec.message());
+    }
+    return Error::success();
+}
+
+} // mrdox
+} // clang
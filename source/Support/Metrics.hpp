@@ -0,0 +1,86 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_METRICS_HPP
+#define MRDOX_TOOL_SUPPORT_METRICS_HPP
+
+#include "Support/PhaseReport.hpp"
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A label which distinguishes the values of one metric.
+*/
+struct MetricLabel
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+/** Start collecting metrics.
+
+    Until this is called, metrics
+    are not kept and cost one load.
+*/
+void
+startMetrics();
+
+/** Return true if metrics are collected.
+
+    A metric which is costly to compute
+    should only be computed when this is true.
+*/
+bool
+isCollectingMetrics() noexcept;
+
+/** Set the value of a metric.
+*/
+void
+setMetric(
+    std::string_view name,
+    double value,
+    MetricLabel label = {});
+
+/** Add to the value of a metric.
+*/
+void
+addMetric(
+    std::string_view name,
+    double value,
+    MetricLabel label = {});
+
+/** Add the times of phases to the metrics.
+*/
+void
+addPhaseMetrics(
+    std::vector<PhaseStats> const& phases);
+
+/** Write the metrics to a file.
+
+    The file is JSON when its extension is
+    ".json", and the OpenMetrics text format
+    read by Prometheus otherwise. It is written
+    to a temporary and renamed, so a scheduler
+    never reads a partly written file. The
+    peak resident set size and the phases
+    not yet reported are added first.
+*/
+Error
+writeMetrics(
+    std::string_view path);
+
+} // mrdox
+} // clang
+
+#endif
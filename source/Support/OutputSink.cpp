@@ -0,0 +1,262 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/OutputSink.hpp"
+#include "Support/Trace.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <optional>
+
+namespace clang {
+namespace mrdox {
+
+Error
+writeFile(
+    std::string const& path,
+    std::string_view text)
+{
+    TraceScope trace("write", path);
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    // the text is written with one call, either
+    // at once or when the stream is closed
+    os << text;
+    os.close();
+    if(os.has_error())
+        return formatError("could not write \"{}\": {}",
+            path, os.error().message());
+    return Error::success();
+}
+
+namespace {
+
+class DirectorySink : public OutputSink
+{
+    std::string dir_;
+    llvm::StringSet<> dirs_;
+
+public:
+    explicit
+    DirectorySink(
+        std::string_view dir)
+        : dir_(dir)
+    {
+    }
+
+    Error
+    write(
+        std::string_view name,
+        std::string_view text) override
+    {
+        // each directory is made once
+        if(auto pos = name.rfind('/');
+            pos != std::string_view::npos &&
+            dirs_.insert(name.substr(0, pos)).second)
+        {
+            auto dir = name.substr(0, pos);
+            if(auto ec = llvm::sys::fs::create_directories(
+                    files::appendPath(dir_, dir)))
+                return formatError("could not create \"{}\": {}",
+                    dir, ec.message());
+        }
+        return writeFile(files::appendPath(dir_, name), text);
+    }
+
+    Error
+    close() override
+    {
+        return Error::success();
+    }
+};
+
+//------------------------------------------------
+
+// A ustar archive, whose members are regular
+// files. Longer names than a header holds are
+// given in a GNU long name member before them.
+class TarSink : public OutputSink
+{
+    static constexpr std::size_t BlockSize = 512;
+
+    std::string path_;
+    llvm::raw_fd_ostream file_;
+    std::optional<CompressedOstream> compressed_;
+    llvm::raw_ostream* os_;
+    bool closed_ = false;
+
+    using Header = std::array<char, BlockSize>;
+
+    static
+    void
+    putString(
+        char* field,
+        std::size_t size,
+        std::string_view s) noexcept
+    {
+        std::memcpy(field, s.data(), std::min(size, s.size()));
+    }
+
+    // octal digits with a terminating NUL
+    static
+    void
+    putOctal(
+        char* field,
+        std::size_t size,
+        std::uint64_t v) noexcept
+    {
+        fmt::format_to_n(field, size - 1, "{:0{}o}", v, size - 1);
+    }
+
+    void
+    writeHeader(
+        std::string_view name,
+        std::uint64_t size,
+        char type)
+    {
+        Header h{};
+        putString(&h[0], 100, name);
+        putOctal(&h[100], 8, 0644);
+        putOctal(&h[108], 8, 0);
+        putOctal(&h[116], 8, 0);
+        putOctal(&h[124], 12, size);
+        // the time is zero so that the
+        // archive of a corpus is the same
+        putOctal(&h[136], 12, 0);
+        h[156] = type;
+        putString(&h[257], 6, "ustar");
+        putString(&h[263], 2, "00");
+
+        // the checksum is taken with its
+        // own field as spaces
+        std::memset(&h[148], ' ', 8);
+        unsigned sum = 0;
+        for(char c : h)
+            sum += static_cast<unsigned char>(c);
+        fmt::format_to_n(&h[148], 7, "{:06o}", sum);
+        h[154] = '\0';
+        os_->write(h.data(), h.size());
+    }
+
+    void
+    writeData(
+        std::string_view data)
+    {
+        static constexpr char zeros[BlockSize] = {};
+        os_->write(data.data(), data.size());
+        if(auto n = data.size() % BlockSize)
+            os_->write(zeros, BlockSize - n);
+    }
+
+    Error
+    checkStream()
+    {
+        if(! file_.has_error())
+            return Error::success();
+        auto ec = file_.error();
+        file_.clear_error();
+        return formatError("could not write \"{}\": {}",
+            path_, ec.message());
+    }
+
+public:
+    TarSink(
+        std::string path,
+        OutputCompression compression,
+        std::error_code& ec)
+        : path_(std::move(path))
+        , file_(path_, ec)
+        , os_(&file_)
+    {
+        file_.SetBufferSize(1024 * 1024);
+        if(compression != OutputCompression::none)
+        {
+            compressed_.emplace(file_, compression);
+            os_ = &*compressed_;
+        }
+    }
+
+    ~TarSink()
+    {
+        if(! closed_)
+            close();
+    }
+
+    Error
+    write(
+        std::string_view name,
+        std::string_view text) override
+    {
+        // octal digits of the size field
+        if(text.size() >= (std::uint64_t(1) << 33))
+            return formatError("\"{}\" is too large for a tar archive",
+                name);
+        TraceScope trace("write", name);
+        if(name.size() > 100)
+        {
+            std::string longName(name);
+            longName.push_back('\0');
+            writeHeader("././@LongLink", longName.size(), 'L');
+            writeData(longName);
+        }
+        writeHeader(name, text.size(), '0');
+        writeData(text);
+        return checkStream();
+    }
+
+    Error
+    close() override
+    {
+        closed_ = true;
+        // the end is two blocks of zeros
+        static constexpr char zeros[2 * BlockSize] = {};
+        os_->write(zeros, sizeof(zeros));
+        if(compressed_)
+            compressed_->close();
+        file_.close();
+        return checkStream();
+    }
+};
+
+} // (anon)
+
+std::unique_ptr<OutputSink>
+makeDirectorySink(
+    std::string_view dir)
+{
+    return std::make_unique<DirectorySink>(dir);
+}
+
+Expected<std::unique_ptr<OutputSink>>
+makeTarSink(
+    std::string_view path,
+    OutputCompression compression)
+{
+    std::string fileName(path);
+    fileName.append(compressedExtension(compression));
+    std::error_code ec;
+    auto sink = std::make_unique<TarSink>(
+        fileName, compression, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            fileName, ec.message());
+    return sink;
+}
+
+} // mrdox
+} // clang
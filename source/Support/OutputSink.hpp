@@ -0,0 +1,87 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_OUTPUTSINK_HPP
+#define MRDOX_TOOL_SUPPORT_OUTPUTSINK_HPP
+
+#include "Support/Compression.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** Write a file with a single call to the operating system.
+*/
+Error
+writeFile(
+    std::string const& path,
+    std::string_view text);
+
+/** The destination of the files of multi-page output.
+
+    The files are written by one thread at a
+    time, in the order they are given.
+*/
+class OutputSink
+{
+public:
+    virtual ~OutputSink() = default;
+
+    /** Write a file.
+
+        @param name The path of the file, relative
+        to the output, with '/' separators.
+
+        @param text The contents of the file.
+    */
+    virtual
+    Error
+    write(
+        std::string_view name,
+        std::string_view text) = 0;
+
+    /** Write what remains of the output.
+
+        Nothing is written after this is called.
+    */
+    virtual
+    Error
+    close() = 0;
+};
+
+/** Return a sink which writes each file in a directory.
+
+    Missing directories in the name of
+    a file are made.
+*/
+std::unique_ptr<OutputSink>
+makeDirectorySink(
+    std::string_view dir);
+
+/** Return a sink which writes every file into one tar archive.
+
+    The archive is streamed as the files are
+    written, and may be compressed as a whole.
+
+    @param path The path of the archive, without
+    the extension of the compression.
+*/
+Expected<std::unique_ptr<OutputSink>>
+makeTarSink(
+    std::string_view path,
+    OutputCompression compression);
+
+} // mrdox
+} // clang
+
+#endif
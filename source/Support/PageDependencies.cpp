@@ -0,0 +1,126 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/PageDependencies.hpp"
+#include "Support/OutputSink.hpp"
+#include "Support/Radix.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+constexpr std::string_view graphName = ".mrdox-pages";
+
+} // (anon)
+
+PageDependencies::
+PageDependencies(
+    std::string_view outputDir,
+    std::uint64_t key)
+    : path_(files::appendPath(outputDir, graphName))
+    , key_(key)
+{
+    // the first line is the key, and each other
+    // is the name of a page followed by its
+    // symbols, as "<id>:<hash>"
+    auto text = files::getFileText(path_);
+    if(! text)
+        return;
+    llvm::StringRef rest(*text);
+    llvm::StringRef line;
+    std::tie(line, rest) = rest.split('\n');
+    std::uint64_t oldKey;
+    if(line.getAsInteger(16, oldKey) || oldKey != key_)
+        return;
+    while(! rest.empty())
+    {
+        std::tie(line, rest) = rest.split('\n');
+        auto [name, list] = line.split(' ');
+        std::vector<Dependency> deps;
+        bool ok = ! name.empty();
+        while(ok && ! list.empty())
+        {
+            llvm::StringRef item;
+            std::tie(item, list) = list.split(' ');
+            auto [hex, hash] = item.split(':');
+            std::string bytes;
+            Dependency dep;
+            ok = llvm::tryGetFromHex(hex, bytes) &&
+                bytes.size() == dep.id.size() &&
+                ! hash.getAsInteger(16, dep.hash);
+            if(ok)
+            {
+                dep.id = SymbolID(bytes.data());
+                deps.push_back(dep);
+            }
+        }
+        if(ok && ! deps.empty())
+            old_[name] = std::move(deps);
+    }
+}
+
+auto
+PageDependencies::
+find(
+    std::string_view name) const noexcept ->
+        std::span<Dependency const>
+{
+    auto it = old_.find(name);
+    if(it == old_.end())
+        return {};
+    return it->getValue();
+}
+
+void
+PageDependencies::
+insert(
+    std::string name,
+    std::vector<Dependency> deps)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    new_[name] = std::move(deps);
+}
+
+Error
+PageDependencies::
+save()
+{
+    std::string text = llvm::utohexstr(key_, true);
+    text.push_back('\n');
+    for(auto const& e : new_)
+    {
+        text.append(e.getKey());
+        for(auto const& dep : e.getValue())
+        {
+            char hex[40];
+            text.push_back(' ');
+            text.append(toBase16(hex, dep.id));
+            text.push_back(':');
+            text.append(llvm::utohexstr(dep.hash, true));
+        }
+        text.push_back('\n');
+    }
+    // the graph is replaced as a whole, so a
+    // failed run never leaves part of one
+    auto const tempPath = path_ + ".tmp";
+    if(auto err = writeFile(tempPath, text))
+        return err;
+    if(auto ec = llvm::sys::fs::rename(tempPath, path_))
+        return formatError("could not rename \"{}\": {}",
+            tempPath, ec.message());
+    return Error::success();
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,96 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SUPPORT_PAGEDEPENDENCIES_HPP
+#define MRDOX_LIB_SUPPORT_PAGEDEPENDENCIES_HPP
+
+#include <mrdox/Metadata/Symbols.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** The symbols which each page of the last run showed.
+
+    The graph is kept in the output directory,
+    with a key for everything else the pages
+    depend on, such as the configuration, the
+    addons and the set of symbols. Each page
+    lists the symbols it looked up, with a hash
+    of the object of each one. A page of the last
+    run whose symbols have the same hashes, and
+    whose key is the same, is unchanged.
+
+    @par Thread Safety
+    @ref find and @ref insert may be
+    called concurrently.
+*/
+class PageDependencies
+{
+public:
+    struct Dependency
+    {
+        SymbolID id;
+        std::uint64_t hash = 0;
+    };
+
+private:
+    std::string path_;
+    std::uint64_t key_;
+    llvm::StringMap<std::vector<Dependency>> old_;
+    std::mutex mutex_;
+    llvm::StringMap<std::vector<Dependency>> new_;
+
+public:
+    /** Constructor.
+
+        The graph of the last run is loaded, and
+        is empty when its key is not this one.
+    */
+    PageDependencies(
+        std::string_view outputDir,
+        std::uint64_t key);
+
+    /** Return the symbols of a page of the last run.
+
+        The list is empty when the page
+        was not rendered by the last run.
+    */
+    std::span<Dependency const>
+    find(
+        std::string_view name) const noexcept;
+
+    /** Set the symbols of a page of this run.
+    */
+    void
+    insert(
+        std::string name,
+        std::vector<Dependency> deps);
+
+    /** Write the graph of this run.
+
+        A page which was not inserted is
+        rendered again by the next run.
+    */
+    Error
+    save();
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,318 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/PageWriter.hpp"
+#include "Support/Metrics.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+constexpr std::string_view manifestName = ".mrdox-manifest";
+
+} // (anon)
+
+std::string
+pageFileName(
+    std::string_view id,
+    std::string_view extension,
+    unsigned shardDepth)
+{
+    std::string name;
+    name.reserve(id.size() + extension.size() + 3 * shardDepth + 1);
+    for(unsigned i = 0; i < shardDepth && 2 * i + 2 <= id.size(); ++i)
+    {
+        name.append(id.substr(2 * i, 2));
+        name.push_back('/');
+    }
+    name.append(id);
+    name.push_back('.');
+    name.append(extension);
+    return name;
+}
+
+PageWriter::
+PageWriter(
+    std::string_view outputDir,
+    Config const& config,
+    std::size_t capacity)
+    : outputDir_(outputDir)
+    , incremental_(config.incrementalOutput)
+    , capacity_(capacity)
+{
+    // the configuration was checked when it was
+    // loaded, so only opening the archive fails
+    auto compression = parseOutputCompression(
+        config.outputCompression).value();
+    if(config.outputArchive == "tar")
+    {
+        auto sink = makeTarSink(files::appendPath(
+            outputDir_, "reference.tar"), compression);
+        if(sink)
+            sink_ = std::move(*sink);
+        else
+            errors_.push_back(sink.error());
+    }
+    else
+    {
+        compression_ = compression;
+        sink_ = makeDirectorySink(outputDir_);
+        directory_ = true;
+    }
+
+    if(incremental_)
+    {
+        // each line is the hash and the name of a file
+        auto text = files::getFileText(
+            files::appendPath(outputDir_, manifestName));
+        if(text)
+        {
+            llvm::StringRef rest(*text);
+            while(! rest.empty())
+            {
+                llvm::StringRef line;
+                std::tie(line, rest) = rest.split('\n');
+                auto [hex, name] = line.split(' ');
+                std::uint64_t hash;
+                if(! name.empty() && ! hex.getAsInteger(16, hash))
+                    oldHashes_[name] = hash;
+            }
+        }
+    }
+    thread_ = std::thread([this]{ run(); });
+}
+
+PageWriter::
+~PageWriter()
+{
+    finish();
+}
+
+void
+PageWriter::
+showProgress(
+    std::size_t total)
+{
+    progress_.emplace("Writing", total, true, &bytesWritten_);
+}
+
+void
+PageWriter::
+write(
+    std::string name,
+    std::string text)
+{
+    if(compression_ != OutputCompression::none)
+    {
+        std::string compressed;
+        compressAppend(compression_, text, compressed);
+        text = std::move(compressed);
+        name.append(compressedExtension(compression_));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    // a page larger than the capacity
+    // is accepted once the queue is empty
+    space_.wait(lock, [&]
+        {
+            return queued_ == 0 ||
+                queued_ + text.size() <= capacity_;
+        });
+    queued_ += text.size();
+    ++filesQueued_;
+    queue_.push_back({ std::move(name), std::move(text) });
+    ready_.notify_one();
+}
+
+bool
+PageWriter::
+keep(
+    std::string name)
+{
+    if(! incremental_ || ! directory_)
+        return false;
+    if(compression_ != OutputCompression::none)
+        name.append(compressedExtension(compression_));
+    // the old hashes are not changed once loaded
+    if(! oldHashes_.count(name) ||
+        ! llvm::sys::fs::exists(files::appendPath(outputDir_, name)))
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back({ std::move(name), {}, true });
+    ready_.notify_one();
+    return true;
+}
+
+std::vector<Error>
+PageWriter::
+finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    ready_.notify_one();
+    if(! thread_.joinable())
+        return {};
+    thread_.join();
+    progress_.reset();
+    if(sink_)
+        if(auto err = sink_->close())
+            errors_.push_back(std::move(err));
+    addMetric("mrdox_pages_written", written_);
+    addMetric("mrdox_pages_unchanged", unchanged_);
+    addMetric("mrdox_bytes_written", bytes_);
+    if(incremental_)
+        if(auto err = finishManifest())
+            errors_.push_back(std::move(err));
+    return std::move(errors_);
+}
+
+Error
+PageWriter::
+writePage(
+    Page const& page)
+{
+    // the error of the sink was kept
+    if(! sink_)
+        return Error::success();
+
+    if(! incremental_)
+    {
+        if(auto err = sink_->write(page.name, page.text))
+            return err;
+        ++written_;
+        bytes_ += page.text.size();
+        return Error::success();
+    }
+
+    if(page.keep)
+    {
+        ++unchanged_;
+        newHashes_[page.name] = oldHashes_.find(page.name)->getValue();
+        return Error::success();
+    }
+
+    auto const path = files::appendPath(outputDir_, page.name);
+    auto const hash = llvm::xxHash64(page.text);
+    // the file is checked, in case
+    // it was removed by someone else
+    auto it = oldHashes_.find(page.name);
+    if( it != oldHashes_.end() &&
+        it->getValue() == hash &&
+        llvm::sys::fs::exists(path))
+    {
+        ++unchanged_;
+        newHashes_[page.name] = hash;
+        return Error::success();
+    }
+    // a file which failed is not in the
+    // manifest, so it is written next time
+    if(auto err = sink_->write(page.name, page.text))
+        return err;
+    ++written_;
+    bytes_ += page.text.size();
+    newHashes_[page.name] = hash;
+    return Error::success();
+}
+
+Error
+PageWriter::
+finishManifest()
+{
+    namespace fs = llvm::sys::fs;
+
+    // only files this writer made are removed
+    std::size_t removed = 0;
+    for(auto const& e : oldHashes_)
+    {
+        if(newHashes_.count(e.getKey()))
+            continue;
+        auto ec = fs::remove(files::appendPath(
+            outputDir_, e.getKey()));
+        if(ec)
+            reportWarning("could not remove \"{}\": {}",
+                e.getKey(), ec.message());
+        else
+            ++removed;
+    }
+
+    std::string text;
+    for(auto const& e : newHashes_)
+    {
+        text += llvm::utohexstr(e.getValue(), true);
+        text.push_back(' ');
+        text.append(e.getKey());
+        text.push_back('\n');
+    }
+    // a partly written manifest is never read,
+    // so the next run does not skip a file wrongly
+    auto const path = files::appendPath(outputDir_, manifestName);
+    auto const tempPath = path + ".tmp";
+    if(auto err = writeFile(tempPath, text))
+        return err;
+    if(auto ec = fs::rename(tempPath, path))
+        return formatError("could not rename \"{}\": {}",
+            tempPath, ec.message());
+
+    reportInfo("{} files written, {} unchanged, {} removed",
+        written_, unchanged_, removed);
+    return Error::success();
+}
+
+void
+PageWriter::
+run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for(;;)
+    {
+        ready_.wait(lock, [&]
+            {
+                return done_ || ! queue_.empty();
+            });
+        if(queue_.empty())
+            return;
+
+        // take every page queued so far
+        std::deque<Page> batch;
+        batch.swap(queue_);
+        lock.unlock();
+        for(auto& page : batch)
+        {
+            auto err = writePage(page);
+            auto const bytes = page.text.size();
+            if(progress_)
+            {
+                bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+                progress_->add();
+            }
+            // the memory is returned right away
+            page = {};
+            lock.lock();
+            queued_ -= bytes;
+            if(err)
+                errors_.push_back(std::move(err));
+            lock.unlock();
+            space_.notify_all();
+        }
+        lock.lock();
+    }
+}
+
+} // mrdox
+} // clang
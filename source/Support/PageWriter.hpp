@@ -0,0 +1,210 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SUPPORT_PAGEWRITER_HPP
+#define MRDOX_LIB_SUPPORT_PAGEWRITER_HPP
+
+#include "Support/Compression.hpp"
+#include "Support/OutputSink.hpp"
+#include "Support/Progress.hpp"
+#include <mrdox/Config.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Return the name of the file of a page.
+
+    The name is relative to the output directory.
+    Each level of subdirectory is named with the
+    next two digits of the id, so that no
+    directory holds more than 256 of them.
+
+    @param id The symbol id, in base 16.
+
+    @param extension The file extension,
+    without the period.
+
+    @param shardDepth The levels of
+    subdirectories, or zero for none.
+*/
+std::string
+pageFileName(
+    std::string_view id,
+    std::string_view extension,
+    unsigned shardDepth);
+
+/** Writes output files on a dedicated thread.
+
+    Render threads hand over the text of each
+    file and go on with the next page, so they
+    do not wait on the file system. They only
+    wait when the text queued for writing
+    exceeds the capacity, until the writer
+    catches up. Each file is written with a
+    single call to the operating system, and
+    missing directories in its name are made.
+
+    When the output is an archive, the files
+    are streamed into one tar file instead, in
+    the order they are queued, and the archive
+    is compressed as a whole.
+
+    When output is incremental, a manifest of
+    the hash of each file is kept in the output
+    directory. A file whose hash did not change
+    since the last run is not written again, and
+    the files of the last run which were not
+    written by this one are removed.
+
+    @par Thread Safety
+    @ref write may be called concurrently.
+*/
+class PageWriter
+{
+    struct Page
+    {
+        std::string name;
+        std::string text;
+
+        // the file of the last run is kept
+        bool keep = false;
+    };
+
+    std::string outputDir_;
+    bool incremental_;
+    bool directory_ = false;
+    OutputCompression compression_ = OutputCompression::none;
+    std::unique_ptr<OutputSink> sink_;
+    llvm::StringMap<std::uint64_t> oldHashes_;
+    llvm::StringMap<std::uint64_t> newHashes_;
+    std::size_t written_ = 0;
+    std::size_t unchanged_ = 0;
+    std::size_t bytes_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable space_;
+    std::deque<Page> queue_;
+    std::size_t queued_ = 0;
+    std::size_t filesQueued_ = 0;
+    std::size_t capacity_;
+    bool done_ = false;
+    std::vector<Error> errors_;
+    std::atomic<std::size_t> bytesWritten_ = 0;
+    std::optional<Progress> progress_;
+    std::thread thread_;
+
+    void run();
+    Error writePage(Page const& page);
+    Error finishManifest();
+
+public:
+    /** Constructor.
+
+        The incremental-output, output-compression
+        and output-archive options of the
+        configuration are used. When each file is
+        compressed, its text is compressed by the
+        thread which queues it, and its name is
+        given the extension of the compression.
+
+        @param outputDir The directory of the files.
+
+        @param config The configuration.
+
+        @param capacity The number of bytes which
+        may be queued before @ref write waits.
+    */
+    PageWriter(
+        std::string_view outputDir,
+        Config const& config,
+        std::size_t capacity = 64 * 1024 * 1024);
+
+    /** Destructor.
+
+        The files still queued are written.
+    */
+    ~PageWriter();
+
+    /** Queue a file to be written.
+
+        @param name The path of the file,
+        relative to the output directory.
+
+        @param text The contents of the file.
+    */
+    void
+    write(
+        std::string name,
+        std::string text);
+
+    /** Keep a file of the last run without writing it again.
+
+        This is only possible when output is
+        incremental to a directory, and the file
+        is in the manifest and still exists.
+
+        @return `true` if the file is kept.
+    */
+    bool
+    keep(
+        std::string name);
+
+    /** Show a progress line for the files written.
+
+        This is called before any file is queued.
+
+        @param total The number of files which
+        will be queued, or zero if not known.
+    */
+    void
+    showProgress(std::size_t total);
+
+    /** Return the number of files queued with their text.
+
+        The files kept from the last run are
+        not included. This is called when no
+        file is being queued.
+    */
+    std::size_t
+    filesQueued() const noexcept
+    {
+        return filesQueued_;
+    }
+
+    /** Write the files still queued and stop the thread.
+
+        When output is incremental, the stale
+        files are removed, the manifest is saved,
+        and the counts of files are reported.
+
+        @return The errors of the files which
+        could not be written.
+    */
+    std::vector<Error>
+    finish();
+};
+
+} // mrdox
+} // clang
+
+#endif
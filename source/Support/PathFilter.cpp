@@ -0,0 +1,91 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/PathFilter.hpp"
+#include "Support/Error.hpp"
+
+namespace clang {
+namespace mrdox {
+
+Error
+PathFilter::
+add(llvm::StringRef pattern)
+{
+    auto const wild = pattern.find_first_of("*?[{");
+    if(wild == llvm::StringRef::npos)
+    {
+        if(! pattern.empty() && pattern.back() == '/')
+            dirs_.insert(pattern);
+        else
+            files_.insert(pattern);
+        return Error::success();
+    }
+
+    auto glob = llvm::GlobPattern::create(pattern);
+    if(! glob)
+        return formatError("invalid pattern \"{}\": {}",
+            pattern, toString(glob.takeError()));
+    // the directory before the first wildcard
+    auto const slash = pattern.rfind('/', wild);
+    llvm::StringRef const dir = slash == llvm::StringRef::npos ?
+        llvm::StringRef() : pattern.take_front(slash + 1);
+    globs_[dir].emplace_back(std::move(*glob));
+    return Error::success();
+}
+
+bool
+PathFilter::
+match(llvm::StringRef path) const
+{
+    if(files_.contains(path))
+        return true;
+    auto const matchGlobs = [&](llvm::StringRef dir)
+    {
+        auto const it = globs_.find(dir);
+        if(it == globs_.end())
+            return false;
+        for(auto const& glob : it->getValue())
+            if(glob.match(path))
+                return true;
+        return false;
+    };
+    if(matchGlobs({}))
+        return true;
+    for(std::size_t i = path.find('/');
+        i != llvm::StringRef::npos;
+        i = path.find('/', i + 1))
+    {
+        llvm::StringRef const dir = path.take_front(i + 1);
+        if(dirs_.contains(dir) || matchGlobs(dir))
+            return true;
+    }
+    return false;
+}
+
+llvm::StringRef
+PathFilter::
+matchDirectory(llvm::StringRef path) const
+{
+    llvm::StringRef result;
+    if(dirs_.empty())
+        return result;
+    for(std::size_t i = path.find('/');
+        i != llvm::StringRef::npos;
+        i = path.find('/', i + 1))
+    {
+        auto const it = dirs_.find(path.take_front(i + 1));
+        if(it != dirs_.end())
+            result = it->getKey();
+    }
+    return result;
+}
+
+} // mrdox
+} // clang
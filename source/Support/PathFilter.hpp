@@ -0,0 +1,80 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_PATHFILTER_HPP
+#define MRDOX_TOOL_SUPPORT_PATHFILTER_HPP
+
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/GlobPattern.h>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A compiled set of path patterns.
+
+    Patterns and paths are full, posix-style
+    paths. A pattern ending in a slash is a
+    directory, which matches every path below
+    it. A pattern containing any of `*?[{` is
+    a glob, where `*` also matches slashes.
+    Any other pattern matches one file.
+
+    Files and directories are found with one
+    hash lookup for each directory of the path,
+    so the cost does not grow with the number
+    of patterns. Globs are kept by the directory
+    before their first wildcard, so only those
+    below a directory of the path are tried.
+*/
+class PathFilter
+{
+    llvm::StringSet<> files_;
+    llvm::StringSet<> dirs_;
+    llvm::StringMap<std::vector<llvm::GlobPattern>> globs_;
+
+public:
+    /** Add a pattern.
+    */
+    Error
+    add(llvm::StringRef pattern);
+
+    /** Return true if there are no patterns.
+    */
+    bool
+    empty() const noexcept
+    {
+        return files_.empty() &&
+            dirs_.empty() &&
+            globs_.empty();
+    }
+
+    /** Return true if a pattern matches the path.
+    */
+    bool
+    match(llvm::StringRef path) const;
+
+    /** Return the longest directory pattern which contains the path.
+
+        Globs and files are not considered.
+        If no directory contains the path, an
+        empty string is returned.
+    */
+    llvm::StringRef
+    matchDirectory(llvm::StringRef path) const;
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,255 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/PhaseReport.hpp"
+#include "Support/Memory.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+struct Phase
+{
+    std::size_t id;
+    PhaseStats stats;
+    bool done = false;
+};
+
+std::mutex phaseMutex;
+std::vector<Phase> phases;
+std::size_t nextPhaseId = 0;
+unsigned phaseDepth = 0;
+
+std::chrono::nanoseconds
+getProcessTime()
+{
+    llvm::sys::TimePoint<> elapsed;
+    std::chrono::nanoseconds user;
+    std::chrono::nanoseconds sys;
+    llvm::sys::Process::GetTimeUsage(elapsed, user, sys);
+    return user + sys;
+}
+
+} // (anon)
+
+ScopedPhase::
+ScopedPhase(
+    std::string_view name)
+    : start_(clock_type::now())
+    , cpu_(getProcessTime())
+    , peak_(getPeakResidentBytes())
+    , allocs_(getThreadAllocationCounts())
+{
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    id_ = nextPhaseId++;
+    auto& phase = phases.emplace_back();
+    phase.id = id_;
+    phase.stats.name = name;
+    phase.stats.depth = phaseDepth++;
+}
+
+ScopedPhase::
+~ScopedPhase()
+{
+    std::chrono::duration<double> const wall =
+        clock_type::now() - start_;
+    std::chrono::duration<double> const cpu =
+        getProcessTime() - cpu_;
+    std::size_t const peak = getPeakResidentBytes();
+    auto const allocs = getThreadAllocationCounts();
+
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    --phaseDepth;
+    auto it = std::find_if(phases.begin(), phases.end(),
+        [&](Phase const& phase)
+        {
+            return phase.id == id_;
+        });
+    if(it == phases.end())
+        return;
+    auto& s = it->stats;
+    s.wallSeconds = wall.count();
+    s.cpuSeconds = cpu.count();
+    s.peakBytes = peak;
+    s.peakDeltaBytes = peak > peak_ ? peak - peak_ : 0;
+    for(std::size_t i = 0; i < allocs.size(); ++i)
+    {
+        // threads which started during the
+        // phase have no counts at its start
+        AllocationCounts d = allocs[i];
+        if(i < allocs_.size())
+        {
+            d.count -= allocs_[i].count;
+            d.bytes -= allocs_[i].bytes;
+        }
+        if(d.count == 0)
+            continue;
+        s.allocations.count += d.count;
+        s.allocations.bytes += d.bytes;
+        s.threadAllocations.emplace_back(i, d);
+    }
+    it->done = true;
+}
+
+void
+setPhaseUnits(
+    std::string_view name,
+    std::size_t units,
+    std::string_view unit)
+{
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    auto it = std::find_if(phases.rbegin(), phases.rend(),
+        [&](Phase const& phase)
+        {
+            return phase.stats.name == name;
+        });
+    if(it == phases.rend())
+        return;
+    it->stats.units = units;
+    it->stats.unit = unit;
+}
+
+std::vector<PhaseStats>
+takePhaseStats()
+{
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    std::vector<PhaseStats> result;
+    for(auto& phase : phases)
+    {
+        if(phase.done)
+            result.emplace_back(std::move(phase.stats));
+    }
+    // phases which are still running are
+    // kept, so their destructors find them
+    std::erase_if(phases,
+        [](Phase const& phase)
+        {
+            return phase.done;
+        });
+    return result;
+}
+
+void
+reportPhaseStats(
+    std::vector<PhaseStats> const& phases)
+{
+    if(phases.empty())
+        return;
+    if(! isTrackingAllocations())
+    {
+        reportInfo("{:<24} {:>10} {:>10} {:>10} {:>10}",
+            "phase", "wall ms", "cpu ms", "peak MB", "+MB");
+        for(auto const& s : phases)
+            reportInfo("{:<24} {:>10.1f} {:>10.1f} {:>10} {:>10}",
+                std::string(2 * s.depth, ' ') + s.name,
+                s.wallSeconds * 1000, s.cpuSeconds * 1000,
+                s.peakBytes >> 20, s.peakDeltaBytes >> 20);
+        return;
+    }
+    reportInfo("{:<24} {:>10} {:>10} {:>10} {:>10} {:>12} {:>10}",
+        "phase", "wall ms", "cpu ms", "peak MB", "+MB",
+        "allocs", "alloc MB");
+    for(auto const& s : phases)
+        reportInfo("{:<24} {:>10.1f} {:>10.1f} {:>10} {:>10} {:>12} {:>10}",
+            std::string(2 * s.depth, ' ') + s.name,
+            s.wallSeconds * 1000, s.cpuSeconds * 1000,
+            s.peakBytes >> 20, s.peakDeltaBytes >> 20,
+            s.allocations.count, s.allocations.bytes >> 20);
+    for(auto const& s : phases)
+    {
+        if(s.units == 0)
+            continue;
+        reportInfo("{}: {:.1f} allocations and {:.0f} bytes per {} ({} {}s)",
+            s.name,
+            double(s.allocations.count) / double(s.units),
+            double(s.allocations.bytes) / double(s.units),
+            s.unit, s.units, s.unit);
+    }
+}
+
+Error
+writePhaseStats(
+    std::string_view path,
+    std::vector<PhaseStats> const& phases)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    llvm::json::OStream J(os, 2);
+    J.object([&]
+    {
+        J.attributeArray("phases", [&]
+        {
+            for(auto const& s : phases)
+            {
+                J.object([&]
+                {
+                    J.attribute("name", s.name);
+                    J.attribute("depth", s.depth);
+                    // a tenth of a millisecond is enough
+                    J.attribute("wall-ms",
+                        std::round(s.wallSeconds * 10000) / 10);
+                    J.attribute("cpu-ms",
+                        std::round(s.cpuSeconds * 10000) / 10);
+                    J.attribute("peak-bytes",
+                        static_cast<std::int64_t>(s.peakBytes));
+                    J.attribute("peak-delta-bytes",
+                        static_cast<std::int64_t>(s.peakDeltaBytes));
+                    if(s.units != 0)
+                    {
+                        J.attribute("units",
+                            static_cast<std::int64_t>(s.units));
+                        J.attribute("unit", s.unit);
+                    }
+                    if(! isTrackingAllocations())
+                        return;
+                    J.attribute("allocations",
+                        static_cast<std::int64_t>(s.allocations.count));
+                    J.attribute("allocated-bytes",
+                        static_cast<std::int64_t>(s.allocations.bytes));
+                    J.attributeArray("threads", [&]
+                    {
+                        for(auto const& [thread, counts] : s.threadAllocations)
+                        {
+                            J.object([&]
+                            {
+                                J.attribute("thread",
+                                    static_cast<std::int64_t>(thread));
+                                J.attribute("allocations",
+                                    static_cast<std::int64_t>(counts.count));
+                                J.attribute("allocated-bytes",
+                                    static_cast<std::int64_t>(counts.bytes));
+                            });
+                        }
+                    });
+                });
+            }
+        });
+    });
+    os << '\n';
+    os.close();
+    if(os.has_error())
+        return formatError("could not write \"{}\": {}",
+            path, os.error().message());
+    return Error::success();
+}
+
+} // mrdox
+} // clang
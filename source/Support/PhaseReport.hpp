@@ -0,0 +1,160 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_PHASEREPORT_HPP
+#define MRDOX_TOOL_SUPPORT_PHASEREPORT_HPP
+
+#include "Support/Allocations.hpp"
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** The resources used by one phase of the program.
+*/
+struct PhaseStats
+{
+    /** The name of the phase.
+    */
+    std::string name;
+
+    /** The number of phases this one is nested in.
+    */
+    unsigned depth = 0;
+
+    /** The elapsed time, in seconds.
+    */
+    double wallSeconds = 0;
+
+    /** The processor time of all threads, in seconds.
+    */
+    double cpuSeconds = 0;
+
+    /** The peak resident set size at the end, in bytes.
+    */
+    std::size_t peakBytes = 0;
+
+    /** The growth of the peak resident set size, in bytes.
+    */
+    std::size_t peakDeltaBytes = 0;
+
+    /** The allocations of all threads.
+
+        This is zero unless allocations are
+        tracked.
+
+        @see isTrackingAllocations
+    */
+    AllocationCounts allocations;
+
+    /** The allocations of each thread, by thread index.
+
+        Threads which did not allocate during
+        the phase are left out.
+    */
+    std::vector<std::pair<std::size_t,
+        AllocationCounts>> threadAllocations;
+
+    /** The number of units of work, such as symbols or pages.
+
+        @see setPhaseUnits
+    */
+    std::size_t units = 0;
+
+    /** The name of a unit of work.
+    */
+    std::string unit;
+};
+
+/** Measure a phase of the program while in scope.
+
+    The measurements are kept for the report of
+    the process when the object is destroyed.
+    Phases may nest, and are reported in the
+    order in which they started. Phases should
+    only be started on the main thread.
+*/
+class ScopedPhase
+{
+    using clock_type = std::chrono::steady_clock;
+
+    std::size_t id_;
+    clock_type::time_point start_;
+    std::chrono::nanoseconds cpu_;
+    std::size_t peak_;
+    std::vector<AllocationCounts> allocs_;
+
+public:
+    explicit
+    ScopedPhase(
+        std::string_view name);
+
+    ~ScopedPhase();
+
+    ScopedPhase(ScopedPhase const&) = delete;
+    ScopedPhase& operator=(ScopedPhase const&) = delete;
+};
+
+/** Set the number of units of work done by a phase.
+
+    This is the last phase with the name, which
+    may have ended. The allocations per unit are
+    reported when allocations are tracked. When
+    there is no such phase, nothing is done.
+
+    @param unit The name of one unit, such
+    as "symbol" or "page".
+*/
+void
+setPhaseUnits(
+    std::string_view name,
+    std::size_t units,
+    std::string_view unit);
+
+/** Return the phases measured so far, and clear them.
+
+    Phases which have not ended are left out.
+*/
+std::vector<PhaseStats>
+takePhaseStats();
+
+/** Report the phases as a table.
+*/
+void
+reportPhaseStats(
+    std::vector<PhaseStats> const& phases);
+
+/** Write the phases to a file as JSON.
+
+    The file holds an object whose "phases" key
+    is an array with an object for each phase.
+    Times are in milliseconds and memory is in
+    bytes, so the values can be compared between
+    runs. When allocations are tracked, each
+    phase also has its allocations in total and
+    for each thread.
+*/
+Error
+writePhaseStats(
+    std::string_view path,
+    std::vector<PhaseStats> const& phases);
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,167 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/Progress.hpp"
+#include <mrdox/Support/unlock_guard.hpp>
+#include <llvm/Support/raw_ostream.h>
+#include <fmt/format.h>
+#include <algorithm>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+std::string
+formatDuration(double seconds)
+{
+    auto const s = static_cast<unsigned long long>(seconds + 0.5);
+    if(s >= 3600)
+        return fmt::format("{}h{:02}m", s / 3600, (s / 60) % 60);
+    if(s >= 60)
+        return fmt::format("{}m{:02}s", s / 60, s % 60);
+    return fmt::format("{}s", s);
+}
+
+} // (anon)
+
+Progress::
+Progress(
+    std::string_view phase,
+    std::size_t total,
+    bool enabled,
+    std::atomic<std::size_t> const* bytes,
+    std::function<void(std::size_t, std::size_t)> callback)
+    : phase_(phase)
+    , total_(total)
+    , bytes_(bytes)
+    , callback_(std::move(callback))
+    , start_(clock_type::now())
+    , enabled_(enabled)
+{
+    if(bytes_)
+        bytesStart_ = bytes_->load(std::memory_order_relaxed);
+    if(! enabled_ && ! callback_)
+        return;
+    if(enabled_)
+        tty_ = llvm::errs().is_displayed();
+    thread_ = std::thread([this]{ run(); });
+}
+
+Progress::
+~Progress()
+{
+    if(! thread_.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    stop_.notify_one();
+    thread_.join();
+
+    if(callback_)
+        callback_(count(), total_);
+    if(! enabled_)
+        return;
+    auto const line = format(true);
+    if(tty_)
+        llvm::errs() << '\r' << line << "\x1b[K\n";
+    else
+        llvm::errs() << line << '\n';
+    llvm::errs().flush();
+}
+
+void
+Progress::
+run()
+{
+    // a log file only needs an occasional line
+    auto const interval = tty_ || ! enabled_ ?
+        std::chrono::milliseconds(500) :
+        std::chrono::milliseconds(5000);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(! stop_.wait_for(lock, interval,
+        [&]{ return stopped_; }))
+    {
+        if(enabled_)
+            draw(format(false));
+        if(callback_)
+        {
+            // the callback does not hold up log
+            unlock_guard unlock(mutex_);
+            callback_(count(), total_);
+        }
+    }
+}
+
+std::string
+Progress::
+format(bool final)
+{
+    std::chrono::duration<double> const elapsed =
+        clock_type::now() - start_;
+    double const seconds = std::max(elapsed.count(), 1e-3);
+    std::size_t const done = count();
+    double const rate = done / seconds;
+
+    std::string line = phase_;
+    if(total_ != 0)
+        line += fmt::format(" {}/{} ({}%)", done, total_,
+            done * 100 / total_);
+    else
+        line += fmt::format(" {}", done);
+    line += fmt::format(", {:.1f}/s", rate);
+    if(bytes_)
+    {
+        auto const bytes = bytes_->load(
+            std::memory_order_relaxed) - bytesStart_;
+        line += fmt::format(", {:.1f} MB/s",
+            bytes / seconds / (1 << 20));
+    }
+    if(final)
+        line += ", " + formatDuration(seconds);
+    else if(total_ != 0 && done != 0 && done < total_)
+        line += ", " + formatDuration(
+            (total_ - done) / rate) + " left";
+    return line;
+}
+
+void
+Progress::
+draw(std::string const& line)
+{
+    if(tty_)
+    {
+        llvm::errs() << '\r' << line << "\x1b[K";
+        shown_ = true;
+    }
+    else
+    {
+        llvm::errs() << line << '\n';
+    }
+    llvm::errs().flush();
+}
+
+void
+Progress::
+log(llvm::Twine const& text)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(shown_)
+        llvm::errs() << "\r\x1b[K";
+    llvm::errs() << text << '\n';
+    if(shown_)
+        draw(format(false));
+    llvm::errs().flush();
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,126 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_PROGRESS_HPP
+#define MRDOX_TOOL_SUPPORT_PROGRESS_HPP
+
+#include <mrdox/Platform.hpp>
+#include <llvm/ADT/Twine.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace clang {
+namespace mrdox {
+
+/** The progress of one phase of work.
+
+    Work is counted with relaxed atomic additions,
+    so counting costs nothing on the hot path.
+    When enabled, a thread prints the count, the
+    rates, and the time remaining twice a second.
+    On a terminal the line is rewritten in place,
+    otherwise a line is printed every few seconds.
+    A final line is printed on destruction.
+    The count can also be given to a callback,
+    on the same thread and at the same times.
+
+    @par Thread Safety
+    All members may be called concurrently.
+*/
+class Progress
+{
+    using clock_type = std::chrono::steady_clock;
+
+    std::string phase_;
+    std::size_t total_;
+    std::atomic<std::size_t> done_ = 0;
+    std::atomic<std::size_t> const* bytes_;
+    std::function<void(std::size_t, std::size_t)> callback_;
+    std::size_t bytesStart_ = 0;
+    clock_type::time_point start_;
+    bool enabled_;
+    bool tty_ = false;
+    bool shown_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable stop_;
+    bool stopped_ = false;
+    std::thread thread_;
+
+    void run();
+    std::string format(bool final);
+    void draw(std::string const& line);
+
+public:
+    /** Constructor.
+
+        @param phase The name of the phase,
+        shown at the start of the line.
+
+        @param total The number of items of work,
+        or zero if it is not known. No time
+        remaining is shown without a total.
+
+        @param enabled `false` to count without
+        printing anything.
+
+        @param bytes A counter of the bytes
+        produced, whose rate is shown, or null.
+
+        @param callback A function called with
+        the count and the total, or empty.
+    */
+    Progress(
+        std::string_view phase,
+        std::size_t total,
+        bool enabled,
+        std::atomic<std::size_t> const* bytes = nullptr,
+        std::function<void(std::size_t done,
+            std::size_t total)> callback = {});
+
+    /** Destructor.
+
+        The final line is printed.
+    */
+    ~Progress();
+
+    /** Count finished items of work.
+    */
+    void
+    add(std::size_t n = 1) noexcept
+    {
+        done_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /** Return the number of finished items of work.
+    */
+    std::size_t
+    count() const noexcept
+    {
+        return done_.load(std::memory_order_relaxed);
+    }
+
+    /** Print a line of text above the progress line.
+    */
+    void
+    log(llvm::Twine const& text);
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -16,6 +16,10 @@
 #include <algorithm>
 #include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 namespace clang {
 namespace mrdox {
 
@@ -234,6 +238,15 @@ toBase64(std::string_view str)
     return dest;
 }
 
+std::string_view
+toBase64(
+    char* dest,
+    std::string_view str) noexcept
+{
+    return std::string_view(dest,
+        base64Encode(dest, str.data(), str.size()));
+}
+
 llvm::StringRef
 toBaseFN(
     llvm::SmallVectorImpl<char>& dest,
@@ -323,6 +336,51 @@ toBase32(
     return dest;
 }
 
+namespace detail {
+
+void
+encodeBase16(
+    char* dest,
+    std::uint8_t const* src,
+    std::size_t n,
+    bool lowercase) noexcept
+{
+    char const* digits = lowercase ?
+        "0123456789abcdef" : "0123456789ABCDEF";
+#if defined(__SSE2__) || defined(_M_X64)
+    // each nibble is a digit, plus the gap
+    // between '9' and 'A' when it is over 9
+    __m128i const mask = _mm_set1_epi8(0x0f);
+    __m128i const nine = _mm_set1_epi8(9);
+    __m128i const zero = _mm_set1_epi8('0');
+    __m128i const gap = _mm_set1_epi8(
+        static_cast<char>(digits[10] - '0' - 10));
+    auto const toDigits = [&](__m128i v)
+    {
+        return _mm_add_epi8(_mm_add_epi8(v, zero),
+            _mm_and_si128(_mm_cmpgt_epi8(v, nine), gap));
+    };
+    for(; n >= 16; n -= 16, src += 16, dest += 32)
+    {
+        __m128i const v = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(src));
+        __m128i const hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        __m128i const lo = _mm_and_si128(v, mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+            toDigits(_mm_unpacklo_epi8(hi, lo)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 16),
+            toDigits(_mm_unpackhi_epi8(hi, lo)));
+    }
+#endif
+    for(; n--; ++src)
+    {
+        *dest++ = digits[*src >> 4];
+        *dest++ = digits[*src & 0xf];
+    }
+}
+
+} // detail
+
 std::string
 toBase16(
     std::string_view str,
@@ -13,19 +13,55 @@
 #define MRDOX_TOOL_SUPPORT_RADIX_HPP
 
 #include <mrdox/Platform.hpp>
+#include <mrdox/Metadata/Symbols.hpp>
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/SmallString.h>
 #include <llvm/ADT/StringRef.h>
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 namespace clang {
 namespace mrdox {
 
+namespace detail {
+
+// Vectorized where the target allows
+void
+encodeBase16(
+    char* dest,
+    std::uint8_t const* src,
+    std::size_t n,
+    bool lowercase) noexcept;
+
+} // detail
+
 std::string
 toBase64(std::string_view str);
 
+/** Return the size of the base64 encoding of a number of octets.
+*/
+constexpr
+std::size_t
+toBase64Size(std::size_t n) noexcept
+{
+    return 4 * ((n + 2) / 3);
+}
+
+/** Encode octets as base64 into a buffer, without allocating.
+
+    The buffer must hold at least
+    `toBase64Size(str.size())` characters.
+
+    @return The encoded string, which
+    refers to the buffer.
+*/
+std::string_view
+toBase64(
+    char* dest,
+    std::string_view str) noexcept;
+
 llvm::StringRef
 toBaseFN(
     llvm::SmallVectorImpl<char>& dest,
@@ -41,6 +77,71 @@ toBase16(
     std::string_view str,
     bool lowercase = false);
 
+/** Encode a symbol ID as base16 into a buffer, without allocating.
+
+    @return The encoded string, which
+    refers to the buffer.
+*/
+constexpr
+std::string_view
+toBase16(
+    char (&dest)[40],
+    SymbolID const& id,
+    bool lowercase = false) noexcept
+{
+    static_assert(sizeof(dest) == 2 * SymbolID::zero.size());
+    if(std::is_constant_evaluated())
+    {
+        char const* digits = lowercase ?
+            "0123456789abcdef" : "0123456789ABCDEF";
+        char* out = dest;
+        for(std::uint8_t c : id)
+        {
+            *out++ = digits[c >> 4];
+            *out++ = digits[c & 0xf];
+        }
+    }
+    else
+    {
+        detail::encodeBase16(dest, id.data(), id.size(), lowercase);
+    }
+    return std::string_view(dest, sizeof(dest));
+}
+
+/** Encode a symbol ID as base64 into a buffer, without allocating.
+
+    The encoding is the same as that of
+    @ref toBase64, including the padding.
+
+    @return The encoded string, which
+    refers to the buffer.
+*/
+constexpr
+std::string_view
+toBase64(
+    char (&dest)[28],
+    SymbolID const& id) noexcept
+{
+    static_assert(sizeof(dest) == toBase64Size(SymbolID::zero.size()));
+    constexpr char const* tab =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::uint8_t const* in = id.data();
+    char* out = dest;
+    for(std::size_t n = id.size() / 3; n--; in += 3)
+    {
+        *out++ = tab[ (in[0] & 0xfc) >> 2];
+        *out++ = tab[((in[0] & 0x03) << 4) + ((in[1] & 0xf0) >> 4)];
+        *out++ = tab[((in[1] & 0x0f) << 2) + ((in[2] & 0xc0) >> 6)];
+        *out++ = tab[  in[2] & 0x3f];
+    }
+    // 20 bytes leave two over
+    *out++ = tab[ (in[0] & 0xfc) >> 2];
+    *out++ = tab[((in[0] & 0x03) << 4) + ((in[1] & 0xf0) >> 4)];
+    *out++ = tab[ (in[1] & 0x0f) << 2];
+    *out++ = '=';
+    return std::string_view(dest, sizeof(dest));
+}
+
 } // mrdox
 } // clang
 
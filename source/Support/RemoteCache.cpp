@@ -0,0 +1,455 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/RemoteCache.hpp"
+#include "Support/LocalSocket.hpp"
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/Base64.h>
+#include <llvm/Support/SHA256.h>
+#include <fmt/format.h>
+#include <chrono>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+// the path of the blob in the action result
+constexpr llvm::StringLiteral outputPath = "mrdox.tu";
+
+// a server which stops responding for
+// this long is considered to be down
+constexpr std::chrono::seconds timeout(30);
+
+std::string
+sha256Hex(
+    llvm::StringRef data)
+{
+    return llvm::toHex(llvm::SHA256::hash(
+        llvm::arrayRefFromStringRef(data)), true);
+}
+
+struct Digest
+{
+    std::string hash;
+    std::uint64_t size = 0;
+};
+
+//------------------------------------------------
+//
+// The subset of protocol buffers needed
+// for the action results.
+//
+//------------------------------------------------
+
+void
+writeVarint(
+    std::string& out,
+    std::uint64_t v)
+{
+    while(v >= 0x80)
+    {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void
+writeBytes(
+    std::string& out,
+    unsigned field,
+    llvm::StringRef bytes)
+{
+    writeVarint(out, (field << 3) | 2);
+    writeVarint(out, bytes.size());
+    out.append(bytes.data(), bytes.size());
+}
+
+/** Invoke a function with each field of a message.
+
+    Varints are passed as the value, and length
+    delimited fields as the bytes. Other fields
+    are skipped. Returns false if the message
+    is malformed.
+*/
+bool
+forEachField(
+    llvm::StringRef msg,
+    llvm::function_ref<void(unsigned field,
+        std::uint64_t value, llvm::StringRef bytes)> f)
+{
+    auto const varint = [&](std::uint64_t& v)
+    {
+        v = 0;
+        for(unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if(msg.empty())
+                return false;
+            auto const c = static_cast<unsigned char>(msg.front());
+            msg = msg.drop_front();
+            v |= std::uint64_t(c & 0x7f) << shift;
+            if(! (c & 0x80))
+                return true;
+        }
+        return false;
+    };
+    while(! msg.empty())
+    {
+        std::uint64_t tag;
+        if(! varint(tag))
+            return false;
+        auto const field = static_cast<unsigned>(tag >> 3);
+        std::uint64_t v = 0;
+        switch(tag & 7)
+        {
+        case 0:
+            if(! varint(v))
+                return false;
+            f(field, v, {});
+            break;
+        case 1:
+        case 5:
+        {
+            std::size_t const n = (tag & 7) == 1 ? 8 : 4;
+            if(msg.size() < n)
+                return false;
+            msg = msg.drop_front(n);
+            break;
+        }
+        case 2:
+            if(! varint(v) || msg.size() < v)
+                return false;
+            f(field, 0, msg.take_front(v));
+            msg = msg.drop_front(v);
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Return an ActionResult with one output file.
+*/
+std::string
+makeActionResult(
+    Digest const& digest)
+{
+    std::string d;
+    writeBytes(d, 1, digest.hash);
+    writeVarint(d, (2 << 3) | 0);
+    writeVarint(d, digest.size);
+
+    std::string file;
+    writeBytes(file, 1, outputPath);
+    writeBytes(file, 2, d);
+
+    std::string result;
+    writeBytes(result, 2, file);
+    return result;
+}
+
+std::optional<Digest>
+parseDigest(
+    llvm::StringRef msg)
+{
+    Digest digest;
+    if(! forEachField(msg,
+        [&](unsigned field, std::uint64_t v, llvm::StringRef bytes)
+        {
+            if(field == 1)
+                digest.hash = bytes.str();
+            else if(field == 2)
+                digest.size = v;
+        }))
+        return std::nullopt;
+    return digest;
+}
+
+/** Return the digest of the output file of an ActionResult.
+*/
+std::optional<Digest>
+parseActionResult(
+    llvm::StringRef msg)
+{
+    std::optional<Digest> result;
+    bool valid = true;
+    bool const ok = forEachField(msg,
+        [&](unsigned field, std::uint64_t, llvm::StringRef file)
+        {
+            // output_files
+            if(field != 2)
+                return;
+            llvm::StringRef path;
+            std::optional<Digest> digest;
+            if(! forEachField(file,
+                [&](unsigned field, std::uint64_t, llvm::StringRef bytes)
+                {
+                    if(field == 1)
+                        path = bytes;
+                    else if(field == 2)
+                        digest = parseDigest(bytes);
+                }))
+                valid = false;
+            if(path == outputPath && digest)
+                result = std::move(digest);
+        });
+    if(! ok || ! valid)
+        return std::nullopt;
+    return result;
+}
+
+} // (anon)
+
+//------------------------------------------------
+
+Expected<std::unique_ptr<RemoteCache>>
+RemoteCache::
+create(
+    std::string_view url,
+    bool upload)
+{
+    llvm::StringRef rest = url;
+    if(rest.starts_with("grpc://") || rest.starts_with("grpcs://"))
+        return formatError("remote cache \"{}\": gRPC is not supported, "
+            "use the HTTP protocol of the cache", url);
+    if(rest.starts_with("https://"))
+        return formatError("remote cache \"{}\": https is not supported, "
+            "use a local proxy", url);
+    if(! rest.consume_front("http://"))
+        return formatError("remote cache \"{}\" is not an http URL", url);
+
+    std::unique_ptr<RemoteCache> cache(new RemoteCache);
+    cache->url_ = url;
+    cache->upload_ = upload;
+
+    auto [authority, path] = rest.split('/');
+    if(auto const at = authority.rfind('@'); at != llvm::StringRef::npos)
+    {
+        cache->auth_ = "Basic " + llvm::encodeBase64(
+            authority.take_front(at));
+        authority = authority.drop_front(at + 1);
+    }
+    // an IPv6 address is in brackets
+    llvm::StringRef port;
+    if(authority.consume_front("["))
+    {
+        auto const end = authority.find(']');
+        if(end == llvm::StringRef::npos)
+            return formatError("remote cache \"{}\" has a bad host", url);
+        cache->host_ = authority.take_front(end).str();
+        port = authority.drop_front(end + 1);
+        if(! port.empty() && ! port.consume_front(":"))
+            return formatError("remote cache \"{}\" has a bad host", url);
+    }
+    else
+    {
+        auto const [host, p] = authority.split(':');
+        cache->host_ = host.str();
+        port = p;
+    }
+    if(cache->host_.empty())
+        return formatError("remote cache \"{}\" has no host", url);
+    if(! port.empty() && port.getAsInteger(10, cache->port_))
+        return formatError("remote cache \"{}\" has a bad port", url);
+    path = path.rtrim('/');
+    if(! path.empty())
+        cache->prefix_ = "/" + path.str();
+    return cache;
+}
+
+Expected<RemoteCache::Response>
+RemoteCache::
+request(
+    std::string_view method,
+    std::string_view target,
+    std::string_view body) const
+{
+    auto conn = LocalConnection::connectTcp(host_, port_, timeout);
+    if(! conn)
+        return conn.error();
+
+    std::string head = fmt::format(
+        "{} {}{} HTTP/1.1\r\n"
+        "Host: {}:{}\r\n",
+        method, prefix_, target, host_, port_);
+    if(! auth_.empty())
+        head += fmt::format("Authorization: {}\r\n", auth_);
+    head += fmt::format(
+        "Content-Length: {}\r\n"
+        "Connection: close\r\n"
+        "\r\n", body.size());
+    if(auto err = conn->write(head))
+        return err;
+    if(auto err = conn->write(body))
+        return err;
+
+    auto const bad = [&]
+    {
+        return formatError("{} {}{} returned a bad response",
+            method, prefix_, target);
+    };
+    auto line = conn->readLine();
+    if(! line)
+        return bad();
+    // HTTP/1.1 200 OK
+    Response res;
+    llvm::StringRef status = llvm::StringRef(*line).split(' ').second;
+    if(status.take_front(3).getAsInteger(10, res.status))
+        return bad();
+
+    std::optional<std::size_t> length;
+    bool chunked = false;
+    for(;;)
+    {
+        line = conn->readLine();
+        if(! line)
+            return bad();
+        if(line->empty())
+            break;
+        auto [name, value] = llvm::StringRef(*line).split(':');
+        value = value.trim();
+        if(name.equals_insensitive("content-length"))
+        {
+            std::size_t n;
+            if(value.getAsInteger(10, n))
+                return bad();
+            length = n;
+        }
+        else if(name.equals_insensitive("transfer-encoding"))
+        {
+            chunked = value.equals_insensitive("chunked");
+        }
+    }
+
+    if(chunked)
+    {
+        for(;;)
+        {
+            line = conn->readLine();
+            std::size_t n;
+            if(! line || llvm::StringRef(*line).split(';').first.
+                    trim().getAsInteger(16, n))
+                return bad();
+            if(n == 0)
+                break;
+            auto chunk = conn->read(n);
+            if(! chunk || ! conn->readLine())
+                return bad();
+            res.body += *chunk;
+        }
+    }
+    else if(length)
+    {
+        auto text = conn->read(*length);
+        if(! text)
+            return bad();
+        res.body = std::move(*text);
+    }
+    else
+    {
+        // the connection is closed after the body
+        res.body = conn->readAll();
+    }
+    return res;
+}
+
+void
+RemoteCache::
+fail(
+    Error const& err)
+{
+    if(! failed_.exchange(true))
+        reportWarning("The remote cache \"{}\" is not used: {}",
+            url_, err.message());
+}
+
+std::optional<std::string>
+RemoteCache::
+get(
+    llvm::StringRef key)
+{
+    if(failed_)
+        return std::nullopt;
+    auto const action = "/ac/" + sha256Hex(key);
+    auto ac = request("GET", action);
+    if(! ac)
+    {
+        fail(ac.error());
+        return std::nullopt;
+    }
+    if(ac->status != 200)
+    {
+        if(ac->status != 404)
+            fail(formatError("GET {} returned {}", action, ac->status));
+        ++misses_;
+        return std::nullopt;
+    }
+    auto digest = parseActionResult(ac->body);
+    if(! digest)
+    {
+        ++misses_;
+        return std::nullopt;
+    }
+
+    auto const blob = "/cas/" + digest->hash;
+    auto cas = request("GET", blob);
+    if(! cas)
+    {
+        fail(cas.error());
+        return std::nullopt;
+    }
+    // the blob can be evicted after its action
+    // result, and is only used if it is intact
+    if(cas->status != 200 ||
+        cas->body.size() != digest->size ||
+        sha256Hex(cas->body) != digest->hash)
+    {
+        if(cas->status != 200 && cas->status != 404)
+            fail(formatError("GET {} returned {}", blob, cas->status));
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    return std::move(cas->body);
+}
+
+void
+RemoteCache::
+put(
+    llvm::StringRef key,
+    llvm::StringRef value)
+{
+    if(! upload_ || failed_)
+        return;
+    Digest digest{ sha256Hex(value), value.size() };
+
+    // the blob is stored first, so an action
+    // result never names a missing blob
+    auto const blob = "/cas/" + digest.hash;
+    auto cas = request("PUT", blob, value);
+    if(! cas)
+        return fail(cas.error());
+    if(cas->status / 100 != 2)
+        return fail(formatError("PUT {} returned {}", blob, cas->status));
+
+    auto const action = "/ac/" + sha256Hex(key);
+    auto ac = request("PUT", action, makeActionResult(digest));
+    if(! ac)
+        return fail(ac.error());
+    if(ac->status / 100 != 2)
+        return fail(formatError("PUT {} returned {}", action, ac->status));
+    ++uploads_;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,114 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_REMOTECACHE_HPP
+#define MRDOX_TOOL_SUPPORT_REMOTECACHE_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringRef.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** A client of a remote content-addressed cache.
+
+    The client speaks the HTTP protocol of the
+    Bazel remote cache, so one server can be
+    shared by every machine. A value is stored
+    as a blob under `/cas/`, and its key maps to
+    the blob through an action result under
+    `/ac/` which lists the blob as its only
+    output file.
+
+    A failure is not an error of the caller.
+    The first one is reported as a warning, and
+    the cache is then unused for the rest of
+    the run.
+
+    @par Thread Safety
+    May be called concurrently.
+*/
+class RemoteCache
+{
+    struct Response
+    {
+        unsigned status = 0;
+        std::string body;
+    };
+
+    std::string url_;
+    std::string host_;
+    std::uint16_t port_ = 80;
+    std::string prefix_;
+    std::string auth_;
+    bool upload_ = true;
+    std::atomic<bool> failed_ = false;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+    std::atomic<std::size_t> uploads_ = 0;
+
+    RemoteCache() = default;
+
+    Expected<Response>
+    request(
+        std::string_view method,
+        std::string_view target,
+        std::string_view body = {}) const;
+
+    void
+    fail(
+        Error const& err);
+
+public:
+    /** Return a client for a cache.
+
+        @param url The URL of the cache, in the
+        form `http://[user:password@]host[:port][/prefix]`.
+        The credentials are sent with basic
+        authentication.
+
+        @param upload If `false`, values are
+        only read from the cache.
+    */
+    static
+    Expected<std::unique_ptr<RemoteCache>>
+    create(
+        std::string_view url,
+        bool upload);
+
+    /** Return the value for a key, if it is in the cache.
+    */
+    std::optional<std::string>
+    get(
+        llvm::StringRef key);
+
+    /** Store the value for a key.
+    */
+    void
+    put(
+        llvm::StringRef key,
+        llvm::StringRef value);
+
+    std::size_t hits() const noexcept { return hits_; }
+    std::size_t misses() const noexcept { return misses_; }
+    std::size_t uploads() const noexcept { return uploads_; }
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,82 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/RenderProfile.hpp"
+#include "Support/Debug.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <algorithm>
+
+namespace clang {
+namespace mrdox {
+
+void
+RenderProfile::
+enter(std::string_view name)
+{
+    // StringMap values do not move
+    auto& entry = entries_[name];
+    stack_.push_back({ &entry, clock_type::now() });
+}
+
+void
+RenderProfile::
+leave()
+{
+    MRDOX_ASSERT(! stack_.empty());
+    auto& frame = stack_.back();
+    auto const elapsed = clock_type::now() - frame.start;
+    ++frame.entry->count;
+    frame.entry->total += elapsed;
+    frame.entry->self += elapsed - frame.children;
+    stack_.pop_back();
+    if(! stack_.empty())
+        stack_.back().children += elapsed;
+}
+
+void
+RenderProfile::
+merge(RenderProfile const& other)
+{
+    for(auto const& e : other.entries_)
+    {
+        auto& entry = entries_[e.getKey()];
+        entry.count += e.getValue().count;
+        entry.total += e.getValue().total;
+        entry.self += e.getValue().self;
+    }
+}
+
+void
+RenderProfile::
+report() const
+{
+    using ms = std::chrono::duration<double, std::milli>;
+
+    std::vector<std::pair<std::string_view, Entry>> v;
+    v.reserve(entries_.size());
+    for(auto const& e : entries_)
+        v.emplace_back(e.getKey(), e.getValue());
+    std::sort(v.begin(), v.end(),
+        [](auto const& a, auto const& b)
+        {
+            return a.second.self > b.second.self;
+        });
+    reportInfo("{:>10} {:>12} {:>12}  {}",
+        "calls", "total ms", "self ms", "template");
+    for(auto const& [name, entry] : v)
+        reportInfo("{:>10} {:>12.3f} {:>12.3f}  {}",
+            entry.count,
+            ms(entry.total).count(),
+            ms(entry.self).count(),
+            name);
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,106 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_LIB_SUPPORT_RENDERPROFILE_HPP
+#define MRDOX_LIB_SUPPORT_RENDERPROFILE_HPP
+
+#include <llvm/ADT/StringMap.h>
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Call counts and times of templates and partials.
+
+    Calls are timed between @ref enter and
+    @ref leave, which nest. The total time of
+    a call includes the calls made inside it,
+    while its own time does not.
+
+    @par Thread Safety
+    Distinct objects may be used concurrently.
+*/
+class RenderProfile
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** The measurements of one name.
+    */
+    struct Entry
+    {
+        std::size_t count = 0;
+        clock_type::duration total{};
+        clock_type::duration self{};
+    };
+
+    /** Begin a call.
+    */
+    void enter(std::string_view name);
+
+    /** End the innermost call.
+    */
+    void leave();
+
+    /** Add the measurements of another profile.
+    */
+    void merge(RenderProfile const& other);
+
+    /** Report the entries, the most own time first.
+    */
+    void report() const;
+
+    /** Times a call for the lifetime of the object.
+
+        Nothing is timed when the profile is null.
+    */
+    class Scope
+    {
+        RenderProfile* profile_;
+
+    public:
+        Scope(
+            RenderProfile* profile,
+            std::string_view name)
+            : profile_(profile)
+        {
+            if(profile_)
+                profile_->enter(name);
+        }
+
+        ~Scope()
+        {
+            if(profile_)
+                profile_->leave();
+        }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+    };
+
+private:
+    struct Frame
+    {
+        Entry* entry;
+        clock_type::time_point start;
+        clock_type::duration children{};
+    };
+
+    llvm::StringMap<Entry> entries_;
+    std::vector<Frame> stack_;
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -8,16 +8,20 @@
 // Official repository: https://github.com/cppalliance/mrdox
 //
 
+#include "Support/PhaseReport.hpp"
 #include "Support/Radix.hpp"
 #include "Support/SafeNames.hpp"
 #include "Support/Validate.hpp"
 #include <mrdox/Corpus.hpp>
 #include <mrdox/Metadata.hpp>
 #include <mrdox/Platform.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/ADT/StringMap.h>
 #include <algorithm>
+#include <cstring>
+#include <mutex>
 
 namespace clang {
 namespace mrdox {
@@ -34,18 +38,39 @@ namespace {
 */
 class PrettyBuilder
 {
-    llvm::raw_ostream* os_ = nullptr;
-    std::string prefix_;
-    std::string temp_;
+    // the least number of members of a
+    // scope which is named by its own task
+    static constexpr std::size_t grain = 32;
+
+    using ScopeInfos = std::vector<Info const*>;
+    using Names = std::vector<
+        std::pair<SymbolID, std::string>>;
+
+    Corpus const& corpus_;
+    TaskGroup taskGroup_;
+    std::mutex mutex_;
+    std::vector<Names> results_;
 
 public:
+    llvm::StringMap<std::string> map;
+
     explicit
     PrettyBuilder(
         Corpus const& corpus)
         : corpus_(corpus)
+        , taskGroup_(corpus.config.threadPool())
     {
-        prefix_.reserve(512);
-        visit(corpus_.globalNamespace(), *this);
+        // each scope is independent once its
+        // prefix is known, so the scopes are
+        // named concurrently and merged here
+        buildScope(corpus_.globalNamespace(), std::string());
+        auto errors = taskGroup_.wait();
+        MRDOX_ASSERT(errors.empty());
+
+        for(auto& names : results_)
+            for(auto& [id, name] : names)
+                /* auto result =*/ map.try_emplace(
+                    llvm::StringRef(id), std::move(name));
         /* auto result =*/ map.try_emplace(
             llvm::StringRef(SymbolID::zero), std::string());
 
@@ -55,67 +80,37 @@ public:
     #endif
     }
 
-    PrettyBuilder(
-        llvm::raw_ostream& os,
-        Corpus const& corpus)
-        :
-        //os_(&os),
-        corpus_(corpus)
-    {
-        prefix_.reserve(512);
-        visit(corpus_.globalNamespace(), *this);
-        /* auto result =*/ map.try_emplace(
-            llvm::StringRef(SymbolID::zero), std::string());
-        if(os_)
-            *os_ << "\n\n";
-    }
-
-    llvm::StringMap<std::string> map;
-
-    using ScopeInfos = std::vector<Info const*>;
-
+private:
     ScopeInfos
-    buildScope(
-        NamespaceInfo const& I)
+    listScope(
+        Info const& I)
     {
         ScopeInfos infos;
-        infos.reserve(I.Members.size());
-        for(auto const& id : I.Members)
-            infos.emplace_back(corpus_.find(id));
-        // KRYSTIAN FIXME: include specializations
-        if(infos.size() < 2)
-            return infos;
-        std::string s0, s1;
-        llvm::sort(infos,
-            [&](Info const* I0, Info const* I1)
+        visit(I, [&]<class T>(T const& J)
+        {
+            // KRYSTIAN FIXME: include specializations and friends
+            if constexpr(
+                T::isNamespace() ||
+                T::isRecord())
             {
-                return compareSymbolNames(I0->Name, I1->Name) < 0;
-            });
-        return infos;
-    }
-
-    ScopeInfos
-    buildScope(
-        RecordInfo const& I)
-    {
-        ScopeInfos infos;
-        infos.reserve(I.Members.size());
-        for(auto const& id : I.Members)
-            infos.emplace_back(corpus_.find(id));
-        // KRYSTIAN FIXME: include specializations and friends
-        if(infos.size() < 2)
-            return infos;
-        std::string s0, s1;
-        llvm::sort(infos,
-            [&](Info const* I0, Info const* I1)
+                infos.reserve(J.Members.size());
+                for(auto const& id : J.Members)
+                    infos.emplace_back(corpus_.find(id));
+            }
+        });
+        sortBySymbolName(infos,
+            [](Info const* J)
             {
-                return compareSymbolNames(I0->Name, I1->Name) < 0;
+                return std::string_view(J->Name);
             });
         return infos;
     }
 
+    static
     llvm::StringRef
-    getSafe(Info const& I)
+    getSafe(
+        Info const& I,
+        std::string& temp)
     {
         if(I.Kind != InfoKind::Function)
             return I.Name;
@@ -124,32 +119,19 @@ public:
         auto OOK = FI.specs0.overloadedOperator.get();
         if(OOK == OperatorKind::None)
             return I.Name;
-        temp_ = '0';
-        temp_.append(getSafeOperatorName(OOK));
-        return temp_;
+        temp = '0';
+        temp.append(getSafeOperatorName(OOK));
+        return temp;
     }
 
-    void insertScope(ScopeInfos const& infos)
+    Names
+    nameScope(
+        ScopeInfos const& infos,
+        std::string const& prefix)
     {
-        if(os_)
-        {
-            std::string temp;
-            if( infos.size() > 0 &&
-                infos.front()->Namespace.size() > 0)
-            {
-                auto const& P = corpus_.get<Info>(infos.front()->Namespace[0]);
-                corpus_.getFullyQualifiedName(P, temp);
-                temp.push_back(' ');
-            }
-            *os_ <<
-                "------------------------\n" <<
-                "Scope " << temp <<
-                "with " << infos.size() << " names:\n\n";
-            for(auto const& I : infos)
-                *os_ << I->Name << '\n';
-            *os_ << '\n';
-        }
-
+        Names names;
+        names.reserve(infos.size());
+        std::string temp;
         auto it0 = infos.begin();
         while(it0 != infos.end())
         {
@@ -166,13 +148,9 @@ public:
             {
                 // unique
                 std::string s;
-                s.assign(prefix_);
-                s.append(getSafe(**it0));
-                if(os_)
-                    *os_ << getSafe(**it0) << "\n";
-                /*auto result =*/ map.try_emplace(
-                    llvm::StringRef((*it0)->id),
-                    std::move(s));
+                s.assign(prefix);
+                s.append(getSafe(**it0, temp));
+                names.emplace_back((*it0)->id, std::move(s));
                 it0 = it;
                 continue;
             }
@@ -180,54 +158,59 @@ public:
             for(std::size_t i = 0; i < n; ++i)
             {
                 std::string s;
-                s.assign(prefix_);
-                std::string suffix;
-                suffix = std::to_string(i + 1);
-                //s.push_back('@');
-                suffix.append(getSafe(**it0));
-                if(os_)
-                    *os_ << suffix << "\n";
-                s.append(suffix);
-                /*auto result =*/ map.try_emplace(
-                    llvm::StringRef(it0[i]->id),
-                    std::move(s));
+                s.assign(prefix);
+                s.append(std::to_string(i + 1));
+                s.append(getSafe(**it0, temp));
+                names.emplace_back(it0[i]->id, std::move(s));
             }
             it0 = it;
         }
+        return names;
     }
 
-    void visitInfos(ScopeInfos const& infos)
+    void
+    buildScope(
+        Info const& I,
+        std::string const& prefix)
     {
-        auto const n0 = prefix_.size();
-        for(auto const I : infos)
+        auto const infos = listScope(I);
+        if(infos.empty())
+            return;
         {
-            prefix_.append(getSafe(*I));
-            prefix_.push_back('-');
-            ::clang::mrdox::visit(*I, *this);
-            prefix_.resize(n0);
+            auto names = nameScope(infos, prefix);
+            std::lock_guard<std::mutex> lock(mutex_);
+            results_.emplace_back(std::move(names));
         }
-    }
-
-    //--------------------------------------------
 
-    template<class T>
-    void operator()(T const& I)
-    {
-        if constexpr(
-            T::isNamespace() ||
-            T::isRecord())
-        {
-            auto infos = buildScope(I);
-            insertScope(infos);
-            visitInfos(infos);
-        }
-        else
+        std::string temp;
+        for(Info const* J : infos)
         {
+            if( J->Kind != InfoKind::Namespace &&
+                J->Kind != InfoKind::Record)
+                continue;
+            std::string childPrefix(prefix);
+            childPrefix.append(getSafe(*J, temp));
+            childPrefix.push_back('-');
+            std::size_t members = 0;
+            visit(*J, [&]<class T>(T const& K)
+            {
+                if constexpr(
+                    T::isNamespace() ||
+                    T::isRecord())
+                    members = K.Members.size();
+            });
+            if(members < grain)
+            {
+                buildScope(*J, childPrefix);
+                continue;
+            }
+            taskGroup_.async(
+                [this, J, childPrefix = std::move(childPrefix)]
+                {
+                    buildScope(*J, childPrefix);
+                });
         }
     }
-
-private:
-    Corpus const& corpus_;
 };
 
 //------------------------------------------------
@@ -235,35 +218,87 @@ private:
 // Always works but isn't the prettiest...
 class UglyBuilder
 {
-    Corpus const& corpus_;
+    char hex_[40];
 
 public:
-    llvm::StringMap<std::string> map;
+    std::string_view
+    get(SymbolID const& id) noexcept
+    {
+        return toBase16(hex_, id, true);
+    }
+};
 
+// Use the names of a PrettyBuilder
+class MapBuilder
+{
+    llvm::StringMap<std::string> map_;
+
+public:
     explicit
-    UglyBuilder(
-        Corpus const& corpus)
-        : corpus_(corpus)
+    MapBuilder(
+        llvm::StringMap<std::string> map) noexcept
+        : map_(std::move(map))
+    {
+    }
+
+    std::string_view
+    get(SymbolID const& id) const noexcept
     {
-        llvm::SmallString<64> temp;
-        for(Info const* I : corpus_.index())
-            map.try_emplace(
-                llvm::StringRef(I->id),
-                toBase16(I->id, true));
+        return map_.lookup(llvm::StringRef(id));
     }
 };
 
+// The symbol IDs are hashes already
+std::size_t
+hashID(SymbolID const& id) noexcept
+{
+    std::size_t h;
+    std::memcpy(&h, id.data(), sizeof(h));
+    return h;
+}
+
 } // (anon)
 
 //------------------------------------------------
 
+template<class Builder>
+void
+SafeNames::
+build(Builder& builder)
+{
+    // only the IDs are needed, so the
+    // Info of each symbol is not read
+    auto const& ids = corpus_.headers().id;
+    offsets_.reserve(ids.size() + 1);
+    text_.reserve(ids.size() * 41);
+    for(SymbolID const& id : ids)
+    {
+        offsets_.push_back(static_cast<std::uint32_t>(text_.size()));
+        text_.append(builder.get(id));
+        text_.push_back('\0');
+    }
+    offsets_.push_back(static_cast<std::uint32_t>(text_.size()));
+
+    // at most half full, so probes are short
+    std::size_t size = 16;
+    while(size < 2 * ids.size())
+        size *= 2;
+    slots_.assign(size, Slot{ SymbolID::zero, 0 });
+    std::size_t const mask = size - 1;
+    for(std::size_t n = 0; n < ids.size(); ++n)
+    {
+        std::size_t i = hashID(ids[n]) & mask;
+        while(slots_[i].id != SymbolID::zero)
+            i = (i + 1) & mask;
+        slots_[i] = { ids[n], static_cast<std::uint32_t>(n) };
+    }
+}
+
 SafeNames::
 SafeNames(
     llvm::raw_ostream& os,
     Corpus const& corpus)
-    : corpus_(corpus)
-    //, map_(PrettyBuilder(corpus).map)
-    , map_(UglyBuilder(corpus).map)
+    : SafeNames(corpus)
 {
 }
 
@@ -271,9 +306,11 @@ SafeNames::
 SafeNames(
     Corpus const& corpus)
     : corpus_(corpus)
-    //, map_(PrettyBuilder(corpus).map)
-    , map_(UglyBuilder(corpus).map)
 {
+    ScopedPhase phase("safe names");
+    //MapBuilder builder(PrettyBuilder(corpus).map);
+    UglyBuilder builder;
+    build(builder);
 }
 
 llvm::StringRef
@@ -281,9 +318,23 @@ SafeNames::
 get(
     SymbolID const &id) const noexcept
 {
-    auto const it = map_.find(llvm::StringRef(id));
-    MRDOX_ASSERT(it != map_.end());
-    return it->getValue();
+    if(id == SymbolID::zero)
+        return {};
+    std::size_t const mask = slots_.size() - 1;
+    for(std::size_t i = hashID(id) & mask;; i = (i + 1) & mask)
+    {
+        Slot const& slot = slots_[i];
+        // an empty slot ends the probe, so an
+        // ID which is not in the table has no name
+        if(slot.id == SymbolID::zero)
+            return {};
+        if(slot.id != id)
+            continue;
+        auto const first = offsets_[slot.index];
+        // the name is followed by a null
+        return llvm::StringRef(text_.data() + first,
+            offsets_[slot.index + 1] - first - 1);
+    }
 }
 
 std::vector<llvm::StringRef>&
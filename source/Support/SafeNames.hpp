@@ -13,10 +13,13 @@
 
 #include <mrdox/Platform.hpp>
 #include <mrdox/MetadataFwd.hpp>
+#include <mrdox/Metadata/Symbols.hpp>
 #include <llvm/ADT/SmallString.h>
-#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
 #include <llvm/Support/raw_ostream.h>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
@@ -29,16 +32,32 @@ namespace mrdox {
     filenames this includes only the subset of
     characters valid for Windows, OSX, and Linux
     type filesystems.
+
+    The names are kept in a single buffer, in
+    the order of the corpus index, and an open
+    addressed table maps each symbol ID to its
+    position in the index.
 */
 class SafeNames
 {
+    struct Slot
+    {
+        SymbolID id;
+        std::uint32_t index;
+    };
+
     Corpus const& corpus_;
-    llvm::StringMap<std::string> map_;
+    std::string text_;
+    std::vector<std::uint32_t> offsets_;
+    std::vector<Slot> slots_;
 
     SafeNames(
         llvm::raw_ostream& os,
         Corpus const&);
 
+    template<class Builder>
+    void build(Builder& builder);
+
 public:
     /** Constructor.
 
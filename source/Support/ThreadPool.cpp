@@ -11,21 +11,523 @@
 #include "Support/Debug.hpp"
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/ThreadPool.hpp>
-#include <llvm/Support/Signals.h>
-#include <llvm/Support/ThreadPool.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace clang {
 namespace mrdox {
 
+namespace {
+
+/** The state shared by the work of a task group.
+*/
+struct Group
+{
+    // the most distinct errors kept by a group
+    static constexpr std::size_t maxErrors = 256;
+
+    /** The errors thrown on one worker.
+
+        Only the worker touches its slot while work
+        is pending, so no lock is needed. The slots
+        are apart to keep workers from sharing lines.
+    */
+    struct alignas(64) Errors
+    {
+        std::unordered_set<Error> errors;
+        std::size_t dropped = 0;
+    };
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::atomic<std::size_t> pending = 0;
+    std::unique_ptr<Errors[]> slots;
+    std::size_t numSlots;
+
+    explicit
+    Group(
+        std::size_t numWorkers)
+        : slots(std::make_unique<Errors[]>(numWorkers))
+        , numSlots(numWorkers)
+    {
+    }
+
+    void
+    fail(
+        std::size_t worker,
+        Error const& err)
+    {
+        auto& slot = slots[worker];
+        if(slot.errors.size() < maxErrors)
+            slot.errors.emplace(err);
+        else if(! slot.errors.contains(err))
+            ++slot.dropped;
+    }
+
+    /** Return the distinct errors, and clear them.
+
+        This is called once no work is pending.
+    */
+    std::vector<Error>
+    takeErrors()
+    {
+        std::unordered_set<Error> seen;
+        std::vector<Error> errors;
+        std::size_t dropped = 0;
+        for(std::size_t i = 0; i < numSlots; ++i)
+        {
+            auto& slot = slots[i];
+            for(auto const& err : slot.errors)
+            {
+                if(seen.contains(err))
+                    continue;
+                if(errors.size() >= maxErrors)
+                {
+                    ++dropped;
+                    continue;
+                }
+                seen.emplace(err);
+                errors.emplace_back(err);
+            }
+            dropped += slot.dropped;
+            slot.errors.clear();
+            slot.dropped = 0;
+        }
+        // the dropped errors may repeat the
+        // kept ones, so they are not counted
+        if(dropped > 0)
+            errors.emplace_back(formatError(
+                "only the first {} distinct errors were kept", maxErrors));
+        return errors;
+    }
+
+    void
+    finish()
+    {
+        // the waiter checks pending under the lock
+        // before the group is destroyed, so the
+        // group is not used after the unlock
+        std::lock_guard<std::mutex> lock(mutex);
+        if(--pending == 0)
+            done.notify_all();
+    }
+};
+
+/** Submitted work, and the group it belongs to.
+*/
+struct Task
+{
+    any_callable<void(void)> f;
+    Group* group;
+};
+
+#ifdef __linux__
+
+/** Return the processors in a list such as "0-3,8,10-11".
+*/
+std::vector<unsigned>
+parseCpuList(
+    std::string const& list)
+{
+    std::vector<unsigned> cpus;
+    std::size_t pos = 0;
+    while(pos < list.size())
+    {
+        std::size_t end = list.find(',', pos);
+        if(end == std::string::npos)
+            end = list.size();
+        auto const range = list.substr(pos, end - pos);
+        std::size_t const dash = range.find('-');
+        unsigned first = 0;
+        unsigned last = 0;
+        try
+        {
+            first = std::stoul(range.substr(0, dash));
+            last = dash == std::string::npos ?
+                first : std::stoul(range.substr(dash + 1));
+        }
+        catch(std::exception const&)
+        {
+            return {};
+        }
+        for(unsigned cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+#endif
+
+/** Return the processors of each NUMA node.
+
+    Processors which the process may not use
+    are left out, as are nodes left without
+    any. Nothing is returned when there are
+    fewer than two nodes, or on platforms where
+    the nodes are not known.
+*/
+std::vector<std::vector<unsigned>>
+getNumaNodes()
+{
+    std::vector<std::vector<unsigned>> nodes;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return nodes;
+    std::string online;
+    {
+        std::ifstream in("/sys/devices/system/node/online");
+        if(! std::getline(in, online))
+            return nodes;
+    }
+    for(unsigned node : parseCpuList(online))
+    {
+        std::ifstream in("/sys/devices/system/node/node" +
+            std::to_string(node) + "/cpulist");
+        std::string list;
+        if(! std::getline(in, list))
+            continue;
+        std::vector<unsigned> cpus;
+        for(unsigned cpu : parseCpuList(list))
+            if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        if(! cpus.empty())
+            nodes.emplace_back(std::move(cpus));
+    }
+    if(nodes.size() < 2)
+        nodes.clear();
+#endif
+    return nodes;
+}
+
+/** Restrict the calling thread to a set of processors.
+*/
+void
+setThreadAffinity(
+    std::vector<unsigned> const& cpus)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(unsigned cpu : cpus)
+        CPU_SET(cpu, &set);
+    // placement is only a hint, so failure is ignored
+    (void)pthread_setaffinity_np(
+        pthread_self(), sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+} // (anon)
+
 //------------------------------------------------
 //
 // ThreadPool
 //
 //------------------------------------------------
 
+struct ThreadPool::
+    Impl
+{
+    // one queue for each priority
+    static constexpr std::size_t numLanes = 3;
+
+    struct Worker
+    {
+        Impl* pool;
+        std::size_t index;
+        unsigned node;
+        std::mutex mutex;
+        std::array<std::deque<Task>, numLanes> lanes;
+        std::thread thread;
+    };
+
+    // the worker running on this thread, if any
+    static thread_local Worker* current;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // the workers and the processors of each node
+    std::vector<std::vector<Worker*>> nodes;
+    std::vector<std::vector<unsigned>> nodeCpus;
+
+    std::array<std::atomic<std::size_t>, numLanes> queuedAt{};
+    std::atomic<std::size_t> queued = 0;
+    std::atomic<std::size_t> unfinished = 0;
+    std::atomic<std::size_t> sleepers = 0;
+    std::atomic<std::size_t> next = 0;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stop = false;
+
+    Impl(
+        unsigned concurrency,
+        bool numa)
+    {
+        if(concurrency == 0)
+            concurrency = std::max(1u,
+                std::thread::hardware_concurrency());
+        if(numa)
+            nodeCpus = getNumaNodes();
+        // every node has at least one worker
+        if(nodeCpus.size() > concurrency)
+            nodeCpus.resize(concurrency);
+        if(nodeCpus.size() < 2)
+            nodeCpus.clear();
+        nodes.resize(std::max<std::size_t>(nodeCpus.size(), 1));
+        workers.reserve(concurrency);
+        for(unsigned i = 0; i < concurrency; ++i)
+        {
+            auto& w = workers.emplace_back(
+                std::make_unique<Worker>());
+            w->pool = this;
+            w->index = i;
+            w->node = i % nodes.size();
+            nodes[w->node].push_back(w.get());
+        }
+        // every queue exists before any thread steals
+        for(auto& w : workers)
+            w->thread = std::thread(
+                [this, w = w.get()]
+                {
+                    run(*w);
+                });
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for(auto& w : workers)
+            w->thread.join();
+    }
+
+    /** Return the worker of this pool running on this thread.
+    */
+    Worker*
+    self() const noexcept
+    {
+        if(current && current->pool == this)
+            return current;
+        return nullptr;
+    }
+
+    /** Submit work.
+
+        Work from outside the pool is spread over
+        the queues, and work from a worker stays
+        with that worker while it is busy. Work for
+        a node stays on that node.
+    */
+    void
+    push(
+        Task task,
+        Priority priority,
+        std::optional<unsigned> node = std::nullopt)
+    {
+        ++unfinished;
+
+        Worker* w = self();
+        if(node)
+        {
+            unsigned const n = *node % nodes.size();
+            if(! w || w->node != n)
+                w = nodes[n][next++ % nodes[n].size()];
+        }
+        else if(! w)
+        {
+            w = workers[next++ % workers.size()].get();
+        }
+        auto const lane = static_cast<std::size_t>(priority);
+        {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->lanes[lane].emplace_back(std::move(task));
+            ++queuedAt[lane];
+            ++queued;
+        }
+
+        // a sleeper counts itself before checking
+        // queued, so one of the two sees the other
+        if(sleepers.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            wake.notify_one();
+        }
+    }
+
+    /** Take work from the own queue, or steal from another.
+
+        Work of a higher priority is taken first,
+        from any worker. Among work of the same
+        priority, workers of the same node are
+        tried first.
+    */
+    std::optional<Task>
+    pop(Worker& w)
+    {
+        std::optional<Task> task;
+        for(std::size_t lane = numLanes; lane-- > 0;)
+        {
+            if(queuedAt[lane].load() == 0)
+                continue;
+            auto const take = [&](Worker& v, bool newest)
+            {
+                std::lock_guard<std::mutex> lock(v.mutex);
+                auto& tasks = v.lanes[lane];
+                if(tasks.empty())
+                    return false;
+                if(newest)
+                {
+                    task.emplace(std::move(tasks.back()));
+                    tasks.pop_back();
+                }
+                else
+                {
+                    task.emplace(std::move(tasks.front()));
+                    tasks.pop_front();
+                }
+                --queuedAt[lane];
+                --queued;
+                return true;
+            };
+            if(take(w, true))
+                return task;
+            auto const& local = nodes[w.node];
+            for(std::size_t i = 1; i < local.size(); ++i)
+                if(take(*local[(w.index / nodes.size() + i) % local.size()], false))
+                    return task;
+            if(nodes.size() == 1)
+                continue;
+            std::size_t const n = workers.size();
+            for(std::size_t i = 1; i < n; ++i)
+            {
+                Worker& v = *workers[(w.index + i) % n];
+                if(v.node != w.node && take(v, false))
+                    return task;
+            }
+        }
+        return task;
+    }
+
+    void
+    invoke(
+        Worker& w,
+        Task& task)
+    {
+        try
+        {
+            task.f();
+        }
+        catch(Exception const& ex)
+        {
+            if(! task.group)
+                reportUnhandledException(ex);
+            task.group->fail(w.index, ex.error());
+        }
+        catch(std::exception const& ex)
+        {
+            // Any exception which is not
+            // derived from Error should
+            // be reported and terminate
+            // the process immediately.
+            reportUnhandledException(ex);
+        }
+        if(task.group)
+            task.group->finish();
+        if(--unfinished == 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.notify_all();
+        }
+    }
+
+    void
+    run(Worker& w)
+    {
+        current = &w;
+        if(! nodeCpus.empty())
+            setThreadAffinity(nodeCpus[w.node]);
+        for(;;)
+        {
+            if(auto task = pop(w))
+            {
+                invoke(w, *task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            ++sleepers;
+            wake.wait(lock,
+                [&]
+                {
+                    return stop || queued.load() > 0;
+                });
+            --sleepers;
+            if(stop && queued.load() == 0)
+                break;
+        }
+        current = nullptr;
+    }
+
+    void
+    wait(Group& group)
+    {
+        // a worker which waits runs other work,
+        // or else nested groups would deadlock
+        if(Worker* w = self())
+        {
+            while(group.pending.load() != 0)
+            {
+                if(auto task = pop(*w))
+                {
+                    invoke(*w, *task);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(group.mutex);
+                group.done.wait_for(lock,
+                    std::chrono::milliseconds(1),
+                    [&]
+                    {
+                        return group.pending.load() == 0;
+                    });
+            }
+        }
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.done.wait(lock,
+            [&]
+            {
+                return group.pending.load() == 0;
+            });
+    }
+};
+
+thread_local ThreadPool::Impl::Worker*
+ThreadPool::Impl::current = nullptr;
+
 ThreadPool::
 ~ThreadPool()
 {
@@ -36,34 +538,47 @@ ThreadPool() = default;
 
 ThreadPool::
 ThreadPool(
-    unsigned concurrency)
+    unsigned concurrency,
+    bool numa)
 {
-    reset(concurrency);
+    reset(concurrency, numa);
 }
 
 void
 ThreadPool::
 reset(
-    unsigned concurrency)
+    unsigned concurrency,
+    bool numa)
 {
-    llvm::ThreadPoolStrategy S;
-    S.ThreadsRequested = concurrency;
-    S.Limit = true;
-    impl_ = std::make_unique<llvm::ThreadPool>(S);
+    // the old threads finish their work first
+    impl_.reset();
+    impl_ = std::make_unique<Impl>(concurrency, numa);
 }
 
 unsigned
 ThreadPool::
 getThreadCount() const noexcept
 {
-    return impl_->getThreadCount();
+    return static_cast<unsigned>(impl_->workers.size());
+}
+
+unsigned
+ThreadPool::
+getNodeCount() const noexcept
+{
+    return static_cast<unsigned>(impl_->nodes.size());
 }
 
 void
 ThreadPool::
 wait()
 {
-    impl_->wait();
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    impl_->idle.wait(lock,
+        [&]
+        {
+            return impl_->unfinished.load() == 0;
+        });
 }
 
 void
@@ -71,24 +586,25 @@ ThreadPool::
 post(
     any_callable<void(void)> f)
 {
-    auto sp = std::make_shared<
-        any_callable<void(void)>>(std::move(f));
-    impl_->async(
-    [sp]
-    {
-        try
-        {
-            (*sp)();
-        }
-        catch(std::exception const& ex)
-        {
-            // Any exception which is not
-            // derived from Error should
-            // be reported and terminate
-            // the process immediately.
-            reportUnhandledException(ex);
-        }
-    });
+    impl_->push(Task{std::move(f), nullptr}, Priority::Normal);
+}
+
+void
+ThreadPool::
+post(
+    unsigned node,
+    any_callable<void(void)> f)
+{
+    impl_->push(Task{std::move(f), nullptr}, Priority::Normal, node);
+}
+
+void
+ThreadPool::
+post(
+    Priority priority,
+    any_callable<void(void)> f)
+{
+    impl_->push(Task{std::move(f), nullptr}, priority);
 }
 
 //------------------------------------------------
@@ -98,30 +614,32 @@ post(
 //------------------------------------------------
 
 struct TaskGroup::
-    Impl
+    Impl : Group
 {
-    std::mutex mutex;
-    std::unordered_set<Error> errors;
-    llvm::ThreadPoolTaskGroup taskGroup;
+    ThreadPool::Impl& pool;
+    ThreadPool::Priority priority;
 
-    explicit
     Impl(
-        llvm::ThreadPool& threadPool)
-        : taskGroup(threadPool)
+        ThreadPool::Impl& pool_,
+        ThreadPool::Priority priority_)
+        : Group(pool_.workers.size())
+        , pool(pool_)
+        , priority(priority_)
     {
     }
 };
 
-
 TaskGroup::
 ~TaskGroup()
 {
+    impl_->pool.wait(*impl_);
 }
 
 TaskGroup::
 TaskGroup(
-    ThreadPool& threadPool)
-    : impl_(std::make_unique<Impl>(*threadPool.impl_))
+    ThreadPool& threadPool,
+    ThreadPool::Priority priority)
+    : impl_(std::make_unique<Impl>(*threadPool.impl_, priority))
 {
 }
 
@@ -129,22 +647,14 @@ std::vector<Error>
 TaskGroup::
 wait()
 {
-    impl_->taskGroup.wait();
+    impl_->pool.wait(*impl_);
 
     // VFALCO We could have a small data race here
     // where another thread posts work after the
     // wait is satisfied, but that could be
     // considered user error.
     //
-    // In theory the lock should not be needed.
-    //
-    std::lock_guard<std::mutex> lock(impl_->mutex);
-    std::vector<Error> errors;
-    errors.reserve(impl_->errors.size());
-    for(auto& err : impl_->errors)
-        errors.emplace_back(std::move(err));
-    impl_->errors.clear();
-    return errors;
+    return impl_->takeErrors();
 }
 
 void
@@ -152,29 +662,20 @@ TaskGroup::
 post(
     any_callable<void(void)> f)
 {
-    auto sp = std::make_shared<
-        any_callable<void(void)>>(std::move(f));
-    impl_->taskGroup.async(
-    [&, sp]
-    {
-        try
-        {
-            (*sp)();
-        }
-        catch(Exception const& ex)
-        {
-            std::lock_guard<std::mutex> lock(impl_->mutex);
-            impl_->errors.emplace(ex.error());
-        }
-        catch(std::exception const& ex)
-        {
-            // Any exception which is not
-            // derived from Error should
-            // be reported and terminate
-            // the process immediately.
-            reportUnhandledException(ex);
-        }
-    });
+    ++impl_->pending;
+    impl_->pool.push(Task{std::move(f), impl_.get()},
+        impl_->priority);
+}
+
+void
+TaskGroup::
+post(
+    unsigned node,
+    any_callable<void(void)> f)
+{
+    ++impl_->pending;
+    impl_->pool.push(Task{std::move(f), impl_.get()},
+        impl_->priority, node);
 }
 
 } // mrdox
@@ -0,0 +1,263 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Support/Trace.hpp"
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(MRDOX_PROFILER_TRACY)
+#include <tracy/TracyC.h>
+#elif defined(MRDOX_PROFILER_ITT)
+#include <ittnotify.h>
+#include <llvm/ADT/DenseMap.h>
+#endif
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct Event
+{
+    char const* name;
+    std::string detail;
+    clock_type::time_point start;
+    clock_type::time_point end;
+};
+
+struct Buffer
+{
+    std::uint64_t tid;
+    std::vector<Event> events;
+};
+
+std::atomic<bool> tracing = false;
+clock_type::time_point origin;
+
+// The buffers outlive their threads,
+// which only append to their own.
+std::mutex bufferMutex;
+std::vector<std::unique_ptr<Buffer>> buffers;
+thread_local Buffer* currentBuffer = nullptr;
+
+Buffer&
+getBuffer()
+{
+    if(! currentBuffer)
+    {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->tid = llvm::get_threadid();
+        currentBuffer = buffer.get();
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        buffers.emplace_back(std::move(buffer));
+    }
+    return *currentBuffer;
+}
+
+double
+toMicroseconds(clock_type::duration d)
+{
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+} // (anon)
+
+void
+startTrace()
+{
+    origin = clock_type::now();
+    tracing.store(true, std::memory_order_release);
+}
+
+bool
+isTracing() noexcept
+{
+    return tracing.load(std::memory_order_acquire);
+}
+
+Error
+writeTrace(
+    std::string_view path)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    llvm::json::OStream J(os);
+    J.object([&]
+    {
+        J.attribute("displayTimeUnit", "ms");
+        J.attributeArray("traceEvents", [&]
+        {
+            for(auto const& buffer : buffers)
+            {
+                for(auto const& e : buffer->events)
+                {
+                    J.object([&]
+                    {
+                        J.attribute("name", e.name);
+                        J.attribute("ph", "X");
+                        J.attribute("pid", 1);
+                        J.attribute("tid",
+                            static_cast<std::int64_t>(buffer->tid));
+                        J.attribute("ts", toMicroseconds(e.start - origin));
+                        J.attribute("dur", toMicroseconds(e.end - e.start));
+                        if(! e.detail.empty())
+                            J.attributeObject("args", [&]
+                            {
+                                J.attribute("detail", e.detail);
+                            });
+                    });
+                }
+            }
+        });
+    });
+    os << '\n';
+    os.close();
+    if(os.has_error())
+        return formatError("could not write \"{}\": {}",
+            path, os.error().message());
+    return Error::success();
+}
+
+TraceScope::
+TraceScope(
+    char const* name) noexcept
+    : name_(name)
+    , active_(isTracing())
+{
+    if(active_)
+        start_ = clock_type::now();
+}
+
+TraceScope::
+TraceScope(
+    char const* name,
+    std::string_view detail)
+    : TraceScope(name)
+{
+    if(active_)
+        detail_ = detail;
+}
+
+TraceScope::
+~TraceScope()
+{
+    if(! active_)
+        return;
+    auto const end = clock_type::now();
+    getBuffer().events.push_back(
+        { name_, std::move(detail_), start_, end });
+}
+
+//------------------------------------------------
+
+#if defined(MRDOX_PROFILER_TRACY)
+
+static_assert(sizeof(ProfileSite) ==
+    sizeof(___tracy_source_location_data));
+static_assert(sizeof(TracyCZoneCtx) <= sizeof(void*));
+
+ProfileZone::
+ProfileZone(
+    ProfileSite const& site) noexcept
+{
+    TracyCZoneCtx ctx = ___tracy_emit_zone_begin(
+        reinterpret_cast<___tracy_source_location_data const*>(&site), 1);
+    std::memcpy(&ctx_, &ctx, sizeof(ctx));
+}
+
+ProfileZone::
+ProfileZone(
+    ProfileSite const& site,
+    std::string_view text) noexcept
+    : ProfileZone(site)
+{
+    TracyCZoneCtx ctx;
+    std::memcpy(&ctx, &ctx_, sizeof(ctx));
+    ___tracy_emit_zone_text(ctx, text.data(), text.size());
+}
+
+ProfileZone::
+~ProfileZone()
+{
+    TracyCZoneCtx ctx;
+    std::memcpy(&ctx, &ctx_, sizeof(ctx));
+    ___tracy_emit_zone_end(ctx);
+}
+
+#elif defined(MRDOX_PROFILER_ITT)
+
+namespace {
+
+__itt_domain*
+ittDomain() noexcept
+{
+    static __itt_domain* const domain = __itt_domain_create("mrdox");
+    return domain;
+}
+
+// the handles are created once per thread and
+// site, since creating one takes a global lock
+__itt_string_handle*
+ittHandle(
+    char const* name)
+{
+    thread_local llvm::DenseMap<char const*, __itt_string_handle*> handles;
+    auto& handle = handles[name];
+    if(! handle)
+        handle = __itt_string_handle_create(name);
+    return handle;
+}
+
+} // (anon)
+
+ProfileZone::
+ProfileZone(
+    ProfileSite const& site) noexcept
+    : ctx_(nullptr)
+{
+    __itt_task_begin(ittDomain(), __itt_null, __itt_null,
+        ittHandle(site.name));
+}
+
+ProfileZone::
+ProfileZone(
+    ProfileSite const& site,
+    std::string_view text) noexcept
+    : ProfileZone(site)
+{
+    // tasks have no text, so it is
+    // attached as metadata instead
+    __itt_metadata_str_add(ittDomain(), __itt_null,
+        ittHandle("detail"), text.data(), text.size());
+}
+
+ProfileZone::
+~ProfileZone()
+{
+    __itt_task_end(ittDomain());
+}
+
+#endif
+
+} // mrdox
+} // clang
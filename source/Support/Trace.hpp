@@ -0,0 +1,178 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_SUPPORT_TRACE_HPP
+#define MRDOX_TOOL_SUPPORT_TRACE_HPP
+
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace clang {
+namespace mrdox {
+
+/** Start recording trace events.
+
+    Until this is called, trace scopes
+    record nothing and cost one load.
+*/
+void
+startTrace();
+
+/** Return true if trace events are recorded.
+*/
+bool
+isTracing() noexcept;
+
+/** Write the recorded trace events to a file.
+
+    The file is in the Chrome trace event
+    format, which is read by Perfetto and by
+    chrome://tracing. This must not be called
+    while events are being recorded.
+*/
+Error
+writeTrace(
+    std::string_view path);
+
+/** Record a trace event for the duration of a scope.
+
+    Each thread appends to its own buffer,
+    so scopes on different threads do not
+    contend. The name must be a string literal.
+*/
+class TraceScope
+{
+    using clock_type = std::chrono::steady_clock;
+
+    char const* name_;
+    std::string detail_;
+    clock_type::time_point start_;
+    bool active_;
+
+public:
+    explicit
+    TraceScope(
+        char const* name) noexcept;
+
+    TraceScope(
+        char const* name,
+        std::string_view detail);
+
+    ~TraceScope();
+
+    TraceScope(TraceScope const&) = delete;
+    TraceScope& operator=(TraceScope const&) = delete;
+
+    /** Return true if this scope is recorded.
+
+        A detail which is costly to compute
+        should only be set when this is true.
+    */
+    explicit
+    operator bool() const noexcept
+    {
+        return active_;
+    }
+
+    /** Set the text shown with the event.
+    */
+    void
+    setDetail(
+        std::string_view detail)
+    {
+        detail_ = detail;
+    }
+};
+
+//------------------------------------------------
+
+/*  MRDOX_PROFILE_ZONE(name) marks the rest of a
+    scope as a zone of an instrumenting profiler,
+    and MRDOX_PROFILE_ZONE_TEXT(name, text) adds
+    text which tells apart its instances.
+
+    With the MRDOX_PROFILER CMake option set to
+    `tracy` or `itt`, the zones are reported to
+    Tracy or to Intel ITT, for VTune. Otherwise
+    the macros expand to nothing, and their
+    arguments are not evaluated, so zones may
+    be placed on the hottest paths. The name
+    must be a string literal.
+*/
+#if defined(MRDOX_PROFILER_TRACY) || defined(MRDOX_PROFILER_ITT)
+
+/** Where a profiler zone is written.
+
+    The layout is that of the source
+    location of a Tracy zone.
+*/
+struct ProfileSite
+{
+    char const* name;
+    char const* function;
+    char const* file;
+    std::uint32_t line;
+    std::uint32_t color;
+};
+
+/** A zone of an instrumenting profiler.
+
+    @see MRDOX_PROFILE_ZONE
+*/
+class ProfileZone
+{
+    void* ctx_;
+
+public:
+    explicit
+    ProfileZone(
+        ProfileSite const& site) noexcept;
+
+    ProfileZone(
+        ProfileSite const& site,
+        std::string_view text) noexcept;
+
+    ~ProfileZone();
+
+    ProfileZone(ProfileZone const&) = delete;
+    ProfileZone& operator=(ProfileZone const&) = delete;
+};
+
+#define MRDOX_PROFILE_CAT2(a, b) a##b
+#define MRDOX_PROFILE_CAT(a, b) MRDOX_PROFILE_CAT2(a, b)
+#define MRDOX_PROFILE_ZONE_IMPL(id, name, ...) \
+    static ::clang::mrdox::ProfileSite const \
+        MRDOX_PROFILE_CAT(mrdox_profile_site_, id) = { \
+            name, __func__, __FILE__, __LINE__, 0 }; \
+    ::clang::mrdox::ProfileZone MRDOX_PROFILE_CAT(mrdox_profile_zone_, id)( \
+        MRDOX_PROFILE_CAT(mrdox_profile_site_, id) __VA_OPT__(,) __VA_ARGS__)
+
+#define MRDOX_PROFILE_ZONE(name) \
+    MRDOX_PROFILE_ZONE_IMPL(__COUNTER__, name)
+
+#define MRDOX_PROFILE_ZONE_TEXT(name, text) \
+    MRDOX_PROFILE_ZONE_IMPL(__COUNTER__, name, text)
+
+#else
+
+#define MRDOX_PROFILE_ZONE(name) ((void)0)
+
+#define MRDOX_PROFILE_ZONE_TEXT(name, text) ((void)0)
+
+#endif
+
+} // mrdox
+} // clang
+
+#endif
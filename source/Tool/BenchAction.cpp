@@ -0,0 +1,408 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "ConfigImpl.hpp"
+#include "CorpusImpl.hpp"
+#include "ToolArgs.hpp"
+#include "ToolExecutor.hpp"
+#include "Support/Error.hpp"
+#include "Support/PhaseReport.hpp"
+#include <mrdox/Generators.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Path.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/Support/FileSystem.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+extern Error runMicroBenchmarks(Corpus const& corpus, unsigned iterations);
+
+namespace {
+
+/** The shape of the synthetic corpus.
+*/
+struct BenchShape
+{
+    unsigned namespaces;
+    unsigned classes;
+    unsigned templateDepth;
+};
+
+/** Compilation database for the synthetic translation units.
+*/
+class BenchDB
+    : public tooling::CompilationDatabase
+{
+    std::vector<tooling::CompileCommand> cc_;
+
+public:
+    BenchDB(
+        llvm::StringRef dir,
+        std::vector<std::string> const& files)
+    {
+        for(auto const& file : files)
+        {
+            cc_.emplace_back(dir, file,
+                std::vector<std::string>{ "clang", "-std=c++20", file },
+                dir);
+            cc_.back().Heuristic = "benchmark";
+        }
+    }
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override
+    {
+        for(auto const& cc : cc_)
+            if(FilePath.equals(cc.Filename))
+                return { cc };
+        return {};
+    }
+
+    std::vector<std::string>
+    getAllFiles() const override
+    {
+        std::vector<std::string> files;
+        for(auto const& cc : cc_)
+            files.push_back(cc.Filename);
+        return files;
+    }
+
+    std::vector<tooling::CompileCommand>
+    getAllCompileCommands() const override
+    {
+        return cc_;
+    }
+};
+
+Error
+writeFile(
+    std::string const& path,
+    std::string_view text)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    os << text;
+    os.close();
+    if(os.has_error())
+        return formatError("could not write \"{}\": {}",
+            path, os.error().message());
+    return Error::success();
+}
+
+/** The javadoc of a synthetic declaration.
+
+    Every declaration is documented at length,
+    so the comment parser and the templates
+    do a realistic share of the work.
+*/
+std::string
+javadoc(
+    std::string_view indent,
+    std::string_view brief,
+    std::vector<std::string> const& params,
+    bool returns)
+{
+    std::string s;
+    s += fmt::format("{}/** {}\n\n", indent, brief);
+    s += fmt::format(
+        "{0}    This paragraph describes the behavior in\n"
+        "{0}    detail, with `code`, *emphasis*, and a\n"
+        "{0}    second sentence so that the text wraps.\n\n"
+        "{0}    @par Thread Safety\n"
+        "{0}    Distinct objects may be used concurrently.\n",
+        indent);
+    if(! params.empty() || returns)
+        s += '\n';
+    for(auto const& p : params)
+        s += fmt::format("{}    @param {} The {} to use.\n", indent, p, p);
+    if(returns)
+        s += fmt::format("{}    @return The result of the operation.\n", indent);
+    s += fmt::format("{}*/\n", indent);
+    return s;
+}
+
+/** Write the synthetic sources and return the number of declarations.
+
+    Each namespace has its own header and
+    translation unit, and every header uses
+    a chain of templates from a common one.
+*/
+Expected<std::size_t>
+writeSyntheticCorpus(
+    std::string const& dir,
+    BenchShape const& shape,
+    std::vector<std::string>& files)
+{
+    std::size_t decls = 0;
+
+    std::string common = "#pragma once\n\nnamespace bench {\n\n";
+    common += javadoc("", "A chain of templates, each deriving from the next.",
+        {}, false);
+    common +=
+        "template<unsigned N, class T>\n"
+        "struct deep : deep<N - 1, T>\n"
+        "{\n";
+    common += javadoc("    ", "The depth of this link.", {}, false);
+    common +=
+        "    static constexpr unsigned depth = N;\n\n";
+    common += javadoc("    ", "The type at the end of the chain.", {}, false);
+    common +=
+        "    using type = typename deep<N - 1, T>::type;\n"
+        "};\n\n";
+    common += javadoc("", "The end of the chain.", {}, false);
+    common +=
+        "template<class T>\n"
+        "struct deep<0, T>\n"
+        "{\n"
+        "    using type = T;\n"
+        "};\n\n"
+        "} // bench\n";
+    decls += 6;
+    if(auto err = writeFile(files::appendPath(dir, "deep.hpp"), common))
+        return err;
+
+    for(unsigned i = 0; i < shape.namespaces; ++i)
+    {
+        std::string header = "#pragma once\n\n#include \"deep.hpp\"\n\n";
+        header += fmt::format("namespace bench{} {{\n\n", i);
+        ++decls;
+        for(unsigned j = 0; j < shape.classes; ++j)
+        {
+            header += javadoc("", fmt::format(
+                "The class number {} of this namespace.", j), {}, false);
+            header += fmt::format("class c{}\n{{\npublic:\n", j);
+            header += javadoc("    ", "Constructor.", { "value" }, false);
+            header += fmt::format("    explicit c{}(int value);\n\n", j);
+            header += javadoc("    ", "Return the value plus an amount.",
+                { "amount" }, true);
+            header += "    int add(int amount) const;\n\n";
+            header += javadoc("    ", "Convert a value.", { "t" }, true);
+            header += "    template<class T>\n"
+                "    T convert(T const& t) const;\n\n";
+            header += javadoc("    ", "The next object.", {}, false);
+            header += fmt::format(
+                "    typename bench::deep<{}, c{}*>::type next;\n\n",
+                shape.templateDepth, j);
+            header += "private:\n    int value_;\n};\n\n";
+            header += javadoc("", "Return the value of an object.",
+                { "c" }, true);
+            header += fmt::format("int f{0}(c{0} const& c);\n\n", j);
+            decls += 7;
+        }
+        header += fmt::format("}} // bench{}\n", i);
+
+        auto const name = fmt::format("ns{}", i);
+        if(auto err = writeFile(files::appendPath(
+                dir, name + ".hpp"), header))
+            return err;
+        auto const file = files::appendPath(dir, name + ".cpp");
+        if(auto err = writeFile(file,
+                fmt::format("#include \"{}.hpp\"\n", name)))
+            return err;
+        files.push_back(file);
+    }
+    return decls;
+}
+
+/** Return the number of files in a directory tree.
+*/
+std::size_t
+countFiles(
+    std::string const& dir)
+{
+    namespace fs = llvm::sys::fs;
+
+    std::size_t n = 0;
+    std::error_code ec;
+    for(fs::recursive_directory_iterator it(dir, ec), end;
+        it != end && ! ec; it.increment(ec))
+    {
+        if(it->type() == fs::file_type::regular_file)
+            ++n;
+    }
+    return n;
+}
+
+double
+phaseSeconds(
+    std::vector<PhaseStats> const& phases,
+    std::initializer_list<std::string_view> names)
+{
+    double seconds = 0;
+    for(auto const& s : phases)
+        if(std::find(names.begin(), names.end(), s.name) != names.end())
+            seconds += s.wallSeconds;
+    return seconds;
+}
+
+/** The timings of one run of the phases.
+*/
+struct BenchRun
+{
+    double extractSeconds = 0;
+    double reduceSeconds = 0;
+    double renderSeconds = 0;
+};
+
+double
+rate(
+    std::size_t n,
+    double seconds)
+{
+    return n / std::max(seconds, 1e-6);
+}
+
+} // (anon)
+
+Error
+DoBenchAction()
+{
+    namespace fs = llvm::sys::fs;
+
+    BenchShape const shape{
+        toolArgs.benchNamespaces.getValue(),
+        toolArgs.benchClasses.getValue(),
+        toolArgs.benchTemplateDepth.getValue() };
+    unsigned const iterations =
+        std::max(toolArgs.benchIterations.getValue(), 1u);
+
+    // The sources are kept in a directory given
+    // on the command line, or else in a temporary
+    // directory which is removed afterwards.
+    std::string dir;
+    bool removeDir = false;
+    if(! toolArgs.inputPaths.empty())
+    {
+        auto absPath = files::makeAbsolute(toolArgs.inputPaths.front());
+        if(! absPath)
+            return absPath.error();
+        dir = files::normalizePath(*absPath);
+        if(auto ec = fs::create_directories(dir))
+            return formatError("could not create \"{}\": {}",
+                dir, ec.message());
+    }
+    else
+    {
+        llvm::SmallString<128> temp;
+        if(auto ec = fs::createUniqueDirectory("mrdox-bench", temp))
+            return formatError("could not create a temporary directory: {}",
+                ec.message());
+        dir = std::string(temp.str());
+        removeDir = true;
+    }
+    auto cleanup = llvm::make_scope_exit(
+        [&]
+        {
+            if(removeDir)
+                fs::remove_directories(dir);
+        });
+
+    std::vector<std::string> sources;
+    auto decls = writeSyntheticCorpus(dir, shape, sources);
+    if(! decls)
+        return decls.error();
+
+    std::string outputDir;
+    if(! toolArgs.outputPath.empty())
+        outputDir = files::normalizePath(
+            files::makeAbsolute(toolArgs.outputPath, dir));
+    else
+        outputDir = files::appendPath(dir, "output");
+    if(auto ec = fs::create_directories(outputDir))
+        return formatError("could not create \"{}\": {}",
+            outputDir, ec.message());
+
+    auto generator = getGenerators().find(toolArgs.formatType.getValue());
+    if(! generator)
+        return formatError("the Generator \"{}\" was not found",
+            toolArgs.formatType.getValue());
+
+    std::string configYaml;
+    llvm::raw_string_ostream(configYaml) <<
+        "verbose: false\n"
+        "multipage: true\n"
+        "source-root: " << dir << "\n";
+    auto config = createConfigFromYAML(
+        files::makeDirsy(dir), toolArgs.addonsDir, configYaml);
+    if(! config)
+        return config.error();
+
+    reportInfo("Benchmark: {} namespaces of {} classes, template depth {}, "
+        "{} declarations in {} translation units",
+        shape.namespaces, shape.classes, shape.templateDepth,
+        *decls, sources.size());
+
+    BenchDB db(dir, sources);
+    std::vector<BenchRun> runs;
+    std::size_t symbols = 0;
+    std::size_t pages = 0;
+    std::unique_ptr<Corpus> corpus;
+    for(unsigned i = 0; i < iterations; ++i)
+    {
+        takePhaseStats();
+        corpus.reset();
+        {
+            ToolExecutor ex(**config, db);
+            auto result = CorpusImpl::build(ex, *config);
+            if(! result)
+                return result.error();
+            corpus = result.release();
+        }
+        {
+            ScopedPhase phase("generate");
+            if(auto err = generator->build(outputDir, *corpus))
+                return err;
+        }
+        auto const phases = takePhaseStats();
+
+        BenchRun run;
+        run.extractSeconds = phaseSeconds(phases, { "mapping", "collect" });
+        run.reduceSeconds = phaseSeconds(phases, { "reduce", "finalize" });
+        run.renderSeconds = phaseSeconds(phases, { "generate" });
+        symbols = corpus->index().size();
+        pages = countFiles(outputDir);
+        reportInfo("Run {}: extract {:.3f} s, reduce {:.3f} s, render {:.3f} s",
+            i + 1, run.extractSeconds, run.reduceSeconds, run.renderSeconds);
+        runs.push_back(run);
+    }
+
+    // The fastest run is the least disturbed
+    // by the rest of the machine.
+    BenchRun best = runs.front();
+    for(auto const& run : runs)
+    {
+        best.extractSeconds = std::min(best.extractSeconds, run.extractSeconds);
+        best.reduceSeconds = std::min(best.reduceSeconds, run.reduceSeconds);
+        best.renderSeconds = std::min(best.renderSeconds, run.renderSeconds);
+    }
+    reportInfo("Best of {}: {:.0f} decls/s, {:.0f} symbols reduced/s, "
+        "{:.0f} pages rendered/s",
+        runs.size(),
+        rate(*decls, best.extractSeconds),
+        rate(symbols, best.reduceSeconds),
+        rate(pages, best.renderSeconds));
+
+    if(toolArgs.benchMicro)
+        return runMicroBenchmarks(*corpus, iterations);
+    return Error::success();
+}
+
+} // mrdox
+} // clang
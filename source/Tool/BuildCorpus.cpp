@@ -0,0 +1,54 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "ConfigImpl.hpp"
+#include "CorpusImpl.hpp"
+#include "ToolExecutor.hpp"
+#include "AST/AbsoluteCompilationDatabase.hpp"
+#include <mrdox/BuildCorpus.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Path.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace clang {
+namespace mrdox {
+
+Expected<std::unique_ptr<Corpus>>
+buildCorpus(
+    std::shared_ptr<Config const> config_,
+    std::vector<CompileCommand> commands,
+    BuildOptions const& options)
+{
+    auto config = std::dynamic_pointer_cast<ConfigImpl const>(config_);
+    if(! config)
+        return formatError("the configuration was not made by createConfig");
+
+    std::vector<tooling::CompileCommand> cc;
+    cc.reserve(commands.size());
+    for(auto& cmd : commands)
+    {
+        auto dir = files::makeAbsolute(cmd.directory, config->workingDir);
+        cc.emplace_back(std::move(dir), std::move(cmd.file),
+            std::move(cmd.arguments), std::string());
+        cc.back().Heuristic = "buildCorpus";
+    }
+    AbsoluteCompilationDatabase compilations(
+        config->workingDir, std::move(cc), config);
+
+    ToolExecutor ex(*config, compilations);
+    ex.setBuildOptions(&options);
+    auto corpus = CorpusImpl::build(ex, config);
+    if(! corpus)
+        return corpus.error();
+    return corpus;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,217 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "CachingFileSystem.hpp"
+#include <llvm/Support/Path.h>
+
+namespace clang {
+namespace mrdox {
+
+std::optional<SharedFileCache::Entry>
+SharedFileCache::
+find(llvm::StringRef path) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if(it == entries_.end())
+        return std::nullopt;
+    return it->second;
+}
+
+SharedFileCache::Entry
+SharedFileCache::
+insert(
+    llvm::StringRef path,
+    Entry entry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = entries_.try_emplace(path, entry);
+    if(inserted)
+        return it->second;
+    // only a buffer adds information
+    // to an entry which already exists
+    if(entry.buffer && ! it->second.buffer)
+        it->second = std::move(entry);
+    return it->second;
+}
+
+//------------------------------------------------
+
+namespace {
+
+/** A file whose contents are held by the shared cache.
+*/
+class CachedFile : public llvm::vfs::File
+{
+    llvm::vfs::Status status_;
+    std::shared_ptr<llvm::MemoryBuffer const> buffer_;
+
+public:
+    CachedFile(
+        llvm::vfs::Status status,
+        std::shared_ptr<llvm::MemoryBuffer const> buffer)
+        : status_(std::move(status))
+        , buffer_(std::move(buffer))
+    {
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status() override
+    {
+        return status_;
+    }
+
+    llvm::ErrorOr<std::string>
+    getName() override
+    {
+        return status_.getName().str();
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+    getBuffer(
+        llvm::Twine const& Name,
+        std::int64_t,
+        bool RequiresNullTerminator,
+        bool) override
+    {
+        // cached buffers are always null terminated
+        return llvm::MemoryBuffer::getMemBuffer(
+            buffer_->getBuffer(), Name.str(),
+            RequiresNullTerminator);
+    }
+
+    std::error_code
+    close() override
+    {
+        return {};
+    }
+};
+
+class CachingFileSystem
+    : public llvm::vfs::ProxyFileSystem
+{
+    SharedFileCache& cache_;
+    llvm::StringSet<>* missing_;
+
+    void
+    noteError(
+        llvm::StringRef key,
+        std::error_code ec)
+    {
+        if(missing_ && ec == std::errc::no_such_file_or_directory)
+            missing_->insert(key);
+    }
+
+    bool
+    makeKey(
+        llvm::Twine const& Path,
+        llvm::SmallVectorImpl<char>& key)
+    {
+        Path.toVector(key);
+        if(makeAbsolute(key))
+            return false;
+        llvm::sys::path::remove_dots(key, false);
+        return true;
+    }
+
+public:
+    CachingFileSystem(
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+        SharedFileCache& cache,
+        llvm::StringSet<>* missing)
+        : ProxyFileSystem(std::move(FS))
+        , cache_(cache)
+        , missing_(missing)
+    {
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status(llvm::Twine const& Path) override
+    {
+        llvm::SmallString<256> key;
+        if(! makeKey(Path, key))
+            return ProxyFileSystem::status(Path);
+        if(auto entry = cache_.find(key))
+        {
+            if(entry->ec)
+            {
+                noteError(key, entry->ec);
+                return entry->ec;
+            }
+            return llvm::vfs::Status::copyWithNewName(
+                *entry->status, Path);
+        }
+        auto result = ProxyFileSystem::status(Path);
+        if(result)
+        {
+            cache_.insert(key, { {}, *result, nullptr });
+        }
+        else
+        {
+            noteError(key, result.getError());
+            cache_.insert(key, { result.getError(), std::nullopt, nullptr });
+        }
+        return result;
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(llvm::Twine const& Path) override
+    {
+        llvm::SmallString<256> key;
+        if(! makeKey(Path, key))
+            return ProxyFileSystem::openFileForRead(Path);
+        if(auto entry = cache_.find(key))
+        {
+            if(entry->ec)
+            {
+                noteError(key, entry->ec);
+                return entry->ec;
+            }
+            if(entry->buffer)
+                return std::make_unique<CachedFile>(
+                    llvm::vfs::Status::copyWithNewName(
+                        *entry->status, Path), entry->buffer);
+        }
+
+        auto file = ProxyFileSystem::openFileForRead(Path);
+        if(! file)
+        {
+            noteError(key, file.getError());
+            return file;
+        }
+        auto status = (*file)->status();
+        if(! status || status->isDirectory())
+            return file;
+        // non-volatile, so large files get mapped
+        auto buffer = (*file)->getBuffer(
+            Path, status->getSize(), true, false);
+        if(! buffer)
+            return buffer.getError();
+        auto entry = cache_.insert(key, {
+            {}, *status, std::move(*buffer) });
+        return std::make_unique<CachedFile>(
+            llvm::vfs::Status::copyWithNewName(
+                *status, Path), entry.buffer);
+    }
+};
+
+} // (anon)
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+createCachingFileSystem(
+    SharedFileCache& cache,
+    llvm::StringSet<>* missing)
+{
+    return llvm::makeIntrusiveRefCnt<CachingFileSystem>(
+        llvm::vfs::createPhysicalFileSystem(), cache, missing);
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,89 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_CACHINGFILESYSTEM_HPP
+#define MRDOX_TOOL_TOOL_CACHINGFILESYSTEM_HPP
+
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace clang {
+namespace mrdox {
+
+/** Stat results and file contents shared by all workers.
+
+    Entries are keyed on the absolute path and
+    are kept for the lifetime of the object.
+    Buffers are memory-mapped when possible.
+    Failed lookups are remembered as well, since
+    include searches probe many missing files.
+
+    @par Thread Safety
+    May be called concurrently.
+*/
+class SharedFileCache
+{
+public:
+    struct Entry
+    {
+        std::error_code ec;
+        std::optional<llvm::vfs::Status> status;
+        std::shared_ptr<llvm::MemoryBuffer const> buffer;
+    };
+
+    /** Return the entry for a path, if present.
+    */
+    std::optional<Entry>
+    find(llvm::StringRef path) const;
+
+    /** Insert or update the entry for a path.
+
+        Returns the entry now stored, which can
+        differ when another thread got there first.
+    */
+    Entry
+    insert(
+        llvm::StringRef path,
+        Entry entry);
+
+private:
+    mutable std::mutex mutex_;
+    llvm::StringMap<Entry> entries_;
+};
+
+/** Return a file system which consults a shared cache.
+
+    Each returned object is backed by its own
+    physical file system, so that every worker
+    keeps an independent working directory,
+    while stat results and buffers come from
+    the shared cache.
+
+    @param missing If not null, the absolute
+    paths which were looked up and do not exist
+    are added to it. These are mostly the probes
+    of include searches, and a file created at
+    one of them can change what is included.
+*/
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+createCachingFileSystem(
+    SharedFileCache& cache,
+    llvm::StringSet<>* missing = nullptr);
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,811 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "ClangdIndex.hpp"
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/YAMLParser.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <functional>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+// the number of bytes of a clangd symbol ID
+constexpr std::size_t prefixSize = 8;
+
+namespace yaml = llvm::yaml;
+
+std::string
+scalar(
+    yaml::Node* node)
+{
+    if(auto* s = llvm::dyn_cast_or_null<yaml::ScalarNode>(node))
+    {
+        llvm::SmallString<128> buf;
+        return s->getValue(buf).str();
+    }
+    if(auto* s = llvm::dyn_cast_or_null<yaml::BlockScalarNode>(node))
+        return s->getValue().str();
+    return {};
+}
+
+/** Invoke a function with each key and value of a mapping.
+*/
+void
+forEachKey(
+    yaml::Node* node,
+    llvm::function_ref<void(
+        llvm::StringRef key, yaml::Node* value)> f)
+{
+    auto* m = llvm::dyn_cast_or_null<yaml::MappingNode>(node);
+    if(! m)
+        return;
+    for(auto& kv : *m)
+    {
+        auto const key = scalar(kv.getKey());
+        f(key, kv.getValue());
+    }
+}
+
+/** Return the eight bytes of a hex symbol ID, or an empty string.
+*/
+std::string
+parseID(
+    yaml::Node* node)
+{
+    std::string bytes;
+    if(! llvm::tryGetFromHex(scalar(node), bytes) ||
+        bytes.size() != prefixSize)
+        return {};
+    return bytes;
+}
+
+/** Return the path of a file URI, or an empty string.
+*/
+std::string
+fileFromURI(
+    llvm::StringRef uri)
+{
+    if(! uri.consume_front("file://"))
+        return {};
+    std::string path;
+    path.reserve(uri.size());
+    for(std::size_t i = 0; i < uri.size(); ++i)
+    {
+        unsigned char c;
+        if(uri[i] == '%' && i + 2 < uri.size() &&
+            llvm::isHexDigit(uri[i + 1]) &&
+            llvm::isHexDigit(uri[i + 2]))
+        {
+            c = static_cast<unsigned char>(
+                llvm::hexFromNibbles(uri[i + 1], uri[i + 2]));
+            i += 2;
+        }
+        else
+        {
+            c = static_cast<unsigned char>(uri[i]);
+        }
+        path.push_back(static_cast<char>(c));
+    }
+    // file:///C:/dir
+    if(path.size() >= 3 && path[0] == '/' &&
+        llvm::isAlpha(path[1]) && path[2] == ':')
+        path.erase(0, 1);
+    return path;
+}
+
+/** Split a qualified name into its scope and its last name.
+*/
+std::pair<llvm::StringRef, llvm::StringRef>
+splitQualified(
+    llvm::StringRef qualified)
+{
+    auto const pos = qualified.rfind("::");
+    if(pos == llvm::StringRef::npos)
+        return { {}, qualified };
+    return { qualified.take_front(pos), qualified.drop_front(pos + 2) };
+}
+
+SymbolID
+hashUSR(
+    llvm::StringRef usr)
+{
+    return SymbolID(llvm::SHA1::hash(
+        llvm::arrayRefFromStringRef(usr)).data());
+}
+
+std::shared_ptr<TypeInfo>
+makeType(
+    llvm::StringRef text)
+{
+    text = text.trim();
+    if(text.empty())
+        return nullptr;
+    // the index only has the spelling
+    auto T = std::make_shared<BuiltinTypeInfo>();
+    T->Name = text.str();
+    return T;
+}
+
+/** Split text at the commas which are not nested.
+*/
+std::vector<llvm::StringRef>
+splitList(
+    llvm::StringRef text)
+{
+    std::vector<llvm::StringRef> list;
+    int depth = 0;
+    std::size_t first = 0;
+    for(std::size_t i = 0; i < text.size(); ++i)
+    {
+        switch(text[i])
+        {
+        case '(': case '[': case '{': case '<':
+            ++depth;
+            break;
+        case ')': case ']': case '}': case '>':
+            --depth;
+            break;
+        case ',':
+            if(depth == 0)
+            {
+                list.push_back(text.slice(first, i).trim());
+                first = i + 1;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    if(! text.drop_front(first).trim().empty())
+        list.push_back(text.drop_front(first).trim());
+    return list;
+}
+
+bool
+isTypeKeyword(
+    llvm::StringRef s)
+{
+    return llvm::is_contained(std::initializer_list<llvm::StringRef>{
+        "bool", "char", "char8_t", "char16_t", "char32_t", "wchar_t",
+        "short", "int", "long", "signed", "unsigned", "float",
+        "double", "void", "auto", "const", "volatile" }, s);
+}
+
+Param
+makeParam(
+    llvm::StringRef text)
+{
+    llvm::StringRef decl = text;
+    llvm::StringRef def;
+    if(auto const eq = text.find('='); eq != llvm::StringRef::npos)
+    {
+        decl = text.take_front(eq).rtrim();
+        def = text.drop_front(eq + 1).trim();
+    }
+    // the name is the identifier at the end, when
+    // it is not the last word of the type
+    std::size_t n = decl.size();
+    while(n > 0 && (llvm::isAlnum(decl[n - 1]) || decl[n - 1] == '_'))
+        --n;
+    llvm::StringRef name = decl.drop_front(n);
+    llvm::StringRef type = decl.take_front(n).rtrim();
+    if(name.empty() || type.empty() ||
+        llvm::isDigit(name.front()) || isTypeKeyword(name) ||
+        type.ends_with("::"))
+    {
+        name = {};
+        type = decl;
+    }
+    return Param(makeType(type), name.str(), def.str());
+}
+
+/** Parse the parameters and qualifiers of a function signature.
+*/
+void
+parseSignature(
+    FunctionInfo& I,
+    llvm::StringRef signature)
+{
+    auto const open = signature.find('(');
+    if(open == llvm::StringRef::npos)
+        return;
+    int depth = 0;
+    std::size_t close = open;
+    for(; close < signature.size(); ++close)
+    {
+        if(signature[close] == '(')
+            ++depth;
+        else if(signature[close] == ')' && --depth == 0)
+            break;
+    }
+    if(close == signature.size())
+        return;
+    for(auto p : splitList(signature.slice(open + 1, close)))
+    {
+        if(p == "...")
+        {
+            I.specs0.isVariadic = true;
+            continue;
+        }
+        I.Params.emplace_back(makeParam(p));
+    }
+    llvm::SmallVector<llvm::StringRef, 4> quals;
+    signature.drop_front(close + 1).split(quals, ' ', -1, false);
+    for(auto q : quals)
+    {
+        if(q == "const")
+            I.specs0.isConst = true;
+        else if(q == "volatile")
+            I.specs0.isVolatile = true;
+        else if(q == "&")
+            I.specs0.refQualifier = ReferenceKind::LValue;
+        else if(q == "&&")
+            I.specs0.refQualifier = ReferenceKind::RValue;
+    }
+}
+
+OperatorKind
+findOperator(
+    llvm::StringRef name)
+{
+    if(! name.consume_front("operator"))
+        return OperatorKind::None;
+    name = name.ltrim();
+    for(auto k = to_underlying(OperatorKind::New);
+        k <= to_underlying(OperatorKind::Coawait); ++k)
+    {
+        auto const K = static_cast<OperatorKind>(k);
+        if(name == llvm::StringRef(getOperatorName(K)))
+            return K;
+    }
+    return OperatorKind::None;
+}
+
+/** Return the documentation as javadoc.
+
+    Paragraphs are separated by blank lines.
+*/
+std::unique_ptr<Javadoc>
+makeJavadoc(
+    llvm::StringRef text)
+{
+    doc::List<doc::Block> blocks;
+    doc::Paragraph para;
+    auto const flush = [&]
+    {
+        if(para.children.empty())
+            return;
+        blocks.emplace_back(std::make_unique<
+            doc::Paragraph>(std::move(para)));
+        para = doc::Paragraph();
+    };
+    llvm::SmallVector<llvm::StringRef, 16> lines;
+    text.split(lines, '\n');
+    for(auto line : lines)
+    {
+        line = line.trim();
+        if(line.empty())
+            flush();
+        else
+            para.emplace_back(doc::Text(line.str()));
+    }
+    flush();
+    if(blocks.empty())
+        return nullptr;
+    auto jd = std::make_unique<Javadoc>(std::move(blocks));
+    jd->computeHash();
+    return jd;
+}
+
+bool
+isRecordKind(
+    llvm::StringRef kind)
+{
+    return kind == "Struct" || kind == "Class" || kind == "Union";
+}
+
+bool
+isFunctionKind(
+    llvm::StringRef kind)
+{
+    return kind == "Function" ||
+        kind == "InstanceMethod" ||
+        kind == "ClassMethod" ||
+        kind == "StaticMethod" ||
+        kind == "Constructor" ||
+        kind == "Destructor" ||
+        kind == "ConversionFunction";
+}
+
+} // (anon)
+
+//------------------------------------------------
+
+Expected<std::unique_ptr<ClangdIndex>>
+ClangdIndex::
+load(
+    std::string_view path,
+    ConfigImpl const& config)
+{
+    auto buf = llvm::MemoryBuffer::getFile(path);
+    if(! buf)
+        return formatError("getFile(\"{}\") returned \"{}\"",
+            path, buf.getError().message());
+    std::unique_ptr<ClangdIndex> index(new ClangdIndex(config));
+    if(auto err = index->parse(path, (*buf)->getBuffer()))
+        return err;
+    return index;
+}
+
+Error
+ClangdIndex::
+parse(
+    std::string_view path,
+    llvm::StringRef text)
+{
+    // only the first diagnostic is kept
+    std::string diag;
+    llvm::SourceMgr sm;
+    sm.setDiagHandler(
+        [](llvm::SMDiagnostic const& d, void* ctx)
+        {
+            auto& s = *static_cast<std::string*>(ctx);
+            if(s.empty())
+                s = fmt::format("line {}: {}",
+                    d.getLineNo(), d.getMessage().str());
+        }, &diag);
+
+    auto const parseLocation = [&](yaml::Node* node, Location& loc)
+    {
+        forEachKey(node,
+            [&](llvm::StringRef key, yaml::Node* value)
+            {
+                if(key == "FileURI")
+                {
+                    loc.file = fileFromURI(scalar(value));
+                    if(! loc.file.empty())
+                        files_.insert(loc.file);
+                }
+                else if(key == "Start")
+                {
+                    forEachKey(value,
+                        [&](llvm::StringRef key, yaml::Node* value)
+                        {
+                            unsigned line;
+                            if(key == "Line" && ! llvm::StringRef(
+                                    scalar(value)).getAsInteger(10, line))
+                                loc.line = line + 1;
+                        });
+                }
+            });
+    };
+
+    yaml::Stream stream(text, sm);
+    for(auto& doc : stream)
+    {
+        auto* root = doc.getRoot();
+        if(! root)
+            break;
+        auto const tag = root->getRawTag();
+        if(tag == "!Symbol")
+        {
+            Symbol S;
+            forEachKey(root,
+                [&](llvm::StringRef key, yaml::Node* value)
+                {
+                    if(key == "ID")
+                        S.id = parseID(value);
+                    else if(key == "Name")
+                        S.name = scalar(value);
+                    else if(key == "Scope")
+                        S.scope = scalar(value);
+                    else if(key == "SymInfo")
+                        forEachKey(value,
+                            [&](llvm::StringRef key, yaml::Node* value)
+                            {
+                                if(key == "Kind")
+                                    S.kind = scalar(value);
+                            });
+                    else if(key == "CanonicalDeclaration")
+                        parseLocation(value, S.decl);
+                    else if(key == "Definition")
+                        parseLocation(value, S.def);
+                    else if(key == "TemplateSpecializationArgs")
+                        S.templateArgs = scalar(value);
+                    else if(key == "Signature")
+                        S.signature = scalar(value);
+                    else if(key == "ReturnType")
+                        S.returnType = scalar(value);
+                    else if(key == "Type")
+                        S.type = scalar(value);
+                    else if(key == "Documentation")
+                        S.documentation = scalar(value);
+                });
+            if(! S.id.empty())
+                symbols_.emplace_back(std::move(S));
+        }
+        else if(tag == "!Refs")
+        {
+            // only the files are used
+            forEachKey(root,
+                [&](llvm::StringRef key, yaml::Node* value)
+                {
+                    auto* refs = llvm::dyn_cast_or_null<
+                        yaml::SequenceNode>(value);
+                    if(key != "References" || ! refs)
+                        return;
+                    for(auto& ref : *refs)
+                        forEachKey(&ref,
+                            [&](llvm::StringRef key, yaml::Node* value)
+                            {
+                                Location loc;
+                                if(key == "Location")
+                                    parseLocation(value, loc);
+                            });
+                });
+        }
+        else if(tag == "!Relations")
+        {
+            Relation R;
+            std::string predicate;
+            auto const subjectID = [](yaml::Node* node)
+            {
+                std::string id;
+                forEachKey(node,
+                    [&](llvm::StringRef key, yaml::Node* value)
+                    {
+                        if(key == "ID")
+                            id = parseID(value);
+                    });
+                return id;
+            };
+            forEachKey(root,
+                [&](llvm::StringRef key, yaml::Node* value)
+                {
+                    if(key == "Subject")
+                        R.subject = subjectID(value);
+                    else if(key == "Object")
+                        R.object = subjectID(value);
+                    else if(key == "Predicate")
+                        predicate = scalar(value);
+                });
+            // the predicate is written by name or by value
+            if(predicate == "BaseOf" || predicate == "0")
+                R.baseOf = true;
+            else if(predicate == "OverriddenBy" || predicate == "1")
+                R.baseOf = false;
+            else
+                continue;
+            if(! R.subject.empty() && ! R.object.empty())
+                relations_.emplace_back(std::move(R));
+        }
+        else if(tag == "!Source")
+        {
+            forEachKey(root,
+                [&](llvm::StringRef key, yaml::Node* value)
+                {
+                    if(key != "URI")
+                        return;
+                    auto file = fileFromURI(scalar(value));
+                    if(! file.empty())
+                        files_.insert(file);
+                });
+        }
+    }
+    if(stream.failed())
+        return formatError("clangd index \"{}\" is malformed: {}", path, diag);
+    return Error::success();
+}
+
+std::size_t
+ClangdIndex::
+insertInto(
+    Bitcodes& bitcodes)
+{
+    // the extracted symbols, by the prefix of their ID
+    llvm::StringMap<SymbolID> extracted;
+    for(auto const& kv : bitcodes)
+        extracted.try_emplace(kv.getKey().take_front(prefixSize),
+            SymbolID(kv.getKey().data()));
+
+    auto const resolve = [&](std::string const& id)
+    {
+        if(auto it = extracted.find(id); it != extracted.end())
+            return it->second;
+        std::uint8_t bytes[20] = {};
+        std::copy(id.begin(), id.end(), bytes);
+        return SymbolID(bytes);
+    };
+
+    std::vector<std::unique_ptr<Info>> infos;
+    // the namespaces, records and enums by qualified
+    // name, with the USR if it could be recomputed
+    llvm::StringMap<Info*> scopes;
+    llvm::StringMap<std::string> usrs;
+    // the imported symbols by clangd ID
+    llvm::StringMap<Info*> byID;
+
+    auto global = std::make_unique<NamespaceInfo>();
+    scopes[""] = global.get();
+    usrs[""] = "c:";
+    infos.emplace_back(std::move(global));
+
+    auto const addChild = [&](Info& P, Info& I)
+    {
+        I.Namespace.push_back(P.id);
+        I.Namespace.insert(I.Namespace.end(),
+            P.Namespace.begin(), P.Namespace.end());
+        if(P.isRecord())
+        {
+            static_cast<RecordInfo&>(P).Members.push_back(I.id);
+            I.Access = AccessKind::Public;
+        }
+        else
+        {
+            static_cast<NamespaceInfo&>(P).Members.push_back(I.id);
+        }
+    };
+
+    // Namespaces are created for every scope which is
+    // not already known, so their IDs come from the USRs
+    std::function<Info*(llvm::StringRef)> findScope =
+        [&](llvm::StringRef qualified) -> Info*
+        {
+            if(auto it = scopes.find(qualified); it != scopes.end())
+                return it->second;
+            auto const [outer, name] = splitQualified(qualified);
+            auto* P = findScope(outer);
+            if(! P || ! P->isNamespace())
+                return nullptr;
+            auto it = usrs.find(outer);
+            if(it == usrs.end())
+                return nullptr;
+            std::string usr = it->second + "@N@" + name.str();
+            auto I = std::make_unique<NamespaceInfo>(hashUSR(usr));
+            I->Name = name.str();
+            addChild(*P, *I);
+            auto* ptr = I.get();
+            usrs[qualified] = std::move(usr);
+            scopes[qualified] = ptr;
+            infos.emplace_back(std::move(I));
+            return ptr;
+        };
+
+    auto const makeLocation = [&](Location const& loc)
+        -> std::optional<mrdox::Location>
+    {
+        std::string prefix;
+        if(loc.file.empty() ||
+            ! config_.shouldExtractFromFile(loc.file, prefix))
+            return std::nullopt;
+        llvm::StringRef file = loc.file;
+        file.consume_front(prefix);
+        return mrdox::Location(loc.line, file, true);
+    };
+
+    auto const setSource = [&](
+        SourceInfo& I,
+        mrdox::Location const& decl,
+        Symbol const& S)
+    {
+        auto def = makeLocation(S.def);
+        if(def)
+            I.DefLoc.emplace(*def);
+        if(! def || def->FileIndex != decl.FileIndex ||
+                def->LineNumber != decl.LineNumber)
+            I.Loc.push_back(decl);
+    };
+
+    // Records and enums can be scopes, so they are
+    // made first, with the outer ones before the inner.
+    std::vector<Symbol const*> order;
+    for(auto const& S : symbols_)
+        if(S.templateArgs.empty())
+            order.push_back(&S);
+    auto const isScopeKind = [](Symbol const* S)
+    {
+        return isRecordKind(S->kind) || S->kind == "Enum";
+    };
+    std::stable_sort(order.begin(), order.end(),
+        [&](Symbol const* a, Symbol const* b)
+        {
+            if(isScopeKind(a) != isScopeKind(b))
+                return isScopeKind(a);
+            return llvm::StringRef(a->scope).count("::") <
+                llvm::StringRef(b->scope).count("::");
+        });
+
+    for(auto const* S : order)
+    {
+        llvm::StringRef const scope =
+            llvm::StringRef(S->scope).drop_back(
+                llvm::StringRef(S->scope).ends_with("::") ? 2 : 0);
+        auto decl = makeLocation(S->decl);
+        if(! decl)
+            continue;
+        llvm::StringRef const kind = S->kind;
+        auto* P = findScope(scope);
+        // only enumerators are in the scope of an enum
+        if(! P || P->isEnum() != (kind == "EnumConstant"))
+            continue;
+        bool const inRecord = P->isRecord();
+        std::unique_ptr<Info> result;
+
+        if(isRecordKind(kind) || kind == "Enum")
+        {
+            // class templates have a different USR,
+            // so the recomputed one is checked
+            std::string usr;
+            std::optional<SymbolID> id;
+            if(auto it = usrs.find(scope); it != usrs.end())
+            {
+                usr = it->second +
+                    (kind == "Union" ? "@U@" : kind == "Enum" ? "@E@" : "@S@") +
+                    S->name;
+                auto const full = hashUSR(usr);
+                if(llvm::StringRef(full).take_front(prefixSize) == S->id)
+                    id = full;
+            }
+            std::string qualified = scope.empty() ? S->name :
+                (scope + "::" + S->name).str();
+            if(kind == "Enum")
+            {
+                auto I = std::make_unique<EnumInfo>(
+                    id ? *id : resolve(S->id));
+                setSource(*I, *decl, *S);
+                result = std::move(I);
+            }
+            else
+            {
+                auto I = std::make_unique<RecordInfo>(
+                    id ? *id : resolve(S->id));
+                I->KeyKind =
+                    kind == "Class" ? RecordKeyKind::Class :
+                    kind == "Union" ? RecordKeyKind::Union :
+                    RecordKeyKind::Struct;
+                setSource(*I, *decl, *S);
+                result = std::move(I);
+            }
+            scopes[qualified] = result.get();
+            if(id)
+                usrs[qualified] = std::move(usr);
+        }
+        else if(isFunctionKind(kind))
+        {
+            bool const member = kind != "Function";
+            if(member != inRecord)
+                continue;
+            auto I = std::make_unique<FunctionInfo>(resolve(S->id));
+            if(kind == "Constructor")
+                I->Class = FunctionClass::Constructor;
+            else if(kind == "Destructor")
+                I->Class = FunctionClass::Destructor;
+            else if(kind == "ConversionFunction")
+                I->Class = FunctionClass::Conversion;
+            else
+                I->ReturnType = makeType(S->returnType);
+            if(kind == "StaticMethod")
+                I->specs0.storageClass = StorageClassKind::Static;
+            I->specs0.overloadedOperator = findOperator(S->name);
+            parseSignature(*I, S->signature);
+            setSource(*I, *decl, *S);
+            result = std::move(I);
+        }
+        else if(kind == "Variable" || kind == "StaticProperty")
+        {
+            if((kind == "StaticProperty") != inRecord)
+                continue;
+            auto I = std::make_unique<VariableInfo>(resolve(S->id));
+            I->Type = makeType(S->type);
+            if(inRecord)
+                I->specs.storageClass = StorageClassKind::Static;
+            setSource(*I, *decl, *S);
+            result = std::move(I);
+        }
+        else if(kind == "Field")
+        {
+            if(! inRecord)
+                continue;
+            auto I = std::make_unique<FieldInfo>(resolve(S->id));
+            I->Type = makeType(S->type);
+            setSource(*I, *decl, *S);
+            result = std::move(I);
+        }
+        else if(kind == "TypeAlias")
+        {
+            auto I = std::make_unique<TypedefInfo>(resolve(S->id));
+            I->Type = makeType(S->type);
+            // an alias can not be redeclared
+            I->DefLoc.emplace(*decl);
+            result = std::move(I);
+        }
+        else if(kind == "EnumConstant")
+        {
+            // unscoped enumerators are in the enclosing
+            // scope, and are not imported
+            auto& M = static_cast<EnumInfo&>(*P).Members.emplace_back(S->name);
+            M.javadoc = makeJavadoc(S->documentation);
+            continue;
+        }
+        else
+        {
+            continue;
+        }
+
+        result->Name = S->name;
+        result->javadoc = makeJavadoc(S->documentation);
+        addChild(*P, *result);
+        byID[S->id] = result.get();
+        infos.emplace_back(std::move(result));
+    }
+
+    llvm::StringMap<Symbol const*> symbols;
+    for(auto const& S : symbols_)
+        symbols.try_emplace(S.id, &S);
+    for(auto const& R : relations_)
+    {
+        auto const object = byID.find(R.object);
+        if(object == byID.end())
+            continue;
+        auto const subject = byID.find(R.subject);
+        if(R.baseOf)
+        {
+            // the subject is the base of the object
+            auto const base = symbols.find(R.subject);
+            if(! object->second->isRecord() || base == symbols.end())
+                continue;
+            auto T = std::make_shared<TagTypeInfo>();
+            T->Name = base->second->name;
+            if(subject != byID.end())
+                T->id = subject->second->id;
+            static_cast<RecordInfo&>(*object->second).Bases.emplace_back(
+                std::move(T), AccessKind::Public, false);
+        }
+        else
+        {
+            // the subject is overridden by the object
+            if(! object->second->isFunction() ||
+                subject == byID.end() ||
+                ! subject->second->isFunction())
+                continue;
+            static_cast<FunctionInfo&>(*subject->second).specs0.isVirtual = true;
+            static_cast<FunctionInfo&>(*object->second).specs0.isVirtual = true;
+        }
+    }
+
+    // Symbols which were also extracted are replaced
+    // by them, but namespaces are merged
+    std::size_t n = 0;
+    BitcodeSerializer serializer;
+    bitcodes_.reserve(bitcodes_.size() + infos.size());
+    for(auto const& I : infos)
+    {
+        llvm::StringRef const key(I->id);
+        if(! I->isNamespace() && bitcodes.count(key))
+            continue;
+        bitcodes_.emplace_back(serializer.write(*I));
+        bitcodes[key].emplace_back(bitcodes_.back().data);
+        ++n;
+    }
+    return n;
+}
+
+} // mrdox
+} // clang
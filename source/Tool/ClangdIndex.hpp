@@ -0,0 +1,155 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_CLANGDINDEX_HPP
+#define MRDOX_TOOL_CLANGDINDEX_HPP
+
+#include "ConfigImpl.hpp"
+#include "AST/Bitcode.hpp"
+#include <mrdox/Platform.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/StringSet.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Symbols imported from a clangd index.
+
+    The index is the YAML written by
+    `clangd-indexer --format=yaml`. Its symbols,
+    locations, documentation, bases and overrides
+    become the skeleton of the corpus, without
+    parsing any translation unit.
+
+    The index keeps only a few of the properties
+    of each declaration, and its types are text,
+    so the translation units which need more are
+    extracted as usual. The symbols of the index
+    are then matched with the extracted ones, and
+    an extracted symbol replaces the imported one.
+
+    clangd identifies a symbol by the first eight
+    bytes of the SHA1 of its USR, while the corpus
+    uses all twenty. The full ID is recomputed for
+    namespaces and records whose USR follows from
+    their name, and is otherwise taken from an
+    extracted symbol with the same prefix. The
+    remaining symbols keep the prefix, padded with
+    zeros, which is unique within the index.
+*/
+class ClangdIndex
+{
+    struct Location
+    {
+        // absolute posix-style path
+        std::string file;
+        // 1-based
+        unsigned line = 0;
+    };
+
+    struct Symbol
+    {
+        // the eight bytes of the clangd ID
+        std::string id;
+        std::string name;
+        // "a::b::", or empty for the global scope
+        std::string scope;
+        std::string kind;
+        std::string templateArgs;
+        std::string signature;
+        std::string returnType;
+        std::string type;
+        std::string documentation;
+        Location decl;
+        Location def;
+    };
+
+    struct Relation
+    {
+        std::string subject;
+        std::string object;
+        bool baseOf;
+    };
+
+    ConfigImpl const& config_;
+    std::vector<Symbol> symbols_;
+    std::vector<Relation> relations_;
+    llvm::StringSet<> files_;
+    std::vector<Bitcode> bitcodes_;
+
+    explicit
+    ClangdIndex(
+        ConfigImpl const& config) noexcept
+        : config_(config)
+    {
+    }
+
+    Error
+    parse(
+        std::string_view path,
+        llvm::StringRef text);
+
+public:
+    /** Load an index from a file.
+    */
+    static
+    Expected<std::unique_ptr<ClangdIndex>>
+    load(
+        std::string_view path,
+        ConfigImpl const& config);
+
+    /** Return the number of symbols in the index.
+    */
+    std::size_t
+    size() const noexcept
+    {
+        return symbols_.size();
+    }
+
+    /** Return true if the index has seen a file.
+
+        A file is seen when a symbol or a reference
+        of the index is located in it, which is
+        the case for nearly every indexed source.
+
+        @param path The posix-style full path.
+    */
+    bool
+    hasFile(
+        llvm::StringRef path) const noexcept
+    {
+        return files_.contains(path);
+    }
+
+    /** Add the bitcode of the imported symbols.
+
+        The bitcodes already in the collection are
+        those of the extracted symbols. An imported
+        symbol which was also extracted is left out,
+        except for namespaces, which are merged.
+
+        The added bitcodes refer to memory owned
+        by the index, which must outlive them.
+
+        @return The number of symbols added.
+    */
+    std::size_t
+    insertInto(
+        Bitcodes& bitcodes);
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -45,5 +45,19 @@ Config() noexcept
 Config::
 ~Config() noexcept = default;
 
+Expected<std::shared_ptr<Config const>>
+createConfig(
+    std::string_view workingDir,
+    std::string_view addonsDir,
+    std::string_view configYaml,
+    std::string_view extraYaml)
+{
+    auto config = createConfigFromYAML(
+        workingDir, addonsDir, configYaml, extraYaml);
+    if(! config)
+        return config.error();
+    return std::shared_ptr<Config const>(std::move(*config));
+}
+
 } // mrdox
 } // clang
@@ -10,17 +10,21 @@
 //
 
 #include "Tool/ConfigImpl.hpp"
+#include "Support/Compression.hpp"
 #include "Support/Debug.hpp"
 #include "Support/Error.hpp"
 #include "Support/Path.hpp"
 #include "Support/YamlFwd.hpp"
+#include <mrdox/Metadata.hpp>
 #include <mrdox/Support/Path.hpp>
 #include <clang/Tooling/AllTUsExecution.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/YAMLParser.h>
 #include <llvm/Support/YAMLTraits.h>
+#include <type_traits>
 
 //------------------------------------------------
 //
@@ -36,6 +40,22 @@ struct llvm::yaml::MappingTraits<
         clang::mrdox::ConfigImpl::FileFilter& f)
     {
         io.mapOptional("include", f.include);
+        io.mapOptional("exclude", f.exclude);
+    }
+};
+
+template<>
+struct llvm::yaml::MappingTraits<
+    clang::mrdox::ConfigImpl::Selection>
+{
+    static void mapping(IO &io,
+        clang::mrdox::ConfigImpl::Selection& f)
+    {
+        io.mapOptional("names",      f.names);
+        io.mapOptional("files",      f.files);
+        io.mapOptional("ids",        f.ids);
+        io.mapOptional("parents",    f.parents);
+        io.mapOptional("references", f.references);
     }
 };
 
@@ -49,14 +69,45 @@ struct llvm::yaml::MappingTraits<
         io.mapOptional("ignore-failures",   cfg.ignoreFailures);
         io.mapOptional("multipage",         cfg.multiPage);
         io.mapOptional("verbose",           cfg.verboseOutput);
+        io.mapOptional("progress",          cfg.progress);
         io.mapOptional("with-private",      cfg.includePrivate);
         io.mapOptional("with-anonymous",    cfg.includeAnonymous);
         io.mapOptional("concurrency",       cfg.concurrency);
+        io.mapOptional("dom-cache-size",    cfg.domCacheSize);
+        io.mapOptional("dom-prebuild",      cfg.domPrebuild);
+        io.mapOptional("incremental-output", cfg.incrementalOutput);
+        io.mapOptional("shard-depth",       cfg.shardDepth);
+        io.mapOptional("output-compression", cfg.outputCompression);
+        io.mapOptional("output-archive",    cfg.outputArchive);
 
         io.mapOptional("defines",           cfg.additionalDefines_);
         io.mapOptional("source-root",       cfg.sourceRoot_);
+        io.mapOptional("source-roots",      cfg.sourceRoots_);
+        io.mapOptional("source-exclude",    cfg.sourceExclude_);
+        io.mapOptional("cache-dir",         cfg.cacheDir_);
+        io.mapOptional("remote-cache",      cfg.remoteCache_);
+        io.mapOptional("remote-cache-upload", cfg.remoteCacheUpload_);
+        io.mapOptional("use-pch",           cfg.usePCH_);
+        io.mapOptional("jumbo-size",        cfg.jumboSize_);
+        io.mapOptional("scan-includes",     cfg.scanIncludes_);
+        io.mapOptional("streaming-reduce",  cfg.streamingReduce_);
+        io.mapOptional("skip-instantiations", cfg.skipInstantiations_);
+        io.mapOptional("spill-dir",         cfg.spillDir_);
+        io.mapOptional("spill-threshold",   cfg.spillThreshold_);
+        io.mapOptional("memory-budget",     cfg.memoryBudget_);
+        io.mapOptional("tu-timeout",        cfg.tuTimeout_);
+        io.mapOptional("deadline",          cfg.deadline_);
+        io.mapOptional("numa",              cfg.numa_);
+        io.mapOptional("header-scan",       cfg.headerScan_);
+        io.mapOptional("headers",           cfg.headers_);
+        io.mapOptional("stats",             cfg.stats_);
+        io.mapOptional("stats-file",        cfg.statsFile_);
+        io.mapOptional("tu-stats",          cfg.tuStats_);
+        io.mapOptional("clangd-index",      cfg.clangdIndex_);
+        io.mapOptional("reparse",           cfg.reparse_);
 
         io.mapOptional("input",             cfg.input_);
+        io.mapOptional("select",            cfg.select_);
     }
 };
 
@@ -65,6 +116,94 @@ struct llvm::yaml::MappingTraits<
 namespace clang {
 namespace mrdox {
 
+/** Add patterns to a filter, made absolute and posix style.
+*/
+static
+void
+addPatterns(
+    PathFilter& filter,
+    std::vector<std::string> const& patterns,
+    std::string_view workingDir,
+    std::string_view key)
+{
+    for(auto const& s : patterns)
+    {
+        std::string pattern = files::makePosixStyle(
+            files::makeAbsolute(s, workingDir));
+        // a directory keeps its trailing separator
+        if(files::isDirsy(s) && ! files::isDirsy(pattern))
+            pattern.push_back('/');
+        if(auto err = filter.add(pattern))
+            formatError("{}: {}", key, err).Throw();
+    }
+}
+
+/** Add globs to a list.
+*/
+static
+void
+addGlobs(
+    std::vector<llvm::GlobPattern>& globs,
+    std::vector<std::string> const& patterns,
+    std::string_view key)
+{
+    for(auto const& s : patterns)
+    {
+        auto glob = llvm::GlobPattern::create(s);
+        if(! glob)
+            formatError("{}: invalid pattern \"{}\": {}",
+                key, s, toString(glob.takeError())).Throw();
+        globs.emplace_back(std::move(*glob));
+    }
+}
+
+std::string
+ConfigImpl::
+extractionOptions() const
+{
+    // the fields are separated by newlines and the
+    // elements of a list by nulls, which no path holds
+    std::string result;
+    auto const add = [&](llvm::StringRef name, auto const& value)
+    {
+        result += name;
+        result += '=';
+        if constexpr(std::is_same_v<std::decay_t<
+                decltype(value)>, std::vector<std::string>>)
+        {
+            for(auto const& s : value)
+            {
+                result += s;
+                result += '\0';
+            }
+        }
+        else if constexpr(std::is_same_v<std::decay_t<
+                decltype(value)>, bool>)
+        {
+            result += value ? "true" : "false";
+        }
+        else
+        {
+            result += value;
+        }
+        result += '\n';
+    };
+    add("source-root", sourceRoot_);
+    add("source-roots", sourceRoots_);
+    add("source-exclude", sourceExclude_);
+    add("input.include", input_.include);
+    add("input.exclude", input_.exclude);
+    add("include-private", includePrivate);
+    add("include-anonymous", includeAnonymous);
+    add("skip-instantiations", skipInstantiations_);
+    add("select.names", select_.names);
+    add("select.files", select_.files);
+    add("select.ids", select_.ids);
+    add("select.parents", select_.parents);
+    add("select.references", select_.references);
+    return result;
+}
+
 ConfigImpl::
 ConfigImpl(
     llvm::StringRef workingDir_,
@@ -104,17 +243,73 @@ ConfigImpl(
     // Post-process as needed
     if( concurrency == 0)
         concurrency = llvm::thread::hardware_concurrency();
+    if(verboseOutput)
+        progress = true;
 
     // This has to be forward slash style
     sourceRoot_ = files::makePosixStyle(files::makeDirsy(
         files::makeAbsolute(sourceRoot_, workingDir)));
+    sourceRootFilter_.add(sourceRoot_).maybeThrow();
+    for(auto& name : sourceRoots_)
+    {
+        name = files::makePosixStyle(files::makeDirsy(
+            files::makeAbsolute(name, workingDir)));
+        sourceRootFilter_.add(name).maybeThrow();
+    }
+    addPatterns(sourceExcludes_, sourceExclude_,
+        workingDir, "source-exclude");
 
-    // adjust input files
-    for(auto& name : inputFileIncludes_)
+    if(! cacheDir_.empty())
+        cacheDir_ = files::makeAbsolute(cacheDir_, workingDir);
+    // spill-threshold is in megabytes
+    if(! spillDir_.empty())
+        spillDir_ = files::makeAbsolute(spillDir_, workingDir);
+    if(! statsFile_.empty())
+        statsFile_ = files::makeAbsolute(statsFile_, workingDir);
+    if(! tuStats_.empty())
+        tuStats_ = files::makeAbsolute(tuStats_, workingDir);
+    if(! clangdIndex_.empty())
+        clangdIndex_ = files::makeAbsolute(clangdIndex_, workingDir);
+    addPatterns(reparseFilter_, reparse_,
+        workingDir, "reparse");
+
+    if(! headerScan_.empty() &&
+        headerScan_ != "umbrella" &&
+        headerScan_ != "each")
+        formatError("header-scan \"{}\" is not \"umbrella\" or \"each\"",
+            headerScan_).Throw();
+    for(auto& name : headers_)
         name = files::makePosixStyle(
             files::makeAbsolute(name, workingDir));
+    parseOutputCompression(outputCompression).error().maybeThrow();
+    if(! outputArchive.empty() &&
+        outputArchive != "none" &&
+        outputArchive != "tar")
+        formatError("output-archive \"{}\" is not \"none\" or \"tar\"",
+            outputArchive).Throw();
+    if(outputArchive == "tar" && incrementalOutput)
+        formatError("output-archive cannot be used with incremental-output").Throw();
 
-    threadPool_.reset(concurrency);
+    // adjust input files
+    addPatterns(inputIncludes_, input_.include,
+        workingDir, "input.include");
+    addPatterns(inputExcludes_, input_.exclude,
+        workingDir, "input.exclude");
+
+    // file globs match the paths of the
+    // locations, relative to the source root
+    addGlobs(selectNames_, select_.names, "select.names");
+    addGlobs(selectFiles_, select_.files, "select.files");
+    for(auto const& s : select_.ids)
+    {
+        std::string bytes;
+        if(! llvm::tryGetFromHex(s, bytes) ||
+            bytes.size() != SymbolID().size())
+            formatError("select.ids: \"{}\" is not a symbol ID", s).Throw();
+        selectIds_.emplace_back(bytes.data());
+    }
+
+    threadPool_.reset(concurrency, numa_);
 }
 
 //------------------------------------------------
@@ -124,12 +319,10 @@ ConfigImpl::
 shouldVisitTU(
     llvm::StringRef filePath) const noexcept
 {
-    if(inputFileIncludes_.empty())
-        return true;
-    for(auto const& s : inputFileIncludes_)
-        if(filePath == s)
-            return true;
-    return false;
+    if(! inputIncludes_.empty() &&
+        ! inputIncludes_.match(filePath))
+        return false;
+    return ! inputExcludes_.match(filePath);
 }
 
 bool
@@ -138,8 +331,6 @@ shouldExtractFromFile(
     llvm::StringRef filePath,
     std::string& prefixPath) const noexcept
 {
-    namespace path = llvm::sys::path;
-
     SmallPathString temp;
     if(! files::isAbsolute(filePath))
     {
@@ -150,13 +341,49 @@ shouldExtractFromFile(
     {
         temp = filePath;
     }
-    if(! path::replace_path_prefix(temp, sourceRoot_, "", path::Style::posix))
+    auto const root = sourceRootFilter_.matchDirectory(temp);
+    if(root.empty() || sourceExcludes_.match(temp))
         return false;
-    MRDOX_ASSERT(files::isDirsy(sourceRoot_));
-    prefixPath.assign(sourceRoot_.begin(), sourceRoot_.end());
+    MRDOX_ASSERT(files::isDirsy(root));
+    prefixPath.assign(root.begin(), root.end());
     return true;
 }
 
+bool
+ConfigImpl::
+isSelected(
+    Info const& I,
+    llvm::StringRef qualifiedName) const
+{
+    if(std::find(selectIds_.begin(), selectIds_.end(),
+            I.id) != selectIds_.end())
+        return true;
+    for(auto const& glob : selectNames_)
+        if(glob.match(qualifiedName))
+            return true;
+    if(selectFiles_.empty())
+        return false;
+    return visit(I, [&]<class T>(T const& J)
+        {
+            if constexpr(std::derived_from<T, SourceInfo>)
+            {
+                auto const match = [&](Location const& loc)
+                {
+                    for(auto const& glob : selectFiles_)
+                        if(glob.match(loc.filename()))
+                            return true;
+                    return false;
+                };
+                if(J.DefLoc && match(*J.DefLoc))
+                    return true;
+                for(auto const& loc : J.Loc)
+                    if(match(loc))
+                        return true;
+            }
+            return false;
+        });
+}
+
 void
 ConfigImpl::
 yamlDiagnostic(
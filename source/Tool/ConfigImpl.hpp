@@ -12,11 +12,15 @@
 #ifndef MRDOX_TOOL_CONFIGIMPL_HPP
 #define MRDOX_TOOL_CONFIGIMPL_HPP
 
+#include "Support/PathFilter.hpp"
 #include "Support/YamlFwd.hpp"
 #include <mrdox/Config.hpp>
+#include <mrdox/MetadataFwd.hpp>
+#include <mrdox/Metadata/Symbols.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/ThreadPool.hpp>
 #include <llvm/ADT/SmallString.h>
+#include <llvm/Support/GlobPattern.h>
 #include <llvm/Support/ThreadPool.h>
 #include <memory>
 
@@ -37,19 +41,60 @@ public:
     struct FileFilter
     {
         std::vector<std::string> include;
+        std::vector<std::string> exclude;
+    };
+
+    struct Selection
+    {
+        std::vector<std::string> names;
+        std::vector<std::string> files;
+        std::vector<std::string> ids;
+        bool parents = true;
+        bool references = false;
     };
 
     std::vector<std::string> additionalDefines_;
     std::string sourceRoot_;
+    std::vector<std::string> sourceRoots_;
+    std::vector<std::string> sourceExclude_;
+    std::string cacheDir_;
+    std::string remoteCache_;
+    bool remoteCacheUpload_ = true;
+    bool usePCH_ = false;
+    std::size_t jumboSize_ = 0;
+    bool scanIncludes_ = false;
+    bool streamingReduce_ = false;
+    bool skipInstantiations_ = false;
+    std::string spillDir_;
+    std::size_t spillThreshold_ = 4096;
+    std::size_t memoryBudget_ = 0;
+    unsigned tuTimeout_ = 0;
+    unsigned deadline_ = 0;
+    bool numa_ = false;
+    std::string headerScan_;
+    std::vector<std::string> headers_;
+    bool stats_ = false;
+    std::string statsFile_;
+    std::string tuStats_;
+    std::string clangdIndex_;
+    std::vector<std::string> reparse_;
 
     FileFilter input_;
+    Selection select_;
 
     //--------------------------------------------
 
 private:
     ThreadPool mutable threadPool_;
     llvm::SmallString<0> outputPath_;
-    std::vector<std::string> inputFileIncludes_;
+    PathFilter inputIncludes_;
+    PathFilter inputExcludes_;
+    PathFilter sourceRootFilter_;
+    PathFilter sourceExcludes_;
+    PathFilter reparseFilter_;
+    std::vector<llvm::GlobPattern> selectNames_;
+    std::vector<llvm::GlobPattern> selectFiles_;
+    std::vector<SymbolID> selectIds_;
 
     friend class Config;
     friend class Options;
@@ -82,6 +127,16 @@ public:
         return sourceRoot_;
     }
 
+    /** Return the full path to the translation unit cache.
+
+        The cache is disabled when this is empty.
+    */
+    std::string_view
+    cacheDir() const noexcept
+    {
+        return cacheDir_;
+    }
+
     //--------------------------------------------
     //
     // Private Interface
@@ -90,6 +145,10 @@ public:
 
     /** Returns true if the translation unit should be visited.
 
+        The file is visited if it matches the
+        input includes, or there are none, and
+        does not match the input excludes.
+
         @param filePath The posix-style full path
         to the file being processed.
     */
@@ -99,9 +158,12 @@ public:
 
     /** Returns true if the file should be visited.
 
-        If the file is visited, then prefix is
-        set to the portion of the file path which
-        should be be removed for matching files.
+        The file is visited if it is below one of
+        the source roots, and does not match the
+        source excludes. If the file is visited,
+        then prefix is set to the longest source
+        root which contains it, which should be
+        removed for matching files.
 
         @param filePath A posix-style full or
         relative path to the file being processed.
@@ -116,6 +178,61 @@ public:
         llvm::StringRef filePath,
         std::string& prefix) const noexcept;
 
+    /** Return true if a translation unit is reparsed with a clangd index.
+
+        When symbols are imported from a clangd
+        index, the translation units which match
+        the reparse patterns are still extracted,
+        for the information the index lacks.
+
+        @param filePath The posix-style full path
+        to the translation unit.
+    */
+    bool
+    shouldReparseTU(
+        llvm::StringRef filePath) const noexcept
+    {
+        return reparseFilter_.match(filePath);
+    }
+
+    /** Return true if only a subset of the symbols is rendered.
+    */
+    bool
+    hasSelection() const noexcept
+    {
+        return ! selectNames_.empty() ||
+            ! selectFiles_.empty() ||
+            ! selectIds_.empty();
+    }
+
+    /** Return true if the selection names a symbol.
+
+        A symbol is named when its fully qualified
+        name matches one of the name globs, one of
+        its locations matches one of the file globs,
+        or its ID is listed. The parents and the
+        references are added by the corpus.
+
+        @param I The symbol.
+
+        @param qualifiedName The fully qualified
+        name of the symbol.
+    */
+    bool
+    isSelected(
+        Info const& I,
+        llvm::StringRef qualifiedName) const;
+
+    /** Return the options which change the results of extraction.
+
+        The string holds every option which decides
+        the symbols extracted from a translation unit
+        or the file names they record, so that cached
+        results are not used when one of them changes.
+    */
+    std::string
+    extractionOptions() const;
+
     /** A diagnostic handler for reading YAML files.
     */
     static void yamlDiagnostic(llvm::SMDiagnostic const&, void*);
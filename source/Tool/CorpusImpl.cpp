@@ -12,49 +12,27 @@
 #include "AST/Bitcode.hpp"
 #include "AST/FrontendAction.hpp"
 #include "CorpusImpl.hpp"
+#include "StreamingReducer.hpp"
+#include "ToolExecutor.hpp"
 #include "Metadata/Reduce.hpp"
 #include "Support/Error.hpp"
+#include "Support/Memory.hpp"
+#include "Support/Metrics.hpp"
+#include "Support/PhaseReport.hpp"
+#include "Support/Progress.hpp"
+#include "Support/Radix.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Metadata.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <llvm/ADT/STLExtras.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <optional>
 
 namespace clang {
 namespace mrdox {
 
-// A standalone function to call to merge a vector of infos into one.
-// This assumes that all infos in the vector are of the same type, and will fail
-// if they are different.
-// Dispatch function.
-llvm::Expected<std::unique_ptr<Info>>
-mergeInfos(std::vector<std::unique_ptr<Info>>& Values)
-{
-    if (Values.empty() || !Values[0])
-        return llvm::createStringError(llvm::inconvertibleErrorCode(),
-            "no info values to merge");
-
-    switch (Values[0]->Kind) {
-    case InfoKind::Namespace:
-        return reduce<NamespaceInfo>(Values);
-    case InfoKind::Record:
-        return reduce<RecordInfo>(Values);
-    case InfoKind::Enum:
-        return reduce<EnumInfo>(Values);
-    case InfoKind::Function:
-        return reduce<FunctionInfo>(Values);
-    case InfoKind::Typedef:
-        return reduce<TypedefInfo>(Values);
-    case InfoKind::Variable:
-        return reduce<VariableInfo>(Values);
-    case InfoKind::Field:
-        return reduce<FieldInfo>(Values);
-    case InfoKind::Specialization:
-        return reduce<SpecializationInfo>(Values);
-    default:
-        return llvm::createStringError(llvm::inconvertibleErrorCode(),
-            "unexpected info type");
-    }
-}
-
 //------------------------------------------------
 
 Info*
@@ -62,10 +40,7 @@ CorpusImpl::
 find(
     SymbolID const& id) noexcept
 {
-    auto it = InfoMap.find(StringRef(id));
-    if(it != InfoMap.end())
-        return it->second.get();
-    return nullptr;
+    return InfoMap[shardIndex(id)].infos.find(id);
 }
 
 Info const*
@@ -73,10 +48,150 @@ CorpusImpl::
 find(
     SymbolID const& id) const noexcept
 {
-    auto it = InfoMap.find(StringRef(id));
-    if(it != InfoMap.end())
-        return it->second.get();
-    return nullptr;
+    return InfoMap[shardIndex(id)].infos.find(id);
+}
+
+std::uint32_t
+CorpusImpl::
+indexOf(
+    SymbolID const& id) const noexcept
+{
+    return InfoMap[shardIndex(id)].infos.findIndex(id);
+}
+
+References const&
+CorpusImpl::
+references(
+    SymbolID const& id) const noexcept
+{
+    static References const empty;
+    auto const& refs = InfoMap[shardIndex(id)].refs;
+    auto it = refs.find(StringRef(id));
+    if(it != refs.end())
+        return it->second;
+    return empty;
+}
+
+std::string_view
+CorpusImpl::
+qualifiedName(
+    Info const& I) const noexcept
+{
+    auto const& names = InfoMap[shardIndex(I.id)].names;
+    auto it = names.find(&I);
+    MRDOX_ASSERT(it != names.end());
+    return it->second;
+}
+
+std::span<OverloadInfo const>
+CorpusImpl::
+overloads(
+    Info const& scope) const noexcept
+{
+    auto const& overloads = InfoMap[shardIndex(scope.id)].overloads;
+    auto it = overloads.find(&scope);
+    if(it != overloads.end())
+        return it->second.list;
+    return {};
+}
+
+std::shared_ptr<Interface const>
+CorpusImpl::
+getInterface(
+    RecordInfo const& I) const
+{
+    auto const& shard = InfoMap[shardIndex(I.id)];
+    {
+        std::lock_guard<llvm::sys::Mutex> lock(shard.mutex);
+        auto it = shard.interfaces.find(&I);
+        if(it != shard.interfaces.end())
+            return it->second;
+    }
+    // build outside the lock; if another thread
+    // got there first, its interface is kept
+    auto sp = std::make_shared<Interface const>(
+        makeInterface(I, *this));
+    std::lock_guard<llvm::sys::Mutex> lock(shard.mutex);
+    return shard.interfaces.try_emplace(&I, std::move(sp)).first->second;
+}
+
+std::span<Info const* const>
+CorpusImpl::
+findByName(
+    std::string_view name) const noexcept
+{
+    // the index is sorted by name
+    auto const [first, last] = std::equal_range(
+        indexNames_.begin(), indexNames_.end(), name);
+    return { index_.data() + (first - indexNames_.begin()),
+        static_cast<std::size_t>(last - first) };
+}
+
+std::span<Info const* const>
+CorpusImpl::
+findByPrefix(
+    std::string_view prefix) const noexcept
+{
+    auto const first = std::lower_bound(
+        indexNames_.begin(), indexNames_.end(), prefix);
+    auto const last = std::partition_point(
+        first, indexNames_.end(),
+        [&](std::string_view name)
+        {
+            return name.substr(0, prefix.size()) == prefix;
+        });
+    return { index_.data() + (first - indexNames_.begin()),
+        static_cast<std::size_t>(last - first) };
+}
+
+bool
+CorpusImpl::
+isSelected(
+    Info const& I) const noexcept
+{
+    return ! config_->hasSelection() ||
+        selected_.contains(&I);
+}
+
+bool
+CorpusImpl::
+hasSelected(
+    Info const& I) const noexcept
+{
+    return ! config_->hasSelection() ||
+        enclosing_.contains(&I);
+}
+
+std::string&
+CorpusImpl::
+buildQualifiedName(
+    Corpus const& corpus,
+    Info const& I,
+    std::string& temp)
+{
+    temp.clear();
+    for(auto const& ns_id : llvm::reverse(I.Namespace))
+    {
+        if(const Info* ns = corpus.find(ns_id))
+            temp.append(ns->Name.data(), ns->Name.size());
+        else
+            temp.append("<unnamed>");
+
+        temp.append("::");
+    }
+    auto s = I.extractName();
+    temp.append(s.data(), s.size());
+    return temp;
+}
+
+std::size_t
+CorpusImpl::
+size() const noexcept
+{
+    std::size_t n = 0;
+    for(auto const& shard : InfoMap)
+        n += shard.infos.size();
+    return n;
 }
 
 //------------------------------------------------
@@ -85,12 +200,464 @@ void
 CorpusImpl::
 insert(std::unique_ptr<Info> I)
 {
-    std::lock_guard<llvm::sys::Mutex> Guard(mutex_);
+    auto& shard = InfoMap[shardIndex(I->id)];
+    std::lock_guard<llvm::sys::Mutex> Guard(shard.mutex);
+    shard.infos.insert(shard.arena.adopt(std::move(I)));
+}
 
-    index_.emplace_back(I.get());
+void
+CorpusImpl::
+insertBorrowed(Info& I)
+{
+    auto& shard = InfoMap[shardIndex(I.id)];
+    std::lock_guard<llvm::sys::Mutex> Guard(shard.mutex);
+    shard.infos.insert(&I);
+}
 
-    // This has to come last because we move I.
-    InfoMap[StringRef(I->id)] = std::move(I);
+void
+CorpusImpl::
+buildPools(Info& I)
+{
+    if(I.javadoc)
+        I.javadoc->buildPool();
+    if(I.isEnum())
+        for(auto& V : static_cast<EnumInfo&>(I).Members)
+            if(V.javadoc)
+                V.javadoc->buildPool();
+}
+
+template<class F>
+Error
+CorpusImpl::
+forEachShard(F const& f) const
+{
+    TaskGroup taskGroup(pool());
+    for(std::size_t i = 0; i < NumShards; ++i)
+        taskGroup.async(shardNode(i),
+            [&f, i]
+            {
+                f(i);
+            });
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        return Error(errors);
+    return Error::success();
+}
+
+Error
+CorpusImpl::
+finalize()
+{
+    ScopedPhase phase("finalize");
+    struct Entry
+    {
+        std::string_view name;
+        Info const* I;
+    };
+
+    auto const less = [](Entry const& a, Entry const& b)
+    {
+        if(int const c = a.name.compare(b.name))
+            return c < 0;
+        return a.I->id < b.I->id;
+    };
+
+    // Each shard computes the qualified names and
+    // javadoc pools of its symbols and is sorted on
+    // its own thread, then the sorted runs are
+    // merged pairwise.
+    std::array<std::vector<Entry>, NumShards> runs;
+    auto err = forEachShard(
+        [&](std::size_t i)
+        {
+            auto& shard = InfoMap[i];
+            auto& run = runs[i];
+            run.reserve(shard.infos.size());
+            shard.names.clear();
+            shard.names.reserve(shard.infos.size());
+            std::string temp;
+            shard.infos.forEach(
+                [&](Info& I)
+                {
+                    if(! borrowed_)
+                        buildPools(I);
+                    std::string_view name;
+                    if(! buildQualifiedName(*this, I, temp).empty())
+                    {
+                        char* p = shard.nameAlloc.Allocate<char>(temp.size());
+                        std::memcpy(p, temp.data(), temp.size());
+                        name = std::string_view(p, temp.size());
+                    }
+                    shard.names.try_emplace(&I, name);
+                    run.push_back({ name, &I });
+                });
+            std::sort(run.begin(), run.end(), less);
+        });
+    if(err)
+        return err;
+
+    std::vector<std::size_t> work;
+    for(std::size_t width = 1; width < NumShards; width *= 2)
+    {
+        work.clear();
+        for(std::size_t i = 0; i + width < NumShards; i += 2 * width)
+            work.push_back(i);
+        auto errors = pool().forEach(work,
+            [&](std::size_t i)
+            {
+                auto& a = runs[i];
+                auto& b = runs[i + width];
+                std::vector<Entry> merged;
+                merged.reserve(a.size() + b.size());
+                std::merge(
+                    std::make_move_iterator(a.begin()),
+                    std::make_move_iterator(a.end()),
+                    std::make_move_iterator(b.begin()),
+                    std::make_move_iterator(b.end()),
+                    std::back_inserter(merged), less);
+                a = std::move(merged);
+                b = {};
+            });
+        if(! errors.empty())
+            return Error(errors);
+    }
+
+    index_.clear();
+    index_.reserve(runs[0].size());
+    indexNames_.clear();
+    indexNames_.reserve(runs[0].size());
+    for(auto const& entry : runs[0])
+    {
+        index_.emplace_back(entry.I);
+        indexNames_.emplace_back(entry.name);
+    }
+    buildHeaders();
+
+    if(auto err = buildReferences())
+        return err;
+
+    if(auto err = buildOverloads())
+        return err;
+    buildSelection();
+    if(config_->stats_)
+        reportPeakMemory("finalize");
+
+    if(config.verboseOutput)
+    {
+        for(auto kind : {
+            InfoKind::Namespace, InfoKind::Record,
+            InfoKind::Function, InfoKind::Enum,
+            InfoKind::Typedef, InfoKind::Variable,
+            InfoKind::Field, InfoKind::Specialization })
+        {
+            InfoArena::Usage total;
+            for(auto const& shard : InfoMap)
+            {
+                auto const u = shard.arena.usage(kind);
+                total.count += u.count;
+                total.bytes += u.bytes;
+            }
+            if(total.count > 0)
+                reportInfo("{} {} symbols in {} bytes",
+                    total.count, std::string_view(toString(kind)),
+                    total.bytes);
+        }
+    }
+    return Error::success();
+}
+
+void
+CorpusImpl::
+buildHeaders()
+{
+    std::size_t const n = index_.size();
+    headers_.id.resize(n);
+    headers_.kind.resize(n);
+    headers_.access.resize(n);
+    headers_.parent.resize(n);
+    headers_.name.resize(n);
+
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        Info const& I = *index_[i];
+        headers_.id[i] = I.id;
+        headers_.kind[i] = I.Kind;
+        headers_.access[i] = I.Access;
+        headers_.name[i] = I.Name;
+        InfoMap[shardIndex(I.id)].infos.setIndex(
+            I.id, static_cast<std::uint32_t>(i));
+    }
+
+    headers_.childOffsets.clear();
+    headers_.childOffsets.reserve(n + 1);
+    headers_.children.clear();
+    auto const addChild = [&](SymbolID const& id)
+    {
+        std::uint32_t const j = indexOf(id);
+        if(j != SymbolHeaders::npos)
+            headers_.children.push_back(j);
+    };
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        Info const& I = *index_[i];
+        headers_.parent[i] = SymbolHeaders::npos;
+        for(auto const& id : I.Namespace)
+        {
+            std::uint32_t const p = indexOf(id);
+            if(p != SymbolHeaders::npos)
+            {
+                headers_.parent[i] = p;
+                break;
+            }
+        }
+
+        headers_.childOffsets.push_back(
+            static_cast<std::uint32_t>(headers_.children.size()));
+        visit(I, [&]<class T>(T const& J)
+        {
+            if constexpr(
+                T::isNamespace() ||
+                T::isRecord())
+            {
+                for(auto const& id : J.Members)
+                    addChild(id);
+                for(auto const& id : J.Specializations)
+                    addChild(id);
+            }
+            else if constexpr(T::isSpecialization())
+            {
+                for(auto const& M : J.Members)
+                    addChild(M.Specialized);
+            }
+        });
+    }
+    headers_.childOffsets.push_back(
+        static_cast<std::uint32_t>(headers_.children.size()));
+}
+
+Error
+CorpusImpl::
+buildOverloads()
+{
+    // Each scope only reads the corpus,
+    // so the shards are done in parallel
+    return forEachShard(
+        [&](std::size_t i)
+        {
+            auto& shard = InfoMap[i];
+            shard.overloads.clear();
+            shard.infos.forEach(
+                [&](Info const& I)
+                {
+                    if(I.isNamespace())
+                        shard.overloads.try_emplace(&I, makeNamespaceOverloads(
+                            static_cast<NamespaceInfo const&>(I), *this));
+                    else if(I.isRecord())
+                        shard.overloads.try_emplace(&I, makeRecordOverloads(
+                            static_cast<RecordInfo const&>(I), *this));
+                });
+        });
+}
+
+namespace {
+
+/** An edge from the symbol `from` to the symbol `to`.
+*/
+struct Edge
+{
+    SymbolID to;
+    SymbolID from;
+    std::vector<SymbolID> References::* list;
+};
+
+/** Invoke a function with the ID of each symbol named in a type.
+*/
+template<class F>
+void
+forEachTypeID(
+    TypeInfo const* T,
+    F const& f)
+{
+    if(! T)
+        return;
+    visit(*T, [&]<class Ty>(Ty const& t)
+    {
+        if constexpr(requires { t.id; })
+            if(t.id != SymbolID::zero)
+                f(t.id);
+        if constexpr(requires { t.PointeeType; })
+            forEachTypeID(t.PointeeType.get(), f);
+        if constexpr(requires { t.ElementType; })
+            forEachTypeID(t.ElementType.get(), f);
+        if constexpr(requires { t.PatternType; })
+            forEachTypeID(t.PatternType.get(), f);
+        if constexpr(requires { t.ParamTypes; })
+        {
+            forEachTypeID(t.ReturnType.get(), f);
+            for(auto const& p : t.ParamTypes)
+                forEachTypeID(p.get(), f);
+        }
+    });
+}
+
+} // (anon)
+
+Error
+CorpusImpl::
+buildReferences()
+{
+    // Each task finds the edges leaving the symbols
+    // of one shard, and buckets them by the shard of
+    // the symbol they point to.
+    using Buckets = std::array<std::vector<Edge>, NumShards>;
+    std::array<Buckets, NumShards> edges;
+    auto err = forEachShard(
+        [&](std::size_t i)
+        {
+            auto& out = edges[i];
+            auto const add = [&](SymbolID const& to, SymbolID const& from,
+                std::vector<SymbolID> References::* list)
+            {
+                if(to != from)
+                    out[shardIndex(to)].push_back({ to, from, list });
+            };
+            InfoMap[i].infos.forEach(
+                [&](Info const& I)
+                {
+                    if(I.isRecord())
+                    {
+                        for(auto const& B : static_cast<RecordInfo const&>(I).Bases)
+                        {
+                            if(! B.Type)
+                                continue;
+                            visit(*B.Type, [&]<class Ty>(Ty const& t)
+                            {
+                                if constexpr(requires { t.id; })
+                                    if(t.id != SymbolID::zero)
+                                        add(t.id, I.id, &References::Derived);
+                            });
+                        }
+                    }
+                    else if(I.isFunction())
+                    {
+                        auto const& F = static_cast<FunctionInfo const&>(I);
+                        auto const use = [&](SymbolID const& id)
+                        {
+                            add(id, I.id, &References::Functions);
+                        };
+                        forEachTypeID(F.ReturnType.get(), use);
+                        for(auto const& P : F.Params)
+                            forEachTypeID(P.Type.get(), use);
+                    }
+                    else if(I.isSpecialization())
+                    {
+                        auto const& S = static_cast<SpecializationInfo const&>(I);
+                        if(S.Primary != SymbolID::zero)
+                            add(S.Primary, I.id, &References::Specializations);
+                    }
+                });
+        });
+    if(err)
+        return err;
+
+    // Each task collects the edges pointing
+    // into one shard, so no locking is needed.
+    return forEachShard(
+        [&](std::size_t i)
+        {
+            auto& refs = InfoMap[i].refs;
+            refs.clear();
+            for(auto& buckets : edges)
+                for(auto const& e : buckets[i])
+                    (refs[StringRef(e.to)].*e.list).push_back(e.from);
+            for(auto& kv : refs)
+            {
+                for(auto list : {
+                    &References::Derived,
+                    &References::Functions,
+                    &References::Specializations })
+                {
+                    auto& v = kv.second.*list;
+                    llvm::sort(v);
+                    v.erase(std::unique(v.begin(), v.end()), v.end());
+                }
+            }
+        });
+}
+
+void
+CorpusImpl::
+buildSelection()
+{
+    selected_.clear();
+    enclosing_.clear();
+    if(! config_->hasSelection())
+        return;
+
+    std::size_t const n = index_.size();
+    std::vector<char> selected(n);
+    for(std::size_t i = 0; i < n; ++i)
+        selected[i] = config_->isSelected(*index_[i], indexNames_[i]);
+    for(std::size_t i = 0; i < n; ++i)
+        if(selected[i])
+            selected_.insert(index_[i]);
+
+    // the reverse edges of a symbol name the
+    // selected symbols which refer to it
+    if(config_->select_.references)
+    {
+        auto const refers = [&](std::vector<SymbolID> const& ids)
+        {
+            for(auto const& id : ids)
+                if(selected_.contains(find(id)))
+                    return true;
+            return false;
+        };
+        for(std::size_t i = 0; i < n; ++i)
+        {
+            if(selected[i])
+                continue;
+            auto const& refs = references(headers_.id[i]);
+            if(refers(refs.Derived) ||
+                refers(refs.Functions) ||
+                refers(refs.Specializations))
+                selected[i] = 1;
+        }
+        for(std::size_t i = 0; i < n; ++i)
+            if(selected[i])
+                selected_.insert(index_[i]);
+    }
+
+    // the scopes are needed to reach the
+    // selected symbols, even when they are
+    // not rendered themselves
+    std::vector<char> enclosing(n);
+    std::vector<std::uint32_t> parents;
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        if(! selected[i])
+            continue;
+        enclosing[i] = 1;
+        for(auto p = headers_.parent[i];
+            p != SymbolHeaders::npos && ! enclosing[p];
+            p = headers_.parent[p])
+        {
+            enclosing[p] = 1;
+            if(! selected[p])
+                parents.push_back(p);
+        }
+    }
+    for(std::size_t i = 0; i < n; ++i)
+        if(enclosing[i])
+            enclosing_.insert(index_[i]);
+    enclosing_.insert(&globalNamespace());
+    if(config_->select_.parents)
+        for(auto p : parents)
+            selected_.insert(index_[p]);
+
+    if(config.verboseOutput)
+        reportInfo("{} of {} symbols selected",
+            selected_.size(), index_.size());
 }
 
 //------------------------------------------------
@@ -102,84 +669,338 @@ build(
     std::shared_ptr<Config const> config_)
 {
     auto config = std::dynamic_pointer_cast<ConfigImpl const>(config_);
-    auto corpus = std::make_unique<CorpusImpl>(config);
+    auto const* tex = dynamic_cast<ToolExecutor const*>(&ex);
+    BuildOptions const* options = tex ? tex->buildOptions() : nullptr;
 
     // Traverse the AST for all translation units
     // and emit serializd bitcode into tool results.
     // This operation happens ona thread pool.
-    if(corpus->config.verboseOutput)
+    if(config->verboseOutput)
         reportInfo("Mapping declarations");
-    if(auto err = ex.execute(
-        makeFrontendActionFactory(
-            *ex.getExecutionContext(), *config)))
     {
-        if(! corpus->config.ignoreFailures)
-            return toError(std::move(err));
-        reportWarning("warning: mapping failed because ", toString(std::move(err)));
+        ScopedPhase phase("mapping");
+        if(auto err = ex.execute(
+            makeFrontendActionFactory(
+                *ex.getExecutionContext(), *config)))
+        {
+            if(! config->ignoreFailures)
+                return toError(std::move(err));
+            reportWarning("mapping failed: {}", toString(std::move(err)));
+        }
     }
+    if(options && options->stop.stop_requested())
+        return formatError("the build was stopped");
+    if(config->stats_)
+        reportPeakMemory("mapping");
 
-    // Inject the global namespace
+    // With streaming reduction, the symbols
+    // were merged while they were extracted.
+    if(StreamingReducer* reducer = tex ? tex->reducer() : nullptr)
     {
-        // default-constructed NamespaceInfo
-        // describes the global namespace
-        NamespaceInfo I;
-        insertBitcode(
-            *ex.getExecutionContext(),
-            writeBitcode(I));
+        auto corpus = std::make_unique<CorpusImpl>(config);
+        reducer->take(
+            [&](std::unique_ptr<Info> I)
+            {
+                corpus->insert(std::move(I));
+            });
+        if(! corpus->find(SymbolID::zero))
+            corpus->insert(std::make_unique<NamespaceInfo>());
+        if(auto err = corpus->finalize())
+            return err;
+        if(corpus->config.verboseOutput)
+            llvm::outs() << "Collected " << corpus->size() << " symbols.\n";
+        if(reducer->failed())
+            return formatError("multiple errors occurred");
+        return corpus;
     }
 
     // Collect the symbols. Each symbol will have
     // a vector of one or more bitcodes. These will
     // be merged later.
-    if(corpus->config.verboseOutput)
+    if(config->verboseOutput)
         reportInfo("Collecting symbols");
+    std::optional<ScopedPhase> collecting(std::in_place, "collect");
     auto bitcodes = collectBitcodes(ex);
+    collecting.reset();
+
+    // bitcode from the cache is checked, while
+    // bitcode written by this run, even when it
+    // was spilled to disk meanwhile, is trusted
+    return build(bitcodes, config, options,
+        tex && tex->trustedResults());
+}
+
+mrdox::Expected<std::unique_ptr<Corpus>>
+CorpusImpl::
+build(
+    Bitcodes& bitcodes,
+    std::shared_ptr<Config const> config_,
+    BuildOptions const* options,
+    bool trusted)
+{
+    auto config = std::dynamic_pointer_cast<ConfigImpl const>(config_);
+    auto corpus = std::make_unique<CorpusImpl>(config);
 
     // First reducing phase (reduce all decls into one info per decl).
     if(corpus->config.verboseOutput)
         reportInfo("Reducing {} declarations", bitcodes.size());
     std::atomic<bool> GotFailure;
     GotFailure = false;
-    auto errors = corpus->config.threadPool().forEach(
-        bitcodes,
-        [&](auto& Group)
-        {
-            // One or more Info for the same symbol ID
-            std::vector<std::unique_ptr<Info>> Infos;
+    std::atomic<std::size_t> TotalBitcodes = 0;
+    std::atomic<std::size_t> UniqueBitcodes = 0;
+    // Decode a run of the bitcodes of one symbol and
+    // merge them into a result, so that the temporaries
+    // are released immediately
+    auto const decodeInto = [&](
+        std::unique_ptr<Info>& Merged,
+        std::span<StringRef const> Values) -> bool
+    {
+        // The abbreviations are parsed once per thread
+        thread_local BitcodeDecoder decoder;
 
-            // Each Bitcode can have multiple Infos
-            for (auto& bitcode : Group.getValue())
+        // Each Bitcode can have multiple Infos
+        for(auto const& bitcode : Values)
+        {
+            auto infos = decoder.read(bitcode, trusted);
+            if(! infos)
             {
-                auto infos = readBitcode(bitcode);
-                if(! infos)
+                reportError(infos.error(), "read bitcode");
+                GotFailure = true;
+                return false;
+            }
+            for(auto& I : *infos)
+            {
+                if(! reduceInto(Merged, *I))
                 {
-                    reportError(infos.error(), "read bitcode");
+                    reportError("merge metadata: mismatched info kinds");
                     GotFailure = true;
-                    return;
+                    return false;
                 }
-                std::move(
-                    infos->begin(),
-                    infos->end(),
-                    std::back_inserter(Infos));
             }
+        }
+        return true;
+    };
+
+    // The bitcodes are in the order the translation
+    // units finished, and are merged in an order
+    // which does not depend on the threads. The
+    // same header declaration seen by many
+    // translation units produces identical bitcode,
+    // which only needs to be decoded once.
+    auto const uniqueBitcodes = [&](auto& Group)
+    {
+        auto& Values = Group.getValue();
+        sortBitcodes(Values);
+        TotalBitcodes += Values.size();
+        Values.erase(std::unique(Values.begin(), Values.end()), Values.end());
+        UniqueBitcodes += Values.size();
+        return std::span<StringRef const>(Values);
+    };
+
+    auto const finish = [&](
+        auto& Group,
+        std::unique_ptr<Info> Merged)
+    {
+        if(! Merged)
+        {
+            reportError("merge metadata: no info values to merge");
+            GotFailure = true;
+            return;
+        }
+        canonicalize(*Merged);
+        MRDOX_ASSERT(Group.getKey() == StringRef(Merged->id));
+        corpus->insert(std::move(Merged));
+    };
 
-            auto merged = mergeInfos(Infos);
-            if(! merged)
+    auto const reduce = [&](auto& Group)
+    {
+        TraceScope Trace("reduce");
+        if(Trace)
+        {
+            char hex[40];
+            Trace.setDetail(toBase16(hex,
+                SymbolID(Group.getKey().data())));
+        }
+        std::unique_ptr<Info> Merged;
+        if(! decodeInto(Merged, uniqueBitcodes(Group)))
+            return;
+        finish(Group, std::move(Merged));
+    };
+
+    // A symbol which many translation units declare,
+    // such as the global namespace, would leave one
+    // task decoding long after the others finished.
+    // Its bitcodes are decoded in runs by separate
+    // tasks instead, and the partial results are
+    // merged pairwise in order once all are done.
+    constexpr std::size_t largeGroup = 1024;
+    constexpr std::size_t largeGrain = 256;
+    struct LargeGroup
+    {
+        Bitcodes::value_type* group;
+        std::span<StringRef const> values;
+        std::vector<std::unique_ptr<Info>> partials;
+    };
+    std::vector<LargeGroup> large;
+
+    // The symbols are reduced on the node which owns
+    // their shard, so the merged infos are allocated
+    // there. Each task reduces a block of one shard.
+    constexpr std::size_t grain = 256;
+    std::array<std::vector<Bitcodes::value_type*>, NumShards> shards;
+    for(auto& Group : bitcodes)
+    {
+        if(Group.getValue().size() >= largeGroup)
+            large.push_back({ &Group, {}, {} });
+        else
+            shards[shardIndex(SymbolID(Group.getKey().data()))].push_back(&Group);
+    }
+    std::optional<ScopedPhase> reducing(std::in_place, "reduce");
+    auto const stopped = [options]
+    {
+        return options && options->stop.stop_requested();
+    };
+    std::function<void(std::size_t, std::size_t)> OnReduced;
+    if(options && options->progress)
+        OnReduced = [options](std::size_t done, std::size_t total)
+        {
+            options->progress("reduce", done, total);
+        };
+    std::optional<Progress> Reducing;
+    Reducing.emplace("Reducing", bitcodes.size(), config->progress,
+        nullptr, std::move(OnReduced));
+    TaskGroup taskGroup(corpus->config.threadPool());
+    for(auto& L : large)
+    {
+        L.values = uniqueBitcodes(*L.group);
+        L.partials.resize((L.values.size() + largeGrain - 1) / largeGrain);
+        for(std::size_t k = 0; k < L.partials.size(); ++k)
+        {
+            taskGroup.async(
+                [&, k]
+                {
+                    TraceScope Trace("reduce part");
+                    if(stopped())
+                        return;
+                    auto& partial = L.partials[k];
+                    if(decodeInto(partial, L.values.subspan(
+                            k * largeGrain, std::min(largeGrain,
+                                L.values.size() - k * largeGrain))) &&
+                        partial)
+                        canonicalize(*partial);
+                });
+        }
+    }
+    for(std::size_t i = 0; i < NumShards; ++i)
+    {
+        for(std::size_t first = 0; first < shards[i].size(); first += grain)
+        {
+            taskGroup.async(corpus->shardNode(i),
+                [&, i, first]
+                {
+                    auto const& groups = shards[i];
+                    std::size_t const last =
+                        std::min(first + grain, groups.size());
+                    if(! stopped())
+                        for(std::size_t k = first; k < last; ++k)
+                            reduce(*groups[k]);
+                    Reducing->add(last - first);
+                });
+        }
+    }
+    auto errors = taskGroup.wait();
+
+    // Each level merges adjacent partial results of
+    // every large group, keeping the left one, so the
+    // order of the merges is that of the bitcodes.
+    // The partial results are kept canonical, so a
+    // merge is a union of two lists without repeats,
+    // whose size is bounded by the distinct members
+    // rather than by the number of contributions.
+    for(std::size_t width = 1; errors.empty() && ! stopped(); width *= 2)
+    {
+        std::size_t merges = 0;
+        for(auto& L : large)
+        {
+            for(std::size_t k = 0; k + width < L.partials.size(); k += 2 * width)
             {
-                reportError(toError(merged.takeError()), "merge metadata");
-                GotFailure = true;
-                return;
+                ++merges;
+                taskGroup.async(
+                    [&, k, width]
+                    {
+                        auto& left = L.partials[k];
+                        auto& right = L.partials[k + width];
+                        if(right && ! reduceInto(left, *right))
+                        {
+                            reportError("merge metadata: mismatched info kinds");
+                            GotFailure = true;
+                        }
+                        else if(left)
+                        {
+                            canonicalize(*left);
+                        }
+                        right.reset();
+                    });
             }
-
-            std::unique_ptr<Info> I(merged.get().release());
-            MRDOX_ASSERT(Group.getKey() == StringRef(I->id));
-            corpus->insert(std::move(I));
-        });
+        }
+        if(merges == 0)
+            break;
+        errors = taskGroup.wait();
+    }
+    if(errors.empty() && ! stopped())
+    {
+        for(auto& L : large)
+        {
+            finish(*L.group, L.partials.empty() ?
+                nullptr : std::move(L.partials.front()));
+            Reducing->add(1);
+        }
+    }
+    Reducing.reset();
+    reducing.reset();
     if(! errors.empty())
         return Error(errors);
+    if(stopped())
+        return formatError("the build was stopped");
+    if(config->stats_)
+        reportPeakMemory("reduction");
+
+    if(corpus->config.verboseOutput && UniqueBitcodes > 0)
+        reportInfo("Decoded {} of {} bitcodes ({:.1f}x deduplication)",
+            UniqueBitcodes.load(), TotalBitcodes.load(),
+            double(TotalBitcodes) / double(UniqueBitcodes));
+    setMetric("mrdox_bitcodes", TotalBitcodes.load());
+    setMetric("mrdox_bitcodes_decoded", UniqueBitcodes.load());
+    if(UniqueBitcodes > 0)
+        setMetric("mrdox_bitcode_dedup_ratio",
+            double(TotalBitcodes) / double(UniqueBitcodes));
+    setPhaseUnits("mapping", TotalBitcodes.load(), "symbol");
+    setPhaseUnits("reduce", bitcodes.size(), "merged symbol");
+
+    // Inject the global namespace, which
+    // exists even when it has no members
+    if(! corpus->find(SymbolID::zero))
+    {
+        // default-constructed NamespaceInfo
+        // describes the global namespace
+        corpus->insert(std::make_unique<NamespaceInfo>());
+    }
+    if(auto err = corpus->finalize())
+        return err;
 
     if(corpus->config.verboseOutput)
-        llvm::outs() << "Collected " << corpus->InfoMap.size() << " symbols.\n";
+        llvm::outs() << "Collected " << corpus->size() << " symbols.\n";
+    if(isCollectingMetrics())
+    {
+        constexpr auto numKinds = static_cast<std::size_t>(
+            InfoKind::Specialization) + 1;
+        std::array<std::size_t, numKinds> kinds{};
+        for(InfoKind kind : corpus->headers().kind)
+            ++kinds[static_cast<std::size_t>(kind)];
+        for(std::size_t i = 0; i < numKinds; ++i)
+            setMetric("mrdox_symbols", kinds[i], { "kind",
+                std::string_view(toString(static_cast<InfoKind>(i))) });
+    }
 
     if(GotFailure)
         return formatError("multiple errors occurred");
@@ -12,19 +12,29 @@
 #define MRDOX_TOOL_CORPUSIMPL_HPP
 
 #include "Tool/ConfigImpl.hpp"
+#include "Tool/InfoArena.hpp"
+#include "Tool/SymbolTable.hpp"
 #include "Support/Debug.hpp"
+#include <mrdox/BuildCorpus.hpp>
 #include <mrdox/Corpus.hpp>
 #include <mrdox/Metadata.hpp>
 #include <mrdox/Platform.hpp>
 #include <mrdox/Support/Error.hpp>
+#include "AST/Bitcode.hpp"
 #include <clang/Tooling/Execution.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Allocator.h>
 #include <llvm/Support/Mutex.h>
+#include <array>
 #include <string>
 
 namespace clang {
 namespace mrdox {
 
+class TUCache;
+
 /** Implements the Corpus.
 */
 class CorpusImpl : public Corpus
@@ -57,6 +67,78 @@ public:
         tooling::ToolExecutor& ex,
         std::shared_ptr<Config const> config);
 
+    /** Build metadata from bitcodes grouped by ID.
+
+        This performs only the reduction step, on
+        bitcodes which were collected elsewhere,
+        for example from distributed extraction.
+
+        @param config A shared pointer to the configuration.
+
+        @param options The options of a build in
+        this process, or null.
+
+        @param trusted Whether every bitcode was
+        written by this process.
+    */
+    [[nodiscard]]
+    static
+    mrdox::Expected<std::unique_ptr<Corpus>>
+    build(
+        Bitcodes& bitcodes,
+        std::shared_ptr<Config const> config,
+        BuildOptions const* options = nullptr,
+        bool trusted = false);
+
+    /** Write a reduced corpus to a snapshot file.
+
+        The snapshot holds the bitcode of every
+        symbol and the version of the tool which
+        wrote it.
+
+        @param units If not null, the entries kept by
+        this cache are also written, so that a later
+        run can re-extract only the translation units
+        whose files changed.
+    */
+    [[nodiscard]]
+    static
+    Error
+    saveSnapshot(
+        Corpus const& corpus,
+        std::string_view path,
+        TUCache const* units = nullptr);
+
+    /** Load a reduced corpus from a snapshot file.
+
+        The file is memory-mapped and the symbols
+        are decoded concurrently. No extraction or
+        reduction is performed.
+
+        @param config A shared pointer to the configuration.
+    */
+    [[nodiscard]]
+    static
+    mrdox::Expected<std::unique_ptr<Corpus>>
+    loadSnapshot(
+        std::string_view path,
+        std::shared_ptr<Config const> config);
+
+    /** Preload the translation units of a snapshot into a cache.
+
+        The bitcode of an unchanged translation unit
+        is replayed from its entry. Translation units
+        which changed or no longer exist contribute
+        nothing, so their old symbols are retracted
+        when the corpus is reduced again.
+    */
+    [[nodiscard]]
+    static
+    Error
+    loadSnapshotUnits(
+        std::string_view path,
+        TUCache& units);
+
 private:
     std::vector<Info const*> const&
     index() const noexcept override
@@ -64,10 +146,70 @@ private:
         return index_;
     }
 
+    SymbolHeaders const&
+    headers() const noexcept override
+    {
+        return headers_;
+    }
+
     Info const*
     find(
         SymbolID const& id) const noexcept override;
 
+    std::uint32_t
+    indexOf(
+        SymbolID const& id) const noexcept override;
+
+    References const&
+    references(
+        SymbolID const& id) const noexcept override;
+
+    std::string_view
+    qualifiedName(
+        Info const& I) const noexcept override;
+
+    std::shared_ptr<Interface const>
+    getInterface(
+        RecordInfo const& I) const override;
+
+    std::span<OverloadInfo const>
+    overloads(
+        Info const& scope) const noexcept override;
+
+    MemoryStats
+    memoryStats() const override;
+
+    std::span<Info const* const>
+    findByName(
+        std::string_view name) const noexcept override;
+
+    std::span<Info const* const>
+    findByPrefix(
+        std::string_view prefix) const noexcept override;
+
+    bool
+    isSelected(
+        Info const& I) const noexcept override;
+
+    bool
+    hasSelected(
+        Info const& I) const noexcept override;
+
+    /** Compute the fully qualified name of a symbol.
+    */
+    static
+    std::string&
+    buildQualifiedName(
+        Corpus const& corpus,
+        Info const& I,
+        std::string& temp);
+
+    /** Build the javadoc pools of a symbol and its enumerators.
+    */
+    static
+    void
+    buildPools(Info& I);
+
     /** Return the Info with the specified symbol ID.
 
         If the id does not exist, the behavior is undefined.
@@ -84,17 +226,139 @@ private:
     */
     void insert(std::unique_ptr<Info> Ip);
 
+    /** Insert an Info which is owned elsewhere.
+
+        The Info must outlive the corpus, and
+        its javadoc pools must already be built.
+
+        @param Thread Safety
+        May be called concurrently.
+    */
+    void insertBorrowed(Info& I);
+
+    /** Build the index once every Info is inserted.
+
+        The index is sorted by fully qualified
+        name and then by symbol ID, so its order
+        does not depend on the order in which
+        the symbols were inserted.
+    */
+    [[nodiscard]]
+    Error finalize();
+
+    /** Build the symbol headers from the index.
+
+        This assigns the position of every symbol,
+        and remaps the member lists to positions.
+    */
+    void buildHeaders();
+
+    /** Build the reverse edges of every symbol.
+    */
+    [[nodiscard]]
+    Error buildReferences();
+
+    /** Build the overload sets of every namespace and record.
+    */
+    [[nodiscard]]
+    Error buildOverloads();
+
+    /** Build the subset of symbols which is rendered.
+
+        This needs the index and the references.
+    */
+    void buildSelection();
+
+    /** Return the number of symbols.
+    */
+    std::size_t
+    size() const noexcept;
+
 private:
     struct Temps;
     friend class Corpus;
+    friend class SnapshotCorpus;
+
+    // The first byte of a SHA1 is uniform,
+    // so it makes a good shard index.
+    static constexpr std::size_t NumShards = 64;
+
+    struct Shard
+    {
+        llvm::sys::Mutex mutable mutex;
+        InfoArena arena;
+        SymbolTable infos;
+        llvm::StringMap<References> refs;
+        llvm::BumpPtrAllocator nameAlloc;
+        llvm::DenseMap<Info const*, std::string_view> names;
+        llvm::DenseMap<Info const*, NamespaceOverloads> overloads;
+
+        // built on demand, guarded by the mutex
+        llvm::DenseMap<Info const*,
+            std::shared_ptr<Interface const>> mutable interfaces;
+    };
+
+    static
+    std::size_t
+    shardIndex(
+        SymbolID const& id) noexcept
+    {
+        return id.data()[0] % NumShards;
+    }
+
+    /** Return the NUMA node which owns a shard.
+
+        Adjacent shards share a node, and work on a
+        shard runs on its node, so the memory of the
+        shard is allocated there.
+    */
+    unsigned
+    shardNode(
+        std::size_t i) const noexcept
+    {
+        return static_cast<unsigned>(
+            i * pool().getNodeCount() / NumShards);
+    }
+
+    /** Return the thread pool which finalize runs on.
+    */
+    ThreadPool&
+    pool() const noexcept
+    {
+        return pool_ ? *pool_ : config_->threadPool();
+    }
+
+    /** Invoke a function with the index of each shard.
+
+        Each shard is done on the node which owns it.
+    */
+    template<class F>
+    Error
+    forEachShard(F const& f) const;
 
     std::shared_ptr<ConfigImpl const> config_;
 
+    // When the Infos are borrowed, finalize may be
+    // called from a task on the thread pool of the
+    // configuration, so it runs on a separate pool
+    // and does not build the javadoc pools again.
+    ThreadPool* pool_ = nullptr;
+    bool borrowed_ = false;
+
     // Table of Info keyed on Symbol ID.
-    llvm::StringMap<std::unique_ptr<Info>> InfoMap;
+    std::array<Shard, NumShards> InfoMap;
     std::vector<Info const*> index_;
 
-    llvm::sys::Mutex mutex_;
+    // The qualified name of each symbol in index_
+    std::vector<std::string_view> indexNames_;
+
+    // The hot fields of each symbol in index_
+    SymbolHeaders headers_;
+
+    // The rendered symbols, and the scopes which
+    // contain them, when there is a selection
+    llvm::DenseSet<Info const*> selected_;
+    llvm::DenseSet<Info const*> enclosing_;
 };
 
 template<class T>
@@ -0,0 +1,236 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "CorpusImpl.hpp"
+#include "SnapshotCorpus.hpp"
+#include "TUCache.hpp"
+#include "AST/Bitcode.hpp"
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
+#include <mrdox/Version.hpp>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <atomic>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+constexpr llvm::StringLiteral snapshotMagic = "MRDOXSN3";
+
+void
+writeU32(
+    llvm::raw_ostream& os,
+    std::uint32_t v)
+{
+    char buf[4];
+    llvm::support::endian::write32le(buf, v);
+    os.write(buf, sizeof(buf));
+}
+
+} // (anon)
+
+Error
+parseSnapshot(
+    std::string_view path,
+    llvm::StringRef s,
+    Snapshot& snapshot)
+{
+    bool ok = true;
+    auto const take = [&](std::size_t n)
+    {
+        if(! ok || s.size() < n)
+        {
+            ok = false;
+            return llvm::StringRef();
+        }
+        auto result = s.take_front(n);
+        s = s.drop_front(n);
+        return result;
+    };
+    auto const takeU32 = [&]() -> std::uint32_t
+    {
+        auto v = take(4);
+        return ok ? llvm::support::endian::read32le(v.data()) : 0;
+    };
+
+    if(take(snapshotMagic.size()) != snapshotMagic)
+        return formatError("\"{}\" is not a corpus snapshot", path);
+    auto const version = take(takeU32());
+    if(ok && version != project_version)
+        return formatError("snapshot \"{}\" was written by version {}",
+            path, std::string_view(version));
+    snapshot.symbols.resize(takeU32());
+    for(auto& [id, bitcode] : snapshot.symbols)
+    {
+        auto const bytes = take(id.size());
+        if(ok)
+            id = SymbolID(reinterpret_cast<
+                std::uint8_t const*>(bytes.data()));
+        bitcode = take(takeU32());
+    }
+    snapshot.units.resize(takeU32());
+    for(auto& unit : snapshot.units)
+    {
+        unit.first = take(takeU32());
+        unit.second = take(takeU32());
+    }
+    if(! ok)
+        return formatError("corpus snapshot \"{}\" is truncated", path);
+    return Error::success();
+}
+
+Error
+CorpusImpl::
+saveSnapshot(
+    Corpus const& corpus,
+    std::string_view path,
+    TUCache const* units)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+
+    auto const& index = corpus.index();
+    os << snapshotMagic;
+    writeU32(os, project_version.size());
+    os << project_version;
+    writeU32(os, index.size());
+    BitcodeSerializer serializer;
+    for(Info const* I : index)
+    {
+        // the ID is read without decoding the bitcode
+        auto bc = serializer.write(*I);
+        os.write(reinterpret_cast<char const*>(
+            I->id.data()), I->id.size());
+        writeU32(os, bc.data.size());
+        os << bc.data;
+    }
+
+    // the translation units which produced the
+    // symbols, for incremental updates
+    std::size_t numUnits = 0;
+    if(units)
+        units->forEachEntry(
+            [&](llvm::StringRef, TUCache::Entry const&)
+            {
+                ++numUnits;
+            });
+    writeU32(os, numUnits);
+    if(units)
+        units->forEachEntry(
+            [&](llvm::StringRef key, TUCache::Entry const& entry)
+            {
+                auto data = TUCache::serialize(entry);
+                writeU32(os, key.size());
+                os << key;
+                writeU32(os, data.size());
+                os << data;
+            });
+    os.close();
+    if(os.has_error())
+    {
+        ec = os.error();
+        os.clear_error();
+        return formatError("write(\"{}\") returned \"{}\"",
+            path, ec.message());
+    }
+    if(corpus.config.verboseOutput)
+        reportInfo("Wrote {} symbols and {} translation units to snapshot \"{}\"",
+            index.size(), numUnits, path);
+    return Error::success();
+}
+
+mrdox::Expected<std::unique_ptr<Corpus>>
+CorpusImpl::
+loadSnapshot(
+    std::string_view path,
+    std::shared_ptr<Config const> config_)
+{
+    auto config = std::dynamic_pointer_cast<ConfigImpl const>(config_);
+
+    // large files are memory-mapped
+    auto buf = llvm::MemoryBuffer::getFile(path,
+        /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if(! buf)
+        return formatError("getFile(\"{}\") returned \"{}\"",
+            path, buf.getError().message());
+
+    Snapshot snapshot;
+    if(auto err = parseSnapshot(path, (*buf)->getBuffer(), snapshot))
+        return err;
+    auto const& symbols = snapshot.symbols;
+
+    if(config->verboseOutput)
+        reportInfo("Loading {} symbols from snapshot", symbols.size());
+    auto corpus = std::make_unique<CorpusImpl>(config);
+    std::atomic<bool> GotFailure = false;
+    auto errors = config->threadPool().forEach(
+        symbols,
+        [&](std::pair<SymbolID, llvm::StringRef> const& symbol)
+        {
+            auto const bitcode = symbol.second;
+            thread_local BitcodeDecoder decoder;
+            auto infos = decoder.read(bitcode);
+            if(! infos)
+            {
+                reportError(infos.error(), "read bitcode");
+                GotFailure = true;
+                return;
+            }
+            for(auto& I : *infos)
+                corpus->insert(std::move(I));
+        });
+    if(! errors.empty())
+        return Error(errors);
+    if(GotFailure)
+        return formatError("multiple errors occurred");
+
+    if(! corpus->find(SymbolID::zero))
+        return formatError("corpus snapshot \"{}\" has no global namespace", path);
+    if(auto err = corpus->finalize())
+        return err;
+    if(config->verboseOutput)
+        llvm::outs() << "Collected " << corpus->size() << " symbols.\n";
+    return corpus;
+}
+
+Error
+CorpusImpl::
+loadSnapshotUnits(
+    std::string_view path,
+    TUCache& units)
+{
+    auto buf = llvm::MemoryBuffer::getFile(path,
+        /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if(! buf)
+        return formatError("getFile(\"{}\") returned \"{}\"",
+            path, buf.getError().message());
+    Snapshot snapshot;
+    if(auto err = parseSnapshot(path, (*buf)->getBuffer(), snapshot))
+        return err;
+    for(auto const& [key, data] : snapshot.units)
+    {
+        auto entry = TUCache::deserialize(data);
+        if(! entry)
+            return formatError("corpus snapshot \"{}\" is corrupt", path);
+        units.preload(key.str(), std::move(*entry));
+    }
+    return Error::success();
+}
+
+} // mrdox
+} // clang
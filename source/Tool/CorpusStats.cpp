@@ -0,0 +1,183 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "CorpusImpl.hpp"
+#include "Support/Memory.hpp"
+#include <mrdox/Metadata.hpp>
+#include <llvm/ADT/DenseSet.h>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+/** Add the nodes of a type which were not seen before.
+*/
+void
+addType(
+    MemoryStats::Usage& u,
+    llvm::DenseSet<TypeInfo const*>& seen,
+    TypeInfo const* T)
+{
+    // types are shared, so a node is
+    // counted the first time it is seen
+    if(! T || ! seen.insert(T).second)
+        return;
+    visit(*T, [&]<class Ty>(Ty const& t)
+    {
+        ++u.count;
+        u.bytes += sizeof(Ty);
+        if constexpr(requires { t.Name; })
+            u.bytes += heapBytes(t.Name);
+        if constexpr(requires { t.TemplateArgs; })
+        {
+            u.bytes += t.TemplateArgs.capacity() * sizeof(TArg);
+            for(auto const& arg : t.TemplateArgs)
+                u.bytes += heapBytes(arg.Value);
+        }
+        if constexpr(requires { t.ParentType; })
+            addType(u, seen, t.ParentType.get());
+        if constexpr(requires { t.PointeeType; })
+            addType(u, seen, t.PointeeType.get());
+        if constexpr(requires { t.ElementType; })
+            addType(u, seen, t.ElementType.get());
+        if constexpr(requires { t.PatternType; })
+            addType(u, seen, t.PatternType.get());
+        if constexpr(requires { t.ParamTypes; })
+        {
+            u.bytes += t.ParamTypes.capacity() *
+                sizeof(std::shared_ptr<TypeInfo>);
+            addType(u, seen, t.ReturnType.get());
+            for(auto const& p : t.ParamTypes)
+                addType(u, seen, p.get());
+        }
+    });
+}
+
+void
+addNode(
+    MemoryStats::Usage& u,
+    doc::Node const& node)
+{
+    doc::visit(node, [&](auto const& J)
+    {
+        ++u.count;
+        u.bytes += sizeof(J);
+        if constexpr(requires { J.string; })
+            u.bytes += heapBytes(J.string);
+        if constexpr(requires { J.href; })
+            u.bytes += heapBytes(J.href);
+        if constexpr(requires { J.name; })
+            u.bytes += heapBytes(J.name);
+        if constexpr(requires { J.children; })
+        {
+            u.bytes += J.children.capacity() *
+                sizeof(std::unique_ptr<doc::Text>);
+            for(auto const& child : J.children)
+                addNode(u, *child);
+        }
+    });
+}
+
+void
+addJavadoc(
+    MemoryStats::Usage& u,
+    std::unique_ptr<Javadoc> const& jd)
+{
+    if(! jd)
+        return;
+    auto const& blocks = jd->getBlocks();
+    u.bytes += sizeof(Javadoc) +
+        blocks.capacity() * sizeof(std::unique_ptr<doc::Block>) +
+        jd->hashes().capacity() * sizeof(std::uint64_t) +
+        jd->pool().bytes();
+    for(auto const& block : blocks)
+        addNode(u, *block);
+}
+
+} // (anon)
+
+MemoryStats
+CorpusImpl::
+memoryStats() const
+{
+    MemoryStats stats;
+    for(auto kind : {
+        InfoKind::Namespace, InfoKind::Record,
+        InfoKind::Function, InfoKind::Enum,
+        InfoKind::Typedef, InfoKind::Variable,
+        InfoKind::Field, InfoKind::Specialization })
+    {
+        MemoryStats::Usage total;
+        for(auto const& shard : InfoMap)
+        {
+            auto const u = shard.arena.usage(kind);
+            total.count += u.count;
+            total.bytes += u.bytes;
+        }
+        stats.kinds.emplace_back(kind, total);
+    }
+
+    llvm::DenseSet<TypeInfo const*> seen;
+    auto const addRoot = [&](std::shared_ptr<TypeInfo> const& T)
+    {
+        addType(stats.types, seen, T.get());
+    };
+    for(auto const& shard : InfoMap)
+    {
+        stats.strings.count += shard.names.size();
+        stats.strings.bytes += shard.nameAlloc.getBytesAllocated();
+        shard.infos.forEach(
+            [&](Info const& I)
+            {
+                ++stats.strings.count;
+                stats.strings.bytes += heapBytes(I.Name);
+                addJavadoc(stats.javadoc, I.javadoc);
+                visit(I, [&]<class T>(T const& J)
+                {
+                    if constexpr(std::derived_from<T, SourceInfo>)
+                    {
+                        stats.locations.count +=
+                            J.Loc.size() + (J.DefLoc ? 1 : 0);
+                        stats.locations.bytes +=
+                            J.Loc.capacity() * sizeof(Location);
+                    }
+                    if constexpr(T::isFunction())
+                    {
+                        addRoot(J.ReturnType);
+                        for(auto const& P : J.Params)
+                            addRoot(P.Type);
+                    }
+                    if constexpr(T::isRecord())
+                    {
+                        for(auto const& B : J.Bases)
+                            addRoot(B.Type);
+                    }
+                    if constexpr(T::isEnum())
+                    {
+                        addRoot(J.UnderlyingType);
+                        for(auto const& V : J.Members)
+                            addJavadoc(stats.javadoc, V.javadoc);
+                    }
+                    if constexpr(
+                        T::isTypedef() ||
+                        T::isVariable() ||
+                        T::isField())
+                    {
+                        addRoot(J.Type);
+                    }
+                });
+            });
+    }
+    return stats;
+}
+
+} // mrdox
+} // clang
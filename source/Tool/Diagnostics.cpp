@@ -0,0 +1,107 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "Diagnostics.hpp"
+#include <algorithm>
+
+namespace clang {
+namespace mrdox {
+
+DiagnosticsReporter::
+~DiagnosticsReporter()
+{
+    flush();
+}
+
+void
+DiagnosticsReporter::
+merge(
+    Diagnostics&& diags)
+{
+    if(diags.empty())
+        return;
+    for(auto& [hash, m] : diags.take())
+    {
+        auto& shard = shards_[hash % shardCount];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.messages.try_emplace(hash);
+        if(inserted)
+            it->second.message = std::move(m);
+        else if(m.error)
+            it->second.message.error = true;
+    }
+}
+
+void
+DiagnosticsReporter::
+flush()
+{
+    std::lock_guard<std::mutex> flushLock(flushMutex_);
+    std::vector<Diagnostics::Message> fresh;
+    for(auto& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for(auto& [hash, entry] : shard.messages)
+        {
+            if(entry.printed)
+                continue;
+            entry.printed = true;
+            fresh.push_back(entry.message);
+        }
+    }
+    if(fresh.empty())
+        return;
+    std::sort(fresh.begin(), fresh.end(),
+        [](auto const& a, auto const& b)
+        {
+            return a.text < b.text;
+        });
+    for(auto const& m : fresh)
+    {
+        if(m.error)
+            errorCount_.fetch_add(1, std::memory_order_relaxed);
+        else
+            warningCount_.fetch_add(1, std::memory_order_relaxed);
+        os_ << m.text << '\n';
+    }
+    os_.flush();
+}
+
+void
+DiagnosticsReporter::
+reportTotals()
+{
+    flush();
+    auto const errorCount = errorCount_.load();
+    auto const warnCount = warningCount_.load();
+    if(errorCount == 0 && warnCount == 0)
+    {
+        os_ << "No errors or warnings.\n";
+        return;
+    }
+    if(errorCount > 0)
+    {
+        os_ << fmt::format("{} {}",
+            errorCount, errorCount > 1
+                ? "errors" : "error");
+    }
+    if(warnCount > 0)
+    {
+        if(errorCount > 0)
+            os_ << " and ";
+        os_ << fmt::format("{} {}",
+            warnCount, warnCount > 1
+                ? "warnings" : "warning");
+    }
+    os_ << ".\n";
+}
+
+} // mrdox
+} // clang
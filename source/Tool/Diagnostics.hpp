@@ -13,79 +13,151 @@
 
 #include <mrdox/Support/Error.hpp>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
 
 /** Diagnostic information accumulated during visitation.
+
+    Messages are keyed by the hash of their
+    text, and only the first occurrence of each
+    keeps its text.
 */
 class Diagnostics
 {
-    std::size_t errorCount_ = 0;
-    std::unordered_map<std::string, bool> messages_;
+public:
+    struct Message
+    {
+        std::string text;
+        bool error;
+    };
+
+private:
+    std::unordered_map<std::uint64_t, Message> messages_;
+
+    void
+    add(std::string s, bool error)
+    {
+        auto const hash = llvm::xxHash64(s);
+        auto result = messages_.try_emplace(hash);
+        if(result.second)
+            result.first->second = { std::move(s), error };
+        else if(error)
+            result.first->second.error = true;
+    }
 
 public:
     void reportError(std::string s)
     {
-        auto result =
-            messages_.emplace(std::move(s), true);
-        if(result.second)
-            ++errorCount_;
+        add(std::move(s), true);
     }
 
     void reportWarning(std::string s)
     {
-        messages_.emplace(std::move(s), false);
+        add(std::move(s), false);
     }
 
-    void reportTotals(
-        llvm::raw_ostream& os)
+    bool
+    empty() const noexcept
     {
-        if(! messages_.empty())
-        {
-            auto warnCount = messages_.size() - errorCount_;
-            if(errorCount_ > 0)
-            {
-                os << fmt::format("{} {}",
-                    errorCount_, errorCount_ > 1
-                        ? "errors" : "error");
-            }
-            if(warnCount > 0)
-            {
-                if(errorCount_ > 0)
-                    os << " and ";
-                os << fmt::format("{} {}.\n",
-                    warnCount, warnCount > 1
-                        ? "warnings" : "warning");
-            }
-            os << '\n';
-        }
-        else
-        {
-            os << "No errors or warnings.\n";
-        }
+        return messages_.empty();
     }
 
-    void
-    merge(
-        Diagnostics&& other,
-        llvm::raw_ostream* os = nullptr)
+    /** Return the messages keyed by hash, and clear them.
+    */
+    std::unordered_map<std::uint64_t, Message>
+    take() noexcept
+    {
+        return std::move(messages_);
+    }
+};
+
+/** The diagnostics of every visitor.
+
+    The messages seen so far are spread over
+    shards by hash, so visitors finishing at
+    the same time rarely share a lock. The new
+    messages are printed when flushed, sorted
+    by their text, so the output is the same
+    for any number of threads.
+*/
+class DiagnosticsReporter
+{
+    struct Entry
+    {
+        Diagnostics::Message message;
+        bool printed = false;
+    };
+
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::uint64_t, Entry> messages;
+    };
+
+    static constexpr std::size_t shardCount = 16;
+
+    llvm::raw_ostream& os_;
+    std::array<Shard, shardCount> shards_;
+    std::mutex flushMutex_;
+    std::atomic<std::size_t> errorCount_ = 0;
+    std::atomic<std::size_t> warningCount_ = 0;
+
+public:
+    explicit
+    DiagnosticsReporter(
+        llvm::raw_ostream& os) noexcept
+        : os_(os)
+    {
+    }
+
+    /** Destructor.
+
+        Messages which were not flushed
+        are printed.
+    */
+    ~DiagnosticsReporter();
+
+    /** Add the messages of a visitor.
+
+        Messages which were seen before
+        are counted once and printed once.
+    */
+    void merge(Diagnostics&& diags);
+
+    /** Print the messages added since the last flush.
+
+        A message which is an error for any
+        visitor is counted as an error.
+    */
+    void flush();
+
+    /** Print the number of errors and warnings.
+    */
+    void reportTotals();
+
+    /** Return the number of distinct errors flushed.
+    */
+    std::size_t
+    errorCount() const noexcept
+    {
+        return errorCount_.load();
+    }
+
+    /** Return the number of distinct warnings flushed.
+    */
+    std::size_t
+    warningCount() const noexcept
     {
-        for(auto&& m : other.messages_)
-        {
-            auto result = messages_.emplace(std::move(m));
-            if(result.second)
-            {
-                if(result.first->second)
-                    ++errorCount_;
-                if(os && result.second)
-                    *os << result.first->first;
-                *os << '\n';
-            }
-        }
-        other.messages_.clear();
+        return warningCount_.load();
     }
 };
 
@@ -10,6 +10,12 @@
 //
 
 #include "ExecutionContext.hpp"
+#include "Support/Metrics.hpp"
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <cstdint>
 
 namespace clang {
 namespace mrdox {
@@ -19,15 +25,164 @@ ExecutionContext::
 report(
     Diagnostics&& diags)
 {
-    std::lock_guard<llvm::sys::Mutex> lock(mutex_);
-    diags_.merge(std::move(diags), &llvm::outs());
+    diags_.merge(std::move(diags));
+}
+
+bool
+ExecutionContext::
+isEmitted(llvm::StringRef key)
+{
+    std::lock_guard<llvm::sys::Mutex> lock(emittedMutex_);
+    return emitted_.contains(key);
+}
+
+void
+ExecutionContext::
+publishEmitted(llvm::StringSet<> const& keys)
+{
+    std::lock_guard<llvm::sys::Mutex> lock(emittedMutex_);
+    for(auto const& key : keys)
+        emitted_.insert(key.getKey());
+}
+
+void
+ExecutionContext::
+reportTimedOut(
+    llvm::StringRef file)
+{
+    std::lock_guard<llvm::sys::Mutex> lock(timedOutMutex_);
+    timedOut_.insert(file);
+}
+
+bool
+ExecutionContext::
+timedOut(
+    llvm::StringRef file)
+{
+    std::lock_guard<llvm::sys::Mutex> lock(timedOutMutex_);
+    return timedOut_.contains(file);
+}
+
+bool
+ExecutionContext::
+claimModule(llvm::StringRef key)
+{
+    std::lock_guard<llvm::sys::Mutex> lock(modulesMutex_);
+    return modules_.insert(key).second;
+}
+
+void
+ExecutionContext::
+reportTUStats(
+    TUStats stats)
+{
+    std::lock_guard<llvm::sys::Mutex> lock(tuStatsMutex_);
+    tuStats_.emplace_back(std::move(stats));
+}
+
+auto
+ExecutionContext::
+takeTUStats() ->
+    std::vector<TUStats>
+{
+    std::lock_guard<llvm::sys::Mutex> lock(tuStatsMutex_);
+    return std::move(tuStats_);
 }
 
 void
 ExecutionContext::
 reportEnd()
 {
-    diags_.reportTotals(llvm::outs());
+    diags_.reportTotals();
+    llvm::outs() << fmt::format(
+        "SymbolID cache: {} hits, {} misses.\n",
+        symbolIDHits_.load(), symbolIDMisses_.load());
+    if(instantiationsSkipped_ > 0)
+        llvm::outs() << fmt::format(
+            "Skipped {} implicit instantiations.\n",
+            instantiationsSkipped_.load());
+}
+
+void
+ExecutionContext::
+recordMetrics()
+{
+    setMetric("mrdox_symbolid_cache_hits", symbolIDHits_.load());
+    setMetric("mrdox_symbolid_cache_misses", symbolIDMisses_.load());
+    setMetric("mrdox_instantiations_skipped", instantiationsSkipped_.load());
+    setMetric("mrdox_bitcode_bytes", bitcodeBytes_.load());
+    setMetric("mrdox_javadoc_cache_hits", javadocs_.hits());
+    setMetric("mrdox_javadoc_cache_misses", javadocs_.misses());
+    diags_.flush();
+    setMetric("mrdox_errors", diags_.errorCount());
+    setMetric("mrdox_warnings", diags_.warningCount());
+}
+
+Error
+writeTUStats(
+    std::string_view path,
+    std::vector<ExecutionContext::TUStats> stats)
+{
+    std::stable_sort(stats.begin(), stats.end(),
+        [](auto const& a, auto const& b)
+        {
+            return a.parseMs + a.visitMs > b.parseMs + b.visitMs;
+        });
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+            path, ec.message());
+    if(llvm::sys::path::extension(path).equals_insensitive(".json"))
+    {
+        llvm::json::OStream J(os, 2);
+        J.array([&]
+        {
+            for(auto const& s : stats)
+            {
+                J.object([&]
+                {
+                    J.attribute("file", s.file);
+                    J.attribute("parse-ms", s.parseMs);
+                    J.attribute("visit-ms", s.visitMs);
+                    J.attribute("decls-visited",
+                        static_cast<std::int64_t>(s.declsVisited));
+                    J.attribute("decls-extracted",
+                        static_cast<std::int64_t>(s.declsExtracted));
+                    J.attribute("bitcodes",
+                        static_cast<std::int64_t>(s.bitcodes));
+                    J.attribute("bitcode-bytes",
+                        static_cast<std::int64_t>(s.bitcodeBytes));
+                });
+            }
+        });
+        os << '\n';
+    }
+    else
+    {
+        os << "file,parse_ms,visit_ms,decls_visited,"
+            "decls_extracted,bitcodes,bitcode_bytes\n";
+        for(auto const& s : stats)
+        {
+            // quotes in a path are doubled
+            std::string file;
+            for(char c : s.file)
+            {
+                if(c == '"')
+                    file.push_back('"');
+                file.push_back(c);
+            }
+            os << fmt::format("\"{}\",{:.1f},{:.1f},{},{},{},{}\n",
+                file, s.parseMs, s.visitMs, s.declsVisited,
+                s.declsExtracted, s.bitcodes, s.bitcodeBytes);
+        }
+    }
+    os.close();
+    if(os.has_error())
+        return formatError("could not write \"{}\": {}",
+            path, os.error().message());
+    return Error::success();
 }
 
 } // mrdox
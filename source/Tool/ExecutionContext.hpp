@@ -13,13 +13,24 @@
 #define MRDOX_TOOL_TOOL_EXECUTIONCONTEXT_HPP
 
 #include "Diagnostics.hpp"
+#include "AST/ParseJavadoc.hpp"
 #include <mrdox/Config.hpp>
+#include <mrdox/Generator.hpp>
+#include <mrdox/Support/Error.hpp>
 #include <clang/Tooling/Execution.h>
+#include <llvm/ADT/StringSet.h>
 #include <llvm/Support/Mutex.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
 
+class TUCache;
+
 /** A custom execution context for visitation.
 
     This execution context extends the clang base
@@ -30,21 +41,234 @@ namespace mrdox {
 class ExecutionContext
     : public tooling::ExecutionContext
 {
-    llvm::sys::Mutex mutex_;
-    Diagnostics diags_;
+public:
+    /** The work done on one translation unit.
+    */
+    struct TUStats
+    {
+        std::string file;
+        double parseMs = 0;
+        double visitMs = 0;
+        std::size_t declsVisited = 0;
+        std::size_t declsExtracted = 0;
+        std::size_t bitcodes = 0;
+        std::size_t bitcodeBytes = 0;
+    };
+
+private:
+    DiagnosticsReporter diags_;
+    TUCache* cache_ = nullptr;
+    MetadataFacets facets_;
+    llvm::sys::Mutex emittedMutex_;
+    llvm::StringSet<> emitted_;
+    llvm::StringSet<> interfaces_;
+    llvm::sys::Mutex modulesMutex_;
+    llvm::StringSet<> modules_;
+    std::atomic<std::size_t> symbolIDHits_ = 0;
+    std::atomic<std::size_t> symbolIDMisses_ = 0;
+    std::atomic<std::size_t> instantiationsSkipped_ = 0;
+    std::atomic<std::size_t> bitcodeBytes_ = 0;
+    llvm::sys::Mutex tuStatsMutex_;
+    std::vector<TUStats> tuStats_;
+    std::chrono::steady_clock::time_point deadline_ =
+        std::chrono::steady_clock::time_point::max();
+    llvm::sys::Mutex timedOutMutex_;
+    llvm::StringSet<> timedOut_;
+    JavadocCache javadocs_;
 
 public:
     explicit
     ExecutionContext(
         tooling::ToolResults* Results)
             : tooling::ExecutionContext(Results)
+            , diags_(llvm::outs())
     {
     }
 
     void report(Diagnostics&& diags);
     void reportEnd();
+
+    /** Add the counters of the visitors to the metrics.
+    */
+    void recordMetrics();
+
+    /** Accumulate the SymbolID cache counters of a visitor.
+    */
+    void
+    reportSymbolIDs(
+        std::size_t hits,
+        std::size_t misses) noexcept
+    {
+        symbolIDHits_ += hits;
+        symbolIDMisses_ += misses;
+    }
+
+    /** Accumulate the implicit instantiations a visitor discarded.
+    */
+    void
+    reportInstantiationsSkipped(
+        std::size_t n) noexcept
+    {
+        instantiationsSkipped_ += n;
+    }
+
+    /** Accumulate the bytes of bitcode a translation unit produced.
+    */
+    void
+    reportBitcodeBytes(
+        std::size_t n) noexcept
+    {
+        bitcodeBytes_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /** Return the counter of the bytes of bitcode produced.
+    */
+    std::atomic<std::size_t> const&
+    bitcodeBytes() const noexcept
+    {
+        return bitcodeBytes_;
+    }
+
+    /** Record the work done on a translation unit.
+    */
+    void
+    reportTUStats(
+        TUStats stats);
+
+    /** Return the work recorded for each translation unit, and clear it.
+    */
+    std::vector<TUStats>
+    takeTUStats();
+
+    /** Set the time after which no translation unit is extracted.
+    */
+    void
+    setDeadline(
+        std::chrono::steady_clock::time_point t) noexcept
+    {
+        deadline_ = t;
+    }
+
+    /** Return the time after which no translation unit is extracted.
+    */
+    std::chrono::steady_clock::time_point
+    deadline() const noexcept
+    {
+        return deadline_;
+    }
+
+    /** Record that a translation unit was given up on.
+    */
+    void
+    reportTimedOut(
+        llvm::StringRef file);
+
+    /** Return true if a translation unit was given up on.
+    */
+    bool
+    timedOut(
+        llvm::StringRef file);
+
+    /** Return the comments parsed by the visitors.
+    */
+    JavadocCache&
+    javadocs() noexcept
+    {
+        return javadocs_;
+    }
+
+    /** Return true if a translation unit emitted a declaration with this key.
+
+        Only the keys of translation units whose
+        results were inserted are seen here.
+    */
+    bool isEmitted(llvm::StringRef key);
+
+    /** Publish the keys of the declarations a translation unit emitted.
+
+        This is called after the results of the
+        translation unit are inserted, so the keys
+        of one which gives up are never published,
+        and the other translation units still
+        extract those declarations.
+    */
+    void publishEmitted(llvm::StringSet<> const& keys);
+
+    /** Set the named modules whose interfaces are translation units.
+
+        The declarations of these modules are
+        extracted from their interface, and not
+        from the translation units which import them.
+    */
+    void
+    setModuleInterfaces(
+        llvm::StringSet<> names) noexcept
+    {
+        interfaces_ = std::move(names);
+    }
+
+    /** Return true if a named module is extracted from its interface.
+    */
+    bool
+    isModuleInterface(
+        llvm::StringRef name) const noexcept
+    {
+        return interfaces_.contains(name);
+    }
+
+    /** Claim the declarations of an imported module.
+
+        @return `true` if no translation unit
+        claimed the module with this key before.
+    */
+    bool claimModule(llvm::StringRef key);
+
+    /** Return the translation unit cache, or nullptr if disabled.
+    */
+    TUCache*
+    cache() const noexcept
+    {
+        return cache_;
+    }
+
+    void
+    setCache(TUCache* cache) noexcept
+    {
+        cache_ = cache;
+    }
+
+    /** Return the parts of the metadata to extract.
+
+        Everything is extracted when a translation
+        unit cache is in use, since the cached results
+        may be read by another generator.
+    */
+    MetadataFacets
+    facets() const noexcept
+    {
+        if(cache_)
+            return {};
+        return facets_;
+    }
+
+    void
+    setFacets(MetadataFacets facets) noexcept
+    {
+        facets_ = facets;
+    }
 };
 
+/** Write the work done on each translation unit.
+
+    The translation units are sorted with the
+    slowest first. The file is JSON when its
+    extension is ".json", and CSV otherwise.
+*/
+Error
+writeTUStats(
+    std::string_view path,
+    std::vector<ExecutionContext::TUStats> stats);
+
 } // mrdox
 } // clang
 
@@ -9,59 +9,949 @@
 // Official repository: https://github.com/cppalliance/mrdox
 //
 
+#include "ClangdIndex.hpp"
 #include "ConfigImpl.hpp"
 #include "CorpusImpl.hpp"
+#include "SnapshotCorpus.hpp"
 #include "ToolArgs.hpp"
 #include "ToolExecutor.hpp"
+#include "-adoc/PageRenderer.hpp"
+#include "TUCache.hpp"
 #include "AST/AbsoluteCompilationDatabase.hpp"
+#include "AST/Bitcode.hpp"
+#include "AST/CompileCommands.hpp"
+#include "AST/HeaderScanDatabase.hpp"
+#include "AST/FrontendAction.hpp"
+#include "Support/Error.hpp"
+#include "Support/FileWatcher.hpp"
+#include "Support/LocalSocket.hpp"
+#include "Support/Memory.hpp"
+#include "Support/Metrics.hpp"
+#include "Support/PhaseReport.hpp"
 #include <mrdox/Generators.hpp>
+#include <mrdox/Support/Dom.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/Path.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
 #include <clang/Tooling/AllTUsExecution.h>
-#include <clang/Tooling/JSONCompilationDatabase.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <algorithm>
+#include <chrono>
+#include <concepts>
 #include <cstdlib>
+#include <optional>
+#include <thread>
 
 namespace clang {
 namespace mrdox {
 
-Error
-DoGenerateAction()
-{
-    auto& generators = getGenerators();
+namespace {
 
+Expected<std::shared_ptr<ConfigImpl const>>
+loadToolConfig()
+{
     // Calculate additional YAML settings from command line options.
     std::string extraYaml;
     {
         llvm::raw_string_ostream os(extraYaml);
         if(toolArgs.ignoreMappingFailures.getValue())
             os << "ignore-failures: true\n";
+        if(toolArgs.stats.getValue())
+            os << "stats: true\n";
+        // a server writes only the pages which changed
+        if(toolArgs.toolAction == Action::serve)
+            os << "incremental-output: true\n";
     }
 
     // Load configuration file
     if(toolArgs.configPath.empty())
         return formatError("the config path argument is missing");
-    auto config = loadConfigFile(
+    return loadConfigFile(
         toolArgs.configPath, toolArgs.addonsDir, extraYaml);
-    if(! config)
-        return config.error();
+}
+
+/** Report the memory held by a corpus.
+*/
+void
+reportMemoryStats(
+    Corpus const& corpus)
+{
+    auto const stats = corpus.memoryStats();
+    auto const report = [](std::string_view what,
+        MemoryStats::Usage const& u)
+    {
+        if(u.count > 0)
+            reportInfo("{:>16}: {} in {} bytes", what, u.count, u.bytes);
+    };
+    for(auto const& [kind, u] : stats.kinds)
+        report(std::string_view(toString(kind)), u);
+    report("types", stats.types);
+    report("javadoc nodes", stats.javadoc);
+    report("locations", stats.locations);
+    report("strings", stats.strings);
+}
+
+/** Report the work done by the Dom during generation.
+*/
+void
+reportDomStats()
+{
+    auto const stats = dom::getStats();
+    auto const report = [](std::string_view what,
+        std::vector<dom::Stats::Count> const& counts)
+    {
+        // only the most frequent ones are useful
+        std::size_t const n = std::min<std::size_t>(counts.size(), 10);
+        for(std::size_t i = 0; i < n; ++i)
+            reportInfo("{:>16}: {} {}", what,
+                counts[i].count, counts[i].name);
+    };
+    report("objects", stats.objects);
+    report("arrays", stats.arrays);
+    report("lookups", stats.lookups);
+    reportInfo("{:>16}: {}", "materialized", stats.materializations);
+    reportInfo("{:>16}: {}", "bytes", stats.bytes);
+}
+
+/** Report the phases measured so far, as requested.
+*/
+void
+reportPhases(
+    ConfigImpl const& config)
+{
+    auto const phases = takePhaseStats();
+    addPhaseMetrics(phases);
+    if(config.stats_ || config.verboseOutput)
+        reportPhaseStats(phases);
+    if(config.statsFile_.empty())
+        return;
+    if(auto err = writePhaseStats(config.statsFile_, phases))
+        reportWarning("Could not write the stats file: {}", err.message());
+}
+
+/** A generator, and the output it writes.
+*/
+struct GeneratorRun
+{
+    Generator const* generator;
+    std::string outputPath;
+};
+
+/** Return the generators named by the format option.
+
+    A single format writes to the output path.
+    With several formats each one writes to the
+    path given for it with the format-output
+    option, else to a directory of the output
+    path named after the format.
+*/
+Expected<std::vector<GeneratorRun>>
+findGenerators(
+    ConfigImpl const& config)
+{
+    namespace fs = llvm::sys::fs;
+
+    auto& generators = getGenerators();
+    llvm::SmallVector<llvm::StringRef, 4> formats;
+    llvm::StringRef(toolArgs.formatType.getValue()).split(
+        formats, ',', -1, false);
+    if(formats.empty())
+        return formatError("no format was given");
+
+    std::vector<GeneratorRun> runs;
+    for(llvm::StringRef format : formats)
+    {
+        format = format.trim();
+        auto generator = generators.find(format);
+        if(! generator)
+            return formatError("the Generator \"{}\" was not found",
+                format);
+        for(auto const& run : runs)
+            if(run.generator == generator)
+                return formatError("the format \"{}\" was given twice",
+                    format);
+        std::string outputPath = toolArgs.outputPath.getValue();
+        if(formats.size() > 1)
+            outputPath = files::appendPath(outputPath, generator->id());
+        runs.push_back({ generator, std::move(outputPath) });
+    }
+
+    for(auto const& arg : toolArgs.formatOutputs)
+    {
+        auto [format, path] = llvm::StringRef(arg).split('=');
+        format = format.trim();
+        auto it = std::find_if(runs.begin(), runs.end(),
+            [&](GeneratorRun const& run)
+            {
+                return run.generator->id() == format;
+            });
+        if(it == runs.end())
+            return formatError("the format-output \"{}\" names a format which is not generated", arg);
+        if(path.empty())
+            return formatError("the format-output \"{}\" has no path", arg);
+        it->outputPath = files::normalizePath(
+            files::makeAbsolute(path, config.workingDir));
+    }
 
-    // Load the compilation database
+    // The directories named after the
+    // formats may not exist yet.
+    if(runs.size() > 1)
+    {
+        for(auto const& run : runs)
+        {
+            if(run.outputPath != files::appendPath(
+                    toolArgs.outputPath.getValue(), run.generator->id()))
+                continue;
+            if(auto ec = fs::create_directories(run.outputPath))
+                return formatError("create_directories(\"{}\") returned \"{}\"",
+                    run.outputPath, ec.message());
+        }
+    }
+    return runs;
+}
+
+/** Return the union of the facets read by the generators.
+*/
+MetadataFacets
+facetsOf(
+    std::vector<GeneratorRun> const& runs)
+{
+    MetadataFacets facets{ false, false, false };
+    for(auto const& run : runs)
+    {
+        MetadataFacets const f = run.generator->facets();
+        facets.javadoc |= f.javadoc;
+        facets.templateArgs |= f.templateArgs;
+        facets.sourceText |= f.sourceText;
+    }
+    return facets;
+}
+
+/** Run the generators, then report the memory if requested.
+
+    The generators share the corpus, and each
+    runs on its own thread. They are not tasks
+    on the thread pool because a generator
+    waits on the pool for its pages, and that
+    would deadlock with fewer workers than
+    formats.
+*/
+Error
+runGenerators(
+    std::vector<GeneratorRun> const& runs,
+    Corpus const& corpus,
+    ConfigImpl const& config)
+{
+    if(config.stats_)
+        reportMemoryStats(corpus);
+    if(config.verboseOutput)
+    {
+        reportInfo("Generating docs...\n");
+        dom::enableStats(true);
+    }
+    std::vector<Error> errors(runs.size());
+    {
+        ScopedPhase phase("generate");
+        auto const build =
+            [&](std::size_t i)
+            {
+                try
+                {
+                    errors[i] = runs[i].generator->build(
+                        runs[i].outputPath, corpus);
+                }
+                catch(Exception const& ex)
+                {
+                    errors[i] = ex.error();
+                }
+                catch(std::exception const& ex)
+                {
+                    reportUnhandledException(ex);
+                }
+            };
+        if(runs.size() == 1)
+        {
+            build(0);
+        }
+        else
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(runs.size());
+            for(std::size_t i = 0; i < runs.size(); ++i)
+                threads.emplace_back(build, i);
+            for(auto& t : threads)
+                t.join();
+        }
+    }
+    if(config.verboseOutput)
+    {
+        dom::enableStats(false);
+        reportDomStats();
+    }
+    if(config.stats_)
+        reportPeakMemory("generation");
+    reportPhases(config);
+    errors.erase(std::remove_if(errors.begin(), errors.end(),
+        [](Error const& err)
+        {
+            return ! err.failed();
+        }), errors.end());
+    if(errors.empty())
+        return Error::success();
+    if(errors.size() == 1)
+        return std::move(errors.front());
+    return Error(errors);
+}
+
+/** Run a generator, then report the memory if requested.
+*/
+Error
+runGenerator(
+    Generator const& generator,
+    Corpus const& corpus,
+    ConfigImpl const& config)
+{
+    return runGenerators({ { &generator,
+        toolArgs.outputPath.getValue() } }, corpus, config);
+}
+
+/** Return the absolute paths of the compilation databases.
+*/
+Expected<std::vector<std::string>>
+getCompilationsPaths()
+{
     if(toolArgs.inputPaths.empty())
         return formatError("the compilation database path argument is missing");
-    if(toolArgs.inputPaths.size() > 1)
-        return formatError("got {} input paths where 1 was expected", toolArgs.inputPaths.size());
-    auto compilationsPath = files::normalizePath(toolArgs.inputPaths.front());
-    std::string errorMessage;
-    auto jsonCompilations = tooling::JSONCompilationDatabase::loadFromFile(
-        compilationsPath, errorMessage, tooling::JSONCommandLineSyntax::AutoDetect);
-    if(! jsonCompilations)
-        return Error(std::move(errorMessage));
+    std::vector<std::string> paths;
+    for(auto const& inputPath : toolArgs.inputPaths)
+    {
+        auto absPath = files::makeAbsolute(
+            files::normalizePath(inputPath));
+        if(! absPath)
+            return absPath.error();
+        paths.emplace_back(std::move(*absPath));
+    }
+    return paths;
+}
+
+/** Load the compilation databases and make their paths absolute.
+
+    The relative paths of each database are
+    resolved against its own directory, and the
+    databases are merged into one, in order.
+    The time taken to parse and to adjust
+    the commands is reported if requested.
+*/
+Expected<std::unique_ptr<AbsoluteCompilationDatabase>>
+loadCompilations(
+    std::vector<std::string> const& compilationsPaths,
+    std::shared_ptr<ConfigImpl const> const& config,
+    bool report)
+{
+    using clock_type = std::chrono::steady_clock;
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+    ScopedPhase phase("load");
+    auto const start = clock_type::now();
+    std::vector<AbsoluteCompilationDatabase::Source> sources;
+    std::size_t n = 0;
+    for(auto const& compilationsPath : compilationsPaths)
+    {
+        auto commands = loadCompileCommands(
+            compilationsPath, config->threadPool());
+        if(! commands)
+            return commands.error();
+        n += commands->size();
+        sources.push_back({
+            files::getParentDir(compilationsPath),
+            std::move(*commands) });
+    }
+    auto const parsed = clock_type::now();
+    auto compilations = std::make_unique<AbsoluteCompilationDatabase>(
+        std::move(sources), config);
+    auto const adjusted = clock_type::now();
+    if(report)
+        reportInfo("Loaded {} compile commands in {:.1f} ms, "
+            "adjusted {} in {:.1f} ms",
+            n, milliseconds(parsed - start).count(),
+            compilations->size(),
+            milliseconds(adjusted - parsed).count());
+    if(compilations->conflicts() != 0)
+        reportWarning("{} files have other commands in the compilation "
+            "databases, and the first command is used",
+            compilations->conflicts());
+    return compilations;
+}
+
+/** The state kept by the server between updates.
+*/
+class ServeSession
+{
+    std::shared_ptr<ConfigImpl const> config_;
+    AbsoluteCompilationDatabase const& compilations_;
+    Generator const& generator_;
+    std::unique_ptr<TUCache> units_;
+    std::unique_ptr<Corpus> corpus_;
+    // unsaved contents of files, by absolute path
+    llvm::StringMap<std::string> buffers_;
+    // files whose contents changed since the last update
+    llvm::StringSet<> dirty_;
+
+public:
+    ServeSession(
+        std::shared_ptr<ConfigImpl const> config,
+        AbsoluteCompilationDatabase const& compilations,
+        Generator const& generator)
+        : config_(std::move(config))
+        , compilations_(compilations)
+        , generator_(generator)
+    {
+    }
+
+    /** Rebuild the corpus and regenerate the pages.
+
+        The results of each translation unit are kept
+        in memory, and are replayed when none of the
+        files it read changed, so only the affected
+        translation units are parsed again. Pages
+        whose text did not change are not written.
+
+        @param generate `false` if the pages are
+        rendered on demand, and not generated.
+
+        @return A line describing the work done.
+    */
+    Expected<std::string>
+    update(
+        bool generate = true)
+    {
+        using clock_type = std::chrono::steady_clock;
+        using milliseconds = std::chrono::duration<double, std::milli>;
+
+        auto const start = clock_type::now();
+        auto units = std::make_unique<TUCache>("", true);
+        if(units_)
+            units_->forEachEntry(
+                [&](llvm::StringRef key, TUCache::Entry const& entry)
+                {
+                    // the files on disk do not tell whether
+                    // a buffer changed since the entry was made
+                    if(std::any_of(entry.deps.begin(), entry.deps.end(),
+                        [&](TUCache::Dependency const& dep)
+                        {
+                            return dirty_.contains(dep.path);
+                        }))
+                        return;
+                    units->preload(key.str(), entry);
+                });
+
+        std::unique_ptr<Corpus> corpus;
+        {
+            ToolExecutor ex(*config_, compilations_);
+            ex.setTUCache(units.get());
+            for(auto const& buffer : buffers_)
+                ex.mapVirtualFile(buffer.first(), buffer.second);
+            auto result = CorpusImpl::build(ex, config_);
+            if(! result)
+                return result.error();
+            corpus = result.release();
+        }
+        if(generate)
+            if(auto err = runGenerator(generator_, *corpus, *config_))
+                return err;
+
+        // a failed update keeps the previous results
+        std::string result = fmt::format(
+            "{} of {} translation units parsed, "
+            "{} symbols, {:.0f} ms",
+            units->misses(), units->hits() + units->misses(),
+            corpus->index().size(),
+            milliseconds(clock_type::now() - start).count());
+        units_ = std::move(units);
+        corpus_ = std::move(corpus);
+        dirty_.clear();
+        return result;
+    }
+
+    /** Use the unsaved contents of a file instead of the file on disk.
+
+        The contents are used by every update
+        until they are discarded.
+    */
+    void
+    setBuffer(
+        std::string path,
+        std::string text)
+    {
+        dirty_.insert(path);
+        buffers_[path] = std::move(text);
+    }
+
+    /** Use the file on disk again.
+    */
+    void
+    discardBuffer(
+        llvm::StringRef path)
+    {
+        if(buffers_.erase(path))
+            dirty_.insert(path);
+    }
+
+    /** Return true if a buffer changed since the last update.
+    */
+    bool
+    buffersChanged() const noexcept
+    {
+        return ! dirty_.empty();
+    }
+
+    /** Return the symbol declared closest above a line of a file, or nullptr.
+
+        Only the selected symbols of the corpus
+        of the last update are considered.
+    */
+    Info const*
+    symbolAt(
+        llvm::StringRef path,
+        int line) const
+    {
+        if(! corpus_)
+            return nullptr;
+        std::string const file = files::makePosixStyle(path);
+        auto const sameFile =
+            [&](Location const& loc)
+            {
+                // the names are relative to the source root
+                llvm::StringRef name = loc.filename();
+                llvm::StringRef rest = file;
+                return ! name.empty() &&
+                    rest.consume_back(name) &&
+                    (rest.empty() || rest.ends_with("/"));
+            };
+        Info const* best = nullptr;
+        int bestLine = 0;
+        auto const consider =
+            [&](Info const& I, Location const& loc)
+            {
+                if(loc.LineNumber <= line &&
+                    loc.LineNumber > bestLine &&
+                    sameFile(loc))
+                {
+                    best = &I;
+                    bestLine = loc.LineNumber;
+                }
+            };
+        for(Info const* I : corpus_->index())
+        {
+            if(! corpus_->isSelected(*I))
+                continue;
+            visit(*I, [&]<class T>(T const& U)
+            {
+                if constexpr(std::derived_from<T, SourceInfo>)
+                {
+                    if(U.DefLoc)
+                        consider(U, *U.DefLoc);
+                    for(Location const& loc : U.Loc)
+                        consider(U, loc);
+                }
+            });
+        }
+        return best;
+    }
+
+    /** Regenerate the pages from the corpus in memory.
+
+        This is enough when only the templates
+        or the scripts of the addons changed.
+    */
+    Expected<std::string>
+    render()
+    {
+        using clock_type = std::chrono::steady_clock;
+        using milliseconds = std::chrono::duration<double, std::milli>;
+
+        if(! corpus_)
+            return update();
+        auto const start = clock_type::now();
+        if(auto err = runGenerator(generator_, *corpus_, *config_))
+            return err;
+        return fmt::format("rendered {} symbols, {:.0f} ms",
+            corpus_->index().size(),
+            milliseconds(clock_type::now() - start).count());
+    }
+
+    /** Return the corpus of the last update, or nullptr.
+    */
+    Corpus const*
+    corpus() const noexcept
+    {
+        return corpus_.get();
+    }
+
+    /** Invoke a function with each file the corpus was built from.
+
+        These are the main files of the compilation
+        database and every file their translation
+        units read.
+    */
+    void
+    forEachInput(
+        llvm::function_ref<void(llvm::StringRef)> f) const
+    {
+        for(auto const& file : compilations_.getAllFiles())
+            f(file);
+        if(units_)
+            units_->forEachEntry(
+                [&](llvm::StringRef, TUCache::Entry const& entry)
+                {
+                    for(auto const& dep : entry.deps)
+                        f(dep.path);
+                });
+    }
+};
+
+/** Regenerate whenever the inputs or the addons change.
+*/
+Error
+watchInputs(
+    ServeSession& session,
+    bool verbose)
+{
+    constexpr std::chrono::milliseconds debounce(100);
+
+    // the addons directory is dirsy
+    llvm::StringRef const addonsDir = toolArgs.addonsDir.getValue();
+    FileWatcher watcher;
+    watcher.watchDirectory(addonsDir);
+    reportInfo("Watching the inputs and \"{}\"", addonsDir);
+    for(;;)
+    {
+        // translation units may have read new files
+        session.forEachInput(
+            [&](llvm::StringRef path)
+            {
+                watcher.watchFile(path);
+            });
+        auto changed = watcher.wait(debounce);
+        if(! changed)
+            return changed.error();
+        bool const sourcesChanged = std::any_of(
+            changed->begin(), changed->end(),
+            [&](std::string const& path)
+            {
+                return ! llvm::StringRef(path).starts_with(addonsDir);
+            });
+        if(verbose)
+            for(auto const& path : *changed)
+                reportInfo("Changed \"{}\"", path);
+        auto result = sourcesChanged
+            ? session.update()
+            : session.render();
+        if(result)
+            reportInfo("{} files changed, {}", changed->size(), *result);
+        else
+            reportError(result.error(), "regenerate the documentation");
+    }
+}
+
+/** Write an HTTP response and close the connection.
+*/
+Error
+writeResponse(
+    LocalConnection& conn,
+    std::string_view status,
+    std::string_view contentType,
+    std::string_view body)
+{
+    if(auto err = conn.write(fmt::format(
+        "HTTP/1.1 {}\r\n"
+        "Content-Type: {}\r\n"
+        "Content-Length: {}\r\n"
+        "Connection: close\r\n"
+        "\r\n", status, contentType, body.size())))
+        return err;
+    return conn.write(body);
+}
+
+/** Serve the page of each symbol over HTTP, rendering it when requested.
+
+    A request for "/symbol/<id>", where the id is
+    the base16 form used in the names of pages,
+    returns the Asciidoc of the symbol. A request
+    for "/" returns the global namespace.
+*/
+Error
+serveHttp(
+    ServeSession& session,
+    std::uint16_t port,
+    bool verbose)
+{
+    auto renderer = adoc::PageRenderer::create(
+        *session.corpus(), toolArgs.httpCachePages);
+    if(! renderer)
+        return renderer.error();
+    auto server = LocalServer::listenTcp(port);
+    if(! server)
+        return server.error();
+    reportInfo("Serving pages on http://127.0.0.1:{}/symbol/<id>", port);
+
+    constexpr std::string_view text = "text/plain; charset=utf-8";
+    for(;;)
+    {
+        auto conn = server->accept();
+        if(! conn)
+            return conn.error();
+        auto request = conn->readLine();
+        if(! request)
+            continue;
+        // the headers are not used
+        while(auto header = conn->readLine())
+            if(header->empty())
+                break;
+
+        llvm::SmallVector<llvm::StringRef, 3> parts;
+        llvm::StringRef(*request).split(parts, ' ');
+        Error err;
+        if(parts.size() != 3 || ! parts[0].equals("GET"))
+        {
+            err = writeResponse(*conn, "405 Method Not Allowed",
+                text, "only GET is supported\n");
+        }
+        else
+        {
+            llvm::StringRef target = parts[1];
+            std::string bytes;
+            std::optional<SymbolID> id;
+            if(target == "/")
+                id = SymbolID::zero;
+            else if(target.consume_front("/symbol/") &&
+                llvm::tryGetFromHex(target, bytes) &&
+                bytes.size() == SymbolID().size())
+                id = SymbolID(bytes.data());
+
+            if(! id)
+            {
+                err = writeResponse(*conn, "404 Not Found",
+                    text, "expected /symbol/<id>\n");
+            }
+            else if(! session.corpus()->find(*id))
+            {
+                err = writeResponse(*conn, "404 Not Found",
+                    text, "the symbol was not found\n");
+            }
+            else
+            {
+                auto page = (*renderer)->render(*id);
+                if(page)
+                    err = writeResponse(*conn, "200 OK", text, *page);
+                else
+                    err = writeResponse(*conn, "500 Internal Server Error",
+                        text, fmt::format("{}\n", page.error().message()));
+            }
+        }
+        if(verbose)
+            reportInfo("{} ({} cached, {} rendered)", *request,
+                (*renderer)->hits(), (*renderer)->misses());
+        if(err)
+            reportWarning("Could not reply to the client: {}", err.message());
+    }
+}
+
+/** Parse a shard specification of the form "i/N".
+*/
+Error
+parseShard(
+    llvm::StringRef spec,
+    std::size_t& index,
+    std::size_t& count)
+{
+    auto [lhs, rhs] = spec.split('/');
+    if(lhs.getAsInteger(10, index) ||
+        rhs.getAsInteger(10, count) ||
+        count == 0 || index >= count)
+        return formatError("invalid shard \"{}\", expected \"i/N\" with i < N", spec);
+    return Error::success();
+}
+
+/** Compilation database for the translation units which are reparsed.
+*/
+class ReparseDB
+    : public tooling::CompilationDatabase
+{
+    std::vector<tooling::CompileCommand> cc_;
+
+public:
+    explicit
+    ReparseDB(
+        std::vector<tooling::CompileCommand> cc) noexcept
+        : cc_(std::move(cc))
+    {
+    }
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override
+    {
+        std::vector<tooling::CompileCommand> result;
+        for(auto const& cc : cc_)
+            if(FilePath.equals(cc.Filename))
+                result.push_back(cc);
+        return result;
+    }
+
+    std::vector<std::string>
+    getAllFiles() const override
+    {
+        std::vector<std::string> files;
+        for(auto const& cc : cc_)
+            files.push_back(cc.Filename);
+        return files;
+    }
+
+    std::vector<tooling::CompileCommand>
+    getAllCompileCommands() const override
+    {
+        return cc_;
+    }
+};
+
+/** Build the corpus from the clangd index of the configuration.
+
+    The translation units which match the reparse
+    patterns, or which the index has not seen, are
+    extracted, and their symbols replace the
+    imported ones. Without compilations only the
+    index is used.
+*/
+Expected<std::unique_ptr<Corpus>>
+buildFromClangdIndex(
+    std::shared_ptr<ConfigImpl const> const& config,
+    AbsoluteCompilationDatabase const* compilations)
+{
+    std::optional<ScopedPhase> importing(std::in_place, "import");
+    auto index = ClangdIndex::load(config->clangdIndex_, *config);
+    if(! index)
+        return index.error();
+    importing.reset();
+    if(config->verboseOutput)
+        reportInfo("Loaded {} symbols from the clangd index \"{}\"",
+            (*index)->size(), config->clangdIndex_);
+
+    Bitcodes bitcodes;
+    std::unique_ptr<ToolExecutor> ex;
+    std::optional<ReparseDB> reparsed;
+    if(compilations)
+    {
+        std::vector<tooling::CompileCommand> cc;
+        for(std::size_t i = 0; i < compilations->size(); ++i)
+        {
+            auto const cmd = (*compilations)[i];
+            if(config->shouldReparseTU(cmd.filename()) ||
+                ! (*index)->hasFile(cmd.filename()))
+                cc.emplace_back(cmd.command());
+        }
+        if(config->verboseOutput)
+            reportInfo("Reparsing {} of {} translation units",
+                cc.size(), compilations->size());
+        setMetric("mrdox_reparsed_tus", cc.size());
+        if(! cc.empty())
+        {
+            reparsed.emplace(std::move(cc));
+            ex = std::make_unique<ToolExecutor>(*config, *reparsed);
+            if(auto err = ex->execute(
+                makeFrontendActionFactory(
+                    *ex->getExecutionContext(), *config)))
+            {
+                if(! config->ignoreFailures)
+                    return toError(std::move(err));
+                reportWarning("mapping failed: {}", toString(std::move(err)));
+            }
+            bitcodes = collectBitcodes(*ex);
+        }
+    }
+
+    // The bitcodes refer to the index and
+    // to the results of the executor
+    auto const imported = (*index)->insertInto(bitcodes);
+    setMetric("mrdox_clangd_index_symbols", imported);
+    if(config->verboseOutput)
+        reportInfo("Imported {} symbols from the clangd index", imported);
+    auto corpus = CorpusImpl::build(bitcodes, config);
+    if(! corpus)
+        return corpus.error();
+    return corpus;
+}
+
+} // (anon)
+
+Error
+DoGenerateAction()
+{
+    auto config = loadToolConfig();
+    if(! config)
+        return config.error();
+
+    // A snapshot holds a reduced corpus, so without
+    // a compilation database only the generators run.
+    if(! toolArgs.fromSnapshot.empty() &&
+        toolArgs.inputPaths.empty())
+    {
+        if( toolArgs.outputPath.empty())
+            return formatError("output path is empty");
+        toolArgs.outputPath = files::normalizePath(
+            files::makeAbsolute(toolArgs.outputPath,
+                (*config)->workingDir));
+
+        auto runs = findGenerators(**config);
+        if(! runs)
+            return runs.error();
+
+        auto const path = files::makeAbsolute(
+            toolArgs.fromSnapshot.getValue(), (*config)->workingDir);
+        if(toolArgs.lazySnapshot)
+        {
+            auto corpus = SnapshotCorpus::load(path, *config);
+            if(! corpus)
+                return formatError("SnapshotCorpus::load returned \"{}\"", corpus.error());
+            return runGenerators(*runs, **corpus, **config);
+        }
+        auto corpus = CorpusImpl::loadSnapshot(path, *config);
+        if(! corpus)
+            return formatError("CorpusImpl::loadSnapshot returned \"{}\"", corpus.error());
+
+        return runGenerators(*runs, **corpus, **config);
+    }
+
+    // A clangd index is enough to build the corpus
+    if(! (*config)->clangdIndex_.empty() &&
+        toolArgs.inputPaths.empty())
+    {
+        if( toolArgs.outputPath.empty())
+            return formatError("output path is empty");
+        toolArgs.outputPath = files::normalizePath(
+            files::makeAbsolute(toolArgs.outputPath,
+                (*config)->workingDir));
+
+        auto runs = findGenerators(**config);
+        if(! runs)
+            return runs.error();
+
+        auto corpus = buildFromClangdIndex(*config, nullptr);
+        if(! corpus)
+            return formatError("buildFromClangdIndex returned \"{}\"", corpus.error());
+        return runGenerators(*runs, **corpus, **config);
+    }
+
+    // Load the compilation databases
+    auto compilationsPaths = getCompilationsPaths();
+    if(! compilationsPaths)
+        return compilationsPaths.error();
 
     // Calculate the working directory
-    auto absPath = files::makeAbsolute(compilationsPath);
-    if(! absPath)
-        return absPath.error();
-    auto workingDir = files::getParentDir(*absPath);
+    auto workingDir = files::getParentDir(compilationsPaths->front());
 
     // normalize outputPath
     if( toolArgs.outputPath.empty())
@@ -71,27 +961,393 @@ DoGenerateAction()
             (*config)->workingDir));
 
     // Convert relative paths to absolute
-    AbsoluteCompilationDatabase compilations(
-        workingDir, *jsonCompilations, *config);
+    auto loaded = loadCompilations(*compilationsPaths,
+        *config, (*config)->verboseOutput);
+    if(! loaded)
+        return loaded.error();
+    AbsoluteCompilationDatabase& compilations = **loaded;
+
+    // With a clangd index only some of the
+    // translation units are extracted
+    if(! (*config)->clangdIndex_.empty())
+    {
+        auto runs = findGenerators(**config);
+        if(! runs)
+            return runs.error();
+
+        auto corpus = buildFromClangdIndex(*config, &compilations);
+        if(! corpus)
+            return formatError("buildFromClangdIndex returned \"{}\"", corpus.error());
+        return runGenerators(*runs, **corpus, **config);
+    }
+
+    // In header scan mode the translation units are
+    // generated files which include the public headers.
+    std::optional<HeaderScanDatabase> headerScan;
+    if(! (*config)->headerScan_.empty())
+    {
+        auto headers = findHeaderFiles((*config)->headers_);
+        if(! headers)
+            return headers.error();
+        if(headers->empty())
+            return formatError("header-scan found no headers");
+        if(compilations.size() == 0)
+            return formatError("header-scan needs at least one compile command");
+        headerScan.emplace(workingDir, compilations, *headers,
+            (*config)->headerScan_ == "umbrella");
+        if((*config)->verboseOutput)
+            reportInfo("Scanning {} headers", headers->size());
+    }
 
     // Create the ToolExecutor from the compilation database
-    auto ex = std::make_unique<ToolExecutor>(**config, compilations);
+    auto ex = headerScan
+        ? std::make_unique<ToolExecutor>(**config, *headerScan)
+        : std::make_unique<ToolExecutor>(**config, compilations);
+    if(headerScan)
+        for(auto const& kv : headerScan->contents())
+            ex->mapVirtualFile(kv.first(), kv.second);
+
+    // The results of each translation unit are kept
+    // when they are saved to a snapshot, and unchanged
+    // ones are replayed from a previous snapshot.
+    std::optional<TUCache> units;
+    if(! toolArgs.saveSnapshot.empty() ||
+        ! toolArgs.fromSnapshot.empty())
+    {
+        units.emplace((*config)->cacheDir(),
+            ! toolArgs.saveSnapshot.empty());
+        if(! toolArgs.fromSnapshot.empty())
+        {
+            if(auto err = CorpusImpl::loadSnapshotUnits(
+                files::makeAbsolute(toolArgs.fromSnapshot.getValue(),
+                    (*config)->workingDir), *units))
+                return err;
+        }
+        ex->setTUCache(&*units);
+    }
+
+    // Distributed extraction writes the raw
+    // bitcode, which is reduced by the merge action.
+    if(! toolArgs.shard.empty())
+    {
+        std::size_t index;
+        std::size_t count;
+        if(auto err = parseShard(toolArgs.shard.getValue(), index, count))
+            return err;
+        ex->setShard(index, count);
+        if((*config)->verboseOutput)
+            reportInfo("Mapping declarations for shard {} of {}", index, count);
+        if(auto err = ex->execute(
+            makeFrontendActionFactory(
+                *ex->getExecutionContext(), **config)))
+        {
+            if(! (*config)->ignoreFailures)
+                return toError(std::move(err));
+            reportWarning("mapping failed: {}", toString(std::move(err)));
+        }
+        return writeBitcodeShard(
+            toolArgs.outputPath.getValue(), collectBitcodes(*ex));
+    }
+
+    // Create the generators
+    auto runs = findGenerators(**config);
+    if(! runs)
+        return runs.error();
+
+    // A snapshot may be read by any generator,
+    // so it is always extracted in full.
+    if(! units)
+        ex->setFacets(facetsOf(*runs));
+
+    // Run the tool, this can take a while
+    auto corpus = CorpusImpl::build(*ex, *config);
+    if(! corpus)
+        return formatError("CorpusImpl::build returned \"{}\"", corpus.error());
+
+    if(! toolArgs.saveSnapshot.empty())
+    {
+        if(auto err = CorpusImpl::saveSnapshot(**corpus,
+            files::makeAbsolute(toolArgs.saveSnapshot.getValue(),
+                (*config)->workingDir), &*units))
+            return err;
+    }
+
+    // Run the generators.
+    return runGenerators(*runs, **corpus, **config);
+}
+
+Error
+DoLoadAction()
+{
+    auto config = loadToolConfig();
+    if(! config)
+        return config.error();
+
+    auto compilationsPaths = getCompilationsPaths();
+    if(! compilationsPaths)
+        return compilationsPaths.error();
+
+    auto compilations = loadCompilations(
+        *compilationsPaths, *config, true);
+    if(! compilations)
+        return compilations.error();
+    return Error::success();
+}
+
+Error
+DoServeAction()
+{
+    auto& generators = getGenerators();
+
+    auto config = loadToolConfig();
+    if(! config)
+        return config.error();
+
+    auto compilationsPaths = getCompilationsPaths();
+    if(! compilationsPaths)
+        return compilationsPaths.error();
+
+    if( toolArgs.outputPath.empty())
+        return formatError("output path is empty");
+    toolArgs.outputPath = files::normalizePath(
+        files::makeAbsolute(toolArgs.outputPath,
+            (*config)->workingDir));
 
-    // Create the generator
     auto generator = generators.find(toolArgs.formatType.getValue());
     if(! generator)
         return formatError("the Generator \"{}\" was not found",
             toolArgs.formatType.getValue());
 
-    // Run the tool, this can take a while
-    auto corpus = CorpusImpl::build(*ex, *config);
+    // The compilation database is loaded once, so
+    // the server is restarted when it changes.
+    auto compilations = loadCompilations(*compilationsPaths,
+        *config, (*config)->verboseOutput);
+    if(! compilations)
+        return compilations.error();
+
+    // Rendering on demand needs a builder for pages,
+    // which only the Asciidoc generator has.
+    if(toolArgs.httpPort.getValue() > 65535)
+        return formatError("invalid port {}", toolArgs.httpPort.getValue());
+    auto const httpPort = static_cast<std::uint16_t>(
+        toolArgs.httpPort.getValue());
+    if(httpPort != 0 && generator->id() != "adoc")
+        return formatError("--http-port needs the adoc generator");
+
+    ServeSession session(*config, **compilations, *generator);
+    auto first = session.update(httpPort == 0);
+    if(! first)
+        return first.error();
+    reportInfo("Built the corpus: {}", *first);
+
+    if(httpPort != 0)
+        return serveHttp(session, httpPort, (*config)->verboseOutput);
+
+    if(toolArgs.watch)
+        return watchInputs(session, (*config)->verboseOutput);
+
+    auto socketPath = files::makeAbsolute(toolArgs.serveSocket.getValue());
+    if(! socketPath)
+        return socketPath.error();
+    auto server = LocalServer::listen(*socketPath);
+    if(! server)
+        return server.error();
+    reportInfo("Listening on \"{}\"", *socketPath);
+
+    // Each line of a connection is a command:
+    //
+    //   changed <path>          a file was changed
+    //   buffer <size> <path>    the next size bytes are the
+    //                           unsaved contents of a file
+    //   discard <path>          use the file on disk again
+    //   page <line> <path>      render the symbol at a line
+    //   update                  regenerate for the files changed
+    //   stop                    stop the server
+    //
+    // Every page, update and stop is answered with a
+    // line which starts with "ok" or "error". A page
+    // is answered with "ok <size>" and the Asciidoc.
+    // Updates of several changed files are coalesced,
+    // and a page only parses the translation units
+    // which read a buffer that changed.
+    std::unique_ptr<adoc::PageRenderer> renderer;
+    for(;;)
+    {
+        auto conn = server->accept();
+        if(! conn)
+            return conn.error();
+        std::size_t changed = 0;
+        while(auto line = conn->readLine())
+        {
+            std::string_view cmd = *line;
+            std::string reply;
+            if(cmd.starts_with("changed "))
+            {
+                // the contents of the files decide
+                // which translation units are parsed
+                ++changed;
+                continue;
+            }
+            if(cmd.starts_with("buffer "))
+            {
+                std::size_t size = 0;
+                auto [count, path] = llvm::StringRef(cmd).drop_front(7).split(' ');
+                if(count.getAsInteger(10, size) || path.empty())
+                {
+                    reply = "error expected buffer <size> <path>";
+                }
+                else
+                {
+                    auto text = conn->read(size);
+                    if(! text)
+                        break;
+                    session.setBuffer(path.str(), std::move(*text));
+                    continue;
+                }
+            }
+            else if(cmd.starts_with("discard "))
+            {
+                session.discardBuffer(cmd.substr(8));
+                continue;
+            }
+            else if(cmd.starts_with("page "))
+            {
+                int lineNumber = 0;
+                auto [number, path] = llvm::StringRef(cmd).drop_front(5).split(' ');
+                Expected<std::string> page = std::string();
+                if(generator->id() != "adoc")
+                {
+                    page = formatError("pages need the adoc generator");
+                }
+                else if(number.getAsInteger(10, lineNumber) || path.empty())
+                {
+                    page = formatError("expected page <line> <path>");
+                }
+                else
+                {
+                    if(session.buffersChanged())
+                    {
+                        // the site is regenerated by the next update
+                        auto result = session.update(false);
+                        if(! result)
+                            page = result.error();
+                        else if((*config)->verboseOutput)
+                            reportInfo("Update: {}", *result);
+                        renderer.reset();
+                    }
+                    if(page && ! renderer)
+                    {
+                        auto created = adoc::PageRenderer::create(
+                            *session.corpus(), toolArgs.httpCachePages);
+                        if(created)
+                            renderer = std::move(*created);
+                        else
+                            page = created.error();
+                    }
+                    if(page)
+                    {
+                        Info const* I = session.symbolAt(path, lineNumber);
+                        if(! I)
+                            page = formatError("no symbol is declared at {}:{}",
+                                path, lineNumber);
+                        else
+                            page = renderer->render(I->id);
+                    }
+                }
+                if(! page)
+                {
+                    reply = fmt::format("error {}", page.error().message());
+                }
+                else
+                {
+                    Error err = conn->writeLine(
+                        fmt::format("ok {}", page->size()));
+                    if(! err)
+                        err = conn->write(*page);
+                    if(err)
+                    {
+                        reportWarning("Could not reply to the client: {}", err.message());
+                        break;
+                    }
+                    continue;
+                }
+            }
+            else if(cmd == "update")
+            {
+                renderer.reset();
+                auto result = session.update();
+                if(result)
+                    reply = fmt::format("ok {} files changed, {}", changed, *result);
+                else
+                    reply = fmt::format("error {}", result.error().message());
+                if((*config)->verboseOutput)
+                    reportInfo("Update: {}", reply);
+                changed = 0;
+            }
+            else if(cmd == "stop")
+            {
+                if(auto err = conn->writeLine("ok"))
+                    reportWarning("Could not reply to the client: {}", err.message());
+                return Error::success();
+            }
+            else if(cmd.empty())
+            {
+                continue;
+            }
+            else
+            {
+                reply = fmt::format("error unknown command \"{}\"", cmd);
+            }
+            if(auto err = conn->writeLine(reply))
+            {
+                reportWarning("Could not reply to the client: {}", err.message());
+                break;
+            }
+        }
+    }
+}
+
+Error
+DoMergeAction()
+{
+    auto config = loadToolConfig();
+    if(! config)
+        return config.error();
+
+    if(toolArgs.inputPaths.empty())
+        return formatError("the bitcode shard path arguments are missing");
+
+    // normalize outputPath
+    if( toolArgs.outputPath.empty())
+        return formatError("output path is empty");
+    toolArgs.outputPath = files::normalizePath(
+        files::makeAbsolute(toolArgs.outputPath,
+            (*config)->workingDir));
+
+    // Create the generators
+    auto runs = findGenerators(**config);
+    if(! runs)
+        return runs.error();
+
+    // The bitcodes refer to the shard buffers
+    Bitcodes bitcodes;
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> buffers;
+    for(auto const& path : toolArgs.inputPaths)
+    {
+        auto buffer = readBitcodeShard(path, bitcodes);
+        if(! buffer)
+            return buffer.error();
+        buffers.emplace_back(std::move(*buffer));
+    }
+    if((*config)->verboseOutput)
+        reportInfo("Merging {} shards", buffers.size());
+
+    auto corpus = CorpusImpl::build(bitcodes, *config);
     if(! corpus)
         return formatError("CorpusImpl::build returned \"{}\"", corpus.error());
 
-    // Run the generator.
-    if((*config)->verboseOutput)
-        reportInfo("Generating docs...\n");
-    return generator->build(toolArgs.outputPath.getValue(), **corpus);
+    // Run the generators.
+    return runGenerators(*runs, **corpus, **config);
 }
 
 } // mrdox
@@ -0,0 +1,243 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "IncludeScanner.hpp"
+#include "Support/Trace.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Path.hpp>
+#include <clang/Tooling/DependencyScanning/DependencyScanningService.h>
+#include <clang/Tooling/DependencyScanning/DependencyScanningTool.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+namespace deps = tooling::dependencies;
+
+namespace {
+
+/** Return the prerequisites of a rule written in the syntax of make.
+
+    This is the form of the output of
+    `-M`, with escaped spaces and lines
+    continued with a backslash.
+*/
+std::vector<std::string>
+parseMakeRule(
+    llvm::StringRef text)
+{
+    std::vector<std::string> result;
+    // the target is followed by a colon and a
+    // space, so a drive letter is not matched
+    std::size_t pos = 0;
+    for(;;)
+    {
+        pos = text.find(':', pos);
+        if(pos == llvm::StringRef::npos)
+            return result;
+        ++pos;
+        if(pos == text.size() ||
+            text[pos] == ' ' ||
+            text[pos] == '\t' ||
+            text[pos] == '\n' ||
+            text[pos] == '\r')
+            break;
+    }
+    std::string path;
+    auto const flush = [&]
+    {
+        if(! path.empty())
+            result.push_back(std::move(path));
+        path.clear();
+    };
+    for(auto const n = text.size(); pos < n; ++pos)
+    {
+        char const c = text[pos];
+        if(c == '\\' && pos + 1 < n)
+        {
+            char const next = text[pos + 1];
+            if(next == '\n' || next == '\r')
+            {
+                flush();
+                continue;
+            }
+            if(next == ' ' || next == '#')
+            {
+                path.push_back(next);
+                ++pos;
+                continue;
+            }
+        }
+        if(c == '$' && pos + 1 < n && text[pos + 1] == '$')
+        {
+            path.push_back('$');
+            ++pos;
+            continue;
+        }
+        if(c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            flush();
+            continue;
+        }
+        path.push_back(c);
+    }
+    flush();
+    return result;
+}
+
+std::string
+makeAbsolute(
+    llvm::StringRef path,
+    llvm::StringRef dir)
+{
+    llvm::SmallString<256> result(path);
+    if(! llvm::sys::path::is_absolute(result))
+        llvm::sys::fs::make_absolute(dir, result);
+    llvm::sys::path::remove_dots(result, true);
+    return std::string(result);
+}
+
+} // (anon)
+
+IncludeScanner::
+IncludeScanner(
+    std::string_view cacheDir)
+    : cache_(cacheDir.empty() ? std::string() :
+        files::appendPath(cacheDir, "includes"))
+{
+}
+
+void
+IncludeScanner::
+scan(
+    tooling::CompilationDatabase const& db,
+    std::vector<std::string> const& files,
+    tooling::ArgumentsAdjuster const& adjuster,
+    ThreadPool& threadPool,
+    bool verbose)
+{
+    // the service holds the directives of each
+    // file, which are shared by all of the scans
+    deps::DependencyScanningService service(
+#if LLVM_VERSION_MAJOR >= 16
+        deps::ScanningMode::DependencyDirectivesScan,
+#else
+        deps::ScanningMode::MinimizedSourcePreprocessing,
+#endif
+        deps::ScanningOutputFormat::Make);
+
+    std::mutex mutex;
+    llvm::StringMap<std::uint64_t> sizes;
+    auto const fileSize = [&](std::string const& path)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = sizes.find(path);
+            if(it != sizes.end())
+                return it->second;
+        }
+        std::uint64_t size = 0;
+        if(llvm::sys::fs::file_size(path, size))
+            size = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        sizes.try_emplace(path, size);
+        return size;
+    };
+    std::atomic<std::size_t> failed = 0;
+    auto errors = threadPool.forEach(files,
+        [&](std::string const& file)
+        {
+            TraceScope trace("scan includes", file);
+            auto commands = db.getCompileCommands(file);
+            if(commands.size() != 1)
+                return;
+            auto& cmd = commands.front();
+            if(adjuster)
+                cmd.CommandLine = adjuster(cmd.CommandLine, cmd.Filename);
+            auto const key = TUCache::makeKey(cmd);
+            auto const mainFile = makeAbsolute(cmd.Filename, cmd.Directory);
+
+            std::optional<TUCache::Entry> entry = cache_.load(key);
+            if(! entry)
+            {
+                deps::DependencyScanningTool tool(service);
+                auto rule = tool.getDependencyFile(
+                    cmd.CommandLine, cmd.Directory);
+                if(! rule)
+                {
+                    // the parse reports the same errors
+                    llvm::consumeError(rule.takeError());
+                    ++failed;
+                    return;
+                }
+                entry.emplace();
+                for(auto& dep : parseMakeRule(*rule))
+                {
+                    auto path = makeAbsolute(dep, cmd.Directory);
+                    auto hash = cache_.getFileHash(path);
+                    if(! hash)
+                        continue;
+                    entry->deps.push_back({ std::move(path), *hash });
+                }
+                if(auto err = cache_.store(key, *entry))
+                    reportWarning("Could not cache the includes of \"{}\": {}",
+                        file, err.message());
+            }
+
+            Unit unit;
+            for(auto& dep : entry->deps)
+            {
+                // a header is as costly as a main file
+                unit.bytes += fileSize(dep.path);
+                if(dep.path != mainFile)
+                    unit.includes.push_back(std::move(dep.path));
+            }
+            std::sort(unit.includes.begin(), unit.includes.end());
+            unit.includes.erase(std::unique(unit.includes.begin(),
+                unit.includes.end()), unit.includes.end());
+            std::lock_guard<std::mutex> lock(mutex);
+            units_.insert_or_assign(file, std::move(unit));
+        });
+    if(! errors.empty())
+        reportError(errors, "scan the includes");
+    if(verbose)
+        reportInfo("Scanned the includes of {} translation units ({} cached, {} failed)",
+            units_.size(), cache_.hits(), failed.load());
+}
+
+std::span<std::string const>
+IncludeScanner::
+includes(
+    llvm::StringRef file) const noexcept
+{
+    auto it = units_.find(file);
+    if(it == units_.end())
+        return {};
+    return it->getValue().includes;
+}
+
+std::uint64_t
+IncludeScanner::
+bytes(
+    llvm::StringRef file) const noexcept
+{
+    auto it = units_.find(file);
+    if(it == units_.end())
+        return 0;
+    return it->getValue().bytes;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,113 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_INCLUDESCANNER_HPP
+#define MRDOX_TOOL_TOOL_INCLUDESCANNER_HPP
+
+#include "Tool/TUCache.hpp"
+#include <mrdox/Support/ThreadPool.hpp>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringMap.h>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** The files included by each translation unit, found without parsing.
+
+    Each translation unit is preprocessed with
+    the dependency directives scanner of clang,
+    which only lexes the directives of each file,
+    as clang-scan-deps does. This is a small part
+    of the cost of a parse, and the translation
+    units are scanned concurrently.
+
+    When there is a cache directory, the files of
+    each translation unit are kept between runs,
+    keyed on the adjusted command, and are reused
+    while none of the files changed.
+*/
+class IncludeScanner
+{
+    struct Unit
+    {
+        std::vector<std::string> includes;
+        std::uint64_t bytes = 0;
+    };
+
+    TUCache cache_;
+    llvm::StringMap<Unit> units_;
+
+public:
+    /** Constructor.
+
+        @param cacheDir The directory which holds
+        the results between runs, or empty for none.
+    */
+    explicit
+    IncludeScanner(
+        std::string_view cacheDir);
+
+    /** Find the files included by a set of translation units.
+
+        A translation unit which cannot be scanned
+        is left out, and is still parsed normally.
+
+        @param adjuster The arguments adjuster which
+        is applied to the compile commands first.
+    */
+    void
+    scan(
+        tooling::CompilationDatabase const& db,
+        std::vector<std::string> const& files,
+        tooling::ArgumentsAdjuster const& adjuster,
+        ThreadPool& threadPool,
+        bool verbose);
+
+    /** Return true if a translation unit was scanned.
+    */
+    bool
+    contains(
+        llvm::StringRef file) const noexcept
+    {
+        return units_.count(file) != 0;
+    }
+
+    /** Return the files a translation unit includes, directly or not.
+
+        The paths are absolute and sorted, and
+        the main file is not included.
+    */
+    std::span<std::string const>
+    includes(
+        llvm::StringRef file) const noexcept;
+
+    /** Return the size of a translation unit and the files it includes.
+
+        Zero is returned for a translation unit
+        which was not scanned.
+    */
+    std::uint64_t
+    bytes(
+        llvm::StringRef file) const noexcept;
+
+    std::size_t hits() const noexcept { return cache_.hits(); }
+    std::size_t misses() const noexcept { return cache_.misses(); }
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,98 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_INFOARENA_HPP
+#define MRDOX_TOOL_TOOL_INFOARENA_HPP
+
+#include <mrdox/Metadata.hpp>
+#include <llvm/Support/Allocator.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+
+namespace clang {
+namespace mrdox {
+
+/** Storage for Info objects, grouped by kind.
+
+    Each kind of Info has its own bump allocator,
+    so the symbols of one kind are contiguous in
+    memory and are freed all at once. The members
+    of an Info, such as its strings and vectors,
+    still use the heap.
+
+    @par Thread Safety
+    Not thread-safe.
+*/
+class InfoArena
+{
+    static constexpr std::size_t NumKinds =
+        static_cast<std::size_t>(InfoKind::Specialization) + 1;
+
+    std::tuple<
+        llvm::SpecificBumpPtrAllocator<NamespaceInfo>,
+        llvm::SpecificBumpPtrAllocator<RecordInfo>,
+        llvm::SpecificBumpPtrAllocator<FunctionInfo>,
+        llvm::SpecificBumpPtrAllocator<EnumInfo>,
+        llvm::SpecificBumpPtrAllocator<TypedefInfo>,
+        llvm::SpecificBumpPtrAllocator<VariableInfo>,
+        llvm::SpecificBumpPtrAllocator<FieldInfo>,
+        llvm::SpecificBumpPtrAllocator<SpecializationInfo>> allocs_;
+
+public:
+    /** The number and size of the Infos of one kind.
+    */
+    struct Usage
+    {
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+    };
+
+private:
+    std::array<Usage, NumKinds> usage_{};
+
+public:
+    /** Move an Info into the arena.
+
+        @return A pointer to the Info, which is
+        owned by the arena.
+    */
+    Info*
+    adopt(std::unique_ptr<Info> I)
+    {
+        return visit(*I,
+            [&]<class T>(T const& J) -> Info*
+            {
+                auto& alloc = std::get<
+                    llvm::SpecificBumpPtrAllocator<T>>(allocs_);
+                T* P = new(alloc.Allocate()) T(
+                    std::move(const_cast<T&>(J)));
+                auto& u = usage_[static_cast<std::size_t>(T::kind_id)];
+                ++u.count;
+                u.bytes += sizeof(T);
+                return P;
+            });
+    }
+
+    /** Return the usage for one kind.
+    */
+    Usage
+    usage(InfoKind kind) const noexcept
+    {
+        return usage_[static_cast<std::size_t>(kind)];
+    }
+};
+
+} // mrdox
+} // clang
+
+#endif
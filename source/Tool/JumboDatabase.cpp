@@ -0,0 +1,188 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "JumboDatabase.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <algorithm>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+constexpr llvm::StringLiteral unitPrefix = ".mrdox-jumbo-";
+
+} // (anon)
+
+void
+JumboDatabase::
+group(
+    std::vector<std::string>& files,
+    std::size_t size,
+    llvm::function_ref<bool(std::string const&)> eligible,
+    tooling::ArgumentsAdjuster const& adjuster)
+{
+    if(size < 2)
+        return;
+
+    // Group the translation units on everything
+    // but the main file. The order of the groups
+    // is that of their first files.
+    struct Group
+    {
+        tooling::CompileCommand cmd;
+        std::vector<std::string> files;
+    };
+    std::vector<Group> groups;
+    llvm::StringMap<std::size_t> index;
+    std::vector<std::string> rest;
+    for(auto& file : files)
+    {
+        auto commands = db_.getCompileCommands(file);
+        if(commands.size() != 1 || ! eligible(file))
+        {
+            rest.push_back(std::move(file));
+            continue;
+        }
+        auto cmd = commands.front();
+        if(adjuster)
+            cmd.CommandLine = adjuster(cmd.CommandLine, cmd.Filename);
+        // the main file itself is not a flag
+        auto const n = cmd.CommandLine.size();
+        std::erase(cmd.CommandLine, cmd.Filename);
+        std::erase(cmd.CommandLine, file);
+        if(cmd.CommandLine.size() + 1 != n)
+        {
+            // the unit could not name its file
+            rest.push_back(std::move(file));
+            continue;
+        }
+
+        llvm::SHA1 H;
+        H.update(cmd.Directory);
+        H.update(llvm::sys::path::extension(file));
+        for(auto const& arg : cmd.CommandLine)
+        {
+            H.update(arg);
+            H.update(llvm::StringRef("\0", 1));
+        }
+        auto [it, inserted] = index.try_emplace(
+            llvm::toHex(H.final(), true), groups.size());
+        if(inserted)
+            groups.push_back({ std::move(commands.front()), {} });
+        groups[it->second].files.push_back(std::move(file));
+    }
+
+    files.clear();
+    for(auto& group : groups)
+    {
+        for(std::size_t first = 0; first < group.files.size(); first += size)
+        {
+            std::size_t const last = std::min(first + size, group.files.size());
+            if(last - first < 2)
+            {
+                rest.push_back(std::move(group.files[first]));
+                continue;
+            }
+            Unit unit;
+            unit.members.assign(
+                std::make_move_iterator(group.files.begin() + first),
+                std::make_move_iterator(group.files.begin() + last));
+
+            // the unit is named by its members, next
+            // to the first, so that its cache key is
+            // the same from one run to the next
+            llvm::SHA1 H;
+            for(auto const& member : unit.members)
+            {
+                H.update(member);
+                H.update(llvm::StringRef("\0", 1));
+                unit.text += "#include \"";
+                unit.text += files::makePosixStyle(member);
+                unit.text += "\"\n";
+            }
+            std::string name = files::appendPath(
+                files::getParentDir(unit.members.front()),
+                (unitPrefix + llvm::toHex(H.final(), true) +
+                    llvm::sys::path::extension(unit.members.front())).str());
+
+            unit.command = group.cmd;
+            for(auto& arg : unit.command.CommandLine)
+                if(arg == unit.command.Filename)
+                    arg = name;
+            unit.command.Filename = name;
+            files.push_back(name);
+            units_.try_emplace(name, std::move(unit));
+        }
+    }
+    for(auto& file : rest)
+        files.push_back(std::move(file));
+}
+
+std::span<std::string const>
+JumboDatabase::
+members(
+    llvm::StringRef file) const noexcept
+{
+    auto it = units_.find(file);
+    if(it == units_.end())
+        return {};
+    return it->getValue().members;
+}
+
+llvm::StringRef
+JumboDatabase::
+text(
+    llvm::StringRef file) const noexcept
+{
+    auto it = units_.find(file);
+    if(it == units_.end())
+        return {};
+    return it->getValue().text;
+}
+
+bool
+JumboDatabase::
+isUnit(
+    llvm::StringRef file) noexcept
+{
+    return llvm::sys::path::filename(file).starts_with(unitPrefix);
+}
+
+std::vector<tooling::CompileCommand>
+JumboDatabase::
+getCompileCommands(
+    llvm::StringRef FilePath) const
+{
+    auto it = units_.find(FilePath);
+    if(it == units_.end())
+        return db_.getCompileCommands(FilePath);
+    return { it->getValue().command };
+}
+
+std::vector<std::string>
+JumboDatabase::
+getAllFiles() const
+{
+    return db_.getAllFiles();
+}
+
+std::vector<tooling::CompileCommand>
+JumboDatabase::
+getAllCompileCommands() const
+{
+    return db_.getAllCompileCommands();
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,115 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_JUMBODATABASE_HPP
+#define MRDOX_TOOL_TOOL_JUMBODATABASE_HPP
+
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Translation units which are parsed together.
+
+    Small translation units with the same
+    compile command, apart from the main file,
+    are grouped into jumbo units. A jumbo unit is
+    a virtual file which includes each of its
+    members, so the headers they share are parsed
+    once. Its command is that of the first member,
+    and the commands of the other files are those
+    of the wrapped database.
+*/
+class JumboDatabase
+    : public tooling::CompilationDatabase
+{
+    struct Unit
+    {
+        tooling::CompileCommand command;
+        std::string text;
+        std::vector<std::string> members;
+    };
+
+    tooling::CompilationDatabase const& db_;
+    llvm::StringMap<Unit> units_;
+
+public:
+    explicit
+    JumboDatabase(
+        tooling::CompilationDatabase const& db) noexcept
+        : db_(db)
+    {
+    }
+
+    /** Group files into jumbo units.
+
+        @param files The files, which are replaced
+        by the jumbo units first, and then the files
+        which are not in one, in their order.
+
+        @param size The most files in a unit.
+
+        @param eligible Return true if a file may
+        be in a unit.
+
+        @param adjuster The arguments adjuster which
+        is applied to the commands before they
+        are compared.
+    */
+    void
+    group(
+        std::vector<std::string>& files,
+        std::size_t size,
+        llvm::function_ref<bool(std::string const&)> eligible,
+        tooling::ArgumentsAdjuster const& adjuster);
+
+    /** Return the members of a jumbo unit.
+
+        The list is empty when the file
+        is not a jumbo unit.
+    */
+    std::span<std::string const>
+    members(
+        llvm::StringRef file) const noexcept;
+
+    /** Return the text of a jumbo unit.
+    */
+    llvm::StringRef
+    text(
+        llvm::StringRef file) const noexcept;
+
+    /** Return true if a file is named like a jumbo unit.
+    */
+    static
+    bool
+    isUnit(
+        llvm::StringRef file) noexcept;
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override;
+
+    std::vector<std::string>
+    getAllFiles() const override;
+
+    std::vector<tooling::CompileCommand>
+    getAllCompileCommands() const override;
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,77 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "MemoryGovernor.hpp"
+#include "Support/Memory.hpp"
+#include <chrono>
+
+namespace clang {
+namespace mrdox {
+
+MemoryGovernor::
+MemoryGovernor(
+    std::size_t budget) noexcept
+    : budget_(budget)
+    , baseline_(getResidentBytes())
+{
+}
+
+bool
+MemoryGovernor::
+fits(std::size_t bytes) const noexcept
+{
+    if(running_ == 0)
+        return true;
+    if(baseline_ + reserved_ + bytes > budget_)
+        return false;
+    // the estimates may be low, so the
+    // actual size is checked as well
+    return getResidentBytes() < budget_;
+}
+
+void
+MemoryGovernor::
+acquire(std::size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(! fits(bytes))
+    {
+        ++waits_;
+        // the resident size can fall without a
+        // release, so the condition is polled
+        while(! fits(bytes))
+            cv_.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    ++running_;
+    reserved_ += bytes;
+}
+
+void
+MemoryGovernor::
+release(std::size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+        reserved_ -= bytes;
+    }
+    cv_.notify_all();
+}
+
+std::size_t
+MemoryGovernor::
+waits() noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waits_;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,82 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_MEMORYGOVERNOR_HPP
+#define MRDOX_TOOL_TOOL_MEMORYGOVERNOR_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+/** Admits translation units while their memory fits a budget.
+
+    Each translation unit is admitted with an
+    estimate of the memory it needs. A new one
+    is only admitted when the memory held before
+    extraction started, plus the estimates of the
+    running ones and its own, fits the budget,
+    and the resident size is still below the
+    budget. One translation unit is always
+    admitted, so that extraction progresses.
+    Light translation units have small estimates,
+    so as many run as there are threads.
+
+    @par Thread Safety
+    May be called concurrently.
+*/
+class MemoryGovernor
+{
+    std::size_t budget_;
+    std::size_t baseline_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::size_t running_ = 0;
+    std::size_t reserved_ = 0;
+    std::size_t waits_ = 0;
+
+    bool fits(std::size_t bytes) const noexcept;
+
+public:
+    /** Constructor.
+
+        @param budget The most memory the
+        process should use, in bytes.
+    */
+    explicit
+    MemoryGovernor(
+        std::size_t budget) noexcept;
+
+    /** Block until a translation unit may run.
+
+        @param bytes The estimated memory.
+    */
+    void
+    acquire(std::size_t bytes);
+
+    /** Release the memory of a translation unit which finished.
+
+        @param bytes The estimate given to @ref acquire.
+    */
+    void
+    release(std::size_t bytes);
+
+    /** Return the number of translation units which waited.
+    */
+    std::size_t
+    waits() noexcept;
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,285 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "-adoc/AdocCorpus.hpp"
+#include "-adoc/Builder.hpp"
+#include "-XML/XMLTags.hpp"
+#include "AST/Bitcode.hpp"
+#include "Metadata/Reduce.hpp"
+#include "Support/Radix.hpp"
+#include <mrdox/Corpus.hpp>
+#include <mrdox/Metadata/DomMetadata.hpp>
+#include <mrdox/Support/Dom.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+// Results are added here so that
+// the work is not optimized away.
+std::size_t volatile sink = 0;
+
+/** Report the fastest of several runs, per operation.
+
+    The setup is not measured. Its result is
+    passed to the body, which is measured.
+*/
+template<class Setup, class Body>
+void
+measure(
+    std::string_view name,
+    std::size_t ops,
+    unsigned iterations,
+    Setup const& setup,
+    Body const& body)
+{
+    using clock_type = std::chrono::steady_clock;
+
+    if(ops == 0)
+        return;
+    double best = std::numeric_limits<double>::max();
+    for(unsigned i = 0; i < iterations; ++i)
+    {
+        auto state = setup();
+        auto const start = clock_type::now();
+        sink = sink + body(state);
+        std::chrono::duration<double> const elapsed =
+            clock_type::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    best = std::max(best, 1e-9);
+    reportInfo("{:<28} {:>12.1f} ns/op {:>14.0f} ops/s",
+        name, best * 1e9 / ops, ops / best);
+}
+
+template<class Body>
+void
+measure(
+    std::string_view name,
+    std::size_t ops,
+    unsigned iterations,
+    Body const& body)
+{
+    measure(name, ops, iterations,
+        []{ return 0; },
+        [&](int) { return body(); });
+}
+
+} // (anon)
+
+/** Measure the hot support components on a corpus.
+
+    Each component runs on its own, so the
+    numbers can be compared between commits.
+*/
+Error
+runMicroBenchmarks(
+    Corpus const& corpus,
+    unsigned iterations)
+{
+    auto const& index = corpus.index();
+
+    // bitcode round-trips
+    std::vector<Bitcode> bitcodes;
+    for(Info const* I : index)
+        bitcodes.emplace_back(writeBitcode(*I));
+    measure("writeBitcode", index.size(), iterations,
+        [&]
+        {
+            std::size_t n = 0;
+            for(Info const* I : index)
+                n += writeBitcode(*I).data.size();
+            return n;
+        });
+    measure("readBitcode", bitcodes.size(), iterations,
+        [&]
+        {
+            std::size_t n = 0;
+            for(auto const& bc : bitcodes)
+                if(auto infos = readBitcode(bc.data))
+                    n += infos->size();
+            return n;
+        });
+
+    // merging the copies of the widest namespace, as
+    // a header seen by every translation unit would be
+    {
+        std::size_t widest = 0;
+        for(std::size_t i = 0; i < index.size(); ++i)
+            if(index[i]->isNamespace() && bitcodes[i].data.size() >
+                    bitcodes[widest].data.size())
+                widest = i;
+        constexpr std::size_t copies = 256;
+        measure("reduceInto wide group", copies, iterations,
+            [&]
+            {
+                std::vector<std::unique_ptr<Info>> infos;
+                for(std::size_t i = 0; i < copies; ++i)
+                    if(auto decoded = readBitcode(bitcodes[widest].data))
+                        for(auto& I : *decoded)
+                            infos.emplace_back(std::move(I));
+                return infos;
+            },
+            [&](std::vector<std::unique_ptr<Info>>& infos)
+            {
+                std::unique_ptr<Info> merged;
+                for(auto& I : infos)
+                    reduceInto(merged, *I);
+                if(merged)
+                    canonicalize(*merged);
+                return infos.size();
+            });
+    }
+
+    // object lookups, by every key in turn
+    {
+        constexpr std::size_t keys = 64;
+        constexpr std::size_t rounds = 1000;
+        dom::Object obj;
+        std::vector<std::string> names;
+        for(std::size_t i = 0; i < keys; ++i)
+        {
+            names.push_back("key" + std::to_string(i));
+            obj.set(names.back(), static_cast<std::int64_t>(i));
+        }
+        measure("dom::Object::find", keys * rounds, iterations,
+            [&]
+            {
+                std::size_t n = 0;
+                for(std::size_t r = 0; r < rounds; ++r)
+                    for(auto const& key : names)
+                        n += obj.find(key).isInteger();
+                return n;
+            });
+    }
+
+    // every symbol from a new Dom corpus
+    measure("DomCorpus::get", index.size(), iterations,
+        [&]
+        {
+            return std::make_unique<DomCorpus>(corpus);
+        },
+        [&](std::unique_ptr<DomCorpus>& domCorpus)
+        {
+            std::size_t n = 0;
+            for(Info const* I : index)
+                n += domCorpus->get(I->id).size();
+            return n;
+        });
+
+    // text which needs an escape now and then
+    {
+        std::string text;
+        while(text.size() < (1 << 16))
+            text += "template<class T> bool f(T const& t) && "
+                "\"quoted\" 'text' without anything to escape. ";
+        measure("xmlEscape (per byte)", text.size(), iterations,
+            [&]
+            {
+                std::string out;
+                llvm::raw_string_ostream os(out);
+                os << xml::xmlEscape(text);
+                os.flush();
+                return out.size();
+            });
+    }
+
+    // the encoders of symbol IDs
+    measure("toBase16", index.size(), iterations,
+        [&]
+        {
+            std::size_t n = 0;
+            char hex[40];
+            for(Info const* I : index)
+                n += toBase16(hex, I->id).size();
+            return n;
+        });
+    measure("toBase64", index.size(), iterations,
+        [&]
+        {
+            std::size_t n = 0;
+            char b64[28];
+            for(Info const* I : index)
+                n += toBase64(b64, I->id).size();
+            return n;
+        });
+
+    // sorting the names of every symbol
+    {
+        std::vector<std::string_view> names;
+        for(Info const* I : index)
+            names.push_back(I->Name);
+        measure("compareSymbolNames sort", names.size(), iterations,
+            [&]
+            {
+                return names;
+            },
+            [&](std::vector<std::string_view>& v)
+            {
+                std::sort(v.begin(), v.end(),
+                    [](std::string_view a, std::string_view b)
+                    {
+                        return compareSymbolNames(a, b) < 0;
+                    });
+                return v.size();
+            });
+    }
+
+    // rendering the page of each record
+    {
+        auto options = adoc::loadOptions(corpus);
+        if(! options)
+            return options.error();
+        adoc::AdocCorpus domCorpus(corpus);
+        std::vector<SymbolID> records;
+        for(Info const* I : index)
+            if(I->isRecord())
+                records.push_back(I->id);
+        try
+        {
+            auto addons = std::make_shared<adoc::AddonCache>(
+                corpus.config, *options);
+            adoc::Builder builder(domCorpus, *options, addons);
+            measure("Builder::callTemplate", records.size(), iterations,
+                [&]
+                {
+                    std::size_t n = 0;
+                    std::string text;
+                    for(auto const& id : records)
+                    {
+                        text.clear();
+                        llvm::raw_string_ostream os(text);
+                        builder.callTemplate(os, "single-symbol.adoc.hbs",
+                            builder.createContext(id)).maybeThrow();
+                        os.flush();
+                        n += text.size();
+                    }
+                    return n;
+                });
+        }
+        catch(Exception const& ex)
+        {
+            return ex.error();
+        }
+    }
+    return Error::success();
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,489 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "ModuleCache.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Path.hpp>
+#include <clang/Basic/LangOptions.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Lex/Lexer.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <algorithm>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+/** A translation unit which declares a module.
+*/
+struct Unit
+{
+    tooling::CompileCommand cmd;
+    std::string file;
+    std::string contents;
+    std::vector<std::string> imports;
+    std::string key;
+};
+
+/** An interface to build.
+*/
+struct Job
+{
+    std::string name;
+    std::string file;
+    std::string output;
+    tooling::CompileCommand cmd;
+};
+
+/** A compilation database holding one command.
+*/
+class OneCommandDB
+    : public tooling::CompilationDatabase
+{
+    tooling::CompileCommand cc_;
+
+public:
+    explicit
+    OneCommandDB(
+        tooling::CompileCommand cc)
+        : cc_(std::move(cc))
+    {
+    }
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override
+    {
+        if(! FilePath.equals(cc_.Filename))
+            return {};
+        return { cc_ };
+    }
+
+    std::vector<std::string>
+    getAllFiles() const override
+    {
+        return { cc_.Filename };
+    }
+};
+
+/** Generate a module interface to a known path.
+*/
+class GenerateInterface
+    : public GenerateModuleInterfaceAction
+{
+    std::string output_;
+
+public:
+    explicit
+    GenerateInterface(
+        std::string output)
+        : output_(std::move(output))
+    {
+    }
+
+protected:
+    bool
+    BeginInvocation(
+        CompilerInstance& CI) override
+    {
+        CI.getFrontendOpts().OutputFile = output_;
+        CI.getFrontendOpts().ProgramAction =
+            frontend::GenerateModuleInterface;
+        return GenerateModuleInterfaceAction::BeginInvocation(CI);
+    }
+};
+
+class GenerateInterfaceFactory
+    : public tooling::FrontendActionFactory
+{
+    std::string output_;
+
+public:
+    explicit
+    GenerateInterfaceFactory(
+        std::string output)
+        : output_(std::move(output))
+    {
+    }
+
+    std::unique_ptr<FrontendAction>
+    create() override
+    {
+        return std::make_unique<GenerateInterface>(output_);
+    }
+};
+
+/** Return true if a translation unit may declare a module.
+*/
+bool
+isModuleCandidate(
+    tooling::CompileCommand const& cmd)
+{
+    llvm::StringRef ext = llvm::sys::path::extension(cmd.Filename);
+    if(ext.equals_insensitive(".cppm") ||
+        ext.equals_insensitive(".ccm") ||
+        ext.equals_insensitive(".cxxm") ||
+        ext.equals_insensitive(".c++m") ||
+        ext.equals_insensitive(".ixx") ||
+        ext.equals_insensitive(".mpp"))
+        return true;
+    for(llvm::StringRef arg : cmd.CommandLine)
+        if(arg.ends_with("c++-module") ||
+            arg.starts_with("-fmodule-output") ||
+            arg == "--precompile")
+            return true;
+    return false;
+}
+
+/** Return the module declared by a source, and the modules it imports.
+
+    Only the top level declarations are looked
+    at, and preprocessor directives are skipped,
+    so a module declaration which depends on a
+    macro is not found. Header units are not
+    named modules, and are not imports here.
+*/
+std::string
+scanModule(
+    llvm::StringRef text,
+    std::vector<std::string>& imports)
+{
+    LangOptions LO;
+    LO.CPlusPlus = true;
+    LO.CPlusPlus20 = true;
+    Lexer L(SourceLocation(), LO,
+        text.begin(), text.begin(), text.end());
+
+    Token T;
+    auto const next = [&]
+    {
+        L.LexFromRawLexer(T);
+        // a directive ends at the next line
+        while(T.is(tok::hash) && T.isAtStartOfLine())
+        {
+            do L.LexFromRawLexer(T);
+            while(! T.is(tok::eof) && ! T.isAtStartOfLine());
+        }
+    };
+    auto const isWord = [&](llvm::StringRef word)
+    {
+        return T.is(tok::raw_identifier) &&
+            T.getRawIdentifier() == word;
+    };
+    // a dotted name and an optional partition
+    auto const lexName = [&]
+    {
+        std::string name;
+        for(;;)
+        {
+            if(T.is(tok::raw_identifier))
+                name += T.getRawIdentifier();
+            else if(T.is(tok::period) || T.is(tok::colon))
+                name += T.is(tok::colon) ? ':' : '.';
+            else
+                return name;
+            next();
+        }
+    };
+
+    std::string module;
+    std::string primary;
+    unsigned depth = 0;
+    bool atStart = true;
+    next();
+    while(! T.is(tok::eof))
+    {
+        if(T.is(tok::l_brace))
+            ++depth;
+        else if(T.is(tok::r_brace) && depth > 0)
+            --depth;
+        if(depth != 0 || ! atStart)
+        {
+            atStart = T.isOneOf(tok::semi, tok::l_brace, tok::r_brace);
+            next();
+            continue;
+        }
+        bool exported = false;
+        if(isWord("export"))
+        {
+            exported = true;
+            next();
+            if(! isWord("module") && ! isWord("import"))
+            {
+                // an exported declaration or block
+                atStart = false;
+                continue;
+            }
+        }
+        if(isWord("module"))
+        {
+            next();
+            // the global module fragment has no name
+            std::string name = lexName();
+            if(! name.empty() && name != ":private")
+            {
+                auto const colon = name.find(':');
+                primary = name.substr(0, colon);
+                if(exported || colon != std::string::npos)
+                    module = std::move(name);
+                else
+                    imports.push_back(std::move(name));
+            }
+        }
+        else if(isWord("import"))
+        {
+            next();
+            std::string name = lexName();
+            if(name.starts_with(':'))
+                name.insert(0, primary);
+            if(! name.empty() && name.front() != ':')
+                imports.push_back(std::move(name));
+        }
+        atStart = T.isOneOf(tok::semi, tok::l_brace, tok::r_brace);
+        if(! T.is(tok::eof))
+            next();
+    }
+    return module;
+}
+
+} // (anon)
+
+//------------------------------------------------
+
+ModuleCache::
+ModuleCache(
+    std::string_view dir)
+{
+    if(! dir.empty())
+        dir_ = files::appendPath(dir, "modules");
+}
+
+ModuleCache::
+~ModuleCache()
+{
+    if(ownsDir_)
+        llvm::sys::fs::remove_directories(dir_);
+}
+
+void
+ModuleCache::
+build(
+    tooling::CompilationDatabase const& db,
+    std::vector<std::string> const& files,
+    tooling::ArgumentsAdjuster const& adjuster,
+    ThreadPool& threadPool,
+    bool verbose)
+{
+    llvm::StringMap<Unit> units;
+    for(auto const& file : files)
+    {
+        auto commands = db.getCompileCommands(file);
+        if(commands.size() != 1 ||
+            ! isModuleCandidate(commands.front()))
+            continue;
+        auto buf = llvm::MemoryBuffer::getFile(file);
+        if(! buf)
+            continue;
+        Unit unit;
+        std::string name = scanModule(
+            (*buf)->getBuffer(), unit.imports);
+        if(name.empty())
+            continue;
+        unit.cmd = std::move(commands.front());
+        if(adjuster)
+            unit.cmd.CommandLine = adjuster(
+                unit.cmd.CommandLine, unit.cmd.Filename);
+        // the main file itself is not a flag
+        std::erase(unit.cmd.CommandLine, unit.cmd.Filename);
+        std::erase(unit.cmd.CommandLine, file);
+        unit.file = file;
+        unit.contents = (*buf)->getBuffer().str();
+        auto [it, inserted] = units.try_emplace(name, std::move(unit));
+        if(! inserted)
+            reportWarning("Module \"{}\" is declared by \"{}\" and \"{}\"",
+                name, it->second.file, file);
+    }
+    if(units.empty())
+        return;
+
+    // the directory is only made for a run
+    // which has modules
+    if(! dir_.empty())
+    {
+        if(auto ec = llvm::sys::fs::create_directories(dir_))
+        {
+            reportWarning("Could not create directory \"{}\": {}",
+                dir_, ec.message());
+            return;
+        }
+    }
+    else
+    {
+        llvm::SmallString<128> temp;
+        if(auto ec = llvm::sys::fs::createUniqueDirectory(
+            "mrdox-modules", temp))
+        {
+            reportWarning("Could not create a temporary directory: {}",
+                ec.message());
+            return;
+        }
+        dir_ = std::string(temp.str());
+        ownsDir_ = true;
+    }
+
+    // Imports of modules which are not part
+    // of the run are left to the compiler.
+    for(auto& kv : units)
+        std::erase_if(kv.second.imports,
+            [&](std::string const& name)
+            {
+                return ! units.contains(name);
+            });
+
+    // Build the interfaces in waves, each after
+    // the interfaces of the modules it imports.
+    std::mutex mutex;
+    std::size_t reused = 0;
+    llvm::StringSet<> pending;
+    for(auto& kv : units)
+        pending.insert(kv.first());
+    while(! pending.empty())
+    {
+        std::vector<std::string> wave;
+        for(auto const& kv : pending)
+        {
+            auto const& unit = units.find(kv.first())->second;
+            if(std::none_of(unit.imports.begin(), unit.imports.end(),
+                [&](std::string const& name)
+                {
+                    return pending.contains(name);
+                }))
+                wave.push_back(kv.first().str());
+        }
+        if(wave.empty())
+        {
+            for(auto const& kv : pending)
+                reportWarning("Module \"{}\" is part of an import cycle",
+                    kv.first());
+            break;
+        }
+
+        // the interfaces of the earlier waves, which
+        // the compiler may need for indirect imports
+        std::vector<std::string> built = flags({});
+        std::vector<Job> jobs;
+        for(auto const& name : wave)
+        {
+            pending.erase(name);
+            Unit& unit = units.find(name)->second;
+            if(std::any_of(unit.imports.begin(), unit.imports.end(),
+                [&](std::string const& dep)
+                {
+                    return ! modules_.contains(dep);
+                }))
+            {
+                reportWarning("Module \"{}\" is not built, "
+                    "because a module it imports is not", name);
+                continue;
+            }
+            tooling::CompileCommand cc = unit.cmd;
+            llvm::SHA1 H;
+            H.update(cc.Directory);
+            for(auto const& arg : cc.CommandLine)
+            {
+                H.update(arg);
+                H.update(llvm::StringRef("\0", 1));
+            }
+            H.update(unit.contents);
+            for(auto const& dep : unit.imports)
+                H.update(units.find(dep)->second.key);
+            unit.key = llvm::toHex(H.final(), true);
+            auto output = files::appendPath(dir_, unit.key + ".pcm");
+            if(! ownsDir_ && llvm::sys::fs::exists(output))
+            {
+                modules_[name] = { unit.file, std::move(output) };
+                ++reused;
+                continue;
+            }
+            cc.CommandLine.insert(cc.CommandLine.end(),
+                built.begin(), built.end());
+            cc.CommandLine.emplace_back("-xc++-module");
+            cc.CommandLine.emplace_back(unit.file);
+            jobs.push_back({ name, unit.file,
+                std::move(output), std::move(cc) });
+        }
+
+        TaskGroup taskGroup(threadPool);
+        for(auto& job : jobs)
+        {
+            taskGroup.async(
+            [&]()
+            {
+                auto const temp = job.output + ".tmp";
+                OneCommandDB moduleDB(std::move(job.cmd));
+                tooling::ClangTool Tool(moduleDB, { job.file });
+                // a partial interface must not be reused
+                GenerateInterfaceFactory factory(temp);
+                if(Tool.run(&factory) != 0 ||
+                    llvm::sys::fs::rename(temp, job.output))
+                {
+                    llvm::sys::fs::remove(temp);
+                    reportWarning("Could not build module \"{}\" from \"{}\"",
+                        job.name, job.file);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                modules_[job.name] = { job.file, job.output };
+            });
+        }
+        auto errors = taskGroup.wait();
+        if(! errors.empty())
+            reportError(errors, "build module interfaces");
+    }
+    if(verbose)
+        reportInfo("Built {} and reused {} of {} module interfaces",
+            modules_.size() - reused, reused, units.size());
+}
+
+std::vector<std::string>
+ModuleCache::
+flags(
+    llvm::StringRef file) const
+{
+    std::vector<std::string> result;
+    for(auto const& kv : modules_)
+        if(kv.second.file != file)
+            result.push_back("-fmodule-file=" +
+                kv.first().str() + "=" + kv.second.bmi);
+    // the same command line for every run
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+llvm::StringSet<>
+ModuleCache::
+interfaces() const
+{
+    llvm::StringSet<> result;
+    for(auto const& kv : modules_)
+        result.insert(kv.first());
+    return result;
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,101 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_MODULECACHE_HPP
+#define MRDOX_TOOL_TOOL_MODULECACHE_HPP
+
+#include <mrdox/Support/ThreadPool.hpp>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Built module interfaces for the named modules of a run.
+
+    The translation units which declare a named
+    module or a partition, `export module name;`
+    or `module name:part;`, are found by scanning
+    the sources with the usual module extensions,
+    or compiled as `c++-module`. The interface of
+    every module is built once, after the modules
+    it imports, and reused by every importer.
+
+    When the directory is the cache directory,
+    the interfaces are kept between runs, keyed
+    on the command, the source, and the keys of
+    the imported modules.
+*/
+class ModuleCache
+{
+    struct Module
+    {
+        std::string file;
+        std::string bmi;
+    };
+
+    std::string dir_;
+    bool ownsDir_ = false;
+    llvm::StringMap<Module> modules_;
+
+public:
+    /** Constructor.
+
+        @param dir The directory to hold the
+        module interfaces. When empty, a temporary
+        directory is used and removed on destruction.
+    */
+    explicit
+    ModuleCache(
+        std::string_view dir);
+
+    ~ModuleCache();
+
+    /** Build the module interfaces declared by a set of files.
+
+        A module whose interface could not be
+        built, or which imports a module that
+        could not, is reported and left out.
+
+        @param adjuster The arguments adjuster which
+        is applied to the compile commands first.
+    */
+    void
+    build(
+        tooling::CompilationDatabase const& db,
+        std::vector<std::string> const& files,
+        tooling::ArgumentsAdjuster const& adjuster,
+        ThreadPool& threadPool,
+        bool verbose);
+
+    /** Return the flags which make the interfaces visible to a file.
+
+        The interface built from the file
+        itself is not included.
+    */
+    std::vector<std::string>
+    flags(
+        llvm::StringRef file) const;
+
+    /** Return the names of the modules which were built.
+    */
+    llvm::StringSet<>
+    interfaces() const;
+};
+
+} // mrdox
+} // clang
+
+#endif
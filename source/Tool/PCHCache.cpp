@@ -0,0 +1,288 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "PCHCache.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Path.hpp>
+#include <clang/Basic/LangOptions.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Lex/Lexer.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+/** A group of translation units sharing a preamble.
+*/
+struct Group
+{
+    tooling::CompileCommand cmd;
+    std::string preamble;
+    std::vector<std::string> files;
+};
+
+/** A compilation database holding one command.
+*/
+class OneCommandDB
+    : public tooling::CompilationDatabase
+{
+    tooling::CompileCommand cc_;
+
+public:
+    explicit
+    OneCommandDB(
+        tooling::CompileCommand cc)
+        : cc_(std::move(cc))
+    {
+    }
+
+    std::vector<tooling::CompileCommand>
+    getCompileCommands(
+        llvm::StringRef FilePath) const override
+    {
+        if(! FilePath.equals(cc_.Filename))
+            return {};
+        return { cc_ };
+    }
+
+    std::vector<std::string>
+    getAllFiles() const override
+    {
+        return { cc_.Filename };
+    }
+};
+
+/** Generate a precompiled header to a known path.
+*/
+class GeneratePCH
+    : public GeneratePCHAction
+{
+    std::string output_;
+
+public:
+    explicit
+    GeneratePCH(
+        std::string output)
+        : output_(std::move(output))
+    {
+    }
+
+protected:
+    bool
+    BeginInvocation(
+        CompilerInstance& CI) override
+    {
+        CI.getFrontendOpts().OutputFile = output_;
+        CI.getFrontendOpts().ProgramAction = frontend::GeneratePCH;
+        return GeneratePCHAction::BeginInvocation(CI);
+    }
+};
+
+class GeneratePCHFactory
+    : public tooling::FrontendActionFactory
+{
+    std::string output_;
+
+public:
+    explicit
+    GeneratePCHFactory(
+        std::string output)
+        : output_(std::move(output))
+    {
+    }
+
+    std::unique_ptr<FrontendAction>
+    create() override
+    {
+        return std::make_unique<GeneratePCH>(output_);
+    }
+};
+
+/** Return the preamble of a source file.
+*/
+std::string
+getPreamble(
+    llvm::StringRef file)
+{
+    auto buf = llvm::MemoryBuffer::getFile(file);
+    if(! buf)
+        return {};
+    LangOptions LO;
+    LO.CPlusPlus = true;
+    auto bounds = Lexer::ComputePreamble(
+        (*buf)->getBuffer(), LO);
+    return (*buf)->getBuffer().take_front(bounds.Size).str();
+}
+
+} // (anon)
+
+//------------------------------------------------
+
+PCHCache::
+PCHCache(
+    std::string_view dir)
+{
+    if(! dir.empty())
+    {
+        dir_ = files::appendPath(dir, "pch");
+        if(auto ec = llvm::sys::fs::create_directories(dir_))
+        {
+            reportWarning("Could not create directory \"{}\": {}",
+                dir_, ec.message());
+            dir_.clear();
+        }
+        return;
+    }
+    llvm::SmallString<128> temp;
+    if(auto ec = llvm::sys::fs::createUniqueDirectory("mrdox-pch", temp))
+    {
+        reportWarning("Could not create a temporary directory: {}",
+            ec.message());
+        return;
+    }
+    dir_ = std::string(temp.str());
+    ownsDir_ = true;
+}
+
+PCHCache::
+~PCHCache()
+{
+    if(ownsDir_)
+        llvm::sys::fs::remove_directories(dir_);
+}
+
+void
+PCHCache::
+build(
+    tooling::CompilationDatabase const& db,
+    std::vector<std::string> const& files,
+    tooling::ArgumentsAdjuster const& adjuster,
+    ThreadPool& threadPool,
+    bool verbose)
+{
+    if(dir_.empty())
+        return;
+
+    // Group the translation units on everything
+    // which affects the meaning of the preamble.
+    llvm::StringMap<Group> groups;
+    for(auto const& file : files)
+    {
+        auto commands = db.getCompileCommands(file);
+        if(commands.size() != 1)
+            continue;
+        auto cmd = std::move(commands.front());
+        if(adjuster)
+            cmd.CommandLine = adjuster(cmd.CommandLine, cmd.Filename);
+        std::string preamble = getPreamble(file);
+        if(preamble.empty())
+            continue;
+
+        // the main file itself is not a flag
+        std::erase(cmd.CommandLine, cmd.Filename);
+        std::erase(cmd.CommandLine, file);
+        std::string parentDir = files::getParentDir(file);
+
+        llvm::SHA1 H;
+        H.update(cmd.Directory);
+        H.update(parentDir);
+        for(auto const& arg : cmd.CommandLine)
+        {
+            H.update(arg);
+            H.update(llvm::StringRef("\0", 1));
+        }
+        H.update(preamble);
+        auto key = llvm::toHex(H.final(), true);
+
+        auto& group = groups[key];
+        if(group.files.empty())
+        {
+            group.cmd = std::move(cmd);
+            group.preamble = std::move(preamble);
+        }
+        group.files.push_back(file);
+    }
+
+    // Build one precompiled header per shared preamble
+    std::mutex mutex;
+    std::size_t built = 0;
+    std::size_t covered = 0;
+    TaskGroup taskGroup(threadPool);
+    for(auto& kv : groups)
+    {
+        if(kv.second.files.size() < 2)
+            continue;
+        taskGroup.async(
+        [&, key = kv.first().str(), &group = kv.second]()
+        {
+            auto header = files::appendPath(dir_, key + ".hpp");
+            auto output = files::appendPath(dir_, key + ".pch");
+            {
+                std::error_code ec;
+                llvm::raw_fd_ostream os(header, ec);
+                if(ec)
+                    return;
+                os << group.preamble;
+            }
+
+            // quoted includes are resolved
+            // against the directory of the TU
+            tooling::CompileCommand cc = group.cmd;
+            cc.Filename = header;
+            cc.CommandLine.emplace_back("-xc++-header");
+            cc.CommandLine.emplace_back("-iquote");
+            cc.CommandLine.emplace_back(
+                files::getParentDir(group.files.front()));
+            cc.CommandLine.emplace_back(header);
+
+            OneCommandDB pchDB(std::move(cc));
+            tooling::ClangTool Tool(pchDB, { header });
+            GeneratePCHFactory factory(output);
+            if(Tool.run(&factory) != 0)
+                return;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto const& file : group.files)
+                pch_[file] = output;
+            ++built;
+            covered += group.files.size();
+        });
+    }
+    auto errors = taskGroup.wait();
+    if(! errors.empty())
+        reportError(errors, "build precompiled headers");
+    if(verbose)
+        reportInfo("Built {} precompiled headers for {} of {} translation units",
+            built, covered, files.size());
+}
+
+std::string_view
+PCHCache::
+find(
+    llvm::StringRef file) const noexcept
+{
+    auto it = pch_.find(file);
+    if(it == pch_.end())
+        return {};
+    return it->second;
+}
+
+} // mrdox
+} // clang
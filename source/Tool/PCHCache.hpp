@@ -0,0 +1,82 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_PCHCACHE_HPP
+#define MRDOX_TOOL_TOOL_PCHCACHE_HPP
+
+#include <mrdox/Support/ThreadPool.hpp>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringMap.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** Precompiled headers for translation units sharing a preamble.
+
+    The preamble of a translation unit is the
+    leading block of preprocessor directives and
+    comments. Translation units with the same
+    preamble, compile flags, and directory are
+    grouped, and a precompiled header is built
+    once for every group with more than one
+    member.
+*/
+class PCHCache
+{
+    std::string dir_;
+    bool ownsDir_ = false;
+    llvm::StringMap<std::string> pch_;
+
+public:
+    /** Constructor.
+
+        @param dir The directory to hold the
+        precompiled headers. When empty, a
+        temporary directory is used and removed
+        on destruction.
+    */
+    explicit
+    PCHCache(
+        std::string_view dir);
+
+    ~PCHCache();
+
+    /** Build the precompiled headers for a set of files.
+
+        Translation units for which no precompiled
+        header could be built are parsed normally.
+
+        @param adjuster The arguments adjuster which
+        is applied to the compile commands before
+        they are compared.
+    */
+    void
+    build(
+        tooling::CompilationDatabase const& db,
+        std::vector<std::string> const& files,
+        tooling::ArgumentsAdjuster const& adjuster,
+        ThreadPool& threadPool,
+        bool verbose);
+
+    /** Return the precompiled header for a file, or an empty string.
+    */
+    std::string_view
+    find(
+        llvm::StringRef file) const noexcept;
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -19,15 +19,15 @@
 namespace clang {
 namespace mrdox {
 
-/** Compilation database for a single .cpp file.
+/** Compilation database for the .cpp files of a test case.
 */
 class SingleFileDB
     : public tooling::CompilationDatabase
 {
     std::vector<tooling::CompileCommand> cc_;
 
-public:
-    SingleFileDB(
+    void
+    add(
         llvm::StringRef dir,
         llvm::StringRef file)
     {
@@ -45,25 +45,50 @@ public:
         cc_.back().Heuristic = "unit test";
     }
 
+public:
+    SingleFileDB(
+        llvm::StringRef dir,
+        llvm::StringRef file)
+    {
+        add(dir, file);
+    }
+
+    /** Constructor.
+
+        Each file is a translation unit of
+        the same corpus.
+    */
+    SingleFileDB(
+        llvm::StringRef dir,
+        std::vector<std::string> const& files)
+    {
+        for(auto const& file : files)
+            add(dir, file);
+    }
+
     std::vector<tooling::CompileCommand>
     getCompileCommands(
         llvm::StringRef FilePath) const override
     {
-        if(! FilePath.equals(cc_.front().Filename))
-            return {};
-        return { cc_.front() };
+        for(auto const& cc : cc_)
+            if(FilePath.equals(cc.Filename))
+                return { cc };
+        return {};
     }
 
     std::vector<std::string>
     getAllFiles() const override
     {
-        return { cc_.front().Filename };
+        std::vector<std::string> files;
+        for(auto const& cc : cc_)
+            files.push_back(cc.Filename);
+        return files;
     }
 
     std::vector<tooling::CompileCommand>
     getAllCompileCommands() const override
     {
-        return { cc_.front() };
+        return cc_;
     }
 };
 
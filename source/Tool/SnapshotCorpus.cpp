@@ -0,0 +1,332 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "SnapshotCorpus.hpp"
+#include "AST/Bitcode.hpp"
+#include "Support/Radix.hpp"
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/ThreadPool.hpp>
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+namespace clang {
+namespace mrdox {
+
+SnapshotCorpus::
+SnapshotCorpus(
+    std::shared_ptr<ConfigImpl const> config,
+    std::unique_ptr<llvm::MemoryBuffer> buffer,
+    Snapshot snapshot)
+    : Corpus(*config)
+    , config_(std::move(config))
+    , buffer_(std::move(buffer))
+    , slots_(std::make_unique<Slot[]>(snapshot.symbols.size()))
+    , size_(snapshot.symbols.size())
+{
+    auto& symbols = snapshot.symbols;
+    std::sort(symbols.begin(), symbols.end(),
+        [](auto const& a, auto const& b)
+        {
+            return a.first < b.first;
+        });
+    for(std::size_t i = 0; i < size_; ++i)
+    {
+        slots_[i].id = symbols[i].first;
+        slots_[i].bitcode = symbols[i].second;
+    }
+}
+
+mrdox::Expected<std::unique_ptr<Corpus>>
+SnapshotCorpus::
+load(
+    std::string_view path,
+    std::shared_ptr<Config const> config_)
+{
+    auto config = std::dynamic_pointer_cast<ConfigImpl const>(config_);
+
+    // the file stays mapped for the
+    // lifetime of the corpus
+    auto buf = llvm::MemoryBuffer::getFile(path,
+        /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if(! buf)
+        return formatError("getFile(\"{}\") returned \"{}\"",
+            path, buf.getError().message());
+
+    Snapshot snapshot;
+    if(auto err = parseSnapshot(path, (*buf)->getBuffer(), snapshot))
+        return err;
+    if(config->verboseOutput)
+        reportInfo("Opened {} symbols in snapshot", snapshot.symbols.size());
+    auto corpus = std::make_unique<SnapshotCorpus>(
+        config, std::move(*buf), std::move(snapshot));
+    if(! corpus->find(SymbolID::zero))
+        return formatError("corpus snapshot \"{}\" has no global namespace", path);
+    return corpus;
+}
+
+//------------------------------------------------
+
+Info const*
+SnapshotCorpus::
+decode(
+    Slot& slot) const noexcept
+{
+    if(Info const* I = slot.I.load(std::memory_order_acquire))
+        return I;
+    if(slot.failed.load(std::memory_order_relaxed))
+        return nullptr;
+
+    // decode outside the lock; if another
+    // thread got there first, its Info is kept
+    thread_local BitcodeDecoder decoder;
+    auto infos = decoder.read(slot.bitcode);
+    if(! infos)
+    {
+        if(! slot.failed.exchange(true))
+            reportError(infos.error(), "read bitcode");
+        return nullptr;
+    }
+    if(infos->size() != 1 || infos->front()->id != slot.id)
+    {
+        if(! slot.failed.exchange(true))
+            reportError("the bitcode of symbol {} is corrupt",
+                toBase16(llvm::StringRef(slot.id)));
+        return nullptr;
+    }
+
+    auto& shard = shards_[shardIndex(slot.id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if(Info const* I = slot.I.load(std::memory_order_relaxed))
+        return I;
+    Info* I = shard.arena.adopt(std::move(infos->front()));
+    CorpusImpl::buildPools(*I);
+    slot.I.store(I, std::memory_order_release);
+    return I;
+}
+
+CorpusImpl const&
+SnapshotCorpus::
+materialize() const noexcept
+{
+    std::call_once(once_,
+        [&]
+        {
+            // This can be called from a task on the thread
+            // pool of the configuration, which would wait on
+            // itself, so the work runs on a pool of its own.
+            ThreadPool pool(config_->threadPool().getThreadCount());
+            auto corpus = std::make_unique<CorpusImpl>(config_);
+            corpus->pool_ = &pool;
+            corpus->borrowed_ = true;
+            auto errors = pool.forEach(
+                std::span<Slot>(slots_.get(), size_),
+                [&](Slot& slot)
+                {
+                    if(Info const* I = decode(slot))
+                        corpus->insertBorrowed(const_cast<Info&>(*I));
+                });
+            for(auto const& err : errors)
+                reportError(err, "decode the snapshot");
+            if(auto err = corpus->finalize())
+                reportError(err, "finalize the snapshot");
+            corpus->pool_ = nullptr;
+            corpus_ = std::move(corpus);
+            ready_.store(true, std::memory_order_release);
+        });
+    return *corpus_;
+}
+
+//------------------------------------------------
+
+std::vector<Info const*> const&
+SnapshotCorpus::
+index() const noexcept
+{
+    return materialize().index();
+}
+
+SymbolHeaders const&
+SnapshotCorpus::
+headers() const noexcept
+{
+    return materialize().headers();
+}
+
+Info const*
+SnapshotCorpus::
+find(
+    SymbolID const& id) const noexcept
+{
+    Slot* const first = slots_.get();
+    Slot* const last = first + size_;
+    Slot* it = std::lower_bound(first, last, id,
+        [](Slot const& slot, SymbolID const& id)
+        {
+            return slot.id < id;
+        });
+    if(it == last || it->id != id)
+        return nullptr;
+    return decode(*it);
+}
+
+std::uint32_t
+SnapshotCorpus::
+indexOf(
+    SymbolID const& id) const noexcept
+{
+    // until every symbol is decoded, the
+    // traversals follow the member lists
+    if(! ready_.load(std::memory_order_acquire))
+        return SymbolHeaders::npos;
+    return corpus_->indexOf(id);
+}
+
+References const&
+SnapshotCorpus::
+references(
+    SymbolID const& id) const noexcept
+{
+    return materialize().references(id);
+}
+
+std::string_view
+SnapshotCorpus::
+qualifiedName(
+    Info const& I) const noexcept
+{
+    auto& shard = shards_[shardIndex(I.id)];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.names.find(&I);
+        if(it != shard.names.end())
+            return it->second;
+    }
+    // the parents are decoded through
+    // this corpus, so build outside the lock
+    std::string temp;
+    CorpusImpl::buildQualifiedName(*this, I, temp);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.names.try_emplace(&I);
+    if(inserted && ! temp.empty())
+    {
+        char* p = shard.nameAlloc.Allocate<char>(temp.size());
+        std::memcpy(p, temp.data(), temp.size());
+        it->second = std::string_view(p, temp.size());
+    }
+    return it->second;
+}
+
+std::shared_ptr<Interface const>
+SnapshotCorpus::
+getInterface(
+    RecordInfo const& I) const
+{
+    auto& shard = shards_[shardIndex(I.id)];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.interfaces.find(&I);
+        if(it != shard.interfaces.end())
+            return it->second;
+    }
+    auto sp = std::make_shared<Interface const>(
+        makeInterface(I, *this));
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.interfaces.try_emplace(&I, std::move(sp)).first->second;
+}
+
+std::span<OverloadInfo const>
+SnapshotCorpus::
+overloads(
+    Info const& scope) const noexcept
+{
+    if(! scope.isNamespace() && ! scope.isRecord())
+        return {};
+    auto& shard = shards_[shardIndex(scope.id)];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.overloads.find(&scope);
+        if(it != shard.overloads.end())
+            return it->second.list;
+    }
+    auto overloads = scope.isNamespace()
+        ? makeNamespaceOverloads(
+            static_cast<NamespaceInfo const&>(scope), *this)
+        : makeRecordOverloads(
+            static_cast<RecordInfo const&>(scope), *this);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.overloads.try_emplace(
+        &scope, std::move(overloads)).first->second.list;
+}
+
+MemoryStats
+SnapshotCorpus::
+memoryStats() const
+{
+    auto stats = materialize().memoryStats();
+
+    // the Infos are held by this corpus
+    stats.kinds.clear();
+    for(auto kind : {
+        InfoKind::Namespace, InfoKind::Record,
+        InfoKind::Function, InfoKind::Enum,
+        InfoKind::Typedef, InfoKind::Variable,
+        InfoKind::Field, InfoKind::Specialization })
+    {
+        MemoryStats::Usage total;
+        for(auto const& shard : shards_)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto const u = shard.arena.usage(kind);
+            total.count += u.count;
+            total.bytes += u.bytes;
+        }
+        stats.kinds.emplace_back(kind, total);
+    }
+    return stats;
+}
+
+std::span<Info const* const>
+SnapshotCorpus::
+findByName(
+    std::string_view name) const noexcept
+{
+    return materialize().findByName(name);
+}
+
+std::span<Info const* const>
+SnapshotCorpus::
+findByPrefix(
+    std::string_view prefix) const noexcept
+{
+    return materialize().findByPrefix(prefix);
+}
+
+bool
+SnapshotCorpus::
+isSelected(
+    Info const& I) const noexcept
+{
+    return ! config_->hasSelection() ||
+        materialize().isSelected(I);
+}
+
+bool
+SnapshotCorpus::
+hasSelected(
+    Info const& I) const noexcept
+{
+    return ! config_->hasSelection() ||
+        materialize().hasSelected(I);
+}
+
+} // mrdox
+} // clang
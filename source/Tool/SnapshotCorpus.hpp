@@ -0,0 +1,212 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_SNAPSHOTCORPUS_HPP
+#define MRDOX_TOOL_TOOL_SNAPSHOTCORPUS_HPP
+
+#include "Tool/ConfigImpl.hpp"
+#include "Tool/CorpusImpl.hpp"
+#include "Tool/InfoArena.hpp"
+#include <mrdox/Corpus.hpp>
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** The sections of a snapshot file.
+
+    The sections refer into the buffer
+    which holds the file.
+*/
+struct Snapshot
+{
+    // the ID and the bitcode of each symbol
+    std::vector<std::pair<
+        SymbolID, llvm::StringRef>> symbols;
+
+    // cache key and serialized entry
+    // of each translation unit
+    std::vector<std::pair<
+        llvm::StringRef, llvm::StringRef>> units;
+};
+
+/** Parse the sections of a snapshot file.
+*/
+Error
+parseSnapshot(
+    std::string_view path,
+    llvm::StringRef s,
+    Snapshot& snapshot);
+
+/** A read-only corpus which decodes each symbol on first use.
+
+    The snapshot file stays mapped, and the
+    bitcode of a symbol is decoded the first
+    time it is found, so a generator which only
+    follows @ref find from the global namespace
+    holds the symbols it renders and no others.
+    Qualified names, overload sets and record
+    interfaces are computed per symbol.
+
+    The index, the headers, the references,
+    the lookups by name and the selection need
+    every symbol. The first call to any of them
+    decodes the rest and builds a @ref CorpusImpl
+    over the same Infos. Until then @ref indexOf
+    returns `SymbolHeaders::npos`, so traversals
+    follow the member lists instead.
+*/
+class SnapshotCorpus : public Corpus
+{
+public:
+    /** Constructor.
+
+        @param buffer The contents of the snapshot.
+
+        @param snapshot The sections of the buffer.
+    */
+    SnapshotCorpus(
+        std::shared_ptr<ConfigImpl const> config,
+        std::unique_ptr<llvm::MemoryBuffer> buffer,
+        Snapshot snapshot);
+
+    /** Open a snapshot file without decoding its symbols.
+
+        @param config A shared pointer to the configuration.
+    */
+    [[nodiscard]]
+    static
+    mrdox::Expected<std::unique_ptr<Corpus>>
+    load(
+        std::string_view path,
+        std::shared_ptr<Config const> config);
+
+private:
+    std::vector<Info const*> const&
+    index() const noexcept override;
+
+    SymbolHeaders const&
+    headers() const noexcept override;
+
+    Info const*
+    find(
+        SymbolID const& id) const noexcept override;
+
+    std::uint32_t
+    indexOf(
+        SymbolID const& id) const noexcept override;
+
+    References const&
+    references(
+        SymbolID const& id) const noexcept override;
+
+    std::string_view
+    qualifiedName(
+        Info const& I) const noexcept override;
+
+    std::shared_ptr<Interface const>
+    getInterface(
+        RecordInfo const& I) const override;
+
+    std::span<OverloadInfo const>
+    overloads(
+        Info const& scope) const noexcept override;
+
+    MemoryStats
+    memoryStats() const override;
+
+    std::span<Info const* const>
+    findByName(
+        std::string_view name) const noexcept override;
+
+    std::span<Info const* const>
+    findByPrefix(
+        std::string_view prefix) const noexcept override;
+
+    bool
+    isSelected(
+        Info const& I) const noexcept override;
+
+    bool
+    hasSelected(
+        Info const& I) const noexcept override;
+
+    struct Slot
+    {
+        SymbolID id;
+        llvm::StringRef bitcode;
+        std::atomic<Info const*> I{nullptr};
+        std::atomic<bool> failed{false};
+    };
+
+    /** Return the Info of a slot, decoding it the first time.
+
+        @return nullptr if the bitcode is corrupt.
+    */
+    Info const*
+    decode(
+        Slot& slot) const noexcept;
+
+    /** Return the corpus over every symbol, building it the first time.
+    */
+    CorpusImpl const&
+    materialize() const noexcept;
+
+    static constexpr std::size_t NumShards = 64;
+
+    struct Shard
+    {
+        std::mutex mutable mutex;
+        InfoArena arena;
+        llvm::BumpPtrAllocator nameAlloc;
+        llvm::DenseMap<Info const*, std::string_view> names;
+        llvm::DenseMap<Info const*, NamespaceOverloads> overloads;
+        llvm::DenseMap<Info const*,
+            std::shared_ptr<Interface const>> interfaces;
+    };
+
+    static
+    std::size_t
+    shardIndex(
+        SymbolID const& id) noexcept
+    {
+        return id.data()[0] % NumShards;
+    }
+
+    std::shared_ptr<ConfigImpl const> config_;
+    std::unique_ptr<llvm::MemoryBuffer> buffer_;
+
+    // sorted by symbol ID
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t size_;
+
+    std::array<Shard, NumShards> mutable shards_;
+
+    std::once_flag mutable once_;
+    std::unique_ptr<CorpusImpl> mutable corpus_;
+    std::atomic<bool> mutable ready_{false};
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,86 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "StreamingReducer.hpp"
+#include "AST/Bitcode.hpp"
+#include "Metadata/Reduce.hpp"
+#include <mrdox/Metadata.hpp>
+#include <mrdox/Support/Error.hpp>
+#include <llvm/Support/MathExtras.h>
+
+namespace clang {
+namespace mrdox {
+
+void
+StreamingReducer::
+addResult(
+    StringRef Key,
+    StringRef Value)
+{
+    // decode outside of the lock
+    thread_local BitcodeDecoder decoder;
+    bool ok = forEachBitcode(Value,
+        [&](StringRef, StringRef bitcode)
+        {
+            auto infos = decoder.read(bitcode);
+            if(! infos)
+            {
+                reportError(infos.error(), "read bitcode");
+                failed_ = true;
+                return;
+            }
+
+            // the first byte of a SHA1 is uniform,
+            // so it makes a good shard index
+            for(auto& I : *infos)
+            {
+                Shard& shard = shards_[I->id.data()[0] % NumShards];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto& slot = shard.infos[StringRef(I->id)];
+                if(! reduceInto(slot.I, *I))
+                {
+                    reportError("merge metadata: mismatched info kinds");
+                    failed_ = true;
+                    continue;
+                }
+                // Duplicates pile up until canonicalized. Doing
+                // it after every power of two merges bounds
+                // memory while keeping the total work low.
+                if(llvm::isPowerOf2_64(++slot.merges))
+                    canonicalize(*slot.I);
+            }
+        });
+    if(! ok)
+    {
+        reportError("invalid bitcode batch for \"{}\"",
+            std::string_view(Key));
+        failed_ = true;
+    }
+}
+
+void
+StreamingReducer::
+take(llvm::function_ref<
+    void(std::unique_ptr<Info>)> f)
+{
+    for(auto& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for(auto& kv : shard.infos)
+        {
+            canonicalize(*kv.second.I);
+            f(std::move(kv.second.I));
+        }
+        shard.infos.clear();
+    }
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,100 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_STREAMINGREDUCER_HPP
+#define MRDOX_TOOL_TOOL_STREAMINGREDUCER_HPP
+
+#include <mrdox/MetadataFwd.hpp>
+#include <clang/Tooling/Execution.h>
+#include <llvm/ADT/StringMap.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace clang {
+namespace mrdox {
+
+/** Tool results which are reduced as they arrive.
+
+    Instead of keeping every serialized bitcode
+    until extraction finishes, each bitcode is
+    decoded and merged into a running Info for
+    its symbol ID as soon as it is reported.
+    This overlaps the reduce phase with extraction,
+    and peak memory is bounded by the size of the
+    reduced corpus rather than by the bitcode.
+
+    @par Thread Safety
+    May be called concurrently.
+*/
+class StreamingReducer : public tooling::ToolResults
+{
+public:
+    void
+    addResult(
+        StringRef Key,
+        StringRef Value) override;
+
+    /** Return nothing, since no bitcode is kept.
+    */
+    std::vector<std::pair<
+        llvm::StringRef, llvm::StringRef>>
+    AllKVResults() override
+    {
+        return {};
+    }
+
+    void
+    forEachResult(llvm::function_ref<
+        void(StringRef Key, StringRef Value)>) override
+    {
+    }
+
+    /** Return true if any bitcode could not be read or merged.
+    */
+    bool
+    failed() const noexcept
+    {
+        return failed_;
+    }
+
+    /** Invoke a function with each reduced Info.
+
+        The Info is moved to the function. This
+        may only be called once, after extraction.
+    */
+    void
+    take(llvm::function_ref<
+        void(std::unique_ptr<Info>)> f);
+
+private:
+    static constexpr std::size_t NumShards = 64;
+
+    struct Slot
+    {
+        std::unique_ptr<Info> I;
+        std::size_t merges = 0;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        llvm::StringMap<Slot> infos;
+    };
+
+    std::array<Shard, NumShards> shards_;
+    std::atomic<bool> failed_ = false;
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,63 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "SymbolTable.hpp"
+#include "Support/Debug.hpp"
+
+namespace clang {
+namespace mrdox {
+
+void
+SymbolTable::
+grow()
+{
+    std::vector<Slot> old = std::move(slots_);
+    slots_ = std::vector<Slot>(old.empty() ? 16 : old.size() * 2);
+    std::size_t const mask = slots_.size() - 1;
+    for(Slot& slot : old)
+    {
+        if(! slot.I)
+            continue;
+        std::size_t i = hash(slot.id) & mask;
+        while(slots_[i].I)
+            i = (i + 1) & mask;
+        slots_[i] = slot;
+    }
+}
+
+void
+SymbolTable::
+insert(Info* I)
+{
+    MRDOX_ASSERT(I);
+    // keep the load factor at or below 3/4
+    if((size_ + 1) * 4 > slots_.size() * 3)
+        grow();
+    std::size_t const mask = slots_.size() - 1;
+    for(std::size_t i = hash(I->id) & mask;; i = (i + 1) & mask)
+    {
+        Slot& slot = slots_[i];
+        if(! slot.I)
+        {
+            slot.id = I->id;
+            slot.I = I;
+            ++size_;
+            return;
+        }
+        if(slot.id == I->id)
+        {
+            slot.I = I;
+            return;
+        }
+    }
+}
+
+} // mrdox
+} // clang
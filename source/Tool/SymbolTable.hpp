@@ -0,0 +1,151 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_SYMBOLTABLE_HPP
+#define MRDOX_TOOL_TOOL_SYMBOLTABLE_HPP
+
+#include <mrdox/Metadata/Info.hpp>
+#include <mrdox/Metadata/Symbols.hpp>
+#include <mrdox/Platform.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A table of Info keyed on symbol ID.
+
+    This is a flat open-addressing hash table
+    with linear probing. The key is stored in
+    the slot next to the Info, so a lookup is
+    one probe into contiguous memory in the
+    common case. A symbol ID is already a SHA1,
+    so eight of its bytes are used as the hash
+    without mixing them again.
+
+    Each element also holds the dense index of
+    its symbol, which is assigned once the
+    corpus is finalized.
+
+    The table does not own the Infos, and
+    elements cannot be erased.
+*/
+class SymbolTable
+{
+    struct Slot
+    {
+        SymbolID id;
+        // fits in the padding before I
+        std::uint32_t index = npos;
+        Info* I = nullptr;
+    };
+
+    std::vector<Slot> slots_;
+    std::size_t size_ = 0;
+
+    static
+    std::uint64_t
+    hash(
+        SymbolID const& id) noexcept
+    {
+        // the leading byte is used to pick the
+        // shard of the corpus, so hash the tail
+        std::uint64_t h;
+        std::memcpy(&h, id.data() + id.size() - sizeof(h), sizeof(h));
+        return h;
+    }
+
+    void grow();
+
+    Slot*
+    lookup(
+        SymbolID const& id) const noexcept
+    {
+        if(slots_.empty())
+            return nullptr;
+        std::size_t const mask = slots_.size() - 1;
+        for(std::size_t i = hash(id) & mask;; i = (i + 1) & mask)
+        {
+            Slot const& slot = slots_[i];
+            if(! slot.I)
+                return nullptr;
+            if(slot.id == id)
+                return const_cast<Slot*>(&slot);
+        }
+    }
+
+public:
+    /** The index of an element which has none.
+    */
+    static constexpr std::uint32_t npos = std::uint32_t(-1);
+
+    /** Return the number of elements.
+    */
+    std::size_t
+    size() const noexcept
+    {
+        return size_;
+    }
+
+    /** Return the Info with the given ID, or nullptr.
+    */
+    Info*
+    find(
+        SymbolID const& id) const noexcept
+    {
+        Slot const* slot = lookup(id);
+        return slot ? slot->I : nullptr;
+    }
+
+    /** Return the index of the element with the given ID, or npos.
+    */
+    std::uint32_t
+    findIndex(
+        SymbolID const& id) const noexcept
+    {
+        Slot const* slot = lookup(id);
+        return slot ? slot->index : npos;
+    }
+
+    /** Set the index of the element with the given ID.
+
+        The element must exist.
+    */
+    void
+    setIndex(
+        SymbolID const& id,
+        std::uint32_t index) noexcept
+    {
+        Slot* slot = lookup(id);
+        MRDOX_ASSERT(slot);
+        slot->index = index;
+    }
+
+    /** Insert an Info, replacing any with the same ID.
+    */
+    void insert(Info* I);
+
+    /** Invoke a function with each Info.
+    */
+    template<class F>
+    void
+    forEach(F&& f) const
+    {
+        for(Slot const& slot : slots_)
+            if(slot.I)
+                f(*slot.I);
+    }
+};
+
+} // mrdox
+} // clang
+
+#endif
@@ -0,0 +1,409 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#include "TUCache.hpp"
+#include <mrdox/Support/Path.hpp>
+#include <mrdox/Version.hpp>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+namespace clang {
+namespace mrdox {
+
+namespace {
+
+constexpr llvm::StringLiteral cacheMagic = "MRDOXTU3";
+
+void
+writeU32(
+    llvm::raw_ostream& os,
+    std::uint32_t v)
+{
+    char buf[4];
+    llvm::support::endian::write32le(buf, v);
+    os.write(buf, sizeof(buf));
+}
+
+void
+writeU64(
+    llvm::raw_ostream& os,
+    std::uint64_t v)
+{
+    char buf[8];
+    llvm::support::endian::write64le(buf, v);
+    os.write(buf, sizeof(buf));
+}
+
+/** A bounds-checked reader over a cache file.
+*/
+class Reader
+{
+    llvm::StringRef s_;
+    bool ok_ = true;
+
+public:
+    explicit
+    Reader(llvm::StringRef s) noexcept
+        : s_(s)
+    {
+    }
+
+    bool ok() const noexcept
+    {
+        return ok_;
+    }
+
+    llvm::StringRef
+    take(std::size_t n) noexcept
+    {
+        if(! ok_ || s_.size() < n)
+        {
+            ok_ = false;
+            return {};
+        }
+        auto result = s_.take_front(n);
+        s_ = s_.drop_front(n);
+        return result;
+    }
+
+    std::uint32_t
+    u32() noexcept
+    {
+        auto s = take(4);
+        return ok_ ? llvm::support::endian::read32le(s.data()) : 0;
+    }
+
+    std::uint64_t
+    u64() noexcept
+    {
+        auto s = take(8);
+        return ok_ ? llvm::support::endian::read64le(s.data()) : 0;
+    }
+};
+
+} // (anon)
+
+//------------------------------------------------
+
+TUCache::
+TUCache(
+    std::string_view dir,
+    bool keepEntries)
+    : dir_(dir)
+    , keepEntries_(keepEntries)
+{
+    if(dir_.empty())
+        return;
+    if(auto ec = llvm::sys::fs::create_directories(dir_))
+        reportWarning("Could not create cache directory \"{}\": {}",
+            dir_, ec.message());
+}
+
+std::string
+TUCache::
+makeKey(
+    tooling::CompileCommand const& cmd,
+    llvm::StringRef options)
+{
+    llvm::SHA1 H;
+    auto const add = [&H](llvm::StringRef s)
+    {
+        // length-prefix each field so that
+        // concatenations cannot collide
+        std::uint8_t len[4];
+        llvm::support::endian::write32le(len, s.size());
+        H.update(llvm::ArrayRef<std::uint8_t>(len));
+        H.update(s);
+    };
+    add(project_version);
+    add(cmd.Directory);
+    add(cmd.Filename);
+    for(auto const& arg : cmd.CommandLine)
+        add(arg);
+    add(options);
+    return llvm::toHex(H.final(), true);
+}
+
+std::uint64_t
+TUCache::
+hashContents(
+    llvm::StringRef contents) noexcept
+{
+    return llvm::xxHash64(contents);
+}
+
+std::optional<std::uint64_t>
+TUCache::
+getFileHash(
+    std::string const& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = fileHashes_.find(path);
+        if(it != fileHashes_.end())
+            return it->second;
+    }
+    std::optional<std::uint64_t> hash;
+    if(auto buf = llvm::MemoryBuffer::getFile(path))
+        hash = hashContents((*buf)->getBuffer());
+    std::lock_guard<std::mutex> lock(mutex_);
+    fileHashes_.try_emplace(path, hash);
+    return hash;
+}
+
+std::string
+TUCache::
+serialize(
+    Entry const& entry)
+{
+    std::string result;
+    llvm::raw_string_ostream os(result);
+    writeU32(os, entry.deps.size());
+    for(auto const& dep : entry.deps)
+    {
+        writeU32(os, dep.path.size());
+        os << dep.path;
+        writeU64(os, dep.hash);
+    }
+    writeU32(os, entry.missing.size());
+    for(auto const& path : entry.missing)
+    {
+        writeU32(os, path.size());
+        os << path;
+    }
+    writeU32(os, entry.bitcodes.size());
+    os << entry.bitcodes;
+    os.flush();
+    return result;
+}
+
+std::optional<TUCache::Entry>
+TUCache::
+deserialize(
+    llvm::StringRef data)
+{
+    Reader r(data);
+    Entry entry;
+    auto const numDeps = r.u32();
+    for(std::uint32_t i = 0; r.ok() && i < numDeps; ++i)
+    {
+        auto& dep = entry.deps.emplace_back();
+        dep.path = r.take(r.u32()).str();
+        dep.hash = r.u64();
+    }
+    auto const numMissing = r.u32();
+    for(std::uint32_t i = 0; r.ok() && i < numMissing; ++i)
+        entry.missing.push_back(r.take(r.u32()).str());
+    entry.bitcodes = r.take(r.u32()).str();
+    if(! r.ok())
+        return std::nullopt;
+    return entry;
+}
+
+std::optional<TUCache::Entry>
+TUCache::
+load(
+    llvm::StringRef key)
+{
+    std::optional<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = preloaded_.find(key);
+        if(it != preloaded_.end())
+        {
+            entry = std::move(it->second);
+            preloaded_.erase(it);
+        }
+    }
+    if(! entry && ! dir_.empty())
+    {
+        auto buf = llvm::MemoryBuffer::getFile(
+            files::appendPath(dir_, key));
+        if(buf)
+        {
+            llvm::StringRef data = (*buf)->getBuffer();
+            if(data.consume_front(cacheMagic))
+                entry = deserialize(data);
+        }
+    }
+    if(! entry && remote_)
+    {
+        if(auto data = remote_->get(key))
+        {
+            llvm::StringRef s = *data;
+            if(s.consume_front(cacheMagic))
+                entry = deserialize(s);
+            // the next run finds it on this machine
+            if(entry && ! dir_.empty())
+                if(auto err = writeFile(key, *data))
+                    reportWarning("Could not cache \"{}\": {}",
+                        key, err.message());
+        }
+    }
+    if(! entry)
+    {
+        ++misses_;
+        return std::nullopt;
+    }
+
+    // every file the translation unit read
+    // must still have the same contents
+    for(auto const& dep : entry->deps)
+    {
+        auto hash = getFileHash(dep.path);
+        if(! hash || *hash != dep.hash)
+        {
+            ++misses_;
+            return std::nullopt;
+        }
+    }
+    // and a file which was searched for and not
+    // found could now be included instead
+    for(auto const& path : entry->missing)
+    {
+        if(getFileHash(path))
+        {
+            ++misses_;
+            return std::nullopt;
+        }
+    }
+    ++hits_;
+    if(keepEntries_)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        kept_.insert_or_assign(key, *entry);
+    }
+    return entry;
+}
+
+Error
+TUCache::
+store(
+    llvm::StringRef key,
+    Entry const& entry)
+{
+    if(keepEntries_)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        kept_.insert_or_assign(key, entry);
+    }
+    if(dir_.empty() && ! remote_)
+        return Error::success();
+
+    std::string data(cacheMagic);
+    data += serialize(entry);
+    if(remote_)
+        remote_->put(key, data);
+    if(dir_.empty())
+        return Error::success();
+    return writeFile(key, data);
+}
+
+Error
+TUCache::
+writeFile(
+    llvm::StringRef key,
+    llvm::StringRef data)
+{
+    auto const path = files::appendPath(dir_, key);
+    llvm::SmallString<256> temp;
+    int fd;
+    if(auto ec = llvm::sys::fs::createUniqueFile(
+            path + "-%%%%%%%%.tmp", fd, temp))
+        return formatError("createUniqueFile(\"{}\") returned \"{}\"",
+            path, ec.message());
+    {
+        llvm::raw_fd_ostream os(fd, true);
+        os << data;
+        os.close();
+        if(os.has_error())
+        {
+            auto ec = os.error();
+            os.clear_error();
+            llvm::sys::fs::remove(temp);
+            return formatError("write(\"{}\") returned \"{}\"",
+                std::string_view(temp), ec.message());
+        }
+    }
+    // rename is atomic, so concurrent runs
+    // never observe a partially written file
+    if(auto ec = llvm::sys::fs::rename(temp, path))
+    {
+        llvm::sys::fs::remove(temp);
+        return formatError("rename(\"{}\") returned \"{}\"",
+            path, ec.message());
+    }
+    return Error::success();
+}
+
+void
+TUCache::
+preload(
+    std::string key,
+    Entry entry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    preloaded_.insert_or_assign(key, std::move(entry));
+}
+
+void
+TUCache::
+forEachEntry(
+    llvm::function_ref<void(
+        llvm::StringRef key,
+        Entry const& entry)> f) const
+{
+    MRDOX_ASSERT(keepEntries_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(auto const& kv : kept_)
+        f(kv.getKey(), kv.getValue());
+}
+
+void
+TUCache::
+record(
+    llvm::StringRef mainFile,
+    Entry entry)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    recorded_[normalizeMainFile(mainFile)] = std::move(entry);
+}
+
+std::optional<TUCache::Entry>
+TUCache::
+claim(
+    llvm::StringRef mainFile)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = recorded_.find(normalizeMainFile(mainFile));
+    if(it == recorded_.end())
+        return std::nullopt;
+    std::optional<Entry> result(std::move(it->second));
+    recorded_.erase(it);
+    return result;
+}
+
+std::string
+TUCache::
+normalizeMainFile(
+    llvm::StringRef path)
+{
+    return files::makePosixStyle(
+        files::normalizePath(path));
+}
+
+} // mrdox
+} // clang
@@ -0,0 +1,223 @@
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+// Copyright (c) 2023 Vinnie Falco (vinnie.falco@gmail.com)
+//
+// Official repository: https://github.com/cppalliance/mrdox
+//
+
+#ifndef MRDOX_TOOL_TOOL_TUCACHE_HPP
+#define MRDOX_TOOL_TOOL_TUCACHE_HPP
+
+#include "AST/Bitcode.hpp"
+#include "Support/RemoteCache.hpp"
+#include <mrdox/Support/Error.hpp>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/StringMap.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace mrdox {
+
+/** A persistent cache of the bitcode produced by each translation unit.
+
+    Each entry is keyed on a hash of the adjusted
+    compile command, and records the content hash
+    of every file the translation unit read. An
+    entry is only considered valid when all of the
+    recorded files still have the same contents.
+
+    Entries which are not in the cache directory
+    are looked up in the remote cache, if one is
+    set, and the entries which are stored are
+    also written to it.
+
+    @par Thread Safety
+    May be called concurrently.
+*/
+class TUCache
+{
+public:
+    /** A file read while parsing a translation unit.
+    */
+    struct Dependency
+    {
+        std::string path;
+        std::uint64_t hash = 0;
+    };
+
+    /** The extraction results for one translation unit.
+    */
+    struct Entry
+    {
+        std::vector<Dependency> deps;
+        // files which were looked up and did not
+        // exist, such as include search probes
+        std::vector<std::string> missing;
+        // the serialized bitcode batch
+        std::string bitcodes;
+    };
+
+    /** Constructor.
+
+        @param dir The absolute path to the directory
+        holding the cache files. It is created if it
+        does not exist. If empty, only entries which
+        are preloaded are used.
+
+        @param keepEntries If `true`, every entry
+        loaded or stored is kept in memory, to be
+        visited with @ref forEachEntry.
+    */
+    explicit
+    TUCache(
+        std::string_view dir,
+        bool keepEntries = false);
+
+    /** Set the remote cache.
+
+        This must not be called while entries
+        are loaded or stored.
+    */
+    void
+    setRemote(
+        std::shared_ptr<RemoteCache> remote) noexcept
+    {
+        remote_ = std::move(remote);
+    }
+
+    /** Return the cache key for a compile command.
+
+        @param options The configuration which
+        changes the results of the command.
+    */
+    static
+    std::string
+    makeKey(
+        tooling::CompileCommand const& cmd,
+        llvm::StringRef options = {});
+
+    /** Return the content hash of a file buffer.
+    */
+    static
+    std::uint64_t
+    hashContents(
+        llvm::StringRef contents) noexcept;
+
+    /** Return the entry for a key if it is present and up to date.
+    */
+    std::optional<Entry>
+    load(
+        llvm::StringRef key);
+
+    /** Write the entry for a key to the cache directory.
+    */
+    Error
+    store(
+        llvm::StringRef key,
+        Entry const& entry);
+
+    /** Add an entry from a previous run.
+
+        A preloaded entry is used instead of the
+        cache file with the same key, and is still
+        only valid if its files are unchanged.
+    */
+    void
+    preload(
+        std::string key,
+        Entry entry);
+
+    /** Invoke a function with each entry loaded or stored.
+
+        This is only available when the cache was
+        constructed with `keepEntries`.
+    */
+    void
+    forEachEntry(
+        llvm::function_ref<void(
+            llvm::StringRef key,
+            Entry const& entry)> f) const;
+
+    /** Return an entry serialized to a string.
+    */
+    static
+    std::string
+    serialize(
+        Entry const& entry);
+
+    /** Return an entry from a serialized string.
+    */
+    static
+    std::optional<Entry>
+    deserialize(
+        llvm::StringRef data);
+
+        /** Record the results of a parsed translation unit.
+
+        This is called by the visitor. The results
+        are held until claimed by the executor
+        using the same main file path.
+    */
+    void
+    record(
+        llvm::StringRef mainFile,
+        Entry entry);
+
+    /** Remove and return the results recorded for a main file.
+    */
+    std::optional<Entry>
+    claim(
+        llvm::StringRef mainFile);
+
+    /** Return a normalized path used to match main files.
+    */
+    static
+    std::string
+    normalizeMainFile(
+        llvm::StringRef path);
+
+    std::size_t hits() const noexcept { return hits_; }
+    std::size_t misses() const noexcept { return misses_; }
+
+    /** Return the content hash of a file.
+
+        Each file is only read once, and the
+        hash is used for every entry naming it.
+        An empty value is returned when the file
+        cannot be read.
+    */
+    std::optional<std::uint64_t>
+    getFileHash(
+        std::string const& path);
+
+private:
+    Error
+    writeFile(
+        llvm::StringRef key,
+        llvm::StringRef data);
+
+    std::string dir_;
+    bool keepEntries_;
+    std::shared_ptr<RemoteCache> remote_;
+    mutable std::mutex mutex_;
+    llvm::StringMap<std::optional<std::uint64_t>> fileHashes_;
+    llvm::StringMap<Entry> recorded_;
+    llvm::StringMap<Entry> preloaded_;
+    llvm::StringMap<Entry> kept_;
+    std::atomic<std::size_t> hits_ = 0;
+    std::atomic<std::size_t> misses_ = 0;
+};
+
+} // mrdox
+} // clang
+
+#endif
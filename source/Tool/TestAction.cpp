@@ -8,27 +8,39 @@
 // Official repository: https://github.com/cppalliance/mrdox
 //
 
+#include "CachingFileSystem.hpp"
 #include "ConfigImpl.hpp"
 #include "CorpusImpl.hpp"
 #include "SingleFileDB.hpp"
+#include "Support/Handlebars.hpp"
+#include "Support/HandlebarsHelpers.hpp"
 #include "ToolArgs.hpp"
 #include "ToolExecutor.hpp"
 #include "Support/Error.hpp"
+#include "Support/Memory.hpp"
 #include <mrdox/Config.hpp>
 #include <mrdox/Generators.hpp>
 #include <mrdox/Platform.hpp>
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/ThreadPool.hpp>
 #include <clang/Tooling/StandaloneExecution.h>
+#include <llvm/ADT/ScopeExit.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/Program.h>
 #include <llvm/Support/Signals.h>
+#include <algorithm>
 #include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 namespace clang {
 namespace mrdox {
@@ -51,11 +63,32 @@ struct Results
     std::atomic<std::size_t> numberOfFailures = 0;
     std::atomic<std::size_t> numberofFilesWritten = 0;
 
+    // the cost of one case
+    struct Case
+    {
+        std::string filePath;
+        double milliseconds;
+        std::size_t bytes;
+    };
+
+    std::mutex mutex;
+    std::vector<Case> cases;
+
     Results()
         : startTime(clock_type::now())
     {
     }
 
+    void
+    addCase(
+        llvm::StringRef filePath,
+        double milliseconds,
+        std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cases.push_back({ filePath.str(), milliseconds, bytes });
+    }
+
     // Return the number of milliseconds of elapsed time
     auto
     elapsedMilliseconds() const noexcept
@@ -75,24 +108,113 @@ struct Results
 class TestRunner
 {
     ThreadPool threadPool_;
+
+    // Every case is a tiny translation unit, so
+    // most of its time would go to reading the
+    // builtin headers. The file cache and the
+    // container operations are shared by all cases,
+    // while each case still gets its own corpus.
+    SharedFileCache fileCache_;
+    std::shared_ptr<PCHContainerOperations> pchOps_;
+
     Results& results_;
     std::string extraYaml_;
     llvm::ErrorOr<std::string> diff_;
+    std::mutex diffMutex_;
     Generator const* xmlGen_;
+    Generator const* jsonGen_;
+    Generator const* searchGen_;
+    Generator const* adocGen_;
+
+    // The template engine is read from the
+    // configuration of a corpus, so comparing
+    // the engines needs a second configuration,
+    // which renders with Handlebars.js.
+    struct Configs
+    {
+        std::shared_ptr<Config const> native;
+        std::shared_ptr<Config const> js;
+    };
 
     std::shared_ptr<Config const>
     makeConfig(
-        llvm::StringRef workingDir);
+        llvm::StringRef workingDir,
+        llvm::StringRef caseYaml,
+        llvm::StringRef engine);
+
+    Configs
+    makeConfigs(
+        llvm::StringRef workingDir,
+        llvm::StringRef caseYaml = {});
 
     Error
     writeFile(
         llvm::StringRef filePath,
         llvm::StringRef contents);
 
+    /** Compare the output of a case with the file which holds the expected output.
+    */
+    void
+    checkOutput(
+        llvm::StringRef casePath,
+        llvm::StringRef outputPath,
+        llvm::StringRef generated);
+
+    void
+    checkCase(
+        llvm::StringRef casePath,
+        tooling::CompilationDatabase const& db,
+        Configs const& configs);
+
+    /** Compare the files of multi-page XML with those which hold the expected output.
+
+        The expected files of foo.cpp are
+        in the directory foo.pages.
+    */
+    void
+    checkPages(
+        llvm::StringRef casePath,
+        Corpus const& corpus);
+
+    /** Compare the asciidoc of a case rendered by each template engine.
+    */
+    void
+    compareEngines(
+        llvm::StringRef casePath,
+        tooling::CompilationDatabase const& db,
+        Corpus const& corpus,
+        std::shared_ptr<Config const> const& jsConfig);
+
     Error
     handleFile(
         llvm::StringRef filePath,
-        std::shared_ptr<Config const> const& config);
+        Configs const& configs);
+
+    /** Check the templates of a file of Handlebars tests.
+
+        The file holds an object whose "tests" are
+        objects with a "name", a "template", the
+        "data" it is rendered with, and the "expected"
+        output. The "partials" are an object of the
+        text of each partial, and "noEscape" and
+        "preventIndent" set the rendering options.
+        The keys of objects in the data are sorted.
+    */
+    Error
+    handleSpec(
+        llvm::StringRef filePath);
+
+    /** Check a directory which holds a mrdox.yml as one case.
+
+        The .cpp files are the translation units of
+        a single corpus, and the configuration is
+        added to the one of the tests. The expected
+        output is beside the directory, as it is
+        beside the .cpp file of other cases.
+    */
+    Error
+    handleUnits(
+        llvm::StringRef dirPath);
 
     Error
     handleDir(
@@ -119,19 +241,28 @@ TestRunner::
 TestRunner(
     Results& results,
     llvm::StringRef extraYaml)
-    : threadPool_(1)
+    : threadPool_(0)
+    , pchOps_(std::make_shared<PCHContainerOperations>())
     , results_(results)
     , extraYaml_(extraYaml)
     , diff_(llvm::sys::findProgramByName("diff"))
     , xmlGen_(getGenerators().find("xml"))
+    , jsonGen_(getGenerators().find("json"))
+    , searchGen_(getGenerators().find("search"))
+    , adocGen_(getGenerators().find("adoc"))
 {
     MRDOX_ASSERT(xmlGen_ != nullptr);
+    MRDOX_ASSERT(jsonGen_ != nullptr);
+    MRDOX_ASSERT(searchGen_ != nullptr);
+    MRDOX_ASSERT(adocGen_ != nullptr);
 }
 
 std::shared_ptr<Config const>
 TestRunner::
 makeConfig(
-    llvm::StringRef workingDir)
+    llvm::StringRef workingDir,
+    llvm::StringRef caseYaml,
+    llvm::StringRef engine)
 {
     std::string configYaml;
     llvm::raw_string_ostream(configYaml) <<
@@ -141,7 +272,10 @@ makeConfig(
         "generator:\n"
         "  xml:\n"
         "    index: false\n"
-        "    prolog: true\n";
+        "    prolog: true\n"
+        "  adoc:\n"
+        "    engine: " << engine << "\n" <<
+        extraYaml_ << caseYaml;
 
     std::error_code ec;
     auto config = loadConfigString(
@@ -152,6 +286,20 @@ makeConfig(
     return *config;
 }
 
+auto
+TestRunner::
+makeConfigs(
+    llvm::StringRef workingDir,
+    llvm::StringRef caseYaml) ->
+        Configs
+{
+    Configs configs;
+    configs.native = makeConfig(workingDir, caseYaml, "native");
+    if(toolArgs.compareEngines)
+        configs.js = makeConfig(workingDir, caseYaml, "js");
+    return configs;
+}
+
 Error
 TestRunner::
 writeFile(
@@ -175,131 +323,530 @@ writeFile(
     return Error::success();
 }
 
-Error
+void
 TestRunner::
-handleFile(
-    llvm::StringRef filePath,
-    std::shared_ptr<Config const> const& config)
+checkOutput(
+    llvm::StringRef casePath,
+    llvm::StringRef outputPath,
+    llvm::StringRef generated)
 {
-    namespace fs = llvm::sys::fs;
     namespace path = llvm::sys::path;
 
-    MRDOX_ASSERT(path::extension(filePath).compare_insensitive(".cpp") == 0);
+    if(toolArgs.toolAction == Action::update)
+    {
+        // Refresh the expected output file,
+        // where writeFile counts a failure
+        writeFile(outputPath, generated).operator bool();
+        return;
+    }
 
-    results_.numberOfFiles++;
+    // Open and load the comparison file
+    auto expected = llvm::MemoryBuffer::getFile(outputPath, false);
+    if(! expected)
+    {
+        // File could not be loaded
+        results_.numberOfErrors++;
 
-    SmallString dirPath = filePath;
-    path::remove_filename(dirPath);
+        if(expected.getError() != std::errc::no_such_file_or_directory)
+        {
+            // Some kind of system problem
+            reportError(
+                formatError("MemoryBuffer::getFile(\"{}\") returned \"{}\"",
+                    outputPath, expected.getError().message()),
+                "load the expected output");
+            return;
+        }
 
-    SmallString outputPath = filePath;
-    path::replace_extension(outputPath, xmlGen_->fileExtension());
+        // File does not exist, so write it
+        writeFile(outputPath, generated).operator bool();
+        return;
+    }
+
+    // Compare the generated output with the expected output
+    if(generated == (*expected)->getBuffer())
+        return;
+
+    // The output did not match
+    results_.numberOfFailures++;
+    reportError("Test for \"{}\" failed", outputPath);
+
+    if(! toolArgs.badOption.getValue())
+        return;
+
+    // Write the .bad file beside the expected one,
+    // so that foo.xml is compared with foo.bad.xml
+    SmallString bad = outputPath;
+    path::replace_extension(bad,
+        "bad" + path::extension(outputPath).str());
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(bad, ec, llvm::sys::fs::OF_None);
+        if (ec)
+        {
+            results_.numberOfErrors++;
+            reportError(formatError("raw_fd_ostream(\"{}\") returned \"{}\"",
+                bad, ec), "write the output of \"{}\"", casePath);
+            return;
+        }
+        os << generated;
+    }
+
+    // VFALCO We are calling this over and over again instead of once?
+    if(! diff_.getError())
+    {
+        // the diffs of the cases are not interleaved
+        std::lock_guard<std::mutex> lock(diffMutex_);
+        std::array<llvm::StringRef, 5u> args {
+            diff_.get(), "-u", "--color", outputPath, bad };
+        llvm::sys::ExecuteAndWait(diff_.get(), args);
+    }
+}
+
+void
+TestRunner::
+checkCase(
+    llvm::StringRef casePath,
+    tooling::CompilationDatabase const& db,
+    Configs const& configs)
+{
+    namespace path = llvm::sys::path;
+
+    results_.numberOfFiles++;
+    // the memory of the parse is recorded on this
+    // thread, so an earlier case must not leave one
+    takeTranslationUnitBytes();
+    auto const start = std::chrono::steady_clock::now();
+    std::size_t bytes = 0;
+    auto record = llvm::make_scope_exit(
+        [&]
+        {
+            std::chrono::duration<double, std::milli> const elapsed =
+                std::chrono::steady_clock::now() - start;
+            results_.addCase(casePath, elapsed.count(), bytes);
+        });
 
     // Build Corpus
     std::unique_ptr<Corpus> corpus;
     {
-        SingleFileDB db(dirPath, filePath);
-        ToolExecutor ex(*config, db);
-        auto result = CorpusImpl::build(ex, config);
+        ToolExecutor ex(*configs.native, db, pchOps_);
+        ex.setFileCache(&fileCache_);
+        auto result = CorpusImpl::build(ex, configs.native);
         if(! result)
         {
-            reportError(result.error(), "build Corpus for \"{}\"", filePath);
-            return Error::success(); // keep going
+            reportError(result.error(), "build Corpus for \"{}\"", casePath);
+            results_.numberOfErrors++;
+            return; // keep going
         }
         corpus = result.release();
+        bytes = takeTranslationUnitBytes();
     }
 
     // Generate XML
     std::string generatedXml;
     if(auto err = xmlGen_->buildOneString(generatedXml, *corpus))
     {
-        reportError(err, "build XML string for \"{}\"", filePath);
+        reportError(err, "build XML string for \"{}\"", casePath);
         results_.numberOfErrors++;
-        return Error::success(); // keep going
+        return; // keep going
     }
 
-    if(toolArgs.toolAction == Action::test)
+    SmallString outputPath = casePath;
+    path::replace_extension(outputPath, xmlGen_->fileExtension());
+    checkOutput(casePath, outputPath, generatedXml);
+
+    // The JSON is checked for the cases which
+    // have a .json file, and an update writes
+    // one for every case.
+    path::replace_extension(outputPath, jsonGen_->fileExtension());
+    if( toolArgs.toolAction == Action::update ||
+        llvm::sys::fs::exists(outputPath))
     {
-        // Open and load XML comparison file
-        std::unique_ptr<llvm::MemoryBuffer> expectedXml;
+        std::string generatedJson;
+        if(auto err = jsonGen_->buildOneString(generatedJson, *corpus))
         {
-            auto result = llvm::MemoryBuffer::getFile(outputPath, false);
-            if(! result)
-            {
-                // File could not be loaded
-                results_.numberOfErrors++;
+            reportError(err, "build JSON string for \"{}\"", casePath);
+            results_.numberOfErrors++;
+            return; // keep going
+        }
+        checkOutput(casePath, outputPath, generatedJson);
+    }
 
-                if( result.getError() != std::errc::no_such_file_or_directory)
-                {
-                    // Some kind of system problem
-                    reportError(
-                        Error("MemoryBuffer::getFile(\"{}\") returned \"{}\""),
-                        "load the reference XML");
-                    return Error::success(); // keep going
-                }
-
-                // File does not exist, so write it
-                if(auto err = writeFile(outputPath, generatedXml))
-                    return Error::success();
-            }
-            else
-            {
-                expectedXml = std::move(result.get());
-            }
+    // The search index is only checked for
+    // the cases which have a .search.json file.
+    path::replace_extension(outputPath, "search.json");
+    if(llvm::sys::fs::exists(outputPath))
+    {
+        std::string generatedIndex;
+        if(auto err = searchGen_->buildOneString(generatedIndex, *corpus))
+        {
+            reportError(err, "build the search index for \"{}\"", casePath);
+            results_.numberOfErrors++;
+            return; // keep going
         }
+        checkOutput(casePath, outputPath, generatedIndex);
+    }
+
+    if(corpus->config.multiPage)
+        checkPages(casePath, *corpus);
+
+    if(configs.js)
+        compareEngines(casePath, db, *corpus, configs.js);
+}
 
-        // Compare the generated output with the expected output
-        if( expectedXml &&
-            generatedXml != expectedXml->getBuffer())
+namespace {
+
+// the paths of the files below a directory,
+// relative to it
+std::vector<std::string>
+listFiles(
+    llvm::StringRef dirPath)
+{
+    namespace fs = llvm::sys::fs;
+
+    std::vector<std::string> files;
+    std::error_code ec;
+    fs::recursive_directory_iterator iter(dirPath, ec);
+    fs::recursive_directory_iterator const end{};
+    for(; ! ec && iter != end; iter.increment(ec))
+    {
+        if(iter->type() != fs::file_type::regular_file)
+            continue;
+        files.emplace_back(llvm::StringRef(
+            iter->path()).drop_front(dirPath.size() + 1));
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+} // (anon)
+
+void
+TestRunner::
+checkPages(
+    llvm::StringRef casePath,
+    Corpus const& corpus)
+{
+    namespace fs = llvm::sys::fs;
+    namespace path = llvm::sys::path;
+
+    SmallString outputDir;
+    if(auto ec = fs::createUniqueDirectory("mrdox-pages", outputDir))
+    {
+        results_.numberOfErrors++;
+        reportError(formatError("createUniqueDirectory returned \"{}\"", ec),
+            "write the pages of \"{}\"", casePath);
+        return;
+    }
+    auto removeOutput = llvm::make_scope_exit(
+        [&]
         {
-            // The output did not match
-            results_.numberOfFailures++;
-            reportError("Test for \"{}\" failed", filePath);
+            fs::remove_directories(outputDir);
+        });
+    if(auto err = xmlGen_->build(outputDir, corpus))
+    {
+        reportError(err, "build the XML pages of \"{}\"", casePath);
+        results_.numberOfErrors++;
+        return;
+    }
 
-            if(toolArgs.badOption.getValue())
-            {
-                // Write the .bad.xml file
-                auto bad = outputPath;
-                path::replace_extension(bad, "bad.xml");
-                {
-                    std::error_code ec;
-                    llvm::raw_fd_ostream os(bad, ec, llvm::sys::fs::OF_None);
-                    if (ec)
-                    {
-                        results_.numberOfErrors++;
-                        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"", bad, ec);
-                    }
-                    os << generatedXml;
-                }
-
-                // VFALCO We are calling this over and over again instead of once?
-                if(! diff_.getError())
-                {
-                    path::replace_extension(bad, "xml");
-                    std::array<llvm::StringRef, 5u> args {
-                        diff_.get(), "-u", "--color", outputPath, bad };
-                    llvm::sys::ExecuteAndWait(diff_.get(), args);
-                }
-
-                // Fix the path for the code that follows
-                outputPath.pop_back_n(8);
-                path::replace_extension(outputPath, "xml");
-            }
+    SmallString expectedDir = casePath;
+    path::replace_extension(expectedDir, "pages");
+
+    auto const files = listFiles(outputDir);
+    for(auto const& file : files)
+    {
+        SmallString filePath = outputDir;
+        path::append(filePath, file);
+        auto generated = llvm::MemoryBuffer::getFile(filePath, false);
+        if(! generated)
+        {
+            results_.numberOfErrors++;
+            reportError(formatError("MemoryBuffer::getFile(\"{}\") returned \"{}\"",
+                filePath, generated.getError().message()), "load the pages");
+            continue;
         }
-        else
+        SmallString expectedPath = expectedDir;
+        path::append(expectedPath, file);
+        // a missing file is written
+        fs::create_directories(path::parent_path(expectedPath));
+        checkOutput(casePath, expectedPath, (*generated)->getBuffer());
+    }
+
+    // the expected files which were not written
+    for(auto const& file : listFiles(expectedDir))
+    {
+        if(std::binary_search(files.begin(), files.end(), file))
+            continue;
+        SmallString expectedPath = expectedDir;
+        path::append(expectedPath, file);
+        if(toolArgs.toolAction == Action::update)
         {
-            // success
+            fs::remove(expectedPath);
+            continue;
         }
+        results_.numberOfFailures++;
+        reportError("Test for \"{}\" failed: the page was not written", expectedPath);
     }
-    else if(toolArgs.toolAction == Action::update)
+}
+
+void
+TestRunner::
+compareEngines(
+    llvm::StringRef casePath,
+    tooling::CompilationDatabase const& db,
+    Corpus const& corpus,
+    std::shared_ptr<Config const> const& jsConfig)
+{
+    namespace path = llvm::sys::path;
+
+    std::unique_ptr<Corpus> jsCorpus;
     {
-        // Refresh the expected output file
-        if(auto err = writeFile(outputPath, generatedXml))
+        ToolExecutor ex(*jsConfig, db, pchOps_);
+        ex.setFileCache(&fileCache_);
+        auto result = CorpusImpl::build(ex, jsConfig);
+        if(! result)
         {
+            reportError(result.error(), "build Corpus for \"{}\"", casePath);
             results_.numberOfErrors++;
-            return Error::success();
+            return;
         }
+        jsCorpus = result.release();
     }
 
+    std::string native;
+    std::string js;
+    if(auto err = adocGen_->buildOneString(native, corpus))
+    {
+        reportError(err, "render \"{}\" with the native engine", casePath);
+        results_.numberOfErrors++;
+        return;
+    }
+    if(auto err = adocGen_->buildOneString(js, *jsCorpus))
+    {
+        reportError(err, "render \"{}\" with Handlebars.js", casePath);
+        results_.numberOfErrors++;
+        return;
+    }
+    if(native == js)
+        return;
+
+    results_.numberOfFailures++;
+    reportError("The template engines render \"{}\" differently", casePath);
+    if(! toolArgs.badOption.getValue())
+        return;
+
+    // both renders are kept beside the case
+    SmallString nativePath = casePath;
+    path::replace_extension(nativePath, "native.adoc");
+    SmallString jsPath = casePath;
+    path::replace_extension(jsPath, "js.adoc");
+    if( writeFile(nativePath, native) ||
+        writeFile(jsPath, js))
+        return;
+    if(! diff_.getError())
+    {
+        std::lock_guard<std::mutex> lock(diffMutex_);
+        std::array<llvm::StringRef, 5u> args {
+            diff_.get(), "-u", "--color", jsPath, nativePath };
+        llvm::sys::ExecuteAndWait(diff_.get(), args);
+    }
+}
+
+Error
+TestRunner::
+handleFile(
+    llvm::StringRef filePath,
+    Configs const& configs)
+{
+    namespace path = llvm::sys::path;
+
+    MRDOX_ASSERT(path::extension(filePath).compare_insensitive(".cpp") == 0);
+
+    SmallString dirPath = filePath;
+    path::remove_filename(dirPath);
+
+    SingleFileDB db(dirPath, filePath);
+    checkCase(filePath, db, configs);
+    return Error::success();
+}
+
+Error
+TestRunner::
+handleUnits(
+    llvm::StringRef dirPath)
+{
+    namespace fs = llvm::sys::fs;
+    namespace path = llvm::sys::path;
+
+    SmallString configPath = dirPath;
+    path::append(configPath, "mrdox.yml");
+    auto caseYaml = llvm::MemoryBuffer::getFile(configPath);
+    if(! caseYaml)
+    {
+        results_.numberOfErrors++;
+        return formatError("MemoryBuffer::getFile(\"{}\") returned \"{}\"",
+            configPath, caseYaml.getError().message());
+    }
+
+    std::vector<std::string> files;
+    std::error_code ec;
+    fs::directory_iterator iter(dirPath, ec, false);
+    if(ec)
+        return formatError("fs::directory_iterator(\"{}\") returned \"{}\"", dirPath, ec);
+    for(fs::directory_iterator const end{}; iter != end; iter.increment(ec))
+    {
+        if(ec)
+            return formatError("directory_iterator::increment returned \"{}\"", ec);
+        if( iter->type() == fs::file_type::regular_file &&
+            path::extension(iter->path()).equals_insensitive(".cpp"))
+            files.push_back(iter->path());
+    }
+    std::sort(files.begin(), files.end());
+
+    auto const configs = makeConfigs(dirPath, (*caseYaml)->getBuffer());
+    threadPool_.async(
+        [this, configs, files = std::move(files), dirPath = SmallString(dirPath)]
+        {
+            SingleFileDB db(dirPath, files);
+            checkCase(dirPath, db, configs);
+        });
+    return Error::success();
+}
+
+namespace {
+
+// The keys of objects are sorted, since
+// the parsed JSON does not keep their order
+dom::Value
+toDom(llvm::json::Value const* v)
+{
+    if(! v)
+        return nullptr;
+    switch(v->kind())
+    {
+    case llvm::json::Value::Null:
+        return nullptr;
+    case llvm::json::Value::Boolean:
+        return *v->getAsBoolean();
+    case llvm::json::Value::Number:
+        if(auto n = v->getAsInteger())
+            return *n;
+        return std::to_string(*v->getAsNumber());
+    case llvm::json::Value::String:
+        return std::string_view(*v->getAsString());
+    case llvm::json::Value::Array:
+    {
+        dom::Array arr;
+        for(auto const& e : *v->getAsArray())
+            arr.emplace_back(toDom(&e));
+        return arr;
+    }
+    case llvm::json::Value::Object:
+    {
+        auto const& obj = *v->getAsObject();
+        std::vector<llvm::StringRef> keys;
+        for(auto const& kv : obj)
+            keys.push_back(kv.first);
+        llvm::sort(keys);
+        dom::Object result;
+        for(auto key : keys)
+            result.set(std::string_view(key), toDom(obj.get(key)));
+        return result;
+    }
+    default:
+        MRDOX_UNREACHABLE();
+    }
+}
+
+} // (anon)
+
+Error
+TestRunner::
+handleSpec(
+    llvm::StringRef filePath)
+{
+    results_.numberOfFiles++;
+
+    auto buffer = llvm::MemoryBuffer::getFile(filePath);
+    if(! buffer)
+    {
+        results_.numberOfErrors++;
+        reportError(formatError("MemoryBuffer::getFile(\"{}\") returned \"{}\"",
+            filePath, buffer.getError().message()), "load the tests");
+        return Error::success();
+    }
+    auto json = llvm::json::parse((*buffer)->getBuffer());
+    if(! json)
+    {
+        results_.numberOfErrors++;
+        reportError("could not parse \"{}\": {}",
+            filePath, llvm::toString(json.takeError()));
+        return Error::success();
+    }
+    auto const* obj = json->getAsObject();
+    auto const* tests = obj ? obj->getArray("tests") : nullptr;
+    if(! tests)
+    {
+        results_.numberOfErrors++;
+        reportError("\"{}\" has no tests", filePath);
+        return Error::success();
+    }
+
+    for(auto const& value : *tests)
+    {
+        auto const* test = value.getAsObject();
+        if(! test)
+        {
+            results_.numberOfErrors++;
+            reportError("\"{}\" has a test which is not an object", filePath);
+            continue;
+        }
+        llvm::StringRef const name =
+            test->getString("name").value_or("");
+
+        Handlebars hbs;
+        builtinHelpers().forEach(
+            [&](std::string_view id, Handlebars::Helper const& fn)
+            {
+                hbs.registerHelper(id, fn);
+            });
+        if(auto const* partials = test->getObject("partials"))
+            for(auto const& kv : *partials)
+                if(auto text = kv.second.getAsString())
+                    hbs.registerPartial(kv.first.str(), *text);
+
+        Handlebars::Options options;
+        options.noEscape =
+            test->getBoolean("noEscape").value_or(false);
+        options.preventIndent =
+            test->getBoolean("preventIndent").value_or(false);
+
+        Expected<std::string> output = formatError("no template");
+        if(auto text = test->getString("template"))
+        {
+            auto tmpl = Handlebars::compile(*text);
+            if(tmpl)
+                output = hbs.render(*tmpl, toDom(test->get("data")), options);
+            else
+                output = tmpl.error();
+        }
+        if(! output)
+        {
+            results_.numberOfFailures++;
+            reportError(output.error(), "render \"{}\" of \"{}\"",
+                name, filePath);
+            continue;
+        }
+        llvm::StringRef const expected =
+            test->getString("expected").value_or("");
+        if(*output == expected)
+            continue;
+        results_.numberOfFailures++;
+        reportError("Test \"{}\" of \"{}\" failed:\n"
+            "expected: \"{}\"\n"
+            "rendered: \"{}\"",
+            name, filePath, expected, *output);
+    }
     return Error::success();
 }
 
@@ -320,23 +867,42 @@ handleDir(
         return formatError("fs::directory_iterator(\"{}\") returned \"{}\"", dirPath, ec);
     fs::directory_iterator const end{};
 
-    auto const config = makeConfig(dirPath);
+    auto const configs = makeConfigs(dirPath);
 
     while(iter != end)
     {
         if(iter->type() == fs::file_type::directory_file)
         {
-            if(auto err = handleDir(iter->path()))
+            SmallString configPath(iter->path());
+            path::append(configPath, "mrdox.yml");
+            if(fs::exists(configPath))
+            {
+                if(auto err = handleUnits(iter->path()))
+                    return err;
+            }
+            else if(auto err = handleDir(iter->path()))
+            {
                 return err;
+            }
+        }
+        else if(
+            iter->type() == fs::file_type::regular_file &&
+            llvm::StringRef(iter->path()).endswith_insensitive(".hbs.json"))
+        {
+            threadPool_.async(
+                [this, filePath = SmallString(iter->path())]
+                {
+                    handleSpec(filePath).operator bool();
+                });
         }
         else if(
             iter->type() == fs::file_type::regular_file &&
             path::extension(iter->path()).equals_insensitive(".cpp"))
         {
             threadPool_.async(
-                [this, config, filePath = SmallString(iter->path())]
+                [this, configs, filePath = SmallString(iter->path())]
                 {
-                    handleFile(filePath, config).operator bool();
+                    handleFile(filePath, configs).operator bool();
                 });
         }
         else
@@ -377,8 +943,8 @@ checkPath(
         path::remove_filename(workingDir);
         path::remove_dots(workingDir, true);
 
-        auto config = makeConfig(workingDir);
-        auto err = handleFile(inputPath, config);
+        auto configs = makeConfigs(workingDir);
+        auto err = handleFile(inputPath, configs);
         threadPool_.wait();
         return err;
     }
@@ -396,6 +962,155 @@ checkPath(
     return formatError("fs::file_type was not directory_file");
 }
 
+//------------------------------------------------
+
+// Smaller changes than these are noise
+constexpr double minRegressionMilliseconds = 10;
+constexpr std::size_t minRegressionBytes = 1 << 20;
+
+/** Write the cost of each case to a baseline file.
+*/
+Error
+writeBaseline(
+    llvm::StringRef path,
+    std::vector<Results::Case> cases)
+{
+    std::sort(cases.begin(), cases.end(),
+        [](auto const& a, auto const& b)
+        {
+            return a.filePath < b.filePath;
+        });
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return formatError("raw_fd_ostream(\"{}\") returned \"{}\"", path, ec);
+    llvm::json::OStream J(os, 2);
+    J.object([&]
+    {
+        J.attributeObject("cases", [&]
+        {
+            for(auto const& c : cases)
+            {
+                J.attributeObject(c.filePath, [&]
+                {
+                    J.attribute("ms", std::round(c.milliseconds * 10) / 10);
+                    J.attribute("bytes", static_cast<std::int64_t>(c.bytes));
+                });
+            }
+        });
+    });
+    os << '\n';
+    os.close();
+    if(os.has_error())
+        return formatError("could not write \"{}\": {}",
+            path, os.error().message());
+    return Error::success();
+}
+
+/** Return the cost of each case from a baseline file.
+*/
+Expected<llvm::StringMap<Results::Case>>
+loadBaseline(
+    llvm::StringRef path)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if(! buffer)
+        return formatError("MemoryBuffer::getFile(\"{}\") returned \"{}\"",
+            path, buffer.getError().message());
+    auto json = llvm::json::parse((*buffer)->getBuffer());
+    if(! json)
+        return formatError("could not parse \"{}\": {}",
+            path, llvm::toString(json.takeError()));
+    llvm::StringMap<Results::Case> cases;
+    auto const* obj = json->getAsObject();
+    auto const* list = obj ? obj->getObject("cases") : nullptr;
+    if(! list)
+        return formatError("\"{}\" has no cases", path);
+    for(auto const& kv : *list)
+    {
+        auto const* c = kv.second.getAsObject();
+        if(! c)
+            continue;
+        llvm::StringRef const filePath = kv.first;
+        auto& entry = cases[filePath];
+        entry.filePath = filePath.str();
+        entry.milliseconds = c->getNumber("ms").value_or(0);
+        entry.bytes = static_cast<std::size_t>(
+            c->getInteger("bytes").value_or(0));
+    }
+    return cases;
+}
+
+/** Compare the cost of each case with the baseline.
+
+    The baseline is written instead when it
+    does not exist yet, or when updating.
+
+    @return The number of regressions.
+*/
+std::size_t
+checkPerformance(
+    Results& results)
+{
+    auto const& path = toolArgs.perfBaseline.getValue();
+    auto& os = debug_outs();
+    if( toolArgs.toolAction == Action::update ||
+        ! llvm::sys::fs::exists(path))
+    {
+        if(auto err = writeBaseline(path, results.cases))
+        {
+            reportError(err, "write the performance baseline");
+            results.numberOfErrors++;
+            return 0;
+        }
+        os << "Wrote the performance baseline of " <<
+            results.cases.size() << " cases to " << path << "\n";
+        return 0;
+    }
+
+    auto baseline = loadBaseline(path);
+    if(! baseline)
+    {
+        reportError(baseline.error(), "load the performance baseline");
+        results.numberOfErrors++;
+        return 0;
+    }
+
+    double const limit = 1 + toolArgs.perfThreshold.getValue() / 100.0;
+    std::size_t regressions = 0;
+    auto const report = [&](std::string_view what, std::string const& value,
+        std::string const& base, llvm::StringRef filePath)
+    {
+        ++regressions;
+        auto const text = fmt::format(
+            "\"{}\" regressed: {} {}, baseline {}",
+            filePath, what, value, base);
+        if(toolArgs.perfFail)
+            reportError("{}", text);
+        else
+            reportWarning("{}", text);
+    };
+    for(auto const& c : results.cases)
+    {
+        auto it = baseline->find(c.filePath);
+        if(it == baseline->end())
+            continue;
+        auto const& base = it->second;
+        if( c.milliseconds > base.milliseconds * limit &&
+            c.milliseconds - base.milliseconds >= minRegressionMilliseconds)
+            report("time", fmt::format("{:.1f} ms", c.milliseconds),
+                fmt::format("{:.1f} ms", base.milliseconds), c.filePath);
+        if( c.bytes > base.bytes * limit &&
+            c.bytes - base.bytes >= minRegressionBytes)
+            report("parse memory", fmt::format("{} bytes", c.bytes),
+                fmt::format("{} bytes", base.bytes), c.filePath);
+    }
+    os << "Compared " << results.cases.size() <<
+        " cases with the performance baseline, " <<
+        regressions << " regressions\n";
+    return regressions;
+}
+
 int
 DoTestAction()
 {
@@ -459,8 +1174,30 @@ DoTestAction()
             " in " << ((milli + 500) / 1000) <<
             " seconds\n";
 
+    // the slowest cases are the first to look at
+    // when the suite gets slower
+    if(results.cases.size() > 1)
+    {
+        std::sort(results.cases.begin(), results.cases.end(),
+            [](auto const& a, auto const& b)
+            {
+                return a.milliseconds > b.milliseconds;
+            });
+        std::size_t const n = std::min<std::size_t>(
+            results.cases.size(), 10);
+        os << "Slowest cases:\n";
+        for(std::size_t i = 0; i < n; ++i)
+            os << fmt::format("  {:>10.1f} ms  {}\n",
+                results.cases[i].milliseconds, results.cases[i].filePath);
+    }
+
+    std::size_t regressions = 0;
+    if(! toolArgs.perfBaseline.empty())
+        regressions = checkPerformance(results);
+
     if( results.numberOfFailures > 0 ||
-        results.numberOfErrors > 0)
+        results.numberOfErrors > 0 ||
+        (regressions > 0 && toolArgs.perfFail))
         return EXIT_FAILURE;
     return EXIT_SUCCESS;
 }
@@ -24,6 +24,8 @@ ToolArgs()
     : commonCat("COMMON")
     , generateCat("GENERATE")
     , testCat("TEST")
+    , benchCat("BENCH")
+    , serveCat("SERVE")
 
     , usageText(
 R"( Generate C++ reference documentation
@@ -42,7 +44,22 @@ EXAMPLES:
     mrdox .. ( compile-commands )
     mrdox .. --action ( "test" | "update" ) ( dir | file )...
     mrdox --action test friend.cpp
+    mrdox --action test --perf-baseline perf.json --perf-fail test-files
+    mrdox --action test --compare-engines test-files/old-tests
     mrdox --format adoc compile_commands.json
+    mrdox --format adoc lib/compile_commands.json app/compile_commands.json
+    mrdox --shard 0/4 --output shard0.bin compile_commands.json
+    mrdox --action merge shard0.bin shard1.bin shard2.bin shard3.bin
+    mrdox --action load compile_commands.json
+    mrdox --action bench --bench-namespaces 20 --bench-classes 100
+    mrdox --action bench --bench-micro
+    mrdox --action serve --serve-socket /tmp/mrdox.sock --format adoc compile_commands.json
+    mrdox --action serve --watch --format adoc compile_commands.json
+    mrdox --action serve --http-port 8080 compile_commands.json
+    mrdox --save-snapshot corpus.snap compile_commands.json
+    mrdox --from-snapshot corpus.snap --format adoc
+    mrdox --from-snapshot corpus.snap --lazy-snapshot --format xml
+    mrdox --from-snapshot corpus.snap --save-snapshot corpus.snap compile_commands.json
 )")
 
 //
@@ -56,7 +73,11 @@ EXAMPLES:
     llvm::cl::values(
         clEnumVal(test, "Compare output against expected."),
         clEnumVal(update, "Update all expected xml files."),
-        clEnumVal(generate, "Generate reference documentation.")),
+        clEnumVal(generate, "Generate reference documentation."),
+        clEnumVal(merge, "Generate reference documentation from bitcode shards."),
+        clEnumVal(load, "Load the compilation database and report the time taken."),
+        clEnumVal(bench, "Measure the throughput of each phase on a synthetic corpus."),
+        clEnumVal(serve, "Keep the corpus in memory and regenerate when notified of changed files.")),
     llvm::cl::cat(commonCat))
 
 , addonsDir(
@@ -78,7 +99,7 @@ EXAMPLES:
 , inputPaths(
     "inputs",
     llvm::cl::Sink,
-    llvm::cl::desc("The path to the compilation database, or one or more .cpp files to test."),
+    llvm::cl::desc("The paths to the compilation databases, one or more .cpp files to test, or the bitcode shards to merge."),
     llvm::cl::cat(commonCat))
 
 //
@@ -87,16 +108,56 @@ EXAMPLES:
 
 , formatType(
     "format",
-    llvm::cl::desc("Format for outputted docs (\"adoc\" or \"xml\")."),
+    llvm::cl::desc("Format for outputted docs (\"adoc\" or \"xml\"), or a comma separated list of formats built from one corpus."),
     llvm::cl::init("adoc"),
     llvm::cl::cat(generateCat))
 
+, formatOutputs(
+    "format-output",
+    llvm::cl::desc("Output for one of several formats (\"format=path\"). Otherwise each format is written to a directory of the output named after it."),
+    llvm::cl::cat(generateCat))
+
 , ignoreMappingFailures(
     "ignore-map-errors",
     llvm::cl::desc("Continue if files are not mapped correctly."),
     llvm::cl::init(true),
     llvm::cl::cat(generateCat))
 
+, shard(
+    "shard",
+    llvm::cl::desc("Extract only slice i of N (\"i/N\") and write the bitcode to the output file."),
+    llvm::cl::cat(generateCat))
+
+, saveSnapshot(
+    "save-snapshot",
+    llvm::cl::desc("Write the reduced corpus to a snapshot file before generating."),
+    llvm::cl::cat(generateCat))
+
+, fromSnapshot(
+    "from-snapshot",
+    llvm::cl::desc("Generate from a corpus snapshot. With a compilation database, re-extract only the changed translation units."),
+    llvm::cl::cat(generateCat))
+
+, lazySnapshot(
+    "lazy-snapshot",
+    llvm::cl::desc("Decode the symbols of a snapshot when a generator first uses them. Only applies without a compilation database."),
+    llvm::cl::cat(generateCat))
+
+, stats(
+    "stats",
+    llvm::cl::desc("Report the memory held by the corpus and the peak memory of each phase."),
+    llvm::cl::cat(generateCat))
+
+, tracePath(
+    "trace",
+    llvm::cl::desc("Write Chrome trace events of the translation units, reductions, and pages to a file."),
+    llvm::cl::cat(generateCat))
+
+, metricsPath(
+    "metrics-file",
+    llvm::cl::desc("Write the metrics of the run to a file at exit, as JSON if its extension is \".json\" and in the OpenMetrics text format otherwise."),
+    llvm::cl::cat(generateCat))
+
 //
 // Test options
 //
@@ -106,6 +167,87 @@ EXAMPLES:
     llvm::cl::desc("Write a .bad.xml file for each test failure."),
     llvm::cl::init(true),
     llvm::cl::cat(testCat))
+
+, perfBaseline(
+    "perf-baseline",
+    llvm::cl::desc("Compare the time and parse memory of each case with a baseline file, which is written if it does not exist or when updating. Cases are keyed by their path as given."),
+    llvm::cl::cat(testCat))
+
+, perfThreshold(
+    "perf-threshold",
+    llvm::cl::desc("The percentage above the baseline at which a case has regressed."),
+    llvm::cl::init(50),
+    llvm::cl::cat(testCat))
+
+, perfFail(
+    "perf-fail",
+    llvm::cl::desc("Fail the test action when a case has regressed, instead of warning."),
+    llvm::cl::cat(testCat))
+
+, compareEngines(
+    "compare-engines",
+    llvm::cl::desc("Also render each case as asciidoc with the native template engine and with Handlebars.js, and fail when they differ."),
+    llvm::cl::cat(testCat))
+
+//
+// Bench options
+//
+
+, benchNamespaces(
+    "bench-namespaces",
+    llvm::cl::desc("The number of namespaces, each in its own translation unit."),
+    llvm::cl::init(8),
+    llvm::cl::cat(benchCat))
+
+, benchClasses(
+    "bench-classes",
+    llvm::cl::desc("The number of classes in each namespace."),
+    llvm::cl::init(50),
+    llvm::cl::cat(benchCat))
+
+, benchTemplateDepth(
+    "bench-template-depth",
+    llvm::cl::desc("The depth of the template chain used by each class."),
+    llvm::cl::init(16),
+    llvm::cl::cat(benchCat))
+
+, benchIterations(
+    "bench-iterations",
+    llvm::cl::desc("The number of times each phase is run."),
+    llvm::cl::init(3),
+    llvm::cl::cat(benchCat))
+
+, benchMicro(
+    "bench-micro",
+    llvm::cl::desc("Also measure the hot support components on their own."),
+    llvm::cl::cat(benchCat))
+
+//
+// Serve options
+//
+
+, serveSocket(
+    "serve-socket",
+    llvm::cl::desc("The path of the Unix domain socket on which changed files are reported."),
+    llvm::cl::init("mrdox.sock"),
+    llvm::cl::cat(serveCat))
+
+, watch(
+    "watch",
+    llvm::cl::desc("Watch the inputs and the addons instead of listening on a socket. A template edit only renders the pages again."),
+    llvm::cl::cat(serveCat))
+
+, httpPort(
+    "http-port",
+    llvm::cl::desc("Render the page of a symbol when /symbol/<id> is requested on this port of the loopback interface, instead of generating every page."),
+    llvm::cl::init(0),
+    llvm::cl::cat(serveCat))
+
+, httpCachePages(
+    "http-cache-pages",
+    llvm::cl::desc("The most rendered pages kept in memory by --http-port."),
+    llvm::cl::init(4096),
+    llvm::cl::cat(serveCat))
 {
 }
 
@@ -124,8 +266,29 @@ hideForeignOptions()
         &outputPath,
         std::addressof(inputPaths),
         &formatType,
+        std::addressof(formatOutputs),
         &ignoreMappingFailures,
-        &badOption
+        &shard,
+        &saveSnapshot,
+        &fromSnapshot,
+        &lazySnapshot,
+        &stats,
+        &tracePath,
+        &metricsPath,
+        &badOption,
+        &perfBaseline,
+        &perfThreshold,
+        &perfFail,
+        &compareEngines,
+        &benchNamespaces,
+        &benchClasses,
+        &benchTemplateDepth,
+        &benchIterations,
+        &benchMicro,
+        &serveSocket,
+        &watch,
+        &httpPort,
+        &httpCachePages
     });
 
     // Really hide the clang/llvm default
@@ -21,7 +21,11 @@ enum Action : int
 {
     test,
     update,
-    generate
+    generate,
+    merge,
+    load,
+    bench,
+    serve
 };
 
 /** Command line options and tool settings.
@@ -33,6 +37,8 @@ class ToolArgs
     llvm::cl::OptionCategory    commonCat;
     llvm::cl::OptionCategory    generateCat;
     llvm::cl::OptionCategory    testCat;
+    llvm::cl::OptionCategory    benchCat;
+    llvm::cl::OptionCategory    serveCat;
 
 public:
     static ToolArgs instance_;
@@ -49,10 +55,35 @@ public:
 
     // Generate options
     llvm::cl::opt<std::string>  formatType;
+    llvm::cl::list<std::string> formatOutputs;
     llvm::cl::opt<bool>         ignoreMappingFailures;
+    llvm::cl::opt<std::string>  shard;
+    llvm::cl::opt<std::string>  saveSnapshot;
+    llvm::cl::opt<std::string>  fromSnapshot;
+    llvm::cl::opt<bool>         lazySnapshot;
+    llvm::cl::opt<bool>         stats;
+    llvm::cl::opt<std::string>  tracePath;
+    llvm::cl::opt<std::string>  metricsPath;
 
     // Test options
     llvm::cl::opt<bool>         badOption;
+    llvm::cl::opt<std::string>  perfBaseline;
+    llvm::cl::opt<unsigned>     perfThreshold;
+    llvm::cl::opt<bool>         perfFail;
+    llvm::cl::opt<bool>         compareEngines;
+
+    // Bench options
+    llvm::cl::opt<unsigned>     benchNamespaces;
+    llvm::cl::opt<unsigned>     benchClasses;
+    llvm::cl::opt<unsigned>     benchTemplateDepth;
+    llvm::cl::opt<unsigned>     benchIterations;
+    llvm::cl::opt<bool>         benchMicro;
+
+    // Serve options
+    llvm::cl::opt<std::string>  serveSocket;
+    llvm::cl::opt<bool>         watch;
+    llvm::cl::opt<unsigned>     httpPort;
+    llvm::cl::opt<unsigned>     httpCachePages;
 
     // Hide all options which don't belong to us
     void hideForeignOptions();
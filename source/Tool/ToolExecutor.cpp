@@ -10,13 +10,40 @@
 //
 
 #include "ToolExecutor.hpp"
+#include "Tool/CachingFileSystem.hpp"
+#include "Tool/ConfigImpl.hpp"
+#include "Tool/IncludeScanner.hpp"
+#include "Tool/JumboDatabase.hpp"
+#include "Tool/MemoryGovernor.hpp"
+#include "Tool/ModuleCache.hpp"
+#include "Tool/PCHCache.hpp"
+#include "Tool/StreamingReducer.hpp"
+#include "Tool/TUCache.hpp"
+#include "AST/Bitcode.hpp"
+#include "Support/Memory.hpp"
+#include "Support/Metrics.hpp"
+#include "Support/Progress.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Support/Error.hpp>
+#include <mrdox/Support/Path.hpp>
 #include <mrdox/Support/ThreadPool.hpp>
 #include <clang/Tooling/ToolExecutorPluginRegistry.h>
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/Regex.h>
 #include <llvm/Support/ThreadPool.h>
 #include <llvm/Support/Threading.h>
 #include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/StringSaver.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
 
 namespace clang {
 namespace mrdox {
@@ -43,35 +70,275 @@ getDefaultArgumentsAdjusters()
 
 //------------------------------------------------
 
+/** Tool results divided into shards.
+
+    Each thread appends to its own shard, so that
+    reporting a result never contends with other
+    threads. The shards are only combined when the
+    results are enumerated, after extraction.
+
+    When a spill directory is set, results beyond
+    the memory threshold are appended to a segment
+    file per shard instead. The segments are mapped
+    when the results are enumerated, so the values
+    are returned without copying.
+*/
 class ThreadSafeToolResults : public tooling::ToolResults
 {
 public:
+    struct ShardStats
+    {
+        std::size_t results = 0;
+        std::size_t bytes = 0;
+        std::size_t spilledBytes = 0;
+    };
+
+    ThreadSafeToolResults() = default;
+
+    ThreadSafeToolResults(
+        std::string spillDir,
+        std::size_t threshold)
+        : spillDir_(std::move(spillDir))
+        , threshold_(threshold)
+    {
+    }
+
+    ~ThreadSafeToolResults()
+    {
+        for(auto& shard : shards_)
+            if(! shard.SpillPath.empty())
+                llvm::sys::fs::remove(shard.SpillPath);
+    }
+
     void addResult(StringRef Key, StringRef Value) override
     {
-        std::unique_lock<std::mutex> LockGuard(Mutex);
-        Results.addResult(Key, Value);
+        Shard& shard = shards_[shardIndex()];
+        std::unique_lock<std::mutex> LockGuard(shard.Mutex);
+        if(! spillDir_.empty() &&
+            totalBytes_.fetch_add(Value.size()) >= threshold_ &&
+            spill(shard, Key, Value))
+            return;
+        shard.KVResults.emplace_back(
+            shard.Strings.save(Key),
+            shard.Strings.save(Value));
+        shard.Bytes += Key.size() + Value.size();
     }
 
     std::vector<std::pair<
         llvm::StringRef, llvm::StringRef>>
     AllKVResults() override
     {
-        return Results.AllKVResults();
+        std::vector<std::pair<
+            llvm::StringRef, llvm::StringRef>> result;
+        forEachResult(
+            [&](StringRef Key, StringRef Value)
+            {
+                result.emplace_back(Key, Value);
+            });
+        return result;
     }
 
     void forEachResult(llvm::function_ref<
         void(StringRef Key, StringRef Value)> Callback) override
     {
-        Results.forEachResult(Callback);
+        for(auto& shard : shards_)
+        {
+            for(auto const& kv : shard.KVResults)
+                Callback(kv.first, kv.second);
+            if(! mapSpill(shard))
+                continue;
+            StringRef const data = shard.Mapped->getBuffer();
+            for(auto const& e : shard.SpillIndex)
+                Callback(e.Key, data.substr(e.Offset, e.Size));
+        }
+    }
+
+    /** Return the number of results and bytes in each used shard.
+    */
+    std::vector<ShardStats>
+    stats() const
+    {
+        std::vector<ShardStats> result;
+        for(auto const& shard : shards_)
+            if(! shard.KVResults.empty() || ! shard.SpillIndex.empty())
+                result.push_back({
+                    shard.KVResults.size() + shard.SpillIndex.size(),
+                    shard.Bytes, shard.SpilledBytes });
+        return result;
     }
 
 private:
-    tooling::InMemoryToolResults Results;
-    std::mutex Mutex;
+    static constexpr std::size_t NumShards = 64;
+
+    struct SpillEntry
+    {
+        StringRef Key;
+        std::uint64_t Offset;
+        std::size_t Size;
+    };
+
+    struct Shard
+    {
+        std::mutex Mutex;
+        llvm::BumpPtrAllocator Arena;
+        llvm::UniqueStringSaver Strings{Arena};
+        std::vector<std::pair<
+            llvm::StringRef, llvm::StringRef>> KVResults;
+        std::size_t Bytes = 0;
+
+        std::string SpillPath;
+        std::unique_ptr<llvm::raw_fd_ostream> Spill;
+        std::vector<SpillEntry> SpillIndex;
+        std::unique_ptr<llvm::MemoryBuffer> Mapped;
+        std::size_t SpilledBytes = 0;
+        bool SpillFailed = false;
+    };
+
+    // Append a value to the segment file of a shard.
+    // Returns false if the value must be kept in memory.
+    bool
+    spill(
+        Shard& shard,
+        StringRef Key,
+        StringRef Value)
+    {
+        if(shard.SpillFailed || shard.Mapped)
+            return false;
+        if(! shard.Spill)
+        {
+            int fd;
+            llvm::SmallString<256> path;
+            if(auto ec = llvm::sys::fs::createUniqueFile(
+                    files::appendPath(spillDir_, "mrdox-%%%%%%%%.seg"),
+                    fd, path))
+            {
+                // keep this shard in memory
+                reportWarning("Could not create a segment file in \"{}\": {}",
+                    spillDir_, ec.message());
+                shard.SpillFailed = true;
+                return false;
+            }
+            shard.SpillPath = std::string(path.str());
+            shard.Spill = std::make_unique<llvm::raw_fd_ostream>(fd, true);
+        }
+        shard.SpillIndex.push_back({
+            shard.Strings.save(Key), shard.Spill->tell(), Value.size() });
+        shard.Spill->write(Value.data(), Value.size());
+        shard.SpilledBytes += Value.size();
+        return true;
+    }
+
+    // Map the segment file of a shard, once writing is done.
+    bool
+    mapSpill(
+        Shard& shard)
+    {
+        if(shard.SpillIndex.empty())
+            return false;
+        if(shard.Spill)
+        {
+            shard.Spill->close();
+            shard.Spill.reset();
+            auto buf = llvm::MemoryBuffer::getFile(
+                shard.SpillPath, false, false, false);
+            if(! buf)
+            {
+                reportError("Could not map \"{}\": {}",
+                    shard.SpillPath, buf.getError().message());
+                shard.SpillIndex.clear();
+                return false;
+            }
+            shard.Mapped = std::move(*buf);
+        }
+        return shard.Mapped != nullptr;
+    }
+
+    // Threads are assigned shards in turn, so the
+    // lock is uncontended up to NumShards threads.
+    std::size_t
+    shardIndex() noexcept
+    {
+        thread_local std::size_t const index =
+            nextShard_++ % NumShards;
+        return index;
+    }
+
+    static inline std::atomic<std::size_t> nextShard_ = 0;
+    std::array<Shard, NumShards> shards_;
+    std::string spillDir_;
+    std::size_t threshold_ = 0;
+    std::atomic<std::size_t> totalBytes_ = 0;
 };
 
 //------------------------------------------------
 
+/** Return the parse times recorded by a previous run.
+
+    Each line holds the number of milliseconds,
+    a tab, and the path of the translation unit.
+*/
+llvm::StringMap<double>
+loadTimings(
+    std::string const& path)
+{
+    llvm::StringMap<double> result;
+    auto buf = llvm::MemoryBuffer::getFile(path);
+    if(! buf)
+        return result;
+    llvm::SmallVector<llvm::StringRef> lines;
+    (*buf)->getBuffer().split(lines, '\n', -1, false);
+    for(auto line : lines)
+    {
+        auto [ms, file] = line.split('\t');
+        double value;
+        if(file.empty() || ms.getAsDouble(value))
+            continue;
+        result[file] = value;
+    }
+    return result;
+}
+
+void
+saveTimings(
+    std::string const& path,
+    llvm::StringMap<double> const& timings)
+{
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec);
+    if(ec)
+        return;
+    for(auto const& kv : timings)
+        os << llvm::format("%.1f", kv.second) << '\t' << kv.first() << '\n';
+}
+
+/** Return the estimated cost of a translation unit.
+
+    The parse time of the previous run is used
+    when available. Otherwise the file size is
+    used, with the sizes of the files it includes
+    when they were scanned, scaled to be roughly
+    comparable.
+*/
+double
+estimateCost(
+    std::string const& file,
+    llvm::StringMap<double> const& timings,
+    IncludeScanner const* includes)
+{
+    auto it = timings.find(file);
+    if(it != timings.end())
+        return it->second;
+    std::uint64_t size = 0;
+    if(includes && includes->contains(file))
+        size = includes->bytes(file);
+    else if(llvm::sys::fs::file_size(file, size))
+        return 0;
+    // VFALCO roughly one millisecond per kilobyte
+    return static_cast<double>(size) / 1024;
+}
+
+//------------------------------------------------
+
 } // (anon)
 
 ToolExecutor::
@@ -81,9 +348,16 @@ ToolExecutor(
     std::shared_ptr<PCHContainerOperations> PCHContainerOps)
     : config_(config)
     , Compilations(Compilations)
-    , Results(new ThreadSafeToolResults)
+    , PCHContainerOps(std::move(PCHContainerOps))
+    , Results(static_cast<ConfigImpl const&>(config).streamingReduce_
+        ? static_cast<tooling::ToolResults*>(new StreamingReducer)
+        : new ThreadSafeToolResults(
+            static_cast<ConfigImpl const&>(config).spillDir_,
+            static_cast<ConfigImpl const&>(config).spillThreshold_ << 20))
     , Context(Results.get())
 {
+    if(static_cast<ConfigImpl const&>(config).streamingReduce_)
+        reducer_ = static_cast<StreamingReducer*>(Results.get());
 }
 
 llvm::Error
@@ -108,63 +382,492 @@ execute(
         ErrorMsg += Err.str();
     };
 
-    auto Log = [&](llvm::Twine Msg)
-    {
-        std::unique_lock<std::mutex> LockGuard(TUMutex);
-        llvm::errs() << Msg.str() << "\n";
-    };
-
     // Get a copy of the filename strings
     std::vector<std::string> Files = Compilations.getAllFiles();
 
-    // Add a counter to track the progress.
+    // Keep only our slice when extraction is
+    // distributed. The order of the database
+    // is the same for every shard.
+    if(shardCount_ > 1)
+    {
+        std::vector<std::string> Slice;
+        for(std::size_t i = shardIndex_; i < Files.size(); i += shardCount_)
+            Slice.emplace_back(std::move(Files[i]));
+        Files = std::move(Slice);
+    }
+
+    // Drop the translation units excluded by the
+    // configuration before any of them are parsed.
+    auto const& config = static_cast<ConfigImpl const&>(config_);
+    auto const NumFiles = Files.size();
+    std::erase_if(Files,
+        [&](std::string const& File)
+        {
+            // generated translation units are always visited
+            return ! OverlayFiles.count(File) &&
+                ! config.shouldVisitTU(files::makePosixStyle(File));
+        });
+    if(config_.verboseOutput && Files.size() != NumFiles)
+        reportInfo("Skipped {} of {} translation units",
+            NumFiles - Files.size(), NumFiles);
+    setMetric("mrdox_translation_units", Files.size());
+    setMetric("mrdox_translation_units_skipped", NumFiles - Files.size());
+    if(Files.empty())
+        return llvm::Error::success();
+
+    auto const& Action = Actions.front();
+
+    // The same adjustments as ClangTool makes,
+    // so that keys reflect the actual command.
+    auto const Adjuster = Action.second
+        ? tooling::combineAdjusters(
+            Action.second, getDefaultArgumentsAdjusters())
+        : getDefaultArgumentsAdjusters();
+
+    // The headers of each translation unit are
+    // found without parsing them, to plan the run.
+    std::optional<IncludeScanner> Includes;
+    if(config.scanIncludes_)
+    {
+        Includes.emplace(config.cacheDir());
+        Includes->scan(Compilations, Files, Adjuster,
+            config_.threadPool(), config_.verboseOutput);
+        setMetric("mrdox_include_scan_hits", Includes->hits());
+        setMetric("mrdox_include_scan_misses", Includes->misses());
+    }
+
+    // Past the deadline, the translation units
+    // which were not extracted are left out,
+    // and the output is built from the rest.
+    if(config.deadline_ != 0)
+        Context.setDeadline(std::chrono::steady_clock::now() +
+            std::chrono::seconds(config.deadline_));
+    std::atomic<std::size_t> PastDeadline = 0;
+    std::atomic<std::size_t> TimedOut = 0;
+
+    // Count the translation units as they start
+    // and finish, without taking a lock.
     auto const TotalNumStr = std::to_string(Files.size());
-    unsigned Counter = 0;
+    std::atomic<std::size_t> Counter = 0;
     auto Count = [&]()
     {
-        std::unique_lock<std::mutex> LockGuard(TUMutex);
-        return ++Counter;
+        return Counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    };
+    std::function<void(std::size_t, std::size_t)> OnParsed;
+    if(options_ && options_->progress)
+        OnParsed = [this](std::size_t Done, std::size_t Total)
+        {
+            options_->progress("parse", Done, Total);
+        };
+    std::optional<Progress> Parsing;
+    Parsing.emplace("Parsing", Files.size(),
+        config_.progress, &Context.bitcodeBytes(),
+        std::move(OnParsed));
+    auto Log = [&](llvm::Twine const& Msg)
+    {
+        Parsing->log(Msg);
     };
 
-    auto const& Action = Actions.front();
+    // Submit the most expensive translation units first,
+    // so that a few large ones do not stretch the tail
+    // of the run while the other threads sit idle.
+    std::string TimingsPath;
+    if(! config.cacheDir().empty())
+        TimingsPath = files::appendPath(config.cacheDir(), "timings.txt");
+    llvm::StringMap<double> Timings;
+    if(! TimingsPath.empty())
+        Timings = loadTimings(TimingsPath);
+    llvm::StringMap<double> FileCosts;
+    double AverageCost = 0;
+    {
+        std::vector<std::pair<double, std::string>> Costs;
+        Costs.reserve(Files.size());
+        double Total = 0;
+        for(auto& File : Files)
+        {
+            double Cost = estimateCost(File, Timings,
+                Includes ? &*Includes : nullptr);
+            Total += Cost;
+            FileCosts[File] = Cost;
+            Costs.emplace_back(Cost, std::move(File));
+        }
+        std::stable_sort(Costs.begin(), Costs.end(),
+            [](auto const& a, auto const& b)
+            {
+                return a.first > b.first;
+            });
+        Files.clear();
+        for(auto& Cost : Costs)
+            Files.emplace_back(std::move(Cost.second));
+        AverageCost = Total / Costs.size();
+        if(config_.verboseOutput)
+        {
+            // no schedule can finish faster than the
+            // largest TU or the evenly divided total
+            auto const Threads = std::max<std::size_t>(
+                config_.threadPool().getThreadCount(), 1);
+            reportInfo("Estimated critical path: {:.1f} (largest {:.1f}, total {:.1f}, threads {})",
+                std::max(Costs.front().first, Total / Threads),
+                Costs.front().first, Total, Threads);
+        }
+    }
+    llvm::StringMap<double> NewTimings;
+
+    // With a memory budget, translation units are
+    // admitted by the memory recorded by the last
+    // run, in megabytes. Unknown ones are given the
+    // average, or else an even share of the budget.
+    std::optional<MemoryGovernor> Governor;
+    std::string MemoryPath;
+    llvm::StringMap<double> Memory;
+    llvm::StringMap<double> NewMemory;
+    double DefaultMemory = 0;
+    if(config.memoryBudget_ != 0)
+    {
+        Governor.emplace(config.memoryBudget_ << 20);
+        if(! config.cacheDir().empty())
+        {
+            MemoryPath = files::appendPath(config.cacheDir(), "memory.txt");
+            Memory = loadTimings(MemoryPath);
+        }
+        for(auto const& kv : Memory)
+            DefaultMemory += kv.second;
+        if(! Memory.empty())
+            DefaultMemory /= Memory.size();
+        else
+            DefaultMemory = static_cast<double>(config.memoryBudget_) /
+                std::max<std::size_t>(config_.threadPool().getThreadCount(), 1);
+    }
+    auto const estimateMemory =
+    [&](std::string const& Path) -> std::size_t
+    {
+        auto const it = Memory.find(Path);
+        double const MB = it != Memory.end() ? it->second : DefaultMemory;
+        return static_cast<std::size_t>(MB * (1 << 20));
+    };
+
+    // Headers are read once for the whole run,
+    // or for every run sharing the caller's cache
+    std::optional<SharedFileCache> OwnFileCache;
+    if(! fileCache_)
+        OwnFileCache.emplace();
+    SharedFileCache& FileCache = fileCache_ ? *fileCache_ : *OwnFileCache;
+
+    // Results of unchanged translation units
+    // are replayed from the cache, if enabled.
+    // The remote cache is shared by every
+    // machine which builds the same inputs.
+    std::shared_ptr<RemoteCache> Remote;
+    if(! config.remoteCache_.empty())
+    {
+        auto remote = RemoteCache::create(
+            config.remoteCache_, config.remoteCacheUpload_);
+        if(! remote)
+            return make_string_error(remote.error().message());
+        Remote = std::move(*remote);
+    }
+    std::unique_ptr<TUCache> OwnedCache;
+    TUCache* Cache = tuCache_;
+    if(! Cache && (! config.cacheDir().empty() || Remote))
+    {
+        OwnedCache = std::make_unique<TUCache>(config.cacheDir());
+        Cache = OwnedCache.get();
+    }
+    if(Cache)
+        Cache->setRemote(Remote);
+    Context.setCache(Cache);
+
+    // The interface of each named module is built
+    // once, and its declarations are extracted from
+    // the interface rather than from every importer.
+    ModuleCache Modules(config.cacheDir());
+    Modules.build(Compilations, Files, Adjuster,
+        config_.threadPool(), config_.verboseOutput);
+    Context.setModuleInterfaces(Modules.interfaces());
+
+    // The commands of the jumbo units, and
+    // of the files which are not in one.
+    JumboDatabase Jumbo(Compilations);
+
+    // Results depend on the configuration too, such
+    // as the source root which names their files.
+    auto const ExtractionOptions = config.extractionOptions();
+    auto const getCacheKey =
+    [&](std::string const& Path) -> std::string
+    {
+        auto Commands = Jumbo.getCompileCommands(Path);
+        if(Commands.size() != 1)
+            return {};
+        auto& Cmd = Commands.front();
+        Cmd.CommandLine = Adjuster(Cmd.CommandLine, Cmd.Filename);
+        // the interfaces are named by their contents,
+        // wherever their directory is
+        for(llvm::StringRef Flag : Modules.flags(Path))
+        {
+            auto const Dir = Flag.rfind('=') + 1;
+            Cmd.CommandLine.push_back((llvm::Twine(Flag.take_front(Dir)) +
+                llvm::sys::path::filename(Flag.drop_front(Dir))).str());
+        }
+        return TUCache::makeKey(Cmd, ExtractionOptions);
+    };
+
+    // Translation units sharing a preamble
+    // reuse one precompiled header.
+    std::optional<PCHCache> Preambles;
+    if(config.usePCH_)
+    {
+        Preambles.emplace(config.cacheDir());
+        Preambles->build(Compilations, Files, Adjuster,
+            config_.threadPool(), config_.verboseOutput);
+    }
+
+    // Small translation units with the same
+    // command are parsed together, so that the
+    // headers they share are parsed once. A
+    // unit which fails is parsed file by file.
+    if(config.jumboSize_ > 1 && Modules.interfaces().empty())
+    {
+        auto const NumUnits = Files.size();
+        // with their headers known, files which
+        // include the same headers are grouped,
+        // leaving the others in the same order
+        if(Includes)
+        {
+            std::vector<std::size_t> Scanned;
+            for(std::size_t i = 0; i < Files.size(); ++i)
+                if(Includes->contains(Files[i]))
+                    Scanned.push_back(i);
+            std::vector<std::string> Sorted;
+            for(auto i : Scanned)
+                Sorted.push_back(std::move(Files[i]));
+            std::stable_sort(Sorted.begin(), Sorted.end(),
+                [&](std::string const& a, std::string const& b)
+                {
+                    auto const A = Includes->includes(a);
+                    auto const B = Includes->includes(b);
+                    return std::lexicographical_compare(
+                        A.begin(), A.end(), B.begin(), B.end());
+                });
+            for(std::size_t k = 0; k < Scanned.size(); ++k)
+                Files[Scanned[k]] = std::move(Sorted[k]);
+        }
+        Jumbo.group(Files, config.jumboSize_,
+            [&](std::string const& File)
+            {
+                return ! OverlayFiles.count(File) &&
+                    FileCosts.lookup(File) <= AverageCost;
+            }, Adjuster);
+        if(config_.verboseOutput && Files.size() != NumUnits)
+            reportInfo("Grouped {} translation units into {}",
+                NumUnits, Files.size());
+    }
+    std::atomic<std::size_t> Fallbacks = 0;
 
     auto const processFile =
-    [&](std::string Path)
+    [&](std::string Path) -> std::vector<std::string>
     {
+        TraceScope Trace("translation unit", Path);
+        MRDOX_PROFILE_ZONE_TEXT("processFile", Path);
+        auto const Members = Jumbo.members(Path);
+        std::size_t const Units = Members.empty() ? 1 : Members.size();
+        // a stopped build skips the units not yet started
+        if(options_ && options_->stop.stop_requested())
+        {
+            Parsing->add(Units);
+            return {};
+        }
+        std::string Key;
+        if(Cache)
+        {
+            Key = getCacheKey(Path);
+            if(! Key.empty())
+            {
+                if(auto Entry = Cache->load(Key))
+                {
+                    if(config_.verboseOutput)
+                        Log("[" + std::to_string(Count()) + "/" + TotalNumStr + "] Cached file " + Path);
+                    if(! Entry->bitcodes.empty())
+                    {
+                        replayed_.store(true, std::memory_order_relaxed);
+                        Context.reportBitcodeBytes(Entry->bitcodes.size());
+                        insertBitcodes(Context, Path,
+                            std::move(Entry->bitcodes));
+                    }
+                    Parsing->add(Units);
+                    return {};
+                }
+            }
+        }
+
+        if(std::chrono::steady_clock::now() >= Context.deadline())
+        {
+            PastDeadline += Units;
+            Parsing->add(Units);
+            return {};
+        }
+
         if(config_.verboseOutput)
             Log("[" + std::to_string(Count()) + "/" + TotalNumStr + "] Processing file " + Path);
 
         // Each thread gets an independent copy of a VFS to allow different
-        // concurrent working directories.
+        // concurrent working directories. Stat results and file buffers
+        // are shared by all of them. Lookups which find nothing
+        // are recorded so a cached result notices new headers.
+        llvm::StringSet<> Missing;
         IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS =
-            llvm::vfs::createPhysicalFileSystem();
+            createCachingFileSystem(FileCache, Cache ? &Missing : nullptr);
+
+        auto const runTool =
+        [&](std::string_view PCH)
+        {
+            tooling::ClangTool Tool( Jumbo, { Path },
+                PCHContainerOps, FS);
+            Tool.appendArgumentsAdjuster(Action.second);
+            Tool.appendArgumentsAdjuster(getDefaultArgumentsAdjusters());
+            if(! PCH.empty())
+                Tool.appendArgumentsAdjuster(
+                    tooling::getInsertArgumentAdjuster(
+                        { "-include-pch", std::string(PCH) },
+                        tooling::ArgumentInsertPosition::BEGIN));
+            if(auto Flags = Modules.flags(Path); ! Flags.empty())
+                Tool.appendArgumentsAdjuster(
+                    tooling::getInsertArgumentAdjuster(
+                        std::move(Flags),
+                        tooling::ArgumentInsertPosition::BEGIN));
+
+            for (const auto& FileAndContent : OverlayFiles)
+                Tool.mapVirtualFile(FileAndContent.first(),
+                    FileAndContent.second);
 
-        tooling::ClangTool Tool( Compilations, { Path },
-            std::make_shared<PCHContainerOperations>(), FS);
-        Tool.appendArgumentsAdjuster(Action.second);
-        Tool.appendArgumentsAdjuster(getDefaultArgumentsAdjusters());
+            // the members are parsed again when the
+            // unit fails, and report their own errors
+            IgnoringDiagConsumer IgnoreDiags;
+            if(! Members.empty())
+            {
+                Tool.mapVirtualFile(Path, Jumbo.text(Path));
+                Tool.setDiagnosticConsumer(&IgnoreDiags);
+            }
+
+            return Tool.run(Action.first.get()) != 0;
+        };
+
+        std::string_view PCH;
+        if(Preambles && Members.empty())
+            PCH = Preambles->find(Path);
+
+        // a failed unit still counts as finished
+        auto Finished = llvm::make_scope_exit(
+            [&]
+            {
+                Parsing->add(Units);
+            });
 
-        for (const auto& FileAndContent : OverlayFiles)
-            Tool.mapVirtualFile(FileAndContent.first(),
-                FileAndContent.second);
+        std::size_t const Reserved = Governor ? estimateMemory(Path) : 0;
+        if(Governor)
+            Governor->acquire(Reserved);
+        auto Release = llvm::make_scope_exit(
+            [&]
+            {
+                if(Governor)
+                    Governor->release(Reserved);
+            });
+        auto const Start = std::chrono::steady_clock::now();
+        bool Failed = runTool(PCH);
+        if(Failed && Context.timedOut(Path))
+        {
+            // the visitor reported it, and its
+            // results were not kept
+            ++TimedOut;
+            if(Cache)
+                Cache->claim(Path);
+            return {};
+        }
+        if(Failed && ! PCH.empty())
+        {
+            // a stale or incompatible precompiled
+            // header should not fail the build
+            if(Cache)
+                Cache->claim(Path);
+            Failed = runTool({});
+            PCH = {};
+        }
+        if(Failed && ! Members.empty())
+        {
+            // the members conflict with each other
+            if(Cache)
+                Cache->claim(Path);
+            ++Fallbacks;
+            Finished.release();
+            return { Members.begin(), Members.end() };
+        }
+        if(Governor)
+        {
+            Release.release();
+            Governor->release(Reserved);
+            if(std::size_t const Bytes = takeTranslationUnitBytes();
+                Bytes != 0 && ! MemoryPath.empty() && Members.empty())
+            {
+                std::unique_lock<std::mutex> LockGuard(TUMutex);
+                NewMemory[Path] = static_cast<double>(Bytes) / (1 << 20);
+            }
+        }
+        if(! TimingsPath.empty() && Members.empty())
+        {
+            std::chrono::duration<double, std::milli> const Elapsed =
+                std::chrono::steady_clock::now() - Start;
+            std::unique_lock<std::mutex> LockGuard(TUMutex);
+            NewTimings[Path] = Elapsed.count();
+        }
 
         // VFALCO This needs to be tested
-        if (Tool.run(Action.first.get()))
+        if (Failed)
+        {
             AppendError(llvm::Twine("Failed to run action on ") + Path + "\n");
+            addMetric("mrdox_translation_units_failed", 1);
+            if(Cache)
+                Cache->claim(Path);
+            return {};
+        }
+
+        if(! Cache)
+            return {};
+        // An unclaimed or unkeyed translation
+        // unit is simply not cached.
+        // Files read through a precompiled header are
+        // not all visible to the visitor, so those
+        // translation units are not cached.
+        auto Entry = Cache->claim(Path);
+        if(! Entry || Key.empty() || ! PCH.empty())
+            return {};
+        for(auto const& Name : Missing.keys())
+            Entry->missing.emplace_back(Name);
+        llvm::sort(Entry->missing);
+        if(auto err = Cache->store(Key, *Entry))
+            reportWarning("Could not cache \"{}\": {}", Path, err.message());
+        return {};
+    };
+    auto const processUnit =
+    [&](std::string Path)
+    {
+        for(auto& Member : processFile(std::move(Path)))
+            processFile(std::move(Member));
     };
 
     // Run the action on all files in the database
     std::vector<Error> errors;
     if(Files.size() > 1)
     {
-        TaskGroup taskGroup(config_.threadPool());
+        // parsing yields to the work of later
+        // stages, which releases memory
+        TaskGroup taskGroup(config_.threadPool(),
+            ThreadPool::Priority::Low);
         // VFALCO is File move-constructed?
         for(std::string File : std::move(Files))
         {
             taskGroup.async(
             [&, Path = std::move(File)]()
             {
-                processFile(std::move(Path));
+                processUnit(std::move(Path));
             });
         }
         errors = taskGroup.wait();
@@ -173,7 +876,7 @@ execute(
     {
         try
         {
-            processFile(std::move(Files.front()));
+            processUnit(std::move(Files.front()));
         }
         catch(Exception const& ex)
         {
@@ -181,9 +884,75 @@ execute(
         }
     }
 
+    Context.setCache(nullptr);
+    Parsing.reset();
+
+    setMetric("mrdox_translation_units_timed_out", TimedOut.load());
+    setMetric("mrdox_jumbo_fallbacks", Fallbacks.load());
+    setMetric("mrdox_translation_units_past_deadline", PastDeadline.load());
+    if(TimedOut != 0)
+        reportWarning("Gave up on {} translation units which ran out of time",
+            TimedOut.load());
+    if(PastDeadline != 0)
+        reportWarning("The deadline of {} seconds passed, and {} of {} "
+            "translation units were not extracted",
+            config.deadline_, PastDeadline.load(), TotalNumStr);
+
+    // Keep the old estimates of translation
+    // units which were not parsed this time.
+    if(! TimingsPath.empty() && ! NewTimings.empty())
+    {
+        for(auto const& kv : NewTimings)
+            Timings[kv.first()] = kv.second;
+        saveTimings(TimingsPath, Timings);
+    }
+    if(! MemoryPath.empty() && ! NewMemory.empty())
+    {
+        for(auto const& kv : NewMemory)
+            Memory[kv.first()] = kv.second;
+        saveTimings(MemoryPath, Memory);
+    }
+    if(! config.tuStats_.empty())
+    {
+        if(auto err = writeTUStats(config.tuStats_, Context.takeTUStats()))
+            reportWarning("Could not write the translation unit stats: {}", err.message());
+    }
+
+    Context.recordMetrics();
+    if(Cache)
+    {
+        setMetric("mrdox_tu_cache_hits", Cache->hits());
+        setMetric("mrdox_tu_cache_misses", Cache->misses());
+    }
+    if(Remote)
+    {
+        setMetric("mrdox_remote_cache_hits", Remote->hits());
+        setMetric("mrdox_remote_cache_misses", Remote->misses());
+        setMetric("mrdox_remote_cache_uploads", Remote->uploads());
+    }
+
     // Report warning and error totals
     if(config_.verboseOutput)
+    {
         Context.reportEnd();
+        if(Cache)
+            reportInfo("Translation unit cache: {} hits, {} misses",
+                Cache->hits(), Cache->misses());
+        if(Remote)
+            reportInfo("Remote cache: {} hits, {} misses, {} uploads",
+                Remote->hits(), Remote->misses(), Remote->uploads());
+        if(Governor)
+            reportInfo("Memory budget: {} translation units waited",
+                Governor->waits());
+        if(! reducer_)
+        {
+            auto const Stats = static_cast<
+                ThreadSafeToolResults&>(*Results).stats();
+            for(std::size_t i = 0; i < Stats.size(); ++i)
+                reportInfo("Results shard {}: {} results, {} bytes, {} bytes spilled",
+                    i, Stats[i].results, Stats[i].bytes, Stats[i].spilledBytes);
+        }
+    }
 
     if(! errors.empty())
         reportError(errors, "Could not run the tool executor");
@@ -13,16 +13,22 @@
 #define MRDOX_TOOL_TOOL_TOOLEXECUTOR_HPP
 
 #include "ExecutionContext.hpp"
+#include <mrdox/BuildCorpus.hpp>
 #include <mrdox/Config.hpp>
 #include <clang/Tooling/ArgumentsAdjusters.h>
 #include <clang/Tooling/Execution.h>
 #include <llvm/ADT/SmallString.h>
 #include <llvm/Support/Mutex.h>
+#include <atomic>
 #include <optional>
 
 namespace clang {
 namespace mrdox {
 
+class SharedFileCache;
+class StreamingReducer;
+class TUCache;
+
 /** A custom tool executor to run a front-end action.
 
     This tool executor permits running one action
@@ -68,6 +74,103 @@ public:
         return Results.get();
     }
 
+    /** Process only one slice of the translation units.
+
+        The files of the compilation database are
+        divided into `count` slices, and only the
+        slice at `index` is processed.
+    */
+    void
+    setShard(
+        std::size_t index,
+        std::size_t count) noexcept
+    {
+        shardIndex_ = index;
+        shardCount_ = count;
+    }
+
+    /** Use a translation unit cache owned by the caller.
+
+        This replaces the cache made from the
+        configured cache directory, so results kept
+        by the cache can be read after execution.
+    */
+    void
+    setTUCache(
+        TUCache* cache) noexcept
+    {
+        tuCache_ = cache;
+    }
+
+    /** Use a file cache owned by the caller.
+
+        Stat results and buffers are then kept
+        across executions, so running many small
+        translation units one executor at a time
+        reads the builtin and system headers once.
+    */
+    void
+    setFileCache(
+        SharedFileCache* cache) noexcept
+    {
+        fileCache_ = cache;
+    }
+
+    /** Extract only the parts of the metadata a generator reads.
+    */
+    void
+    setFacets(
+        MetadataFacets facets) noexcept
+    {
+        Context.setFacets(facets);
+    }
+
+    /** Use the options of a build in this process.
+
+        The progress of parsing is reported, and
+        translation units are skipped once a stop
+        is requested. The options must outlive
+        the executor.
+    */
+    void
+    setBuildOptions(
+        BuildOptions const* options) noexcept
+    {
+        options_ = options;
+    }
+
+    /** Return the options of the build, or nullptr.
+    */
+    BuildOptions const*
+    buildOptions() const noexcept
+    {
+        return options_;
+    }
+
+    /** Return the streaming reducer, or nullptr if not in use.
+
+        When the configuration enables streaming
+        reduction, results are merged as they are
+        reported and no bitcode is kept.
+    */
+    StreamingReducer*
+    reducer() const noexcept
+    {
+        return reducer_;
+    }
+
+    /** Return true if every result was extracted in this process.
+
+        Results replayed from the cache were
+        read from files, and their bitcode is
+        decoded with every check.
+    */
+    bool
+    trustedResults() const noexcept
+    {
+        return ! replayed_.load(std::memory_order_relaxed);
+    }
+
     void
     mapVirtualFile(
         StringRef FilePath,
@@ -79,9 +182,17 @@ public:
 private:
     Config const& config_;
     tooling::CompilationDatabase const& Compilations;
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps;
     std::unique_ptr<tooling::ToolResults> Results;
     llvm::StringMap<std::string> OverlayFiles;
     ExecutionContext Context;
+    StreamingReducer* reducer_ = nullptr;
+    std::atomic<bool> replayed_ = false;
+    TUCache* tuCache_ = nullptr;
+    SharedFileCache* fileCache_ = nullptr;
+    BuildOptions const* options_ = nullptr;
+    std::size_t shardIndex_ = 0;
+    std::size_t shardCount_ = 1;
 };
 
 } // mrdox
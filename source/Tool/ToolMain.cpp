@@ -34,9 +34,12 @@
 
 #include "ToolArgs.hpp"
 #include "Support/Debug.hpp"
+#include "Support/Metrics.hpp"
+#include "Support/Trace.hpp"
 #include <mrdox/Support/Error.hpp>
 #include <mrdox/Support/Path.hpp>
 #include <mrdox/Version.hpp>
+#include <llvm/ADT/ScopeExit.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Process.h>
 #include <llvm/Support/raw_ostream.h>
@@ -51,6 +54,10 @@ namespace mrdox {
 
 extern int DoTestAction();
 extern Error DoGenerateAction();
+extern Error DoMergeAction();
+extern Error DoLoadAction();
+extern Error DoBenchAction();
+extern Error DoServeAction();
 
 void
 print_version(llvm::raw_ostream& os)
@@ -61,6 +68,79 @@ print_version(llvm::raw_ostream& os)
        << "\n    built with LLVM " << LLVM_VERSION_STRING;
 }
 
+namespace {
+
+/** Run the action chosen on the command line.
+*/
+int
+runAction()
+{
+    // Generate
+    if(toolArgs.toolAction == Action::generate)
+    {
+        auto err = DoGenerateAction();
+        if(err)
+        {
+            reportError(err, "generate reference documentation");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Merge
+    if(toolArgs.toolAction == Action::merge)
+    {
+        auto err = DoMergeAction();
+        if(err)
+        {
+            reportError(err, "merge bitcode shards");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Bench
+    if(toolArgs.toolAction == Action::bench)
+    {
+        auto err = DoBenchAction();
+        if(err)
+        {
+            reportError(err, "run the benchmark");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Serve
+    if(toolArgs.toolAction == Action::serve)
+    {
+        auto err = DoServeAction();
+        if(err)
+        {
+            reportError(err, "serve reference documentation");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Load
+    if(toolArgs.toolAction == Action::load)
+    {
+        auto err = DoLoadAction();
+        if(err)
+        {
+            reportError(err, "load the compilation database");
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Test
+    return DoTestAction();
+}
+
+} // (anon)
+
 int mrdox_main(int argc, char const** argv)
 {
     namespace fs = llvm::sys::fs;
@@ -140,20 +220,55 @@ int mrdox_main(int argc, char const** argv)
         }
     }
 
-    // Generate
-    if(toolArgs.toolAction == Action::generate)
+    // The trace is written when the action is done,
+    // so a failed run can be inspected as well
+    std::string tracePath;
+    if(! toolArgs.tracePath.empty())
     {
-        auto err = DoGenerateAction();
-        if(err)
+        auto absPath = files::makeAbsolute(toolArgs.tracePath.getValue());
+        if(! absPath)
         {
-            reportError(err, "generate reference documentation");
+            reportError(absPath.error(), "set the trace file");
             return EXIT_FAILURE;
         }
-        return EXIT_SUCCESS;
+        tracePath = files::normalizePath(*absPath);
+        startTrace();
     }
+    auto writeTraceFile = llvm::make_scope_exit(
+        [&]
+        {
+            if(tracePath.empty())
+                return;
+            if(auto err = writeTrace(tracePath))
+                reportError(err, "write the trace file");
+        });
 
-    // Test
-    return DoTestAction();
+    // The metrics are written however the action
+    // ends, so a scheduler sees failed runs too
+    std::string metricsPath;
+    if(! toolArgs.metricsPath.empty())
+    {
+        auto absPath = files::makeAbsolute(toolArgs.metricsPath.getValue());
+        if(! absPath)
+        {
+            reportError(absPath.error(), "set the metrics file");
+            return EXIT_FAILURE;
+        }
+        metricsPath = files::normalizePath(*absPath);
+        startMetrics();
+    }
+    int exitCode = EXIT_FAILURE;
+    auto writeMetricsFile = llvm::make_scope_exit(
+        [&]
+        {
+            if(metricsPath.empty())
+                return;
+            setMetric("mrdox_exit_code", exitCode);
+            if(auto err = writeMetrics(metricsPath))
+                reportError(err, "write the metrics file");
+        });
+    exitCode = runAction();
+    return exitCode;
 }
 
 namespace lua {
@@ -0,0 +1,13 @@
+void f();
+
+struct A {};
+
+struct B : A
+{
+    friend void f();
+};
+
+namespace N
+{
+    struct C {};
+}
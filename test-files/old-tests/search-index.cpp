@@ -0,0 +1,17 @@
+/** The "last" symbol
+*/
+void z();
+
+namespace N
+{
+    /** A record
+    */
+    struct S
+    {
+        void g();
+    };
+
+    void f(int x);
+}
+
+void Христос_воскрес();
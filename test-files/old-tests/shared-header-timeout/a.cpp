@@ -0,0 +1,34 @@
+#include "shared.hpp"
+
+// Every assertion takes a while, so the translation
+// unit runs out of time long before its end, after
+// it saw the declarations of the header. Neither
+// its own declarations nor its claim on those of
+// the header may be kept.
+
+constexpr unsigned long
+spin(unsigned long n)
+{
+    unsigned long i = 0;
+    while(i != n)
+        ++i;
+    return i;
+}
+
+#define SPIN static_assert(spin(100000) == 100000);
+#define SPIN10 SPIN SPIN SPIN SPIN SPIN SPIN SPIN SPIN SPIN SPIN
+#define SPIN100 SPIN10 SPIN10 SPIN10 SPIN10 SPIN10 SPIN10 SPIN10 SPIN10 SPIN10 SPIN10
+#define SPIN1000 SPIN100 SPIN100 SPIN100 SPIN100 SPIN100 SPIN100 SPIN100 SPIN100 SPIN100 SPIN100
+
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+SPIN1000
+
+void a();
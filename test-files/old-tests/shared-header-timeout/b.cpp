@@ -0,0 +1,3 @@
+#include "shared.hpp"
+
+void b();